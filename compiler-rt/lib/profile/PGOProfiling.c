@@ -0,0 +1,374 @@
+/*===- PGOProfiling.c - Support library for PGO counter profiles ----------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+|*===----------------------------------------------------------------------===*|
+|*
+|* This file implements the runtime of the -pgo-instr-gen LLVM pass.  Every
+|* instrumented module registers its table of functions and counters before
+|* main runs, and at exit the counters are added to the profile named by the
+|* LLVM_PGO_FILE environment variable, "default.pgodata" by default.  Runs
+|* that share a profile accumulate into it; the file is locked while it is
+|* updated so that processes exiting at the same time do not lose counts.
+|*
+|* The format is described in llvm/include/llvm/Support/PGOProfile.h: an 8
+|* byte magic and ULEB128 numbers.
+|*
+|* Counters are incremented without atomics, so counts of code that runs in
+|* several threads at once are approximate.
+|*
+\*===----------------------------------------------------------------------===*/
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+#ifndef _MSC_VER
+#include <stdint.h>
+#else
+typedef unsigned int uint32_t;
+typedef unsigned long long uint64_t;
+#endif
+
+static const char pgo_magic[8] = { '\xff', 'p', 'g', 'o', 'd', 'a', 't', 0 };
+static const uint64_t pgo_version = 1;
+
+/*
+ * One entry of the table -pgo-instr-gen emits for each module.
+ */
+struct llvm_pgo_function {
+  const char *name;
+  uint64_t hash;
+  uint32_t num_counters;
+  uint64_t *counters;
+};
+
+/*
+ * The registered tables.
+ */
+struct pgo_module_node {
+  const struct llvm_pgo_function *functions;
+  uint32_t num_functions;
+  struct pgo_module_node *next;
+};
+
+static struct pgo_module_node *pgo_modules = NULL;
+
+/*
+ * --- The profile being written, keyed by function name ---
+ */
+
+struct pgo_record {
+  const char *name;
+  uint64_t name_size;
+  uint64_t hash;
+  uint64_t num_counters;
+  uint64_t *counters;
+};
+
+static struct pgo_record *records = NULL;
+static uint64_t num_records = 0;
+static uint64_t records_capacity = 0;
+
+static uint64_t hash_name(const char *name, uint64_t size) {
+  uint64_t h = 14695981039346656037ULL;
+  uint64_t i;
+  for (i = 0; i != size; ++i) {
+    h ^= (unsigned char)name[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/*
+ * Find the slot of a name in the open addressed table, which is empty if the
+ * name is not there yet.
+ */
+static struct pgo_record *find_record(const char *name, uint64_t size) {
+  uint64_t i = hash_name(name, size) & (records_capacity - 1);
+  for (;; i = (i + 1) & (records_capacity - 1)) {
+    struct pgo_record *r = &records[i];
+    if (!r->name ||
+        (r->name_size == size && memcmp(r->name, name, size) == 0))
+      return r;
+  }
+}
+
+static int grow_records(void) {
+  struct pgo_record *old = records;
+  uint64_t old_capacity = records_capacity, i;
+  uint64_t capacity = old_capacity ? old_capacity * 2 : 1024;
+
+  records = calloc(capacity, sizeof(struct pgo_record));
+  if (!records) {
+    records = old;
+    return -1;
+  }
+  records_capacity = capacity;
+  for (i = 0; i != old_capacity; ++i)
+    if (old[i].name)
+      *find_record(old[i].name, old[i].name_size) = old[i];
+  free(old);
+  return 0;
+}
+
+/*
+ * Add the counters of a function to the profile.  A copy of a function with
+ * a different layout, from an older build, is dropped; the first one added
+ * wins.
+ */
+static int add_record(const char *name, uint64_t name_size, uint64_t hash,
+                      uint64_t num_counters, const uint64_t *counters) {
+  struct pgo_record *r;
+  uint64_t i;
+
+  if ((num_records + 1) * 2 > records_capacity && grow_records() != 0)
+    return -1;
+
+  r = find_record(name, name_size);
+  if (r->name) {
+    if (r->hash != hash || r->num_counters != num_counters)
+      return 0;
+    for (i = 0; i != num_counters; ++i)
+      r->counters[i] += counters[i];
+    return 0;
+  }
+
+  r->counters = malloc(num_counters * sizeof(uint64_t) + 1);
+  if (!r->counters)
+    return -1;
+  memcpy(r->counters, counters, num_counters * sizeof(uint64_t));
+  r->name = name;
+  r->name_size = name_size;
+  r->hash = hash;
+  r->num_counters = num_counters;
+  ++num_records;
+  return 0;
+}
+
+/*
+ * --- Reading the existing profile ---
+ */
+
+static int read_uleb128(const unsigned char **p, const unsigned char *end,
+                        uint64_t *value) {
+  unsigned shift = 0;
+  *value = 0;
+  while (*p != end && shift < 64) {
+    uint64_t byte = *(*p)++;
+    *value |= (byte & 0x7f) << shift;
+    if (byte < 128)
+      return 0;
+    shift += 7;
+  }
+  return -1;
+}
+
+/*
+ * Add the records of an existing profile.  A file that is not a profile of
+ * this version is overwritten, as are the records after a truncated one.
+ */
+static void merge_profile(const unsigned char *data, uint64_t size) {
+  const unsigned char *p = data + sizeof(pgo_magic), *end = data + size;
+  uint64_t version, num_functions, i, c;
+  uint64_t *counters = NULL;
+
+  if (size < sizeof(pgo_magic) ||
+      memcmp(data, pgo_magic, sizeof(pgo_magic)) != 0 ||
+      read_uleb128(&p, end, &version) != 0 || version != pgo_version ||
+      read_uleb128(&p, end, &num_functions) != 0)
+    return;
+
+  for (i = 0; i != num_functions; ++i) {
+    uint64_t name_size, hash, num_counters;
+    const char *name;
+    if (read_uleb128(&p, end, &name_size) != 0 ||
+        name_size > (uint64_t)(end - p))
+      break;
+    name = (const char *)p;
+    p += name_size;
+    if (read_uleb128(&p, end, &hash) != 0 ||
+        read_uleb128(&p, end, &num_counters) != 0 ||
+        num_counters > (uint64_t)(end - p))
+      break;
+
+    free(counters);
+    counters = malloc(num_counters * sizeof(uint64_t) + 1);
+    if (!counters)
+      break;
+    for (c = 0; c != num_counters; ++c)
+      if (read_uleb128(&p, end, &counters[c]) != 0)
+        break;
+    if (c != num_counters || add_record(name, name_size, hash, num_counters,
+                                        counters) != 0)
+      break;
+  }
+  free(counters);
+}
+
+/*
+ * --- Writing the profile ---
+ */
+
+static unsigned char *out_buffer = NULL;
+static uint64_t out_size = 0;
+static uint64_t out_capacity = 0;
+
+static int write_bytes(const void *bytes, uint64_t size) {
+  if (out_size + size > out_capacity) {
+    uint64_t capacity = out_capacity ? out_capacity : 64 * 1024;
+    unsigned char *buffer;
+    while (out_size + size > capacity)
+      capacity *= 2;
+    buffer = realloc(out_buffer, capacity);
+    if (!buffer)
+      return -1;
+    out_buffer = buffer;
+    out_capacity = capacity;
+  }
+  memcpy(out_buffer + out_size, bytes, size);
+  out_size += size;
+  return 0;
+}
+
+static int write_uleb128(uint64_t value) {
+  unsigned char bytes[10];
+  unsigned n = 0;
+  do {
+    bytes[n] = value & 0x7f;
+    value >>= 7;
+    if (value)
+      bytes[n] |= 0x80;
+    ++n;
+  } while (value);
+  return write_bytes(bytes, n);
+}
+
+static int write_profile(void) {
+  uint64_t i, c;
+  if (write_bytes(pgo_magic, sizeof(pgo_magic)) != 0 ||
+      write_uleb128(pgo_version) != 0 || write_uleb128(num_records) != 0)
+    return -1;
+  for (i = 0; i != records_capacity; ++i) {
+    struct pgo_record *r = &records[i];
+    if (!r->name)
+      continue;
+    if (write_uleb128(r->name_size) != 0 ||
+        write_bytes(r->name, r->name_size) != 0 ||
+        write_uleb128(r->hash) != 0 || write_uleb128(r->num_counters) != 0)
+      return -1;
+    for (c = 0; c != r->num_counters; ++c)
+      if (write_uleb128(r->counters[c]) != 0)
+        return -1;
+  }
+  return 0;
+}
+
+static int read_file(int fd, unsigned char **data, uint64_t *size) {
+  struct stat st;
+  uint64_t done = 0;
+  *data = NULL;
+  *size = 0;
+  if (fstat(fd, &st) != 0)
+    return -1;
+  if (st.st_size == 0)
+    return 0;
+  *data = malloc(st.st_size);
+  if (!*data)
+    return -1;
+  while (done != (uint64_t)st.st_size) {
+    ssize_t n = read(fd, *data + done, st.st_size - done);
+    if (n <= 0)
+      return -1;
+    done += n;
+  }
+  *size = done;
+  return 0;
+}
+
+static int write_file(int fd) {
+  uint64_t done = 0;
+  if (lseek(fd, 0, SEEK_SET) != 0 || ftruncate(fd, 0) != 0)
+    return -1;
+  while (done != out_size) {
+    ssize_t n = write(fd, out_buffer + done, out_size - done);
+    if (n <= 0)
+      return -1;
+    done += n;
+  }
+  return 0;
+}
+
+static void llvm_pgo_write_profile(void) {
+  const char *filename = getenv("LLVM_PGO_FILE");
+  struct pgo_module_node *m;
+  unsigned char *existing = NULL;
+  uint64_t existing_size = 0;
+  uint32_t i;
+  int fd;
+
+  if (!filename || !*filename)
+    filename = "default.pgodata";
+
+  for (m = pgo_modules; m; m = m->next)
+    for (i = 0; i != m->num_functions; ++i) {
+      const struct llvm_pgo_function *f = &m->functions[i];
+      if (add_record(f->name, strlen(f->name), f->hash, f->num_counters,
+                     f->counters) != 0) {
+        fprintf(stderr, "profiling: %s: out of memory\n", filename);
+        return;
+      }
+    }
+
+  fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (fd == -1) {
+    fprintf(stderr, "profiling: %s: cannot open profile\n", filename);
+    return;
+  }
+#ifndef _WIN32
+  flock(fd, LOCK_EX);
+#endif
+
+  /* Leave a profile that cannot be read alone rather than lose its counts. */
+  if (read_file(fd, &existing, &existing_size) != 0)
+    fprintf(stderr, "profiling: %s: cannot read profile\n", filename);
+  else {
+    merge_profile(existing, existing_size);
+    if (write_profile() != 0 || write_file(fd) != 0)
+      fprintf(stderr, "profiling: %s: cannot write profile\n", filename);
+  }
+
+#ifndef _WIN32
+  flock(fd, LOCK_UN);
+#endif
+  close(fd);
+  free(existing);
+}
+
+/*
+ * Called by the constructor -pgo-instr-gen adds to each module.
+ */
+void llvm_pgo_register_functions(const struct llvm_pgo_function *functions,
+                                 uint32_t num_functions) {
+  struct pgo_module_node *node = malloc(sizeof(struct pgo_module_node));
+  if (!node)
+    return;
+  if (!pgo_modules)
+    atexit(llvm_pgo_write_profile);
+  node->functions = functions;
+  node->num_functions = num_functions;
+  node->next = pgo_modules;
+  pgo_modules = node;
+}
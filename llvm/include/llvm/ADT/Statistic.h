@@ -108,6 +108,18 @@ public:
     return init();
   }
 
+  /// updateMax - Raise the value to V if it is smaller, atomically.
+  const Statistic &updateMax(unsigned V) {
+    sys::cas_flag Old = Value;
+    while (V > unsigned(Old)) {
+      sys::cas_flag Seen = sys::CompareAndSwap(&Value, V, Old);
+      if (Seen == Old)
+        break;
+      Old = Seen;
+    }
+    return init();
+  }
+
 #else  // Statistics are disabled in release builds.
 
   const Statistic &operator=(unsigned Val) {
@@ -146,6 +158,10 @@ public:
     return *this;
   }
 
+  const Statistic &updateMax(unsigned V) {
+    return *this;
+  }
+
 #endif  // !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
 
 protected:
@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/Analysis/Dominators.h"
+#include <queue>
 
 //===----------------------------------------------------------------------===//
 //
@@ -284,6 +285,524 @@ void Calculate(DominatorTreeBase<typename GraphTraits<NodeT>::NodeType>& DT,
   DT.updateDFSNumbers();
 }
 
+//===----------------------------------------------------------------------===//
+//
+// Incremental updates - DomTreeUpdater keeps a dominator tree valid across
+// CFG edge insertions and deletions, following the depth-based search of:
+//
+//   An Experimental Study of Dynamic Dominators
+//   L. Georgiadis, G. F. Italiano, L. Laura, F. Santaroni, ESA 2012.
+//
+// An insertion can only move blocks up to the nearest common dominator of
+// the ends of the edge; the blocks that move are found by searching from the
+// destination in order of decreasing depth.  A deletion recomputes the
+// subtree of the nearest common dominator of its ends with the SemiNCA
+// algorithm, and erases the subtree of the destination if it became
+// unreachable.  Either way, only the part of the tree below the nearest
+// common dominator is visited.
+//
+//===----------------------------------------------------------------------===//
+
+template<class NodeT>
+class DomTreeUpdater {
+  typedef DomTreeNodeBase<NodeT> TreeNode;
+  typedef GraphTraits<NodeT*> SuccTraits;
+  typedef GraphTraits<Inverse<NodeT*> > PredTraits;
+  typedef DenseMap<NodeT*, SmallVector<NodeT*, 2> > EdgeMapType;
+
+  DominatorTreeBase<NodeT> &DT;
+
+  // The edges of the batch being applied that the tree does not reflect yet:
+  // ones already added to the CFG, and ones already removed from it.  The
+  // tree is valid for the CFG with the former removed and the latter added
+  // back, and successors and predecessors are looked up in that CFG.
+  EdgeMapType InsertedSuccs, InsertedPreds;
+  EdgeMapType DeletedSuccs, DeletedPreds;
+
+  // Information record used by the SemiNCA computation of a subtree.
+  struct InfoRec {
+    unsigned DFSNum;
+    unsigned Parent;
+    unsigned Semi;
+    NodeT *Label;
+    NodeT *IDom;
+    SmallVector<NodeT*, 2> Preds;
+
+    InfoRec() : DFSNum(0), Parent(0), Semi(0), Label(0), IDom(0) {}
+  };
+
+  DenseMap<NodeT*, InfoRec> Info;
+  SmallVector<NodeT*, 32> NumToNode;
+
+  // DFS conditions.  Rebuilding a subtree only descends into blocks deeper
+  // than its root: those reached from the subtree are inside it.
+  struct DescendBelow {
+    DominatorTreeBase<NodeT> &DT;
+    unsigned Level;
+    DescendBelow(DominatorTreeBase<NodeT> &DT, unsigned Level)
+      : DT(DT), Level(Level) {}
+    bool operator()(NodeT *, NodeT *To) const {
+      TreeNode *TN = DT.getNode(To);
+      return TN && TN->getLevel() > Level;
+    }
+  };
+
+  // Same, but also collects the blocks outside the subtree that it reaches.
+  struct DescendBelowAndCollect {
+    DominatorTreeBase<NodeT> &DT;
+    unsigned Level;
+    SmallVectorImpl<NodeT*> &Outside;
+    DescendBelowAndCollect(DominatorTreeBase<NodeT> &DT, unsigned Level,
+                           SmallVectorImpl<NodeT*> &Outside)
+      : DT(DT), Level(Level), Outside(Outside) {}
+    bool operator()(NodeT *, NodeT *To) const {
+      TreeNode *TN = DT.getNode(To);
+      if (!TN)
+        return false;
+      if (TN->getLevel() > Level)
+        return true;
+      if (std::find(Outside.begin(), Outside.end(), To) == Outside.end())
+        Outside.push_back(To);
+      return false;
+    }
+  };
+
+  // Blocks that became reachable are the ones not in the tree yet; the
+  // edges from them into the tree are collected.
+  struct DescendUnreachable {
+    DominatorTreeBase<NodeT> &DT;
+    SmallVectorImpl<std::pair<NodeT*, NodeT*> > &EdgesToReachable;
+    DescendUnreachable(DominatorTreeBase<NodeT> &DT,
+                       SmallVectorImpl<std::pair<NodeT*, NodeT*> > &Edges)
+      : DT(DT), EdgesToReachable(Edges) {}
+    bool operator()(NodeT *From, NodeT *To) const {
+      if (!DT.getNode(To))
+        return true;
+      EdgesToReachable.push_back(std::make_pair(From, To));
+      return false;
+    }
+  };
+
+  // Orders the search of an insertion by decreasing depth.
+  struct LevelLess {
+    bool operator()(const TreeNode *LHS, const TreeNode *RHS) const {
+      return LHS->getLevel() < RHS->getLevel();
+    }
+  };
+
+  static void removeEdge(EdgeMapType &Map, NodeT *From, NodeT *To) {
+    typename EdgeMapType::iterator I = Map.find(From);
+    assert(I != Map.end() && "Edge is not pending!");
+    SmallVectorImpl<NodeT*> &Edges = I->second;
+    Edges.erase(std::find(Edges.begin(), Edges.end(), To));
+    if (Edges.empty())
+      Map.erase(I);
+  }
+
+  template<class IterT>
+  static void getChildren(NodeT *N, IterT Begin, IterT End,
+                          const EdgeMapType &Inserted,
+                          const EdgeMapType &Deleted,
+                          SmallVectorImpl<NodeT*> &Result) {
+    Result.clear();
+    for (; Begin != End; ++Begin)
+      Result.push_back(*Begin);
+
+    typename EdgeMapType::const_iterator I = Inserted.find(N);
+    if (I != Inserted.end())
+      for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+        Result.erase(std::remove(Result.begin(), Result.end(), I->second[i]),
+                     Result.end());
+
+    I = Deleted.find(N);
+    if (I != Deleted.end())
+      Result.append(I->second.begin(), I->second.end());
+  }
+
+  void getSuccessors(NodeT *N, SmallVectorImpl<NodeT*> &Result) const {
+    getChildren(N, SuccTraits::child_begin(N), SuccTraits::child_end(N),
+                InsertedSuccs, DeletedSuccs, Result);
+  }
+
+  void getPredecessors(NodeT *N, SmallVectorImpl<NodeT*> &Result) const {
+    getChildren(N, PredTraits::child_begin(N), PredTraits::child_end(N),
+                InsertedPreds, DeletedPreds, Result);
+  }
+
+  static TreeNode *findNearestCommonDominator(TreeNode *A, TreeNode *B) {
+    while (A != B) {
+      if (A->getLevel() < B->getLevel())
+        std::swap(A, B);
+      A = A->getIDom();
+    }
+    return A;
+  }
+
+  void clear() {
+    Info.clear();
+    NumToNode.clear();
+  }
+
+  /// runDFS - Number the blocks reachable from Root in depth first order,
+  /// descending along the edges Condition accepts, and record the
+  /// predecessors of each among the numbered blocks.
+  template<class DescendCondition>
+  unsigned runDFS(NodeT *Root, DescendCondition Condition) {
+    assert(NumToNode.empty() && "DFS state in use!");
+    NumToNode.push_back(0);
+
+    SmallVector<NodeT*, 64> WorkList(1, Root);
+    SmallVector<NodeT*, 8> Succs;
+    Info[Root].Parent = 0;
+    unsigned LastNum = 0;
+
+    while (!WorkList.empty()) {
+      NodeT *BB = WorkList.pop_back_val();
+      InfoRec &BBInfo = Info[BB];
+      // A block may be pushed once by each predecessor; the last push is
+      // visited first and sets the DFS parent.
+      if (BBInfo.DFSNum != 0)
+        continue;
+
+      BBInfo.DFSNum = BBInfo.Semi = ++LastNum;
+      BBInfo.Label = BB;
+      NumToNode.push_back(BB);
+
+      getSuccessors(BB, Succs);
+      for (unsigned i = 0, e = Succs.size(); i != e; ++i) {
+        NodeT *Succ = Succs[i];
+        typename DenseMap<NodeT*, InfoRec>::iterator SI = Info.find(Succ);
+        if (SI != Info.end() && SI->second.DFSNum != 0) {
+          if (Succ != BB)
+            SI->second.Preds.push_back(BB);
+          continue;
+        }
+
+        if (!Condition(BB, Succ))
+          continue;
+
+        InfoRec &SuccInfo = Info[Succ];
+        WorkList.push_back(Succ);
+        SuccInfo.Parent = LastNum;
+        SuccInfo.Preds.push_back(BB);
+      }
+    }
+
+    return LastNum;
+  }
+
+  NodeT *eval(NodeT *V, unsigned LastLinked,
+              SmallVectorImpl<InfoRec*> &Stack) {
+    InfoRec *VInfo = &Info[V];
+    if (VInfo->Parent < LastLinked)
+      return VInfo->Label;
+
+    // Store the ancestors except the last, the root of the virtual tree.
+    assert(Stack.empty());
+    do {
+      Stack.push_back(VInfo);
+      VInfo = &Info[NumToNode[VInfo->Parent]];
+    } while (VInfo->Parent >= LastLinked);
+
+    // Path compression: point each ancestor to the root, keeping the label
+    // with the smallest semidominator.
+    const InfoRec *PInfo = VInfo;
+    const InfoRec *PLabelInfo = &Info[PInfo->Label];
+    do {
+      VInfo = Stack.pop_back_val();
+      VInfo->Parent = PInfo->Parent;
+      const InfoRec *VLabelInfo = &Info[VInfo->Label];
+      if (PLabelInfo->Semi < VLabelInfo->Semi)
+        VInfo->Label = PInfo->Label;
+      else
+        PLabelInfo = VLabelInfo;
+      PInfo = VInfo;
+    } while (!Stack.empty());
+    return VInfo->Label;
+  }
+
+  /// runSemiNCA - Compute the immediate dominators of the blocks numbered by
+  /// runDFS, relative to its root.
+  void runSemiNCA() {
+    unsigned N = NumToNode.size() - 1;
+
+    // Parents are overwritten by the path compression in eval; the immediate
+    // dominators start out as the DFS parents.
+    for (unsigned i = 1; i <= N; ++i) {
+      InfoRec &VInfo = Info[NumToNode[i]];
+      VInfo.IDom = NumToNode[VInfo.Parent];
+    }
+
+    // Step #1: Calculate the semidominators of all vertices.
+    SmallVector<InfoRec*, 32> EvalStack;
+    for (unsigned i = N; i >= 2; --i) {
+      InfoRec &WInfo = Info[NumToNode[i]];
+      WInfo.Semi = WInfo.Parent;
+      for (unsigned j = 0, e = WInfo.Preds.size(); j != e; ++j) {
+        unsigned SemiU = Info[eval(WInfo.Preds[j], i + 1, EvalStack)].Semi;
+        if (SemiU < WInfo.Semi)
+          WInfo.Semi = SemiU;
+      }
+    }
+
+    // Step #2: The immediate dominator of each vertex is the nearest common
+    // ancestor of its semidominator and its parent in the DFS tree.
+    for (unsigned i = 2; i <= N; ++i) {
+      InfoRec &WInfo = Info[NumToNode[i]];
+      NodeT *IDomCandidate = WInfo.IDom;
+      while (Info[IDomCandidate].DFSNum > WInfo.Semi)
+        IDomCandidate = Info[IDomCandidate].IDom;
+      WInfo.IDom = IDomCandidate;
+    }
+  }
+
+  /// rebuildSubtree - Recompute the immediate dominators of the blocks below
+  /// Root, which keeps its own.
+  void rebuildSubtree(TreeNode *Root) {
+    runDFS(Root->getBlock(), DescendBelow(DT, Root->getLevel()));
+    runSemiNCA();
+
+    // A block's new immediate dominator precedes it in DFS order, so it is
+    // already in place when the block is moved under it.
+    for (unsigned i = 2, e = NumToNode.size(); i != e; ++i) {
+      NodeT *N = NumToNode[i];
+      DT.changeImmediateDominator(DT.getNode(N), DT.getNode(Info[N].IDom));
+    }
+    clear();
+  }
+
+  void insertReachable(TreeNode *FromTN, TreeNode *ToTN) {
+    // A block is affected by the insertion iff it is deeper than the nearest
+    // common dominator plus one, and there is a path from To to it through
+    // blocks no shallower than it.  Affected blocks move up to the NCD.
+    TreeNode *NCD = findNearestCommonDominator(FromTN, ToTN);
+    if (NCD == ToTN || NCD->getLevel() + 1 >= ToTN->getLevel())
+      return;
+    unsigned NCDLevel = NCD->getLevel();
+
+    std::priority_queue<TreeNode*, SmallVector<TreeNode*, 8>, LevelLess>
+      Bucket;
+    SmallPtrSet<TreeNode*, 8> Visited;
+    SmallVector<TreeNode*, 8> Affected;
+    SmallVector<TreeNode*, 8> UnaffectedOnEveryLevel;
+    SmallVector<NodeT*, 8> Succs;
+
+    Bucket.push(ToTN);
+    Visited.insert(ToTN);
+    while (!Bucket.empty()) {
+      TreeNode *TN = Bucket.top();
+      Bucket.pop();
+      Affected.push_back(TN);
+
+      // The deepest block of the queue bounds the depth of the blocks it can
+      // affect; deeper blocks reached from it are unaffected themselves but
+      // may lead to affected ones, and are expanded right away.
+      unsigned CurrentLevel = TN->getLevel();
+      for (;;) {
+        getSuccessors(TN->getBlock(), Succs);
+        for (unsigned i = 0, e = Succs.size(); i != e; ++i) {
+          TreeNode *SuccTN = DT.getNode(Succs[i]);
+          assert(SuccTN && "Unreachable successor of a reachable block!");
+          unsigned SuccLevel = SuccTN->getLevel();
+          if (SuccLevel <= NCDLevel + 1 || !Visited.insert(SuccTN))
+            continue;
+
+          if (SuccLevel > CurrentLevel)
+            UnaffectedOnEveryLevel.push_back(SuccTN);
+          else
+            Bucket.push(SuccTN);
+        }
+
+        if (UnaffectedOnEveryLevel.empty())
+          break;
+        TN = UnaffectedOnEveryLevel.pop_back_val();
+      }
+    }
+
+    for (unsigned i = 0, e = Affected.size(); i != e; ++i)
+      DT.changeImmediateDominator(Affected[i], NCD);
+  }
+
+  void insertUnreachable(TreeNode *FromTN, NodeT *To) {
+    // The blocks that became reachable can only be entered through To, so
+    // their dominators among themselves are computed like a new tree rooted
+    // at To and hung below From.  The edges from them to blocks that were
+    // already reachable are then inserted one by one.
+    SmallVector<std::pair<NodeT*, NodeT*>, 8> EdgesToReachable;
+    runDFS(To, DescendUnreachable(DT, EdgesToReachable));
+    runSemiNCA();
+
+    DT.addNewBlock(To, FromTN->getBlock());
+    for (unsigned i = 2, e = NumToNode.size(); i != e; ++i) {
+      NodeT *N = NumToNode[i];
+      DT.addNewBlock(N, Info[N].IDom);
+    }
+    clear();
+
+    for (unsigned i = 0, e = EdgesToReachable.size(); i != e; ++i)
+      insertReachable(DT.getNode(EdgesToReachable[i].first),
+                      DT.getNode(EdgesToReachable[i].second));
+  }
+
+  /// hasProperSupport - Return true if a predecessor of TN other than ones it
+  /// dominates is reachable, so that TN stays reachable.
+  bool hasProperSupport(TreeNode *TN) {
+    SmallVector<NodeT*, 8> Preds;
+    getPredecessors(TN->getBlock(), Preds);
+    for (unsigned i = 0, e = Preds.size(); i != e; ++i) {
+      TreeNode *PredTN = DT.getNode(Preds[i]);
+      if (PredTN && findNearestCommonDominator(TN, PredTN) != TN)
+        return true;
+    }
+    return false;
+  }
+
+  void deleteUnreachable(TreeNode *ToTN) {
+    // Everything To dominates is unreachable now.  The blocks those reach
+    // outside of the subtree may lose dominators; the subtree of the highest
+    // NCD of such a block and To has to be rebuilt.
+    SmallVector<NodeT*, 16> Outside;
+    unsigned N =
+        runDFS(ToTN->getBlock(),
+               DescendBelowAndCollect(DT, ToTN->getLevel(), Outside));
+
+    TreeNode *MinNode = ToTN;
+    for (unsigned i = 0, e = Outside.size(); i != e; ++i) {
+      TreeNode *TN = DT.getNode(Outside[i]);
+      TreeNode *NCD = findNearestCommonDominator(TN, ToTN);
+      if (NCD != TN && NCD->getLevel() < MinNode->getLevel())
+        MinNode = NCD;
+    }
+
+    // Blocks are erased in reverse DFS order, so that the ones a block
+    // dominates are gone before it is.
+    for (unsigned i = N; i != 0; --i)
+      DT.eraseNode(NumToNode[i]);
+    clear();
+
+    if (MinNode != ToTN)
+      rebuildSubtree(MinNode);
+  }
+
+public:
+  explicit DomTreeUpdater(DominatorTreeBase<NodeT> &DT) : DT(DT) {}
+
+  void insertEdge(NodeT *From, NodeT *To) {
+    TreeNode *FromTN = DT.getNode(From);
+    // An edge out of an unreachable block changes nothing.
+    if (!FromTN)
+      return;
+
+    if (TreeNode *ToTN = DT.getNode(To))
+      insertReachable(FromTN, ToTN);
+    else
+      insertUnreachable(FromTN, To);
+  }
+
+  void deleteEdge(NodeT *From, NodeT *To) {
+    TreeNode *FromTN = DT.getNode(From);
+    TreeNode *ToTN = DT.getNode(To);
+    if (!FromTN || !ToTN)
+      return;
+
+    // Another edge between the same blocks, e.g. from a switch, may remain.
+    SmallVector<NodeT*, 8> Succs;
+    getSuccessors(From, Succs);
+    if (std::find(Succs.begin(), Succs.end(), To) != Succs.end())
+      return;
+
+    // If To dominates From, the edge was not on any path that determines a
+    // dominator.
+    TreeNode *NCD = findNearestCommonDominator(FromTN, ToTN);
+    if (NCD == ToTN)
+      return;
+
+    // To stays reachable if it has another incoming edge from a block it
+    // does not dominate; otherwise it loses the subtree it dominates.
+    if (FromTN != ToTN->getIDom() || hasProperSupport(ToTN))
+      rebuildSubtree(NCD);
+    else
+      deleteUnreachable(ToTN);
+  }
+
+  void applyUpdates(ArrayRef<DomTreeUpdate<NodeT> > Updates) {
+    typedef DomTreeUpdate<NodeT> UpdateT;
+
+    // Cancel out insertions and deletions of the same edge, keeping the
+    // first position of each edge.
+    typedef std::pair<NodeT*, NodeT*> EdgeT;
+    DenseMap<EdgeT, int> Net;
+    SmallVector<EdgeT, 8> Edges;
+    for (unsigned i = 0, e = Updates.size(); i != e; ++i) {
+      EdgeT Edge(Updates[i].From, Updates[i].To);
+      std::pair<typename DenseMap<EdgeT, int>::iterator, bool> Res =
+          Net.insert(std::make_pair(Edge, 0));
+      if (Res.second)
+        Edges.push_back(Edge);
+      Res.first->second += Updates[i].Kind == UpdateT::Insert ? 1 : -1;
+    }
+
+    // Insertions go first: a deletion is cheaper when the blocks it cuts off
+    // are already reachable some other way.
+    SmallVector<UpdateT, 8> Legal, Deletes;
+    for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+      int Count = Net[Edges[i]];
+      if (Count == 0)
+        continue;
+      UpdateT U(Count > 0 ? UpdateT::Insert : UpdateT::Delete,
+                Edges[i].first, Edges[i].second);
+      if (U.Kind == UpdateT::Insert) {
+        Legal.push_back(U);
+        InsertedSuccs[U.From].push_back(U.To);
+        InsertedPreds[U.To].push_back(U.From);
+      } else {
+        Deletes.push_back(U);
+        DeletedSuccs[U.From].push_back(U.To);
+        DeletedPreds[U.To].push_back(U.From);
+      }
+    }
+
+    Legal.append(Deletes.begin(), Deletes.end());
+
+    // Apply the updates one at a time, each to the CFG the tree is valid for
+    // plus that one edit.
+    for (unsigned i = 0, e = Legal.size(); i != e; ++i) {
+      const UpdateT &U = Legal[i];
+      if (U.Kind == UpdateT::Insert) {
+        removeEdge(InsertedSuccs, U.From, U.To);
+        removeEdge(InsertedPreds, U.To, U.From);
+        insertEdge(U.From, U.To);
+      } else {
+        removeEdge(DeletedSuccs, U.From, U.To);
+        removeEdge(DeletedPreds, U.To, U.From);
+        deleteEdge(U.From, U.To);
+      }
+    }
+  }
+};
+
+template<class NodeT>
+void DominatorTreeBase<NodeT>::insertEdge(NodeT *From, NodeT *To) {
+  assert(!this->isPostDominator() &&
+         "Post dominator trees are not updated incrementally!");
+  DomTreeUpdater<NodeT>(*this).insertEdge(From, To);
+}
+
+template<class NodeT>
+void DominatorTreeBase<NodeT>::deleteEdge(NodeT *From, NodeT *To) {
+  assert(!this->isPostDominator() &&
+         "Post dominator trees are not updated incrementally!");
+  DomTreeUpdater<NodeT>(*this).deleteEdge(From, To);
+}
+
+template<class NodeT>
+void DominatorTreeBase<NodeT>::applyUpdates(
+    ArrayRef<DomTreeUpdate<NodeT> > Updates) {
+  assert(!this->isPostDominator() &&
+         "Post dominator trees are not updated incrementally!");
+  DomTreeUpdater<NodeT>(*this).applyUpdates(Updates);
+}
+
 }
 
 #endif
@@ -15,6 +15,7 @@
 #ifndef LLVM_ANALYSIS_DOMINATORS_H
 #define LLVM_ANALYSIS_DOMINATORS_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
@@ -66,6 +67,7 @@ class DomTreeNodeBase {
   DomTreeNodeBase<NodeT> *IDom;
   std::vector<DomTreeNodeBase<NodeT> *> Children;
   int DFSNumIn, DFSNumOut;
+  unsigned Level;
 
   template<class N> friend class DominatorTreeBase;
   friend struct PostDominatorTree;
@@ -85,8 +87,13 @@ public:
     return Children;
   }
 
+  /// getLevel - Return the depth of this node in the tree; the root is at
+  /// level 0.
+  unsigned getLevel() const { return Level; }
+
   DomTreeNodeBase(NodeT *BB, DomTreeNodeBase<NodeT> *iDom)
-    : TheBB(BB), IDom(iDom), DFSNumIn(-1), DFSNumOut(-1) { }
+    : TheBB(BB), IDom(iDom), DFSNumIn(-1), DFSNumOut(-1),
+      Level(iDom ? iDom->Level + 1 : 0) { }
 
   DomTreeNodeBase<NodeT> *addChild(DomTreeNodeBase<NodeT> *C) {
     Children.push_back(C);
@@ -132,6 +139,8 @@ public:
       // Switch to new dominator
       IDom = NewIDom;
       IDom->Children.push_back(this);
+
+      UpdateLevel();
     }
   }
 
@@ -146,6 +155,24 @@ private:
     return this->DFSNumIn >= other->DFSNumIn &&
       this->DFSNumOut <= other->DFSNumOut;
   }
+
+  // Recompute the levels of this node and of the nodes below it after it
+  // moved.  Subtrees whose level did not change are not visited.
+  void UpdateLevel() {
+    assert(IDom);
+    if (Level == IDom->Level + 1)
+      return;
+
+    SmallVector<DomTreeNodeBase<NodeT> *, 64> WorkStack(1, this);
+    while (!WorkStack.empty()) {
+      DomTreeNodeBase<NodeT> *Current = WorkStack.pop_back_val();
+      Current->Level = Current->IDom->Level + 1;
+
+      for (iterator I = Current->begin(), E = Current->end(); I != E; ++I)
+        if ((*I)->Level != Current->Level + 1)
+          WorkStack.push_back(*I);
+    }
+  }
 };
 
 EXTERN_TEMPLATE_INSTANTIATION(class DomTreeNodeBase<BasicBlock>);
@@ -183,6 +210,20 @@ template<class FuncT, class N>
 void Calculate(DominatorTreeBase<typename GraphTraits<N>::NodeType>& DT,
                FuncT& F);
 
+/// DomTreeUpdate - An edge that was added to or removed from the CFG, for
+/// DominatorTreeBase::applyUpdates.
+template<class NodeT>
+struct DomTreeUpdate {
+  enum UpdateKind { Insert, Delete };
+
+  UpdateKind Kind;
+  NodeT *From;
+  NodeT *To;
+
+  DomTreeUpdate(UpdateKind Kind, NodeT *From, NodeT *To)
+    : Kind(Kind), From(From), To(To) {}
+};
+
 template<class NodeT>
 class DominatorTreeBase : public DominatorBase<NodeT> {
   bool dominatedBySlowTreeWalk(const DomTreeNodeBase<NodeT> *A,
@@ -538,6 +579,32 @@ public:
     delete Node;
   }
 
+  /// eraseRootNode - Removes the root node, which must have a single child.
+  /// The child becomes the new root.  This is used when the entry block is
+  /// merged into its only successor.
+  void eraseRootNode() {
+    assert(!this->IsPostDominators && "Cannot replace a post-dominator root!");
+    DomTreeNodeBase<NodeT> *OldRoot = RootNode;
+    assert(OldRoot && OldRoot->getNumChildren() == 1 &&
+           "The root must have a single child!");
+    DomTreeNodeBase<NodeT> *NewRoot = OldRoot->Children[0];
+    NewRoot->IDom = 0;
+
+    // Every node moves up one level.
+    SmallVector<DomTreeNodeBase<NodeT> *, 64> WorkStack(1, NewRoot);
+    while (!WorkStack.empty()) {
+      DomTreeNodeBase<NodeT> *Current = WorkStack.pop_back_val();
+      --Current->Level;
+      WorkStack.append(Current->begin(), Current->end());
+    }
+
+    this->Roots[0] = NewRoot->getBlock();
+    RootNode = NewRoot;
+    DomTreeNodes.erase(OldRoot->getBlock());
+    delete OldRoot;
+    DFSInfoValid = false;
+  }
+
   /// removeNode - Removes a node from the dominator tree.  Block must not
   /// dominate any other blocks.  Invalidates any node pointing to removed
   /// block.
@@ -555,6 +622,24 @@ public:
       this->Split<NodeT*, GraphTraits<NodeT*> >(*this, NewBB);
   }
 
+  /// insertEdge - Update the tree for the edge From -> To, which has just
+  /// been added to the CFG.  If To was unreachable, the blocks that became
+  /// reachable through it are added to the tree.  Only the blocks whose
+  /// dominators change are visited.  Not supported on post dominator trees.
+  void insertEdge(NodeT *From, NodeT *To);
+
+  /// deleteEdge - Update the tree for the edge From -> To, which has just been
+  /// removed from the CFG.  Blocks that became unreachable are removed from
+  /// the tree.  Not supported on post dominator trees.
+  void deleteEdge(NodeT *From, NodeT *To);
+
+  /// applyUpdates - Update the tree for a batch of edge insertions and
+  /// deletions, all of which the CFG already reflects.  The CFG edits may be
+  /// reported in any order; an insertion and a deletion of the same edge
+  /// cancel out.  An edge may only be reported as inserted if the CFG did
+  /// not have it before, and as deleted if the CFG no longer has it.
+  void applyUpdates(ArrayRef<DomTreeUpdate<NodeT> > Updates);
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -870,12 +955,38 @@ public:
     DT->eraseNode(BB);
   }
 
+  /// eraseRootNode - Removes the root node, which must have a single child.
+  /// The child becomes the new root.
+  inline void eraseRootNode() {
+    DT->eraseRootNode();
+  }
+
   /// splitBlock - BB is split and now it has one successor. Update dominator
   /// tree to reflect this change.
   inline void splitBlock(BasicBlock* NewBB) {
     DT->splitBlock(NewBB);
   }
 
+  typedef DomTreeUpdate<BasicBlock> UpdateType;
+
+  /// insertEdge - Update the tree for the edge From -> To, which has just
+  /// been added to the CFG.
+  inline void insertEdge(BasicBlock *From, BasicBlock *To) {
+    DT->insertEdge(From, To);
+  }
+
+  /// deleteEdge - Update the tree for the edge From -> To, which has just been
+  /// removed from the CFG.
+  inline void deleteEdge(BasicBlock *From, BasicBlock *To) {
+    DT->deleteEdge(From, To);
+  }
+
+  /// applyUpdates - Update the tree for a batch of CFG edge insertions and
+  /// deletions.  This is cheaper than updating one edge at a time.
+  inline void applyUpdates(ArrayRef<UpdateType> Updates) {
+    DT->applyUpdates(Updates);
+  }
+
   bool isReachableFromEntry(const BasicBlock* A) const {
     return DT->isReachableFromEntry(A);
   }
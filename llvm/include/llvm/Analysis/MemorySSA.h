@@ -0,0 +1,295 @@
+//===- llvm/Analysis/MemorySSA.h - SSA form of memory -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines MemorySSA, a def-use form of the memory accesses of a
+// function.  Memory is treated as a single variable: every instruction that
+// may write it defines a new version (a MemoryDef), every instruction that
+// only reads it uses the version that reaches it (a MemoryUse), and a
+// MemoryPhi merges the versions that reach a join point.  The version live
+// on entry to the function is a MemoryDef without an instruction.
+//
+// The form is built once, in time linear in the size of the function, and
+// the clients keep it up to date as they delete memory instructions and add
+// loads.  Finding the access that actually clobbers a location walks the def
+// chain with alias analysis queries, instead of scanning the instructions of
+// every block backwards as MemoryDependenceAnalysis does.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_MEMORYSSA_H
+#define LLVM_ANALYSIS_MEMORYSSA_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ValueHandle.h"
+#include <list>
+
+namespace llvm {
+
+class BasicBlock;
+class DominatorTree;
+class Function;
+class Instruction;
+class MemorySSA;
+class raw_ostream;
+
+/// MemoryAccess - A version of memory: a MemoryUse, MemoryDef or MemoryPhi.
+class MemoryAccess {
+public:
+  enum AccessKind { UseKind, DefKind, PhiKind };
+
+  typedef SmallPtrSet<MemoryAccess *, 4>::const_iterator user_iterator;
+
+  AccessKind getKind() const { return Kind; }
+  BasicBlock *getBlock() const { return Block; }
+
+  /// getID - Return the number that names this def or phi when printing.
+  /// The live on entry definition and the uses are 0.  Numbers are not
+  /// reused, so a client can key on them without its keys being taken by a
+  /// new access once the one they named is removed.
+  unsigned getID() const { return ID; }
+
+  /// The accesses that use the version this one defines: the MemoryUses and
+  /// MemoryDefs it reaches and the MemoryPhis it is an incoming value of.
+  user_iterator user_begin() const { return Users.begin(); }
+  user_iterator user_end() const { return Users.end(); }
+  bool user_empty() const { return Users.empty(); }
+
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+  virtual ~MemoryAccess() {}
+
+protected:
+  MemoryAccess(AccessKind K, BasicBlock *BB) : Kind(K), Block(BB), ID(0) {}
+
+private:
+  friend class MemorySSA;
+  MemoryAccess(const MemoryAccess &) LLVM_DELETED_FUNCTION;
+  void operator=(const MemoryAccess &) LLVM_DELETED_FUNCTION;
+
+  AccessKind Kind;
+  BasicBlock *Block;
+  unsigned ID;
+  SmallPtrSet<MemoryAccess *, 4> Users;
+};
+
+/// MemoryUseOrDef - The access of a memory instruction.
+class MemoryUseOrDef : public MemoryAccess {
+public:
+  /// getMemoryInst - Return the instruction, or null for the live on entry
+  /// definition.
+  Instruction *getMemoryInst() const { return MemoryInst; }
+
+  /// getDefiningAccess - Return the version of memory that reaches this
+  /// access, or null for the live on entry definition.
+  MemoryAccess *getDefiningAccess() const { return DefiningAccess; }
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() != PhiKind;
+  }
+
+protected:
+  MemoryUseOrDef(AccessKind K, Instruction *I, BasicBlock *BB)
+    : MemoryAccess(K, BB), MemoryInst(I), DefiningAccess(0) {}
+
+private:
+  friend class MemorySSA;
+  Instruction *MemoryInst;
+  MemoryAccess *DefiningAccess;
+  /// Position - Where the access is in the access list of its block.
+  std::list<MemoryUseOrDef *>::iterator Position;
+};
+
+/// MemoryUse - The access of an instruction that reads memory but does not
+/// write it.
+class MemoryUse : public MemoryUseOrDef {
+public:
+  MemoryUse(Instruction *I, BasicBlock *BB)
+    : MemoryUseOrDef(UseKind, I, BB) {}
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == UseKind;
+  }
+};
+
+/// MemoryDef - The access of an instruction that may write memory, which
+/// defines a new version of it.  Ordered and volatile loads and fences are
+/// definitions as well, so that nothing is moved across them.
+class MemoryDef : public MemoryUseOrDef {
+public:
+  MemoryDef(Instruction *I, BasicBlock *BB)
+    : MemoryUseOrDef(DefKind, I, BB) {}
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == DefKind;
+  }
+};
+
+/// MemoryPhi - The version of memory at the start of a block that more than
+/// one version reaches.
+class MemoryPhi : public MemoryAccess {
+public:
+  explicit MemoryPhi(BasicBlock *BB) : MemoryAccess(PhiKind, BB) {}
+
+  unsigned getNumIncomingValues() const { return Incoming.size(); }
+  MemoryAccess *getIncomingValue(unsigned I) const {
+    return Incoming[I].second;
+  }
+  BasicBlock *getIncomingBlock(unsigned I) const { return Incoming[I].first; }
+
+  static bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == PhiKind;
+  }
+
+private:
+  friend class MemorySSA;
+  SmallVector<std::pair<BasicBlock *, MemoryAccess *>, 4> Incoming;
+};
+
+/// MemorySSA - The memory accesses of a function in SSA form.  Instructions
+/// in unreachable blocks have no access.
+class MemorySSA {
+public:
+  typedef std::list<MemoryUseOrDef *> AccessListType;
+
+  MemorySSA(Function &F, AliasAnalysis &AA, DominatorTree &DT);
+  ~MemorySSA();
+
+  /// getMemoryAccess - Return the access of the given instruction, or null if
+  /// it does not access memory.
+  MemoryUseOrDef *getMemoryAccess(const Instruction *I) const {
+    return InstructionToAccess.lookup(I);
+  }
+
+  /// getMemoryAccess - Return the MemoryPhi of the given block, or null if it
+  /// does not have one.
+  MemoryPhi *getMemoryAccess(const BasicBlock *BB) const {
+    return BlockToPhi.lookup(BB);
+  }
+
+  /// getBlockAccesses - Return the accesses of the instructions of the given
+  /// block in order, or null if there are none.
+  const AccessListType *getBlockAccesses(const BasicBlock *BB) const {
+    return BlockToAccesses.lookup(BB);
+  }
+
+  MemoryDef *getLiveOnEntryDef() const { return LiveOnEntryDef; }
+  bool isLiveOnEntryDef(const MemoryAccess *MA) const {
+    return MA == LiveOnEntryDef;
+  }
+
+  /// getClobberingMemoryAccess - Return the nearest access above the
+  /// instruction that may write the memory it reads: a MemoryDef that
+  /// clobbers it, a MemoryPhi, or the live on entry definition.  Only loads
+  /// are looked through the definitions that do not alias them; for other
+  /// instructions this is their defining access.  Return null if the
+  /// instruction has no access.  The results are cached.
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I);
+
+  /// getClobberingMemoryAccess - Walk up the definitions from Start and
+  /// return the first MemoryDef that may write Loc, MemoryPhi or the live on
+  /// entry definition.  The walk gives up after -memssa-walk-limit
+  /// definitions and returns the one it stopped at.  The result is cached for
+  /// every definition the walk went through, so that later walks for Loc
+  /// stop where they join this one.
+  MemoryAccess *getClobberingMemoryAccess(MemoryAccess *Start,
+                                          const AliasAnalysis::Location &Loc);
+
+  /// createMemoryUse - Add a MemoryUse for I, a new instruction that reads
+  /// memory without writing it, to the form.
+  MemoryUse *createMemoryUse(Instruction *I);
+
+  /// removeMemoryAccess - Remove the access of an instruction that is about
+  /// to be deleted.  The users of a MemoryDef are given its defining access.
+  void removeMemoryAccess(MemoryUseOrDef *MA);
+
+  /// replacePhiIncomingBlock - Update the MemoryPhi of BB, if any, after the
+  /// edge from OldPred was split by NewPred.
+  void replacePhiIncomingBlock(BasicBlock *BB, BasicBlock *OldPred,
+                               BasicBlock *NewPred);
+
+  /// mergeBlockIntoPredecessor - Update the form after the instructions of
+  /// BB were moved to the end of Pred, its only predecessor, and the edges
+  /// out of BB now leave Pred.  BB may be empty but must not be erased yet.
+  void mergeBlockIntoPredecessor(BasicBlock *BB, BasicBlock *Pred);
+
+  /// print - Print the function annotated with its memory accesses.
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+private:
+  MemorySSA(const MemorySSA &) LLVM_DELETED_FUNCTION;
+  void operator=(const MemorySSA &) LLVM_DELETED_FUNCTION;
+
+  void buildMemorySSA();
+  void placePHINodes(const SmallPtrSet<BasicBlock *, 32> &DefiningBlocks);
+  void renamePass();
+  MemoryAccess *renameBlock(BasicBlock *BB, MemoryAccess *IncomingVal);
+  MemoryAccess *getDefiningAccessAtEntry(BasicBlock *BB) const;
+  void setDefiningAccess(MemoryUseOrDef *MA, MemoryAccess *Defining);
+
+  Function &F;
+  AliasAnalysis *AA;
+  DominatorTree *DT;
+  MemoryDef *LiveOnEntryDef;
+
+  /// Allocator - Where the accesses are made.  A removed access is destroyed
+  /// but its memory is only freed with the rest.
+  BumpPtrAllocator Allocator;
+
+  DenseMap<const Instruction *, MemoryUseOrDef *> InstructionToAccess;
+  DenseMap<const BasicBlock *, AccessListType *> BlockToAccesses;
+  DenseMap<const BasicBlock *, MemoryPhi *> BlockToPhi;
+
+  /// CachedClobbers - The results of getClobberingMemoryAccess for
+  /// instructions.
+  DenseMap<const MemoryAccess *, MemoryAccess *> CachedClobbers;
+
+  /// CachedWalks - The results of getClobberingMemoryAccess for locations,
+  /// by the definition the walk went through and the location.  The key only
+  /// holds the address of the location's pointer, which a new value may get
+  /// once the pointer is deleted, so each result also tracks the pointer and
+  /// is ignored once it was deleted or replaced.
+  typedef std::pair<const MemoryAccess *, AliasAnalysis::Location> WalkKey;
+  struct CachedWalk {
+    MemoryAccess *Clobber;
+    WeakVH Ptr;
+  };
+  DenseMap<WalkKey, CachedWalk> CachedWalks;
+};
+
+/// MemorySSAAnalysis - The pass that builds the MemorySSA form of a function
+/// for the passes that require it.  A pass that preserves it must keep the
+/// form up to date as it deletes or adds memory instructions and splits
+/// edges.  MergeBlockIntoPredecessor updates it when it is available.
+class MemorySSAAnalysis : public FunctionPass {
+  OwningPtr<MemorySSA> MSSA;
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  MemorySSAAnalysis();
+
+  MemorySSA &getMSSA() { return *MSSA; }
+  const MemorySSA &getMSSA() const { return *MSSA; }
+
+  virtual bool runOnFunction(Function &F);
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+  virtual void releaseMemory();
+  virtual void print(raw_ostream &OS, const Module * = 0) const;
+};
+
+} // end namespace llvm
+
+#endif
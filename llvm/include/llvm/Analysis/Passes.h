@@ -156,6 +156,13 @@ namespace llvm {
   // information and prints it with -analyze.
   //
   FunctionPass *createMemDepPrinter();
+
+  //===--------------------------------------------------------------------===//
+  //
+  // createMemorySSAPrinterPass - This pass builds the MemorySSA form of each
+  // function and prints it with -analyze.
+  //
+  FunctionPass *createMemorySSAPrinterPass();
 }
 
 #endif
@@ -280,6 +280,15 @@ public:
   /// Is this type legal.
   virtual bool isTypeLegal(Type *Ty) const;
 
+  /// isLegalMaskedLoad - Return true if the target supports masked loads
+  /// (llvm.masked.load) of the given data type. \p DataType may be a vector
+  /// type, or the scalar element type when the vector width is not known yet.
+  virtual bool isLegalMaskedLoad(Type *DataType) const;
+
+  /// isLegalMaskedStore - Return true if the target supports masked stores
+  /// (llvm.masked.store) of the given data type.
+  virtual bool isLegalMaskedStore(Type *DataType) const;
+
   /// getJumpBufAlignment - returns the target's jmp_buf alignment in bytes
   virtual unsigned getJumpBufAlignment() const;
 
@@ -368,6 +377,24 @@ public:
                                    unsigned Alignment,
                                    unsigned AddressSpace) const;
 
+  /// \return The cost of an interleaved load or store: one wide access of
+  /// type \p VecTy over \p Factor interleaved fields, plus the shuffles that
+  /// separate the fields in \p Indices from it (for a load) or merge all of
+  /// the fields into it (for a store).
+  virtual unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const;
+
+  /// \return The cost of a masked vector load or store (llvm.masked.load and
+  /// llvm.masked.store) of type \p Src. This includes the cost of emulating
+  /// the operation with conditional scalar accesses if the target has no
+  /// native support for it.
+  virtual unsigned getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                         unsigned Alignment,
+                                         unsigned AddressSpace) const;
+
   /// \brief Calculate the cost of performing a vector reduction.
   ///
   /// This is the cost of reducing the vector value of type \p Ty to a scalar
@@ -0,0 +1,70 @@
+//===-- llvm/CodeGen/GlobalISel/CallLowering.h - Call lowering --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file describes how the global instruction selector lowers formal
+// arguments, returns and calls. These are the only places where it needs the
+// calling convention, so the target emits them directly as copies to and from
+// physical registers around its own call and return instructions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+#define LLVM_CODEGEN_GLOBALISEL_CALLLOWERING_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Support/DebugLoc.h"
+
+namespace llvm {
+
+class CallInst;
+class Function;
+class MachineBasicBlock;
+class MachineFunction;
+class TargetMachine;
+class Value;
+
+class CallLowering {
+protected:
+  const TargetMachine &TM;
+
+public:
+  explicit CallLowering(const TargetMachine &TM) : TM(TM) {}
+  virtual ~CallLowering();
+
+  /// canLowerFunction - Return true if the arguments and the return value of
+  /// MF's function can be lowered. Otherwise the function is left to
+  /// SelectionDAG.
+  virtual bool canLowerFunction(MachineFunction &MF) const = 0;
+
+  /// canLowerCall - Return true if CI, which is not an intrinsic call, can be
+  /// lowered by lowerCall.
+  virtual bool canLowerCall(MachineFunction &MF,
+                            const CallInst &CI) const = 0;
+
+  /// lowerArguments - Append code to MBB that defines the generic virtual
+  /// register VRegs[i] with the value of the i-th argument of F.
+  virtual void lowerArguments(MachineBasicBlock &MBB, const Function &F,
+                              ArrayRef<unsigned> VRegs) const = 0;
+
+  /// lowerReturn - Append a return of Val, held in the generic virtual
+  /// register VReg, to MBB. Val is null for a void return.
+  virtual void lowerReturn(MachineBasicBlock &MBB, const Value *Val,
+                           unsigned VReg, DebugLoc DL) const = 0;
+
+  /// lowerCall - Append the call CI to MBB. CalleeReg holds the address of
+  /// the callee for indirect calls and is 0 for direct calls. ArgRegs holds
+  /// the arguments, and the result is defined in ResReg unless it is 0.
+  virtual void lowerCall(MachineBasicBlock &MBB, const CallInst &CI,
+                         unsigned CalleeReg, ArrayRef<unsigned> ArgRegs,
+                         unsigned ResReg) const = 0;
+};
+
+} // End llvm namespace
+
+#endif
@@ -0,0 +1,44 @@
+//===-- llvm/CodeGen/GlobalISel/GlobalISel.h - Global ISel passes -*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The global instruction selector selects a whole function at a time, working
+// on MachineInstrs instead of a SelectionDAG per basic block. It runs as four
+// passes, each of which a target enables by implementing one interface:
+//
+//  IRTranslator       - Translates LLVM IR into generic MachineInstrs on
+//                       generic virtual registers (CallLowering).
+//  Legalizer          - Widens or expands the generic instructions the target
+//                       cannot select directly (LegalizerInfo).
+//  RegBankSelect      - Assigns a register bank and class to every generic
+//                       virtual register, inserting copies between banks
+//                       where needed (RegisterBankInfo).
+//  InstructionSelect  - Replaces the generic instructions with target
+//                       instructions (InstructionSelector).
+//
+// The IRTranslator checks up front that every instruction of the function is
+// supported. If one is not, it leaves the MachineFunction empty and the
+// target's SelectionDAG selector, which runs afterwards, selects it instead.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_GLOBALISEL_H
+#define LLVM_CODEGEN_GLOBALISEL_GLOBALISEL_H
+
+namespace llvm {
+
+class FunctionPass;
+
+FunctionPass *createIRTranslatorPass();
+FunctionPass *createLegalizerPass();
+FunctionPass *createRegBankSelectPass();
+FunctionPass *createInstructionSelectPass();
+
+} // End llvm namespace
+
+#endif
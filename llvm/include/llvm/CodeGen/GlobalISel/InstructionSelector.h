@@ -0,0 +1,36 @@
+//===-- llvm/CodeGen/GlobalISel/InstructionSelector.h -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the target hook that replaces legal, register bank
+// selected generic instructions with target instructions.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+#define LLVM_CODEGEN_GLOBALISEL_INSTRUCTIONSELECTOR_H
+
+namespace llvm {
+
+class MachineInstr;
+
+class InstructionSelector {
+public:
+  virtual ~InstructionSelector();
+
+  /// select - Replace the generic instruction I with target instructions
+  /// inserted before it, and erase I. Instructions are visited bottom-up, so
+  /// I may fold the generic instructions that define its operands; those are
+  /// erased by the caller once they have no uses left. select may not erase
+  /// any instruction before I. Return false if I cannot be selected.
+  virtual bool select(MachineInstr &I) const = 0;
+};
+
+} // End llvm namespace
+
+#endif
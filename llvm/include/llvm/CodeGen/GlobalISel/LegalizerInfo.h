@@ -0,0 +1,77 @@
+//===-- llvm/CodeGen/GlobalISel/LegalizerInfo.h - Legality ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the table the Legalizer pass uses to decide what to do
+// with each generic instruction. An instruction is classified by its opcode
+// and the size of the one register operand that matters for that opcode,
+// which is the result for most instructions and the source for comparisons,
+// extensions, int-to-fp conversions and stores.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_LEGALIZERINFO_H
+#define LLVM_CODEGEN_GLOBALISEL_LEGALIZERINFO_H
+
+#include "llvm/ADT/DenseMap.h"
+#include <utility>
+
+namespace llvm {
+
+class MachineInstr;
+class MachineRegisterInfo;
+
+class LegalizerInfo {
+public:
+  enum LegalizeAction {
+    /// The instruction can be selected as it is.
+    Legal,
+    /// The instruction is rewritten at a larger size which is legal.
+    WidenScalar,
+    /// The instruction is expanded into other generic instructions.
+    Lower,
+    /// The instruction cannot be handled; functions containing it are left
+    /// to SelectionDAG.
+    Unsupported
+  };
+
+  virtual ~LegalizerInfo();
+
+  /// setAction - Record the action for Opcode at Size. Sizes that are not set
+  /// explicitly are widened to the next larger Legal size for the opcode, or
+  /// are Unsupported if there is none.
+  void setAction(unsigned Opcode, unsigned Size, LegalizeAction Action) {
+    Actions[std::make_pair(Opcode, Size)] = Action;
+  }
+
+  /// getAction - Return the action for Opcode at Size, and the size to widen
+  /// to for WidenScalar.
+  std::pair<LegalizeAction, unsigned> getAction(unsigned Opcode,
+                                                unsigned Size) const;
+
+  /// getAction - Return the action for the generic instruction MI.
+  std::pair<LegalizeAction, unsigned>
+  getAction(const MachineInstr &MI, const MachineRegisterInfo &MRI) const;
+
+  /// isSupported - Return true if Opcode at Size is legal or can be made
+  /// legal.
+  bool isSupported(unsigned Opcode, unsigned Size) const {
+    return getAction(Opcode, Size).first != Unsupported;
+  }
+
+  /// getTypeOperandIdx - Return the index of the operand whose size
+  /// classifies instructions with the given generic opcode.
+  static unsigned getTypeOperandIdx(unsigned Opcode);
+
+private:
+  DenseMap<std::pair<unsigned, unsigned>, LegalizeAction> Actions;
+};
+
+} // End llvm namespace
+
+#endif
@@ -0,0 +1,60 @@
+//===-- llvm/CodeGen/GlobalISel/RegisterBankInfo.h - Banks ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the interface RegBankSelect uses to assign generic
+// virtual registers to register banks. A bank is a set of register classes
+// that can be copied between cheaply, such as the general purpose or the
+// floating point registers. Once a register has a bank, its class follows
+// from the bank and its size.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_GLOBALISEL_REGISTERBANKINFO_H
+#define LLVM_CODEGEN_GLOBALISEL_REGISTERBANKINFO_H
+
+namespace llvm {
+
+class MachineInstr;
+class TargetRegisterClass;
+
+class RegisterBankInfo {
+public:
+  /// AnyBank - The operand does not constrain the bank of its register.
+  static const unsigned AnyBank = ~0U;
+
+  virtual ~RegisterBankInfo();
+
+  /// getNumRegBanks - Return the number of register banks.
+  virtual unsigned getNumRegBanks() const = 0;
+
+  /// getRegBankName - Return the name of Bank, for debug output.
+  virtual const char *getRegBankName(unsigned Bank) const = 0;
+
+  /// getDefaultRegBank - Return the bank of registers that nothing
+  /// constrains.
+  virtual unsigned getDefaultRegBank() const = 0;
+
+  /// getOperandRegBank - Return the bank that the register operand OpIdx of
+  /// the generic instruction MI must be in, or AnyBank.
+  virtual unsigned getOperandRegBank(const MachineInstr &MI,
+                                     unsigned OpIdx) const = 0;
+
+  /// getRegBankForRegClass - Return the bank that contains RC.
+  virtual unsigned
+  getRegBankForRegClass(const TargetRegisterClass *RC) const = 0;
+
+  /// getRegClass - Return the register class for generic registers of Size
+  /// bits in Bank, or null if the bank has no registers of that size.
+  virtual const TargetRegisterClass *getRegClass(unsigned Bank,
+                                                 unsigned Size) const = 0;
+};
+
+} // End llvm namespace
+
+#endif
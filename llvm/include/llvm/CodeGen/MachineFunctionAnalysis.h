@@ -19,13 +19,17 @@
 namespace llvm {
 
 class MachineFunction;
+class MachineModuleInfo;
 class TargetMachine;
 
 /// MachineFunctionAnalysis - This class is a Pass that manages a
-/// MachineFunction object.
+/// MachineFunction object. If MachineModuleInfo retains machine functions,
+/// the MachineFunction outlives this pass and a later MachineFunctionAnalysis
+/// picks it up again.
 struct MachineFunctionAnalysis : public FunctionPass {
 private:
   const TargetMachine &TM;
+  MachineModuleInfo *MMI;
   MachineFunction *MF;
   unsigned NextFnNum;
 public:
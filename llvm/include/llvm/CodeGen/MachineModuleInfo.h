@@ -165,6 +165,18 @@ class MachineModuleInfo : public ImmutablePass {
   /// to _fltused on Windows targets.
   bool UsesVAFloatArgument;
 
+  /// RetainMFs - True if MachineFunctionAnalysis should hand machine functions
+  /// over to this object instead of deleting them.
+  bool RetainMFs;
+
+  struct RetainedFunction;
+
+  /// RetainedMFs - Machine functions kept alive after the machine function
+  /// passes, with the per-function information that belongs to them.
+  DenseMap<const Function *, RetainedFunction *> RetainedMFs;
+
+  void swapFunctionInfo(RetainedFunction &RF);
+
 public:
   static char ID; // Pass identification, replacement for typeid
 
@@ -231,6 +243,28 @@ public:
     UsesVAFloatArgument = b;
   }
 
+  /// setRetainMachineFunctions - When set, the machine function of each
+  /// function is kept alive after the last machine function pass that uses
+  /// it, instead of being deleted. This lets a module pass see the machine
+  /// code of every function before any of it is emitted. The next
+  /// MachineFunctionAnalysis to run on a function takes its machine function
+  /// back.
+  void setRetainMachineFunctions(bool Retain) { RetainMFs = Retain; }
+  bool retainsMachineFunctions() const { return RetainMFs; }
+
+  /// retainMachineFunction - Take ownership of MF, together with the
+  /// per-function information above, which is reset for the next function.
+  void retainMachineFunction(MachineFunction *MF);
+
+  /// getRetainedMachineFunction - Return the retained machine function for F,
+  /// or null.
+  MachineFunction *getRetainedMachineFunction(const Function *F) const;
+
+  /// takeRetainedMachineFunction - Give up ownership of the machine function
+  /// for F, and make its per-function information current again. Returns null
+  /// if F has no retained machine function.
+  MachineFunction *takeRetainedMachineFunction(const Function *F);
+
   /// \brief Returns a reference to a list of cfi instructions in the current
   /// function's prologue.  Used to construct frame maps for debug and exception
   /// handling comsumers.
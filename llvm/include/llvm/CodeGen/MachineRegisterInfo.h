@@ -65,6 +65,11 @@ private:
   /// register of the hint.
   IndexedMap<std::pair<unsigned, unsigned>, VirtReg2IndexFunctor> RegAllocHints;
 
+  /// VRegToSize - The size in bits of each generic virtual register, or 0 for
+  /// registers created with a register class. Generic registers only exist
+  /// during global instruction selection.
+  IndexedMap<unsigned, VirtReg2IndexFunctor> VRegToSize;
+
   /// PhysRegUseDefLists - This is an array of the head of the use/def list for
   /// physical registers.
   MachineOperand **PhysRegUseDefLists;
@@ -372,6 +377,17 @@ public:
   ///
   unsigned createVirtualRegister(const TargetRegisterClass *RegClass);
 
+  /// createGenericVirtualRegister - Create and return a new generic virtual
+  /// register of the given size in bits. It has no register class until one
+  /// is set with setRegClass.
+  unsigned createGenericVirtualRegister(unsigned Size);
+
+  /// getSize - Return the size in bits of the generic virtual register Reg,
+  /// or 0 if Reg was not created as a generic register.
+  unsigned getSize(unsigned Reg) const {
+    return VRegToSize.inBounds(Reg) ? VRegToSize[Reg] : 0;
+  }
+
   /// getNumVirtRegs - Return the number of virtual registers created.
   ///
   unsigned getNumVirtRegs() const { return VRegInfo.size(); }
@@ -0,0 +1,77 @@
+//===-- llvm/CodeGen/ParallelCG.h - Parallel code generation ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header declares functions that can be used for parallel code generation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CODEGEN_PARALLELCG_H
+#define LLVM_CODEGEN_PARALLELCG_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/Target/TargetMachine.h"
+#include <string>
+
+namespace llvm {
+
+class Module;
+class PassManagerBase;
+class TargetLibraryInfo;
+class formatted_raw_ostream;
+class raw_ostream;
+
+/// cloneTargetMachine - Create a TargetMachine for the same target, CPU,
+/// features, options, relocation model, code model and optimization level as
+/// \p TM, with the same MC settings (such as .loc, CFI and relax-all).
+/// Returns null if the target cannot create one.
+TargetMachine *cloneTargetMachine(const TargetMachine &TM);
+
+/// addCodeGenPasses - Add to \p PM the passes that generate code for \p M
+/// with \p TM into \p OS: a copy of \p TLI if it is not null, the analysis
+/// passes of the target, the DataLayout of \p TM (or of \p M if \p TM has
+/// none) and the code generator itself. splitCodeGen sets up the pass
+/// manager of every partition with it, so clients that use it for whole
+/// modules compile partitions the same way.
+///
+/// \returns true if \p TM cannot emit \p FileType, like
+/// TargetMachine::addPassesToEmitFile.
+bool addCodeGenPasses(PassManagerBase &PM, Module &M, TargetMachine &TM,
+                      const TargetLibraryInfo *TLI, formatted_raw_ostream &OS,
+                      TargetMachine::CodeGenFileType FileType,
+                      bool DisableVerify = true, AnalysisID StartAfter = 0,
+                      AnalysisID StopAfter = 0);
+
+/// splitCodeGen - Split \p M into OSs.size() balanced partitions with
+/// SplitModule, preserving call graph locality, and generate code for each
+/// partition concurrently, writing the output for partition I to *OSs[I].
+/// The partitions are compiled as tasks of a ThreadPool, each in its own
+/// LLVMContext, with its own copy of \p TM made by cloneTargetMachine and the
+/// passes of addCodeGenPasses, including a copy of \p TLI if it is not null.
+///
+/// Each stream receives a complete object file or assembly file, and the
+/// program needs all of them: they are linked together like the outputs of
+/// separate translation units. The partitioning does not depend on the number
+/// of threads that are actually available, so every output is the same
+/// whether or not the partitions are compiled concurrently. If OSs.size() is
+/// 1, \p M is compiled as is on the calling thread with \p TM.
+///
+/// Local symbols of \p M that are referenced across partitions are promoted
+/// to hidden symbols, so \p M is modified even if code generation fails.
+///
+/// This puts LLVM into multithreaded mode if it is not already.
+///
+/// \returns true on success. On failure, returns false and sets \p ErrMsg.
+bool splitCodeGen(Module *M, ArrayRef<raw_ostream *> OSs, TargetMachine &TM,
+                  const TargetLibraryInfo *TLI,
+                  TargetMachine::CodeGenFileType FileType,
+                  std::string &ErrMsg);
+
+} // End llvm namespace
+
+#endif
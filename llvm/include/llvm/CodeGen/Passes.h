@@ -23,6 +23,7 @@ namespace llvm {
 
 class FunctionPass;
 class MachineFunctionPass;
+class ModulePass;
 class PassConfigImpl;
 class PassInfo;
 class PassManagerBase;
@@ -154,6 +155,10 @@ public:
   bool getEnableTailMerge() const { return EnableTailMerge; }
   void setEnableTailMerge(bool Enable) { setOpt(EnableTailMerge, Enable); }
 
+  /// isGlobalISelEnabled - Return true if targets that support it should run
+  /// the global instruction selector ahead of their SelectionDAG selector.
+  bool isGlobalISelEnabled() const;
+
   /// Allow the target to override a specific pass without overriding the pass
   /// pipeline. When passes are added to the standard pipeline at the
   /// point where StandardID is expected, add TargetID in its place.
@@ -193,7 +198,10 @@ public:
   virtual void addISelPrepare();
 
   /// addInstSelector - This method should install an instruction selector pass,
-  /// which converts from LLVM code to machine instructions.
+  /// which converts from LLVM code to machine instructions. When
+  /// isGlobalISelEnabled() is true, targets with a global instruction selector
+  /// add it in front of their SelectionDAG selector, which then only handles
+  /// the functions the global selector left alone.
   virtual bool addInstSelector() {
     return true;
   }
@@ -428,6 +436,12 @@ namespace llvm {
   ///
   FunctionPass *createGreedyRegisterAllocator();
 
+  /// LinearScanRegisterAllocation Pass - This pass implements a global register
+  /// allocator that assigns live ranges in linear order, with simple splitting.
+  /// It trades some code quality for compile time, for JIT compilers.
+  ///
+  FunctionPass *createLinearScanRegisterAllocator();
+
   /// PBQPRegisterAllocation Pass - This pass implements the Partitioned Boolean
   /// Quadratic Prograaming (PBQP) based register allocator.
   ///
@@ -563,6 +577,12 @@ namespace llvm {
   /// bundles (created earlier, e.g. during pre-RA scheduling).
   extern char &FinalizeMachineBundlesID;
 
+  /// createMachineOutlinerPass - This pass replaces instruction sequences
+  /// repeated across the module's machine functions with calls to new
+  /// functions. It runs after register allocation, and needs every machine
+  /// function of the module at once.
+  ModulePass *createMachineOutlinerPass();
+
 } // End llvm namespace
 
 #endif
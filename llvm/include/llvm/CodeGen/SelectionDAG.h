@@ -20,6 +20,7 @@
 #include "llvm/ADT/ilist.h"
 #include "llvm/CodeGen/DAGCombine.h"
 #include "llvm/CodeGen/SelectionDAGNodes.h"
+#include "llvm/Support/ArrayRecycler.h"
 #include "llvm/Support/RecyclingAllocator.h"
 #include "llvm/Target/TargetMachine.h"
 #include <cassert>
@@ -196,9 +197,14 @@ class SelectionDAG {
   /// CSE with existing nodes when a duplicate is requested.
   FoldingSet<SDNode> CSEMap;
 
-  /// OperandAllocator - Pool allocation for machine-opcode SDNode operands.
+  /// OperandAllocator - Pool allocation for SDNode operands that don't fit in
+  /// the node itself.
   BumpPtrAllocator OperandAllocator;
 
+  /// OperandRecycler - Recycles the operand lists of deleted and morphed
+  /// nodes, so nodes with many operands don't need their own allocations.
+  ArrayRecycler<SDUse> OperandRecycler;
+
   /// Allocator - Pool allocation for misc. objects that are created once per
   /// SelectionDAG.
   BumpPtrAllocator Allocator;
@@ -1132,6 +1138,14 @@ private:
   void DeleteNodeNotInCSEMaps(SDNode *N);
   void DeallocateNode(SDNode *N);
 
+  /// createOperands - Give N an operand list from the operand recycler,
+  /// holding the NumOps values in Ops.
+  void createOperands(SDNode *N, const SDValue *Ops, unsigned NumOps);
+
+  /// removeOperands - Give the operand list of N back to the operand
+  /// recycler, if it came from there.
+  void removeOperands(SDNode *N);
+
   unsigned getEVTAlignment(EVT MemoryVT) const;
 
   void allnodes_clear();
@@ -22,6 +22,7 @@
 
 namespace llvm {
   class FastISel;
+  class FastISelReport;
   class SelectionDAGBuilder;
   class SDValue;
   class MachineRegisterInfo;
@@ -66,6 +67,8 @@ public:
 
   virtual bool runOnMachineFunction(MachineFunction &MF);
 
+  virtual bool doFinalization(Module &M);
+
   virtual void EmitFunctionEntryCode() {}
 
   /// PreprocessISelDAG - This hook allows targets to hack on the graph before
@@ -277,6 +280,10 @@ private:
   ///
   ScheduleDAGSDNodes *CreateScheduler();
 
+  /// FastISReport - The instructions FastISel left to SelectionDAG in this
+  /// module, kept when -fast-isel-report is given.
+  FastISelReport *FastISReport;
+
   /// OpcodeOffset - This is a cache used to dispatch efficiently into isel
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
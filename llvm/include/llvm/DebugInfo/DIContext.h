@@ -145,6 +145,24 @@ public:
       uint64_t Size, DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
   virtual DIInliningInfo getInliningInfoForAddress(uint64_t Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
+
+  /// setNumThreads - Set the number of threads that build the index from
+  /// addresses to compile units.  Zero or one builds it on the calling thread.
+  /// Contexts without such an index ignore it.
+  virtual void setNumThreads(unsigned NumThreads) {}
+
+  /// writeAddressIndex - Write the index from addresses to compile units to
+  /// OS, building it first if needed.  Key identifies the binary the index is
+  /// for, e.g. by a hash of its contents.  Contexts without such an index
+  /// write nothing.
+  virtual void writeAddressIndex(raw_ostream &OS, uint64_t Key) {}
+
+  /// readAddressIndex - Use the index in Buffer rather than build one.  Returns
+  /// false if Buffer does not hold an index written for this debug info with
+  /// the same Key, or if this context has no such index.
+  virtual bool readAddressIndex(StringRef Buffer, uint64_t Key) {
+    return false;
+  }
 private:
   const DIContextKind Kind;
 };
@@ -178,7 +178,11 @@ public:
     /// Appends the two values, which are required to be metadata
     /// nodes. However, duplicate entries in the second list are dropped
     /// during the append operation.
-    AppendUnique = 6
+    AppendUnique = 6,
+
+    /// Takes the larger of the two values, which are required to be
+    /// integers.
+    Max = 7
   };
 
   struct ModuleFlagEntry {
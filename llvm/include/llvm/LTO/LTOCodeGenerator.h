@@ -36,6 +36,7 @@
 #define LTO_CODE_GENERATOR_H
 
 #include "llvm-c/lto.h"
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/Linker.h"
@@ -71,6 +72,9 @@ struct LTOCodeGenerator {
 
   void setCpu(const char *mCpu) { MCpu = mCpu; }
 
+  // Set the number of object files that compile_to_files() generates.
+  void setCodeGenParallelism(unsigned N) { CodeGenParallelism = N ? N : 1; }
+
   void addMustPreserveSymbol(const char *sym) { MustPreserveSymbols[sym] = 1; }
 
   // To pass options to the driver and optimization passes. These options are
@@ -115,14 +119,33 @@ struct LTOCodeGenerator {
                       bool disableGVNLoadPRE,
                       std::string &errMsg);
 
+  // As with compile_to_file(), this function compiles the merged module, but
+  // into as many object files as set by setCodeGenParallelism(). After
+  // optimization, the merged module is split into partitions that keep
+  // related functions together, and code is generated for each partition on
+  // its own thread. The paths to the object files are returned to the caller
+  // via arguments "names" and "count"; the array is owned by the
+  // LTOCodeGenerator and stays valid until it is destroyed or
+  // compile_to_files() is called again. Return true on success.
+  //
+  // As with compile_to_file(), it is up to the linker to remove the object
+  // files.
+  //
+  bool compile_to_files(const char ***names,
+                        unsigned *count,
+                        bool disableOpt,
+                        bool disableInline,
+                        bool disableGVNLoadPRE,
+                        std::string &errMsg);
+
 private:
   void initializeLTOPasses();
 
-  bool generateObjectFile(llvm::raw_ostream &out,
-                          bool disableOpt,
-                          bool disableInline,
-                          bool disableGVNLoadPRE,
-                          std::string &errMsg);
+  bool generateObjectFiles(llvm::ArrayRef<llvm::raw_ostream *> out,
+                           bool disableOpt,
+                           bool disableInline,
+                           bool disableGVNLoadPRE,
+                           std::string &errMsg);
   void applyScopeRestrictions();
   void applyRestriction(llvm::GlobalValue &GV,
                         std::vector<const char*> &MustPreserveList,
@@ -138,12 +161,15 @@ private:
   bool EmitDwarfDebugInfo;
   bool ScopeRestrictionsDone;
   lto_codegen_model CodeModel;
+  unsigned CodeGenParallelism;
   StringSet MustPreserveSymbols;
   StringSet AsmUndefinedRefs;
   llvm::MemoryBuffer *NativeObjectFile;
   std::vector<char *> CodegenOptions;
   std::string MCpu;
   std::string NativeObjectPath;
+  std::vector<std::string> NativeObjectPaths;
+  std::vector<const char *> NativeObjectPathNames;
   llvm::TargetOptions Options;
 };
 
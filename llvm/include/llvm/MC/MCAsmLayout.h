@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include <vector>
 
 namespace llvm {
 class MCAssembler;
@@ -42,6 +43,48 @@ private:
   /// lower ordinal will be valid.
   mutable DenseMap<const MCSectionData*, MCFragment*> LastValidFragment;
 
+  /// A fragment whose relaxation depends on the distance between the
+  /// fragments with layout orders Begin and End of a section.
+  struct DependentSpan {
+    unsigned Begin, End;
+    MCFragment *Dependent;
+  };
+
+  /// An alignment or org fragment, with its last seen offset and size.
+  struct PaddingState {
+    MCFragment *Frag;
+    uint64_t Offset, Size;
+  };
+
+  /// The fragments whose relaxation depends on the offsets within a section.
+  struct SectionDependents {
+    /// The dependents on distances, sorted by Begin.
+    std::vector<DependentSpan> Spans;
+    /// The largest End - Begin in Spans.
+    unsigned MaxSpan;
+    /// The dependents on the offset of a single fragment, as pairs of its
+    /// layout order and the dependent, sorted by layout order.
+    std::vector<std::pair<unsigned, MCFragment*> > Offsets;
+    /// The alignment and org fragments, in layout order. Their size depends
+    /// on their offset, so the offset and size they had when the dependents
+    /// last saw them are kept to tell whether a resize before them changed
+    /// their size as well.
+    std::vector<PaddingState> Padding;
+
+    SectionDependents() : MaxSpan(0) {}
+  };
+
+  /// The invalidation index used by relaxation.
+  DenseMap<const MCSectionData*, SectionDependents> Dependents;
+
+  /// Whether the lists in Dependents are sorted.
+  bool DependentsSorted;
+
+  /// Append to \p Result the dependents on a span of \p SD that contains the
+  /// fragment with layout order \p Order, other than at its end.
+  static void getSpansContaining(const SectionDependents &SD, unsigned Order,
+                                 SmallVectorImpl<MCFragment*> &Result);
+
   /// \brief Make sure that the layout for the given fragment is valid, lazily
   /// computing it if necessary.
   void ensureValid(const MCFragment *F) const;
@@ -65,6 +108,33 @@ public:
   /// its bundle padding will be recomputed.
   void invalidateFragmentsFrom(MCFragment *F);
 
+  /// \brief Record that whether \p Dependent needs relaxation depends on the
+  /// distance between \p First and \p Last, which are in the same section and
+  /// in layout order. If \p First is null, it depends on the offset of \p Last
+  /// within its section.
+  void addDependent(const MCFragment *First, const MCFragment *Last,
+                    MCFragment *Dependent);
+
+  /// \brief Sort the recorded dependents and note the current offset and size
+  /// of the alignment and org fragments. This must be called after the last
+  /// addDependent and before any fragment is resized.
+  void finishDependents();
+
+  /// \brief Append to \p Result the recorded dependents whose distance or
+  /// offset may change when \p F is resized, because it lies between the two
+  /// fragments or before the one they depend on. The first alignment or org
+  /// fragment after \p F is appended as well, to be passed to
+  /// getDependentsOfPadding once it is laid out again.
+  void getDependentsOfResize(const MCFragment *F,
+                             SmallVectorImpl<MCFragment*> &Result);
+
+  /// \brief Append to \p Result the recorded dependents that may change
+  /// because the alignment or org fragment \p F has moved since it was last
+  /// examined: those on a distance that \p F is part of if its size changed,
+  /// and the next such fragment if \p F does not end where it did.
+  void getDependentsOfPadding(MCFragment *F,
+                              SmallVectorImpl<MCFragment*> &Result);
+
   /// \brief Perform layout for a single fragment, assuming that the previous
   /// fragment has already been laid out correctly, and the parent section has
   /// been initialized.
@@ -10,6 +10,7 @@
 #ifndef LLVM_MC_MCASSEMBLER_H
 #define LLVM_MC_MCASSEMBLER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
@@ -37,6 +38,11 @@ class MCSymbol;
 class MCSymbolData;
 class MCValue;
 class MCAsmBackend;
+class ThreadPool;
+
+namespace sys {
+class MutexImpl;
+}
 
 class MCFragment : public ilist_node<MCFragment> {
   friend class MCAsmLayout;
@@ -890,6 +896,17 @@ private:
   // Access to the flags is necessary in cases where assembler directives affect
   // which flags to be set.
   unsigned ELFHeaderEFlags;
+
+  /// The number of threads that relax and write the sections concurrently. If
+  /// this is zero or one, everything happens on the calling thread.
+  unsigned NumThreads;
+
+  /// The pool of worker threads while Finish runs with several threads.
+  ThreadPool *Pool;
+
+  /// Serializes the code emitter, which allocates from the MCContext, while
+  /// the sections are relaxed concurrently.
+  sys::MutexImpl *EmitterLock;
 private:
   /// Evaluate a fixup to a relocatable expression and the value which should be
   /// placed into the fixup.
@@ -925,6 +942,29 @@ private:
   /// if any offsets were adjusted.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
 
+  /// \brief Relax fragments until everything fits. Every fragment is examined
+  /// once up front, and then again only when a fragment whose offset decides
+  /// its relaxation has moved.
+  void layoutWithWorklist(MCAsmLayout &Layout);
+
+  /// \brief Relax \p Fragments, and the fragments whose relaxation depends on
+  /// them, until they fit. \p Unanalyzable are examined again after every
+  /// resize. If \p Only is not null, fragments of other sections are not
+  /// examined.
+  void relaxWithWorklist(MCAsmLayout &Layout, ArrayRef<MCFragment*> Fragments,
+                         ArrayRef<MCFragment*> Unanalyzable,
+                         const MCSectionData *Only);
+
+  /// \brief Relax the fragments of the given section without updating the
+  /// layout, and return the first fragment that was relaxed or null.
+  MCFragment *relaxSection(MCAsmLayout &Layout, MCSectionData &SD);
+
+  static void relaxSectionTask(void *Arg);
+
+  /// \brief Relax the given fragment if it needs it, and return true if its
+  /// size changed.
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
+
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
@@ -959,6 +999,15 @@ public:
   void writeSectionData(const MCSectionData *Section,
                         const MCAsmLayout &Layout) const;
 
+  /// Emit the contents of each of \p Sections into the corresponding element
+  /// of \p Contents, which is resized to match. The sections are written
+  /// concurrently if Finish is running with several threads. Virtual sections
+  /// get no contents.
+  void writeSectionDataConcurrently(ArrayRef<const MCSectionData *> Sections,
+                                    const MCAsmLayout &Layout,
+                                    std::vector<SmallString<0> > &Contents)
+    const;
+
   /// Check whether a given symbol has been flagged with .thumb_func.
   bool isThumbFunc(const MCSymbol *Func) const {
     return ThumbFuncs.count(Func);
@@ -997,6 +1046,14 @@ public:
 
   MCObjectWriter &getWriter() const { return Writer; }
 
+  /// Get the number of threads used to lay out and write the sections.
+  unsigned getNumThreads() const { return NumThreads; }
+
+  /// Set the number of threads used to lay out and write the sections. With
+  /// more than one, the sections are relaxed in rounds against a shared
+  /// layout, which gives the same output for any number of threads.
+  void setNumThreads(unsigned Value) { NumThreads = Value; }
+
   /// Finish - Do final processing and write the object to the output stream.
   /// \p Writer is used for custom object writer (as the MCJIT does),
   /// if not specified it is automatically created from backend.
@@ -19,6 +19,8 @@
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Mutex.h"
+#include <vector>
 
 namespace llvm {
 namespace object {
@@ -88,6 +90,9 @@ public:
       return StringRef(Data.data() + StartOfFile, getSize());
     }
 
+    /// getMemoryBuffer - Return a MemoryBuffer that refers to the contents of
+    /// the member in the archive's own buffer.  Nothing is copied, so the
+    /// buffer must not outlive the archive.
     error_code getMemoryBuffer(OwningPtr<MemoryBuffer> &Result,
                                bool FullPath = false) const;
 
@@ -185,7 +190,9 @@ public:
     return v->isArchive();
   }
 
-  // check if a symbol is in the archive
+  /// findSym - Return the member that defines the symbol \p name, or
+  /// end_children() if the symbol table does not list it.  The first call
+  /// builds a hash index of the symbol table, so later lookups do not scan it.
   child_iterator findSym(StringRef name) const;
 
   bool hasSymbolTable() const;
@@ -195,6 +202,25 @@ private:
   child_iterator StringTable;
   child_iterator FirstRegular;
   Kind Format;
+
+  /// SymbolIndexEntry - A slot of the open-addressed symbol table index.
+  struct SymbolIndexEntry {
+    uint32_t Hash;
+    /// One more than the index of the symbol, or zero for an empty slot.
+    uint32_t SymbolNumber;
+  };
+  /// The hash index of the symbol names, built by the first findSym.  Only
+  /// the first symbol of each name is entered.
+  mutable std::vector<SymbolIndexEntry> SymbolIndex;
+  /// The offset of the name of each symbol in the symbol table member.
+  mutable std::vector<uint32_t> SymbolNameOffsets;
+  /// Set once SymbolIndex and SymbolNameOffsets are complete; findSym may be
+  /// called from several threads, so the index is built under
+  /// SymbolIndexLock.
+  mutable bool SymbolIndexBuilt;
+  mutable sys::Mutex SymbolIndexLock;
+
+  void buildSymbolIndex() const;
 };
 
 }
@@ -358,6 +358,12 @@ public:
 /// @brief This is the storage for the -time-passes option.
 extern bool TimePassesIsEnabled;
 
+/// isFunctionOverCompileBudget - Return true if -function-compile-budget-us is
+/// given and the passes that the pass manager running P has run on F so far
+/// have taken longer than that.  Optional passes that can be expensive check
+/// this to do less work on F.
+bool isFunctionOverCompileBudget(const Pass &P, const Function &F);
+
 } // End llvm namespace
 
 // Include support files that contain important APIs commonly used by Passes,
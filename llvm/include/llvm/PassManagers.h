@@ -18,7 +18,9 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/ValueMap.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/ValueHandle.h"
 #include <map>
 #include <vector>
 
@@ -227,6 +229,19 @@ public:
   // Active Pass Managers
   PMStack activeStack;
 
+  /// CompileTimeConfig - Entries are keyed by Value, so that replacing the
+  /// uses of a function with a cast of another one leaves them alone.
+  struct CompileTimeConfig : ValueMapConfig<const Value *> {
+    enum { FollowRAUW = false };
+  };
+  typedef ValueMap<const Value *, uint64_t, CompileTimeConfig>
+    CompileTimeMap;
+
+  /// FunctionCompileTime - The time the passes have spent on each function in
+  /// the current run, for -function-compile-budget-us.  It is cleared when a
+  /// run starts, and an entry goes away with its function.
+  CompileTimeMap FunctionCompileTime;
+
 protected:
 
   /// Collection of pass managers
@@ -465,6 +480,50 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+//===----------------------------------------------------------------------===//
+// PassTraceRegion
+//
+/// PassTraceRegion - Records one run of a pass over a basic block, a function,
+/// the functions of an SCC or a module in the -pass-trace output, and charges
+/// the time of a run over a single function or one of its blocks to that
+/// function's compile-time budget.  Does nothing unless -pass-trace or
+/// -function-compile-budget-us is given.
+///
+/// The functions are held by WeakVH, because a pass over an SCC may delete
+/// them (argument promotion replaces the functions it changes); deleted ones
+/// are left out of what is recorded after the run.
+class PassTraceRegion {
+  Pass *P;
+  Module *M;
+  /// The block a basic block pass runs on; only its instructions are counted.
+  BasicBlock *BB;
+  SmallVector<WeakVH, 4> Functions;
+  uint64_t StartTime;
+  uint64_t InstrsBefore;
+  bool Changed;
+  bool Active;
+
+  void begin();
+  uint64_t countInstructions() const;
+
+  PassTraceRegion(const PassTraceRegion &) LLVM_DELETED_FUNCTION;
+  void operator=(const PassTraceRegion &) LLVM_DELETED_FUNCTION;
+
+public:
+  PassTraceRegion(Pass *P, Module &M);
+  PassTraceRegion(Pass *P, Function &F);
+  PassTraceRegion(Pass *P, BasicBlock &BB);
+  PassTraceRegion(Pass *P, ArrayRef<Function *> Fs);
+  ~PassTraceRegion();
+
+  /// setChanged - Record whether the run changed the IR.
+  void setChanged(bool C) { Changed = C; }
+
+  /// recordInvalidation - Note that the run of P recorded last invalidated
+  /// the analysis AP.
+  static void recordInvalidation(Pass *P, Pass *AP);
+};
+
 }
 
 #endif
@@ -116,10 +116,11 @@ public:
 
   /// getFileOrSTDIN - Open the specified file as a MemoryBuffer, or open stdin
   /// if the Filename is "-".  If an error occurs, this returns null and sets
-  /// ec.
+  /// ec.  RequiresNullTerminator only applies to files, see getFile.
   static error_code getFileOrSTDIN(StringRef Filename,
                                    OwningPtr<MemoryBuffer> &result,
-                                   int64_t FileSize = -1);
+                                   int64_t FileSize = -1,
+                                   bool RequiresNullTerminator = true);
 
   //===--------------------------------------------------------------------===//
   // Provided for performance analysis.
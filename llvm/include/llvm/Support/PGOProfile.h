@@ -0,0 +1,104 @@
+//===-- llvm/Support/PGOProfile.h - Instrumented profile data ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This header provides the interface to read and write the counter profiles
+// that -pgo-instr-gen programs write at exit, and that -pgo-instr-use reads
+// back.
+//
+// A profile is the 8 byte magic "\xffpgodat" followed by ULEB128 numbers: the
+// format version, the number of functions and, for each function, the length
+// of its name, the name itself, the hash of its CFG, the number of counters
+// and the counters.  The same layout is written by the runtime in
+// compiler-rt/lib/profile/PGOProfiling.c.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_PGOPROFILE_H
+#define LLVM_SUPPORT_PGOPROFILE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class MemoryBuffer;
+class raw_ostream;
+
+namespace PGOProfile {
+  /// Magic - The first eight bytes of every profile.
+  extern const char Magic[8];
+
+  /// Version - The format version this reader and writer understand.
+  const uint64_t Version = 1;
+} // end PGOProfile namespace
+
+/// PGOFunctionProfile - The counters recorded for one function.
+struct PGOFunctionProfile {
+  /// Hash - The hash of the CFG the counters were laid out for.  The reader
+  /// ignores a profile whose hash no longer matches the function.
+  uint64_t Hash;
+
+  /// Counts - The counter values, in the order the instrumentation laid them
+  /// out.
+  std::vector<uint64_t> Counts;
+
+  PGOFunctionProfile() : Hash(0) {}
+};
+
+/// PGOProfileReader - Parses a profile into a table of functions.
+class PGOProfileReader {
+  StringMap<PGOFunctionProfile> Functions;
+  uint64_t MaxCount;
+
+  PGOProfileReader() : MaxCount(0) {}
+  bool parse(StringRef Data, std::string &Error);
+
+public:
+  /// create - Parse the profile held in Buffer.  Return null and set Error if
+  /// it is not a well formed profile.
+  static PGOProfileReader *create(const MemoryBuffer *Buffer,
+                                  std::string &Error);
+
+  /// create - Read and parse the profile in the file Path.
+  static PGOProfileReader *create(StringRef Path, std::string &Error);
+
+  /// getFunction - Return the profile of the function with the given name,
+  /// or null if the profile has none.
+  const PGOFunctionProfile *getFunction(StringRef Name) const;
+
+  /// getMaximumCount - Return the largest counter in the profile.
+  uint64_t getMaximumCount() const { return MaxCount; }
+
+  /// getNumFunctions - Return the number of functions in the profile.
+  unsigned getNumFunctions() const { return Functions.size(); }
+};
+
+/// PGOProfileWriter - Collects function profiles and writes them out in the
+/// format the reader parses.  Adding a function that is already present with
+/// the same hash and number of counters adds the counts together.
+class PGOProfileWriter {
+  StringMap<PGOFunctionProfile> Functions;
+
+public:
+  /// addFunction - Add the counters of a function.  Return false if the
+  /// function is already present with a different hash or counter layout.
+  bool addFunction(StringRef Name, uint64_t Hash, ArrayRef<uint64_t> Counts);
+
+  /// write - Write the profile to OS.  Functions are written in name order so
+  /// that the output does not depend on the order they were added in.
+  void write(raw_ostream &OS) const;
+};
+
+} // end llvm namespace
+
+#endif
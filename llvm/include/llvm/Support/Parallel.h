@@ -0,0 +1,233 @@
+//===-- llvm/Support/Parallel.h - Parallel algorithms -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines parallel versions of common algorithms that run on a
+// ThreadPool: parallel_for_each, parallel_sort and parallel_transform_reduce.
+//
+// The range is cut into chunks of consecutive elements, and every chunk is
+// processed by one task.  The algorithms return when all of their tasks have
+// finished, and they may be used from inside tasks of the same pool.  The
+// results do not depend on the number of threads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_PARALLEL_H
+#define LLVM_SUPPORT_PARALLEL_H
+
+#include "llvm/Support/ThreadPool.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+namespace llvm {
+
+namespace parallel_detail {
+
+/// The number of chunks a range is cut into.  This is independent of the
+/// number of threads, so that the results are too, and large enough to
+/// balance the load of any realistic number of threads.
+enum { MaxNumChunks = 256 };
+
+/// getChunkSize - Return the number of elements processed by each task for a
+/// range of \p Len elements.
+inline size_t getChunkSize(size_t Len) {
+  return (Len + MaxNumChunks - 1) / MaxNumChunks;
+}
+
+template <class RandomIt, class Function>
+struct ForEachTask {
+  RandomIt Begin, End;
+  Function *Fn;
+
+  static void run(void *Arg) {
+    ForEachTask &T = *static_cast<ForEachTask *>(Arg);
+    for (RandomIt I = T.Begin; I != T.End; ++I)
+      (*T.Fn)(*I);
+  }
+};
+
+/// The number of elements below which parallel_sort uses std::sort.
+enum { MinParallelSortSize = 1024 };
+
+/// LessThanPivot - Compare elements against a pivot element that is not part
+/// of the partitioned range.
+template <class RandomIt, class Compare>
+struct LessThanPivot {
+  RandomIt Pivot;
+  Compare *Comp;
+
+  LessThanPivot(RandomIt Pivot, Compare *Comp) : Pivot(Pivot), Comp(Comp) {}
+  bool operator()(
+      const typename std::iterator_traits<RandomIt>::value_type &V) const {
+    return (*Comp)(V, *Pivot);
+  }
+};
+
+template <class RandomIt, class Compare>
+struct SortTask {
+  TaskGroup *Group;
+  RandomIt Begin, End;
+  Compare *Comp;
+  unsigned Depth;
+
+  static void run(void *Arg);
+};
+
+/// parallelQuickSort - Sort [Begin, End) by partitioning it around a pivot,
+/// sorting the lower part in a new task and the upper part on this thread.
+/// Past \p Depth levels of recursion, which only happens for pathological
+/// inputs, and for small ranges, std::sort takes over.
+template <class RandomIt, class Compare>
+void parallelQuickSort(TaskGroup &Group, RandomIt Begin, RandomIt End,
+                       Compare *Comp, unsigned Depth) {
+  while (End - Begin > MinParallelSortSize && Depth != 0) {
+    --Depth;
+
+    // Move the median of the first, middle and last elements to the end, and
+    // partition the rest around it.
+    RandomIt Last = End - 1;
+    RandomIt Mid = Begin + (End - Begin) / 2;
+    if ((*Comp)(*Mid, *Begin))
+      std::iter_swap(Mid, Begin);
+    if ((*Comp)(*Last, *Begin))
+      std::iter_swap(Last, Begin);
+    if ((*Comp)(*Mid, *Last))
+      std::iter_swap(Mid, Last);
+    RandomIt Split = std::partition(Begin, Last,
+                                    LessThanPivot<RandomIt, Compare>(Last,
+                                                                     Comp));
+    std::iter_swap(Split, Last);
+
+    if (Split - Begin > MinParallelSortSize) {
+      SortTask<RandomIt, Compare> *Lower = new SortTask<RandomIt, Compare>();
+      Lower->Group = &Group;
+      Lower->Begin = Begin;
+      Lower->End = Split;
+      Lower->Comp = Comp;
+      Lower->Depth = Depth;
+      Group.spawn(SortTask<RandomIt, Compare>::run, Lower);
+    } else {
+      std::sort(Begin, Split, *Comp);
+    }
+
+    Begin = Split + 1;
+  }
+  std::sort(Begin, End, *Comp);
+}
+
+template <class RandomIt, class Compare>
+void SortTask<RandomIt, Compare>::run(void *Arg) {
+  SortTask *T = static_cast<SortTask *>(Arg);
+  parallelQuickSort(*T->Group, T->Begin, T->End, T->Comp, T->Depth);
+  delete T;
+}
+
+template <class RandomIt, class T, class ReduceFn, class TransformFn>
+struct TransformReduceTask {
+  RandomIt Begin, End;
+  T Result;
+  ReduceFn *Reduce;
+  TransformFn *Transform;
+
+  TransformReduceTask(const T &Init) : Result(Init) {}
+
+  static void run(void *Arg) {
+    TransformReduceTask &Task = *static_cast<TransformReduceTask *>(Arg);
+    for (RandomIt I = Task.Begin; I != Task.End; ++I)
+      Task.Result = (*Task.Reduce)(Task.Result, (*Task.Transform)(*I));
+  }
+};
+
+} // end parallel_detail namespace
+
+/// parallel_for_each - Call \p Fn on every element of [Begin, End) on the
+/// threads of \p Pool.  The calls may happen in any order and concurrently.
+template <class RandomIt, class Function>
+void parallel_for_each(ThreadPool &Pool, RandomIt Begin, RandomIt End,
+                       Function Fn) {
+  typedef parallel_detail::ForEachTask<RandomIt, Function> TaskTy;
+  size_t Len = End - Begin;
+  if (Len == 0)
+    return;
+  size_t ChunkSize = parallel_detail::getChunkSize(Len);
+
+  std::vector<TaskTy> Tasks((Len + ChunkSize - 1) / ChunkSize);
+  TaskGroup Group(Pool);
+  for (size_t I = 0, E = Tasks.size(); I != E; ++I) {
+    Tasks[I].Begin = Begin + I * ChunkSize;
+    Tasks[I].End = Begin + std::min(Len, (I + 1) * ChunkSize);
+    Tasks[I].Fn = &Fn;
+    Group.spawn(TaskTy::run, &Tasks[I]);
+  }
+  Group.wait();
+}
+
+/// parallel_sort - Sort [Begin, End) with \p Comp on the threads of \p Pool.
+/// As with std::sort, the order of equal elements is unspecified.
+template <class RandomIt, class Compare>
+void parallel_sort(ThreadPool &Pool, RandomIt Begin, RandomIt End,
+                   Compare Comp) {
+  // Limit the recursion like introsort does.
+  unsigned Depth = 0;
+  for (size_t Len = End - Begin; Len > 1; Len >>= 1)
+    Depth += 2;
+
+  TaskGroup Group(Pool);
+  parallel_detail::parallelQuickSort(Group, Begin, End, &Comp, Depth);
+  Group.wait();
+}
+
+/// parallel_sort - Sort [Begin, End) with operator< on the threads of \p Pool.
+template <class RandomIt>
+void parallel_sort(ThreadPool &Pool, RandomIt Begin, RandomIt End) {
+  typedef typename std::iterator_traits<RandomIt>::value_type ValueTy;
+  parallel_sort(Pool, Begin, End, std::less<ValueTy>());
+}
+
+/// parallel_transform_reduce - Return the reduction with \p Reduce of \p Init
+/// and of \p Transform applied to every element of [Begin, End), computed on
+/// the threads of \p Pool.
+///
+/// Every chunk of the range is reduced separately, starting from \p Init, and
+/// the results of the chunks are then reduced in order.  So \p Reduce must be
+/// associative, and \p Init must be an identity of \p Reduce.  \p Transform may
+/// be called concurrently.
+template <class RandomIt, class T, class ReduceFn, class TransformFn>
+T parallel_transform_reduce(ThreadPool &Pool, RandomIt Begin, RandomIt End,
+                            T Init, ReduceFn Reduce, TransformFn Transform) {
+  typedef parallel_detail::TransformReduceTask<RandomIt, T, ReduceFn,
+                                               TransformFn> TaskTy;
+  size_t Len = End - Begin;
+  if (Len == 0)
+    return Init;
+  size_t ChunkSize = parallel_detail::getChunkSize(Len);
+
+  std::vector<TaskTy> Tasks((Len + ChunkSize - 1) / ChunkSize, TaskTy(Init));
+  {
+    TaskGroup Group(Pool);
+    for (size_t I = 0, E = Tasks.size(); I != E; ++I) {
+      Tasks[I].Begin = Begin + I * ChunkSize;
+      Tasks[I].End = Begin + std::min(Len, (I + 1) * ChunkSize);
+      Tasks[I].Reduce = &Reduce;
+      Tasks[I].Transform = &Transform;
+      Group.spawn(TaskTy::run, &Tasks[I]);
+    }
+    Group.wait();
+  }
+
+  T Result = Init;
+  for (size_t I = 0, E = Tasks.size(); I != E; ++I)
+    Result = Reduce(Result, Tasks[I].Result);
+  return Result;
+}
+
+} // End llvm namespace
+
+#endif
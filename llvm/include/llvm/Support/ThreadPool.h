@@ -0,0 +1,98 @@
+//===-- llvm/Support/ThreadPool.h - A pool of worker threads ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the ThreadPool and TaskGroup classes, which run tasks
+// concurrently on a fixed set of worker threads.
+//
+// Every worker owns a double-ended task queue.  A task spawned by a worker is
+// pushed onto the back of that worker's queue and workers take their own work
+// from the back, so nested tasks run depth first and stay in the cache of the
+// thread that created them.  Idle workers steal from the front of the other
+// queues, which holds the oldest and usually the largest pieces of work.
+//
+// Threads waiting for a TaskGroup run pending tasks instead of blocking, so
+// tasks may themselves spawn and wait for nested groups without exhausting the
+// workers.  A waiting thread steals only a few levels of tasks from other
+// queues, so that its stack stays bounded.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_THREADPOOL_H
+#define LLVM_SUPPORT_THREADPOOL_H
+
+#include "llvm/Support/Compiler.h"
+
+namespace llvm {
+
+class ThreadPool;
+class ThreadPoolImpl;
+
+/// TaskGroup - A set of tasks spawned on a ThreadPool that can be waited for
+/// together.  The destructor waits for the tasks that are still running.
+class TaskGroup {
+  ThreadPool &Pool;
+  /// The number of spawned tasks that have not finished yet.  Guarded by the
+  /// lock of the pool.
+  unsigned Pending;
+
+  TaskGroup(const TaskGroup &) LLVM_DELETED_FUNCTION;
+  void operator=(const TaskGroup &) LLVM_DELETED_FUNCTION;
+
+  friend class ThreadPoolImpl;
+
+public:
+  explicit TaskGroup(ThreadPool &Pool) : Pool(Pool), Pending(0) {}
+  ~TaskGroup() { wait(); }
+
+  ThreadPool &getPool() const { return Pool; }
+
+  /// spawn - Schedule Fn(Arg) to run on the pool.  This may be called from any
+  /// thread, including from the tasks of this group.
+  void spawn(void (*Fn)(void *), void *Arg);
+
+  /// wait - Return when every task spawned in this group has finished,
+  /// including the tasks they spawned in turn.  The calling thread runs
+  /// pending tasks of the pool while it waits.
+  void wait();
+};
+
+/// ThreadPool - A fixed number of worker threads running the tasks spawned in
+/// TaskGroups.  The workers are started when the pool is created and joined
+/// when it is destroyed.
+///
+/// Creating a pool puts LLVM into multithreaded mode if it is not already.
+/// Where system support for threads is unavailable, or if the pool has no
+/// worker threads, spawned tasks run immediately on the spawning thread.
+class ThreadPool {
+  ThreadPoolImpl *Impl;
+  unsigned ThreadCount;
+
+  ThreadPool(const ThreadPool &) LLVM_DELETED_FUNCTION;
+  void operator=(const ThreadPool &) LLVM_DELETED_FUNCTION;
+
+  friend class TaskGroup;
+
+public:
+  /// Create a pool of \p ThreadCount worker threads, or of one thread per
+  /// processor if \p ThreadCount is zero.  If \p StackSize is not zero, the
+  /// workers are started with stacks of that many bytes.
+  explicit ThreadPool(unsigned ThreadCount = 0, unsigned StackSize = 0);
+
+  /// Wait for all running tasks and join the worker threads.  Every TaskGroup
+  /// of the pool must have been waited for.
+  ~ThreadPool();
+
+  /// getThreadCount - Return the number of worker threads, or zero if tasks
+  /// run on the spawning thread.
+  unsigned getThreadCount() const { return ThreadCount; }
+};
+
+} // End llvm namespace
+
+#endif
@@ -54,6 +54,10 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_hardware_concurrency - Return the number of processors available
+  /// to run threads on, or 1 if it cannot be determined.
+  unsigned llvm_hardware_concurrency();
 }
 
 #endif
@@ -21,6 +21,7 @@
 
 namespace llvm {
 
+class GlobalValue;
 class InstrItineraryData;
 class LiveVariables;
 class MCAsmInfo;
@@ -989,6 +990,76 @@ public:
     return NULL;
   }
 
+  /// MachineOutlinerInstrType - How the machine outliner may treat an
+  /// instruction when it looks for repeated sequences.
+  enum MachineOutlinerInstrType {
+    MOIT_Illegal,     ///< Never part of an outlined sequence.
+    MOIT_Legal,       ///< May appear anywhere in an outlined sequence.
+    MOIT_LegalInTail, ///< Only legal in a sequence reached by a jump, because
+                      ///< it depends on the caller's stack pointer.
+    MOIT_Call,        ///< A direct call; it clobbers the return address of
+                      ///< an outlined function, so it may only end a sequence.
+    MOIT_Return,      ///< A return or tail call ending the caller.
+    MOIT_Invisible    ///< Skipped, such as a debug value: it neither ends a
+                      ///< sequence nor is copied into an outlined one.
+  };
+
+  /// MachineOutlinerKind - How an outlined sequence is reached and left.
+  enum MachineOutlinerKind {
+    MOK_Call,  ///< Called; the outlined function gets a return appended.
+    MOK_Thunk, ///< Called; the sequence ends in a call which becomes a tail
+               ///< call in the outlined function.
+    MOK_Tail   ///< Jumped to; the sequence ends in a return of its own.
+  };
+
+  /// isFunctionSafeToOutlineFrom - Return true if the machine outliner may
+  /// replace sequences in MF with calls to outlined functions.
+  virtual bool isFunctionSafeToOutlineFrom(const MachineFunction &MF) const {
+    return false;
+  }
+
+  /// getOutliningType - Classify MI for the machine outliner.
+  virtual MachineOutlinerInstrType
+  getOutliningType(const MachineInstr *MI) const {
+    return MOIT_Illegal;
+  }
+
+  /// getOutliningInstrSize - Return an estimate of the encoded size of MI in
+  /// bytes, used by the machine outliner's cost model.
+  virtual unsigned getOutliningInstrSize(const MachineInstr *MI) const {
+    return 0;
+  }
+
+  /// getOutliningCallOverhead - Return the size in bytes of the instruction
+  /// that replaces each outlined occurrence of kind K.
+  virtual unsigned getOutliningCallOverhead(MachineOutlinerKind K) const {
+    return 0;
+  }
+
+  /// getOutliningFrameOverhead - Return the size in bytes of the code that
+  /// finishOutlinedFunction adds to an outlined function of kind K.
+  virtual unsigned getOutliningFrameOverhead(MachineOutlinerKind K) const {
+    return 0;
+  }
+
+  /// insertOutlinedCall - Insert a call or jump to the outlined function
+  /// Callee before It in MBB, and return the inserted instruction.
+  virtual MachineInstr *insertOutlinedCall(MachineBasicBlock &MBB,
+                                           MachineBasicBlock::iterator It,
+                                           const GlobalValue *Callee,
+                                           MachineOutlinerKind K) const {
+    llvm_unreachable("Target didn't implement "
+                     "TargetInstrInfo::insertOutlinedCall!");
+  }
+
+  /// finishOutlinedFunction - Complete the body of an outlined function of
+  /// kind K whose instructions have been copied into MBB.
+  virtual void finishOutlinedFunction(MachineBasicBlock &MBB,
+                                      MachineOutlinerKind K) const {
+    llvm_unreachable("Target didn't implement "
+                     "TargetInstrInfo::finishOutlinedFunction!");
+  }
+
 private:
   int CallFrameSetupOpcode, CallFrameDestroyOpcode;
 };
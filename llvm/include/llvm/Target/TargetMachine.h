@@ -23,8 +23,12 @@
 
 namespace llvm {
 
+class CallLowering;
 class InstrItineraryData;
+class InstructionSelector;
 class JITCodeEmitter;
+class LegalizerInfo;
+class RegisterBankInfo;
 class GlobalValue;
 class MCAsmInfo;
 class MCCodeGenInfo;
@@ -116,6 +120,15 @@ public:
   virtual const TargetSelectionDAGInfo *getSelectionDAGInfo() const{ return 0; }
   virtual const DataLayout             *getDataLayout() const { return 0; }
 
+  /// Interfaces used by the global instruction selector. A target that does
+  /// not implement all four of them is only selected with SelectionDAG.
+  virtual const CallLowering *getCallLowering() const { return 0; }
+  virtual const LegalizerInfo *getLegalizerInfo() const { return 0; }
+  virtual const RegisterBankInfo *getRegisterBankInfo() const { return 0; }
+  virtual const InstructionSelector *getInstructionSelector() const {
+    return 0;
+  }
+
   /// getMCAsmInfo - Return target specific asm information.
   ///
   const MCAsmInfo *getMCAsmInfo() const { return AsmInfo; }
@@ -104,9 +104,78 @@ namespace TargetOpcode {
     /// support optimizations for dynamic languages (such as javascript) that
     /// rewrite calls to runtimes with more efficient code sequences.
     /// This also implies a stack map.
-    PATCHPOINT = 18
+    PATCHPOINT = 18,
+
+    /// Generic opcodes used by the global instruction selector. They operate
+    /// on generic virtual registers, which have a size in bits but no register
+    /// class until a register bank is chosen for them, and they are all
+    /// replaced by target instructions before the end of instruction
+    /// selection. The first operand is the result for those that have one.
+
+    /// Integer arithmetic: result, lhs, rhs.
+    G_ADD = 19,
+    G_SUB = 20,
+    G_MUL = 21,
+    G_SDIV = 22,
+    G_UDIV = 23,
+    G_SREM = 24,
+    G_UREM = 25,
+    G_AND = 26,
+    G_OR = 27,
+    G_XOR = 28,
+    G_SHL = 29,
+    G_LSHR = 30,
+    G_ASHR = 31,
+
+    /// Comparisons: 1-bit result, CmpInst::Predicate immediate, lhs, rhs.
+    G_ICMP = 32,
+    G_FCMP = 33,
+
+    /// Floating point arithmetic: result, lhs, rhs.
+    G_FADD = 34,
+    G_FSUB = 35,
+    G_FMUL = 36,
+    G_FDIV = 37,
+
+    /// G_SELECT - result, 1-bit condition, true value, false value.
+    G_SELECT = 38,
+
+    /// Conversions: result, source. G_ANYEXT leaves the new high bits
+    /// undefined.
+    G_ANYEXT = 39,
+    G_ZEXT = 40,
+    G_SEXT = 41,
+    G_TRUNC = 42,
+    G_SITOFP = 43,
+    G_FPTOSI = 44,
+    G_FPEXT = 45,
+    G_FPTRUNC = 46,
+
+    /// Materialized values: result, then a ConstantInt, ConstantFP, frame
+    /// index or global address operand.
+    G_CONSTANT = 47,
+    G_FCONSTANT = 48,
+    G_FRAME_INDEX = 49,
+    G_GLOBAL_VALUE = 50,
+
+    /// Memory accesses with a single memory operand. G_LOAD is result,
+    /// address; G_STORE is value, address.
+    G_LOAD = 51,
+    G_STORE = 52,
+
+    /// G_BR - unconditional branch to a basic block.
+    G_BR = 53,
+
+    /// G_BRCOND - branch to a basic block if the 1-bit condition is set.
+    G_BRCOND = 54
   };
 } // end namespace TargetOpcode
+
+/// isPreISelGenericOpcode - Return true if Opcode is one of the generic
+/// opcodes that only exist during global instruction selection.
+inline bool isPreISelGenericOpcode(unsigned Opcode) {
+  return Opcode >= TargetOpcode::G_ADD && Opcode <= TargetOpcode::G_BRCOND;
+}
 } // end namespace llvm
 
 #endif
@@ -15,6 +15,7 @@
 #ifndef LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 #define LLVM_TRANSFORMS_IPO_PASSMANAGERBUILDER_H
 
+#include <string>
 #include <vector>
 
 namespace llvm {
@@ -107,6 +108,19 @@ public:
   bool LoopVectorize;
   bool LateVectorize;
 
+  /// PGOInstrGen - Insert the counters of profile guided optimization at the
+  /// start of the per-module passes.
+  bool PGOInstrGen;
+
+  /// PGOInstrUse - If not empty, the profile to annotate the IR with at the
+  /// start of the per-module passes, written by a program built with
+  /// PGOInstrGen from the same input.
+  std::string PGOInstrUse;
+
+  /// PGOSampleUse - If not empty, the sampled profile to derive branch
+  /// weights from, by the line numbers of the debug info.
+  std::string PGOSampleUse;
+
 private:
   /// ExtensionList - This is list of all of the extensions that are registered.
   std::vector<std::pair<ExtensionPointTy, ExtensionFn> > Extensions;
@@ -123,6 +137,7 @@ public:
 private:
   void addExtensionsToPM(ExtensionPointTy ETy, PassManagerBase &PM) const;
   void addInitialAliasAnalysisPasses(PassManagerBase &PM) const;
+  void addPGOPasses(PassManagerBase &MPM) const;
 public:
 
   /// populateFunctionPassManager - This fills in the function pass manager,
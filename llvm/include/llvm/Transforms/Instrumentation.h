@@ -63,6 +63,12 @@ struct GCOVOptions {
 ModulePass *createGCOVProfilerPass(const GCOVOptions &Options =
                                    GCOVOptions::getDefault());
 
+// Insert the counters of profile guided optimization, and annotate the IR
+// with the profile that running the instrumented program wrote.  Without a
+// file name, -pgo-instr-use reads the file given by -pgo-profile-file.
+ModulePass *createPGOInstrumentationGenPass();
+ModulePass *createPGOInstrumentationUsePass(StringRef Filename = StringRef());
+
 // Insert AddressSanitizer (address sanity checking) instrumentation
 FunctionPass *createAddressSanitizerFunctionPass(
     bool CheckInitOrder = true, bool CheckUseAfterReturn = false,
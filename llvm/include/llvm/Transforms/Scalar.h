@@ -15,6 +15,8 @@
 #ifndef LLVM_TRANSFORMS_SCALAR_H
 #define LLVM_TRANSFORMS_SCALAR_H
 
+#include "llvm/ADT/StringRef.h"
+
 namespace llvm {
 
 class FunctionPass;
@@ -354,6 +356,14 @@ FunctionPass *createLowerExpectIntrinsicPass();
 //
 FunctionPass *createPartiallyInlineLibCallsPass();
 
+//===----------------------------------------------------------------------===//
+//
+// SampleProfilePass - Loads a sampled profile, text or binary, and sets the
+// branch weights and call counts it implies.  The file given here, if any,
+// overrides -sample-profile-file.
+//
+FunctionPass *createSampleProfileLoaderPass(StringRef Name = StringRef());
+
 } // End llvm namespace
 
 #endif
@@ -0,0 +1,57 @@
+//===- SplitModule.h - Split a module into partitions -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. It can be used to implement parallel code
+// generation for link-time optimization.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+#define LLVM_TRANSFORMS_UTILS_SPLITMODULE_H
+
+namespace llvm {
+
+class Module;
+
+/// SplitModule - Split the module \p M into \p N linkable partitions, and
+/// call \p ModuleCallback for each of them in order, passing the partition,
+/// its index and \p Context. The callback takes ownership of the partition.
+/// Partitions are created one at a time, so at most one of them is alive
+/// unless the callback keeps them around.
+///
+/// Every global definition in \p M ends up in exactly one partition; the other
+/// partitions refer to it through an external declaration. Globals that have
+/// to stay together (an alias and its aliasee, a function and the globals
+/// that take the address of its blocks) are always placed in the same
+/// partition. Local symbols referenced from more than one partition are
+/// promoted to hidden external symbols in \p M before it is split, so linking
+/// the code generated for all partitions is equivalent to linking the code
+/// generated for \p M.
+///
+/// By default, each group of globals is assigned to a partition by hashing
+/// its name, so the partition of a global does not depend on the rest of the
+/// module. If \p PreserveLocality is true, globals are instead grouped with
+/// the globals referring to them (such as a local function and its callers,
+/// or a function and its only caller) as long as the groups stay smaller than
+/// an even share of the module, and the groups are then spread over the
+/// partitions to balance their sizes. This reduces the number of promoted
+/// symbols and keeps call chains together.
+///
+/// Either way, the assignment of globals to partitions only depends on the
+/// contents of \p M, so splitting the same module twice yields the same
+/// partitions.
+void SplitModule(Module *M, unsigned N,
+                 void (*ModuleCallback)(Module *Part, unsigned Index,
+                                        void *Context),
+                 void *Context, bool PreserveLocality = false);
+
+} // End llvm namespace
+
+#endif
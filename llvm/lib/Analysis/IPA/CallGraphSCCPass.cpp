@@ -120,8 +120,15 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
     }
 
     {
+      SmallVector<Function *, 4> Functions;
+      for (CallGraphSCC::iterator I = CurSCC.begin(), E = CurSCC.end();
+           I != E; ++I)
+        Functions.push_back((*I)->getFunction());
+
       TimeRegion PassTimer(getPassTimer(CGSP));
+      PassTraceRegion Trace(CGSP, Functions);
       Changed = CGSP->runOnSCC(CurSCC);
+      Trace.setChanged(Changed);
     }
     
     // After the CGSCCPass is done, when assertions are enabled, use
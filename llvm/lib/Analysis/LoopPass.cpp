@@ -228,8 +228,11 @@ bool LPPassManager::runOnFunction(Function &F) {
       {
         PassManagerPrettyStackEntry X(P, *CurrentLoop->getHeader());
         TimeRegion PassTimer(getPassTimer(P));
+        PassTraceRegion Trace(P, F);
 
-        Changed |= P->runOnLoop(CurrentLoop, *this);
+        bool LocalChanged = P->runOnLoop(CurrentLoop, *this);
+        Trace.setChanged(LocalChanged);
+        Changed |= LocalChanged;
       }
 
       if (Changed)
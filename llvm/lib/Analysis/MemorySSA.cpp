@@ -0,0 +1,611 @@
+//===- MemorySSA.cpp - SSA form of memory ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements MemorySSA, the pass that builds it for its clients,
+// and the pass that prints it.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "memoryssa"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/Passes.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Assembly/AssemblyAnnotationWriter.h"
+#include "llvm/Assembly/Writer.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CallSite.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/raw_ostream.h"
+using namespace llvm;
+
+STATISTIC(NumDefs, "Number of MemoryDefs built");
+STATISTIC(NumUses, "Number of MemoryUses built");
+STATISTIC(NumPhis, "Number of MemoryPhis built");
+STATISTIC(NumClobberWalks, "Number of clobber walks");
+STATISTIC(NumClobberWalkSteps, "Number of definitions looked at by the walks");
+STATISTIC(NumClobberWalkLimit, "Number of walks stopped by the limit");
+
+static cl::opt<unsigned>
+WalkLimit("memssa-walk-limit", cl::Hidden, cl::init(100),
+          cl::desc("The number of definitions a MemorySSA clobber walk "
+                   "looks at before giving up (default = 100)"));
+
+//===----------------------------------------------------------------------===//
+//                          MemoryAccess Implementation
+//===----------------------------------------------------------------------===//
+
+/// printAccessName - Print the name a MemoryAccess is referred to by.
+static void printAccessName(raw_ostream &OS, const MemoryAccess *MA) {
+  const MemoryUseOrDef *UseOrDef = dyn_cast<MemoryUseOrDef>(MA);
+  if (UseOrDef && !UseOrDef->getMemoryInst())
+    OS << "liveOnEntry";
+  else
+    OS << MA->getID();
+}
+
+void MemoryAccess::print(raw_ostream &OS) const {
+  if (const MemoryPhi *Phi = dyn_cast<MemoryPhi>(this)) {
+    OS << getID() << " = MemoryPhi(";
+    for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I) {
+      if (I)
+        OS << ',';
+      OS << '{';
+      WriteAsOperand(OS, Phi->getIncomingBlock(I), false);
+      OS << ',';
+      printAccessName(OS, Phi->getIncomingValue(I));
+      OS << '}';
+    }
+    OS << ')';
+    return;
+  }
+
+  const MemoryUseOrDef *UseOrDef = cast<MemoryUseOrDef>(this);
+  if (isa<MemoryDef>(this))
+    OS << getID() << " = MemoryDef(";
+  else
+    OS << "MemoryUse(";
+  if (MemoryAccess *Defining = UseOrDef->getDefiningAccess())
+    printAccessName(OS, Defining);
+  OS << ')';
+}
+
+void MemoryAccess::dump() const {
+  print(dbgs());
+  dbgs() << '\n';
+}
+
+//===----------------------------------------------------------------------===//
+//                           MemorySSA Implementation
+//===----------------------------------------------------------------------===//
+
+MemorySSA::MemorySSA(Function &Func, AliasAnalysis &A, DominatorTree &D)
+  : F(Func), AA(&A), DT(&D), LiveOnEntryDef(0) {
+  buildMemorySSA();
+}
+
+MemorySSA::~MemorySSA() {
+  // The accesses live in Allocator, so they are only destroyed here.
+  for (DenseMap<const BasicBlock *, AccessListType *>::iterator
+       I = BlockToAccesses.begin(), E = BlockToAccesses.end(); I != E; ++I) {
+    for (AccessListType::iterator AI = I->second->begin(),
+         AE = I->second->end(); AI != AE; ++AI)
+      (*AI)->~MemoryUseOrDef();
+    delete I->second;
+  }
+  for (DenseMap<const BasicBlock *, MemoryPhi *>::iterator
+       I = BlockToPhi.begin(), E = BlockToPhi.end(); I != E; ++I)
+    I->second->~MemoryPhi();
+  LiveOnEntryDef->~MemoryDef();
+}
+
+/// setDefiningAccess - Make Defining the defining access of MA.
+void MemorySSA::setDefiningAccess(MemoryUseOrDef *MA, MemoryAccess *Defining) {
+  if (MA->DefiningAccess)
+    MA->DefiningAccess->Users.erase(MA);
+  MA->DefiningAccess = Defining;
+  Defining->Users.insert(MA);
+}
+
+void MemorySSA::buildMemorySSA() {
+  BasicBlock &Entry = F.getEntryBlock();
+  LiveOnEntryDef = new (Allocator) MemoryDef(0, &Entry);
+
+  // Make the accesses of the instructions, and note the blocks that define
+  // memory.
+  SmallPtrSet<BasicBlock *, 32> DefiningBlocks;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (!DT->isReachableFromEntry(BB))
+      continue;
+    AccessListType *Accesses = 0;
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      bool IsDef;
+      if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+        IsDef = !LI->isUnordered();
+      } else if (CallSite CS = CallSite(&*I)) {
+        // Ask the alias analysis chain once rather than once per question.
+        AliasAnalysis::ModRefBehavior MRB = AA->getModRefBehavior(CS);
+        if (MRB == AliasAnalysis::DoesNotAccessMemory)
+          continue;
+        IsDef = !AliasAnalysis::onlyReadsMemory(MRB);
+      } else if (I->mayWriteToMemory()) {
+        IsDef = true;
+      } else if (I->mayReadFromMemory()) {
+        IsDef = false;
+      } else {
+        continue;
+      }
+
+      MemoryUseOrDef *MA;
+      if (IsDef) {
+        MA = new (Allocator) MemoryDef(I, BB);
+        DefiningBlocks.insert(BB);
+        ++NumDefs;
+      } else {
+        MA = new (Allocator) MemoryUse(I, BB);
+        ++NumUses;
+      }
+      if (!Accesses)
+        Accesses = BlockToAccesses[BB] = new AccessListType();
+      MA->Position = Accesses->insert(Accesses->end(), MA);
+      InstructionToAccess[I] = MA;
+    }
+  }
+
+  placePHINodes(DefiningBlocks);
+  renamePass();
+
+  // Number the definitions and phis in the order of the function, so that
+  // the printed form does not depend on the order they were made in.
+  unsigned NextID = 1;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (MemoryPhi *Phi = BlockToPhi.lookup(BB))
+      Phi->ID = NextID++;
+    if (AccessListType *Accesses = BlockToAccesses.lookup(BB))
+      for (AccessListType::iterator I = Accesses->begin(),
+           E = Accesses->end(); I != E; ++I)
+        if (isa<MemoryDef>(*I))
+          (*I)->ID = NextID++;
+  }
+}
+
+/// placePHINodes - Place MemoryPhis at the iterated dominance frontier of the
+/// blocks that define memory.
+void MemorySSA::placePHINodes(
+    const SmallPtrSet<BasicBlock *, 32> &DefiningBlocks) {
+  // Compute the dominance frontiers of the reachable blocks: a join point is
+  // in the frontier of every block from one of its predecessors up to, but
+  // not including, its immediate dominator.
+  DenseMap<BasicBlock *, SmallVector<BasicBlock *, 4> > Frontiers;
+  for (Function::iterator BB = F.begin(), BE = F.end(); BB != BE; ++BB) {
+    if (!DT->isReachableFromEntry(BB))
+      continue;
+    pred_iterator PI = pred_begin(BB), PE = pred_end(BB);
+    if (PI == PE || llvm::next(PI) == PE)
+      continue;
+    DomTreeNode *IDom = DT->getNode(BB)->getIDom();
+    for (; PI != PE; ++PI) {
+      if (!DT->isReachableFromEntry(*PI))
+        continue;
+      for (DomTreeNode *Runner = DT->getNode(*PI); Runner != IDom;
+           Runner = Runner->getIDom()) {
+        SmallVectorImpl<BasicBlock *> &Frontier =
+          Frontiers[Runner->getBlock()];
+        if (!Frontier.empty() && Frontier.back() == BB)
+          break;
+        Frontier.push_back(BB);
+      }
+    }
+  }
+
+  SmallVector<BasicBlock *, 32> Worklist(DefiningBlocks.begin(),
+                                         DefiningBlocks.end());
+  while (!Worklist.empty()) {
+    BasicBlock *BB = Worklist.pop_back_val();
+    DenseMap<BasicBlock *, SmallVector<BasicBlock *, 4> >::iterator It =
+      Frontiers.find(BB);
+    if (It == Frontiers.end())
+      continue;
+    for (unsigned I = 0, E = It->second.size(); I != E; ++I) {
+      BasicBlock *Join = It->second[I];
+      MemoryPhi *&Phi = BlockToPhi[Join];
+      if (Phi)
+        continue;
+      Phi = new (Allocator) MemoryPhi(Join);
+      ++NumPhis;
+      // The phi is a definition as well.
+      Worklist.push_back(Join);
+    }
+  }
+}
+
+/// renameBlock - Link the accesses of BB to the versions that reach them,
+/// given the version that reaches the start of BB, and add the incoming
+/// values of the phis of its successors.  Return the version live out of BB.
+MemoryAccess *MemorySSA::renameBlock(BasicBlock *BB,
+                                     MemoryAccess *IncomingVal) {
+  if (MemoryPhi *Phi = BlockToPhi.lookup(BB))
+    IncomingVal = Phi;
+
+  if (AccessListType *Accesses = BlockToAccesses.lookup(BB))
+    for (AccessListType::iterator I = Accesses->begin(), E = Accesses->end();
+         I != E; ++I) {
+      setDefiningAccess(*I, IncomingVal);
+      if (isa<MemoryDef>(*I))
+        IncomingVal = *I;
+    }
+
+  for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE; ++SI)
+    if (MemoryPhi *Phi = BlockToPhi.lookup(*SI)) {
+      Phi->Incoming.push_back(std::make_pair(BB, IncomingVal));
+      IncomingVal->Users.insert(Phi);
+    }
+  return IncomingVal;
+}
+
+namespace {
+/// RenameFrame - A block of the dominator tree walk of renamePass, with the
+/// next of its children to visit and the version live out of it.
+struct RenameFrame {
+  DomTreeNode *Node;
+  DomTreeNode::iterator NextChild;
+  MemoryAccess *OutgoingVal;
+};
+}
+
+/// renamePass - Walk the dominator tree depth first, renaming each block
+/// with the version live out of its immediate dominator.
+void MemorySSA::renamePass() {
+  DomTreeNode *Root = DT->getRootNode();
+  RenameFrame RootFrame = {
+    Root, Root->begin(), renameBlock(Root->getBlock(), LiveOnEntryDef)
+  };
+  SmallVector<RenameFrame, 32> Stack;
+  Stack.push_back(RootFrame);
+  while (!Stack.empty()) {
+    RenameFrame &Top = Stack.back();
+    if (Top.NextChild == Top.Node->end()) {
+      Stack.pop_back();
+      continue;
+    }
+    DomTreeNode *Child = *Top.NextChild++;
+    RenameFrame ChildFrame = {
+      Child, Child->begin(), renameBlock(Child->getBlock(), Top.OutgoingVal)
+    };
+    Stack.push_back(ChildFrame);
+  }
+}
+
+MemoryAccess *MemorySSA::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MA = getMemoryAccess(I);
+  if (!MA)
+    return 0;
+
+  DenseMap<const MemoryAccess *, MemoryAccess *>::iterator It =
+    CachedClobbers.find(MA);
+  if (It != CachedClobbers.end())
+    return It->second;
+
+  MemoryAccess *Clobber = MA->getDefiningAccess();
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I))
+    Clobber = getClobberingMemoryAccess(Clobber, AA->getLocation(LI));
+  CachedClobbers[MA] = Clobber;
+  return Clobber;
+}
+
+MemoryAccess *
+MemorySSA::getClobberingMemoryAccess(MemoryAccess *Start,
+                                     const AliasAnalysis::Location &Loc) {
+  ++NumClobberWalks;
+  SmallVector<MemoryAccess *, 16> Walked;
+  MemoryAccess *MA = Start;
+  MemoryAccess *Clobber;
+  for (unsigned Steps = 0; ; ++Steps) {
+    MemoryDef *Def = dyn_cast<MemoryDef>(MA);
+    if (!Def || isLiveOnEntryDef(Def)) {
+      Clobber = MA;
+      break;
+    }
+    DenseMap<WalkKey, CachedWalk>::iterator It =
+      CachedWalks.find(WalkKey(Def, Loc));
+    if (It != CachedWalks.end() && It->second.Ptr == Loc.Ptr) {
+      Clobber = It->second.Clobber;
+      break;
+    }
+    Walked.push_back(Def);
+    if (Steps == WalkLimit) {
+      ++NumClobberWalkLimit;
+      Clobber = Def;
+      break;
+    }
+    ++NumClobberWalkSteps;
+    Instruction *I = Def->getMemoryInst();
+
+    // Like memdep, take an allocation to write only the object it returns.
+    const TargetLibraryInfo *TLI = AA->getTargetLibraryInfo();
+    if (isMallocLikeFn(I, TLI) || isCallocLikeFn(I, TLI)) {
+      const Value *Obj = GetUnderlyingObject(Loc.Ptr, AA->getDataLayout());
+      if (Obj == I || AA->alias(I, Obj) != AliasAnalysis::NoAlias) {
+        Clobber = Def;
+        break;
+      }
+      MA = Def->getDefiningAccess();
+      continue;
+    }
+
+    AliasAnalysis::ModRefResult MR = AA->getModRefInfo(I, Loc);
+    // A call the object has not escaped to yet cannot write it.
+    if (MR == AliasAnalysis::ModRef)
+      MR = AA->callCapturesBefore(I, Loc, DT);
+    if (MR & AliasAnalysis::Mod) {
+      Clobber = Def;
+      break;
+    }
+    MA = Def->getDefiningAccess();
+  }
+
+  for (unsigned I = 0, E = Walked.size(); I != E; ++I) {
+    CachedWalk &Entry = CachedWalks[WalkKey(Walked[I], Loc)];
+    Entry.Clobber = Clobber;
+    Entry.Ptr = const_cast<Value *>(Loc.Ptr);
+  }
+  return Clobber;
+}
+
+/// getDefiningAccessAtEntry - Return the version of memory that reaches the
+/// start of BB: its phi, or else the version live out of the nearest
+/// dominator that defines memory.
+MemoryAccess *MemorySSA::getDefiningAccessAtEntry(BasicBlock *BB) const {
+  if (MemoryPhi *Phi = BlockToPhi.lookup(BB))
+    return Phi;
+  for (DomTreeNode *N = DT->getNode(BB)->getIDom(); N; N = N->getIDom()) {
+    BasicBlock *Dom = N->getBlock();
+    if (AccessListType *Accesses = BlockToAccesses.lookup(Dom))
+      for (AccessListType::reverse_iterator I = Accesses->rbegin(),
+           E = Accesses->rend(); I != E; ++I)
+        if (isa<MemoryDef>(*I))
+          return *I;
+    if (MemoryPhi *Phi = BlockToPhi.lookup(Dom))
+      return Phi;
+  }
+  return LiveOnEntryDef;
+}
+
+MemoryUse *MemorySSA::createMemoryUse(Instruction *I) {
+  assert(!getMemoryAccess(I) && "Instruction already has an access!");
+  assert(!I->mayWriteToMemory() && "Instruction defines memory!");
+  BasicBlock *BB = I->getParent();
+  AccessListType *&Accesses = BlockToAccesses[BB];
+  if (!Accesses)
+    Accesses = new AccessListType();
+
+  // The new access goes after the nearest access above I in its block, and
+  // uses the same version of memory as it.
+  MemoryAccess *Defining = 0;
+  AccessListType::iterator InsertPt = Accesses->begin();
+  for (BasicBlock::iterator It = I; It != BB->begin(); ) {
+    MemoryUseOrDef *Prev = getMemoryAccess(--It);
+    if (!Prev)
+      continue;
+    InsertPt = llvm::next(Prev->Position);
+    Defining = isa<MemoryDef>(Prev) ? Prev : Prev->getDefiningAccess();
+    break;
+  }
+  if (!Defining)
+    Defining = getDefiningAccessAtEntry(BB);
+
+  MemoryUse *MU = new (Allocator) MemoryUse(I, BB);
+  MU->Position = Accesses->insert(InsertPt, MU);
+  setDefiningAccess(MU, Defining);
+  InstructionToAccess[I] = MU;
+  return MU;
+}
+
+void MemorySSA::removeMemoryAccess(MemoryUseOrDef *MA) {
+  MemoryAccess *Defining = MA->getDefiningAccess();
+  if (isa<MemoryDef>(MA)) {
+    // Everything this definition reaches is now reached by the version it
+    // was defined from, and the walks that stopped at it are out of date.
+    while (!MA->user_empty()) {
+      MemoryAccess *User = *MA->user_begin();
+      if (MemoryUseOrDef *UseOrDef = dyn_cast<MemoryUseOrDef>(User)) {
+        setDefiningAccess(UseOrDef, Defining);
+        continue;
+      }
+      MemoryPhi *Phi = cast<MemoryPhi>(User);
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+        if (Phi->Incoming[I].second == MA)
+          Phi->Incoming[I].second = Defining;
+      MA->Users.erase(Phi);
+      Defining->Users.insert(Phi);
+    }
+    CachedClobbers.clear();
+    CachedWalks.clear();
+  } else {
+    CachedClobbers.erase(MA);
+  }
+
+  Defining->Users.erase(MA);
+  AccessListType *&Accesses = BlockToAccesses[MA->getBlock()];
+  Accesses->erase(MA->Position);
+  if (Accesses->empty()) {
+    delete Accesses;
+    BlockToAccesses.erase(MA->getBlock());
+  }
+  InstructionToAccess.erase(MA->getMemoryInst());
+  MA->~MemoryUseOrDef();
+}
+
+void MemorySSA::replacePhiIncomingBlock(BasicBlock *BB, BasicBlock *OldPred,
+                                        BasicBlock *NewPred) {
+  MemoryPhi *Phi = BlockToPhi.lookup(BB);
+  if (!Phi)
+    return;
+  for (unsigned I = 0, E = Phi->getNumIncomingValues(); I != E; ++I)
+    if (Phi->Incoming[I].first == OldPred) {
+      Phi->Incoming[I].first = NewPred;
+      return;
+    }
+}
+
+void MemorySSA::mergeBlockIntoPredecessor(BasicBlock *BB, BasicBlock *Pred) {
+  assert(!BlockToPhi.count(BB) && "A block with one predecessor has no phi!");
+  for (succ_iterator SI = succ_begin(Pred), SE = succ_end(Pred); SI != SE;
+       ++SI)
+    replacePhiIncomingBlock(*SI, BB, Pred);
+
+  DenseMap<const BasicBlock *, AccessListType *>::iterator It =
+    BlockToAccesses.find(BB);
+  if (It == BlockToAccesses.end())
+    return;
+  AccessListType *Accesses = It->second;
+  BlockToAccesses.erase(It);
+  for (AccessListType::iterator I = Accesses->begin(), E = Accesses->end();
+       I != E; ++I)
+    (*I)->Block = Pred;
+
+  // Splicing keeps the positions the accesses hold valid.
+  AccessListType *&PredAccesses = BlockToAccesses[Pred];
+  if (!PredAccesses) {
+    PredAccesses = Accesses;
+    return;
+  }
+  PredAccesses->splice(PredAccesses->end(), *Accesses);
+  delete Accesses;
+}
+
+namespace {
+/// MemorySSAAnnotatedWriter - Print the accesses of a function as comments
+/// above their instructions.
+class MemorySSAAnnotatedWriter : public AssemblyAnnotationWriter {
+  const MemorySSA &MSSA;
+
+public:
+  explicit MemorySSAAnnotatedWriter(const MemorySSA &M) : MSSA(M) {}
+
+  virtual void emitBasicBlockStartAnnot(const BasicBlock *BB,
+                                        formatted_raw_ostream &OS) {
+    if (MemoryPhi *Phi = MSSA.getMemoryAccess(BB)) {
+      OS << "; ";
+      Phi->print(OS);
+      OS << '\n';
+    }
+  }
+
+  virtual void emitInstructionAnnot(const Instruction *I,
+                                    formatted_raw_ostream &OS) {
+    if (MemoryUseOrDef *MA = MSSA.getMemoryAccess(I)) {
+      OS << "; ";
+      MA->print(OS);
+      OS << '\n';
+    }
+  }
+};
+}
+
+void MemorySSA::print(raw_ostream &OS) const {
+  MemorySSAAnnotatedWriter Writer(*this);
+  F.print(OS, &Writer);
+}
+
+void MemorySSA::dump() const {
+  print(dbgs());
+}
+
+//===----------------------------------------------------------------------===//
+//                          MemorySSAAnalysis Pass
+//===----------------------------------------------------------------------===//
+
+char MemorySSAAnalysis::ID = 0;
+INITIALIZE_PASS_BEGIN(MemorySSAAnalysis, "memoryssa",
+                      "Memory SSA", false, true)
+INITIALIZE_PASS_DEPENDENCY(DominatorTree)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_PASS_END(MemorySSAAnalysis, "memoryssa",
+                    "Memory SSA", false, true)
+
+MemorySSAAnalysis::MemorySSAAnalysis() : FunctionPass(ID) {
+  initializeMemorySSAAnalysisPass(*PassRegistry::getPassRegistry());
+}
+
+bool MemorySSAAnalysis::runOnFunction(Function &F) {
+  MSSA.reset(new MemorySSA(F, getAnalysis<AliasAnalysis>(),
+                           getAnalysis<DominatorTree>()));
+  return false;
+}
+
+void MemorySSAAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequiredTransitive<AliasAnalysis>();
+  AU.addRequiredTransitive<DominatorTree>();
+  AU.setPreservesAll();
+}
+
+void MemorySSAAnalysis::releaseMemory() {
+  MSSA.reset();
+}
+
+void MemorySSAAnalysis::print(raw_ostream &OS, const Module *) const {
+  if (MSSA)
+    MSSA->print(OS);
+}
+
+//===----------------------------------------------------------------------===//
+//                          MemorySSAPrinter Pass
+//===----------------------------------------------------------------------===//
+
+namespace {
+  /// MemorySSAPrinter - Print the MemorySSA form of each function with
+  /// -analyze.
+  struct MemorySSAPrinter : public FunctionPass {
+    const MemorySSAAnalysis *MSSA;
+
+    static char ID; // Pass identification, replacement for typeid
+    MemorySSAPrinter() : FunctionPass(ID), MSSA(0) {
+      initializeMemorySSAPrinterPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnFunction(Function &F) {
+      MSSA = &getAnalysis<MemorySSAAnalysis>();
+      return false;
+    }
+
+    virtual void print(raw_ostream &OS, const Module *M = 0) const {
+      if (MSSA)
+        MSSA->print(OS, M);
+    }
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.addRequiredTransitive<MemorySSAAnalysis>();
+      AU.setPreservesAll();
+    }
+
+    virtual void releaseMemory() {
+      MSSA = 0;
+    }
+  };
+}
+
+char MemorySSAPrinter::ID = 0;
+INITIALIZE_PASS_BEGIN(MemorySSAPrinter, "print-memoryssa",
+                      "Print MemorySSA", false, true)
+INITIALIZE_PASS_DEPENDENCY(MemorySSAAnalysis)
+INITIALIZE_PASS_END(MemorySSAPrinter, "print-memoryssa",
+                    "Print MemorySSA", false, true)
+
+FunctionPass *llvm::createMemorySSAPrinterPass() {
+  return new MemorySSAPrinter();
+}
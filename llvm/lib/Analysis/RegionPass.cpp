@@ -93,7 +93,10 @@ bool RGPassManager::runOnFunction(Function &F) {
         PassManagerPrettyStackEntry X(P, *CurrentRegion->getEntry());
 
         TimeRegion PassTimer(getPassTimer(P));
-        Changed |= P->runOnRegion(CurrentRegion, *this);
+        PassTraceRegion Trace(P, F);
+        bool LocalChanged = P->runOnRegion(CurrentRegion, *this);
+        Trace.setChanged(LocalChanged);
+        Changed |= LocalChanged;
       }
 
       if (Changed)
@@ -133,6 +133,14 @@ bool TargetTransformInfo::isTypeLegal(Type *Ty) const {
   return PrevTTI->isTypeLegal(Ty);
 }
 
+bool TargetTransformInfo::isLegalMaskedLoad(Type *DataType) const {
+  return PrevTTI->isLegalMaskedLoad(DataType);
+}
+
+bool TargetTransformInfo::isLegalMaskedStore(Type *DataType) const {
+  return PrevTTI->isLegalMaskedStore(DataType);
+}
+
 unsigned TargetTransformInfo::getJumpBufAlignment() const {
   return PrevTTI->getJumpBufAlignment();
 }
@@ -208,6 +216,23 @@ unsigned TargetTransformInfo::getMemoryOpCost(unsigned Opcode, Type *Src,
   ;
 }
 
+unsigned
+TargetTransformInfo::getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                                unsigned Factor,
+                                                ArrayRef<unsigned> Indices,
+                                                unsigned Alignment,
+                                                unsigned AddressSpace) const {
+  return PrevTTI->getInterleavedMemoryOpCost(Opcode, VecTy, Factor, Indices,
+                                             Alignment, AddressSpace);
+}
+
+unsigned
+TargetTransformInfo::getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                           unsigned Alignment,
+                                           unsigned AddressSpace) const {
+  return PrevTTI->getMaskedMemoryOpCost(Opcode, Src, Alignment, AddressSpace);
+}
+
 unsigned
 TargetTransformInfo::getIntrinsicInstrCost(Intrinsic::ID ID,
                                            Type *RetTy,
@@ -513,6 +538,14 @@ struct NoTTI : ImmutablePass, TargetTransformInfo {
     return false;
   }
 
+  bool isLegalMaskedLoad(Type *DataType) const {
+    return false;
+  }
+
+  bool isLegalMaskedStore(Type *DataType) const {
+    return false;
+  }
+
   unsigned getJumpBufAlignment() const {
     return 0;
   }
@@ -584,6 +617,20 @@ struct NoTTI : ImmutablePass, TargetTransformInfo {
     return 1;
   }
 
+  unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                      unsigned Factor,
+                                      ArrayRef<unsigned> Indices,
+                                      unsigned Alignment,
+                                      unsigned AddressSpace) const {
+    return 1;
+  }
+
+  unsigned getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                 unsigned Alignment,
+                                 unsigned AddressSpace) const {
+    return 1;
+  }
+
   unsigned getIntrinsicInstrCost(Intrinsic::ID ID,
                                  Type *RetTy,
                                  ArrayRef<Type*> Tys) const {
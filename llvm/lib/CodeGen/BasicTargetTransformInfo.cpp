@@ -109,6 +109,14 @@ public:
   virtual unsigned getMemoryOpCost(unsigned Opcode, Type *Src,
                                    unsigned Alignment,
                                    unsigned AddressSpace) const;
+  virtual unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const;
+  virtual unsigned getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                         unsigned Alignment,
+                                         unsigned AddressSpace) const;
   virtual unsigned getIntrinsicInstrCost(Intrinsic::ID, Type *RetTy,
                                          ArrayRef<Type*> Tys) const;
   virtual unsigned getNumberOfParts(Type *Tp) const;
@@ -422,6 +430,64 @@ unsigned BasicTTI::getMemoryOpCost(unsigned Opcode, Type *Src,
   return LT.first;
 }
 
+unsigned BasicTTI::getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const {
+  VectorType *VT = cast<VectorType>(VecTy);
+  unsigned NumElts = VT->getNumElements();
+  assert(Factor > 1 && NumElts % Factor == 0 && "Invalid interleave factor");
+  unsigned NumSubElts = NumElts / Factor;
+  VectorType *SubVT = VectorType::get(VT->getElementType(), NumSubElts);
+
+  unsigned Cost = TopTTI->getMemoryOpCost(Opcode, VecTy, Alignment,
+                                          AddressSpace);
+
+  // Without better information, assume that the fields are moved one
+  // element at a time.
+  if (Opcode == Instruction::Load) {
+    for (unsigned i = 0, e = Indices.size(); i != e; ++i)
+      for (unsigned j = 0; j != NumSubElts; ++j) {
+        Cost += TopTTI->getVectorInstrCost(Instruction::ExtractElement, VT,
+                                           Indices[i] + j * Factor);
+        Cost += TopTTI->getVectorInstrCost(Instruction::InsertElement, SubVT,
+                                           j);
+      }
+    return Cost;
+  }
+
+  assert(Opcode == Instruction::Store && "Invalid Opcode");
+  for (unsigned i = 0; i != NumElts; ++i) {
+    Cost += TopTTI->getVectorInstrCost(Instruction::ExtractElement, SubVT,
+                                       i / Factor);
+    Cost += TopTTI->getVectorInstrCost(Instruction::InsertElement, VT, i);
+  }
+  return Cost;
+}
+
+unsigned BasicTTI::getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                         unsigned Alignment,
+                                         unsigned AddressSpace) const {
+  // Without native support, CodeGenPrepare expands the operation into a
+  // conditional scalar access per element: test the mask bit, branch, and
+  // move the element between the vector and memory.
+  VectorType *VT = cast<VectorType>(Src);
+  Type *EltTy = VT->getElementType();
+  VectorType *MaskTy =
+    VectorType::get(Type::getInt1Ty(Src->getContext()), VT->getNumElements());
+  unsigned Cost = 0;
+  for (unsigned i = 0, e = VT->getNumElements(); i != e; ++i) {
+    Cost += TopTTI->getVectorInstrCost(Instruction::ExtractElement, MaskTy, i);
+    Cost += TopTTI->getCFInstrCost(Instruction::Br);
+    Cost += TopTTI->getVectorInstrCost(Opcode == Instruction::Load ?
+                                       Instruction::InsertElement :
+                                       Instruction::ExtractElement, VT, i);
+    Cost += TopTTI->getMemoryOpCost(Opcode, EltTy, Alignment, AddressSpace);
+  }
+  return Cost;
+}
+
 unsigned BasicTTI::getIntrinsicInstrCost(Intrinsic::ID IID, Type *RetTy,
                                          ArrayRef<Type *> Tys) const {
   unsigned ISD = 0;
@@ -0,0 +1,28 @@
+//===-- GlobalISel.cpp - Global instruction selector initialization -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the common initialization routines for the
+// GlobalISel library.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/PassRegistry.h"
+
+using namespace llvm;
+
+/// initializeGlobalISel - Initialize all passes linked into the GlobalISel
+/// library.
+void llvm::initializeGlobalISel(PassRegistry &Registry) {
+  initializeIRTranslatorPass(Registry);
+  initializeInstructionSelectPass(Registry);
+  initializeLegalizerPass(Registry);
+  initializeRegBankSelectPass(Registry);
+}
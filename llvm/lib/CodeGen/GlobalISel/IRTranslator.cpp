@@ -0,0 +1,672 @@
+//===-- IRTranslator.cpp - Translate LLVM IR into generic MachineInstrs ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the first pass of the global instruction selector. It
+// creates one MachineBasicBlock per IR basic block and translates every
+// instruction into generic MachineInstrs on generic virtual registers, using
+// the target's CallLowering for arguments, returns and calls.
+//
+// Before emitting anything, the whole function is checked against what the
+// translator and the target's LegalizerInfo can handle. If anything is
+// missing, the MachineFunction is left empty so that SelectionDAG selects the
+// function instead.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "irtranslator"
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+#include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineMemOperand.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/GetElementPtrTypeIterator.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetSubtargetInfo.h"
+using namespace llvm;
+
+STATISTIC(NumFunctionsTranslated, "Number of functions translated");
+STATISTIC(NumFallbacks, "Number of functions left to SelectionDAG");
+
+static cl::opt<bool>
+AbortOnFallback("global-isel-abort", cl::Hidden,
+                cl::desc("Abort instead of falling back to SelectionDAG when "
+                         "the global instruction selector cannot handle a "
+                         "function"));
+
+CallLowering::~CallLowering() {}
+
+namespace {
+class IRTranslator : public MachineFunctionPass {
+  MachineFunction *MF;
+  MachineRegisterInfo *MRI;
+  const TargetInstrInfo *TII;
+  const DataLayout *TD;
+  const CallLowering *CLI;
+  const LegalizerInfo *LI;
+
+  /// ValueToVReg - The generic virtual register holding each argument and
+  /// instruction result. Constants, globals and static allocas have no entry;
+  /// they are materialized again at each use.
+  DenseMap<const Value *, unsigned> ValueToVReg;
+
+  /// BBToMBB - The MachineBasicBlock created for each IR basic block.
+  DenseMap<const BasicBlock *, MachineBasicBlock *> BBToMBB;
+
+  /// StaticAllocas - The frame index of each fixed-size entry block alloca.
+  DenseMap<const AllocaInst *, int> StaticAllocas;
+
+  /// PendingPHIs - PHIs whose operands are added once every block has been
+  /// translated.
+  SmallVector<std::pair<const PHINode *, MachineInstr *>, 8> PendingPHIs;
+
+  /// CurMBB - The block new instructions are appended to.
+  MachineBasicBlock *CurMBB;
+  DebugLoc CurDL;
+
+public:
+  static char ID;
+  IRTranslator() : MachineFunctionPass(ID) {
+    initializeIRTranslatorPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual const char *getPassName() const { return "IRTranslator"; }
+  virtual bool runOnMachineFunction(MachineFunction &MF);
+
+private:
+  unsigned getTypeSize(Type *Ty) const;
+  bool isMaterializable(const Value *V) const;
+  bool isSupportedOperand(const Value *V) const;
+  bool isSupported(const Instruction &I) const;
+  const Instruction *findUnsupported(const Function &F) const;
+
+  MachineInstrBuilder buildInstr(unsigned Opcode) {
+    return BuildMI(*CurMBB, CurMBB->end(), CurDL, TII->get(Opcode));
+  }
+  MachineInstrBuilder buildInstr(unsigned Opcode, unsigned Res) {
+    return BuildMI(*CurMBB, CurMBB->end(), CurDL, TII->get(Opcode), Res);
+  }
+  unsigned getOrCreateVReg(const Value *V);
+  unsigned materialize(const Value *V, MachineBasicBlock &MBB,
+                       MachineBasicBlock::iterator I);
+  void addSuccessor(const BasicBlock *BB);
+
+  void translate(const Instruction &I);
+  void translateGEP(const GetElementPtrInst &GEP);
+  void translateCast(const CastInst &CI);
+  void translateBr(const BranchInst &BI);
+  void translateLoad(const LoadInst &LI);
+  void translateStore(const StoreInst &SI);
+  void translateCall(const CallInst &CI);
+  void finishPendingPHIs();
+};
+} // end anonymous namespace
+
+char IRTranslator::ID = 0;
+INITIALIZE_PASS(IRTranslator, "irtranslator", "IRTranslator", false, false)
+
+FunctionPass *llvm::createIRTranslatorPass() { return new IRTranslator(); }
+
+/// getGenericOpcode - Return the generic opcode for a binary operator,
+/// comparison or cast, or 0 if there is none.
+static unsigned getGenericOpcode(unsigned IROpcode) {
+  switch (IROpcode) {
+  default: return 0;
+  case Instruction::Add:     return TargetOpcode::G_ADD;
+  case Instruction::Sub:     return TargetOpcode::G_SUB;
+  case Instruction::Mul:     return TargetOpcode::G_MUL;
+  case Instruction::SDiv:    return TargetOpcode::G_SDIV;
+  case Instruction::UDiv:    return TargetOpcode::G_UDIV;
+  case Instruction::SRem:    return TargetOpcode::G_SREM;
+  case Instruction::URem:    return TargetOpcode::G_UREM;
+  case Instruction::And:     return TargetOpcode::G_AND;
+  case Instruction::Or:      return TargetOpcode::G_OR;
+  case Instruction::Xor:     return TargetOpcode::G_XOR;
+  case Instruction::Shl:     return TargetOpcode::G_SHL;
+  case Instruction::LShr:    return TargetOpcode::G_LSHR;
+  case Instruction::AShr:    return TargetOpcode::G_ASHR;
+  case Instruction::FAdd:    return TargetOpcode::G_FADD;
+  case Instruction::FSub:    return TargetOpcode::G_FSUB;
+  case Instruction::FMul:    return TargetOpcode::G_FMUL;
+  case Instruction::FDiv:    return TargetOpcode::G_FDIV;
+  case Instruction::ICmp:    return TargetOpcode::G_ICMP;
+  case Instruction::FCmp:    return TargetOpcode::G_FCMP;
+  case Instruction::Select:  return TargetOpcode::G_SELECT;
+  case Instruction::ZExt:    return TargetOpcode::G_ZEXT;
+  case Instruction::SExt:    return TargetOpcode::G_SEXT;
+  case Instruction::Trunc:   return TargetOpcode::G_TRUNC;
+  case Instruction::SIToFP:  return TargetOpcode::G_SITOFP;
+  case Instruction::FPToSI:  return TargetOpcode::G_FPTOSI;
+  case Instruction::FPExt:   return TargetOpcode::G_FPEXT;
+  case Instruction::FPTrunc: return TargetOpcode::G_FPTRUNC;
+  case Instruction::Load:    return TargetOpcode::G_LOAD;
+  case Instruction::Store:   return TargetOpcode::G_STORE;
+  }
+}
+
+/// getTypeSize - Return the size of the generic virtual registers holding
+/// values of type Ty, or 0 if the translator does not handle Ty.
+unsigned IRTranslator::getTypeSize(Type *Ty) const {
+  if (IntegerType *ITy = dyn_cast<IntegerType>(Ty)) {
+    unsigned Width = ITy->getBitWidth();
+    if (Width == 1 || Width == 8 || Width == 16 || Width == 32 || Width == 64)
+      return Width;
+    return 0;
+  }
+  if (Ty->isPointerTy())
+    return Ty->getPointerAddressSpace() == 0 ? TD->getPointerSizeInBits() : 0;
+  if (Ty->isFloatTy())
+    return 32;
+  if (Ty->isDoubleTy())
+    return 64;
+  return 0;
+}
+
+/// isMaterializable - Return true if V is re-created at each use instead of
+/// living in a virtual register.
+bool IRTranslator::isMaterializable(const Value *V) const {
+  if (isa<Constant>(V))
+    return true;
+  if (const AllocaInst *AI = dyn_cast<AllocaInst>(V))
+    return StaticAllocas.count(AI);
+  return false;
+}
+
+bool IRTranslator::isSupportedOperand(const Value *V) const {
+  if (!getTypeSize(V->getType()))
+    return false;
+  if (isa<Instruction>(V) || isa<Argument>(V))
+    return true;
+  if (isa<ConstantInt>(V) || isa<ConstantFP>(V) ||
+      isa<ConstantPointerNull>(V) || isa<UndefValue>(V))
+    return true;
+  if (const GlobalVariable *GV = dyn_cast<GlobalVariable>(V))
+    return !GV->isThreadLocal();
+  return isa<Function>(V);
+}
+
+/// isStaticAlloca - Return true if AI is a fixed-size alloca in the entry
+/// block, which becomes a frame object as in FunctionLoweringInfo.
+static bool isStaticAlloca(const AllocaInst &AI) {
+  return isa<ConstantInt>(AI.getArraySize()) &&
+         AI.getParent() == &AI.getParent()->getParent()->getEntryBlock();
+}
+
+bool IRTranslator::isSupported(const Instruction &I) const {
+  if (const IntrinsicInst *II = dyn_cast<IntrinsicInst>(&I)) {
+    switch (II->getIntrinsicID()) {
+    case Intrinsic::dbg_declare:
+    case Intrinsic::dbg_value:
+    case Intrinsic::lifetime_start:
+    case Intrinsic::lifetime_end:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  // Every operand and the result must have a type the translator handles.
+  if (!I.getType()->isVoidTy() && !getTypeSize(I.getType()))
+    return false;
+  for (unsigned i = 0, e = I.getNumOperands(); i != e; ++i) {
+    const Value *Op = I.getOperand(i);
+    if (isa<BasicBlock>(Op) || isa<Function>(Op))
+      continue;
+    if (!isSupportedOperand(Op))
+      return false;
+  }
+
+  switch (I.getOpcode()) {
+  default:
+    break;
+  case Instruction::Br:
+  case Instruction::Ret:
+  case Instruction::Unreachable:
+  case Instruction::PHI:
+    return true;
+  case Instruction::Alloca:
+    return isStaticAlloca(cast<AllocaInst>(I));
+  case Instruction::GetElementPtr:
+    return LI->isSupported(TargetOpcode::G_ADD, 64) &&
+           LI->isSupported(TargetOpcode::G_MUL, 64) &&
+           LI->isSupported(TargetOpcode::G_SEXT, 32);
+  case Instruction::BitCast:
+  case Instruction::PtrToInt:
+  case Instruction::IntToPtr: {
+    Type *SrcTy = I.getOperand(0)->getType();
+    if (SrcTy->isPointerTy() || I.getType()->isPointerTy())
+      return SrcTy->isPointerTy() || SrcTy->isIntegerTy(64) ||
+             I.getType()->isIntegerTy(64);
+    return false;
+  }
+  case Instruction::Load:
+    if (cast<LoadInst>(I).isAtomic())
+      return false;
+    break;
+  case Instruction::Store:
+    if (cast<StoreInst>(I).isAtomic())
+      return false;
+    break;
+  case Instruction::FCmp: {
+    CmpInst::Predicate Pred = cast<FCmpInst>(I).getPredicate();
+    if (Pred == CmpInst::FCMP_FALSE || Pred == CmpInst::FCMP_TRUE)
+      return true;
+    break;
+  }
+  case Instruction::Call:
+    if (cast<CallInst>(I).isInlineAsm())
+      return false;
+    return CLI->canLowerCall(*MF, cast<CallInst>(I));
+  }
+
+  unsigned Opcode = getGenericOpcode(I.getOpcode());
+  if (!Opcode)
+    return false;
+  unsigned Idx = LegalizerInfo::getTypeOperandIdx(Opcode);
+  Type *Ty = I.getType();
+  if (isa<StoreInst>(I))
+    Ty = I.getOperand(0)->getType();
+  else if (Idx)
+    Ty = I.getOperand(0)->getType();
+  return LI->isSupported(Opcode, getTypeSize(Ty));
+}
+
+/// findUnsupported - Return the first instruction of F that cannot be
+/// translated, or F's entry block terminator if the function itself cannot
+/// be lowered. Return null if the whole function can be translated.
+const Instruction *IRTranslator::findUnsupported(const Function &F) const {
+  if (!CLI->canLowerFunction(*MF) || F.hasGC() ||
+      F.callsFunctionThatReturnsTwice() ||
+      F.getAttributes().hasAttribute(AttributeSet::FunctionIndex,
+                                     Attribute::Naked))
+    return F.getEntryBlock().getTerminator();
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end(); I != IE;
+         ++I)
+      if (!isSupported(*I))
+        return I;
+  return 0;
+}
+
+unsigned IRTranslator::getOrCreateVReg(const Value *V) {
+  if (isMaterializable(V))
+    return materialize(V, *CurMBB, CurMBB->end());
+  unsigned &Reg = ValueToVReg[V];
+  if (!Reg)
+    Reg = MRI->createGenericVirtualRegister(getTypeSize(V->getType()));
+  return Reg;
+}
+
+/// materialize - Insert an instruction before I in MBB that defines a new
+/// generic virtual register with the value of the constant or static alloca
+/// V.
+unsigned IRTranslator::materialize(const Value *V, MachineBasicBlock &MBB,
+                                   MachineBasicBlock::iterator I) {
+  unsigned Size = getTypeSize(V->getType());
+  unsigned Reg = MRI->createGenericVirtualRegister(Size);
+  if (const AllocaInst *AI = dyn_cast<AllocaInst>(V)) {
+    BuildMI(MBB, I, CurDL, TII->get(TargetOpcode::G_FRAME_INDEX), Reg)
+      .addFrameIndex(StaticAllocas.lookup(AI));
+  } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(V)) {
+    BuildMI(MBB, I, CurDL, TII->get(TargetOpcode::G_GLOBAL_VALUE), Reg)
+      .addGlobalAddress(GV);
+  } else if (V->getType()->isFloatingPointTy()) {
+    // Undef floating point values are materialized as zero.
+    const ConstantFP *CF = dyn_cast<ConstantFP>(V);
+    if (!CF)
+      CF = cast<ConstantFP>(Constant::getNullValue(V->getType()));
+    BuildMI(MBB, I, CurDL, TII->get(TargetOpcode::G_FCONSTANT), Reg)
+      .addFPImm(CF);
+  } else {
+    // Null pointers and undef integers are materialized as zero.
+    const ConstantInt *CI = dyn_cast<ConstantInt>(V);
+    if (!CI)
+      CI = ConstantInt::get(IntegerType::get(V->getContext(), Size), 0);
+    BuildMI(MBB, I, CurDL, TII->get(TargetOpcode::G_CONSTANT), Reg)
+      .addCImm(CI);
+  }
+  return Reg;
+}
+
+void IRTranslator::addSuccessor(const BasicBlock *BB) {
+  MachineBasicBlock *Succ = BBToMBB[BB];
+  if (!CurMBB->isSuccessor(Succ))
+    CurMBB->addSuccessor(Succ);
+}
+
+void IRTranslator::translateGEP(const GetElementPtrInst &GEP) {
+  unsigned Res = getOrCreateVReg(&GEP);
+  unsigned Base = getOrCreateVReg(GEP.getPointerOperand());
+  unsigned PtrSize = MRI->getSize(Res);
+  LLVMContext &Ctx = GEP.getContext();
+  IntegerType *IntPtrTy = IntegerType::get(Ctx, PtrSize);
+  int64_t Offset = 0;
+
+  for (gep_type_iterator GTI = gep_type_begin(GEP), E = gep_type_end(GEP);
+       GTI != E; ++GTI) {
+    const Value *Idx = GTI.getOperand();
+    if (StructType *STy = dyn_cast<StructType>(*GTI)) {
+      unsigned Field = cast<ConstantInt>(Idx)->getZExtValue();
+      Offset += TD->getStructLayout(STy)->getElementOffset(Field);
+      continue;
+    }
+    uint64_t ElementSize = TD->getTypeAllocSize(GTI.getIndexedType());
+    if (const ConstantInt *CI = dyn_cast<ConstantInt>(Idx)) {
+      Offset += CI->getSExtValue() * ElementSize;
+      continue;
+    }
+
+    // Variable index: Base += sext(Idx) * ElementSize.
+    unsigned IdxReg = getOrCreateVReg(Idx);
+    if (MRI->getSize(IdxReg) != PtrSize) {
+      unsigned Ext = MRI->createGenericVirtualRegister(PtrSize);
+      buildInstr(TargetOpcode::G_SEXT, Ext).addReg(IdxReg);
+      IdxReg = Ext;
+    }
+    if (ElementSize != 1) {
+      unsigned Scale = MRI->createGenericVirtualRegister(PtrSize);
+      buildInstr(TargetOpcode::G_CONSTANT, Scale)
+        .addCImm(ConstantInt::get(IntPtrTy, ElementSize));
+      unsigned Scaled = MRI->createGenericVirtualRegister(PtrSize);
+      buildInstr(TargetOpcode::G_MUL, Scaled).addReg(IdxReg).addReg(Scale);
+      IdxReg = Scaled;
+    }
+    unsigned Sum = MRI->createGenericVirtualRegister(PtrSize);
+    buildInstr(TargetOpcode::G_ADD, Sum).addReg(Base).addReg(IdxReg);
+    Base = Sum;
+  }
+
+  if (!Offset) {
+    buildInstr(TargetOpcode::COPY, Res).addReg(Base);
+    return;
+  }
+  unsigned OffsetReg = MRI->createGenericVirtualRegister(PtrSize);
+  buildInstr(TargetOpcode::G_CONSTANT, OffsetReg)
+    .addCImm(ConstantInt::get(IntPtrTy, Offset, /*isSigned=*/true));
+  buildInstr(TargetOpcode::G_ADD, Res).addReg(Base).addReg(OffsetReg);
+}
+
+void IRTranslator::translateCast(const CastInst &CI) {
+  unsigned Res = getOrCreateVReg(&CI);
+  unsigned Src = getOrCreateVReg(CI.getOperand(0));
+  unsigned Opcode = getGenericOpcode(CI.getOpcode());
+  if (!Opcode) {
+    // Bitcasts between pointers and conversions between pointers and
+    // integers of the same size are plain copies.
+    unsigned SrcSize = MRI->getSize(Src), ResSize = MRI->getSize(Res);
+    if (SrcSize == ResSize)
+      Opcode = TargetOpcode::COPY;
+    else
+      Opcode = SrcSize < ResSize ? TargetOpcode::G_ZEXT
+                                 : TargetOpcode::G_TRUNC;
+  }
+  buildInstr(Opcode, Res).addReg(Src);
+}
+
+void IRTranslator::translateBr(const BranchInst &BI) {
+  MachineFunction::iterator NextMBB = CurMBB;
+  ++NextMBB;
+  const BasicBlock *FalseBB = BI.getSuccessor(0);
+  if (BI.isConditional()) {
+    const BasicBlock *TrueBB = BI.getSuccessor(0);
+    FalseBB = BI.getSuccessor(1);
+    unsigned Cond = getOrCreateVReg(BI.getCondition());
+    buildInstr(TargetOpcode::G_BRCOND).addReg(Cond).addMBB(BBToMBB[TrueBB]);
+    addSuccessor(TrueBB);
+  }
+  // Branches to the layout successor are left implicit.
+  if (NextMBB == MF->end() || &*NextMBB != BBToMBB[FalseBB])
+    buildInstr(TargetOpcode::G_BR).addMBB(BBToMBB[FalseBB]);
+  addSuccessor(FalseBB);
+}
+
+void IRTranslator::translateLoad(const LoadInst &LI) {
+  unsigned Res = getOrCreateVReg(&LI);
+  unsigned Addr = getOrCreateVReg(LI.getPointerOperand());
+  unsigned Flags = MachineMemOperand::MOLoad;
+  if (LI.isVolatile())
+    Flags |= MachineMemOperand::MOVolatile;
+  unsigned Align = LI.getAlignment();
+  if (!Align)
+    Align = TD->getABITypeAlignment(LI.getType());
+  MachineMemOperand *MMO =
+    MF->getMachineMemOperand(MachinePointerInfo(LI.getPointerOperand()),
+                             Flags, TD->getTypeStoreSize(LI.getType()), Align,
+                             LI.getMetadata(LLVMContext::MD_tbaa));
+  buildInstr(TargetOpcode::G_LOAD, Res).addReg(Addr).addMemOperand(MMO);
+}
+
+void IRTranslator::translateStore(const StoreInst &SI) {
+  const Value *Val = SI.getValueOperand();
+  unsigned ValReg = getOrCreateVReg(Val);
+  unsigned Addr = getOrCreateVReg(SI.getPointerOperand());
+  unsigned Flags = MachineMemOperand::MOStore;
+  if (SI.isVolatile())
+    Flags |= MachineMemOperand::MOVolatile;
+  unsigned Align = SI.getAlignment();
+  if (!Align)
+    Align = TD->getABITypeAlignment(Val->getType());
+  MachineMemOperand *MMO =
+    MF->getMachineMemOperand(MachinePointerInfo(SI.getPointerOperand()),
+                             Flags, TD->getTypeStoreSize(Val->getType()),
+                             Align, SI.getMetadata(LLVMContext::MD_tbaa));
+  buildInstr(TargetOpcode::G_STORE).addReg(ValReg).addReg(Addr)
+    .addMemOperand(MMO);
+}
+
+void IRTranslator::translateCall(const CallInst &CI) {
+  // The only intrinsics that get here carry no code.
+  if (isa<IntrinsicInst>(CI))
+    return;
+
+  unsigned CalleeReg = 0;
+  if (!isa<Function>(CI.getCalledValue()))
+    CalleeReg = getOrCreateVReg(CI.getCalledValue());
+  SmallVector<unsigned, 8> ArgRegs;
+  for (unsigned i = 0, e = CI.getNumArgOperands(); i != e; ++i)
+    ArgRegs.push_back(getOrCreateVReg(CI.getArgOperand(i)));
+  unsigned ResReg = 0;
+  if (!CI.getType()->isVoidTy() && !CI.use_empty())
+    ResReg = getOrCreateVReg(&CI);
+  CLI->lowerCall(*CurMBB, CI, CalleeReg, ArgRegs, ResReg);
+}
+
+void IRTranslator::translate(const Instruction &I) {
+  CurDL = I.getDebugLoc();
+  switch (I.getOpcode()) {
+  case Instruction::Alloca:
+  case Instruction::Unreachable:
+    return;
+  case Instruction::PHI: {
+    MachineInstr *PHI =
+      buildInstr(TargetOpcode::PHI, getOrCreateVReg(&I));
+    PendingPHIs.push_back(std::make_pair(cast<PHINode>(&I), PHI));
+    return;
+  }
+  case Instruction::GetElementPtr:
+    return translateGEP(cast<GetElementPtrInst>(I));
+  case Instruction::Trunc:
+  case Instruction::ZExt:
+  case Instruction::SExt:
+  case Instruction::SIToFP:
+  case Instruction::FPToSI:
+  case Instruction::FPExt:
+  case Instruction::FPTrunc:
+  case Instruction::BitCast:
+  case Instruction::PtrToInt:
+  case Instruction::IntToPtr:
+    return translateCast(cast<CastInst>(I));
+  case Instruction::Br:
+    return translateBr(cast<BranchInst>(I));
+  case Instruction::Load:
+    return translateLoad(cast<LoadInst>(I));
+  case Instruction::Store:
+    return translateStore(cast<StoreInst>(I));
+  case Instruction::Call:
+    return translateCall(cast<CallInst>(I));
+  case Instruction::Ret: {
+    const Value *Val = cast<ReturnInst>(I).getReturnValue();
+    CLI->lowerReturn(*CurMBB, Val, Val ? getOrCreateVReg(Val) : 0, CurDL);
+    return;
+  }
+  case Instruction::ICmp:
+  case Instruction::FCmp: {
+    const CmpInst &Cmp = cast<CmpInst>(I);
+    unsigned Res = getOrCreateVReg(&I);
+    CmpInst::Predicate Pred = Cmp.getPredicate();
+    if (Pred == CmpInst::FCMP_FALSE || Pred == CmpInst::FCMP_TRUE) {
+      buildInstr(TargetOpcode::G_CONSTANT, Res)
+        .addCImm(ConstantInt::get(Type::getInt1Ty(I.getContext()),
+                                  Pred == CmpInst::FCMP_TRUE));
+      return;
+    }
+    unsigned LHS = getOrCreateVReg(Cmp.getOperand(0));
+    unsigned RHS = getOrCreateVReg(Cmp.getOperand(1));
+    buildInstr(getGenericOpcode(I.getOpcode()), Res)
+      .addImm(Pred).addReg(LHS).addReg(RHS);
+    return;
+  }
+  default: {
+    // Binary operators and selects map one operand to one operand.
+    SmallVector<unsigned, 3> Ops;
+    for (unsigned i = 0, e = I.getNumOperands(); i != e; ++i)
+      Ops.push_back(getOrCreateVReg(I.getOperand(i)));
+    MachineInstrBuilder MIB =
+      buildInstr(getGenericOpcode(I.getOpcode()), getOrCreateVReg(&I));
+    for (unsigned i = 0, e = Ops.size(); i != e; ++i)
+      MIB.addReg(Ops[i]);
+    return;
+  }
+  }
+}
+
+void IRTranslator::finishPendingPHIs() {
+  for (unsigned i = 0, e = PendingPHIs.size(); i != e; ++i) {
+    const PHINode *PN = PendingPHIs[i].first;
+    MachineInstrBuilder MIB(*MF, PendingPHIs[i].second);
+    CurDL = PN->getDebugLoc();
+    // A predecessor can appear more than once; the machine PHI lists it once.
+    SmallPtrSet<const BasicBlock *, 8> Seen;
+    for (unsigned j = 0, je = PN->getNumIncomingValues(); j != je; ++j) {
+      const BasicBlock *Pred = PN->getIncomingBlock(j);
+      if (!Seen.insert(Pred))
+        continue;
+      MachineBasicBlock *PredMBB = BBToMBB[Pred];
+      const Value *V = PN->getIncomingValue(j);
+      unsigned Reg;
+      if (isMaterializable(V))
+        Reg = materialize(V, *PredMBB, PredMBB->getFirstTerminator());
+      else
+        Reg = getOrCreateVReg(V);
+      MIB.addReg(Reg).addMBB(PredMBB);
+    }
+  }
+}
+
+bool IRTranslator::runOnMachineFunction(MachineFunction &mf) {
+  MF = &mf;
+  const TargetMachine &TM = MF->getTarget();
+  CLI = TM.getCallLowering();
+  LI = TM.getLegalizerInfo();
+  if (!CLI || !LI || !TM.getRegisterBankInfo() ||
+      !TM.getInstructionSelector())
+    return false;
+
+  const Function &F = *MF->getFunction();
+  TargetSubtargetInfo &ST =
+    const_cast<TargetSubtargetInfo&>(TM.getSubtarget<TargetSubtargetInfo>());
+  ST.resetSubtargetFeatures(MF);
+  TM.resetTargetOptions(MF);
+  MRI = &MF->getRegInfo();
+  TII = TM.getInstrInfo();
+  TD = TM.getDataLayout();
+
+  if (const Instruction *I = findUnsupported(F)) {
+    ++NumFallbacks;
+    DEBUG(dbgs() << "IRTranslator: falling back on " << F.getName()
+                 << " because of: " << *I << '\n');
+    if (AbortOnFallback) {
+      std::string Msg;
+      raw_string_ostream OS(Msg);
+      OS << "global instruction selection failed in '" << F.getName()
+         << "' on: " << *I;
+      report_fatal_error(OS.str());
+    }
+    return false;
+  }
+
+  const BasicBlock &Entry = F.getEntryBlock();
+  for (BasicBlock::const_iterator I = Entry.begin(), E = Entry.end(); I != E;
+       ++I) {
+    const AllocaInst *AI = dyn_cast<AllocaInst>(I);
+    if (!AI)
+      continue;
+    Type *Ty = AI->getAllocatedType();
+    uint64_t Size = TD->getTypeAllocSize(Ty) *
+                    cast<ConstantInt>(AI->getArraySize())->getZExtValue();
+    unsigned Align = std::max((unsigned)TD->getPrefTypeAlignment(Ty),
+                              AI->getAlignment());
+    bool MayNeedSP =
+      AI->isArrayAllocation() ||
+      (Size >= 8 && isa<ArrayType>(Ty) &&
+       cast<ArrayType>(Ty)->getElementType()->isIntegerTy(8));
+    StaticAllocas[AI] = MF->getFrameInfo()->CreateStackObject(
+      Size ? Size : 1, Align, false, MayNeedSP, AI);
+  }
+
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    MachineBasicBlock *MBB = MF->CreateMachineBasicBlock(BB);
+    BBToMBB[BB] = MBB;
+    MF->push_back(MBB);
+    if (BB->hasAddressTaken())
+      MBB->setHasAddressTaken();
+  }
+
+  CurMBB = BBToMBB[&Entry];
+  CurDL = DebugLoc();
+  SmallVector<unsigned, 8> ArgRegs;
+  for (Function::const_arg_iterator A = F.arg_begin(), AE = F.arg_end();
+       A != AE; ++A)
+    ArgRegs.push_back(getOrCreateVReg(A));
+  CLI->lowerArguments(*CurMBB, F, ArgRegs);
+
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    CurMBB = BBToMBB[BB];
+    for (BasicBlock::const_iterator I = BB->begin(), IE = BB->end(); I != IE;
+         ++I)
+      translate(*I);
+  }
+  finishPendingPHIs();
+  ++NumFunctionsTranslated;
+
+  ValueToVReg.clear();
+  BBToMBB.clear();
+  StaticAllocas.clear();
+  PendingPHIs.clear();
+  return true;
+}
@@ -0,0 +1,140 @@
+//===-- InstructionSelect.cpp - Select generic MachineInstrs --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the last pass of the global instruction selector. It
+// walks each block bottom-up and hands every generic instruction to the
+// target's InstructionSelector. Walking bottom-up lets the selector fold an
+// instruction's operands into it; the folded instructions are then dead when
+// they are reached and are simply erased.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "instruction-select"
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+#include "llvm/CodeGen/MachineFrameInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+using namespace llvm;
+
+STATISTIC(NumSelected, "Number of generic instructions selected");
+STATISTIC(NumErased, "Number of dead generic instructions erased");
+
+InstructionSelector::~InstructionSelector() {}
+
+namespace {
+class InstructionSelect : public MachineFunctionPass {
+public:
+  static char ID;
+  InstructionSelect() : MachineFunctionPass(ID) {
+    initializeInstructionSelectPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual const char *getPassName() const { return "InstructionSelect"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  virtual bool runOnMachineFunction(MachineFunction &MF);
+};
+} // end anonymous namespace
+
+char InstructionSelect::ID = 0;
+INITIALIZE_PASS(InstructionSelect, "instruction-select",
+                "Select target instructions for generic instructions",
+                false, false)
+
+FunctionPass *llvm::createInstructionSelectPass() {
+  return new InstructionSelect();
+}
+
+/// isDead - Return true if the generic instruction MI can be erased because
+/// nothing uses its result.
+static bool isDead(const MachineInstr &MI, const MachineRegisterInfo &MRI) {
+  if (MI.mayStore() || MI.isTerminator() || MI.hasOrderedMemoryRef())
+    return false;
+  return MRI.use_nodbg_empty(MI.getOperand(0).getReg());
+}
+
+/// isDeadCopy - Return true if MI is a copy between virtual registers whose
+/// result is no longer used, such as the copy of an address that all its
+/// users folded. Erasing it lets the instructions computing the address die.
+static bool isDeadCopy(const MachineInstr &MI, const MachineRegisterInfo &MRI) {
+  if (!MI.isCopy())
+    return false;
+  unsigned Reg = MI.getOperand(0).getReg();
+  return TargetRegisterInfo::isVirtualRegister(Reg) &&
+         MRI.use_nodbg_empty(Reg);
+}
+
+bool InstructionSelect::runOnMachineFunction(MachineFunction &MF) {
+  // Nothing to do for functions the IRTranslator left to SelectionDAG.
+  if (MF.empty())
+    return false;
+
+  const InstructionSelector &ISel =
+    *MF.getTarget().getInstructionSelector();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  MachineFrameInfo *MFI = MF.getFrameInfo();
+
+  for (MachineFunction::iterator MBB = MF.begin(), E = MF.end(); MBB != E;
+       ++MBB) {
+    MachineBasicBlock::iterator I = MBB->end();
+    while (I != MBB->begin()) {
+      MachineInstr *MI = --I;
+      if (MI->isCall())
+        MFI->setHasCalls(true);
+      if (isDeadCopy(*MI, MRI)) {
+        DEBUG(dbgs() << "Erasing dead: " << *MI);
+        I = llvm::next(I);
+        MI->eraseFromParent();
+        ++NumErased;
+        continue;
+      }
+      if (!isPreISelGenericOpcode(MI->getOpcode()))
+        continue;
+
+      // The selector only inserts instructions right before MI, so resume
+      // the walk at the first instruction after the one before MI.
+      bool AtBegin = I == MBB->begin();
+      MachineBasicBlock::iterator Prev = AtBegin ? I : llvm::prior(I);
+
+      if (isDead(*MI, MRI)) {
+        DEBUG(dbgs() << "Erasing dead: " << *MI);
+        MI->eraseFromParent();
+        ++NumErased;
+      } else {
+        DEBUG(dbgs() << "Selecting: " << *MI);
+        if (!ISel.select(*MI)) {
+          std::string Msg;
+          raw_string_ostream OS(Msg);
+          OS << "cannot select: " << *MI;
+          report_fatal_error(OS.str());
+        }
+        ++NumSelected;
+      }
+      I = AtBegin ? MBB->begin() : llvm::next(Prev);
+    }
+  }
+
+  // Finish the function the way SelectionDAGISel does.
+  MF.setExposesReturnsTwice(MF.getFunction()->callsFunctionThatReturnsTwice());
+  MRI.freezeReservedRegs(MF);
+  return true;
+}
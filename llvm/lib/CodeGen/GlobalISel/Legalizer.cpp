@@ -0,0 +1,273 @@
+//===-- Legalizer.cpp - Legalize generic MachineInstrs --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the second pass of the global instruction selector.
+// It rewrites the generic instructions that the target's LegalizerInfo does
+// not mark Legal: too narrow operations are redone at a legal width between
+// extensions and a truncation, and extensions from a single bit are expanded
+// into instructions on wider registers.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "legalizer"
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+using namespace llvm;
+
+STATISTIC(NumWidened, "Number of generic instructions widened");
+STATISTIC(NumLowered, "Number of generic instructions lowered");
+
+namespace {
+class Legalizer : public MachineFunctionPass {
+  MachineRegisterInfo *MRI;
+  const TargetInstrInfo *TII;
+  LLVMContext *Ctx;
+
+  /// WorkList - Generic instructions that may still need legalizing.
+  SmallVector<MachineInstr *, 64> WorkList;
+
+public:
+  static char ID;
+  Legalizer() : MachineFunctionPass(ID) {
+    initializeLegalizerPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual const char *getPassName() const { return "Legalizer"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  virtual bool runOnMachineFunction(MachineFunction &MF);
+
+private:
+  unsigned buildBefore(MachineInstr &MI, unsigned Opcode, unsigned Size,
+                       unsigned Src);
+  unsigned buildConstantBefore(MachineInstr &MI, unsigned Size, uint64_t Val);
+  void widenUse(MachineInstr &MI, unsigned OpIdx, unsigned ExtOpcode,
+                unsigned Size);
+  void widenDef(MachineInstr &MI, unsigned Size);
+  void widen(MachineInstr &MI, unsigned Size);
+  void lower(MachineInstr &MI);
+};
+} // end anonymous namespace
+
+char Legalizer::ID = 0;
+INITIALIZE_PASS(Legalizer, "legalizer", "Legalize generic instructions",
+                false, false)
+
+FunctionPass *llvm::createLegalizerPass() { return new Legalizer(); }
+
+/// buildBefore - Insert "Res = Opcode Src" before MI, with Res a new generic
+/// virtual register of Size bits, and return Res.
+unsigned Legalizer::buildBefore(MachineInstr &MI, unsigned Opcode,
+                                unsigned Size, unsigned Src) {
+  unsigned Res = MRI->createGenericVirtualRegister(Size);
+  MachineInstr *NewMI =
+    BuildMI(*MI.getParent(), &MI, MI.getDebugLoc(), TII->get(Opcode), Res)
+      .addReg(Src);
+  WorkList.push_back(NewMI);
+  return Res;
+}
+
+unsigned Legalizer::buildConstantBefore(MachineInstr &MI, unsigned Size,
+                                        uint64_t Val) {
+  unsigned Res = MRI->createGenericVirtualRegister(Size);
+  BuildMI(*MI.getParent(), &MI, MI.getDebugLoc(),
+          TII->get(TargetOpcode::G_CONSTANT), Res)
+    .addCImm(ConstantInt::get(IntegerType::get(*Ctx, Size), Val));
+  return Res;
+}
+
+/// widenUse - Replace the register operand OpIdx of MI by its extension to
+/// Size bits.
+void Legalizer::widenUse(MachineInstr &MI, unsigned OpIdx, unsigned ExtOpcode,
+                         unsigned Size) {
+  MachineOperand &MO = MI.getOperand(OpIdx);
+  if (MRI->getSize(MO.getReg()) < Size)
+    MO.setReg(buildBefore(MI, ExtOpcode, Size, MO.getReg()));
+}
+
+/// widenDef - Make MI define a register of Size bits, and truncate it into
+/// the original result register after MI.
+void Legalizer::widenDef(MachineInstr &MI, unsigned Size) {
+  MachineOperand &MO = MI.getOperand(0);
+  unsigned WideReg = MRI->createGenericVirtualRegister(Size);
+  MachineBasicBlock::iterator InsertPt = MI;
+  ++InsertPt;
+  MachineInstr *Trunc = BuildMI(*MI.getParent(), InsertPt, MI.getDebugLoc(),
+                                TII->get(TargetOpcode::G_TRUNC), MO.getReg())
+                          .addReg(WideReg);
+  MO.setReg(WideReg);
+  WorkList.push_back(Trunc);
+}
+
+void Legalizer::widen(MachineInstr &MI, unsigned Size) {
+  switch (MI.getOpcode()) {
+  default:
+    llvm_unreachable("Cannot widen this generic instruction");
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_SUB:
+  case TargetOpcode::G_MUL:
+  case TargetOpcode::G_AND:
+  case TargetOpcode::G_OR:
+  case TargetOpcode::G_XOR:
+    // The high bits of the operands do not affect the low bits of the result.
+    widenUse(MI, 1, TargetOpcode::G_ANYEXT, Size);
+    widenUse(MI, 2, TargetOpcode::G_ANYEXT, Size);
+    widenDef(MI, Size);
+    return;
+  case TargetOpcode::G_SDIV:
+  case TargetOpcode::G_SREM:
+    widenUse(MI, 1, TargetOpcode::G_SEXT, Size);
+    widenUse(MI, 2, TargetOpcode::G_SEXT, Size);
+    widenDef(MI, Size);
+    return;
+  case TargetOpcode::G_UDIV:
+  case TargetOpcode::G_UREM:
+    widenUse(MI, 1, TargetOpcode::G_ZEXT, Size);
+    widenUse(MI, 2, TargetOpcode::G_ZEXT, Size);
+    widenDef(MI, Size);
+    return;
+  case TargetOpcode::G_SHL:
+  case TargetOpcode::G_LSHR:
+  case TargetOpcode::G_ASHR: {
+    // Right shifts pull the high bits of the value into the result.
+    unsigned Ext = TargetOpcode::G_ANYEXT;
+    if (MI.getOpcode() == TargetOpcode::G_LSHR)
+      Ext = TargetOpcode::G_ZEXT;
+    else if (MI.getOpcode() == TargetOpcode::G_ASHR)
+      Ext = TargetOpcode::G_SEXT;
+    widenUse(MI, 1, Ext, Size);
+    widenUse(MI, 2, TargetOpcode::G_ZEXT, Size);
+    widenDef(MI, Size);
+    return;
+  }
+  case TargetOpcode::G_ICMP: {
+    unsigned Ext = CmpInst::isSigned(
+      (CmpInst::Predicate)MI.getOperand(1).getImm()) ? TargetOpcode::G_SEXT
+                                                     : TargetOpcode::G_ZEXT;
+    widenUse(MI, 2, Ext, Size);
+    widenUse(MI, 3, Ext, Size);
+    return;
+  }
+  case TargetOpcode::G_SELECT:
+    widenUse(MI, 2, TargetOpcode::G_ANYEXT, Size);
+    widenUse(MI, 3, TargetOpcode::G_ANYEXT, Size);
+    widenDef(MI, Size);
+    return;
+  case TargetOpcode::G_SITOFP:
+    widenUse(MI, 1, TargetOpcode::G_SEXT, Size);
+    return;
+  case TargetOpcode::G_FPTOSI:
+    widenDef(MI, Size);
+    return;
+  }
+}
+
+void Legalizer::lower(MachineInstr &MI) {
+  unsigned Res = MI.getOperand(0).getReg();
+  unsigned Size = MRI->getSize(Res);
+  switch (MI.getOpcode()) {
+  default:
+    llvm_unreachable("Cannot lower this generic instruction");
+  case TargetOpcode::G_ZEXT: {
+    // zext i1 %x -> and (anyext %x), 1
+    unsigned Ext = buildBefore(MI, TargetOpcode::G_ANYEXT, Size,
+                               MI.getOperand(1).getReg());
+    unsigned One = buildConstantBefore(MI, Size, 1);
+    MachineInstr *And = BuildMI(*MI.getParent(), &MI, MI.getDebugLoc(),
+                                TII->get(TargetOpcode::G_AND), Res)
+                          .addReg(Ext).addReg(One);
+    WorkList.push_back(And);
+    break;
+  }
+  case TargetOpcode::G_SEXT: {
+    // sext i1 %x -> ashr (shl (anyext %x), Size-1), Size-1
+    unsigned Ext = buildBefore(MI, TargetOpcode::G_ANYEXT, Size,
+                               MI.getOperand(1).getReg());
+    unsigned Amt = buildConstantBefore(MI, Size, Size - 1);
+    unsigned Shl = MRI->createGenericVirtualRegister(Size);
+    MachineInstr *ShlMI = BuildMI(*MI.getParent(), &MI, MI.getDebugLoc(),
+                                  TII->get(TargetOpcode::G_SHL), Shl)
+                            .addReg(Ext).addReg(Amt);
+    MachineInstr *AShrMI = BuildMI(*MI.getParent(), &MI, MI.getDebugLoc(),
+                                   TII->get(TargetOpcode::G_ASHR), Res)
+                             .addReg(Shl).addReg(Amt);
+    WorkList.push_back(ShlMI);
+    WorkList.push_back(AShrMI);
+    break;
+  }
+  }
+  MI.eraseFromParent();
+}
+
+bool Legalizer::runOnMachineFunction(MachineFunction &MF) {
+  // Nothing to do for functions the IRTranslator left to SelectionDAG.
+  if (MF.empty())
+    return false;
+
+  const LegalizerInfo &LI = *MF.getTarget().getLegalizerInfo();
+  MRI = &MF.getRegInfo();
+  TII = MF.getTarget().getInstrInfo();
+  Ctx = &MF.getFunction()->getContext();
+
+  for (MachineFunction::iterator MBB = MF.begin(), E = MF.end(); MBB != E;
+       ++MBB)
+    for (MachineBasicBlock::iterator MI = MBB->begin(), ME = MBB->end();
+         MI != ME; ++MI)
+      if (isPreISelGenericOpcode(MI->getOpcode()))
+        WorkList.push_back(MI);
+
+  bool Changed = false;
+  while (!WorkList.empty()) {
+    MachineInstr *MI = WorkList.pop_back_val();
+    std::pair<LegalizerInfo::LegalizeAction, unsigned> Action =
+      LI.getAction(*MI, *MRI);
+    switch (Action.first) {
+    case LegalizerInfo::Legal:
+      continue;
+    case LegalizerInfo::WidenScalar:
+      DEBUG(dbgs() << "Widening to s" << Action.second << ": " << *MI);
+      widen(*MI, Action.second);
+      ++NumWidened;
+      break;
+    case LegalizerInfo::Lower:
+      DEBUG(dbgs() << "Lowering: " << *MI);
+      lower(*MI);
+      ++NumLowered;
+      break;
+    case LegalizerInfo::Unsupported: {
+      // The IRTranslator only emits instructions the target supports.
+      std::string Msg;
+      raw_string_ostream OS(Msg);
+      OS << "unable to legalize instruction: " << *MI;
+      report_fatal_error(OS.str());
+    }
+    }
+    Changed = true;
+  }
+  return Changed;
+}
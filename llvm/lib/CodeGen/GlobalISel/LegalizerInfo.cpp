@@ -0,0 +1,63 @@
+//===-- LegalizerInfo.cpp - Legality of generic instructions --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the LegalizerInfo table lookups.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Target/TargetOpcodes.h"
+
+using namespace llvm;
+
+LegalizerInfo::~LegalizerInfo() {}
+
+unsigned LegalizerInfo::getTypeOperandIdx(unsigned Opcode) {
+  switch (Opcode) {
+  default:
+    return 0;
+  case TargetOpcode::G_ICMP:
+  case TargetOpcode::G_FCMP:
+    return 2;
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT:
+  case TargetOpcode::G_SITOFP:
+    return 1;
+  }
+}
+
+std::pair<LegalizerInfo::LegalizeAction, unsigned>
+LegalizerInfo::getAction(unsigned Opcode, unsigned Size) const {
+  DenseMap<std::pair<unsigned, unsigned>, LegalizeAction>::const_iterator I =
+    Actions.find(std::make_pair(Opcode, Size));
+  if (I != Actions.end())
+    return std::make_pair(I->second, Size);
+
+  // Widen to the smallest legal size that is larger than Size.
+  unsigned WideSize = 0;
+  for (I = Actions.begin(); I != Actions.end(); ++I)
+    if (I->first.first == Opcode && I->second == Legal &&
+        I->first.second > Size && (!WideSize || I->first.second < WideSize))
+      WideSize = I->first.second;
+  if (WideSize)
+    return std::make_pair(WidenScalar, WideSize);
+  return std::make_pair(Unsupported, Size);
+}
+
+std::pair<LegalizerInfo::LegalizeAction, unsigned>
+LegalizerInfo::getAction(const MachineInstr &MI,
+                         const MachineRegisterInfo &MRI) const {
+  // Unconditional branches have no register operand to classify them.
+  if (MI.getOpcode() == TargetOpcode::G_BR)
+    return std::make_pair(Legal, 0U);
+  unsigned Reg = MI.getOperand(getTypeOperandIdx(MI.getOpcode())).getReg();
+  return getAction(MI.getOpcode(), MRI.getSize(Reg));
+}
@@ -0,0 +1,229 @@
+//===-- RegBankSelect.cpp - Assign register banks to generic registers ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the third pass of the global instruction selector. It
+// gives every generic virtual register a register bank, and from that a
+// register class. A register takes the bank its defining instruction
+// requires, else the bank one of its users requires, else the bank of the
+// registers it is copied to or from, else the target's default bank. Operands
+// whose instruction requires a different bank are then rewritten to use a
+// copy into that bank.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "regbankselect"
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+using namespace llvm;
+
+STATISTIC(NumRepairCopies, "Number of copies inserted between banks");
+
+RegisterBankInfo::~RegisterBankInfo() {}
+
+namespace {
+class RegBankSelect : public MachineFunctionPass {
+  MachineRegisterInfo *MRI;
+  const TargetRegisterInfo *TRI;
+  const TargetInstrInfo *TII;
+  const RegisterBankInfo *RBI;
+
+  /// RegBank - The bank chosen for each generic virtual register.
+  DenseMap<unsigned, unsigned> RegBank;
+
+public:
+  static char ID;
+  RegBankSelect() : MachineFunctionPass(ID) {
+    initializeRegBankSelectPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual const char *getPassName() const { return "RegBankSelect"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  virtual bool runOnMachineFunction(MachineFunction &MF);
+
+private:
+  bool isGeneric(unsigned Reg) const {
+    return TargetRegisterInfo::isVirtualRegister(Reg) &&
+           !MRI->getRegClass(Reg);
+  }
+  unsigned getBank(unsigned Reg) const;
+  bool propagateThroughCopies(MachineFunction &MF);
+  unsigned repair(unsigned Reg, unsigned Bank, MachineBasicBlock &MBB,
+                  MachineBasicBlock::iterator I, DebugLoc DL);
+};
+} // end anonymous namespace
+
+char RegBankSelect::ID = 0;
+INITIALIZE_PASS(RegBankSelect, "regbankselect",
+                "Assign register banks to generic registers", false, false)
+
+FunctionPass *llvm::createRegBankSelectPass() { return new RegBankSelect(); }
+
+/// getBank - Return the bank of Reg, which is known for physical registers
+/// and registers that have a class, or AnyBank if none is chosen yet.
+unsigned RegBankSelect::getBank(unsigned Reg) const {
+  if (TargetRegisterInfo::isPhysicalRegister(Reg))
+    return RBI->getRegBankForRegClass(TRI->getMinimalPhysRegClass(Reg));
+  if (const TargetRegisterClass *RC = MRI->getRegClass(Reg))
+    return RBI->getRegBankForRegClass(RC);
+  DenseMap<unsigned, unsigned>::const_iterator I = RegBank.find(Reg);
+  return I == RegBank.end() ? RegisterBankInfo::AnyBank : I->second;
+}
+
+/// propagateThroughCopies - Give unassigned generic registers that are copied
+/// to or from a register with a bank that bank. Return true if any register
+/// was assigned.
+bool RegBankSelect::propagateThroughCopies(MachineFunction &MF) {
+  bool Changed = false;
+  for (MachineFunction::iterator MBB = MF.begin(), E = MF.end(); MBB != E;
+       ++MBB)
+    for (MachineBasicBlock::iterator MI = MBB->begin(), ME = MBB->end();
+         MI != ME; ++MI) {
+      if (!MI->isCopy() && !MI->isPHI())
+        continue;
+      unsigned Def = MI->getOperand(0).getReg();
+      unsigned DefBank = getBank(Def);
+      for (unsigned i = 1, e = MI->getNumOperands(); i != e; ++i) {
+        const MachineOperand &MO = MI->getOperand(i);
+        if (!MO.isReg() || !MO.getReg())
+          continue;
+        unsigned Bank = getBank(MO.getReg());
+        if (DefBank == RegisterBankInfo::AnyBank &&
+            Bank != RegisterBankInfo::AnyBank) {
+          RegBank[Def] = DefBank = Bank;
+          Changed = true;
+        } else if (Bank == RegisterBankInfo::AnyBank &&
+                   DefBank != RegisterBankInfo::AnyBank &&
+                   isGeneric(MO.getReg())) {
+          RegBank[MO.getReg()] = DefBank;
+          Changed = true;
+        }
+      }
+    }
+  return Changed;
+}
+
+/// repair - Insert a copy of Reg into a new register of Bank before I, and
+/// return the new register.
+unsigned RegBankSelect::repair(unsigned Reg, unsigned Bank,
+                               MachineBasicBlock &MBB,
+                               MachineBasicBlock::iterator I, DebugLoc DL) {
+  const TargetRegisterClass *RC = RBI->getRegClass(Bank, MRI->getSize(Reg));
+  assert(RC && "No register class for a required bank");
+  unsigned NewReg = MRI->createVirtualRegister(RC);
+  BuildMI(MBB, I, DL, TII->get(TargetOpcode::COPY), NewReg).addReg(Reg);
+  ++NumRepairCopies;
+  return NewReg;
+}
+
+bool RegBankSelect::runOnMachineFunction(MachineFunction &MF) {
+  // Nothing to do for functions the IRTranslator left to SelectionDAG.
+  if (MF.empty())
+    return false;
+
+  MRI = &MF.getRegInfo();
+  TRI = MF.getTarget().getRegisterInfo();
+  TII = MF.getTarget().getInstrInfo();
+  RBI = MF.getTarget().getRegisterBankInfo();
+
+  // Banks required by the defining instruction win over those required by
+  // users, so visit all definitions first.
+  for (unsigned Pass = 0; Pass != 2; ++Pass)
+    for (MachineFunction::iterator MBB = MF.begin(), E = MF.end(); MBB != E;
+         ++MBB)
+      for (MachineBasicBlock::iterator MI = MBB->begin(), ME = MBB->end();
+           MI != ME; ++MI) {
+        if (!isPreISelGenericOpcode(MI->getOpcode()))
+          continue;
+        for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+          const MachineOperand &MO = MI->getOperand(i);
+          if (!MO.isReg() || MO.isDef() != (Pass == 0) ||
+              !isGeneric(MO.getReg()) || RegBank.count(MO.getReg()))
+            continue;
+          unsigned Bank = RBI->getOperandRegBank(*MI, i);
+          if (Bank != RegisterBankInfo::AnyBank)
+            RegBank[MO.getReg()] = Bank;
+        }
+      }
+
+  while (propagateThroughCopies(MF))
+    ;
+
+  // Fix the register class of every generic register.
+  for (unsigned i = 0, e = MRI->getNumVirtRegs(); i != e; ++i) {
+    unsigned Reg = TargetRegisterInfo::index2VirtReg(i);
+    if (!isGeneric(Reg) || (MRI->reg_empty(Reg)))
+      continue;
+    unsigned Bank = getBank(Reg);
+    if (Bank == RegisterBankInfo::AnyBank)
+      Bank = RBI->getDefaultRegBank();
+    RegBank[Reg] = Bank;
+    const TargetRegisterClass *RC = RBI->getRegClass(Bank, MRI->getSize(Reg));
+    if (!RC)
+      report_fatal_error(Twine("no register class for s") +
+                         Twine(MRI->getSize(Reg)) + " in the " +
+                         RBI->getRegBankName(Bank) + " bank");
+    DEBUG(dbgs() << PrintReg(Reg) << " -> " << RBI->getRegBankName(Bank)
+                 << '\n');
+    MRI->setRegClass(Reg, RC);
+  }
+
+  // Copy operands into the bank their instruction requires. PHI operands
+  // must be in the bank of the PHI, and are copied at the end of the
+  // predecessor.
+  for (MachineFunction::iterator MBB = MF.begin(), E = MF.end(); MBB != E;
+       ++MBB)
+    for (MachineBasicBlock::iterator MI = MBB->begin(), ME = MBB->end();
+         MI != ME; ++MI) {
+      if (MI->isPHI()) {
+        unsigned Bank = RegBank.lookup(MI->getOperand(0).getReg());
+        for (unsigned i = 1, e = MI->getNumOperands(); i != e; i += 2) {
+          MachineOperand &MO = MI->getOperand(i);
+          if (getBank(MO.getReg()) == Bank)
+            continue;
+          MachineBasicBlock *Pred = MI->getOperand(i + 1).getMBB();
+          MO.setReg(repair(MO.getReg(), Bank, *Pred,
+                           Pred->getFirstTerminator(), MI->getDebugLoc()));
+        }
+        continue;
+      }
+      if (!isPreISelGenericOpcode(MI->getOpcode()))
+        continue;
+      for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+        MachineOperand &MO = MI->getOperand(i);
+        if (!MO.isReg() || MO.isDef())
+          continue;
+        unsigned Bank = RBI->getOperandRegBank(*MI, i);
+        if (Bank == RegisterBankInfo::AnyBank ||
+            Bank == getBank(MO.getReg()))
+          continue;
+        MO.setReg(repair(MO.getReg(), Bank, *MBB, MI, MI->getDebugLoc()));
+      }
+    }
+
+  RegBank.clear();
+  return true;
+}
@@ -52,6 +52,8 @@ STATISTIC(CondBranchTakenFreq,
           "Potential frequency of taking conditional branches");
 STATISTIC(UncondBranchTakenFreq,
           "Potential frequency of taking unconditional branches");
+STATISTIC(NumColdBlocksSunk,
+          "Number of blocks the profile never saw that were moved to the end");
 
 static cl::opt<unsigned> AlignAllBlock("align-all-blocks",
                                        cl::desc("Force the alignment of all "
@@ -222,6 +224,7 @@ class MachineBlockPlacement : public MachineFunctionPass {
   void buildLoopChains(MachineFunction &F, MachineLoop &L);
   void rotateLoop(BlockChain &LoopChain, MachineBasicBlock *ExitingBB,
                   const BlockFilterSet &LoopBlockSet);
+  void sinkProfileColdBlocks(MachineFunction &F, BlockChain &FunctionChain);
   void buildCFGChains(MachineFunction &F);
 
 public:
@@ -875,6 +878,67 @@ void MachineBlockPlacement::buildLoopChains(MachineFunction &F,
   });
 }
 
+/// \brief Move the blocks a profile says never run to the end of the function.
+///
+/// With the counts of a training run, the probabilities of never-taken edges
+/// are merely small, so such blocks can still end up between hot ones when a
+/// hot chain breaks. If the function carries the entry count recorded by
+/// -pgo-instr-use, blocks whose estimated count is zero are moved after all
+/// the others so that the hot part of the function is contiguous. Blocks
+/// that must stay in front of their fallthrough successor move together with
+/// it.
+void MachineBlockPlacement::sinkProfileColdBlocks(MachineFunction &F,
+                                                  BlockChain &FunctionChain) {
+  Attribute EntryCountAttr = F.getFunction()->getAttributes().getAttribute(
+      AttributeSet::FunctionIndex, "pgo-entry-count");
+  uint64_t EntryCount;
+  if (!EntryCountAttr.isStringAttribute() ||
+      EntryCountAttr.getValueAsString().getAsInteger(10, EntryCount) ||
+      EntryCount == 0)
+    return;
+
+  // A block runs EntryCount * Freq / EntryFreq times, which is less than once
+  // when Freq is below the rounded up EntryFreq / EntryCount.
+  uint64_t EntryFreq = MBFI->getBlockFreq(&F.front()).getFrequency();
+  uint64_t ColdFreq = EntryFreq / EntryCount +
+                      (EntryFreq % EntryCount != 0);
+
+  SmallVector<MachineBasicBlock *, 16> HotBlocks, ColdBlocks;
+  SmallVector<MachineBasicBlock *, 4> Unit;
+  SmallVector<MachineOperand, 4> Cond; // For AnalyzeBranch.
+  for (BlockChain::iterator BI = FunctionChain.begin(),
+                            BE = FunctionChain.end();
+       BI != BE;) {
+    // Gather the blocks that have to stay together.
+    Unit.clear();
+    bool IsCold = *BI != &F.front();
+    for (;;) {
+      MachineBasicBlock *BB = *BI++;
+      Unit.push_back(BB);
+      IsCold &= MBFI->getBlockFreq(BB).getFrequency() < ColdFreq;
+
+      Cond.clear();
+      MachineBasicBlock *TBB = 0, *FBB = 0; // For AnalyzeBranch.
+      if (BI == BE || !TII->AnalyzeBranch(*BB, TBB, FBB, Cond) ||
+          !BB->canFallThrough())
+        break;
+    }
+
+    SmallVectorImpl<MachineBasicBlock *> &Dest = IsCold ? ColdBlocks
+                                                        : HotBlocks;
+    Dest.append(Unit.begin(), Unit.end());
+  }
+
+  if (ColdBlocks.empty())
+    return;
+  DEBUG(dbgs() << "Sinking " << ColdBlocks.size()
+               << " blocks the profile never saw\n");
+  NumColdBlocksSunk += ColdBlocks.size();
+  std::copy(ColdBlocks.begin(), ColdBlocks.end(),
+            std::copy(HotBlocks.begin(), HotBlocks.end(),
+                      FunctionChain.begin()));
+}
+
 void MachineBlockPlacement::buildCFGChains(MachineFunction &F) {
   // Ensure that every BB in the function has an associated chain to simplify
   // the assumptions of the remaining algorithm.
@@ -967,6 +1031,8 @@ void MachineBlockPlacement::buildCFGChains(MachineFunction &F) {
     assert(!BadFunc && "Detected problems with the block placement.");
   });
 
+  sinkProfileColdBlocks(F, FunctionChain);
+
   // Splice the blocks into place.
   MachineFunction::iterator InsertPos = F.begin();
   for (BlockChain::iterator BI = FunctionChain.begin(),
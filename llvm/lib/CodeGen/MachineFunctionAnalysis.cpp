@@ -20,7 +20,7 @@ using namespace llvm;
 char MachineFunctionAnalysis::ID = 0;
 
 MachineFunctionAnalysis::MachineFunctionAnalysis(const TargetMachine &tm) :
-  FunctionPass(ID), TM(tm), MF(0) {
+  FunctionPass(ID), TM(tm), MMI(0), MF(0) {
   initializeMachineModuleInfoPass(*PassRegistry::getPassRegistry());
 }
 
@@ -35,7 +35,7 @@ void MachineFunctionAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
 }
 
 bool MachineFunctionAnalysis::doInitialization(Module &M) {
-  MachineModuleInfo *MMI = getAnalysisIfAvailable<MachineModuleInfo>();
+  MMI = getAnalysisIfAvailable<MachineModuleInfo>();
   assert(MMI && "MMI not around yet??");
   MMI->setModule(&M);
   NextFnNum = 0;
@@ -45,13 +45,20 @@ bool MachineFunctionAnalysis::doInitialization(Module &M) {
 
 bool MachineFunctionAnalysis::runOnFunction(Function &F) {
   assert(!MF && "MachineFunctionAnalysis already initialized!");
-  MF = new MachineFunction(&F, TM, NextFnNum++,
-                           getAnalysis<MachineModuleInfo>(),
+  // Pick up the machine function an earlier MachineFunctionAnalysis left
+  // behind, if any.
+  MF = MMI->takeRetainedMachineFunction(&F);
+  if (MF)
+    return false;
+  MF = new MachineFunction(&F, TM, NextFnNum++, *MMI,
                            getAnalysisIfAvailable<GCModuleInfo>());
   return false;
 }
 
 void MachineFunctionAnalysis::releaseMemory() {
-  delete MF;
+  if (MF && MMI->retainsMachineFunctions())
+    MMI->retainMachineFunction(MF);
+  else
+    delete MF;
   MF = 0;
 }
@@ -1597,6 +1597,12 @@ void MachineInstr::print(raw_ostream &OS, const TargetMachine *TM,
     if (!HaveSemi) OS << ";"; HaveSemi = true;
     for (unsigned i = 0; i != VirtRegs.size(); ++i) {
       const TargetRegisterClass *RC = MRI->getRegClass(VirtRegs[i]);
+      // Generic virtual registers have a size instead of a class.
+      if (!RC) {
+        OS << " s" << MRI->getSize(VirtRegs[i]) << ':'
+           << PrintReg(VirtRegs[i]);
+        continue;
+      }
       OS << " " << RC->getName() << ':' << PrintReg(VirtRegs[i]);
       for (unsigned j = i+1; j != VirtRegs.size();) {
         if (MRI->getRegClass(VirtRegs[j]) != RC) {
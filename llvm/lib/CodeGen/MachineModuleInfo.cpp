@@ -267,6 +267,74 @@ MachineModuleInfo::MachineModuleInfo()
 MachineModuleInfo::~MachineModuleInfo() {
 }
 
+/// RetainedFunction - A retained machine function and the per-function
+/// information that was current when it was retained.
+struct MachineModuleInfo::RetainedFunction {
+  MachineFunction *MF;
+  std::vector<MCCFIInstruction> FrameInstructions;
+  uint32_t CompactUnwindEncoding;
+  std::vector<LandingPadInfo> LandingPads;
+  DenseMap<MCSymbol*, SmallVector<unsigned, 4> > LPadToCallSiteMap;
+  DenseMap<MCSymbol*, unsigned> CallSiteMap;
+  unsigned CurCallSite;
+  std::vector<const GlobalVariable *> TypeInfos;
+  std::vector<unsigned> FilterIds;
+  std::vector<unsigned> FilterEnds;
+  bool CallsEHReturn;
+  bool CallsUnwindInit;
+  VariableDbgInfoMapTy VariableDbgInfo;
+
+  explicit RetainedFunction(MachineFunction *MF)
+    : MF(MF), CompactUnwindEncoding(0), CurCallSite(0), CallsEHReturn(false),
+      CallsUnwindInit(false) {}
+};
+
+/// swapFunctionInfo - Exchange the current per-function information with the
+/// information saved in RF.
+void MachineModuleInfo::swapFunctionInfo(RetainedFunction &RF) {
+  FrameInstructions.swap(RF.FrameInstructions);
+  std::swap(CompactUnwindEncoding, RF.CompactUnwindEncoding);
+  LandingPads.swap(RF.LandingPads);
+  LPadToCallSiteMap.swap(RF.LPadToCallSiteMap);
+  CallSiteMap.swap(RF.CallSiteMap);
+  std::swap(CurCallSite, RF.CurCallSite);
+  TypeInfos.swap(RF.TypeInfos);
+  FilterIds.swap(RF.FilterIds);
+  FilterEnds.swap(RF.FilterEnds);
+  std::swap(CallsEHReturn, RF.CallsEHReturn);
+  std::swap(CallsUnwindInit, RF.CallsUnwindInit);
+  VariableDbgInfo.swap(RF.VariableDbgInfo);
+}
+
+void MachineModuleInfo::retainMachineFunction(MachineFunction *MF) {
+  RetainedFunction *&RF = RetainedMFs[MF->getFunction()];
+  assert(!RF && "Machine function retained twice");
+  RF = new RetainedFunction(MF);
+  swapFunctionInfo(*RF);
+}
+
+MachineFunction *
+MachineModuleInfo::getRetainedMachineFunction(const Function *F) const {
+  DenseMap<const Function *, RetainedFunction *>::const_iterator I =
+    RetainedMFs.find(F);
+  return I == RetainedMFs.end() ? 0 : I->second->MF;
+}
+
+MachineFunction *
+MachineModuleInfo::takeRetainedMachineFunction(const Function *F) {
+  DenseMap<const Function *, RetainedFunction *>::iterator I =
+    RetainedMFs.find(F);
+  if (I == RetainedMFs.end())
+    return 0;
+  RetainedFunction *RF = I->second;
+  RetainedMFs.erase(I);
+  EndFunction();
+  swapFunctionInfo(*RF);
+  MachineFunction *MF = RF->MF;
+  delete RF;
+  return MF;
+}
+
 bool MachineModuleInfo::doInitialization(Module &M) {
 
   ObjFileMMI = 0;
@@ -279,12 +347,21 @@ bool MachineModuleInfo::doInitialization(Module &M) {
   Personalities.push_back(NULL);
   AddrLabelSymbols = 0;
   TheModule = 0;
+  RetainMFs = false;
 
   return false;
 }
 
 bool MachineModuleInfo::doFinalization(Module &M) {
 
+  // Delete machine functions that were retained but never emitted.
+  for (DenseMap<const Function *, RetainedFunction *>::iterator
+       I = RetainedMFs.begin(), E = RetainedMFs.end(); I != E; ++I) {
+    delete I->second->MF;
+    delete I->second;
+  }
+  RetainedMFs.clear();
+
   Personalities.clear();
 
   delete AddrLabelSymbols;
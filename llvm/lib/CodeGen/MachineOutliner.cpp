@@ -0,0 +1,753 @@
+//===-- MachineOutliner.cpp - Outline repeated instruction sequences ------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the MachineOutliner pass, which replaces instruction
+// sequences that are repeated across the module with calls to new functions
+// holding one copy of each sequence. It runs after register allocation and
+// the pre-emit passes, so the sequences it finds include the spill code,
+// epilogues and argument setup that are invisible to IR-level function
+// merging.
+//
+// Every legal instruction is mapped to an integer, with identical instructions
+// mapping to the same integer and each illegal instruction and block end
+// mapping to a unique one. A suffix tree of the resulting string has an
+// internal node for every repeated substring, which gives all the repeated
+// instruction sequences of the module in linear time.
+//
+// The target classifies each instruction and supplies the cost model:
+//
+// - Sequences of ordinary instructions are called, and the outlined function
+//   ends in a return.
+// - A sequence ending in a call is called too, and the call becomes a tail
+//   call in the outlined function.
+// - A sequence ending in a return is jumped to. It runs in the caller's frame,
+//   so it may also use the stack pointer.
+//
+// Candidates are taken greedily in order of estimated bytes saved. An
+// occurrence that overlaps one already outlined is dropped, and the saving is
+// recomputed before the candidate is kept.
+//
+// Outlining needs every machine function of the module at once, so this pass
+// asks MachineModuleInfo to retain the machine functions until a
+// MachineFunctionAnalysis after it picks them up again.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "machine-outliner"
+#include "llvm/CodeGen/Passes.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetInstrInfo.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+#include <algorithm>
+
+using namespace llvm;
+
+STATISTIC(NumOutlined,  "Number of functions created by the outliner");
+STATISTIC(NumReplaced,  "Number of sequences replaced by outlined calls");
+STATISTIC(NumBytesSaved, "Estimated number of code bytes saved by outlining");
+
+static cl::opt<bool>
+OutlinerReport("outliner-report", cl::Hidden,
+               cl::desc("Print the functions created by the machine outliner "
+                        "and the bytes they save"));
+
+// CreateInfoOutputFile - Return a file stream to print our output on.
+namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
+
+namespace {
+
+//===----------------------------------------------------------------------===//
+//                               Suffix tree
+//===----------------------------------------------------------------------===//
+
+/// SuffixTreeNode - A node of the suffix tree. The edge leading into the node
+/// is labelled with Str[StartIdx, *EndIdx]. Leaves share a single end index,
+/// which grows as the tree is built.
+struct SuffixTreeNode {
+  DenseMap<unsigned, SuffixTreeNode *> Children;
+  unsigned StartIdx;
+  unsigned *EndIdx;
+  SuffixTreeNode *Link;
+
+  /// Depth - Length of the string from the root to the end of this node.
+  unsigned Depth;
+
+  /// FirstLeaf, LastLeaf - The range of SuffixTree::LeafStarts holding the
+  /// suffixes below this node.
+  unsigned FirstLeaf, LastLeaf;
+
+  SuffixTreeNode(unsigned StartIdx, unsigned *EndIdx, SuffixTreeNode *Link)
+    : StartIdx(StartIdx), EndIdx(EndIdx), Link(Link), Depth(0), FirstLeaf(0),
+      LastLeaf(0) {}
+
+  bool isRoot() const { return StartIdx == ~0U; }
+  bool isLeaf() const { return Children.empty() && !isRoot(); }
+  unsigned size() const { return isRoot() ? 0 : *EndIdx - StartIdx + 1; }
+};
+
+/// SuffixTree - A suffix tree over a string of unsigned integers, built with
+/// Ukkonen's algorithm. The last character of the string must be unique, so
+/// that every suffix ends in a leaf.
+class SuffixTree {
+  const std::vector<unsigned> &Str;
+  BumpPtrAllocator Allocator;
+  SuffixTreeNode *Root;
+  unsigned LeafEndIdx;
+
+  // The active point of Ukkonen's algorithm.
+  SuffixTreeNode *ActiveNode;
+  unsigned ActiveIdx;
+  unsigned ActiveLen;
+
+  SuffixTreeNode *createNode(unsigned StartIdx, unsigned *EndIdx) {
+    return new (Allocator.Allocate<SuffixTreeNode>())
+      SuffixTreeNode(StartIdx, EndIdx, Root);
+  }
+
+  SuffixTreeNode *createInternalNode(SuffixTreeNode *Parent, unsigned StartIdx,
+                                     unsigned EndIdx) {
+    unsigned *E = new (Allocator.Allocate<unsigned>()) unsigned(EndIdx);
+    SuffixTreeNode *N = createNode(StartIdx, E);
+    Parent->Children[Str[StartIdx]] = N;
+    return N;
+  }
+
+  unsigned extend(unsigned EndIdx, unsigned SuffixesToAdd);
+  void finish();
+
+public:
+  /// LeafStarts - The start index of every suffix, in depth first order.
+  std::vector<unsigned> LeafStarts;
+
+  /// Internal - Every internal node other than the root, parents first.
+  std::vector<SuffixTreeNode *> Internal;
+
+  explicit SuffixTree(const std::vector<unsigned> &Str);
+
+  ~SuffixTree() {
+    for (unsigned i = 0, e = Internal.size(); i != e; ++i)
+      Internal[i]->~SuffixTreeNode();
+    Root->~SuffixTreeNode();
+  }
+};
+
+} // end anonymous namespace
+
+SuffixTree::SuffixTree(const std::vector<unsigned> &S)
+  : Str(S), LeafEndIdx(0), ActiveIdx(0), ActiveLen(0) {
+  Root = createNode(~0U, 0);
+  Root->Link = Root;
+  ActiveNode = Root;
+
+  unsigned SuffixesToAdd = 0;
+  for (unsigned i = 0, e = Str.size(); i != e; ++i) {
+    ++SuffixesToAdd;
+    LeafEndIdx = i;
+    SuffixesToAdd = extend(i, SuffixesToAdd);
+  }
+  assert(SuffixesToAdd == 0 && "Last character of the string isn't unique");
+  finish();
+}
+
+/// extend - Add the character Str[EndIdx] to every suffix still waiting to be
+/// added to the tree, and return the number that still are.
+unsigned SuffixTree::extend(unsigned EndIdx, unsigned SuffixesToAdd) {
+  SuffixTreeNode *NeedsLink = 0;
+
+  while (SuffixesToAdd > 0) {
+    if (ActiveLen == 0)
+      ActiveIdx = EndIdx;
+    unsigned FirstChar = Str[ActiveIdx];
+
+    DenseMap<unsigned, SuffixTreeNode *>::iterator I =
+      ActiveNode->Children.find(FirstChar);
+    if (I == ActiveNode->Children.end()) {
+      // No edge starts with the character; add a leaf.
+      ActiveNode->Children[FirstChar] = createNode(EndIdx, &LeafEndIdx);
+      if (NeedsLink) {
+        NeedsLink->Link = ActiveNode;
+        NeedsLink = 0;
+      }
+    } else {
+      SuffixTreeNode *Next = I->second;
+      unsigned EdgeLen = Next->size();
+
+      // Walk down to the next node if the active point is past this edge.
+      if (ActiveLen >= EdgeLen) {
+        ActiveIdx += EdgeLen;
+        ActiveLen -= EdgeLen;
+        ActiveNode = Next;
+        continue;
+      }
+
+      // The suffix is already in the tree; it and every shorter one will be
+      // added by a later character.
+      unsigned LastChar = Str[EndIdx];
+      if (Str[Next->StartIdx + ActiveLen] == LastChar) {
+        if (NeedsLink && !ActiveNode->isRoot()) {
+          NeedsLink->Link = ActiveNode;
+          NeedsLink = 0;
+        }
+        ++ActiveLen;
+        break;
+      }
+
+      // Split the edge, and hang a leaf for the new character off the split.
+      SuffixTreeNode *Split =
+        createInternalNode(ActiveNode, Next->StartIdx,
+                           Next->StartIdx + ActiveLen - 1);
+      Internal.push_back(Split);
+      Split->Children[LastChar] = createNode(EndIdx, &LeafEndIdx);
+      Next->StartIdx += ActiveLen;
+      Split->Children[Str[Next->StartIdx]] = Next;
+      if (NeedsLink)
+        NeedsLink->Link = Split;
+      NeedsLink = Split;
+    }
+
+    --SuffixesToAdd;
+    if (ActiveNode->isRoot()) {
+      if (ActiveLen > 0) {
+        --ActiveLen;
+        ActiveIdx = EndIdx - SuffixesToAdd + 1;
+      }
+    } else {
+      ActiveNode = ActiveNode->Link;
+    }
+  }
+  return SuffixesToAdd;
+}
+
+/// finish - Compute the depth of every node and the range of suffixes below
+/// it, and order Internal parents first.
+void SuffixTree::finish() {
+  Internal.clear();
+  LeafStarts.reserve(Str.size());
+
+  // Iterative depth first walk; a node is visited again after its children
+  // to close its leaf range.
+  std::vector<std::pair<SuffixTreeNode *, bool> > Stack;
+  Stack.push_back(std::make_pair(Root, false));
+  while (!Stack.empty()) {
+    SuffixTreeNode *N = Stack.back().first;
+    bool Done = Stack.back().second;
+    Stack.pop_back();
+    if (Done) {
+      N->LastLeaf = LeafStarts.size();
+      continue;
+    }
+    N->FirstLeaf = LeafStarts.size();
+    if (N->isLeaf()) {
+      LeafStarts.push_back(Str.size() - N->Depth);
+      N->LastLeaf = LeafStarts.size();
+      continue;
+    }
+    if (!N->isRoot())
+      Internal.push_back(N);
+    Stack.push_back(std::make_pair(N, true));
+    for (DenseMap<unsigned, SuffixTreeNode *>::iterator
+         I = N->Children.begin(), E = N->Children.end(); I != E; ++I) {
+      I->second->Depth = N->Depth + I->second->size();
+      Stack.push_back(std::make_pair(I->second, false));
+    }
+  }
+}
+
+//===----------------------------------------------------------------------===//
+//                               The outliner
+//===----------------------------------------------------------------------===//
+
+namespace {
+
+/// Candidate - A repeated sequence that may be worth outlining.
+struct Candidate {
+  unsigned FirstLeaf, LastLeaf; // Occurrences, in SuffixTree::LeafStarts.
+  unsigned Len;
+  unsigned Size;
+  int Benefit;
+  TargetInstrInfo::MachineOutlinerKind Kind;
+};
+
+/// OutlinedFunction - A sequence that was outlined, for the report.
+struct OutlinedFunction {
+  const Function *F;
+  TargetInstrInfo::MachineOutlinerKind Kind;
+  unsigned Len;
+  unsigned Size;
+  unsigned Occurrences;
+  int Benefit;
+};
+
+struct CompareBenefit {
+  bool operator()(const Candidate &LHS, const Candidate &RHS) const {
+    return LHS.Benefit > RHS.Benefit;
+  }
+};
+
+class MachineOutliner : public ModulePass {
+  MachineModuleInfo *MMI;
+  const TargetInstrInfo *TII;
+  const TargetRegisterInfo *TRI;
+
+  /// InstrIDs - Numbers for legal instructions. Instructions that are only
+  /// legal in a tail are numbered separately, because an identical
+  /// instruction may be legal everywhere in another function.
+  DenseMap<MachineInstr *, unsigned, MachineInstrExpressionTrait> InstrIDs[2];
+  unsigned NextLegalID, NextIllegalID;
+
+  // The instruction string, and for each position the instruction, its type
+  // and its estimated size. Separators have a null instruction.
+  std::vector<unsigned> Str;
+  std::vector<MachineInstr *> Instrs;
+  std::vector<TargetInstrInfo::MachineOutlinerInstrType> Types;
+  std::vector<unsigned> Sizes;
+
+  // For each position, the start of the next position that isn't Legal, and
+  // of the next Call, and the sum of the sizes before it.
+  std::vector<unsigned> NextNonLegal, NextCall, SizeBefore;
+
+  std::vector<OutlinedFunction> Report;
+
+public:
+  static char ID;
+  MachineOutliner() : ModulePass(ID) {
+    initializeMachineOutlinerPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual const char *getPassName() const { return "Machine Outliner"; }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.addRequired<MachineModuleInfo>();
+    AU.setPreservesAll();
+    ModulePass::getAnalysisUsage(AU);
+  }
+
+  virtual bool doInitialization(Module &M);
+  virtual bool runOnModule(Module &M);
+
+private:
+  void appendSeparator();
+  void mapFunction(MachineFunction &MF);
+  void findCandidates(const SuffixTree &ST, std::vector<Candidate> &Cands);
+  int getBenefit(TargetInstrInfo::MachineOutlinerKind K, unsigned Occurrences,
+                 unsigned Size) const;
+  Function *createOutlinedFunction(Module &M, const Candidate &C,
+                                   unsigned Start, unsigned FnNum,
+                                   unsigned Idx);
+  void replaceOccurrence(unsigned Start, const Candidate &C, Function *F);
+  void printReport(raw_ostream &OS) const;
+};
+
+} // end anonymous namespace
+
+char MachineOutliner::ID = 0;
+INITIALIZE_PASS(MachineOutliner, "machine-outliner",
+                "Machine Function Outliner", false, false)
+
+ModulePass *llvm::createMachineOutlinerPass() {
+  return new MachineOutliner();
+}
+
+bool MachineOutliner::doInitialization(Module &M) {
+  // Keep the machine functions alive until runOnModule has seen them all.
+  if (MachineModuleInfo *MMI = getAnalysisIfAvailable<MachineModuleInfo>())
+    MMI->setRetainMachineFunctions(true);
+  return false;
+}
+
+void MachineOutliner::appendSeparator() {
+  // Runs of illegal instructions need only one separator.
+  if (!Instrs.empty() && !Instrs.back())
+    return;
+  // DenseMap<unsigned> reserves ~0U and ~0U - 1.
+  Str.push_back(NextIllegalID--);
+  Instrs.push_back(0);
+  Types.push_back(TargetInstrInfo::MOIT_Illegal);
+  Sizes.push_back(0);
+}
+
+/// mapFunction - Append the instructions of MF to the instruction string.
+void MachineOutliner::mapFunction(MachineFunction &MF) {
+  for (MachineFunction::iterator MBB = MF.begin(), MBBE = MF.end();
+       MBB != MBBE; ++MBB) {
+    for (MachineBasicBlock::iterator MI = MBB->begin(), E = MBB->end();
+         MI != E; ++MI) {
+      TargetInstrInfo::MachineOutlinerInstrType Type =
+        TII->getOutliningType(MI);
+      if (Type == TargetInstrInfo::MOIT_Invisible)
+        continue;
+      if (Type == TargetInstrInfo::MOIT_Illegal) {
+        appendSeparator();
+        continue;
+      }
+      std::pair<DenseMap<MachineInstr *, unsigned,
+                         MachineInstrExpressionTrait>::iterator, bool> R =
+        InstrIDs[Type == TargetInstrInfo::MOIT_LegalInTail].insert(
+          std::make_pair(&*MI, NextLegalID));
+      if (R.second)
+        ++NextLegalID;
+      Str.push_back(R.first->second);
+      Instrs.push_back(MI);
+      Types.push_back(Type);
+      Sizes.push_back(TII->getOutliningInstrSize(MI));
+    }
+    appendSeparator();
+  }
+}
+
+int MachineOutliner::getBenefit(TargetInstrInfo::MachineOutlinerKind K,
+                                unsigned Occurrences, unsigned Size) const {
+  // Each occurrence shrinks to a call; one copy remains in the new function.
+  int Saved = int(Occurrences * Size);
+  int Cost = int(Occurrences * TII->getOutliningCallOverhead(K) + Size +
+                 TII->getOutliningFrameOverhead(K));
+  return Saved - Cost;
+}
+
+/// findCandidates - Find the most profitable way of outlining the sequence
+/// each internal node of the suffix tree stands for.
+void MachineOutliner::findCandidates(const SuffixTree &ST,
+                                     std::vector<Candidate> &Cands) {
+  unsigned N = Str.size();
+  NextNonLegal.assign(N + 1, N);
+  NextCall.assign(N + 1, N);
+  SizeBefore.assign(N + 1, 0);
+  for (unsigned i = N; i-- != 0;) {
+    NextNonLegal[i] =
+      Types[i] == TargetInstrInfo::MOIT_Legal ? NextNonLegal[i + 1] : i;
+    NextCall[i] = Types[i] == TargetInstrInfo::MOIT_Call ? i : NextCall[i + 1];
+  }
+  for (unsigned i = 0; i != N; ++i)
+    SizeBefore[i + 1] = SizeBefore[i] + Sizes[i];
+
+  for (unsigned i = 0, e = ST.Internal.size(); i != e; ++i) {
+    const SuffixTreeNode *Node = ST.Internal[i];
+    unsigned Occurrences = Node->LastLeaf - Node->FirstLeaf;
+    unsigned MaxLen = Node->Depth;
+    // Shorter sequences belong to an ancestor, which has more occurrences.
+    unsigned MinLen = std::max(Node->Depth - Node->size() + 1, 2U);
+    unsigned Start = ST.LeafStarts[Node->FirstLeaf];
+
+    Candidate Best;
+    Best.Benefit = 0;
+    unsigned LegalLen = NextNonLegal[Start] - Start;
+
+    // Plain instructions, called.
+    unsigned Len = std::min(LegalLen, MaxLen);
+    if (Len >= MinLen) {
+      unsigned Size = SizeBefore[Start + Len] - SizeBefore[Start];
+      int Benefit = getBenefit(TargetInstrInfo::MOK_Call, Occurrences, Size);
+      if (Benefit > Best.Benefit) {
+        Best.Len = Len;
+        Best.Size = Size;
+        Best.Benefit = Benefit;
+        Best.Kind = TargetInstrInfo::MOK_Call;
+      }
+    }
+
+    // Plain instructions ending in a call, called.
+    Len = LegalLen + 1;
+    if (Len >= MinLen && Len <= MaxLen &&
+        Types[Start + LegalLen] == TargetInstrInfo::MOIT_Call) {
+      unsigned Size = SizeBefore[Start + Len] - SizeBefore[Start];
+      int Benefit = getBenefit(TargetInstrInfo::MOK_Thunk, Occurrences, Size);
+      if (Benefit > Best.Benefit) {
+        Best.Len = Len;
+        Best.Size = Size;
+        Best.Benefit = Benefit;
+        Best.Kind = TargetInstrInfo::MOK_Thunk;
+      }
+    }
+
+    // A sequence ending in a return, jumped to. It has no call frame in the
+    // unwind tables, so it can't contain calls.
+    Len = MaxLen;
+    if (Types[Start + Len - 1] == TargetInstrInfo::MOIT_Return &&
+        NextCall[Start] >= Start + Len) {
+      unsigned Size = SizeBefore[Start + Len] - SizeBefore[Start];
+      int Benefit = getBenefit(TargetInstrInfo::MOK_Tail, Occurrences, Size);
+      if (Benefit > Best.Benefit) {
+        Best.Len = Len;
+        Best.Size = Size;
+        Best.Benefit = Benefit;
+        Best.Kind = TargetInstrInfo::MOK_Tail;
+      }
+    }
+
+    if (Best.Benefit <= 0)
+      continue;
+    Best.FirstLeaf = Node->FirstLeaf;
+    Best.LastLeaf = Node->LastLeaf;
+    Cands.push_back(Best);
+  }
+}
+
+/// createOutlinedFunction - Create a function holding a copy of the sequence
+/// of C at Start.
+Function *MachineOutliner::createOutlinedFunction(Module &M,
+                                                  const Candidate &C,
+                                                  unsigned Start,
+                                                  unsigned FnNum,
+                                                  unsigned Idx) {
+  // The IR function only needs a body for the machine function passes to
+  // visit it.
+  LLVMContext &Ctx = M.getContext();
+  Function *F =
+    Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                     GlobalValue::InternalLinkage,
+                     Twine("OUTLINED_FUNCTION_") + Twine(Idx), &M);
+  F->addFnAttr(Attribute::NoUnwind);
+  F->addFnAttr(Attribute::OptimizeForSize);
+  F->addFnAttr(Attribute::MinSize);
+  // A called sequence has a frame of its own, which is worth describing to
+  // the unwinder if the caller's is.
+  MachineFunction &Src = *Instrs[Start]->getParent()->getParent();
+  if (C.Kind != TargetInstrInfo::MOK_Tail &&
+      Src.getFunction()->needsUnwindTableEntry())
+    F->addFnAttr(Attribute::UWTable);
+  new UnreachableInst(Ctx, BasicBlock::Create(Ctx, "entry", F));
+
+  MachineFunction *MF =
+    new MachineFunction(F, Src.getTarget(), FnNum, *MMI, 0);
+  MachineRegisterInfo &MRI = MF->getRegInfo();
+  MRI.freezeReservedRegs(*MF);
+  MRI.leaveSSA();
+  MachineBasicBlock *MBB = MF->CreateMachineBasicBlock();
+  MF->push_back(MBB);
+
+  // Registers read before they are written are live into the function.
+  BitVector Defined(TRI->getNumRegs());
+  for (unsigned i = Start, e = Start + C.Len; i != e; ++i) {
+    MachineInstr *NewMI = MF->CloneMachineInstr(Instrs[i]);
+    // Memory operands belong to the caller's function.
+    NewMI->setMemRefs(0, 0);
+    NewMI->setDebugLoc(DebugLoc());
+    MBB->push_back(NewMI);
+
+    for (unsigned j = 0, je = NewMI->getNumOperands(); j != je; ++j) {
+      MachineOperand &MO = NewMI->getOperand(j);
+      if (!MO.isReg() || !MO.getReg() || MO.isDef() || MO.isUndef())
+        continue;
+      MO.setIsKill(false);
+      if (!Defined.test(MO.getReg()) && !MRI.isReserved(MO.getReg()) &&
+          !MBB->isLiveIn(MO.getReg()))
+        MBB->addLiveIn(MO.getReg());
+    }
+    for (unsigned j = 0, je = NewMI->getNumOperands(); j != je; ++j) {
+      const MachineOperand &MO = NewMI->getOperand(j);
+      if (MO.isReg() && MO.getReg() && MO.isDef())
+        for (MCSubRegIterator SR(MO.getReg(), TRI, true); SR.isValid(); ++SR)
+          Defined.set(*SR);
+    }
+  }
+  TII->finishOutlinedFunction(*MBB, C.Kind);
+
+  MMI->retainMachineFunction(MF);
+  return F;
+}
+
+/// replaceOccurrence - Replace the sequence of C at Start with a call to F.
+void MachineOutliner::replaceOccurrence(unsigned Start, const Candidate &C,
+                                        Function *F) {
+  MachineInstr *First = Instrs[Start];
+  MachineBasicBlock &MBB = *First->getParent();
+  const MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  MachineInstr *Call = TII->insertOutlinedCall(MBB, First, F, C.Kind);
+  MachineInstrBuilder MIB(*MBB.getParent(), Call);
+
+  // The call reads and writes what the sequence did.
+  BitVector Defined(TRI->getNumRegs());
+  SmallVector<unsigned, 8> Uses, Defs;
+  for (unsigned i = Start, e = Start + C.Len; i != e; ++i) {
+    MachineInstr *MI = Instrs[i];
+    for (unsigned j = 0, je = MI->getNumOperands(); j != je; ++j) {
+      const MachineOperand &MO = MI->getOperand(j);
+      if (!MO.isReg() || !MO.getReg() || MO.isDef() || MO.isUndef() ||
+          Defined.test(MO.getReg()) || MRI.isReserved(MO.getReg()))
+        continue;
+      if (std::find(Uses.begin(), Uses.end(), MO.getReg()) == Uses.end())
+        Uses.push_back(MO.getReg());
+    }
+    for (unsigned j = 0, je = MI->getNumOperands(); j != je; ++j) {
+      const MachineOperand &MO = MI->getOperand(j);
+      if (MO.isRegMask() && C.Kind == TargetInstrInfo::MOK_Thunk)
+        MIB.addRegMask(MO.getRegMask());
+      if (!MO.isReg() || !MO.getReg() || !MO.isDef())
+        continue;
+      for (MCSubRegIterator SR(MO.getReg(), TRI, true); SR.isValid(); ++SR)
+        Defined.set(*SR);
+      if (!MRI.isReserved(MO.getReg()) &&
+          std::find(Defs.begin(), Defs.end(), MO.getReg()) == Defs.end())
+        Defs.push_back(MO.getReg());
+    }
+  }
+  for (unsigned i = 0, e = Uses.size(); i != e; ++i)
+    MIB.addReg(Uses[i], RegState::Implicit);
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i)
+    MIB.addReg(Defs[i], RegState::Implicit | RegState::Define);
+
+  // The debug values among the sequence stay behind the call.  Those of
+  // registers that the sequence writes no longer describe the variable there.
+  MachineBasicBlock::iterator I = First, E = Instrs[Start + C.Len - 1];
+  for (; I != E; ++I)
+    if (I->isDebugValue() && I->getOperand(0).isReg() &&
+        I->getOperand(0).getReg() && Defined.test(I->getOperand(0).getReg()))
+      I->getOperand(0).setReg(0);
+
+  for (unsigned i = Start, e = Start + C.Len; i != e; ++i)
+    Instrs[i]->eraseFromParent();
+}
+
+bool MachineOutliner::runOnModule(Module &M) {
+  MMI = &getAnalysis<MachineModuleInfo>();
+  MMI->setRetainMachineFunctions(false);
+
+  // Collect the machine functions in module order, so the outlined functions
+  // don't depend on the order of the retained map.
+  std::vector<MachineFunction *> MFs;
+  unsigned NextFnNum = 0;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+    if (MachineFunction *MF = MMI->getRetainedMachineFunction(F)) {
+      MFs.push_back(MF);
+      NextFnNum = std::max(NextFnNum, MF->getFunctionNumber() + 1);
+    }
+  if (MFs.empty())
+    return false;
+
+  TII = MFs.front()->getTarget().getInstrInfo();
+  TRI = MFs.front()->getTarget().getRegisterInfo();
+  NextLegalID = 0;
+  NextIllegalID = ~0U - 2;
+  for (unsigned i = 0, e = MFs.size(); i != e; ++i)
+    if (TII->isFunctionSafeToOutlineFrom(*MFs[i]))
+      mapFunction(*MFs[i]);
+  // The tree needs a unique last character.
+  if (!Instrs.empty() && Instrs.back())
+    appendSeparator();
+  if (Str.empty())
+    return false;
+
+  std::vector<Candidate> Cands;
+  {
+    SuffixTree ST(Str);
+    findCandidates(ST, Cands);
+    std::stable_sort(Cands.begin(), Cands.end(), CompareBenefit());
+
+    // Take candidates greedily, dropping occurrences that overlap sequences
+    // already outlined or each other.
+    BitVector Taken(Str.size());
+    std::vector<unsigned> Starts, Kept;
+    for (unsigned i = 0, e = Cands.size(); i != e; ++i) {
+      Candidate &C = Cands[i];
+      Starts.assign(ST.LeafStarts.begin() + C.FirstLeaf,
+                    ST.LeafStarts.begin() + C.LastLeaf);
+      std::sort(Starts.begin(), Starts.end());
+      Kept.clear();
+      for (unsigned j = 0, je = Starts.size(); j != je; ++j) {
+        unsigned S = Starts[j];
+        if (!Kept.empty() && S < Kept.back() + C.Len)
+          continue;
+        bool Overlaps = false;
+        for (unsigned k = S, ke = S + C.Len; k != ke && !Overlaps; ++k)
+          Overlaps = Taken.test(k);
+        if (!Overlaps)
+          Kept.push_back(S);
+      }
+      C.Benefit = getBenefit(C.Kind, Kept.size(), C.Size);
+      if (Kept.size() < 2 || C.Benefit <= 0)
+        continue;
+
+      unsigned Idx = Report.size();
+      Function *F = createOutlinedFunction(M, C, Kept.front(), NextFnNum++,
+                                           Idx);
+      DEBUG(dbgs() << "Outlining " << C.Len << " instructions, " << C.Size
+                   << " bytes, at " << Kept.size() << " places into "
+                   << F->getName() << ", saving " << C.Benefit << " bytes\n");
+      for (unsigned j = 0, je = Kept.size(); j != je; ++j) {
+        Taken.set(Kept[j], Kept[j] + C.Len);
+        replaceOccurrence(Kept[j], C, F);
+      }
+
+      OutlinedFunction OF;
+      OF.F = F;
+      OF.Kind = C.Kind;
+      OF.Len = C.Len;
+      OF.Size = C.Size;
+      OF.Occurrences = Kept.size();
+      OF.Benefit = C.Benefit;
+      Report.push_back(OF);
+      ++NumOutlined;
+      NumReplaced += Kept.size();
+      NumBytesSaved += C.Benefit;
+    }
+  }
+
+  if (OutlinerReport) {
+    OwningPtr<raw_ostream> OS(CreateInfoOutputFile());
+    printReport(*OS);
+  }
+
+  for (unsigned i = 0; i != 2; ++i)
+    InstrIDs[i].clear();
+  Str.clear();
+  Instrs.clear();
+  Types.clear();
+  Sizes.clear();
+  NextNonLegal.clear();
+  NextCall.clear();
+  SizeBefore.clear();
+  bool Changed = !Report.empty();
+  Report.clear();
+  return Changed;
+}
+
+void MachineOutliner::printReport(raw_ostream &OS) const {
+  static const char *const KindNames[] = { "call", "thunk", "tail" };
+  OS << "===" << std::string(73, '-') << "===\n"
+     << "                           Machine outliner report\n"
+     << "===" << std::string(73, '-') << "===\n\n";
+  unsigned NumOccurrences = 0;
+  int Saved = 0;
+  for (unsigned i = 0, e = Report.size(); i != e; ++i) {
+    NumOccurrences += Report[i].Occurrences;
+    Saved += Report[i].Benefit;
+  }
+  OS << format("%8u", unsigned(Report.size())) << " functions outlined\n"
+     << format("%8u", NumOccurrences) << " sequences replaced\n"
+     << format("%8d", Saved) << " bytes saved (estimated)\n";
+  if (Report.empty())
+    return;
+  OS << "\n   Insts   Bytes   Uses   Saved  Kind   Function\n";
+  for (unsigned i = 0, e = Report.size(); i != e; ++i) {
+    const OutlinedFunction &OF = Report[i];
+    OS << format("%8u", OF.Len) << format("%8u", OF.Size)
+       << format("%7u", OF.Occurrences) << format("%8d", OF.Benefit) << "  "
+       << format("%-6s", KindNames[OF.Kind]) << ' ' << OF.F->getName() << '\n';
+  }
+}
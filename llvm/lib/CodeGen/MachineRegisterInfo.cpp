@@ -113,6 +113,20 @@ MachineRegisterInfo::createVirtualRegister(const TargetRegisterClass *RegClass){
   return Reg;
 }
 
+/// createGenericVirtualRegister - Create and return a new generic virtual
+/// register of the given size in bits.
+unsigned MachineRegisterInfo::createGenericVirtualRegister(unsigned Size) {
+  assert(Size && "Generic virtual registers need a size");
+  unsigned Reg = TargetRegisterInfo::index2VirtReg(getNumVirtRegs());
+  VRegInfo.grow(Reg);
+  RegAllocHints.grow(Reg);
+  VRegToSize.grow(Reg);
+  VRegToSize[Reg] = Size;
+  if (TheDelegate)
+    TheDelegate->MRI_NoteNewVirtualRegister(Reg);
+  return Reg;
+}
+
 /// clearVirtRegs - Remove all virtual registers (after physreg assignment).
 void MachineRegisterInfo::clearVirtRegs() {
 #ifndef NDEBUG
@@ -125,6 +139,7 @@ void MachineRegisterInfo::clearVirtRegs() {
   }
 #endif
   VRegInfo.clear();
+  VRegToSize.clear();
 }
 
 void MachineRegisterInfo::verifyUseList(unsigned Reg) const {
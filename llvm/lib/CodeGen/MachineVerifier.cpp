@@ -911,6 +911,18 @@ MachineVerifier::visitMachineOperand(const MachineOperand *MO, unsigned MONum) {
       } else {
         // Virtual register.
         const TargetRegisterClass *RC = MRI->getRegClass(Reg);
+        if (!RC) {
+          // Generic virtual registers get a class from register bank
+          // selection, and may only be used by generic instructions, copies
+          // and PHIs until then.
+          if (!MRI->getSize(Reg))
+            report("Virtual register has no register class", MO, MONum);
+          else if (!isPreISelGenericOpcode(MI->getOpcode()) &&
+                   !MI->isCopy() && !MI->isPHI())
+            report("Generic virtual register used by a target instruction",
+                   MO, MONum);
+          return;
+        }
         if (SubIdx) {
           const TargetRegisterClass *SRC =
             TRI->getSubClassWithSubReg(RC, SubIdx);
@@ -0,0 +1,189 @@
+//===-- ParallelCG.cpp ----------------------------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines functions that can be used for parallel code generation.
+//
+// The code generator keeps per-module state in the LLVMContext, the
+// MachineModuleInfo and the MC layer, so functions of the same module cannot
+// be compiled concurrently. Instead, the module is split into partitions that
+// are serialized to bitcode and compiled independently as tasks of a
+// ThreadPool, each in a fresh LLVMContext with its own TargetMachine.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Target/TargetLibraryInfo.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include <algorithm>
+#include <vector>
+using namespace llvm;
+
+/// The stack size requested for the code generation workers.  Some platforms
+/// have small default stacks for secondary threads, and the code generator can
+/// recurse deeply on large functions.
+static const unsigned CodeGenThreadStackSize = 8 << 20;
+
+TargetMachine *llvm::cloneTargetMachine(const TargetMachine &TM) {
+  TargetMachine *Clone =
+    TM.getTarget().createTargetMachine(TM.getTargetTriple(),
+                                       TM.getTargetCPU(),
+                                       TM.getTargetFeatureString(), TM.Options,
+                                       TM.getRelocationModel(),
+                                       TM.getCodeModel(), TM.getOptLevel());
+  if (!Clone)
+    return 0;
+  Clone->setMCRelaxAll(TM.hasMCRelaxAll());
+  Clone->setMCSaveTempLabels(TM.hasMCSaveTempLabels());
+  Clone->setMCNoExecStack(TM.hasMCNoExecStack());
+  Clone->setMCUseLoc(TM.hasMCUseLoc());
+  Clone->setMCUseCFI(TM.hasMCUseCFI());
+  Clone->setMCUseDwarfDirectory(TM.hasMCUseDwarfDirectory());
+  return Clone;
+}
+
+bool llvm::addCodeGenPasses(PassManagerBase &PM, Module &M, TargetMachine &TM,
+                            const TargetLibraryInfo *TLI,
+                            formatted_raw_ostream &OS,
+                            TargetMachine::CodeGenFileType FileType,
+                            bool DisableVerify, AnalysisID StartAfter,
+                            AnalysisID StopAfter) {
+  if (TLI)
+    PM.add(new TargetLibraryInfo(*TLI));
+
+  // Add internal analysis passes from the target machine.
+  TM.addAnalysisPasses(PM);
+
+  // Add the target data from the target machine, if it exists, or the module.
+  if (const DataLayout *TD = TM.getDataLayout())
+    PM.add(new DataLayout(*TD));
+  else
+    PM.add(new DataLayout(&M));
+
+  return TM.addPassesToEmitFile(PM, OS, FileType, DisableVerify, StartAfter,
+                                StopAfter);
+}
+
+/// codegen - Run the code generator for \p TM on \p M, writing the result to
+/// \p OS.
+static bool codegen(Module *M, raw_ostream &OS, TargetMachine &TM,
+                    const TargetLibraryInfo *TLI,
+                    TargetMachine::CodeGenFileType FileType,
+                    std::string &ErrMsg) {
+  PassManager CodeGenPasses;
+  formatted_raw_ostream FOS(OS);
+  if (addCodeGenPasses(CodeGenPasses, *M, TM, TLI, FOS, FileType)) {
+    ErrMsg = "target file type not supported";
+    return false;
+  }
+
+  CodeGenPasses.run(*M);
+  return true;
+}
+
+namespace {
+/// PartitionJob - The input and the result of the code generation of one
+/// partition.
+struct PartitionJob {
+  /// The bitcode of the partition, written by the calling thread.
+  SmallString<0> Bitcode;
+  raw_ostream *OS;
+  const TargetMachine *Template;
+  const TargetLibraryInfo *TLI;
+  TargetMachine::CodeGenFileType FileType;
+  bool Success;
+  std::string ErrMsg;
+
+  PartitionJob()
+    : OS(0), Template(0), TLI(0), FileType(TargetMachine::CGFT_ObjectFile),
+      Success(false) {}
+};
+} // end anonymous namespace
+
+/// writePartition - SplitModule callback that serializes a partition into the
+/// corresponding job.
+static void writePartition(Module *Part, unsigned Index, void *Context) {
+  std::vector<PartitionJob> &Jobs =
+    *static_cast<std::vector<PartitionJob> *>(Context);
+  {
+    raw_svector_ostream BCOS(Jobs[Index].Bitcode);
+    WriteBitcodeToFile(Part, BCOS);
+  }
+  delete Part;
+}
+
+/// runPartitionJob - Task compiling one partition.
+static void runPartitionJob(void *Arg) {
+  PartitionJob &Job = *static_cast<PartitionJob *>(Arg);
+
+  LLVMContext Context;
+  OwningPtr<MemoryBuffer> Buffer(
+    MemoryBuffer::getMemBuffer(Job.Bitcode.str(), "<split-module>", false));
+  OwningPtr<Module> M(ParseBitcodeFile(Buffer.get(), Context, &Job.ErrMsg));
+  if (!M)
+    return;
+
+  OwningPtr<TargetMachine> TM(cloneTargetMachine(*Job.Template));
+  if (!TM) {
+    Job.ErrMsg = "could not create target machine";
+    return;
+  }
+
+  Job.Success = codegen(M.get(), *Job.OS, *TM, Job.TLI, Job.FileType,
+                        Job.ErrMsg);
+}
+
+bool llvm::splitCodeGen(Module *M, ArrayRef<raw_ostream *> OSs,
+                        TargetMachine &TM, const TargetLibraryInfo *TLI,
+                        TargetMachine::CodeGenFileType FileType,
+                        std::string &ErrMsg) {
+  assert(!OSs.empty() && "No output streams given!");
+  if (OSs.size() == 1)
+    return codegen(M, *OSs[0], TM, TLI, FileType, ErrMsg);
+
+  std::vector<PartitionJob> Jobs(OSs.size());
+  SplitModule(M, OSs.size(), writePartition, &Jobs,
+              /*PreserveLocality=*/true);
+
+  // The waiting thread compiles partitions too, so one worker fewer than
+  // there are partitions is enough.  Creating the pool puts LLVM into
+  // multithreaded mode, which guards pass registration, managed statics and
+  // other global state.
+  unsigned NumWorkers =
+    std::min<unsigned>(Jobs.size() - 1, llvm_hardware_concurrency());
+  ThreadPool Pool(NumWorkers, CodeGenThreadStackSize);
+  TaskGroup Tasks(Pool);
+  for (unsigned I = 0, E = Jobs.size(); I != E; ++I) {
+    Jobs[I].OS = OSs[I];
+    Jobs[I].Template = &TM;
+    Jobs[I].TLI = TLI;
+    Jobs[I].FileType = FileType;
+    Tasks.spawn(runPartitionJob, &Jobs[I]);
+  }
+  Tasks.wait();
+
+  for (unsigned I = 0, E = Jobs.size(); I != E; ++I) {
+    if (!Jobs[I].Success) {
+      ErrMsg = Jobs[I].ErrMsg;
+      return false;
+    }
+  }
+  return true;
+}
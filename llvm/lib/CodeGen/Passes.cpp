@@ -17,6 +17,7 @@
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/CodeGen/GCStrategy.h"
+#include "llvm/CodeGen/MachineFunctionAnalysis.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/RegAllocRegistry.h"
 #include "llvm/MC/MCAsmInfo.h"
@@ -87,6 +88,18 @@ PrintMachineInstrs("print-machineinstrs", cl::ValueOptional,
 static cl::opt<bool> EarlyLiveIntervals("early-live-intervals", cl::Hidden,
     cl::desc("Run live interval analysis earlier in the pipeline"));
 
+// Experimental option to select instructions a whole function at a time on
+// MachineInstrs, for the targets that implement it.
+static cl::opt<bool> EnableGlobalISel("global-isel", cl::Hidden,
+    cl::desc("Enable the global instruction selector, falling back to "
+             "SelectionDAG for functions it does not support"));
+
+// Outline instruction sequences repeated across functions, for the targets
+// that implement the outliner hooks.
+static cl::opt<bool> EnableMachineOutliner("enable-machine-outliner",
+    cl::Hidden, cl::desc("Replace repeated machine instruction sequences with "
+                         "calls to outlined functions"));
+
 /// Allow standard passes to be disabled by command line options. This supports
 /// simple binary flags that either suppress the pass or do nothing.
 /// i.e. -disable-mypass=false has no effect.
@@ -263,6 +276,10 @@ TargetPassConfig::TargetPassConfig()
   llvm_unreachable("TargetPassConfig should not be constructed on-the-fly");
 }
 
+bool TargetPassConfig::isGlobalISelEnabled() const {
+  return EnableGlobalISel;
+}
+
 // Helper to verify the analysis is really immutable.
 void TargetPassConfig::setOpt(bool &Opt, bool Val) {
   assert(!Initialized && "PassConfig is immutable");
@@ -536,6 +553,14 @@ void TargetPassConfig::addMachinePasses() {
 
   if (addPreEmitPass())
     printAndVerify("After PreEmit passes");
+
+  // The outliner is a module pass. Machine functions are kept alive across it
+  // and handed to a new MachineFunctionAnalysis for the passes after it.
+  if (EnableMachineOutliner && getOptLevel() != CodeGenOpt::None) {
+    addPass(createMachineOutlinerPass());
+    addPass(new MachineFunctionAnalysis(*TM));
+    printAndVerify("After Machine Outliner");
+  }
 }
 
 /// Add passes that optimize machine instructions in SSA form.
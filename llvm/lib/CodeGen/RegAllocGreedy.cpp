@@ -22,6 +22,7 @@
 #include "Spiller.h"
 #include "SplitKit.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/CodeGen/CalcSpillWeights.h"
 #include "llvm/CodeGen/EdgeBundles.h"
@@ -40,6 +41,7 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <queue>
@@ -49,6 +51,33 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumCappedSplits, "Number of region splits cut short by the effort "
+                           "limit");
+
+// Histograms over functions. Bucket i counts the functions where the quantity
+// has i decimal digits, the last bucket is open ended.
+enum { NumHistogramBuckets = 5 };
+static Statistic EvictionHistogram[NumHistogramBuckets] = {
+  { DEBUG_TYPE, "Functions with 0 evictions", 0, 0 },
+  { DEBUG_TYPE, "Functions with 1-9 evictions", 0, 0 },
+  { DEBUG_TYPE, "Functions with 10-99 evictions", 0, 0 },
+  { DEBUG_TYPE, "Functions with 100-999 evictions", 0, 0 },
+  { DEBUG_TYPE, "Functions with 1000+ evictions", 0, 0 }
+};
+static Statistic SplitHistogram[NumHistogramBuckets] = {
+  { DEBUG_TYPE, "Functions with 0 live range splits", 0, 0 },
+  { DEBUG_TYPE, "Functions with 1-9 live range splits", 0, 0 },
+  { DEBUG_TYPE, "Functions with 10-99 live range splits", 0, 0 },
+  { DEBUG_TYPE, "Functions with 100-999 live range splits", 0, 0 },
+  { DEBUG_TYPE, "Functions with 1000+ live range splits", 0, 0 }
+};
+static Statistic CascadeHistogram[NumHistogramBuckets] = {
+  { DEBUG_TYPE, "Functions with eviction cascade depth 0", 0, 0 },
+  { DEBUG_TYPE, "Functions with eviction cascade depth 1-9", 0, 0 },
+  { DEBUG_TYPE, "Functions with eviction cascade depth 10-99", 0, 0 },
+  { DEBUG_TYPE, "Functions with eviction cascade depth 100-999", 0, 0 },
+  { DEBUG_TYPE, "Functions with eviction cascade depth 1000+", 0, 0 }
+};
 
 static cl::opt<SplitEditor::ComplementSpillMode>
 SplitSpillMode("split-spill-mode", cl::Hidden,
@@ -59,6 +88,24 @@ SplitSpillMode("split-spill-mode", cl::Hidden,
              clEnumValEnd),
   cl::init(SplitEditor::SM_Partition));
 
+static cl::opt<unsigned>
+MaxSplitCandidates("regalloc-max-split-candidates", cl::Hidden,
+  cl::desc("Maximum number of registers tried when splitting a live range "
+           "around a region (0 = no limit)"),
+  cl::init(0));
+
+static cl::opt<unsigned>
+SplitEffortLimit("regalloc-split-effort", cl::Hidden,
+  cl::desc("Maximum number of block updates spent on region splitting one "
+           "live range before falling back to per-block splitting "
+           "(0 = no limit)"),
+  cl::init(1000000));
+
+static cl::opt<std::string>
+StatsJSONFile("regalloc-stats-json", cl::value_desc("filename"),
+  cl::desc("Write per-function greedy register allocator statistics to the "
+           "given file as JSON"));
+
 static RegisterRegAlloc greedyRegAlloc("greedy", "greedy register allocator",
                                        createGreedyRegisterAllocator);
 
@@ -131,7 +178,10 @@ class RAGreedy : public MachineFunctionPass,
     // Cascade - Eviction loop prevention. See canEvictInterference().
     unsigned Cascade;
 
-    RegInfo() : Stage(RS_New), Cascade(0) {}
+    // Depth - Length of the chain of evictions that evicted this live range.
+    unsigned Depth;
+
+    RegInfo() : Stage(RS_New), Cascade(0), Depth(0) {}
   };
 
   IndexedMap<RegInfo, VirtReg2IndexFunctor> ExtraRegInfo;
@@ -228,6 +278,37 @@ class RAGreedy : public MachineFunctionPass,
   /// NoCand which indicates the stack interval.
   SmallVector<unsigned, 32> BundleCand;
 
+  /// Block updates spent on region splitting the current live range. See
+  /// -regalloc-split-effort.
+  unsigned SplitEffort;
+
+  /// Counters for the current function, reported by -stats as histograms and
+  /// by -regalloc-stats-json.
+  struct FunctionStats {
+    unsigned Evictions;
+    unsigned RegionSplits;
+    unsigned BlockSplits;
+    unsigned LocalSplits;
+    unsigned InstructionSplits;
+    unsigned Spills;
+    unsigned CappedSplits;
+    unsigned MaxSplitEffort;
+
+    /// EvictionDepths[d] is the number of evictions at cascade depth d+1.
+    SmallVector<unsigned, 8> EvictionDepths;
+
+    void clear() {
+      Evictions = RegionSplits = BlockSplits = LocalSplits = 0;
+      InstructionSplits = Spills = CappedSplits = MaxSplitEffort = 0;
+      EvictionDepths.clear();
+    }
+
+    unsigned getSplits() const {
+      return RegionSplits + BlockSplits + LocalSplits + InstructionSplits;
+    }
+  };
+  FunctionStats FuncStats;
+
 public:
   RAGreedy();
 
@@ -258,11 +339,13 @@ private:
   BlockFrequency calcSpillCost();
   bool addSplitConstraints(InterferenceCache::Cursor, BlockFrequency&);
   void addThroughConstraints(InterferenceCache::Cursor, ArrayRef<unsigned>);
-  void growRegion(GlobalSplitCandidate &Cand);
+  bool growRegion(GlobalSplitCandidate &Cand);
   BlockFrequency calcGlobalSplitCost(GlobalSplitCandidate&);
   bool calcCompactRegion(GlobalSplitCandidate&);
   void splitAroundRegion(LiveRangeEdit&, ArrayRef<unsigned>);
   void calcGapWeights(unsigned, SmallVectorImpl<float>&);
+  bool overSplitEffort() const;
+  void reportFunctionStats();
   unsigned canReassign(LiveInterval &VirtReg, unsigned PhysReg);
   bool shouldEvict(LiveInterval &A, bool, LiveInterval &B, bool);
   bool canEvictInterference(LiveInterval&, unsigned, bool, EvictionCost&);
@@ -647,6 +730,7 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
   unsigned Cascade = ExtraRegInfo[VirtReg.reg].Cascade;
   if (!Cascade)
     Cascade = ExtraRegInfo[VirtReg.reg].Cascade = NextCascade++;
+  unsigned Depth = ExtraRegInfo[VirtReg.reg].Depth + 1;
 
   DEBUG(dbgs() << "evicting " << PrintReg(PhysReg, TRI)
                << " interference: Cascade " << Cascade << '\n');
@@ -671,7 +755,12 @@ void RAGreedy::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
             VirtReg.isSpillable() < Intf->isSpillable()) &&
            "Cannot decrease cascade number, illegal eviction");
     ExtraRegInfo[Intf->reg].Cascade = Cascade;
+    ExtraRegInfo[Intf->reg].Depth = Depth;
     ++NumEvicted;
+    ++FuncStats.Evictions;
+    if (FuncStats.EvictionDepths.size() < Depth)
+      FuncStats.EvictionDepths.resize(Depth);
+    ++FuncStats.EvictionDepths[Depth - 1];
     NewVRegs.push_back(Intf->reg);
   }
 }
@@ -862,7 +951,10 @@ void RAGreedy::addThroughConstraints(InterferenceCache::Cursor Intf,
   SpillPlacer->addLinks(makeArrayRef(TBS, T));
 }
 
-void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
+/// growRegion - Grow the live bundles of Cand through the live-through blocks
+/// of the current live range. Returns false if the split effort limit was
+/// reached before the region stopped growing.
+bool RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
   // Keep track of through blocks that have not been added to SpillPlacer.
   BitVector Todo = SA->getThroughBlocks();
   SmallVectorImpl<unsigned> &ActiveBlocks = Cand.ActiveBlocks;
@@ -906,10 +998,20 @@ void RAGreedy::growRegion(GlobalSplitCandidate &Cand) {
       SpillPlacer->addPrefSpill(NewBlocks, /* Strong= */ true);
     AddedTo = ActiveBlocks.size();
 
+    // Each round of iteration may update all the blocks added so far, so a
+    // region that grows slowly through many blocks costs quadratic time.
+    SplitEffort += AddedTo;
+    if (overSplitEffort()) {
+      DEBUG(dbgs() << ", effort limit reached after " << AddedTo
+                   << " blocks.\n");
+      return false;
+    }
+
     // Perhaps iterating can enable more bundles?
     SpillPlacer->iterate();
   }
   DEBUG(dbgs() << ", v=" << Visited);
+  return true;
 }
 
 /// calcCompactRegion - Compute the set of edge bundles that should be live
@@ -940,10 +1042,10 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
     return false;
   }
 
-  growRegion(Cand);
+  bool Grown = growRegion(Cand);
   SpillPlacer->finish();
 
-  if (!Cand.LiveBundles.any()) {
+  if (!Grown || !Cand.LiveBundles.any()) {
     DEBUG(dbgs() << ", none.\n");
     return false;
   }
@@ -957,6 +1059,13 @@ bool RAGreedy::calcCompactRegion(GlobalSplitCandidate &Cand) {
   return true;
 }
 
+/// overSplitEffort - Return true when region splitting the current live range
+/// has used up its effort limit, and we should fall back to cheaper per-block
+/// splitting.
+bool RAGreedy::overSplitEffort() const {
+  return SplitEffortLimit && SplitEffort > SplitEffortLimit;
+}
+
 /// calcSpillCost - Compute how expensive it would be to split the live range in
 /// SA around all use blocks instead of forming bundle regions.
 BlockFrequency RAGreedy::calcSpillCost() {
@@ -1124,6 +1233,7 @@ void RAGreedy::splitAroundRegion(LiveRangeEdit &LREdit,
   }
 
   ++NumGlobalSplits;
+  ++FuncStats.RegionSplits;
 
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
@@ -1177,6 +1287,7 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
   unsigned BestCand = NoCand;
   BlockFrequency BestCost;
   SmallVector<unsigned, 8> UsedCands;
+  SplitEffort = 0;
 
   // Check if we can split this live range around a compact region.
   bool HasCompact = calcCompactRegion(GlobalCand.front());
@@ -1191,8 +1302,21 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     DEBUG(dbgs() << "Cost of isolating all blocks = " << BestCost << '\n');
   }
 
+  unsigned NumTried = 0;
+  bool Capped = false;
   Order.rewind();
   while (unsigned PhysReg = Order.next()) {
+    // Bound the time spent on huge live ranges. The best candidate found so
+    // far is still used, without one we fall back to per-block splitting.
+    if ((MaxSplitCandidates && NumTried == MaxSplitCandidates) ||
+        overSplitEffort()) {
+      DEBUG(dbgs() << "Stopping region split after " << NumTried
+                   << " candidates, effort " << SplitEffort << ".\n");
+      Capped = true;
+      break;
+    }
+    ++NumTried;
+
     // Discard bad candidates before we run out of interference cache cursors.
     // This will only affect register classes with a lot of registers (>32).
     if (NumCands == IntfCache.getMaxCursors()) {
@@ -1217,6 +1341,7 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     Cand.reset(IntfCache, PhysReg);
 
     SpillPlacer->prepare(Cand.LiveBundles);
+    SplitEffort += SA->getUseBlocks().size();
     BlockFrequency Cost;
     if (!addSplitConstraints(Cand.Intf, Cost)) {
       DEBUG(dbgs() << PrintReg(PhysReg, TRI) << "\tno positive bundles\n");
@@ -1233,10 +1358,16 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
       });
       continue;
     }
-    growRegion(Cand);
+    bool Grown = growRegion(Cand);
 
     SpillPlacer->finish();
 
+    // The region is incomplete, don't trust its cost.
+    if (!Grown) {
+      Cand.LiveBundles.clear();
+      continue;
+    }
+
     // No live bundles, defer to splitSingleBlocks().
     if (!Cand.LiveBundles.any()) {
       DEBUG(dbgs() << " no bundles.\n");
@@ -1258,6 +1389,12 @@ unsigned RAGreedy::tryRegionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     ++NumCands;
   }
 
+  if (Capped || overSplitEffort()) {
+    ++NumCappedSplits;
+    ++FuncStats.CappedSplits;
+  }
+  FuncStats.MaxSplitEffort = std::max(FuncStats.MaxSplitEffort, SplitEffort);
+
   // No solutions found, fall back to single block splitting.
   if (!HasCompact && BestCand == NoCand)
     return 0;
@@ -1324,6 +1461,7 @@ unsigned RAGreedy::tryBlockSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     return 0;
 
   // We did split for some blocks.
+  ++FuncStats.BlockSplits;
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
 
@@ -1393,6 +1531,7 @@ RAGreedy::tryInstructionSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     return 0;
   }
 
+  ++FuncStats.InstructionSplits;
   SmallVector<unsigned, 8> IntvMap;
   SE->finish(&IntvMap);
   DebugVars->splitRegister(VirtReg.reg, LREdit.regs(), *LIS);
@@ -1706,6 +1845,7 @@ unsigned RAGreedy::tryLocalSplit(LiveInterval &VirtReg, AllocationOrder &Order,
     DEBUG(dbgs() << '\n');
   }
   ++NumLocalSplits;
+  ++FuncStats.LocalSplits;
 
   return 0;
 }
@@ -1810,6 +1950,7 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
   NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
   LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
   spiller().spill(LRE);
+  ++FuncStats.Spills;
   setStage(NewVRegs.begin(), NewVRegs.end(), RS_Done);
 
   if (VerifyEnabled)
@@ -1820,6 +1961,114 @@ unsigned RAGreedy::selectOrSplit(LiveInterval &VirtReg,
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+//                          Allocation Statistics
+//===----------------------------------------------------------------------===//
+
+namespace {
+/// StatsJSON - The -regalloc-stats-json file. It holds a JSON array with one
+/// object per allocated function.
+class StatsJSON {
+  OwningPtr<raw_fd_ostream> OS;
+  bool First;
+public:
+  StatsJSON();
+  ~StatsJSON();
+
+  /// Start a new record and return the stream to write it to, or NULL if the
+  /// file couldn't be opened.
+  raw_ostream *beginRecord();
+};
+} // end anonymous namespace
+
+static ManagedStatic<StatsJSON> TheStatsJSON;
+
+StatsJSON::StatsJSON() : First(true) {
+  std::string Error;
+  OS.reset(new raw_fd_ostream(StatsJSONFile.c_str(), Error));
+  if (!Error.empty()) {
+    errs() << "error opening register allocator statistics '"
+           << StatsJSONFile << "': " << Error << "\n";
+    OS.reset();
+    return;
+  }
+  *OS << '[';
+}
+
+StatsJSON::~StatsJSON() {
+  if (OS)
+    *OS << "\n]\n";
+}
+
+raw_ostream *StatsJSON::beginRecord() {
+  if (!OS)
+    return 0;
+  *OS << (First ? "\n" : ",\n");
+  First = false;
+  return OS.get();
+}
+
+/// writeJSONString - Write S as a quoted JSON string.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (StringRef::iterator I = S.begin(), E = S.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << "\\u00" << hexdigit(C >> 4) << hexdigit(C & 0xF);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+/// getHistogramBucket - Return the histogram bucket for N: the number of
+/// decimal digits in N, saturating at the last bucket.
+static unsigned getHistogramBucket(unsigned N) {
+  unsigned Bucket = 0;
+  while (N && Bucket + 1 < NumHistogramBuckets) {
+    ++Bucket;
+    N /= 10;
+  }
+  return Bucket;
+}
+
+/// reportFunctionStats - Add the current function to the -stats histograms,
+/// and write its record to the -regalloc-stats-json file.
+void RAGreedy::reportFunctionStats() {
+  unsigned Depth = FuncStats.EvictionDepths.size();
+  ++EvictionHistogram[getHistogramBucket(FuncStats.Evictions)];
+  ++SplitHistogram[getHistogramBucket(FuncStats.getSplits())];
+  ++CascadeHistogram[getHistogramBucket(Depth)];
+
+  if (StatsJSONFile.empty())
+    return;
+  raw_ostream *OS = TheStatsJSON->beginRecord();
+  if (!OS)
+    return;
+  raw_ostream &Out = *OS;
+  Out << "{\"function\":";
+  writeJSONString(Out, MF->getName());
+  Out << ",\"virtregs\":" << MRI->getNumVirtRegs()
+      << ",\"evictions\":" << FuncStats.Evictions
+      << ",\"region_splits\":" << FuncStats.RegionSplits
+      << ",\"block_splits\":" << FuncStats.BlockSplits
+      << ",\"local_splits\":" << FuncStats.LocalSplits
+      << ",\"instruction_splits\":" << FuncStats.InstructionSplits
+      << ",\"spills\":" << FuncStats.Spills
+      << ",\"capped_region_splits\":" << FuncStats.CappedSplits
+      << ",\"max_split_effort\":" << FuncStats.MaxSplitEffort
+      << ",\"max_cascade_depth\":" << Depth
+      << ",\"evictions_by_depth\":[";
+  for (unsigned i = 0; i != Depth; ++i) {
+    if (i)
+      Out << ',';
+    Out << FuncStats.EvictionDepths[i];
+  }
+  Out << "]}";
+}
+
 bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   DEBUG(dbgs() << "********** GREEDY REGISTER ALLOCATION **********\n"
                << "********** Function: " << mf.getName() << '\n');
@@ -1849,8 +2098,10 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   NextCascade = 1;
   IntfCache.init(MF, Matrix->getLiveUnions(), Indexes, LIS, TRI);
   GlobalCand.resize(32);  // This will grow as needed.
+  FuncStats.clear();
 
   allocatePhysRegs();
+  reportFunctionStats();
   releaseMemory();
   return true;
 }
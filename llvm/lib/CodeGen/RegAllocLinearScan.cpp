@@ -0,0 +1,618 @@
+//===-- RegAllocLinearScan.cpp - Linear scan register allocator -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the RALinearScan function pass, a global register
+// allocator for clients that need better code than the fast allocator but
+// can't afford the greedy allocator's compile time, such as JIT tiers.
+//
+// Live ranges are assigned in order of their start points, as in a classic
+// linear scan. The LiveRegMatrix takes the place of the active and inactive
+// lists, so lifetime holes are used without any extra bookkeeping. When no
+// register is free, the allocator tries, in order:
+//
+// - Evicting cheaper live ranges. A live range is only evicted once, which
+//   bounds the work to a small multiple of the number of live ranges.
+// - Splitting a live range that is live across calls so it stays in a
+//   register everywhere else. Only the pieces around the calls go to the
+//   stack.
+// - Splitting a live range that spans several blocks around the blocks where
+//   it is used. The new local ranges are allocated like any other, and the
+//   remainder goes to the spiller.
+// - Spilling.
+//
+// There is no interference cache, region splitting or spill placement, so
+// each live range costs a bounded number of interference queries.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "regalloc"
+#include "llvm/CodeGen/Passes.h"
+#include "AllocationOrder.h"
+#include "LiveDebugVariables.h"
+#include "RegAllocBase.h"
+#include "Spiller.h"
+#include "SplitKit.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/CodeGen/CalcSpillWeights.h"
+#include "llvm/CodeGen/LiveIntervalAnalysis.h"
+#include "llvm/CodeGen/LiveRangeEdit.h"
+#include "llvm/CodeGen/LiveRegMatrix.h"
+#include "llvm/CodeGen/LiveStackAnalysis.h"
+#include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/RegAllocRegistry.h"
+#include "llvm/CodeGen/VirtRegMap.h"
+#include "llvm/PassAnalysisSupport.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetRegisterInfo.h"
+#include <queue>
+
+using namespace llvm;
+
+STATISTIC(NumEvicted,     "Number of interferences evicted");
+STATISTIC(NumCallSplits,  "Number of live ranges split around calls");
+STATISTIC(NumBlockSplits, "Number of live ranges split around blocks");
+STATISTIC(NumSpilled,     "Number of live ranges spilled");
+
+static RegisterRegAlloc linearScanRegAlloc("linearscan",
+                                           "linear scan register allocator",
+                                           createLinearScanRegisterAllocator);
+
+namespace {
+class RALinearScan : public MachineFunctionPass,
+                     public RegAllocBase,
+                     private LiveRangeEdit::Delegate {
+  // context
+  MachineFunction *MF;
+
+  // analyses
+  SlotIndexes *Indexes;
+  LiveDebugVariables *DebugVars;
+
+  // state
+  OwningPtr<Spiller> SpillerInstance;
+  std::priority_queue<std::pair<unsigned, unsigned> > Queue;
+
+  // Live ranges move through these stages. A range is never returned to an
+  // earlier stage, which guarantees that allocation terminates.
+  enum LiveRangeStage {
+    /// Original live range. It may be split if it can't be assigned.
+    RS_New,
+
+    /// Product of splitting around calls. It may be split around blocks.
+    RS_Global,
+
+    /// Product of block splitting. It may be spilled, but not split again.
+    RS_Split,
+
+    /// Remainder of a split or product of spilling. Assign it or spill it.
+    RS_Spill
+  };
+
+  // RegInfo - Keep additional information about each live range.
+  struct RegInfo {
+    LiveRangeStage Stage;
+
+    // Evicted - The range was evicted once, and will not be evicted again
+    // by a spillable range.
+    bool Evicted;
+
+    RegInfo() : Stage(RS_New), Evicted(false) {}
+  };
+
+  IndexedMap<RegInfo, VirtReg2IndexFunctor> ExtraRegInfo;
+
+  // splitting state.
+  OwningPtr<SplitAnalysis> SA;
+  OwningPtr<SplitEditor> SE;
+
+public:
+  RALinearScan();
+
+  /// Return the pass name.
+  virtual const char* getPassName() const {
+    return "Linear Scan Register Allocator";
+  }
+
+  /// RALinearScan analysis usage.
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+  virtual void releaseMemory();
+  virtual Spiller &spiller() { return *SpillerInstance; }
+  virtual void enqueue(LiveInterval *LI);
+  virtual LiveInterval *dequeue();
+  virtual unsigned selectOrSplit(LiveInterval&,
+                                 SmallVectorImpl<unsigned>&);
+
+  /// Perform register allocation.
+  virtual bool runOnMachineFunction(MachineFunction &mf);
+
+  static char ID;
+
+private:
+  bool LRE_CanEraseVirtReg(unsigned);
+  void LRE_WillShrinkVirtReg(unsigned);
+  void LRE_DidCloneVirtReg(unsigned, unsigned);
+
+  LiveRangeStage getStage(const LiveInterval &VirtReg) const {
+    return ExtraRegInfo[VirtReg.reg].Stage;
+  }
+
+  void setStage(const LiveInterval &VirtReg, LiveRangeStage Stage) {
+    ExtraRegInfo.resize(MRI->getNumVirtRegs());
+    ExtraRegInfo[VirtReg.reg].Stage = Stage;
+  }
+
+  bool canEvictInterference(LiveInterval&, unsigned, float&);
+  void evictInterference(LiveInterval&, unsigned,
+                         SmallVectorImpl<unsigned>&);
+  unsigned tryEvict(LiveInterval&, AllocationOrder&,
+                    SmallVectorImpl<unsigned>&);
+  bool canEnterAfterCalls(unsigned);
+  unsigned tryCallSplit(LiveInterval&, SmallVectorImpl<unsigned>&);
+  unsigned tryBlockSplit(LiveInterval&, SmallVectorImpl<unsigned>&);
+};
+} // end anonymous namespace
+
+char RALinearScan::ID = 0;
+
+FunctionPass* llvm::createLinearScanRegisterAllocator() {
+  return new RALinearScan();
+}
+
+RALinearScan::RALinearScan(): MachineFunctionPass(ID) {
+  initializeLiveDebugVariablesPass(*PassRegistry::getPassRegistry());
+  initializeSlotIndexesPass(*PassRegistry::getPassRegistry());
+  initializeLiveIntervalsPass(*PassRegistry::getPassRegistry());
+  initializeRegisterCoalescerPass(*PassRegistry::getPassRegistry());
+  initializeMachineSchedulerPass(*PassRegistry::getPassRegistry());
+  initializeCalculateSpillWeightsPass(*PassRegistry::getPassRegistry());
+  initializeLiveStacksPass(*PassRegistry::getPassRegistry());
+  initializeMachineDominatorTreePass(*PassRegistry::getPassRegistry());
+  initializeMachineLoopInfoPass(*PassRegistry::getPassRegistry());
+  initializeVirtRegMapPass(*PassRegistry::getPassRegistry());
+  initializeLiveRegMatrixPass(*PassRegistry::getPassRegistry());
+}
+
+void RALinearScan::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesCFG();
+  AU.addRequired<MachineBlockFrequencyInfo>();
+  AU.addPreserved<MachineBlockFrequencyInfo>();
+  AU.addRequired<AliasAnalysis>();
+  AU.addPreserved<AliasAnalysis>();
+  AU.addRequired<LiveIntervals>();
+  AU.addPreserved<LiveIntervals>();
+  AU.addRequired<SlotIndexes>();
+  AU.addPreserved<SlotIndexes>();
+  AU.addRequired<LiveDebugVariables>();
+  AU.addPreserved<LiveDebugVariables>();
+  AU.addRequired<LiveStacks>();
+  AU.addPreserved<LiveStacks>();
+  AU.addRequired<CalculateSpillWeights>();
+  AU.addRequired<MachineDominatorTree>();
+  AU.addPreserved<MachineDominatorTree>();
+  AU.addRequired<MachineLoopInfo>();
+  AU.addPreserved<MachineLoopInfo>();
+  AU.addRequired<VirtRegMap>();
+  AU.addPreserved<VirtRegMap>();
+  AU.addRequired<LiveRegMatrix>();
+  AU.addPreserved<LiveRegMatrix>();
+  MachineFunctionPass::getAnalysisUsage(AU);
+}
+
+
+//===----------------------------------------------------------------------===//
+//                     LiveRangeEdit delegate methods
+//===----------------------------------------------------------------------===//
+
+bool RALinearScan::LRE_CanEraseVirtReg(unsigned VirtReg) {
+  if (VRM->hasPhys(VirtReg)) {
+    Matrix->unassign(LIS->getInterval(VirtReg));
+    return true;
+  }
+  // Unassigned virtreg is probably in the priority queue.
+  // RegAllocBase will erase it after dequeueing.
+  return false;
+}
+
+void RALinearScan::LRE_WillShrinkVirtReg(unsigned VirtReg) {
+  if (!VRM->hasPhys(VirtReg))
+    return;
+
+  // Register is assigned, put it back on the queue for reassignment.
+  LiveInterval &LI = LIS->getInterval(VirtReg);
+  Matrix->unassign(LI);
+  enqueue(&LI);
+}
+
+void RALinearScan::LRE_DidCloneVirtReg(unsigned New, unsigned Old) {
+  // Cloning a register we haven't even heard about yet?  Just ignore it.
+  if (!ExtraRegInfo.inBounds(Old))
+    return;
+
+  // The clones are connected components of the original range, so they
+  // inherit its stage.
+  ExtraRegInfo.grow(New);
+  ExtraRegInfo[New] = ExtraRegInfo[Old];
+}
+
+void RALinearScan::releaseMemory() {
+  SpillerInstance.reset(0);
+  ExtraRegInfo.clear();
+}
+
+void RALinearScan::enqueue(LiveInterval *LI) {
+  const unsigned Reg = LI->reg;
+  assert(TargetRegisterInfo::isVirtualRegister(Reg) &&
+         "Can only enqueue virtual registers");
+  ExtraRegInfo.grow(Reg);
+
+  // Allocate in order of start points. Empty ranges go first, they can't
+  // interfere with anything.
+  unsigned Prio = ~0u;
+  if (!LI->empty())
+    Prio = LI->beginIndex().getInstrDistance(Indexes->getLastIndex());
+
+  // The virtual register number is a tie breaker for ranges that start at the
+  // same instruction. Give lower vreg numbers higher priority.
+  Queue.push(std::make_pair(Prio, ~Reg));
+}
+
+LiveInterval *RALinearScan::dequeue() {
+  if (Queue.empty())
+    return 0;
+  LiveInterval *LI = &LIS->getInterval(~Queue.top().second);
+  Queue.pop();
+  return LI;
+}
+
+
+//===----------------------------------------------------------------------===//
+//                         Interference eviction
+//===----------------------------------------------------------------------===//
+
+/// canEvictInterference - Return true if all interferences between VirtReg and
+/// PhysReg can be evicted. When true, MaxWeight is the largest spill weight
+/// that would be evicted.
+bool RALinearScan::canEvictInterference(LiveInterval &VirtReg,
+                                        unsigned PhysReg, float &MaxWeight) {
+  bool Urgent = !VirtReg.isSpillable();
+  MaxWeight = 0;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    // If there is 10 or more interferences, chances are one is heavier.
+    if (Q.collectInterferingVRegs(10) >= 10)
+      return false;
+
+    for (unsigned i = Q.interferingVRegs().size(); i; --i) {
+      LiveInterval *Intf = Q.interferingVRegs()[i - 1];
+      assert(TargetRegisterInfo::isVirtualRegister(Intf->reg) &&
+             "Only expecting virtual register interference from query");
+      // Never evict spill products. They cannot be split or spilled.
+      if (!Intf->isSpillable())
+        return false;
+      // Ranges that have been evicted once only make way for ranges that
+      // can't be spilled at all.
+      if (ExtraRegInfo[Intf->reg].Evicted && !Urgent)
+        return false;
+      if (!Urgent && !(Intf->weight < VirtReg.weight))
+        return false;
+      MaxWeight = std::max(MaxWeight, Intf->weight);
+    }
+  }
+  return true;
+}
+
+/// evictInterference - Evict any interferring registers that prevent VirtReg
+/// from being assigned to Physreg. This assumes that canEvictInterference
+/// returned true.
+void RALinearScan::evictInterference(LiveInterval &VirtReg, unsigned PhysReg,
+                                     SmallVectorImpl<unsigned> &NewVRegs) {
+  DEBUG(dbgs() << "evicting " << PrintReg(PhysReg, TRI) << " interference\n");
+
+  // Collect all interfering virtregs first.
+  SmallVector<LiveInterval*, 8> Intfs;
+  for (MCRegUnitIterator Units(PhysReg, TRI); Units.isValid(); ++Units) {
+    LiveIntervalUnion::Query &Q = Matrix->query(VirtReg, *Units);
+    assert(Q.seenAllInterferences() && "Didn't check all interfererences.");
+    ArrayRef<LiveInterval*> IVR = Q.interferingVRegs();
+    Intfs.append(IVR.begin(), IVR.end());
+  }
+
+  // Evict them second. This will invalidate the queries.
+  for (unsigned i = 0, e = Intfs.size(); i != e; ++i) {
+    LiveInterval *Intf = Intfs[i];
+    // The same VirtReg may be present in multiple RegUnits. Skip duplicates.
+    if (!VRM->hasPhys(Intf->reg))
+      continue;
+    Matrix->unassign(*Intf);
+    ExtraRegInfo[Intf->reg].Evicted = true;
+    ++NumEvicted;
+    NewVRegs.push_back(Intf->reg);
+  }
+}
+
+/// tryEvict - Try to evict all interferences for a physreg, choosing the
+/// register where the heaviest evicted range is cheapest.
+/// @param  VirtReg Currently unassigned virtual register.
+/// @param  Order   Physregs to try.
+/// @return         Physreg to assign VirtReg, or 0.
+unsigned RALinearScan::tryEvict(LiveInterval &VirtReg, AllocationOrder &Order,
+                                SmallVectorImpl<unsigned> &NewVRegs) {
+  NamedRegionTimer T("Evict", TimerGroupName, TimePassesIsEnabled);
+
+  unsigned BestPhys = 0;
+  float BestWeight = 0;
+  Order.rewind();
+  while (unsigned PhysReg = Order.next()) {
+    if (Matrix->checkInterference(VirtReg, PhysReg) !=
+        LiveRegMatrix::IK_VirtReg)
+      continue;
+    float MaxWeight;
+    if (!canEvictInterference(VirtReg, PhysReg, MaxWeight))
+      continue;
+    if (BestPhys && !(MaxWeight < BestWeight))
+      continue;
+    BestPhys = PhysReg;
+    BestWeight = MaxWeight;
+  }
+
+  if (!BestPhys)
+    return 0;
+
+  evictInterference(VirtReg, BestPhys, NewVRegs);
+  return BestPhys;
+}
+
+
+//===----------------------------------------------------------------------===//
+//                              Call splitting
+//===----------------------------------------------------------------------===//
+
+/// canEnterAfterCalls - Return true if a value that is live out of block
+/// Number can be copied back into a register after the last call in it. That
+/// is not possible when the call is an invoke, for instance.
+bool RALinearScan::canEnterAfterCalls(unsigned Number) {
+  ArrayRef<SlotIndex> Calls = LIS->getRegMaskSlotsInBlock(Number);
+  return Calls.empty() ||
+         Calls.back().getDeadSlot() < SA->getLastSplitPoint(Number);
+}
+
+/// tryCallSplit - Split a global live range that is live across calls into a
+/// main interval that avoids all the calls, and a remainder that holds the
+/// value across them. The main interval is live everywhere the original range
+/// was, except between the first and the last call of each block.
+///
+/// This is the region split that the greedy allocator would pick when a value
+/// only fails to get a register because of call clobbers, found without any
+/// cost model: every block belongs to the region, and the calls are the only
+/// interference.
+unsigned RALinearScan::tryCallSplit(LiveInterval &VirtReg,
+                                    SmallVectorImpl<unsigned> &NewVRegs) {
+  BitVector UsableRegs;
+  if (!LIS->checkRegMaskInterference(VirtReg, UsableRegs))
+    return 0;
+
+  NamedRegionTimer T("Call Split", TimerGroupName, TimePassesIsEnabled);
+  SA->analyze(&VirtReg);
+  ArrayRef<SplitAnalysis::BlockInfo> UseBlocks = SA->getUseBlocks();
+  const BitVector &Through = SA->getThroughBlocks();
+
+  // The main interval is live out of the same blocks as the original range.
+  for (unsigned i = 0; i != UseBlocks.size(); ++i)
+    if (UseBlocks[i].LiveOut &&
+        !canEnterAfterCalls(UseBlocks[i].MBB->getNumber()))
+      return 0;
+  for (int Number = Through.find_first(); Number >= 0;
+       Number = Through.find_next(Number))
+    if (!canEnterAfterCalls(Number))
+      return 0;
+
+  unsigned Reg = VirtReg.reg;
+  bool SingleInstrs = RegClassInfo.isProperSubClass(MRI->getRegClass(Reg));
+  LiveRangeEdit LREdit(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
+  SE->reset(LREdit);
+  unsigned MainIntv = SE->openIntv();
+
+  // First handle all the blocks with uses.
+  for (unsigned i = 0; i != UseBlocks.size(); ++i) {
+    const SplitAnalysis::BlockInfo &BI = UseBlocks[i];
+    unsigned Number = BI.MBB->getNumber();
+    if (!BI.LiveIn && !BI.LiveOut) {
+      if (SA->shouldSplitSingleBlock(BI, SingleInstrs))
+        SE->splitSingleBlock(BI);
+      continue;
+    }
+    ArrayRef<SlotIndex> Calls = LIS->getRegMaskSlotsInBlock(Number);
+    SlotIndex IntfIn, IntfOut;
+    if (!Calls.empty()) {
+      IntfIn = Calls.front();
+      IntfOut = Calls.back().getDeadSlot();
+    }
+    if (BI.LiveIn && BI.LiveOut)
+      SE->splitLiveThroughBlock(Number, MainIntv, IntfIn, MainIntv, IntfOut);
+    else if (BI.LiveIn)
+      SE->splitRegInBlock(BI, MainIntv, IntfIn);
+    else
+      SE->splitRegOutBlock(BI, MainIntv, IntfOut);
+  }
+
+  // Then the live-through blocks.
+  for (int Number = Through.find_first(); Number >= 0;
+       Number = Through.find_next(Number)) {
+    ArrayRef<SlotIndex> Calls = LIS->getRegMaskSlotsInBlock(Number);
+    SlotIndex IntfIn, IntfOut;
+    if (!Calls.empty()) {
+      IntfIn = Calls.front();
+      IntfOut = Calls.back().getDeadSlot();
+    }
+    SE->splitLiveThroughBlock(Number, MainIntv, IntfIn, MainIntv, IntfOut);
+  }
+
+  SmallVector<unsigned, 8> IntvMap;
+  SE->finish(&IntvMap);
+  ++NumCallSplits;
+
+  // Tell LiveDebugVariables about the new ranges.
+  DebugVars->splitRegister(Reg, LREdit.regs(), *LIS);
+
+  // The remainder holds the value across the calls and should be spilled if
+  // it doesn't get a callee-saved register. The main interval no longer
+  // crosses any calls, but may still be split around blocks.
+  ExtraRegInfo.resize(MRI->getNumVirtRegs());
+  for (unsigned i = 0, e = LREdit.size(); i != e; ++i) {
+    LiveInterval &LI = LIS->getInterval(LREdit.get(i));
+    if (IntvMap[i] == 0)
+      setStage(LI, RS_Spill);
+    else if (IntvMap[i] == MainIntv)
+      setStage(LI, RS_Global);
+    else
+      setStage(LI, RS_Split);
+  }
+
+  if (VerifyEnabled)
+    MF->verify(this, "After splitting live range around calls");
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+//                             Block splitting
+//===----------------------------------------------------------------------===//
+
+/// tryBlockSplit - Split a global live range around every block with uses.
+/// The new local ranges are assigned or spilled individually. Blocks where
+/// SplitAnalysis doesn't think isolating the uses would help are left out.
+unsigned RALinearScan::tryBlockSplit(LiveInterval &VirtReg,
+                                     SmallVectorImpl<unsigned> &NewVRegs) {
+  NamedRegionTimer T("Block Split", TimerGroupName, TimePassesIsEnabled);
+  SA->analyze(&VirtReg);
+  unsigned Reg = VirtReg.reg;
+  bool SingleInstrs = RegClassInfo.isProperSubClass(MRI->getRegClass(Reg));
+  LiveRangeEdit LREdit(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
+  SE->reset(LREdit);
+  ArrayRef<SplitAnalysis::BlockInfo> UseBlocks = SA->getUseBlocks();
+  for (unsigned i = 0; i != UseBlocks.size(); ++i) {
+    const SplitAnalysis::BlockInfo &BI = UseBlocks[i];
+    if (SA->shouldSplitSingleBlock(BI, SingleInstrs))
+      SE->splitSingleBlock(BI);
+  }
+  // No blocks were split.
+  if (LREdit.empty())
+    return 0;
+
+  SmallVector<unsigned, 8> IntvMap;
+  SE->finish(&IntvMap);
+  ++NumBlockSplits;
+
+  // Tell LiveDebugVariables about the new ranges.
+  DebugVars->splitRegister(Reg, LREdit.regs(), *LIS);
+
+  // The remainder goes straight to spilling, the local ranges may still be
+  // spilled but are not split again.
+  ExtraRegInfo.resize(MRI->getNumVirtRegs());
+  for (unsigned i = 0, e = LREdit.size(); i != e; ++i) {
+    LiveInterval &LI = LIS->getInterval(LREdit.get(i));
+    setStage(LI, IntvMap[i] == 0 ? RS_Spill : RS_Split);
+  }
+
+  if (VerifyEnabled)
+    MF->verify(this, "After splitting live range around basic blocks");
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+//                            Main Entry Point
+//===----------------------------------------------------------------------===//
+
+unsigned RALinearScan::selectOrSplit(LiveInterval &VirtReg,
+                                     SmallVectorImpl<unsigned> &NewVRegs) {
+  // First try assigning a free register. AllocationOrder yields the hints
+  // first.
+  AllocationOrder Order(VirtReg.reg, *VRM, RegClassInfo);
+  while (unsigned PhysReg = Order.next())
+    if (!Matrix->checkInterference(VirtReg, PhysReg))
+      return PhysReg;
+
+  // Then try to make room by evicting cheaper ranges.
+  if (unsigned PhysReg = tryEvict(VirtReg, Order, NewVRegs))
+    return PhysReg;
+
+  // If we couldn't allocate a register from spilling, there is probably some
+  // invalid inline assembly. The base class wil report it.
+  if (!VirtReg.isSpillable())
+    return ~0u;
+
+  // Split global ranges around calls, and then around their uses.
+  LiveRangeStage Stage = getStage(VirtReg);
+  if (Stage < RS_Split && !LIS->intervalIsInOneMBB(VirtReg)) {
+    if (Stage == RS_New) {
+      tryCallSplit(VirtReg, NewVRegs);
+      if (!NewVRegs.empty())
+        return 0;
+    }
+    tryBlockSplit(VirtReg, NewVRegs);
+    if (!NewVRegs.empty())
+      return 0;
+  }
+
+  // Finally spill VirtReg itself.
+  NamedRegionTimer T("Spiller", TimerGroupName, TimePassesIsEnabled);
+  DEBUG(dbgs() << "spilling: " << VirtReg << '\n');
+  LiveRangeEdit LRE(&VirtReg, NewVRegs, *MF, *LIS, VRM, this);
+  spiller().spill(LRE);
+  ++NumSpilled;
+  ExtraRegInfo.resize(MRI->getNumVirtRegs());
+  for (unsigned i = 0, e = NewVRegs.size(); i != e; ++i)
+    ExtraRegInfo[NewVRegs[i]].Stage = RS_Spill;
+
+  if (VerifyEnabled)
+    MF->verify(this, "After spilling");
+
+  // The live virtual register requesting allocation was spilled, so tell
+  // the caller not to allocate anything during this round.
+  return 0;
+}
+
+bool RALinearScan::runOnMachineFunction(MachineFunction &mf) {
+  DEBUG(dbgs() << "********** LINEAR SCAN REGISTER ALLOCATION **********\n"
+               << "********** Function: " << mf.getName() << '\n');
+
+  MF = &mf;
+  if (VerifyEnabled)
+    MF->verify(this, "Before linear scan register allocator");
+
+  RegAllocBase::init(getAnalysis<VirtRegMap>(),
+                     getAnalysis<LiveIntervals>(),
+                     getAnalysis<LiveRegMatrix>());
+  Indexes = &getAnalysis<SlotIndexes>();
+  DebugVars = &getAnalysis<LiveDebugVariables>();
+  SpillerInstance.reset(createInlineSpiller(*this, *MF, *VRM));
+
+  SA.reset(new SplitAnalysis(*VRM, *LIS, getAnalysis<MachineLoopInfo>()));
+  SE.reset(new SplitEditor(*SA, *LIS, *VRM,
+                           getAnalysis<MachineDominatorTree>(),
+                           getAnalysis<MachineBlockFrequencyInfo>()));
+  ExtraRegInfo.clear();
+  ExtraRegInfo.resize(MRI->getNumVirtRegs());
+
+  allocatePhysRegs();
+
+  // Diagnostic output before rewriting
+  DEBUG(dbgs() << "Post alloc VirtRegMap:\n" << *VRM << "\n");
+
+  releaseMemory();
+  return true;
+}
@@ -18,6 +18,7 @@
 
 #define DEBUG_TYPE "dagcombine"
 #include "llvm/CodeGen/SelectionDAG.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -46,6 +47,8 @@ STATISTIC(PostIndexedNodes, "Number of post-indexed nodes created");
 STATISTIC(OpsNarrowed     , "Number of load/op/store narrowed");
 STATISTIC(LdStFP2Int      , "Number of fp load/store pairs transformed to int");
 STATISTIC(SlicedLoads, "Number of load sliced");
+STATISTIC(WorkListRequeued, "Number of queued nodes moved to the worklist end");
+STATISTIC(WorkListCompactions, "Number of times the worklist was compacted");
 
 namespace {
   static cl::opt<bool>
@@ -82,18 +85,56 @@ namespace {
     // also only appear once. The naive approach to this takes
     // linear time.
     //
-    // To reduce the insert/remove time to logarithmic, we use
-    // a set and a vector to maintain our worklist.
+    // Instead, the vector holds the nodes in the order they should be
+    // visited, and the map holds the position of each node in the vector.
+    // A node that is added again, or removed, has its old slot cleared
+    // rather than being searched for, so every node is in the vector at most
+    // once and all operations are constant time. The cleared slots are
+    // skipped when popping, and squeezed out once they outnumber the live
+    // entries.
     //
-    // The set contains the items on the worklist, but does not
-    // maintain the order they should be visited.
-    //
-    // The vector maintains the order nodes should be visited, but may
-    // contain duplicate or removed nodes. When choosing a node to
-    // visit, we pop off the order stack until we find an item that is
-    // also in the contents set. All operations are O(log N).
-    SmallPtrSet<SDNode*, 64> WorkListContents;
+    // The visit order is the one the set-based worklist had: the nodes are
+    // seeded in allnodes order and popped from the back. A node that is added
+    // again is visited at its newest position. The set-based worklist pushed
+    // a second copy, which was popped first, and skipped the older copy once
+    // the node had left the set; here the older slot is cleared instead.
+    // Several combines depend on seeing a node before or after its operands,
+    // so seeding the worklist topologically changes the code that is
+    // generated.
     SmallVector<SDNode*, 64> WorkListOrder;
+    DenseMap<SDNode*, unsigned> WorkListMap;
+    unsigned NumWorkListHoles;
+
+    /// compactWorkList - Squeeze the cleared slots out of the worklist,
+    /// keeping the remaining nodes in order.
+    void compactWorkList() {
+      unsigned Next = 0;
+      for (unsigned i = 0, e = WorkListOrder.size(); i != e; ++i) {
+        SDNode *N = WorkListOrder[i];
+        if (!N)
+          continue;
+        WorkListOrder[Next] = N;
+        WorkListMap[N] = Next++;
+      }
+      WorkListOrder.resize(Next);
+      NumWorkListHoles = 0;
+      ++WorkListCompactions;
+    }
+
+    /// getNextWorkListEntry - Pop the next node to visit off the worklist, or
+    /// return null if it is empty.
+    SDNode *getNextWorkListEntry() {
+      while (!WorkListOrder.empty()) {
+        SDNode *N = WorkListOrder.pop_back_val();
+        if (!N) {
+          --NumWorkListHoles;
+          continue;
+        }
+        WorkListMap.erase(N);
+        return N;
+      }
+      return 0;
+    }
 
     // AA - Used for DAG load/store alias analysis.
     AliasAnalysis &AA;
@@ -116,14 +157,32 @@ namespace {
     /// AddToWorkList - Add to the work list making sure its instance is at the
     /// back (next to be processed.)
     void AddToWorkList(SDNode *N) {
-      WorkListContents.insert(N);
+      std::pair<DenseMap<SDNode*, unsigned>::iterator, bool> IP =
+        WorkListMap.insert(std::make_pair(N, WorkListOrder.size()));
+      if (!IP.second) {
+        // Already queued. Nothing to do if it is next anyway.
+        unsigned &Idx = IP.first->second;
+        if (Idx + 1 == WorkListOrder.size())
+          return;
+        WorkListOrder[Idx] = 0;
+        ++NumWorkListHoles;
+        Idx = WorkListOrder.size();
+        ++WorkListRequeued;
+      }
       WorkListOrder.push_back(N);
+      if (NumWorkListHoles > 64 && NumWorkListHoles > WorkListMap.size())
+        compactWorkList();
     }
 
-    /// removeFromWorkList - remove all instances of N from the worklist.
+    /// removeFromWorkList - remove N from the worklist.
     ///
     void removeFromWorkList(SDNode *N) {
-      WorkListContents.erase(N);
+      DenseMap<SDNode*, unsigned>::iterator I = WorkListMap.find(N);
+      if (I == WorkListMap.end())
+        return;
+      WorkListOrder[I->second] = 0;
+      ++NumWorkListHoles;
+      WorkListMap.erase(I);
     }
 
     SDValue CombineTo(SDNode *N, const SDValue *To, unsigned NumTo,
@@ -329,7 +388,8 @@ namespace {
   public:
     DAGCombiner(SelectionDAG &D, AliasAnalysis &A, CodeGenOpt::Level OL)
         : DAG(D), TLI(D.getTargetLoweringInfo()), Level(BeforeLegalizeTypes),
-          OptLevel(OL), LegalOperations(false), LegalTypes(false), AA(A) {
+          OptLevel(OL), LegalOperations(false), LegalTypes(false),
+          NumWorkListHoles(0), AA(A) {
       AttributeSet FnAttrs =
           DAG.getMachineFunction().getFunction()->getAttributes();
       ForCodeSize =
@@ -1032,17 +1092,7 @@ void DAGCombiner::Run(CombineLevel AtLevel) {
 
   // while the worklist isn't empty, find a node and
   // try and combine it.
-  while (!WorkListContents.empty()) {
-    SDNode *N;
-    // The WorkListOrder holds the SDNodes in order, but it may contain
-    // duplicates.
-    // In order to avoid a linear scan, we use a set (O(log N)) to hold what the
-    // worklist *should* contain, and check the node we want to visit is should
-    // actually be visited.
-    do {
-      N = WorkListOrder.pop_back_val();
-    } while (!WorkListContents.erase(N));
-
+  while (SDNode *N = getNextWorkListEntry()) {
     // If N has no uses, it is dead.  Make sure to revisit all N's operands once
     // N is deleted from the DAG, since they too may now be dead or may have a
     // reduced number of uses, allowing other xforms.
@@ -790,9 +790,14 @@ bool FastISel::SelectBitCast(const User *I) {
 
   bool Op0IsKill = hasTrivialKill(I->getOperand(0));
 
-  // First, try to perform the bitcast by inserting a reg-reg copy.
+  // First, try to perform the bitcast by inserting a reg-reg copy. Values of
+  // the same size that live in the same register class, like the vector types
+  // in a target's vector registers, are the same bits there too, as long as
+  // lanes aren't numbered from the other end on big-endian targets.
   unsigned ResultReg = 0;
-  if (SrcVT == DstVT) {
+  if (SrcVT == DstVT ||
+      (SrcVT.getSizeInBits() == DstVT.getSizeInBits() &&
+       (TD.isLittleEndian() || !SrcVT.isVector()))) {
     const TargetRegisterClass* SrcClass = TLI.getRegClassFor(SrcVT);
     const TargetRegisterClass* DstClass = TLI.getRegClassFor(DstVT);
     // Don't attempt a cross-class copy. It will likely fail.
@@ -890,10 +895,11 @@ FastISel::FastEmitBranch(MachineBasicBlock *MSucc, DebugLoc DL) {
 ///
 bool
 FastISel::SelectFNeg(const User *I) {
-  unsigned OpReg = getRegForValue(BinaryOperator::getFNegArgument(I));
+  const Value *Op = BinaryOperator::getFNegArgument(I);
+  unsigned OpReg = getRegForValue(Op);
   if (OpReg == 0) return false;
 
-  bool OpRegIsKill = hasTrivialKill(I);
+  bool OpRegIsKill = hasTrivialKill(Op);
 
   // If the target has ISD::FNEG, use it.
   EVT VT = TLI.getValueType(I->getType());
@@ -626,8 +626,7 @@ void SelectionDAG::DeleteNodeNotInCSEMaps(SDNode *N) {
 }
 
 void SelectionDAG::DeallocateNode(SDNode *N) {
-  if (N->OperandsNeedDelete)
-    delete[] N->OperandList;
+  removeOperands(N);
 
   // Set the opcode to DELETED_NODE to help catch bugs when node
   // memory is reallocated.
@@ -641,6 +640,28 @@ void SelectionDAG::DeallocateNode(SDNode *N) {
     DbgVals[i]->setIsInvalidated();
 }
 
+void SelectionDAG::createOperands(SDNode *N, const SDValue *Ops,
+                                  unsigned NumOps) {
+  assert(!N->OperandsNeedDelete && "Node already has an operand list!");
+  if (NumOps == 0)
+    return;
+  SDUse *OpList = OperandRecycler.allocate(
+    ArrayRecycler<SDUse>::Capacity::get(NumOps), OperandAllocator);
+  N->InitOperands(OpList, Ops, NumOps);
+  N->OperandsNeedDelete = true;
+}
+
+void SelectionDAG::removeOperands(SDNode *N) {
+  if (!N->OperandsNeedDelete)
+    return;
+  // The list may have been shrunk in place by MorphNodeTo, so it is at least
+  // as large as this capacity, which is all the recycler needs.
+  OperandRecycler.deallocate(
+    ArrayRecycler<SDUse>::Capacity::get(N->NumOperands), N->OperandList);
+  N->OperandList = 0;
+  N->OperandsNeedDelete = false;
+}
+
 /// RemoveNodeFromCSEMaps - Take the specified node out of the CSE map that
 /// correspond to it.  This is useful when we're about to delete or repurpose
 /// the node.  We don't want future request for structurally identical nodes
@@ -885,6 +906,7 @@ void SelectionDAG::init(MachineFunction &mf, const TargetTransformInfo *tti) {
 SelectionDAG::~SelectionDAG() {
   assert(!UpdateListeners && "Dangling registered DAGUpdateListeners");
   allnodes_clear();
+  OperandRecycler.clear(OperandAllocator);
   delete DbgInfo;
 }
 
@@ -897,6 +919,7 @@ void SelectionDAG::allnodes_clear() {
 
 void SelectionDAG::clear() {
   allnodes_clear();
+  OperandRecycler.clear(OperandAllocator);
   OperandAllocator.Reset();
   CSEMap.clear();
 
@@ -1400,7 +1423,8 @@ SDValue SelectionDAG::getConvertRndSat(EVT VT, SDLoc dl,
 
   CvtRndSatSDNode *N = new (NodeAllocator) CvtRndSatSDNode(VT, dl.getIROrder(),
                                                            dl.getDebugLoc(),
-                                                           Ops, 5, Code);
+                                                           Code);
+  createOperands(N, Ops, 5);
   CSEMap.InsertNode(N, IP);
   AllNodes.push_back(N);
   return SDValue(N, 0);
@@ -4362,13 +4386,15 @@ SelectionDAG::getMemIntrinsicNode(unsigned Opcode, SDLoc dl, SDVTList VTList,
     }
 
     N = new (NodeAllocator) MemIntrinsicSDNode(Opcode, dl.getIROrder(),
-                                               dl.getDebugLoc(), VTList, Ops,
-                                               NumOps, MemVT, MMO);
+                                               dl.getDebugLoc(), VTList,
+                                               MemVT, MMO);
+    createOperands(N, Ops, NumOps);
     CSEMap.InsertNode(N, IP);
   } else {
     N = new (NodeAllocator) MemIntrinsicSDNode(Opcode, dl.getIROrder(),
-                                               dl.getDebugLoc(), VTList, Ops,
-                                               NumOps, MemVT, MMO);
+                                               dl.getDebugLoc(), VTList,
+                                               MemVT, MMO);
+    createOperands(N, Ops, NumOps);
   }
   AllNodes.push_back(N);
   return SDValue(N, 0);
@@ -4760,11 +4786,13 @@ SDValue SelectionDAG::getNode(unsigned Opcode, SDLoc DL, EVT VT,
       return SDValue(E, 0);
 
     N = new (NodeAllocator) SDNode(Opcode, DL.getIROrder(), DL.getDebugLoc(),
-                                   VTs, Ops, NumOps);
+                                   VTs);
+    createOperands(N, Ops, NumOps);
     CSEMap.InsertNode(N, IP);
   } else {
     N = new (NodeAllocator) SDNode(Opcode, DL.getIROrder(), DL.getDebugLoc(),
-                                   VTs, Ops, NumOps);
+                                   VTs);
+    createOperands(N, Ops, NumOps);
   }
 
   AllNodes.push_back(N);
@@ -4839,7 +4867,8 @@ SDValue SelectionDAG::getNode(unsigned Opcode, SDLoc DL, SDVTList VTList,
                                             Ops[1], Ops[2]);
     } else {
       N = new (NodeAllocator) SDNode(Opcode, DL.getIROrder(), DL.getDebugLoc(),
-                                     VTList, Ops, NumOps);
+                                     VTList);
+      createOperands(N, Ops, NumOps);
     }
     CSEMap.InsertNode(N, IP);
   } else {
@@ -4856,7 +4885,8 @@ SDValue SelectionDAG::getNode(unsigned Opcode, SDLoc DL, SDVTList VTList,
                                             Ops[1], Ops[2]);
     } else {
       N = new (NodeAllocator) SDNode(Opcode, DL.getIROrder(), DL.getDebugLoc(),
-                                     VTList, Ops, NumOps);
+                                     VTList);
+      createOperands(N, Ops, NumOps);
     }
   }
   AllNodes.push_back(N);
@@ -5287,8 +5317,7 @@ SDNode *SelectionDAG::MorphNodeTo(SDNode *N, unsigned Opc,
     // If NumOps is larger than the # of operands we can have in a
     // MachineSDNode, reallocate the operand list.
     if (NumOps > MN->NumOperands || !MN->OperandsNeedDelete) {
-      if (MN->OperandsNeedDelete)
-        delete[] MN->OperandList;
+      removeOperands(MN);
       if (NumOps > array_lengthof(MN->LocalOperands))
         // We're creating a final node that will live unmorphed for the
         // remainder of the current SelectionDAG iteration, so we can allocate
@@ -5304,10 +5333,8 @@ SDNode *SelectionDAG::MorphNodeTo(SDNode *N, unsigned Opc,
     // If NumOps is larger than the # of operands we currently have, reallocate
     // the operand list.
     if (NumOps > N->NumOperands) {
-      if (N->OperandsNeedDelete)
-        delete[] N->OperandList;
-      N->InitOperands(new SDUse[NumOps], Ops, NumOps);
-      N->OperandsNeedDelete = true;
+      removeOperands(N);
+      createOperands(N, Ops, NumOps);
     } else
       N->InitOperands(N->OperandList, Ops, NumOps);
   }
@@ -5989,17 +6016,6 @@ MemSDNode::MemSDNode(unsigned Opc, unsigned Order, DebugLoc dl, SDVTList VTs,
   assert(memvt.getStoreSize() == MMO->getSize() && "Size mismatch!");
 }
 
-MemSDNode::MemSDNode(unsigned Opc, unsigned Order, DebugLoc dl, SDVTList VTs,
-                     const SDValue *Ops, unsigned NumOps, EVT memvt,
-                     MachineMemOperand *mmo)
-   : SDNode(Opc, Order, dl, VTs, Ops, NumOps),
-     MemoryVT(memvt), MMO(mmo) {
-  SubclassData = encodeMemSDNodeFlags(0, ISD::UNINDEXED, MMO->isVolatile(),
-                                      MMO->isNonTemporal(), MMO->isInvariant());
-  assert(isVolatile() == MMO->isVolatile() && "Volatile encoding error!");
-  assert(memvt.getStoreSize() == MMO->getSize() && "Size mismatch!");
-}
-
 /// Profile - Gather unique data for the node.
 ///
 void SDNode::Profile(FoldingSetNodeID &ID) const {
@@ -17,6 +17,7 @@
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/ConstantFolding.h"
@@ -62,6 +63,9 @@
 #include <algorithm>
 using namespace llvm;
 
+STATISTIC(NumHotSwitchCases,
+          "Number of switch cases the profile made tested first");
+
 /// LimitFloatPrecision - Generate low-precision inline sequences for
 /// some float libcalls (6, 8 or 12 bits).
 static unsigned LimitFloatPrecision;
@@ -73,6 +77,12 @@ LimitFPPrecision("limit-float-precision",
                  cl::location(LimitFloatPrecision),
                  cl::init(0));
 
+static cl::opt<unsigned>
+SwitchHotCasePercent("switch-hot-case-percent", cl::Hidden, cl::init(60),
+                     cl::desc("With profile data, test a switch case on its "
+                              "own first if it takes at least this percentage "
+                              "of the executions"));
+
 // Limit the width of DAG chains. This is important in general to prevent
 // prevent DAG-based analysis from blowing up. For example, alias analysis and
 // load clustering may not complete in reasonable time. It is difficult to
@@ -2664,9 +2674,48 @@ void SelectionDAGBuilder::visitSwitch(const SwitchInst &SI) {
   // search tree.
   const Value *SV = SI.getCondition();
 
+  // When the profile shows that one case takes most of the executions, test
+  // it on its own before the jump table or search tree of the other cases.
+  // Small switches are already tested in order of weight.
+  MachineBasicBlock *CasesMBB = SwitchMBB;
+  BranchProbabilityInfo *BPI = FuncInfo.BPI;
+  if (BPI && Cases.size() > 3 && SI.getMetadata(LLVMContext::MD_prof)) {
+    uint64_t TotalWeight = BPI->getEdgeWeight(SI.getParent(), (unsigned)0);
+    CaseItr Hot = Cases.begin();
+    for (CaseItr I = Cases.begin(), E = Cases.end(); I != E; ++I) {
+      TotalWeight += I->ExtraWeight;
+      if (I->ExtraWeight > Hot->ExtraWeight)
+        Hot = I;
+    }
+
+    uint64_t HotWeight = Hot->ExtraWeight;
+    if (HotWeight * 100 >= TotalWeight * SwitchHotCasePercent) {
+      Case HotCase = *Hot;
+      Cases.erase(Hot);
+
+      CasesMBB = FuncInfo.MF->CreateMachineBasicBlock(SI.getParent());
+      FuncInfo.MF->insert(llvm::next(MachineFunction::iterator(SwitchMBB)),
+                          CasesMBB);
+      ExportFromCurrentBlock(SV);
+
+      const Value *LHS = SV, *MHS = NULL, *RHS = HotCase.High;
+      ISD::CondCode CC = ISD::SETEQ;
+      if (HotCase.Low != HotCase.High) {
+        CC = ISD::SETLE;
+        LHS = HotCase.Low; MHS = SV;
+      }
+      uint64_t RestWeight = TotalWeight - HotWeight;
+      CaseBlock CB(CC, LHS, RHS, MHS, HotCase.BB, CasesMBB, SwitchMBB,
+                   HotCase.ExtraWeight,
+                   (uint32_t)std::min<uint64_t>(RestWeight, UINT32_MAX));
+      visitSwitchCase(CB, SwitchMBB);
+      ++NumHotSwitchCases;
+    }
+  }
+
   // Push the initial CaseRec onto the worklist
   CaseRecVector WorkList;
-  WorkList.push_back(CaseRec(SwitchMBB,0,0,
+  WorkList.push_back(CaseRec(CasesMBB,0,0,
                              CaseRange(Cases.begin(),Cases.end())));
 
   while (!WorkList.empty()) {
@@ -3493,6 +3542,66 @@ void SelectionDAGBuilder::visitStore(const StoreInst &I) {
   DAG.setRoot(StoreNode);
 }
 
+/// visitMaskedLoad - Lower a llvm.masked.load to an INTRINSIC_W_CHAIN memory
+/// node that targets custom lower. The i1 mask is sign extended to the width
+/// of the data elements, which is the form vector compares produce it in.
+void SelectionDAGBuilder::visitMaskedLoad(const CallInst &I) {
+  SDLoc sdl = getCurSDLoc();
+  const TargetLowering *TLI = TM.getTargetLowering();
+  const Value *PtrOperand = I.getArgOperand(0);
+  SDValue Ptr = getValue(PtrOperand);
+  unsigned Alignment = cast<ConstantInt>(I.getArgOperand(1))->getZExtValue();
+  SDValue Mask = getValue(I.getArgOperand(2));
+  SDValue Src0 = getValue(I.getArgOperand(3));
+
+  EVT VT = Src0.getValueType();
+  EVT MaskVT = VT.changeVectorElementTypeToInteger();
+  Mask = DAG.getNode(ISD::SIGN_EXTEND, sdl, MaskVT, Mask);
+
+  SDValue Ops[] = {
+    DAG.getRoot(),
+    DAG.getTargetConstant(Intrinsic::masked_load, TLI->getPointerTy()),
+    Ptr, Mask, Src0
+  };
+  SDVTList VTs = DAG.getVTList(VT, MVT::Other);
+  SDValue Load = DAG.getMemIntrinsicNode(ISD::INTRINSIC_W_CHAIN, sdl, VTs,
+                                         Ops, array_lengthof(Ops), VT,
+                                         MachinePointerInfo(PtrOperand),
+                                         Alignment, /*Vol=*/false,
+                                         /*ReadMem=*/true, /*WriteMem=*/false);
+  PendingLoads.push_back(Load.getValue(1));
+  setValue(&I, Load);
+}
+
+/// visitMaskedStore - Lower a llvm.masked.store to an INTRINSIC_VOID memory
+/// node, see visitMaskedLoad.
+void SelectionDAGBuilder::visitMaskedStore(const CallInst &I) {
+  SDLoc sdl = getCurSDLoc();
+  const TargetLowering *TLI = TM.getTargetLowering();
+  SDValue Src0 = getValue(I.getArgOperand(0));
+  const Value *PtrOperand = I.getArgOperand(1);
+  SDValue Ptr = getValue(PtrOperand);
+  unsigned Alignment = cast<ConstantInt>(I.getArgOperand(2))->getZExtValue();
+  SDValue Mask = getValue(I.getArgOperand(3));
+
+  EVT VT = Src0.getValueType();
+  EVT MaskVT = VT.changeVectorElementTypeToInteger();
+  Mask = DAG.getNode(ISD::SIGN_EXTEND, sdl, MaskVT, Mask);
+
+  SDValue Ops[] = {
+    getRoot(),
+    DAG.getTargetConstant(Intrinsic::masked_store, TLI->getPointerTy()),
+    Src0, Ptr, Mask
+  };
+  SDValue Store = DAG.getMemIntrinsicNode(ISD::INTRINSIC_VOID, sdl,
+                                          DAG.getVTList(MVT::Other),
+                                          Ops, array_lengthof(Ops), VT,
+                                          MachinePointerInfo(PtrOperand),
+                                          Alignment, /*Vol=*/false,
+                                          /*ReadMem=*/true, /*WriteMem=*/true);
+  DAG.setRoot(Store);
+}
+
 static SDValue InsertFenceForAtomic(SDValue Chain, AtomicOrdering Order,
                                     SynchronizationScope Scope,
                                     bool Before, SDLoc dl,
@@ -5258,6 +5367,12 @@ SelectionDAGBuilder::visitIntrinsicCall(const CallInst &I, unsigned Intrinsic) {
                                         rw==1)); /* write */
     return 0;
   }
+  case Intrinsic::masked_load:
+    visitMaskedLoad(I);
+    return 0;
+  case Intrinsic::masked_store:
+    visitMaskedStore(I);
+    return 0;
   case Intrinsic::lifetime_start:
   case Intrinsic::lifetime_end: {
     bool IsStart = (Intrinsic == Intrinsic::lifetime_start);
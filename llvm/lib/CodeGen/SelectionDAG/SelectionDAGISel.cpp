@@ -15,8 +15,10 @@
 #include "llvm/CodeGen/SelectionDAGISel.h"
 #include "ScheduleDAGSDNodes.h"
 #include "SelectionDAGBuilder.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/PostOrderIterator.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
 #include "llvm/Analysis/CFG.h"
@@ -45,6 +47,7 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetInstrInfo.h"
@@ -155,6 +158,10 @@ static cl::opt<bool>
 EnableFastISelAbortArgs("fast-isel-abort-args", cl::Hidden,
           cl::desc("Enable abort calls when \"fast\" instruction selection "
                    "fails to lower a formal argument"));
+static cl::opt<bool>
+EnableFastISelReport("fast-isel-report", cl::Hidden,
+          cl::desc("Print a summary of the instructions the \"fast\" "
+                   "instruction selector left to SelectionDAG"));
 
 static cl::opt<bool>
 UseMBPI("use-mbpi",
@@ -276,6 +283,94 @@ void TargetLowering::AdjustInstrPostInstrSelection(MachineInstr *MI,
 // SelectionDAGISel code
 //===----------------------------------------------------------------------===//
 
+// CreateInfoOutputFile - Return a file stream to print our output on.
+namespace llvm { extern raw_ostream *CreateInfoOutputFile(); }
+
+namespace llvm {
+/// FastISelReport - Counts, for each kind of instruction FastISel fails on,
+/// how often it failed and how many instructions SelectionDAG had to select
+/// as a result: the instruction itself for calls, and the rest of the block
+/// above it otherwise.
+class FastISelReport {
+  struct MissInfo {
+    unsigned Misses;
+    unsigned DAGInsts;
+    MissInfo() : Misses(0), DAGInsts(0) {}
+  };
+  StringMap<MissInfo> Misses;
+
+  static bool compareMisses(const StringMapEntry<MissInfo> *LHS,
+                            const StringMapEntry<MissInfo> *RHS) {
+    if (LHS->getValue().DAGInsts != RHS->getValue().DAGInsts)
+      return LHS->getValue().DAGInsts > RHS->getValue().DAGInsts;
+    if (LHS->getValue().Misses != RHS->getValue().Misses)
+      return LHS->getValue().Misses > RHS->getValue().Misses;
+    return LHS->getKey() < RHS->getKey();
+  }
+
+public:
+  unsigned NumSelected;
+  unsigned NumFastISelBlocks;
+  unsigned NumDAGBlocks;
+
+  FastISelReport() : NumSelected(0), NumFastISelBlocks(0), NumDAGBlocks(0) {}
+
+  /// addMiss - Record that FastISel failed on I, and that SelectionDAG
+  /// selected NumDAGInsts instructions because of it.
+  void addMiss(const Instruction *I, unsigned NumDAGInsts) {
+    std::string Key = I->getOpcodeName();
+    // Calls are broken down by what they call, since that is what decides
+    // whether they can be selected.
+    if (const CallInst *CI = dyn_cast<CallInst>(I)) {
+      if (isa<InlineAsm>(CI->getCalledValue()))
+        Key += " asm";
+      else if (const Function *F = CI->getCalledFunction()) {
+        if (F->isIntrinsic())
+          Key += " @" + F->getName().str();
+      } else
+        Key += " indirect";
+    }
+    addMiss(Key, NumDAGInsts);
+  }
+
+  void addMiss(StringRef Key, unsigned NumDAGInsts) {
+    MissInfo &Info = Misses[Key];
+    ++Info.Misses;
+    Info.DAGInsts += NumDAGInsts;
+  }
+
+  void print(raw_ostream &OS) const {
+    unsigned NumDAGInsts = 0;
+    std::vector<const StringMapEntry<MissInfo> *> Sorted;
+    for (StringMap<MissInfo>::const_iterator I = Misses.begin(),
+         E = Misses.end(); I != E; ++I) {
+      Sorted.push_back(&*I);
+      NumDAGInsts += I->getValue().DAGInsts;
+    }
+    std::sort(Sorted.begin(), Sorted.end(), compareMisses);
+
+    OS << "===" << std::string(73, '-') << "===\n"
+       << "                           FastISel fallback report\n"
+       << "===" << std::string(73, '-') << "===\n\n";
+    unsigned Total = NumSelected + NumDAGInsts;
+    OS << format("%8u", NumSelected) << " instructions selected by FastISel\n"
+       << format("%8u", NumDAGInsts) << " instructions left to SelectionDAG ("
+       << format("%.1f", Total ? 100.0 * NumDAGInsts / Total : 0.0)
+       << "%)\n"
+       << format("%8u", NumFastISelBlocks)
+       << " blocks selected entirely by FastISel\n"
+       << format("%8u", NumDAGBlocks) << " blocks selected using SelectionDAG\n";
+    if (Sorted.empty())
+      return;
+    OS << "\n  Misses  DAG insts  Instruction\n";
+    for (unsigned i = 0, e = Sorted.size(); i != e; ++i)
+      OS << format("%8u", Sorted[i]->getValue().Misses)
+         << format("%11u", Sorted[i]->getValue().DAGInsts) << "  "
+         << Sorted[i]->getKey() << '\n';
+  }
+};
+}
+
 SelectionDAGISel::SelectionDAGISel(TargetMachine &tm,
                                    CodeGenOpt::Level OL) :
   MachineFunctionPass(ID), TM(tm),
@@ -284,7 +379,7 @@ SelectionDAGISel::SelectionDAGISel(TargetMachine &tm,
   SDB(new SelectionDAGBuilder(*CurDAG, *FuncInfo, OL)),
   GFI(),
   OptLevel(OL),
-  DAGSize(0) {
+  DAGSize(0), FastISReport(0) {
     initializeGCModuleInfoPass(*PassRegistry::getPassRegistry());
     initializeAliasAnalysisAnalysisGroup(*PassRegistry::getPassRegistry());
     initializeBranchProbabilityInfoPass(*PassRegistry::getPassRegistry());
@@ -295,6 +390,17 @@ SelectionDAGISel::~SelectionDAGISel() {
   delete SDB;
   delete CurDAG;
   delete FuncInfo;
+  delete FastISReport;
+}
+
+bool SelectionDAGISel::doFinalization(Module &M) {
+  if (FastISReport) {
+    OwningPtr<raw_ostream> OS(CreateInfoOutputFile());
+    FastISReport->print(*OS);
+    delete FastISReport;
+    FastISReport = 0;
+  }
+  return MachineFunctionPass::doFinalization(M);
 }
 
 void SelectionDAGISel::getAnalysisUsage(AnalysisUsage &AU) const {
@@ -347,6 +453,11 @@ static void SplitCriticalSideEffectEdges(Function &Fn, Pass *SDISel) {
 }
 
 bool SelectionDAGISel::runOnMachineFunction(MachineFunction &mf) {
+  // Functions selected by the global instruction selector already have their
+  // machine code.
+  if (!mf.empty())
+    return false;
+
   // Do some sanity-checking on the command-line options.
   assert((!EnableFastISelVerbose || TM.Options.EnableFastISel) &&
          "-fast-isel-verbose requires -fast-isel");
@@ -946,6 +1057,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
   FastISel *FastIS = 0;
   if (TM.Options.EnableFastISel)
     FastIS = getTargetLowering()->createFastISel(*FuncInfo, LibInfo);
+  if (FastIS && EnableFastISelReport && !FastISReport)
+    FastISReport = new FastISelReport();
 
   // Iterate over all basic blocks in the function.
   ReversePostOrderTraversal<const Function*> RPOT(&Fn);
@@ -979,6 +1092,7 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
     BasicBlock::const_iterator const Begin = LLVMBB->getFirstNonPHI();
     BasicBlock::const_iterator const End = LLVMBB->end();
     BasicBlock::const_iterator BI = End;
+    bool SelectedCallsWithDAG = false;
 
     FuncInfo->MBB = FuncInfo->MBBMap[LLVMBB];
     FuncInfo->InsertPt = FuncInfo->MBB->getFirstNonPHI();
@@ -1002,6 +1116,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (!FastIS->LowerArguments()) {
           // Fast isel failed to lower these arguments
           ++NumFastIselFailLowerArguments;
+          if (FastISReport)
+            FastISReport->addMiss("arguments", 0);
           if (EnableFastISelAbortArgs)
             llvm_unreachable("FastISel didn't lower all arguments");
 
@@ -1040,6 +1156,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
         if (FastIS->SelectInstruction(Inst)) {
           --NumFastIselRemaining;
           ++NumFastIselSuccess;
+          if (FastISReport)
+            ++FastISReport->NumSelected;
           // If fast isel succeeded, skip over all the folded instructions, and
           // then see if there is a load right before the selected instructions.
           // Try to fold the load if so.
@@ -1056,6 +1174,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
             BI = llvm::next(BasicBlock::const_iterator(BeforeInst));
             --NumFastIselRemaining;
             ++NumFastIselSuccess;
+            if (FastISReport)
+              ++FastISReport->NumSelected;
           }
           continue;
         }
@@ -1086,6 +1206,8 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
           // If the call was emitted as a tail call, we're done with the block.
           // We also need to delete any previously emitted instructions.
           if (HadTailCall) {
+            if (FastISReport)
+              FastISReport->addMiss(Inst, NumFastIselRemaining);
             FastIS->removeDeadCode(SavedInsertPt, FuncInfo->MBB->end());
             --BI;
             break;
@@ -1093,12 +1215,18 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
 
           // Recompute NumFastIselRemaining as Selection DAG instruction
           // selection may have handled the call, input args, etc.
-          unsigned RemainingNow = std::distance(Begin, BI);
+          unsigned RemainingNow = std::distance(Begin, BI) - 1;
+          SelectedCallsWithDAG = true;
           NumFastIselFailures += NumFastIselRemaining - RemainingNow;
+          if (FastISReport)
+            FastISReport->addMiss(Inst, NumFastIselRemaining - RemainingNow);
           NumFastIselRemaining = RemainingNow;
           continue;
         }
 
+        if (FastISReport)
+          FastISReport->addMiss(Inst, NumFastIselRemaining);
+
         if (isa<TerminatorInst>(Inst) && !isa<BranchInst>(Inst)) {
           // Don't abort, and use a different message for terminator misses.
           NumFastIselFailures += NumFastIselRemaining;
@@ -1133,6 +1261,9 @@ void SelectionDAGISel::SelectAllBasicBlocks(const Function &Fn) {
       ++NumDAGBlocks;
     else
       ++NumFastIselBlocks;
+    if (FastISReport)
+      ++(Begin != BI || SelectedCallsWithDAG ? FastISReport->NumDAGBlocks
+                                             : FastISReport->NumFastISelBlocks);
 
     if (Begin != BI) {
       // Run SelectionDAG instruction selection on the remainder of the block
@@ -236,6 +236,18 @@ const DWARFDebugAranges *DWARFContext::getDebugAranges() {
   return Aranges.get();
 }
 
+void DWARFContext::writeAddressIndex(raw_ostream &OS, uint64_t Key) {
+  getDebugAranges()->writeIndex(OS, Key, getInfoSection().Data.size());
+}
+
+bool DWARFContext::readAddressIndex(StringRef Buffer, uint64_t Key) {
+  OwningPtr<DWARFDebugAranges> Index(new DWARFDebugAranges());
+  if (!Index->readIndex(Buffer, Key, getInfoSection().Data.size()))
+    return false;
+  Aranges.swap(Index);
+  return true;
+}
+
 const DWARFDebugFrame *DWARFContext::getDebugFrame() {
   if (DebugFrame)
     return DebugFrame.get();
@@ -39,6 +39,8 @@ class DWARFContext : public DIContext {
   SmallVector<DWARFCompileUnit *, 1> DWOCUs;
   OwningPtr<DWARFDebugAbbrev> AbbrevDWO;
 
+  unsigned NumThreads;
+
   DWARFContext(DWARFContext &) LLVM_DELETED_FUNCTION;
   DWARFContext &operator=(DWARFContext &) LLVM_DELETED_FUNCTION;
 
@@ -58,7 +60,7 @@ public:
     RelocAddrMap Relocs;
   };
 
-  DWARFContext() : DIContext(CK_DWARF) {}
+  DWARFContext() : DIContext(CK_DWARF), NumThreads(0) {}
   virtual ~DWARFContext();
 
   static bool classof(const DIContext *DICtx) {
@@ -121,6 +123,11 @@ public:
   /// Get a pointer to the parsed DebugAranges object.
   const DWARFDebugAranges *getDebugAranges();
 
+  unsigned getNumThreads() const { return NumThreads; }
+  virtual void setNumThreads(unsigned N) { NumThreads = N; }
+  virtual void writeAddressIndex(raw_ostream &OS, uint64_t Key);
+  virtual bool readAddressIndex(StringRef Buffer, uint64_t Key);
+
   /// Get a pointer to the parsed frame information object.
   const DWARFDebugFrame *getDebugFrame();
 
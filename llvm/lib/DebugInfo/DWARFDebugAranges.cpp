@@ -10,10 +10,13 @@
 #include "DWARFDebugAranges.h"
 #include "DWARFCompileUnit.h"
 #include "DWARFContext.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 using namespace llvm;
 
 void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
@@ -36,6 +39,8 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   for (RangeSetColl::const_iterator I = Sets.begin(), E = Sets.end(); I != E;
        ++I) {
     uint32_t CUOffset = I->getCompileUnitDIEOffset();
+    // There is no need to walk the DIEs of the units described here.
+    ParsedCUOffsets.insert(CUOffset);
 
     for (uint32_t i = 0, n = I->getNumDescriptors(); i < n; ++i) {
       const DWARFDebugArangeSet::Descriptor *ArangeDescPtr =
@@ -47,6 +52,19 @@ void DWARFDebugAranges::extract(DataExtractor DebugArangesData) {
   }
 }
 
+namespace {
+/// UnitRanges - The ranges of one compile unit, built from its DIEs by a task.
+struct UnitRanges {
+  DWARFCompileUnit *CU;
+  DWARFDebugAranges Ranges;
+
+  static void build(void *Arg) {
+    UnitRanges &U = *static_cast<UnitRanges *>(Arg);
+    U.CU->buildAddressRangeTable(&U.Ranges, true, U.CU->getOffset());
+  }
+};
+}
+
 void DWARFDebugAranges::generate(DWARFContext *CTX) {
   clear();
   if (!CTX)
@@ -59,14 +77,35 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
+  std::vector<UnitRanges> Units;
   for (uint32_t i = 0, n = CTX->getNumCompileUnits(); i < n; ++i) {
     if (DWARFCompileUnit *CU = CTX->getCompileUnitAtIndex(i)) {
-      uint32_t CUOffset = CU->getOffset();
-      if (ParsedCUOffsets.insert(CUOffset).second)
-        CU->buildAddressRangeTable(this, true, CUOffset);
+      if (ParsedCUOffsets.insert(CU->getOffset()).second) {
+        Units.push_back(UnitRanges());
+        Units.back().CU = CU;
+      }
     }
   }
 
+  // Each unit only extracts its own DIEs, so the units can be walked
+  // concurrently.  Their ranges are appended in unit order, as the serial
+  // walk would append them.
+  unsigned NumThreads = CTX->getNumThreads();
+  if (NumThreads > 1 && Units.size() > 1) {
+    ThreadPool Pool(NumThreads);
+    TaskGroup Tasks(Pool);
+    for (unsigned i = 0, e = Units.size(); i != e; ++i)
+      Tasks.spawn(UnitRanges::build, &Units[i]);
+    Tasks.wait();
+  } else {
+    for (unsigned i = 0, e = Units.size(); i != e; ++i)
+      UnitRanges::build(&Units[i]);
+  }
+  for (unsigned i = 0, e = Units.size(); i != e; ++i) {
+    const RangeColl &UnitAranges = Units[i].Ranges.Aranges;
+    Aranges.insert(Aranges.end(), UnitAranges.begin(), UnitAranges.end());
+  }
+
   sortAndMinimize();
 }
 
@@ -150,3 +189,71 @@ uint32_t DWARFDebugAranges::findAddress(uint64_t Address) const {
   }
   return -1U;
 }
+
+// The index written by writeIndex is a header followed by the ranges, sorted
+// by address.  All fields are little-endian.
+namespace {
+struct IndexHeader {
+  char Magic[8];
+  support::ulittle32_t Version;
+  support::ulittle32_t NumRanges;
+  support::ulittle64_t Key;
+  support::ulittle64_t InfoSize;
+};
+
+struct IndexRange {
+  support::ulittle64_t LowPC;
+  support::ulittle32_t Length;
+  support::ulittle32_t CUOffset;
+};
+}
+
+static const char IndexMagic[8] = { 'L', 'L', 'V', 'M', 'A', 'R', 'N', 'G' };
+static const uint32_t IndexVersion = 1;
+
+void DWARFDebugAranges::writeIndex(raw_ostream &OS, uint64_t Key,
+                                   uint64_t InfoSize) const {
+  IndexHeader Header;
+  memcpy(Header.Magic, IndexMagic, sizeof(IndexMagic));
+  Header.Version = IndexVersion;
+  Header.NumRanges = Aranges.size();
+  Header.Key = Key;
+  Header.InfoSize = InfoSize;
+  OS.write(reinterpret_cast<const char *>(&Header), sizeof(Header));
+
+  for (RangeCollIterator I = Aranges.begin(), E = Aranges.end(); I != E; ++I) {
+    IndexRange R;
+    R.LowPC = I->LowPC;
+    R.Length = I->Length;
+    R.CUOffset = I->CUOffset;
+    OS.write(reinterpret_cast<const char *>(&R), sizeof(R));
+  }
+}
+
+bool DWARFDebugAranges::readIndex(StringRef Buffer, uint64_t Key,
+                                  uint64_t InfoSize) {
+  if (Buffer.size() < sizeof(IndexHeader))
+    return false;
+  const IndexHeader *Header =
+      reinterpret_cast<const IndexHeader *>(Buffer.data());
+  if (memcmp(Header->Magic, IndexMagic, sizeof(IndexMagic)) != 0 ||
+      Header->Version != IndexVersion || Header->Key != Key ||
+      Header->InfoSize != InfoSize)
+    return false;
+  uint32_t NumRanges = Header->NumRanges;
+  if ((Buffer.size() - sizeof(IndexHeader)) / sizeof(IndexRange) != NumRanges)
+    return false;
+
+  const IndexRange *Ranges =
+      reinterpret_cast<const IndexRange *>(Buffer.data() + sizeof(IndexHeader));
+  clear();
+  Aranges.reserve(NumRanges);
+  for (uint32_t i = 0; i != NumRanges; ++i) {
+    Range R;
+    R.LowPC = Ranges[i].LowPC;
+    R.Length = Ranges[i].Length;
+    R.CUOffset = Ranges[i].CUOffset;
+    Aranges.push_back(R);
+  }
+  return true;
+}
@@ -17,6 +17,7 @@
 namespace llvm {
 
 class DWARFContext;
+class raw_ostream;
 
 class DWARFDebugAranges {
 public:
@@ -25,6 +26,9 @@ public:
     ParsedCUOffsets.clear();
   }
 
+  /// generate - Build the ranges from .debug_aranges and, for the compile
+  /// units it does not describe, from their DIEs.  The DIEs are walked on
+  /// CTX->getNumThreads() threads if that is more than one.
   void generate(DWARFContext *CTX);
 
   // Use appendRange multiple times and then call sortAndMinimize.
@@ -32,6 +36,15 @@ public:
 
   uint32_t findAddress(uint64_t Address) const;
 
+  /// writeIndex - Write the generated ranges to OS.  Key and InfoSize, the
+  /// size of the .debug_info section, identify the debug info they are for.
+  void writeIndex(raw_ostream &OS, uint64_t Key, uint64_t InfoSize) const;
+
+  /// readIndex - Replace the ranges with those of an index written by
+  /// writeIndex with the same Key and InfoSize.  Returns false, leaving the
+  /// ranges unchanged, if Buffer does not hold such an index.
+  bool readIndex(StringRef Buffer, uint64_t Key, uint64_t InfoSize);
+
 private:
   void extract(DataExtractor DebugArangesData);
   void sortAndMinimize();
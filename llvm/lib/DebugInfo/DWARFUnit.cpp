@@ -308,6 +308,18 @@ DWARFUnit::buildAddressRangeTable(DWARFDebugAranges *debug_aranges,
   // all compile units to stay loaded when they weren't needed. So we can end
   // up parsing the DWARF and then throwing them all away to keep memory usage
   // down.
+  //
+  // If the compile unit DIE itself carries a contiguous address range, that
+  // range covers all of the unit's code, so only the compile unit DIE needs
+  // to be extracted.
+  extractDIEsIfNeeded(true);
+  if (DieArray.empty())
+    return;
+  uint64_t LowPC, HighPC;
+  if (DieArray[0].getLowAndHighPC(this, LowPC, HighPC)) {
+    debug_aranges->appendRange(CUOffsetInAranges, LowPC, HighPC);
+    return;
+  }
   const bool clear_dies = extractDIEsIfNeeded(false) > 1 &&
                           clear_dies_if_already_not_parsed;
   DieArray[0].buildAddressRangeTable(this, debug_aranges, CUOffsetInAranges);
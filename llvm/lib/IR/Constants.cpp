@@ -474,19 +474,24 @@ Constant *ConstantInt::getFalse(Type *Ty) {
 }
 
 
-// Get a ConstantInt from an APInt. Note that the value stored in the DenseMap 
-// as the key, is a DenseMapAPIntKeyInfo::KeyTy which has provided the
-// operator== and operator!= to ensure that the DenseMap doesn't attempt to
-// compare APInt's of different widths, which would violate an APInt class
-// invariant which generates an assertion.
+// Get a ConstantInt from an APInt. Note that the key the table is searched
+// with is a ConstantIntKeyInfo::KeyTy which has provided the operator== and
+// operator!= to ensure that the table doesn't attempt to compare APInt's of
+// different widths, which would violate an APInt class invariant which
+// generates an assertion.
 ConstantInt *ConstantInt::get(LLVMContext &Context, const APInt &V) {
   // Get the corresponding integer type for the bit width of the value.
   IntegerType *ITy = IntegerType::get(Context, V.getBitWidth());
-  // get an existing value or the insertion position
+  // get an existing value or create one
   LLVMContextImpl *pImpl = Context.pImpl;
-  ConstantInt *&Slot = pImpl->IntConstants[DenseMapAPIntKeyInfo::KeyTy(V, ITy)];
-  if (!Slot) Slot = new ConstantInt(ITy, V);
-  return Slot;
+  ConstantIntKeyInfo::KeyTy Key(V, ITy);
+  unsigned Hash = ConstantIntKeyInfo::getHashValue(Key);
+  ConstantInt *CI = pImpl->IntConstants.find(Key, Hash);
+  if (!CI) {
+    CI = new ConstantInt(ITy, V);
+    pImpl->IntConstants.insert(CI, Hash);
+  }
+  return CI;
 }
 
 Constant *ConstantInt::get(Type *Ty, uint64_t V, bool isSigned) {
@@ -610,9 +615,11 @@ Constant *ConstantFP::getZeroValueForNegation(Type *Ty) {
 ConstantFP* ConstantFP::get(LLVMContext &Context, const APFloat& V) {
   LLVMContextImpl* pImpl = Context.pImpl;
 
-  ConstantFP *&Slot = pImpl->FPConstants[DenseMapAPFloatKeyInfo::KeyTy(V)];
+  ConstantFPKeyInfo::KeyTy Key(V);
+  unsigned Hash = ConstantFPKeyInfo::getHashValue(Key);
+  ConstantFP *CFP = pImpl->FPConstants.find(Key, Hash);
 
-  if (!Slot) {
+  if (!CFP) {
     Type *Ty;
     if (&V.getSemantics() == &APFloat::IEEEhalf)
       Ty = Type::getHalfTy(Context);
@@ -629,10 +636,11 @@ ConstantFP* ConstantFP::get(LLVMContext &Context, const APFloat& V) {
              "Unknown FP format");
       Ty = Type::getPPC_FP128Ty(Context);
     }
-    Slot = new ConstantFP(Ty, V);
+    CFP = new ConstantFP(Ty, V);
+    pImpl->FPConstants.insert(CFP, Hash);
   }
 
-  return Slot;
+  return CFP;
 }
 
 ConstantFP *ConstantFP::getInfinity(Type *Ty, bool Negative) {
@@ -2579,11 +2587,8 @@ void ConstantArray::replaceUsesOfWithOnConstant(Value *From, Value *To,
   } else {
     // Check to see if we have this array type already.
     Lookup.second = makeArrayRef(Values);
-    LLVMContextImpl::ArrayConstantsTy::MapTy::iterator I =
-      pImpl->ArrayConstants.find(Lookup);
-
-    if (I != pImpl->ArrayConstants.map_end()) {
-      Replacement = I->first;
+    if (Constant *C = pImpl->ArrayConstants.find(Lookup)) {
+      Replacement = C;
     } else {
       // Okay, the new shape doesn't exist in the system yet.  Instead of
       // creating a new constant array, inserting it, replaceallusesof'ing the
@@ -2665,11 +2670,8 @@ void ConstantStruct::replaceUsesOfWithOnConstant(Value *From, Value *To,
   } else {
     // Check to see if we have this struct type already.
     Lookup.second = makeArrayRef(Values);
-    LLVMContextImpl::StructConstantsTy::MapTy::iterator I =
-      pImpl->StructConstants.find(Lookup);
-
-    if (I != pImpl->StructConstants.map_end()) {
-      Replacement = I->first;
+    if (Constant *C = pImpl->StructConstants.find(Lookup)) {
+      Replacement = C;
     } else {
       // Okay, the new shape doesn't exist in the system yet.  Instead of
       // creating a new constant struct, inserting it, replaceallusesof'ing the
@@ -15,6 +15,7 @@
 #ifndef LLVM_CONSTANTSCONTEXT_H
 #define LLVM_CONSTANTSCONTEXT_H
 
+#include "UniqueTable.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/Hashing.h"
 #include "llvm/IR/InlineAsm.h"
@@ -654,15 +655,6 @@ public:
   typedef std::pair<TypeClass*, Operands> LookupKey;
 private:
   struct MapInfo {
-    typedef DenseMapInfo<ConstantClass*> ConstantClassInfo;
-    typedef DenseMapInfo<Constant*> ConstantInfo;
-    typedef DenseMapInfo<TypeClass*> TypeClassInfo;
-    static inline ConstantClass* getEmptyKey() {
-      return ConstantClassInfo::getEmptyKey();
-    }
-    static inline ConstantClass* getTombstoneKey() {
-      return ConstantClassInfo::getTombstoneKey();
-    }
     static unsigned getHashValue(const ConstantClass *CP) {
       SmallVector<Constant*, 8> CPOperands;
       CPOperands.reserve(CP->getNumOperands());
@@ -670,16 +662,11 @@ private:
         CPOperands.push_back(CP->getOperand(I));
       return getHashValue(LookupKey(CP->getType(), CPOperands));
     }
-    static bool isEqual(const ConstantClass *LHS, const ConstantClass *RHS) {
-      return LHS == RHS;
-    }
     static unsigned getHashValue(const LookupKey &Val) {
       return hash_combine(Val.first, hash_combine_range(Val.second.begin(),
                                                         Val.second.end()));
     }
     static bool isEqual(const LookupKey &LHS, const ConstantClass *RHS) {
-      if (RHS == getEmptyKey() || RHS == getTombstoneKey())
-        return false;
       if (LHS.first != RHS->getType()
           || LHS.second.size() != RHS->getNumOperands())
         return false;
@@ -691,7 +678,7 @@ private:
     }
   };
 public:
-  typedef DenseMap<ConstantClass *, char, MapInfo> MapTy;
+  typedef UniqueTable<ConstantClass, MapInfo> MapTy;
 
 private:
   /// Map - This is the main map from the element descriptor to the Constants.
@@ -707,61 +694,43 @@ public:
     for (typename MapTy::iterator I=Map.begin(), E=Map.end();
          I != E; ++I) {
       // Asserts that use_empty().
-      delete I->first;
+      delete *I;
     }
   }
 
-private:
-  typename MapTy::iterator findExistingElement(ConstantClass *CP) {
-    return Map.find(CP);
-  }
-
-  ConstantClass *Create(TypeClass *Ty, Operands V, typename MapTy::iterator I) {
-    ConstantClass* Result =
-      ConstantArrayCreator<ConstantClass,TypeClass>::create(Ty, V);
-
-    assert(Result->getType() == Ty && "Type specified is not correct!");
-    Map[Result] = '\0';
-
-    return Result;
-  }
-public:
-
   /// getOrCreate - Return the specified constant from the map, creating it if
   /// necessary.
   ConstantClass *getOrCreate(TypeClass *Ty, Operands V) {
     LookupKey Lookup(Ty, V);
-    ConstantClass* Result = 0;
+    unsigned Hash = MapInfo::getHashValue(Lookup);
 
-    typename MapTy::iterator I = Map.find_as(Lookup);
     // Is it in the map?
-    if (I != Map.end())
-      Result = I->first;
-
-    if (!Result) {
-      // If no preexisting value, create one now...
-      Result = Create(Ty, V, I);
-    }
+    if (ConstantClass *Result = Map.find(Lookup, Hash))
+      return Result;
 
+    // If no preexisting value, create one now...
+    ConstantClass *Result =
+      ConstantArrayCreator<ConstantClass,TypeClass>::create(Ty, V);
+    assert(Result->getType() == Ty && "Type specified is not correct!");
+    Map.insert(Result, Hash);
     return Result;
   }
 
-  /// Find the constant by lookup key.
-  typename MapTy::iterator find(LookupKey Lookup) {
-    return Map.find_as(Lookup);
+  /// Find the constant by lookup key, or return null if there is none.
+  ConstantClass *find(const LookupKey &Lookup) {
+    return Map.find(Lookup);
   }
 
   /// Insert the constant into its proper slot.
   void insert(ConstantClass *CP) {
-    Map[CP] = '\0';
+    Map.insert(CP, MapInfo::getHashValue(CP));
   }
 
   /// Remove this constant from the map
   void remove(ConstantClass *CP) {
-    typename MapTy::iterator I = findExistingElement(CP);
-    assert(I != Map.end() && "Constant not found in constant table!");
-    assert(I->first == CP && "Didn't find correct element?");
-    Map.erase(I);
+    bool Erased = Map.erase(CP);
+    (void)Erased;
+    assert(Erased && "Constant not found in constant table!");
   }
 
   void dump() const {
@@ -50,13 +50,10 @@ struct DropReferences {
   }
 };
 
-// Temporary - drops pair.first instead of second.
-struct DropFirst {
-  // Takes the value_type of a ConstantUniqueMap's internal map, whose 'second'
-  // is a Constant*.
-  template<typename PairT>
-  void operator()(const PairT &P) {
-    P.first->dropAllReferences();
+struct DropAllReferences {
+  // Takes the Constant* stored in a ConstantAggrUniqueMap's table.
+  void operator()(Constant *C) {
+    C->dropAllReferences();
   }
 };
 }
@@ -74,11 +71,11 @@ LLVMContextImpl::~LLVMContextImpl() {
   std::for_each(ExprConstants.map_begin(), ExprConstants.map_end(),
                 DropReferences());
   std::for_each(ArrayConstants.map_begin(), ArrayConstants.map_end(),
-                DropFirst());
+                DropAllReferences());
   std::for_each(StructConstants.map_begin(), StructConstants.map_end(),
-                DropFirst());
+                DropAllReferences());
   std::for_each(VectorConstants.map_begin(), VectorConstants.map_end(),
-                DropFirst());
+                DropAllReferences());
   ExprConstants.freeConstants();
   ArrayConstants.freeConstants();
   StructConstants.freeConstants();
@@ -87,8 +84,8 @@ LLVMContextImpl::~LLVMContextImpl() {
   DeleteContainerSeconds(CPNConstants);
   DeleteContainerSeconds(UVConstants);
   InlineAsms.freeConstants();
-  DeleteContainerSeconds(IntConstants);
-  DeleteContainerSeconds(FPConstants);
+  DeleteContainerPointers(IntConstants);
+  DeleteContainerPointers(FPConstants);
   
   for (StringMap<ConstantDataSequential*>::iterator I = CDSConstants.begin(),
        E = CDSConstants.end(); I != E; ++I)
@@ -18,6 +18,7 @@
 #include "AttributeImpl.h"
 #include "ConstantsContext.h"
 #include "LeaksContext.h"
+#include "UniqueTable.h"
 #include "llvm/ADT/APFloat.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/ArrayRef.h"
@@ -41,11 +42,12 @@ class LLVMContext;
 class Type;
 class Value;
 
-struct DenseMapAPIntKeyInfo {
+struct ConstantIntKeyInfo {
   struct KeyTy {
-    APInt val;
+    const APInt &val;
     Type* type;
     KeyTy(const APInt& V, Type* Ty) : val(V), type(Ty) {}
+    KeyTy(const ConstantInt *CI) : val(CI->getValue()), type(CI->getType()) {}
     bool operator==(const KeyTy& that) const {
       return type == that.type && this->val == that.val;
     }
@@ -56,20 +58,22 @@ struct DenseMapAPIntKeyInfo {
       return hash_combine(Key.type, Key.val);
     }
   };
-  static inline KeyTy getEmptyKey() { return KeyTy(APInt(1,0), 0); }
-  static inline KeyTy getTombstoneKey() { return KeyTy(APInt(1,1), 0); }
   static unsigned getHashValue(const KeyTy &Key) {
     return static_cast<unsigned>(hash_value(Key));
   }
-  static bool isEqual(const KeyTy &LHS, const KeyTy &RHS) {
-    return LHS == RHS;
+  static unsigned getHashValue(const ConstantInt *CI) {
+    return getHashValue(KeyTy(CI));
+  }
+  static bool isEqual(const KeyTy &LHS, const ConstantInt *RHS) {
+    return LHS == KeyTy(RHS);
   }
 };
 
-struct DenseMapAPFloatKeyInfo {
+struct ConstantFPKeyInfo {
   struct KeyTy {
-    APFloat val;
+    const APFloat &val;
     KeyTy(const APFloat& V) : val(V){}
+    KeyTy(const ConstantFP *CFP) : val(CFP->getValueAPF()) {}
     bool operator==(const KeyTy& that) const {
       return this->val.bitwiseIsEqual(that.val);
     }
@@ -80,17 +84,14 @@ struct DenseMapAPFloatKeyInfo {
       return hash_combine(Key.val);
     }
   };
-  static inline KeyTy getEmptyKey() { 
-    return KeyTy(APFloat(APFloat::Bogus,1));
-  }
-  static inline KeyTy getTombstoneKey() { 
-    return KeyTy(APFloat(APFloat::Bogus,2)); 
-  }
   static unsigned getHashValue(const KeyTy &Key) {
     return static_cast<unsigned>(hash_value(Key));
   }
-  static bool isEqual(const KeyTy &LHS, const KeyTy &RHS) {
-    return LHS == RHS;
+  static unsigned getHashValue(const ConstantFP *CFP) {
+    return getHashValue(KeyTy(CFP));
+  }
+  static bool isEqual(const KeyTy &LHS, const ConstantFP *RHS) {
+    return LHS == KeyTy(RHS);
   }
 };
 
@@ -114,12 +115,6 @@ struct AnonStructTypeKeyInfo {
       return !this->operator==(that);
     }
   };
-  static inline StructType* getEmptyKey() {
-    return DenseMapInfo<StructType*>::getEmptyKey();
-  }
-  static inline StructType* getTombstoneKey() {
-    return DenseMapInfo<StructType*>::getTombstoneKey();
-  }
   static unsigned getHashValue(const KeyTy& Key) {
     return hash_combine(hash_combine_range(Key.ETypes.begin(),
                                            Key.ETypes.end()),
@@ -129,13 +124,8 @@ struct AnonStructTypeKeyInfo {
     return getHashValue(KeyTy(ST));
   }
   static bool isEqual(const KeyTy& LHS, const StructType *RHS) {
-    if (RHS == getEmptyKey() || RHS == getTombstoneKey())
-      return false;
     return LHS == KeyTy(RHS);
   }
-  static bool isEqual(const StructType *LHS, const StructType *RHS) {
-    return LHS == RHS;
-  }
 };
 
 struct FunctionTypeKeyInfo {
@@ -162,12 +152,6 @@ struct FunctionTypeKeyInfo {
       return !this->operator==(that);
     }
   };
-  static inline FunctionType* getEmptyKey() {
-    return DenseMapInfo<FunctionType*>::getEmptyKey();
-  }
-  static inline FunctionType* getTombstoneKey() {
-    return DenseMapInfo<FunctionType*>::getTombstoneKey();
-  }
   static unsigned getHashValue(const KeyTy& Key) {
     return hash_combine(Key.ReturnType,
                         hash_combine_range(Key.Params.begin(),
@@ -178,13 +162,8 @@ struct FunctionTypeKeyInfo {
     return getHashValue(KeyTy(FT));
   }
   static bool isEqual(const KeyTy& LHS, const FunctionType *RHS) {
-    if (RHS == getEmptyKey() || RHS == getTombstoneKey())
-      return false;
     return LHS == KeyTy(RHS);
   }
-  static bool isEqual(const FunctionType *LHS, const FunctionType *RHS) {
-    return LHS == RHS;
-  }
 };
 
 // Provide a FoldingSetTrait::Equals specialization for MDNode that can use a
@@ -239,12 +218,10 @@ public:
   LLVMContext::InlineAsmDiagHandlerTy InlineAsmDiagHandler;
   void *InlineAsmDiagContext;
   
-  typedef DenseMap<DenseMapAPIntKeyInfo::KeyTy, ConstantInt*, 
-                         DenseMapAPIntKeyInfo> IntMapTy;
+  typedef UniqueTable<ConstantInt, ConstantIntKeyInfo> IntMapTy;
   IntMapTy IntConstants;
   
-  typedef DenseMap<DenseMapAPFloatKeyInfo::KeyTy, ConstantFP*, 
-                         DenseMapAPFloatKeyInfo> FPMapTy;
+  typedef UniqueTable<ConstantFP, ConstantFPKeyInfo> FPMapTy;
   FPMapTy FPConstants;
 
   FoldingSet<AttributeImpl> AttrsSet;
@@ -303,9 +280,9 @@ public:
   
   DenseMap<unsigned, IntegerType*> IntegerTypes;
   
-  typedef DenseMap<FunctionType*, bool, FunctionTypeKeyInfo> FunctionTypeMap;
+  typedef UniqueTable<FunctionType, FunctionTypeKeyInfo> FunctionTypeMap;
   FunctionTypeMap FunctionTypes;
-  typedef DenseMap<StructType*, bool, AnonStructTypeKeyInfo> StructTypeMap;
+  typedef UniqueTable<StructType, AnonStructTypeKeyInfo> StructTypeMap;
   StructTypeMap AnonStructTypes;
   StringMap<StructType*> NamedStructTypes;
   unsigned NamedStructTypesUniqueID;
@@ -13,6 +13,8 @@
 
 
 #include "llvm/PassManagers.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Module.h"
@@ -23,6 +25,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/PassNameParser.h"
+#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -886,6 +889,7 @@ void PMDataManager::removeNotPreservedAnalysis(Pass *P) {
         dbgs() << " -- '" <<  P->getPassName() << "' is not preserving '";
         dbgs() << S->getPassName() << "'\n";
       }
+      PassTraceRegion::recordInvalidation(P, Info->second);
       AvailableAnalysis.erase(Info);
     }
   }
@@ -910,6 +914,7 @@ void PMDataManager::removeNotPreservedAnalysis(Pass *P) {
           dbgs() << " -- '" <<  P->getPassName() << "' is not preserving '";
           dbgs() << S->getPassName() << "'\n";
         }
+        PassTraceRegion::recordInvalidation(P, Info->second);
         InheritedAnalysis[Index]->erase(Info);
       }
     }
@@ -1299,8 +1304,10 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        PassTraceRegion Trace(BP, *I);
 
-        LocalChanged |= BP->runOnBasicBlock(*I);
+        LocalChanged = BP->runOnBasicBlock(*I);
+        Trace.setChanged(LocalChanged);
       }
 
       Changed |= LocalChanged;
@@ -1417,6 +1424,7 @@ bool FunctionPassManager::doFinalization() {
 //
 bool FunctionPassManagerImpl::doInitialization(Module &M) {
   bool Changed = false;
+  FunctionCompileTime.clear();
 
   dumpArguments();
   dumpPasses();
@@ -1526,8 +1534,10 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      PassTraceRegion Trace(FP, F);
 
       LocalChanged |= FP->runOnFunction(F);
+      Trace.setChanged(LocalChanged);
     }
 
     Changed |= LocalChanged;
@@ -1604,8 +1614,10 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      PassTraceRegion Trace(MP, M);
 
       LocalChanged |= MP->runOnModule(M);
+      Trace.setChanged(LocalChanged);
     }
 
     Changed |= LocalChanged;
@@ -1688,6 +1700,7 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
 bool PassManagerImpl::run(Module &M) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  FunctionCompileTime.clear();
 
   dumpArguments();
   dumpPasses();
@@ -1766,6 +1779,306 @@ Timer *llvm::getPassTimer(Pass *P) {
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// PassTraceRegion implementation
+
+namespace {
+enum PassTraceFormat {
+  TraceJSON, TraceChrome
+};
+}
+
+static cl::opt<std::string>
+PassTraceFile("pass-trace", cl::value_desc("filename"),
+              cl::desc("Record every pass execution, with its time and the "
+                       "instruction counts around it, in the given file"));
+
+static cl::opt<PassTraceFormat>
+PassTraceFormatOpt("pass-trace-format", cl::init(TraceJSON),
+  cl::desc("Format of the -pass-trace file"),
+  cl::values(
+    clEnumValN(TraceJSON, "json", "A JSON array of pass executions"),
+    clEnumValN(TraceChrome, "chrome",
+               "Chrome trace events, for chrome://tracing"),
+    clEnumValEnd));
+
+static cl::opt<unsigned>
+FunctionCompileBudget("function-compile-budget-us", cl::init(0),
+  cl::value_desc("microseconds"),
+  cl::desc("Let optional expensive passes do less work on a function once "
+           "the passes run on it have taken this long (0 = unlimited)"));
+
+namespace {
+/// PassTraceEvent - One pass execution in the trace.
+struct PassTraceEvent {
+  const Pass *P;
+  std::string PassName;
+  const char *Kind;
+  std::string Unit;
+  uint64_t Start, End;
+  uint64_t InstrsBefore, InstrsAfter;
+  bool Changed;
+  bool OverBudget;
+  std::vector<std::string> Invalidated;
+};
+
+/// PassTrace - Streams the events of -pass-trace to its file.  The last event
+/// is held back until the next one starts, so that the analyses its pass
+/// invalidates can be added to it.
+class PassTrace {
+  OwningPtr<raw_fd_ostream> OS;
+  PassTraceEvent Pending;
+  bool HasPending;
+  bool First;
+
+  void writeEvent(const PassTraceEvent &E);
+
+public:
+  PassTrace();
+  ~PassTrace();
+
+  void addEvent(const PassTraceEvent &E);
+  void addInvalidation(const Pass *P, StringRef AnalysisName);
+};
+}
+
+static ManagedStatic<sys::SmartMutex<true> > PassTraceMutex;
+static ManagedStatic<PassTrace> ThePassTrace;
+
+/// TraceEpoch - When the first traced pass started.  Event times are
+/// relative to it.
+static uint64_t TraceEpoch = 0;
+
+/// writeJSONString - Write S as a quoted JSON string.
+static void writeJSONString(raw_ostream &OS, StringRef S) {
+  OS << '"';
+  for (StringRef::iterator I = S.begin(), E = S.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << "\\u00" << hexdigit(C >> 4) << hexdigit(C & 0xF);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+PassTrace::PassTrace() : HasPending(false), First(true) {
+  std::string Error;
+  OS.reset(new raw_fd_ostream(PassTraceFile.c_str(), Error));
+  if (!Error.empty()) {
+    errs() << "error opening pass trace '" << PassTraceFile << "': "
+           << Error << "\n";
+    OS.reset();
+    return;
+  }
+  *OS << (PassTraceFormatOpt == TraceChrome ? "{\"traceEvents\":[" : "[");
+}
+
+PassTrace::~PassTrace() {
+  if (!OS)
+    return;
+  if (HasPending)
+    writeEvent(Pending);
+  *OS << (PassTraceFormatOpt == TraceChrome ? "\n]}\n" : "\n]\n");
+}
+
+void PassTrace::writeEvent(const PassTraceEvent &E) {
+  raw_ostream &Out = *OS;
+  Out << (First ? "\n" : ",\n");
+  First = false;
+
+  if (PassTraceFormatOpt == TraceChrome) {
+    // A complete event per execution; the details show up when it is
+    // selected.
+    Out << "{\"name\":";
+    writeJSONString(Out, E.PassName);
+    Out << ",\"cat\":\"" << E.Kind << "\",\"ph\":\"X\",\"ts\":" << E.Start
+        << ",\"dur\":" << E.End - E.Start << ",\"pid\":1,\"tid\":1,"
+        << "\"args\":{\"unit\":";
+    writeJSONString(Out, E.Unit);
+  } else {
+    Out << "{\"pass\":";
+    writeJSONString(Out, E.PassName);
+    Out << ",\"kind\":\"" << E.Kind << "\",\"unit\":";
+    writeJSONString(Out, E.Unit);
+    Out << ",\"start_us\":" << E.Start << ",\"end_us\":" << E.End;
+  }
+
+  Out << ",\"instructions_before\":" << E.InstrsBefore
+      << ",\"instructions_after\":" << E.InstrsAfter
+      << ",\"changed\":" << (E.Changed ? "true" : "false");
+  if (E.OverBudget)
+    Out << ",\"over_budget\":true";
+  Out << ",\"invalidated\":[";
+  for (unsigned i = 0, e = E.Invalidated.size(); i != e; ++i) {
+    if (i)
+      Out << ',';
+    writeJSONString(Out, E.Invalidated[i]);
+  }
+  Out << (PassTraceFormatOpt == TraceChrome ? "]}}" : "]}");
+}
+
+void PassTrace::addEvent(const PassTraceEvent &E) {
+  if (!OS)
+    return;
+  if (HasPending)
+    writeEvent(Pending);
+  Pending = E;
+  HasPending = true;
+}
+
+void PassTrace::addInvalidation(const Pass *P, StringRef AnalysisName) {
+  if (HasPending && Pending.P == P)
+    Pending.Invalidated.push_back(AnalysisName);
+}
+
+/// getFunctionCompileTime - The compile times kept by the pass manager that
+/// runs P, or null if P is not being run by one.
+static PMTopLevelManager::CompileTimeMap *
+getFunctionCompileTime(const Pass &P) {
+  AnalysisResolver *AR = P.getResolver();
+  if (!AR)
+    return 0;
+  PMTopLevelManager *TPM = AR->getPMDataManager().getTopLevelManager();
+  return TPM ? &TPM->FunctionCompileTime : 0;
+}
+
+static const char *getPassKindName(PassKind K) {
+  switch (K) {
+  case PT_BasicBlock:   return "basicblock";
+  case PT_Region:       return "region";
+  case PT_Loop:         return "loop";
+  case PT_Function:     return "function";
+  case PT_CallGraphSCC: return "cgscc";
+  case PT_Module:       return "module";
+  case PT_PassManager:  return "passmanager";
+  }
+  llvm_unreachable("Unknown pass kind");
+}
+
+PassTraceRegion::PassTraceRegion(Pass *P, Module &M)
+  : P(P), M(&M), BB(0) {
+  begin();
+}
+
+PassTraceRegion::PassTraceRegion(Pass *P, Function &F)
+  : P(P), M(0), BB(0) {
+  Functions.push_back(&F);
+  begin();
+}
+
+PassTraceRegion::PassTraceRegion(Pass *P, BasicBlock &BB)
+  : P(P), M(0), BB(&BB) {
+  Functions.push_back(BB.getParent());
+  begin();
+}
+
+PassTraceRegion::PassTraceRegion(Pass *P, ArrayRef<Function *> Fs)
+  : P(P), M(0), BB(0) {
+  for (unsigned i = 0, e = Fs.size(); i != e; ++i)
+    if (Fs[i])
+      Functions.push_back(Fs[i]);
+  begin();
+}
+
+void PassTraceRegion::begin() {
+  Changed = false;
+  // Pass managers are not traced themselves; the passes they run are.
+  Active = (!PassTraceFile.empty() || FunctionCompileBudget) &&
+           !P->getAsPMDataManager();
+  if (!Active)
+    return;
+  InstrsBefore = PassTraceFile.empty() ? 0 : countInstructions();
+  StartTime = sys::TimeValue::now().usec();
+  if (!TraceEpoch)
+    TraceEpoch = StartTime;
+}
+
+uint64_t PassTraceRegion::countInstructions() const {
+  if (BB)
+    return BB->size();
+  uint64_t Count = 0;
+  if (M) {
+    for (Module::iterator F = M->begin(), E = M->end(); F != E; ++F)
+      for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB)
+        Count += BB->size();
+    return Count;
+  }
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    Value *V = Functions[i];
+    if (Function *F = cast_or_null<Function>(V))
+      for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB)
+        Count += BB->size();
+  }
+  return Count;
+}
+
+PassTraceRegion::~PassTraceRegion() {
+  if (!Active)
+    return;
+  uint64_t EndTime = sys::TimeValue::now().usec();
+
+  bool OverBudget = false;
+  if (FunctionCompileBudget && !M && Functions.size() == 1 && Functions[0])
+    if (PMTopLevelManager::CompileTimeMap *CompileTime =
+          getFunctionCompileTime(*P)) {
+      // Charge at least the resolution of the clock, so that many fast passes
+      // still add up.
+      const Value *F = Functions[0];
+      PMTopLevelManager::CompileTimeMap::iterator I = CompileTime->find(F);
+      if (I == CompileTime->end())
+        I = CompileTime->insert(std::make_pair(F, uint64_t(0))).first;
+      I->second += std::max<uint64_t>(EndTime - StartTime, 1);
+      OverBudget = I->second >= FunctionCompileBudget;
+    }
+
+  if (PassTraceFile.empty())
+    return;
+  sys::SmartScopedLock<true> Lock(*PassTraceMutex);
+  PassTrace &Trace = *ThePassTrace;
+  PassTraceEvent E;
+  E.P = P;
+  E.PassName = P->getPassName();
+  E.Kind = getPassKindName(P->getPassKind());
+  if (M)
+    E.Unit = M->getModuleIdentifier();
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    if (!Functions[i])
+      continue;
+    if (!E.Unit.empty())
+      E.Unit += ' ';
+    E.Unit += Functions[i]->getName();
+  }
+  E.Start = StartTime - TraceEpoch;
+  E.End = EndTime - TraceEpoch;
+  E.InstrsBefore = InstrsBefore;
+  E.InstrsAfter = countInstructions();
+  E.Changed = Changed;
+  E.OverBudget = OverBudget;
+  Trace.addEvent(E);
+}
+
+void PassTraceRegion::recordInvalidation(Pass *P, Pass *AP) {
+  if (PassTraceFile.empty())
+    return;
+  sys::SmartScopedLock<true> Lock(*PassTraceMutex);
+  ThePassTrace->addInvalidation(P, AP->getPassName());
+}
+
+bool llvm::isFunctionOverCompileBudget(const Pass &P, const Function &F) {
+  if (!FunctionCompileBudget)
+    return false;
+  PMTopLevelManager::CompileTimeMap *CompileTime =
+    getFunctionCompileTime(P);
+  if (!CompileTime)
+    return false;
+  PMTopLevelManager::CompileTimeMap::iterator I =
+    CompileTime->find(&F);
+  return I != CompileTime->end() && I->second >= FunctionCompileBudget;
+}
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
@@ -362,18 +362,15 @@ FunctionType *FunctionType::get(Type *ReturnType,
                                 ArrayRef<Type*> Params, bool isVarArg) {
   LLVMContextImpl *pImpl = ReturnType->getContext().pImpl;
   FunctionTypeKeyInfo::KeyTy Key(ReturnType, Params, isVarArg);
-  LLVMContextImpl::FunctionTypeMap::iterator I =
-    pImpl->FunctionTypes.find_as(Key);
-  FunctionType *FT;
+  unsigned Hash = FunctionTypeKeyInfo::getHashValue(Key);
+  FunctionType *FT = pImpl->FunctionTypes.find(Key, Hash);
 
-  if (I == pImpl->FunctionTypes.end()) {
+  if (!FT) {
     FT = (FunctionType*) pImpl->TypeAllocator.
       Allocate(sizeof(FunctionType) + sizeof(Type*) * (Params.size() + 1),
                AlignOf<FunctionType>::Alignment);
     new (FT) FunctionType(ReturnType, Params, isVarArg);
-    pImpl->FunctionTypes[FT] = true;
-  } else {
-    FT = I->first;
+    pImpl->FunctionTypes.insert(FT, Hash);
   }
 
   return FT;
@@ -406,18 +403,15 @@ StructType *StructType::get(LLVMContext &Context, ArrayRef<Type*> ETypes,
                             bool isPacked) {
   LLVMContextImpl *pImpl = Context.pImpl;
   AnonStructTypeKeyInfo::KeyTy Key(ETypes, isPacked);
-  LLVMContextImpl::StructTypeMap::iterator I =
-    pImpl->AnonStructTypes.find_as(Key);
-  StructType *ST;
+  unsigned Hash = AnonStructTypeKeyInfo::getHashValue(Key);
+  StructType *ST = pImpl->AnonStructTypes.find(Key, Hash);
 
-  if (I == pImpl->AnonStructTypes.end()) {
+  if (!ST) {
     // Value not found.  Create a new type!
     ST = new (Context.pImpl->TypeAllocator) StructType(Context);
     ST->setSubclassData(SCDB_IsLiteral);  // Literal struct.
     ST->setBody(ETypes, isPacked);
-    Context.pImpl->AnonStructTypes[ST] = true;
-  } else {
-    ST = I->first;
+    Context.pImpl->AnonStructTypes.insert(ST, Hash);
   }
 
   return ST;
@@ -0,0 +1,119 @@
+//===-- UniqueTable.cpp - Open-addressed uniquing table -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file implements the parts of UniqueTable that do not depend on the
+// type of the entries.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "ir"
+#include "UniqueTable.h"
+#include "llvm/ADT/Statistic.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+using namespace llvm;
+
+// The entry and bucket counts are those of the tables that are live; their
+// ratio is the load factor.
+STATISTIC(NumTableEntries, "Number of entries in the uniquing tables");
+STATISTIC(NumTableBuckets, "Number of buckets in the uniquing tables");
+STATISTIC(NumLookups, "Number of lookups in the uniquing tables");
+STATISTIC(NumProbes, "Number of buckets probed by uniquing table lookups");
+STATISTIC(MaxProbeLength, "Longest probe sequence of a uniquing table lookup");
+
+UniqueTableBase::~UniqueTableBase() {
+  clear();
+}
+
+void UniqueTableBase::clear() {
+  NumTableEntries -= NumEntries;
+  NumTableBuckets -= NumBuckets;
+  free(Buckets);
+  Buckets = 0;
+  NumBuckets = NumEntries = NumTombstones = 0;
+}
+
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+void UniqueTableBase::noteLookup(unsigned Probes) {
+  // Lookups are frequent; don't pay for the atomic updates unless the
+  // statistics will be printed.
+  if (!AreStatisticsEnabled())
+    return;
+  ++NumLookups;
+  NumProbes += Probes;
+  MaxProbeLength.updateMax(Probes);
+}
+#endif
+
+/// grow - Rehash the entries into a table of NewNumBuckets buckets, a power
+/// of two, dropping the tombstones.
+void UniqueTableBase::grow(unsigned NewNumBuckets) {
+  assert(NewNumBuckets && !(NewNumBuckets & (NewNumBuckets - 1)) &&
+         "The number of buckets must be a power of two!");
+  unsigned OldNumBuckets = NumBuckets;
+  Bucket *OldBuckets = Buckets;
+
+  NumBuckets = NewNumBuckets;
+  Buckets = static_cast<Bucket*>(calloc(NumBuckets, sizeof(Bucket)));
+  NumTombstones = 0;
+  NumTableBuckets += NumBuckets - OldNumBuckets;
+
+  unsigned Mask = NumBuckets - 1;
+  for (Bucket *B = OldBuckets, *E = OldBuckets + OldNumBuckets; B != E; ++B) {
+    if (!B->Ptr || B->Ptr == getTombstone())
+      continue;
+    unsigned I = B->Hash & Mask;
+    while (Buckets[I].Ptr)
+      I = (I + 1) & Mask;
+    Buckets[I] = *B;
+  }
+  free(OldBuckets);
+}
+
+void UniqueTableBase::insertNew(unsigned Hash, void *Ptr) {
+  assert(Ptr && Ptr != getTombstone() && "Cannot insert this pointer!");
+  // Keep at least a quarter of the buckets empty, so that the probe
+  // sequences stay short and every lookup ends at an empty bucket.
+  if ((NumEntries + NumTombstones + 1) * 4 > NumBuckets * 3) {
+    // Rehashing in place is enough when it is the tombstones that fill the
+    // table.
+    unsigned NewNumBuckets = NumBuckets;
+    if ((NumEntries + 1) * 2 > NumBuckets)
+      NewNumBuckets = std::max(16u, NumBuckets * 2);
+    grow(NewNumBuckets);
+  }
+
+  unsigned Mask = NumBuckets - 1;
+  unsigned I = Hash & Mask;
+  while (Buckets[I].Ptr && Buckets[I].Ptr != getTombstone())
+    I = (I + 1) & Mask;
+  if (Buckets[I].Ptr)
+    --NumTombstones;
+  Buckets[I].Hash = Hash;
+  Buckets[I].Ptr = Ptr;
+  ++NumEntries;
+  ++NumTableEntries;
+}
+
+bool UniqueTableBase::eraseExisting(unsigned Hash, void *Ptr) {
+  if (NumBuckets == 0)
+    return false;
+  unsigned Mask = NumBuckets - 1;
+  for (unsigned I = Hash & Mask; Buckets[I].Ptr; I = (I + 1) & Mask) {
+    if (Buckets[I].Ptr != Ptr)
+      continue;
+    Buckets[I].Ptr = getTombstone();
+    ++NumTombstones;
+    --NumEntries;
+    --NumTableEntries;
+    return true;
+  }
+  return false;
+}
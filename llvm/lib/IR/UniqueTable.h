@@ -0,0 +1,174 @@
+//===-- UniqueTable.h - Open-addressed uniquing table -----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines UniqueTable, the hash table LLVMContextImpl uses to
+// unique constants and types.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_UNIQUETABLE_H
+#define LLVM_UNIQUETABLE_H
+
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include <cstddef>
+#include <iterator>
+
+namespace llvm {
+
+/// UniqueTableBase - The part of UniqueTable that does not depend on the
+/// type of the entries: the bucket array, growing it and the statistics.
+class UniqueTableBase {
+protected:
+  /// Bucket - An entry together with its hash. Lookups compare the hashes
+  /// before looking at the entries, and growing the table rehashes from
+  /// them, so the entries are only touched to check a likely match.
+  struct Bucket {
+    unsigned Hash;
+    void *Ptr;
+  };
+
+  Bucket *Buckets;
+  unsigned NumBuckets;
+  unsigned NumEntries;
+  unsigned NumTombstones;
+
+  UniqueTableBase()
+    : Buckets(0), NumBuckets(0), NumEntries(0), NumTombstones(0) {}
+  ~UniqueTableBase();
+
+  /// getTombstone - The pointer left in the bucket of an erased entry, so
+  /// that the probe sequences running through it still find what follows.
+  static void *getTombstone() {
+    return reinterpret_cast<void*>(~uintptr_t(0));
+  }
+
+  /// insertNew - Add Ptr with the given hash, which must not be in the table.
+  void insertNew(unsigned Hash, void *Ptr);
+
+  /// eraseExisting - Remove Ptr, which has the given hash, from the table.
+  /// Return false if it is not there.
+  bool eraseExisting(unsigned Hash, void *Ptr);
+
+  /// noteLookup - Update the statistics for a lookup that looked at Probes
+  /// buckets.
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+  static void noteLookup(unsigned Probes);
+#else
+  static void noteLookup(unsigned) {}
+#endif
+
+private:
+  void grow(unsigned NewNumBuckets);
+
+  UniqueTableBase(const UniqueTableBase &) LLVM_DELETED_FUNCTION;
+  void operator=(const UniqueTableBase &) LLVM_DELETED_FUNCTION;
+
+public:
+  unsigned size() const { return NumEntries; }
+  bool empty() const { return NumEntries == 0; }
+  unsigned getNumBuckets() const { return NumBuckets; }
+
+  /// clear - Remove all the entries and free the buckets.
+  void clear();
+};
+
+/// UniqueTable - A set of T*, uniqued by the key each T is made from. It is
+/// an open-addressed table of (hash, pointer) pairs with linear probing, so
+/// that a bucket takes two words however large the key is, and a lookup only
+/// dereferences the entries whose hash matches.
+///
+/// KeyInfoT provides getHashValue(const LookupKeyT &) and
+/// isEqual(const LookupKeyT &, const T *) for each kind of key T is looked up
+/// with, and getHashValue(const T *) if entries are erased. The hash of an
+/// entry must equal the hash of any key it is equal to.
+template <typename T, typename KeyInfoT>
+class UniqueTable : public UniqueTableBase {
+public:
+  class iterator : public std::iterator<std::forward_iterator_tag, T*,
+                                        ptrdiff_t, T**, T*> {
+    const Bucket *Ptr, *End;
+
+    void skipEmpty() {
+      while (Ptr != End && (!Ptr->Ptr || Ptr->Ptr == getTombstone()))
+        ++Ptr;
+    }
+  public:
+    iterator(const Bucket *P, const Bucket *E) : Ptr(P), End(E) {
+      skipEmpty();
+    }
+
+    T *operator*() const { return static_cast<T*>(Ptr->Ptr); }
+
+    iterator &operator++() {
+      ++Ptr;
+      skipEmpty();
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator Tmp = *this;
+      ++*this;
+      return Tmp;
+    }
+
+    bool operator==(const iterator &RHS) const { return Ptr == RHS.Ptr; }
+    bool operator!=(const iterator &RHS) const { return Ptr != RHS.Ptr; }
+  };
+
+  iterator begin() const {
+    return iterator(Buckets, Buckets + NumBuckets);
+  }
+  iterator end() const {
+    return iterator(Buckets + NumBuckets, Buckets + NumBuckets);
+  }
+
+  /// find - Return the entry equal to Key, whose hash is Hash, or null if
+  /// there is none.
+  template <typename LookupKeyT>
+  T *find(const LookupKeyT &Key, unsigned Hash) const {
+    if (NumBuckets == 0) {
+      noteLookup(0);
+      return 0;
+    }
+    unsigned Mask = NumBuckets - 1;
+    for (unsigned I = Hash & Mask, Probes = 1; ; ++Probes) {
+      const Bucket &B = Buckets[I];
+      if (!B.Ptr) {
+        noteLookup(Probes);
+        return 0;
+      }
+      if (B.Hash == Hash && B.Ptr != getTombstone() &&
+          KeyInfoT::isEqual(Key, static_cast<const T*>(B.Ptr))) {
+        noteLookup(Probes);
+        return static_cast<T*>(B.Ptr);
+      }
+      I = (I + 1) & Mask;
+    }
+  }
+
+  template <typename LookupKeyT>
+  T *find(const LookupKeyT &Key) const {
+    return find(Key, KeyInfoT::getHashValue(Key));
+  }
+
+  /// insert - Add P, whose hash is Hash. Nothing equal to P may be in the
+  /// table yet.
+  void insert(T *P, unsigned Hash) {
+    insertNew(Hash, P);
+  }
+
+  /// erase - Remove P from the table. Return false if it is not there.
+  bool erase(T *P) {
+    return eraseExisting(KeyInfoT::getHashValue(P), P);
+  }
+};
+
+} // end namespace llvm
+
+#endif
@@ -720,6 +720,13 @@ void Verifier::visitModuleFlag(MDNode *Op, DenseMap<MDString*, MDNode*>&SeenIDs,
             "(expected a metadata node)", Op->getOperand(2));
     break;
   }
+
+  case Module::Max: {
+    Assert1(isa<ConstantInt>(Op->getOperand(2)),
+            "invalid value for 'max' module flag (expected constant integer)",
+            Op->getOperand(2));
+    break;
+  }
   }
 
   // Unless this is a "requires" flag, check the ID is unique.
@@ -2356,6 +2363,26 @@ void Verifier::visitIntrinsicFunctionCall(Intrinsic::ID ID, CallInst &CI) {
     Assert1(isa<ConstantInt>(CI.getArgOperand(1)),
             "llvm.invariant.end parameter #2 must be a constant integer", &CI);
     break;
+  case Intrinsic::masked_load:
+  case Intrinsic::masked_store: {
+    bool IsLoad = ID == Intrinsic::masked_load;
+    Type *DataTy = IsLoad ? CI.getType() : CI.getArgOperand(0)->getType();
+    Value *Ptr = CI.getArgOperand(IsLoad ? 0 : 1);
+    Value *Alignment = CI.getArgOperand(IsLoad ? 1 : 2);
+    VectorType *MaskTy =
+      cast<VectorType>(CI.getArgOperand(IsLoad ? 2 : 3)->getType());
+    Assert1(cast<PointerType>(Ptr->getType())->getElementType() == DataTy,
+            "pointer operand of masked memory intrinsics must point to the "
+            "data type", &CI);
+    Assert1(isa<ConstantInt>(Alignment),
+            "alignment argument of masked memory intrinsics must be a "
+            "constant int", &CI);
+    Assert1(MaskTy->getElementType()->isIntegerTy(1) &&
+            MaskTy->getNumElements() == DataTy->getVectorNumElements(),
+            "mask of masked memory intrinsics must be a vector of i1 with one "
+            "element per data element", &CI);
+    break;
+  }
   }
 }
 
@@ -18,6 +18,7 @@
 #include "llvm/Analysis/Passes.h"
 #include "llvm/Analysis/Verifier.h"
 #include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/Config/config.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -59,7 +60,8 @@ const char* LTOCodeGenerator::getVersionString() {
 LTOCodeGenerator::LTOCodeGenerator()
     : Context(getGlobalContext()), Linker(new Module("ld-temp.o", Context)),
       TargetMach(NULL), EmitDwarfDebugInfo(false), ScopeRestrictionsDone(false),
-      CodeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC), NativeObjectFile(NULL) {
+      CodeModel(LTO_CODEGEN_PIC_MODEL_DYNAMIC), CodeGenParallelism(1),
+      NativeObjectFile(NULL) {
   initializeLTOPasses();
 }
 
@@ -211,8 +213,9 @@ bool LTOCodeGenerator::compile_to_file(const char** name,
   // generate object file
   tool_output_file objFile(Filename.c_str(), FD);
 
-  bool genResult = generateObjectFile(objFile.os(), disableOpt, disableInline,
-                                      disableGVNLoadPRE, errMsg);
+  raw_ostream *OS = &objFile.os();
+  bool genResult = generateObjectFiles(OS, disableOpt, disableInline,
+                                       disableGVNLoadPRE, errMsg);
   objFile.os().close();
   if (objFile.os().has_error()) {
     objFile.os().clear_error();
@@ -263,6 +266,65 @@ const void* LTOCodeGenerator::compile(size_t* length,
   return NativeObjectFile->getBufferStart();
 }
 
+bool LTOCodeGenerator::compile_to_files(const char ***names,
+                                        unsigned *count,
+                                        bool disableOpt,
+                                        bool disableInline,
+                                        bool disableGVNLoadPRE,
+                                        std::string &errMsg) {
+  NativeObjectPaths.clear();
+  NativeObjectPathNames.clear();
+
+  // make a unique temp .o file for each partition
+  std::vector<tool_output_file *> objFiles;
+  std::vector<raw_ostream *> OSs;
+  std::vector<std::string> Filenames;
+  bool Success = true;
+  for (unsigned I = 0; I != CodeGenParallelism; ++I) {
+    SmallString<128> Filename;
+    int FD;
+    error_code EC = sys::fs::createTemporaryFile("lto-llvm", "o", FD, Filename);
+    if (EC) {
+      errMsg = EC.message();
+      Success = false;
+      break;
+    }
+    objFiles.push_back(new tool_output_file(Filename.c_str(), FD));
+    OSs.push_back(&objFiles.back()->os());
+    Filenames.push_back(Filename.str());
+  }
+
+  // generate object files
+  if (Success)
+    Success = generateObjectFiles(OSs, disableOpt, disableInline,
+                                  disableGVNLoadPRE, errMsg);
+
+  for (unsigned I = 0, E = objFiles.size(); I != E; ++I) {
+    objFiles[I]->os().close();
+    if (objFiles[I]->os().has_error()) {
+      objFiles[I]->os().clear_error();
+      if (Success)
+        errMsg = "could not write object file: " + Filenames[I];
+      Success = false;
+    }
+    objFiles[I]->keep();
+    delete objFiles[I];
+  }
+
+  if (!Success) {
+    for (unsigned I = 0, E = Filenames.size(); I != E; ++I)
+      sys::fs::remove(Twine(Filenames[I]));
+    return false;
+  }
+
+  NativeObjectPaths = Filenames;
+  for (unsigned I = 0, E = NativeObjectPaths.size(); I != E; ++I)
+    NativeObjectPathNames.push_back(NativeObjectPaths[I].c_str());
+  *names = &NativeObjectPathNames[0];
+  *count = NativeObjectPathNames.size();
+  return true;
+}
+
 bool LTOCodeGenerator::determineTarget(std::string &errMsg) {
   if (TargetMach != NULL)
     return true;
@@ -395,12 +457,13 @@ void LTOCodeGenerator::applyScopeRestrictions() {
   ScopeRestrictionsDone = true;
 }
 
-/// Optimize merged modules using various IPO passes
-bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
-                                          bool DisableOpt,
-                                          bool DisableInline,
-                                          bool DisableGVNLoadPRE,
-                                          std::string &errMsg) {
+/// Optimize merged modules using various IPO passes, and generate code for
+/// them into one object file per output stream.
+bool LTOCodeGenerator::generateObjectFiles(ArrayRef<raw_ostream *> out,
+                                           bool DisableOpt,
+                                           bool DisableInline,
+                                           bool DisableGVNLoadPRE,
+                                           std::string &errMsg) {
   if (!this->determineTarget(errMsg))
     return false;
 
@@ -431,30 +494,17 @@ bool LTOCodeGenerator::generateObjectFile(raw_ostream &out,
   // Make sure everything is still good.
   passes.add(createVerifierPass());
 
-  PassManager codeGenPasses;
-
-  codeGenPasses.add(new DataLayout(*TargetMach->getDataLayout()));
-  TargetMach->addAnalysisPasses(codeGenPasses);
-
-  formatted_raw_ostream Out(out);
-
   // If the bitcode files contain ARC code and were compiled with optimization,
-  // the ObjCARCContractPass must be run, so do it unconditionally here.
-  codeGenPasses.add(createObjCARCContractPass());
-
-  if (TargetMach->addPassesToEmitFile(codeGenPasses, Out,
-                                      TargetMachine::CGFT_ObjectFile)) {
-    errMsg = "target file type not supported";
-    return false;
-  }
+  // the ObjCARCContractPass must be run, so do it unconditionally here. It
+  // runs before the module is split, so every partition sees its results.
+  passes.add(createObjCARCContractPass());
 
   // Run our queue of passes all at once now, efficiently.
   passes.run(*mergedModule);
 
-  // Run the code generator, and write assembly file
-  codeGenPasses.run(*mergedModule);
-
-  return true;
+  // Run the code generator, and write the object files
+  return splitCodeGen(mergedModule, out, *TargetMach, /*TLI=*/0,
+                      TargetMachine::CGFT_ObjectFile, errMsg);
 }
 
 /// setCodeGenDebugOptions - Set codegen debugging options to aid in debugging
@@ -1169,6 +1169,18 @@ bool ModuleLinker::linkModuleFlagsMetadata() {
                                                                 Elts.end())));
       break;
     }
+    case Module::Max: {
+      ConstantInt *DstValue = cast<ConstantInt>(DstOp->getOperand(2));
+      ConstantInt *SrcValue = cast<ConstantInt>(SrcOp->getOperand(2));
+      if (SrcValue->getType() != DstValue->getType()) {
+        HasErr |= emitError("linking module flags '" + ID->getString() +
+                            "': IDs have values of different types");
+        continue;
+      }
+      if (SrcValue->getValue().ugt(DstValue->getValue()))
+        DstOp->replaceOperandWith(2, SrcValue);
+      break;
+    }
     }
   }
 
@@ -57,7 +57,8 @@ class ELFObjectWriter : public MCObjectWriter {
 
     void WriteDataSectionData(MCAssembler &Asm,
                               const MCAsmLayout &Layout,
-                              const MCSectionELF &Section);
+                              const MCSectionELF &Section,
+                              const SmallVectorImpl<char> *Contents = 0);
 
     /*static bool isFixupKindX86RIPRel(unsigned Kind) {
       return Kind == X86::reloc_riprel_4byte ||
@@ -1415,9 +1416,11 @@ uint64_t ELFObjectWriter::GetSectionAddressSize(const MCAsmLayout &Layout,
   return Layout.getSectionAddressSize(&SD);
 }
 
-void ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
-                                           const MCAsmLayout &Layout,
-                                           const MCSectionELF &Section) {
+void
+ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
+                                      const MCAsmLayout &Layout,
+                                      const MCSectionELF &Section,
+                                      const SmallVectorImpl<char> *Contents) {
   const MCSectionData &SD = Asm.getOrCreateSectionData(Section);
 
   uint64_t Padding = OffsetToAlignment(OS.tell(), SD.getAlignment());
@@ -1430,6 +1433,8 @@ void ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
       assert(F.getKind() == MCFragment::FT_Data);
       WriteBytes(cast<MCDataFragment>(F).getContents());
     }
+  } else if (Contents) {
+    WriteBytes(StringRef(Contents->data(), Contents->size()));
   } else {
     Asm.writeSectionData(&SD, Layout);
   }
@@ -1582,10 +1587,30 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
   // Write out the ELF header ...
   WriteHeader(Asm, SectionHeaderOffset, NumSections + 1);
 
+  // With several threads, the contents of the user sections are rendered
+  // concurrently before they are written out in order.
+  std::vector<const MCSectionData *> RenderedSections;
+  std::vector<SmallString<0> > RenderedContents;
+  if (Asm.getNumThreads() > 1) {
+    for (unsigned i = 0; i < NumRegularSections + 1; ++i) {
+      const MCSectionELF &Section = *Sections[i];
+      const MCSectionData &SD = Asm.getOrCreateSectionData(Section);
+      if (!IsELFMetaDataSection(SD) && !Section.isVirtualSection())
+        RenderedSections.push_back(&SD);
+    }
+    Asm.writeSectionDataConcurrently(RenderedSections, Layout,
+                                     RenderedContents);
+  }
+
   // ... then the regular sections ...
   // + because of .shstrtab
-  for (unsigned i = 0; i < NumRegularSections + 1; ++i)
-    WriteDataSectionData(Asm, Layout, *Sections[i]);
+  for (unsigned i = 0, j = 0; i < NumRegularSections + 1; ++i) {
+    const SmallVectorImpl<char> *Contents = 0;
+    if (j != RenderedSections.size() &&
+        RenderedSections[j] == &Asm.getOrCreateSectionData(*Sections[i]))
+      Contents = &RenderedContents[j++];
+    WriteDataSectionData(Asm, Layout, *Sections[i], Contents);
+  }
 
   uint64_t Padding = OffsetToAlignment(OS.tell(), NaturalAlignment);
   WriteZeros(Padding);
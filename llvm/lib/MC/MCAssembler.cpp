@@ -9,6 +9,8 @@
 
 #define DEBUG_TYPE "assembler"
 #include "llvm/MC/MCAssembler.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
@@ -23,11 +25,16 @@
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LEB128.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <deque>
 
 using namespace llvm;
 
@@ -51,9 +58,27 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxationVisits, "Number of fragments examined for relaxation");
 }
 }
 
+static cl::opt<unsigned>
+AssemblerThreads("mc-assembler-threads", cl::Hidden,
+                 cl::desc("Number of threads used to relax and write the "
+                          "sections of an object file"),
+                 cl::init(0));
+
+static cl::opt<bool>
+TimeAssembler("time-mc-assembler", cl::Hidden,
+              cl::desc("Time the phases of the assembler backend"));
+
+static cl::opt<bool>
+RelaxWithWorklist("mc-relax-worklist", cl::Hidden, cl::init(true),
+                  cl::desc("Only re-examine the fragments whose dependencies "
+                           "moved during relaxation"));
+
+static const char *const TimerGroupName = "Assembler Backend";
+
 // FIXME FIXME FIXME: There are number of places in this file where we convert
 // what is a 64-bit assembler value used for computation into a value in the
 // object file, which may truncate it. We should detect that truncation where
@@ -62,7 +87,7 @@ STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
 /* *** */
 
 MCAsmLayout::MCAsmLayout(MCAssembler &Asm)
-  : Assembler(Asm), LastValidFragment()
+  : Assembler(Asm), LastValidFragment(), DependentsSorted(true)
  {
   // Compute the section layout order. Virtual sections must go last.
   for (MCAssembler::iterator it = Asm.begin(), ie = Asm.end(); it != ie; ++it)
@@ -93,6 +118,138 @@ void MCAsmLayout::invalidateFragmentsFrom(MCFragment *F) {
   LastValidFragment[&SD] = F->getPrevNode();
 }
 
+void MCAsmLayout::addDependent(const MCFragment *First, const MCFragment *Last,
+                               MCFragment *Dependent) {
+  SectionDependents &SD = Dependents[Last->getParent()];
+  if (First) {
+    assert(First->getParent() == Last->getParent() &&
+           First->getLayoutOrder() <= Last->getLayoutOrder() &&
+           "Invalid dependent span!");
+    DependentSpan Span = { First->getLayoutOrder(), Last->getLayoutOrder(),
+                           Dependent };
+    // Fragments at the same place have a fixed distance.
+    if (Span.Begin == Span.End)
+      return;
+    SD.Spans.push_back(Span);
+    SD.MaxSpan = std::max(SD.MaxSpan, Span.End - Span.Begin);
+  } else {
+    SD.Offsets.push_back(std::make_pair(Last->getLayoutOrder(), Dependent));
+  }
+  DependentsSorted = false;
+}
+
+namespace {
+struct SpanBeginLess {
+  template <typename SpanTy>
+  bool operator()(const SpanTy &LHS, const SpanTy &RHS) const {
+    return LHS.Begin < RHS.Begin;
+  }
+};
+
+struct PaddingOrderLess {
+  template <typename PaddingTy>
+  bool operator()(const PaddingTy &LHS, const PaddingTy &RHS) const {
+    return LHS.Frag->getLayoutOrder() < RHS.Frag->getLayoutOrder();
+  }
+};
+}
+
+void MCAsmLayout::finishDependents() {
+  // Keep the dependents of a fragment in the order they were added, so that
+  // relaxation visits them in a deterministic order.
+  for (DenseMap<const MCSectionData*, SectionDependents>::iterator
+         it = Dependents.begin(), ie = Dependents.end(); it != ie; ++it) {
+    SectionDependents &SD = it->second;
+    std::stable_sort(SD.Spans.begin(), SD.Spans.end(), SpanBeginLess());
+    std::stable_sort(SD.Offsets.begin(), SD.Offsets.end(), less_first());
+
+    SD.Padding.clear();
+    for (MCSectionData::const_iterator I = it->first->begin(),
+           IE = it->first->end(); I != IE; ++I) {
+      if (I->getKind() != MCFragment::FT_Align &&
+          I->getKind() != MCFragment::FT_Org)
+        continue;
+      PaddingState P = { const_cast<MCFragment*>(&*I), getFragmentOffset(&*I),
+                         Assembler.computeFragmentSize(*this, *I) };
+      SD.Padding.push_back(P);
+    }
+  }
+  DependentsSorted = true;
+}
+
+void MCAsmLayout::getSpansContaining(const SectionDependents &SD,
+                                     unsigned Order,
+                                     SmallVectorImpl<MCFragment*> &Result) {
+  // None of the spans can begin more than MaxSpan fragments before Order.
+  unsigned FirstBegin = Order < SD.MaxSpan ? 0 : Order - SD.MaxSpan + 1;
+  DependentSpan Key = { FirstBegin, 0, 0 };
+  for (std::vector<DependentSpan>::const_iterator
+         SI = std::lower_bound(SD.Spans.begin(), SD.Spans.end(), Key,
+                               SpanBeginLess()),
+         SE = SD.Spans.end(); SI != SE && SI->Begin <= Order; ++SI)
+    if (Order < SI->End)
+      Result.push_back(SI->Dependent);
+}
+
+void MCAsmLayout::getDependentsOfResize(const MCFragment *F,
+                                        SmallVectorImpl<MCFragment*> &Result) {
+  assert(DependentsSorted && "Dependents changed after finishDependents!");
+
+  DenseMap<const MCSectionData*, SectionDependents>::iterator it =
+    Dependents.find(F->getParent());
+  if (it == Dependents.end())
+    return;
+  SectionDependents &SD = it->second;
+
+  // Resizing F moves every fragment after it.
+  unsigned Order = F->getLayoutOrder();
+  std::vector<std::pair<unsigned, MCFragment*> >::const_iterator OI =
+    std::upper_bound(SD.Offsets.begin(), SD.Offsets.end(),
+                     std::make_pair(Order, static_cast<MCFragment*>(0)),
+                     less_first());
+  for (; OI != SD.Offsets.end(); ++OI)
+    Result.push_back(OI->second);
+
+  // Only the spans with Begin <= Order < End change.
+  getSpansContaining(SD, Order, Result);
+
+  // The alignment and org fragments after F move, and may change size with
+  // it. The first of them is examined in turn.
+  PaddingState Key = { const_cast<MCFragment*>(F), 0, 0 };
+  std::vector<PaddingState>::const_iterator PI =
+    std::upper_bound(SD.Padding.begin(), SD.Padding.end(), Key,
+                     PaddingOrderLess());
+  if (PI != SD.Padding.end())
+    Result.push_back(PI->Frag);
+}
+
+void MCAsmLayout::getDependentsOfPadding(MCFragment *F,
+                                         SmallVectorImpl<MCFragment*> &Result) {
+  assert(DependentsSorted && "Dependents changed after finishDependents!");
+  SectionDependents &SD = Dependents.find(F->getParent())->second;
+  PaddingState Key = { F, 0, 0 };
+  std::vector<PaddingState>::iterator PI =
+    std::lower_bound(SD.Padding.begin(), SD.Padding.end(), Key,
+                     PaddingOrderLess());
+  assert(PI != SD.Padding.end() && PI->Frag == F && "Not a padding fragment!");
+
+  uint64_t Offset = getFragmentOffset(F);
+  uint64_t Size = Assembler.computeFragmentSize(*this, *F);
+  bool Resized = Size != PI->Size;
+  bool Moved = Offset + Size != PI->Offset + PI->Size;
+  PI->Offset = Offset;
+  PI->Size = Size;
+
+  // A change of size acts like a resize of F, but only the distances that F
+  // is part of change, as the offsets after F were already revisited.
+  if (Resized)
+    getSpansContaining(SD, F->getLayoutOrder(), Result);
+  // If F still ends where it did, nothing after it has moved since the next
+  // padding fragment was last examined.
+  if (Moved && ++PI != SD.Padding.end())
+    Result.push_back(PI->Frag);
+}
+
 void MCAsmLayout::ensureValid(const MCFragment *F) const {
   MCSectionData &SD = *F->getParent();
 
@@ -295,7 +452,8 @@ MCAssembler::MCAssembler(MCContext &Context_, MCAsmBackend &Backend_,
                          raw_ostream &OS_)
   : Context(Context_), Backend(Backend_), Emitter(Emitter_), Writer(Writer_),
     OS(OS_), BundleAlignSize(0), RelaxAll(false), NoExecStack(false),
-    SubsectionsViaSymbols(false), ELFHeaderEFlags(0) {
+    SubsectionsViaSymbols(false), ELFHeaderEFlags(0),
+    NumThreads(AssemblerThreads), Pool(0), EmitterLock(0) {
 }
 
 MCAssembler::~MCAssembler() {
@@ -534,9 +692,7 @@ static void writeFragmentContents(const MCFragment &F, MCObjectWriter *OW) {
 
 /// \brief Write the fragment \p F to the output file.
 static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
-                          const MCFragment &F) {
-  MCObjectWriter *OW = &Asm.getWriter();
-
+                          const MCFragment &F, MCObjectWriter *OW) {
   // FIXME: Embed in fragments instead?
   uint64_t FragmentSize = Asm.computeFragmentSize(Layout, F);
 
@@ -682,6 +838,22 @@ static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
          "The stream should advance by fragment size");
 }
 
+/// \brief Write the fragments of the non-virtual section \p SD to \p OW.
+static void writeSectionContents(const MCAssembler &Asm,
+                                 const MCSectionData *SD,
+                                 const MCAsmLayout &Layout,
+                                 MCObjectWriter *OW) {
+  uint64_t Start = OW->getStream().tell();
+  (void)Start;
+
+  for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
+       it != ie; ++it)
+    writeFragment(Asm, Layout, *it, OW);
+
+  assert(OW->getStream().tell() - Start ==
+         Layout.getSectionAddressSize(SD));
+}
+
 void MCAssembler::writeSectionData(const MCSectionData *SD,
                                    const MCAsmLayout &Layout) const {
   // Ignore virtual sections.
@@ -723,15 +895,76 @@ void MCAssembler::writeSectionData(const MCSectionData *SD,
     return;
   }
 
-  uint64_t Start = getWriter().getStream().tell();
-  (void)Start;
+  writeSectionContents(*this, SD, Layout, &getWriter());
+}
 
-  for (MCSectionData::const_iterator it = SD->begin(), ie = SD->end();
-       it != ie; ++it)
-    writeFragment(*this, Layout, *it);
+namespace {
+/// SectionContentsWriter - An object writer that only serves to write section
+/// contents to a buffer, in the byte order of the real object writer.
+class SectionContentsWriter : public MCObjectWriter {
+public:
+  SectionContentsWriter(raw_ostream &OS, bool IsLittleEndian)
+    : MCObjectWriter(OS, IsLittleEndian) {}
+
+  virtual void ExecutePostLayoutBinding(MCAssembler &Asm,
+                                        const MCAsmLayout &Layout) {
+    llvm_unreachable("Section contents writer cannot bind symbols");
+  }
 
-  assert(getWriter().getStream().tell() - Start ==
-         Layout.getSectionAddressSize(SD));
+  virtual void RecordRelocation(const MCAssembler &Asm,
+                                const MCAsmLayout &Layout,
+                                const MCFragment *Fragment,
+                                const MCFixup &Fixup, MCValue Target,
+                                uint64_t &FixedValue) {
+    llvm_unreachable("Section contents writer cannot record relocations");
+  }
+
+  virtual void WriteObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
+    llvm_unreachable("Section contents writer cannot write objects");
+  }
+};
+
+/// WriteSectionTask - The arguments of a task writing one section to a buffer.
+struct WriteSectionTask {
+  const MCAssembler *Asm;
+  const MCAsmLayout *Layout;
+  const MCSectionData *SD;
+  SmallString<0> *Contents;
+
+  static void run(void *Arg) {
+    WriteSectionTask &T = *static_cast<WriteSectionTask *>(Arg);
+    raw_svector_ostream VecOS(*T.Contents);
+    SectionContentsWriter OW(VecOS, T.Asm->getWriter().isLittleEndian());
+    writeSectionContents(*T.Asm, T.SD, *T.Layout, &OW);
+    VecOS.flush();
+  }
+};
+}
+
+void MCAssembler::writeSectionDataConcurrently(
+    ArrayRef<const MCSectionData *> Sections, const MCAsmLayout &Layout,
+    std::vector<SmallString<0> > &Contents) const {
+  Contents.clear();
+  Contents.resize(Sections.size());
+
+  std::vector<WriteSectionTask> Tasks;
+  for (unsigned i = 0, e = Sections.size(); i != e; ++i) {
+    if (Sections[i]->getSection().isVirtualSection())
+      continue;
+    WriteSectionTask T = { this, &Layout, Sections[i], &Contents[i] };
+    Tasks.push_back(T);
+  }
+
+  if (!Pool) {
+    for (unsigned i = 0, e = Tasks.size(); i != e; ++i)
+      WriteSectionTask::run(&Tasks[i]);
+    return;
+  }
+
+  TaskGroup Group(*Pool);
+  for (unsigned i = 0, e = Tasks.size(); i != e; ++i)
+    Group.spawn(WriteSectionTask::run, &Tasks[i]);
+  Group.wait();
 }
 
 
@@ -780,16 +1013,34 @@ void MCAssembler::Finish() {
       iFrag->setLayoutOrder(FragmentIndex++);
   }
 
-  // Layout until everything fits.
-  while (layoutOnce(Layout))
-    continue;
+  // With several threads, the pool lives until the object has been written.
+  OwningPtr<ThreadPool> Threads;
+  if (NumThreads > 1) {
+    Threads.reset(new ThreadPool(NumThreads));
+    Pool = Threads.get();
+  }
 
-  DEBUG_WITH_TYPE("mc-dump", {
-      llvm::errs() << "assembler backend - post-relaxation\n--\n";
-      dump(); });
+  {
+    NamedRegionTimer T("Layout and relaxation", TimerGroupName,
+                       TimeAssembler);
 
-  // Finalize the layout, including fragment lowering.
-  finishLayout(Layout);
+    // Layout until everything fits.
+    if (RelaxWithWorklist && !isBundlingEnabled()) {
+      // Bundle padding can move a fragment when it is resized itself, which
+      // the worklist does not track.
+      layoutWithWorklist(Layout);
+    } else {
+      while (layoutOnce(Layout))
+        continue;
+    }
+
+    DEBUG_WITH_TYPE("mc-dump", {
+        llvm::errs() << "assembler backend - post-relaxation\n--\n";
+        dump(); });
+
+    // Finalize the layout, including fragment lowering.
+    finishLayout(Layout);
+  }
 
   DEBUG_WITH_TYPE("mc-dump", {
       llvm::errs() << "assembler backend - final-layout\n--\n";
@@ -797,30 +1048,43 @@ void MCAssembler::Finish() {
 
   uint64_t StartOffset = OS.tell();
 
-  // Allow the object writer a chance to perform post-layout binding (for
-  // example, to set the index fields in the symbol data).
-  getWriter().ExecutePostLayoutBinding(*this, Layout);
-
-  // Evaluate and apply the fixups, generating relocation entries as necessary.
-  for (MCAssembler::iterator it = begin(), ie = end(); it != ie; ++it) {
-    for (MCSectionData::iterator it2 = it->begin(),
-           ie2 = it->end(); it2 != ie2; ++it2) {
-      MCEncodedFragmentWithFixups *F =
-        dyn_cast<MCEncodedFragmentWithFixups>(it2);
-      if (F) {
-        for (MCEncodedFragmentWithFixups::fixup_iterator it3 = F->fixup_begin(),
-             ie3 = F->fixup_end(); it3 != ie3; ++it3) {
-          MCFixup &Fixup = *it3;
-          uint64_t FixedValue = handleFixup(Layout, *F, Fixup);
-          getBackend().applyFixup(Fixup, F->getContents().data(),
-                                  F->getContents().size(), FixedValue);
+  {
+    NamedRegionTimer T("Fixup evaluation", TimerGroupName, TimeAssembler);
+
+    // Allow the object writer a chance to perform post-layout binding (for
+    // example, to set the index fields in the symbol data).
+    getWriter().ExecutePostLayoutBinding(*this, Layout);
+
+    // Evaluate and apply the fixups, generating relocation entries as
+    // necessary. This stays serial: the object writer records the relocations
+    // in order.
+    for (MCAssembler::iterator it = begin(), ie = end(); it != ie; ++it) {
+      for (MCSectionData::iterator it2 = it->begin(),
+             ie2 = it->end(); it2 != ie2; ++it2) {
+        MCEncodedFragmentWithFixups *F =
+          dyn_cast<MCEncodedFragmentWithFixups>(it2);
+        if (F) {
+          for (MCEncodedFragmentWithFixups::fixup_iterator
+                 it3 = F->fixup_begin(), ie3 = F->fixup_end();
+               it3 != ie3; ++it3) {
+            MCFixup &Fixup = *it3;
+            uint64_t FixedValue = handleFixup(Layout, *F, Fixup);
+            getBackend().applyFixup(Fixup, F->getContents().data(),
+                                    F->getContents().size(), FixedValue);
+          }
         }
       }
     }
   }
 
-  // Write the object file.
-  getWriter().WriteObject(*this, Layout);
+  {
+    NamedRegionTimer T("Object writing", TimerGroupName, TimeAssembler);
+
+    // Write the object file.
+    getWriter().WriteObject(*this, Layout);
+  }
+
+  Pool = 0;
 
   stats::ObjectBytes += OS.tell() - StartOffset;
 }
@@ -875,7 +1139,11 @@ bool MCAssembler::relaxInstruction(MCAsmLayout &Layout,
   SmallVector<MCFixup, 4> Fixups;
   SmallString<256> Code;
   raw_svector_ostream VecOS(Code);
+  if (EmitterLock)
+    EmitterLock->acquire();
   getEmitter().EncodeInstruction(Relaxed, VecOS, Fixups);
+  if (EmitterLock)
+    EmitterLock->release();
   VecOS.flush();
 
   // Update the fragment.
@@ -937,42 +1205,58 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+/// \brief Check whether fragments of the given kind may change size during
+/// relaxation.
+static bool isRelaxableKind(MCFragment::FragmentType Kind) {
+  switch (Kind) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+  case MCFragment::FT_Dwarf:
+  case MCFragment::FT_DwarfFrame:
+  case MCFragment::FT_LEB:
+    return true;
+  }
+}
+
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  if (!isRelaxableKind(F.getKind()))
+    return false;
+  ++stats::RelaxationVisits;
+
+  switch(F.getKind()) {
+  default:
+    llvm_unreachable("Unexpected relaxable fragment kind!");
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  }
+}
+
+MCFragment *MCAssembler::relaxSection(MCAsmLayout &Layout, MCSectionData &SD) {
   // Holds the first fragment which needed relaxing during this layout. It will
   // remain NULL if none were relaxed.
-  // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = NULL;
 
   // Attempt to relax all the fragments in the section.
-  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
-    default:
-      break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
-    case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
-      break;
-    case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
-      break;
-    case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
-      break;
-    }
-    if (RelaxedFrag && !FirstRelaxedFragment)
+  for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I)
+    if (relaxFragment(Layout, *I) && !FirstRelaxedFragment)
       FirstRelaxedFragment = I;
-  }
-  if (FirstRelaxedFragment) {
+  return FirstRelaxedFragment;
+}
+
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+  // When a fragment is relaxed, all the fragments following it should get
+  // invalidated because their offset is going to change.
+  if (MCFragment *FirstRelaxedFragment = relaxSection(Layout, SD)) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
     return true;
   }
@@ -992,6 +1276,211 @@ bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
   return WasRelaxed;
 }
 
+/// \brief Collect the fragments whose offsets the value of \p Expr depends on.
+/// Returns false if the expression has target specific parts, which cannot be
+/// analyzed.
+static bool collectExprFragments(const MCAssembler &Asm, const MCExpr *Expr,
+                                 SmallVectorImpl<const MCFragment*> &Frags) {
+  switch (Expr->getKind()) {
+  case MCExpr::Target:
+    return false;
+  case MCExpr::Constant:
+    return true;
+  case MCExpr::Binary: {
+    const MCBinaryExpr *BE = cast<MCBinaryExpr>(Expr);
+    bool LHS = collectExprFragments(Asm, BE->getLHS(), Frags);
+    bool RHS = collectExprFragments(Asm, BE->getRHS(), Frags);
+    return LHS && RHS;
+  }
+  case MCExpr::Unary:
+    return collectExprFragments(Asm, cast<MCUnaryExpr>(Expr)->getSubExpr(),
+                                Frags);
+  case MCExpr::SymbolRef: {
+    const MCSymbol &Sym = cast<MCSymbolRefExpr>(Expr)->getSymbol();
+    if (Sym.isVariable())
+      return collectExprFragments(Asm, Sym.getVariableValue(), Frags);
+    if (Sym.isDefined())
+      if (const MCFragment *Def = Asm.getSymbolData(Sym).getFragment())
+        Frags.push_back(Def);
+    return true;
+  }
+  }
+  llvm_unreachable("Invalid expression kind!");
+}
+
+/// \brief Record in the layout which fragments decide whether \p F needs
+/// relaxation. Returns false if they cannot be determined. \p Isolated is
+/// cleared if one of them is in another section.
+static bool addFragmentDependencies(const MCAssembler &Asm,
+                                    MCAsmLayout &Layout, MCFragment *F,
+                                    bool &Isolated) {
+  SmallVector<const MCFragment*, 4> Frags;
+  bool Known = true;
+  switch (F->getKind()) {
+  default:
+    llvm_unreachable("Unexpected relaxable fragment kind!");
+  case MCFragment::FT_Relaxable: {
+    MCRelaxableFragment &RF = *cast<MCRelaxableFragment>(F);
+    if (!Asm.getBackend().mayNeedRelaxation(RF.getInst()))
+      return true;
+    for (MCRelaxableFragment::const_fixup_iterator it = RF.fixup_begin(),
+           ie = RF.fixup_end(); it != ie; ++it) {
+      Known &= collectExprFragments(Asm, it->getValue(), Frags);
+      // PC-relative fixups also depend on the offset of the fragment itself.
+      if (Asm.getBackend().getFixupKindInfo(it->getKind()).Flags &
+          MCFixupKindInfo::FKF_IsPCRel)
+        Frags.push_back(F);
+    }
+    break;
+  }
+  case MCFragment::FT_Dwarf:
+    Known = collectExprFragments(
+        Asm, &cast<MCDwarfLineAddrFragment>(F)->getAddrDelta(), Frags);
+    break;
+  case MCFragment::FT_DwarfFrame:
+    Known = collectExprFragments(
+        Asm, &cast<MCDwarfCallFrameFragment>(F)->getAddrDelta(), Frags);
+    break;
+  case MCFragment::FT_LEB:
+    Known = collectExprFragments(Asm, &cast<MCLEBFragment>(F)->getValue(),
+                                 Frags);
+    break;
+  }
+
+  // The value of a resolved expression only depends on the distances between
+  // the fragments of a section that it refers to more than once, as in A - B.
+  // A single reference depends on the offset within the section.
+  for (unsigned i = 0, e = Frags.size(); i != e; ++i) {
+    const MCFragment *First = Frags[i], *Last = Frags[i];
+    if (!First)
+      continue;
+    unsigned Count = 0;
+    for (unsigned j = i; j != e; ++j) {
+      if (!Frags[j] || Frags[j]->getParent() != First->getParent())
+        continue;
+      if (Frags[j]->getLayoutOrder() < First->getLayoutOrder())
+        First = Frags[j];
+      if (Frags[j]->getLayoutOrder() > Last->getLayoutOrder())
+        Last = Frags[j];
+      Frags[j] = 0;
+      ++Count;
+    }
+    Layout.addDependent(Count > 1 ? First : 0, Last, F);
+    if (First->getParent() != F->getParent())
+      Isolated = false;
+  }
+  return Known;
+}
+
+namespace {
+/// RelaxSectionTask - The arguments of a task relaxing one section.
+struct RelaxSectionTask {
+  MCAssembler *Asm;
+  MCAsmLayout *Layout;
+  MCSectionData *SD;
+  SmallVector<MCFragment*, 32> Fragments;
+};
+}
+
+void MCAssembler::relaxSectionTask(void *Arg) {
+  RelaxSectionTask &T = *static_cast<RelaxSectionTask *>(Arg);
+  T.Asm->relaxWithWorklist(*T.Layout, T.Fragments, ArrayRef<MCFragment*>(),
+                           T.SD);
+}
+
+void MCAssembler::relaxWithWorklist(MCAsmLayout &Layout,
+                                    ArrayRef<MCFragment*> Fragments,
+                                    ArrayRef<MCFragment*> Unanalyzable,
+                                    const MCSectionData *Only) {
+  std::deque<MCFragment*> Worklist(Fragments.begin(), Fragments.end());
+  SmallPtrSet<MCFragment*, 32> InWorklist;
+  for (unsigned i = 0, e = Fragments.size(); i != e; ++i)
+    InWorklist.insert(Fragments[i]);
+
+  SmallVector<MCFragment*, 16> Moved;
+  while (!Worklist.empty()) {
+    MCFragment *F = Worklist.front();
+    Worklist.pop_front();
+    InWorklist.erase(F);
+
+    Moved.clear();
+    if (F->getKind() == MCFragment::FT_Align ||
+        F->getKind() == MCFragment::FT_Org) {
+      // A fragment before F was resized, so F may have changed size too.
+      Layout.getDependentsOfPadding(F, Moved);
+    } else {
+      if (!relaxFragment(Layout, *F))
+        continue;
+
+      // Everything after F in its section moves, so re-examine the fragments
+      // whose distances or offsets changed.
+      Layout.invalidateFragmentsFrom(F);
+      Layout.getDependentsOfResize(F, Moved);
+      Moved.append(Unanalyzable.begin(), Unanalyzable.end());
+    }
+    for (unsigned i = 0, e = Moved.size(); i != e; ++i)
+      if ((!Only || Moved[i]->getParent() == Only) &&
+          InWorklist.insert(Moved[i]))
+        Worklist.push_back(Moved[i]);
+  }
+}
+
+void MCAssembler::layoutWithWorklist(MCAsmLayout &Layout) {
+  ++stats::RelaxationSteps;
+
+  // With several threads, the sections whose relaxation only depends on
+  // their own layout are relaxed concurrently, one task each. Everything
+  // else is relaxed on the calling thread once they are done.
+  std::vector<RelaxSectionTask> Tasks;
+  SmallVector<MCFragment*, 32> Fragments;
+  // Fragments whose dependencies are unknown are examined again whenever any
+  // fragment has been resized.
+  SmallVector<MCFragment*, 4> Unanalyzable;
+
+  for (iterator it = begin(), ie = end(); it != ie; ++it) {
+    RelaxSectionTask T;
+    T.Asm = this;
+    T.Layout = &Layout;
+    T.SD = &*it;
+    bool Isolated = true;
+    for (MCSectionData::iterator I = it->begin(), IE = it->end(); I != IE;
+         ++I) {
+      if (!isRelaxableKind(I->getKind()))
+        continue;
+      T.Fragments.push_back(I);
+      if (!addFragmentDependencies(*this, Layout, I, Isolated)) {
+        Unanalyzable.push_back(I);
+        Isolated = false;
+      }
+    }
+    if (Pool && Isolated) {
+      if (!T.Fragments.empty())
+        Tasks.push_back(T);
+    } else {
+      Fragments.append(T.Fragments.begin(), T.Fragments.end());
+    }
+  }
+  Layout.finishDependents();
+
+  if (!Tasks.empty()) {
+    // Lay out every fragment up front, so that the tasks only change the
+    // layout of their own section.
+    finishLayout(Layout);
+
+    sys::MutexImpl Lock;
+    EmitterLock = &Lock;
+    {
+      TaskGroup Group(*Pool);
+      for (unsigned i = 0, e = Tasks.size(); i != e; ++i)
+        Group.spawn(relaxSectionTask, &Tasks[i]);
+      Group.wait();
+    }
+    EmitterLock = 0;
+  }
+
+  relaxWithWorklist(Layout, Fragments, Unanalyzable, 0);
+}
+
 void MCAssembler::finishLayout(MCAsmLayout &Layout) {
   // The layout is done. Mark every fragment as valid.
   for (unsigned int i = 0, n = Layout.getSectionOrder().size(); i != n; ++i) {
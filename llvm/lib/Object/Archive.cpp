@@ -14,9 +14,12 @@
 #include "llvm/Object/Archive.h"
 #include "llvm/ADT/APInt.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <cstring>
 
 using namespace llvm;
 using namespace object;
@@ -194,7 +197,8 @@ error_code Archive::Child::getAsBinary(OwningPtr<Binary> &Result) const {
 }
 
 Archive::Archive(MemoryBuffer *source, error_code &ec)
-  : Binary(Binary::ID_Archive, source), SymbolTable(end_children()) {
+  : Binary(Binary::ID_Archive, source), SymbolTable(end_children()),
+    SymbolIndexBuilt(false) {
   // Check for sufficient magic.
   assert(source);
   if (source->getBufferSize() < 8 ||
@@ -325,8 +329,23 @@ Archive::child_iterator Archive::end_children() const {
   return Child(this, NULL);
 }
 
+/// getSymbolName - Return the NUL-terminated name at Offset in the symbol
+/// table Table, or a null StringRef if it runs past the end of the table.
+/// Archives are mapped without a terminator, so the search is bounded.
+static StringRef getSymbolName(StringRef Table, uint32_t Offset) {
+  if (Offset >= Table.size())
+    return StringRef();
+  const char *Start = Table.data() + Offset;
+  const void *End = memchr(Start, '\0', Table.size() - Offset);
+  if (!End)
+    return StringRef();
+  return StringRef(Start, static_cast<const char *>(End) - Start);
+}
+
 error_code Archive::Symbol::getName(StringRef &Result) const {
-  Result = StringRef(Parent->SymbolTable->getBuffer().begin() + StringIndex);
+  Result = getSymbolName(Parent->SymbolTable->getBuffer(), StringIndex);
+  if (!Result.data())
+    return object_error::parse_failed;
   return object_error::success;
 }
 
@@ -377,9 +396,11 @@ error_code Archive::Symbol::getMember(child_iterator &Result) const {
 
 Archive::Symbol Archive::Symbol::getNext() const {
   Symbol t(*this);
-  // Go to one past next null.
-  t.StringIndex =
-      Parent->SymbolTable->getBuffer().find('\0', t.StringIndex) + 1;
+  // Go to one past next null, or to the end of a truncated table, where
+  // getName fails.
+  StringRef Table = Parent->SymbolTable->getBuffer();
+  size_t Null = Table.find('\0', t.StringIndex);
+  t.StringIndex = Null == StringRef::npos ? Table.size() : Null + 1;
   ++t.SymbolIndex;
   return t;
 }
@@ -427,22 +448,81 @@ Archive::symbol_iterator Archive::end_symbols() const {
     Symbol(this, symbol_count, 0));
 }
 
+/// buildSymbolIndex - Enter the name of every symbol in the symbol table into
+/// an open-addressed hash table, keeping the first symbol of each name as the
+/// linear scan of the symbol table would find it.
+void Archive::buildSymbolIndex() const {
+  if (!hasSymbolTable())
+    return;
+
+  StringRef Table = SymbolTable->getBuffer();
+  for (symbol_iterator I = begin_symbols(), E = end_symbols(); I != E; ++I) {
+    StringRef Name;
+    if (I->getName(Name))
+      break;
+    SymbolNameOffsets.push_back(Name.data() - Table.data());
+  }
+
+  // Keep the load factor at or below one half.
+  unsigned NumSlots = 1;
+  while (NumSlots < SymbolNameOffsets.size() * 2)
+    NumSlots <<= 1;
+  SymbolIndexEntry Empty = { 0, 0 };
+  SymbolIndex.assign(NumSlots, Empty);
+
+  for (uint32_t I = 0, E = SymbolNameOffsets.size(); I != E; ++I) {
+    StringRef Name = getSymbolName(Table, SymbolNameOffsets[I]);
+    uint32_t Hash = HashString(Name);
+    for (unsigned Slot = Hash & (NumSlots - 1);;
+         Slot = (Slot + 1) & (NumSlots - 1)) {
+      SymbolIndexEntry &Entry = SymbolIndex[Slot];
+      if (Entry.SymbolNumber == 0) {
+        Entry.Hash = Hash;
+        Entry.SymbolNumber = I + 1;
+        break;
+      }
+      if (Entry.Hash == Hash &&
+          Name == getSymbolName(Table,
+                                SymbolNameOffsets[Entry.SymbolNumber - 1]))
+        break;
+    }
+  }
+}
+
 Archive::child_iterator Archive::findSym(StringRef name) const {
-  Archive::symbol_iterator bs = begin_symbols();
-  Archive::symbol_iterator es = end_symbols();
-  Archive::child_iterator result;
-  
-  StringRef symname;
-  for (; bs != es; ++bs) {
-    if (bs->getName(symname))
-        return end_children();
-    if (symname == name) {
-      if (bs->getMember(result))
-        return end_children();
-      return result;
+  // Double-checked: the fence orders the read of SymbolIndexBuilt before the
+  // reads of the index, pairing with the fence before it is set.
+  bool Built = SymbolIndexBuilt;
+  sys::MemoryFence();
+  if (!Built) {
+    sys::ScopedLock Lock(SymbolIndexLock);
+    if (!SymbolIndexBuilt) {
+      buildSymbolIndex();
+      sys::MemoryFence();
+      SymbolIndexBuilt = true;
     }
   }
-  return end_children();
+  if (SymbolIndex.empty())
+    return end_children();
+
+  StringRef Table = SymbolTable->getBuffer();
+  uint32_t Hash = HashString(name);
+  unsigned Mask = SymbolIndex.size() - 1;
+  for (unsigned Slot = Hash & Mask;; Slot = (Slot + 1) & Mask) {
+    const SymbolIndexEntry &Entry = SymbolIndex[Slot];
+    if (Entry.SymbolNumber == 0)
+      return end_children();
+    uint32_t Index = Entry.SymbolNumber - 1;
+    if (Entry.Hash != Hash ||
+        name != getSymbolName(Table, SymbolNameOffsets[Index]))
+      continue;
+
+    Archive::child_iterator result;
+    Symbol Sym(this, Index, SymbolNameOffsets[Index]);
+    if (Sym.getMember(result))
+      return end_children();
+    return result;
+  }
 }
 
 bool Archive::hasSymbolTable() const {
@@ -110,8 +110,10 @@ error_code object::createBinary(MemoryBuffer *Source,
 }
 
 error_code object::createBinary(StringRef Path, OwningPtr<Binary> &Result) {
+  // The object file readers do not need a null terminator, and without one the
+  // file is always mapped rather than read, which matters for large archives.
   OwningPtr<MemoryBuffer> File;
-  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File))
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File, -1, false))
     return ec;
   return createBinary(File.take(), Result);
 }
@@ -0,0 +1,196 @@
+//===- PGOProfile.cpp - Instrumented profile data -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the reader and writer of the counter profiles used by
+// -pgo-instr-gen and -pgo-instr-use.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/PGOProfile.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+using namespace llvm;
+
+const char PGOProfile::Magic[8] = { '\xff', 'p', 'g', 'o', 'd', 'a', 't',
+                                    '\0' };
+
+namespace {
+/// ProfileCursor - Reads the ULEB128 fields of a profile, failing instead of
+/// reading past its end.
+class ProfileCursor {
+  const uint8_t *Ptr, *End;
+
+public:
+  ProfileCursor(StringRef Data)
+    : Ptr(reinterpret_cast<const uint8_t*>(Data.begin())),
+      End(reinterpret_cast<const uint8_t*>(Data.end())) {}
+
+  bool atEnd() const { return Ptr == End; }
+
+  /// readULEB128 - Read one number into Value, return false if the data ends
+  /// first or the number does not fit in 64 bits.
+  bool readULEB128(uint64_t &Value) {
+    Value = 0;
+    for (unsigned Shift = 0; Ptr != End; Shift += 7) {
+      uint64_t Byte = *Ptr++;
+      if (Shift >= 64 || (Shift == 63 && (Byte & 0x7e)))
+        return false;
+      Value |= (Byte & 0x7f) << Shift;
+      if (Byte < 128)
+        return true;
+    }
+    return false;
+  }
+
+  /// readBytes - Read Size bytes, return false if the data ends first.
+  bool readBytes(uint64_t Size, StringRef &Bytes) {
+    if (Size > uint64_t(End - Ptr))
+      return false;
+    Bytes = StringRef(reinterpret_cast<const char*>(Ptr), Size);
+    Ptr += Size;
+    return true;
+  }
+};
+}
+
+bool PGOProfileReader::parse(StringRef Data, std::string &Error) {
+  if (!Data.startswith(StringRef(PGOProfile::Magic,
+                                 sizeof(PGOProfile::Magic)))) {
+    Error = "not a profile: bad magic";
+    return false;
+  }
+  ProfileCursor Cursor(Data.substr(sizeof(PGOProfile::Magic)));
+
+  uint64_t Version, NumFunctions;
+  if (!Cursor.readULEB128(Version) || !Cursor.readULEB128(NumFunctions)) {
+    Error = "truncated profile header";
+    return false;
+  }
+  if (Version != PGOProfile::Version) {
+    Error = "unsupported profile version " + Twine(Version).str();
+    return false;
+  }
+
+  for (uint64_t i = 0; i != NumFunctions; ++i) {
+    uint64_t NameSize, Hash, NumCounts;
+    StringRef Name;
+    if (!Cursor.readULEB128(NameSize) || !Cursor.readBytes(NameSize, Name) ||
+        !Cursor.readULEB128(Hash) || !Cursor.readULEB128(NumCounts)) {
+      Error = "truncated profile record " + Twine(i).str();
+      return false;
+    }
+
+    // Every counter takes at least a byte, which bounds NumCounts before it
+    // is used to size anything.
+    std::vector<uint64_t> Counts;
+    for (uint64_t c = 0; c != NumCounts; ++c) {
+      uint64_t Count;
+      if (!Cursor.readULEB128(Count)) {
+        Error = "truncated counters for '" + Name.str() + "'";
+        return false;
+      }
+      Counts.push_back(Count);
+      MaxCount = std::max(MaxCount, Count);
+    }
+
+    // A profile merged from several programs can hold the same function more
+    // than once.  Add up the copies that agree on its layout and keep the
+    // first of those that do not.
+    StringMap<PGOFunctionProfile>::iterator I = Functions.find(Name);
+    if (I == Functions.end()) {
+      PGOFunctionProfile &FP = Functions[Name];
+      FP.Hash = Hash;
+      FP.Counts.swap(Counts);
+      continue;
+    }
+    PGOFunctionProfile &FP = I->getValue();
+    if (FP.Hash != Hash || FP.Counts.size() != Counts.size())
+      continue;
+    for (unsigned c = 0, e = Counts.size(); c != e; ++c) {
+      FP.Counts[c] += Counts[c];
+      MaxCount = std::max(MaxCount, FP.Counts[c]);
+    }
+  }
+
+  if (!Cursor.atEnd()) {
+    Error = "trailing data after the last profile record";
+    return false;
+  }
+  return true;
+}
+
+PGOProfileReader *PGOProfileReader::create(const MemoryBuffer *Buffer,
+                                           std::string &Error) {
+  OwningPtr<PGOProfileReader> Reader(new PGOProfileReader());
+  if (!Reader->parse(Buffer->getBuffer(), Error))
+    return 0;
+  return Reader.take();
+}
+
+PGOProfileReader *PGOProfileReader::create(StringRef Path,
+                                           std::string &Error) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(Path, Buffer)) {
+    Error = EC.message();
+    return 0;
+  }
+  return create(Buffer.get(), Error);
+}
+
+const PGOFunctionProfile *
+PGOProfileReader::getFunction(StringRef Name) const {
+  StringMap<PGOFunctionProfile>::const_iterator I = Functions.find(Name);
+  if (I == Functions.end())
+    return 0;
+  return &I->getValue();
+}
+
+bool PGOProfileWriter::addFunction(StringRef Name, uint64_t Hash,
+                                   ArrayRef<uint64_t> Counts) {
+  StringMap<PGOFunctionProfile>::iterator I = Functions.find(Name);
+  if (I == Functions.end()) {
+    PGOFunctionProfile &FP = Functions[Name];
+    FP.Hash = Hash;
+    FP.Counts.assign(Counts.begin(), Counts.end());
+    return true;
+  }
+
+  PGOFunctionProfile &FP = I->getValue();
+  if (FP.Hash != Hash || FP.Counts.size() != Counts.size())
+    return false;
+  for (unsigned i = 0, e = Counts.size(); i != e; ++i)
+    FP.Counts[i] += Counts[i];
+  return true;
+}
+
+void PGOProfileWriter::write(raw_ostream &OS) const {
+  std::vector<StringRef> Names;
+  for (StringMap<PGOFunctionProfile>::const_iterator I = Functions.begin(),
+       E = Functions.end(); I != E; ++I)
+    Names.push_back(I->getKey());
+  std::sort(Names.begin(), Names.end());
+
+  OS.write(PGOProfile::Magic, sizeof(PGOProfile::Magic));
+  encodeULEB128(PGOProfile::Version, OS);
+  encodeULEB128(Names.size(), OS);
+  for (unsigned i = 0, e = Names.size(); i != e; ++i) {
+    const PGOFunctionProfile &FP = Functions.find(Names[i])->getValue();
+    encodeULEB128(Names[i].size(), OS);
+    OS << Names[i];
+    encodeULEB128(FP.Hash, OS);
+    encodeULEB128(FP.Counts.size(), OS);
+    for (unsigned c = 0, ce = FP.Counts.size(); c != ce; ++c)
+      encodeULEB128(FP.Counts[c], OS);
+  }
+}
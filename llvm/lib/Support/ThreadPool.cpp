@@ -0,0 +1,359 @@
+//===-- ThreadPool.cpp - A pool of worker threads -------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ThreadPool and TaskGroup classes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/Threading.h"
+
+using namespace llvm;
+
+#if LLVM_ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H)
+#include "llvm/Support/ThreadLocal.h"
+#include <deque>
+#include <pthread.h>
+#include <vector>
+
+namespace {
+/// Task - A spawned task and the group it belongs to.
+struct Task {
+  void (*Fn)(void *);
+  void *Arg;
+  TaskGroup *Group;
+};
+
+/// WorkQueue - The tasks spawned by one worker thread.  The owner takes tasks
+/// from the back, thieves from the front.
+struct WorkQueue {
+  pthread_mutex_t Lock;
+  std::deque<Task> Tasks;
+
+  WorkQueue() { ::pthread_mutex_init(&Lock, 0); }
+  ~WorkQueue() { ::pthread_mutex_destroy(&Lock); }
+};
+
+/// Worker - The start argument of a worker thread.
+struct Worker {
+  ThreadPoolImpl *Pool;
+  unsigned Index;
+};
+} // end anonymous namespace
+
+namespace llvm {
+class ThreadPoolImpl {
+  std::vector<WorkQueue *> Queues;
+  std::vector<Worker> Workers;
+  std::vector<pthread_t> Threads;
+  /// The worker running on the current thread, or null for other threads.
+  sys::ThreadLocal<const Worker> CurrentWorker;
+  /// The number of stolen tasks the current thread is running, or null if it
+  /// is running none and is not a worker.
+  sys::ThreadLocal<const unsigned> StealDepth;
+
+  /// Lock guards the members below and the Pending count of every TaskGroup.
+  pthread_mutex_t Lock;
+  /// Changed is signaled when a task is queued or a TaskGroup is done.
+  pthread_cond_t Changed;
+  /// The number of tasks in the queues.  This is updated after a task is
+  /// pushed or popped, so it may briefly be off by the tasks in transit.
+  int Queued;
+  /// The number of threads waiting on Changed.
+  unsigned Sleeping;
+  /// The queue that the next task spawned by a non-worker thread goes to.
+  unsigned NextQueue;
+  bool ShuttingDown;
+
+  static void *runWorker(void *Arg);
+  bool popTask(Task &T, bool MaySteal, bool &Stolen);
+  bool runTask(bool MaySteal, unsigned &Depth);
+  bool hasOwnTask();
+  void notifyLocked() {
+    if (Sleeping)
+      ::pthread_cond_broadcast(&Changed);
+  }
+
+public:
+  ThreadPoolImpl(unsigned NumThreads, unsigned StackSize);
+  ~ThreadPoolImpl();
+
+  unsigned getNumThreads() const { return Threads.size(); }
+  void spawn(TaskGroup &Group, void (*Fn)(void *), void *Arg);
+  void wait(TaskGroup &Group);
+};
+} // End llvm namespace
+
+ThreadPoolImpl::ThreadPoolImpl(unsigned NumThreads, unsigned StackSize)
+  : Queued(0), Sleeping(0), NextQueue(0), ShuttingDown(false) {
+  ::pthread_mutex_init(&Lock, 0);
+  ::pthread_cond_init(&Changed, 0);
+
+  Queues.resize(NumThreads);
+  Workers.resize(NumThreads);
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    Queues[I] = new WorkQueue();
+    Workers[I].Pool = this;
+    Workers[I].Index = I;
+  }
+
+  // If the stack size cannot be set, the threads get the default one.
+  pthread_attr_t Attr;
+  bool HaveAttr = StackSize && ::pthread_attr_init(&Attr) == 0;
+  if (HaveAttr && ::pthread_attr_setstacksize(&Attr, StackSize) != 0) {
+    ::pthread_attr_destroy(&Attr);
+    HaveAttr = false;
+  }
+
+  // Tasks left in the queue of a thread that could not be started are stolen
+  // by the others.
+  for (unsigned I = 0; I != NumThreads; ++I) {
+    pthread_t Thread;
+    if (::pthread_create(&Thread, HaveAttr ? &Attr : 0, runWorker,
+                         &Workers[I]) == 0)
+      Threads.push_back(Thread);
+  }
+
+  if (HaveAttr)
+    ::pthread_attr_destroy(&Attr);
+}
+
+ThreadPoolImpl::~ThreadPoolImpl() {
+  ::pthread_mutex_lock(&Lock);
+  ShuttingDown = true;
+  ::pthread_cond_broadcast(&Changed);
+  ::pthread_mutex_unlock(&Lock);
+
+  for (unsigned I = 0, E = Threads.size(); I != E; ++I)
+    ::pthread_join(Threads[I], 0);
+  for (unsigned I = 0, E = Queues.size(); I != E; ++I)
+    delete Queues[I];
+
+  ::pthread_cond_destroy(&Changed);
+  ::pthread_mutex_destroy(&Lock);
+}
+
+void *ThreadPoolImpl::runWorker(void *Arg) {
+  Worker *W = static_cast<Worker *>(Arg);
+  ThreadPoolImpl &Pool = *W->Pool;
+  unsigned Depth = 0;
+  Pool.CurrentWorker.set(W);
+  Pool.StealDepth.set(&Depth);
+
+  while (true) {
+    if (Pool.runTask(true, Depth))
+      continue;
+
+    ::pthread_mutex_lock(&Pool.Lock);
+    while (Pool.Queued <= 0 && !Pool.ShuttingDown) {
+      ++Pool.Sleeping;
+      ::pthread_cond_wait(&Pool.Changed, &Pool.Lock);
+      --Pool.Sleeping;
+    }
+    bool Done = Pool.ShuttingDown && Pool.Queued <= 0;
+    ::pthread_mutex_unlock(&Pool.Lock);
+    if (Done)
+      return 0;
+  }
+}
+
+/// popTask - Take the most recently spawned task of the current worker, or,
+/// if MaySteal is set, steal the oldest task of another queue.
+bool ThreadPoolImpl::popTask(Task &T, bool MaySteal, bool &Stolen) {
+  unsigned NumQueues = Queues.size();
+  unsigned First = 0;
+  Stolen = false;
+  if (const Worker *W = CurrentWorker.get()) {
+    WorkQueue &Q = *Queues[W->Index];
+    ::pthread_mutex_lock(&Q.Lock);
+    bool Found = !Q.Tasks.empty();
+    if (Found) {
+      T = Q.Tasks.back();
+      Q.Tasks.pop_back();
+    }
+    ::pthread_mutex_unlock(&Q.Lock);
+    if (Found)
+      return true;
+    First = W->Index + 1;
+  }
+
+  if (!MaySteal)
+    return false;
+  for (unsigned I = 0; I != NumQueues; ++I) {
+    WorkQueue &Q = *Queues[(First + I) % NumQueues];
+    ::pthread_mutex_lock(&Q.Lock);
+    bool Found = !Q.Tasks.empty();
+    if (Found) {
+      T = Q.Tasks.front();
+      Q.Tasks.pop_front();
+    }
+    ::pthread_mutex_unlock(&Q.Lock);
+    if (Found) {
+      Stolen = true;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// runTask - Run one queued task, if there is one.  Depth counts the stolen
+/// tasks running on the current thread.
+bool ThreadPoolImpl::runTask(bool MaySteal, unsigned &Depth) {
+  Task T;
+  bool Stolen;
+  if (!popTask(T, MaySteal, Stolen))
+    return false;
+
+  ::pthread_mutex_lock(&Lock);
+  --Queued;
+  ::pthread_mutex_unlock(&Lock);
+
+  if (Stolen)
+    ++Depth;
+  T.Fn(T.Arg);
+  if (Stolen)
+    --Depth;
+
+  ::pthread_mutex_lock(&Lock);
+  if (--T.Group->Pending == 0)
+    notifyLocked();
+  ::pthread_mutex_unlock(&Lock);
+  return true;
+}
+
+/// hasOwnTask - Return true if the queue of the current worker is not empty.
+bool ThreadPoolImpl::hasOwnTask() {
+  const Worker *W = CurrentWorker.get();
+  if (!W)
+    return false;
+  WorkQueue &Q = *Queues[W->Index];
+  ::pthread_mutex_lock(&Q.Lock);
+  bool Found = !Q.Tasks.empty();
+  ::pthread_mutex_unlock(&Q.Lock);
+  return Found;
+}
+
+void ThreadPoolImpl::spawn(TaskGroup &Group, void (*Fn)(void *), void *Arg) {
+  Task T = { Fn, Arg, &Group };
+  const Worker *W = CurrentWorker.get();
+
+  ::pthread_mutex_lock(&Lock);
+  ++Group.Pending;
+  unsigned Index = W ? W->Index : NextQueue;
+  if (!W)
+    NextQueue = (NextQueue + 1) % Queues.size();
+  ::pthread_mutex_unlock(&Lock);
+
+  WorkQueue &Q = *Queues[Index];
+  ::pthread_mutex_lock(&Q.Lock);
+  Q.Tasks.push_back(T);
+  ::pthread_mutex_unlock(&Q.Lock);
+
+  ::pthread_mutex_lock(&Lock);
+  ++Queued;
+  notifyLocked();
+  ::pthread_mutex_unlock(&Lock);
+}
+
+/// MaxStealDepth - The number of stolen tasks a thread may run nested inside
+/// wait.  A stolen task may belong to another group and wait in turn, so
+/// without a limit a waiting thread could nest one stolen task inside another
+/// until its stack overflows.
+static const unsigned MaxStealDepth = 8;
+
+void ThreadPoolImpl::wait(TaskGroup &Group) {
+  unsigned OuterDepth = 0;
+  unsigned *Depth = const_cast<unsigned *>(StealDepth.get());
+  if (!Depth) {
+    Depth = &OuterDepth;
+    StealDepth.set(Depth);
+  }
+
+  while (true) {
+    ::pthread_mutex_lock(&Lock);
+    bool Done = Group.Pending == 0;
+    ::pthread_mutex_unlock(&Lock);
+    if (Done)
+      break;
+
+    // Help with the queued tasks rather than block; they may well be the ones
+    // of this group.  The tasks of the worker's own queue were spawned below
+    // this wait, so only stealing needs a limit.
+    bool MaySteal = *Depth < MaxStealDepth;
+    if (runTask(MaySteal, *Depth))
+      continue;
+
+    ::pthread_mutex_lock(&Lock);
+    while (Group.Pending != 0 &&
+           (Queued <= 0 || (!MaySteal && !hasOwnTask()))) {
+      ++Sleeping;
+      ::pthread_cond_wait(&Changed, &Lock);
+      --Sleeping;
+    }
+    ::pthread_mutex_unlock(&Lock);
+  }
+
+  if (Depth == &OuterDepth)
+    StealDepth.erase();
+}
+
+ThreadPool::ThreadPool(unsigned ThreadCount, unsigned StackSize)
+  : Impl(0), ThreadCount(0) {
+  if (ThreadCount == 0)
+    ThreadCount = llvm_hardware_concurrency();
+
+  // The tasks will use LLVM from several threads at once.
+  if (!llvm_is_multithreaded())
+    llvm_start_multithreaded();
+
+  Impl = new ThreadPoolImpl(ThreadCount, StackSize);
+  this->ThreadCount = Impl->getNumThreads();
+  if (this->ThreadCount == 0) {
+    delete Impl;
+    Impl = 0;
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  delete Impl;
+}
+
+void TaskGroup::spawn(void (*Fn)(void *), void *Arg) {
+  if (!Pool.Impl) {
+    Fn(Arg);
+    return;
+  }
+  Pool.Impl->spawn(*this, Fn, Arg);
+}
+
+void TaskGroup::wait() {
+  if (Pool.Impl)
+    Pool.Impl->wait(*this);
+}
+
+#else
+// Support for non-pthread implementations: every task runs as soon as it is
+// spawned.
+
+ThreadPool::ThreadPool(unsigned ThreadCount, unsigned StackSize)
+  : Impl(0), ThreadCount(0) {
+  (void)ThreadCount;
+  (void)StackSize;
+}
+
+ThreadPool::~ThreadPool() {}
+
+void TaskGroup::spawn(void (*Fn)(void *), void *Arg) {
+  Fn(Arg);
+}
+
+void TaskGroup::wait() {}
+
+#endif
@@ -17,6 +17,12 @@
 #include "llvm/Support/Mutex.h"
 #include <cassert>
 
+#if defined(LLVM_ON_WIN32)
+#include "Windows/Windows.h"
+#elif defined(HAVE_UNISTD_H)
+#include <unistd.h>
+#endif
+
 using namespace llvm;
 
 static bool multithreaded_mode = false;
@@ -103,7 +109,6 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   ::pthread_attr_destroy(&Attr);
 }
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
-#include "Windows/Windows.h"
 #include <process.h>
 
 struct ThreadInfo {
@@ -145,3 +150,17 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
 }
 
 #endif
+
+unsigned llvm::llvm_hardware_concurrency() {
+#if defined(LLVM_ON_WIN32)
+  SYSTEM_INFO Info;
+  ::GetSystemInfo(&Info);
+  if (Info.dwNumberOfProcessors > 0)
+    return Info.dwNumberOfProcessors;
+#elif defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long NumCPUs = ::sysconf(_SC_NPROCESSORS_ONLN);
+  if (NumCPUs > 0)
+    return NumCPUs;
+#endif
+  return 1;
+}
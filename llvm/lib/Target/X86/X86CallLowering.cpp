@@ -0,0 +1,377 @@
+//===-- X86CallLowering.cpp - X86 call lowering for GlobalISel ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements argument, return and call lowering for the global
+// instruction selector on x86-64. Like FastISel, it only handles the C
+// calling convention with every value passed in a register; anything else is
+// left to SelectionDAG.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86CallLowering.h"
+#include "X86.h"
+#include "X86InstrInfo.h"
+#include "X86ISelLowering.h"
+#include "X86Subtarget.h"
+#include "X86TargetMachine.h"
+#include "llvm/CodeGen/CallingConvLower.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Target/TargetLowering.h"
+using namespace llvm;
+
+#include "X86GenCallingConv.inc"
+
+X86CallLowering::X86CallLowering(const X86TargetMachine &TM)
+  : CallLowering(TM), Subtarget(&TM.getSubtarget<X86Subtarget>()) {
+}
+
+/// isSupportedType - Return true if Ty is a scalar that lives in a single
+/// general purpose or SSE register.
+static bool isSupportedType(Type *Ty) {
+  if (Ty->isPointerTy() || Ty->isFloatTy() || Ty->isDoubleTy())
+    return true;
+  return Ty->isIntegerTy(1) || Ty->isIntegerTy(8) || Ty->isIntegerTy(16) ||
+         Ty->isIntegerTy(32) || Ty->isIntegerTy(64);
+}
+
+/// getRegisterVT - Return the value type a scalar of type Ty is passed as
+/// before the calling convention promotes it.
+static MVT getRegisterVT(const TargetLowering &TLI, Type *Ty) {
+  assert(isSupportedType(Ty) && "Unexpected argument type!");
+  MVT VT = TLI.getValueType(Ty).getSimpleVT();
+  return VT == MVT::i1 ? MVT::i8 : VT;
+}
+
+/// getArgFlags - Return the flags of the parameter with attribute index Idx.
+static ISD::ArgFlagsTy getArgFlags(const AttributeSet &Attrs, unsigned Idx,
+                                   Type *Ty, const DataLayout &TD) {
+  ISD::ArgFlagsTy Flags;
+  if (Attrs.hasAttribute(Idx, Attribute::SExt))
+    Flags.setSExt();
+  if (Attrs.hasAttribute(Idx, Attribute::ZExt))
+    Flags.setZExt();
+  Flags.setOrigAlign(TD.getABITypeAlignment(Ty));
+  return Flags;
+}
+
+static bool hasUnsupportedParamAttr(const AttributeSet &Attrs, unsigned Idx) {
+  return Attrs.hasAttribute(Idx, Attribute::ByVal) ||
+         Attrs.hasAttribute(Idx, Attribute::InReg) ||
+         Attrs.hasAttribute(Idx, Attribute::StructRet) ||
+         Attrs.hasAttribute(Idx, Attribute::Nest);
+}
+
+/// isRegisterLoc - Return true if VA is a register, possibly after an integer
+/// extension, that is not on the x87 stack.
+static bool isRegisterLoc(const CCValAssign &VA) {
+  if (!VA.isRegLoc() || VA.getLocReg() == X86::ST0 ||
+      VA.getLocReg() == X86::ST1)
+    return false;
+  switch (VA.getLocInfo()) {
+  case CCValAssign::Full:
+  case CCValAssign::SExt:
+  case CCValAssign::ZExt:
+  case CCValAssign::AExt:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static bool allRegisterLocs(const SmallVectorImpl<CCValAssign> &Locs) {
+  for (unsigned i = 0, e = Locs.size(); i != e; ++i)
+    if (!isRegisterLoc(Locs[i]))
+      return false;
+  return true;
+}
+
+/// getExtendOpcode - Return the generic opcode that extends a value to the
+/// location VA assigns it.
+static unsigned getExtendOpcode(CCValAssign::LocInfo LocInfo) {
+  switch (LocInfo) {
+  case CCValAssign::SExt: return TargetOpcode::G_SEXT;
+  case CCValAssign::ZExt: return TargetOpcode::G_ZEXT;
+  default:                return TargetOpcode::G_ANYEXT;
+  }
+}
+
+bool X86CallLowering::isSupportedCallingConv(CallingConv::ID CC) const {
+  return Subtarget->is64Bit() && !Subtarget->isCallingConvWin64(CC) &&
+         (CC == CallingConv::C || CC == CallingConv::X86_64_SysV);
+}
+
+bool X86CallLowering::canLowerFunction(MachineFunction &MF) const {
+  const Function &F = *MF.getFunction();
+  const TargetLowering &TLI = *TM.getTargetLowering();
+  // Floating point values live in SSE registers, and only small code model
+  // addressing is selected.
+  if (!Subtarget->hasSSE2() || TM.getCodeModel() != CodeModel::Small ||
+      !isSupportedCallingConv(F.getCallingConv()) || F.isVarArg())
+    return false;
+
+  const AttributeSet &Attrs = F.getAttributes();
+  SmallVector<MVT, 8> ArgVTs;
+  SmallVector<ISD::ArgFlagsTy, 8> ArgFlags;
+  unsigned Idx = 1;
+  for (Function::const_arg_iterator A = F.arg_begin(), E = F.arg_end();
+       A != E; ++A, ++Idx) {
+    Type *Ty = A->getType();
+    if (!isSupportedType(Ty) || hasUnsupportedParamAttr(Attrs, Idx))
+      return false;
+    ArgVTs.push_back(getRegisterVT(TLI, Ty));
+    ArgFlags.push_back(getArgFlags(Attrs, Idx, Ty, *TM.getDataLayout()));
+  }
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(F.getCallingConv(), false, MF, TM, ArgLocs, F.getContext());
+  CCInfo.AnalyzeCallOperands(ArgVTs, ArgFlags, CC_X86);
+  if (!allRegisterLocs(ArgLocs))
+    return false;
+
+  Type *RetTy = F.getReturnType();
+  if (RetTy->isVoidTy())
+    return true;
+  if (!isSupportedType(RetTy))
+    return false;
+  SmallVector<ISD::OutputArg, 4> Outs;
+  GetReturnInfo(RetTy, Attrs, Outs, TLI);
+  SmallVector<CCValAssign, 16> RetLocs;
+  CCState RetInfo(F.getCallingConv(), false, MF, TM, RetLocs, F.getContext());
+  RetInfo.AnalyzeReturn(Outs, RetCC_X86);
+  return RetLocs.size() == 1 && allRegisterLocs(RetLocs);
+}
+
+bool X86CallLowering::canLowerCall(MachineFunction &MF,
+                                   const CallInst &CI) const {
+  const TargetLowering &TLI = *TM.getTargetLowering();
+  CallingConv::ID CC = CI.getCallingConv();
+  if (!isSupportedCallingConv(CC))
+    return false;
+  // Calls through Darwin stubs are left to SelectionDAG.
+  if (isa<Function>(CI.getCalledValue()) && Subtarget->isPICStyleStubAny())
+    return false;
+
+  FunctionType *FTy = cast<FunctionType>(
+    cast<PointerType>(CI.getCalledValue()->getType())->getElementType());
+  const AttributeSet &Attrs = CI.getAttributes();
+  SmallVector<MVT, 8> ArgVTs;
+  SmallVector<ISD::ArgFlagsTy, 8> ArgFlags;
+  for (unsigned i = 0, e = CI.getNumArgOperands(); i != e; ++i) {
+    Type *Ty = CI.getArgOperand(i)->getType();
+    if (!isSupportedType(Ty) || hasUnsupportedParamAttr(Attrs, i + 1))
+      return false;
+    ArgVTs.push_back(getRegisterVT(TLI, Ty));
+    ArgFlags.push_back(getArgFlags(Attrs, i + 1, Ty, *TM.getDataLayout()));
+  }
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(CC, FTy->isVarArg(), MF, TM, ArgLocs, CI.getContext());
+  CCInfo.AnalyzeCallOperands(ArgVTs, ArgFlags, CC_X86);
+  if (!allRegisterLocs(ArgLocs))
+    return false;
+
+  Type *RetTy = CI.getType();
+  if (RetTy->isVoidTy())
+    return true;
+  if (!isSupportedType(RetTy))
+    return false;
+  SmallVector<CCValAssign, 16> RetLocs;
+  CCState RetInfo(CC, false, MF, TM, RetLocs, CI.getContext());
+  RetInfo.AnalyzeCallResult(getRegisterVT(TLI, RetTy), RetCC_X86);
+  return RetLocs.size() == 1 && allRegisterLocs(RetLocs);
+}
+
+void X86CallLowering::lowerArguments(MachineBasicBlock &MBB,
+                                     const Function &F,
+                                     ArrayRef<unsigned> VRegs) const {
+  MachineFunction &MF = *MBB.getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const TargetInstrInfo &TII = *TM.getInstrInfo();
+  const TargetLowering &TLI = *TM.getTargetLowering();
+
+  SmallVector<MVT, 8> ArgVTs;
+  SmallVector<ISD::ArgFlagsTy, 8> ArgFlags;
+  unsigned Idx = 1;
+  for (Function::const_arg_iterator A = F.arg_begin(), E = F.arg_end();
+       A != E; ++A, ++Idx) {
+    ArgVTs.push_back(getRegisterVT(TLI, A->getType()));
+    ArgFlags.push_back(getArgFlags(F.getAttributes(), Idx, A->getType(),
+                                   *TM.getDataLayout()));
+  }
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(F.getCallingConv(), false, MF, TM, ArgLocs, F.getContext());
+  CCInfo.AnalyzeCallOperands(ArgVTs, ArgFlags, CC_X86);
+
+  for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
+    CCValAssign &VA = ArgLocs[i];
+    unsigned PhysReg = VA.getLocReg();
+    unsigned VReg = VRegs[VA.getValNo()];
+    MBB.addLiveIn(PhysReg);
+    MRI.addLiveIn(PhysReg);
+
+    unsigned LocSize = VA.getLocVT().getSizeInBits();
+    if (LocSize == MRI.getSize(VReg)) {
+      BuildMI(MBB, MBB.end(), DebugLoc(), TII.get(TargetOpcode::COPY), VReg)
+        .addReg(PhysReg);
+      continue;
+    }
+    // Promoted integers arrive in a wider register.
+    unsigned WideReg = MRI.createGenericVirtualRegister(LocSize);
+    BuildMI(MBB, MBB.end(), DebugLoc(), TII.get(TargetOpcode::COPY), WideReg)
+      .addReg(PhysReg);
+    BuildMI(MBB, MBB.end(), DebugLoc(), TII.get(TargetOpcode::G_TRUNC), VReg)
+      .addReg(WideReg);
+  }
+}
+
+void X86CallLowering::lowerReturn(MachineBasicBlock &MBB, const Value *Val,
+                                  unsigned VReg, DebugLoc DL) const {
+  MachineFunction &MF = *MBB.getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const TargetInstrInfo &TII = *TM.getInstrInfo();
+  const Function &F = *MF.getFunction();
+
+  unsigned RetReg = 0;
+  if (Val) {
+    SmallVector<ISD::OutputArg, 4> Outs;
+    GetReturnInfo(Val->getType(), F.getAttributes(), Outs,
+                  *TM.getTargetLowering());
+    SmallVector<CCValAssign, 16> RetLocs;
+    CCState CCInfo(F.getCallingConv(), false, MF, TM, RetLocs,
+                   F.getContext());
+    CCInfo.AnalyzeReturn(Outs, RetCC_X86);
+    CCValAssign &VA = RetLocs[0];
+    RetReg = VA.getLocReg();
+
+    unsigned LocSize = VA.getLocVT().getSizeInBits();
+    if (LocSize != MRI.getSize(VReg)) {
+      unsigned Opcode = TargetOpcode::G_ANYEXT;
+      if (Outs[0].Flags.isSExt())
+        Opcode = TargetOpcode::G_SEXT;
+      else if (Outs[0].Flags.isZExt())
+        Opcode = TargetOpcode::G_ZEXT;
+      unsigned WideReg = MRI.createGenericVirtualRegister(LocSize);
+      BuildMI(MBB, MBB.end(), DL, TII.get(Opcode), WideReg).addReg(VReg);
+      VReg = WideReg;
+    }
+    BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::COPY), RetReg)
+      .addReg(VReg);
+  }
+
+  MachineInstrBuilder MIB = BuildMI(MBB, MBB.end(), DL, TII.get(X86::RET));
+  if (RetReg)
+    MIB.addReg(RetReg, RegState::Implicit);
+}
+
+void X86CallLowering::lowerCall(MachineBasicBlock &MBB, const CallInst &CI,
+                                unsigned CalleeReg,
+                                ArrayRef<unsigned> ArgRegs,
+                                unsigned ResReg) const {
+  MachineFunction &MF = *MBB.getParent();
+  MachineRegisterInfo &MRI = MF.getRegInfo();
+  const TargetInstrInfo &TII = *TM.getInstrInfo();
+  const TargetLowering &TLI = *TM.getTargetLowering();
+  DebugLoc DL = CI.getDebugLoc();
+  CallingConv::ID CC = CI.getCallingConv();
+  FunctionType *FTy = cast<FunctionType>(
+    cast<PointerType>(CI.getCalledValue()->getType())->getElementType());
+  bool IsVarArg = FTy->isVarArg();
+
+  SmallVector<MVT, 8> ArgVTs;
+  SmallVector<ISD::ArgFlagsTy, 8> ArgFlags;
+  for (unsigned i = 0, e = CI.getNumArgOperands(); i != e; ++i) {
+    Type *Ty = CI.getArgOperand(i)->getType();
+    ArgVTs.push_back(getRegisterVT(TLI, Ty));
+    ArgFlags.push_back(getArgFlags(CI.getAttributes(), i + 1, Ty,
+                                   *TM.getDataLayout()));
+  }
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(CC, IsVarArg, MF, TM, ArgLocs, CI.getContext());
+  CCInfo.AnalyzeCallOperands(ArgVTs, ArgFlags, CC_X86);
+
+  // Every argument is in a register, so no stack space is reserved.
+  BuildMI(MBB, MBB.end(), DL, TII.get(X86::ADJCALLSTACKDOWN64)).addImm(0);
+
+  SmallVector<unsigned, 8> PhysArgRegs;
+  for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
+    CCValAssign &VA = ArgLocs[i];
+    unsigned Reg = ArgRegs[VA.getValNo()];
+    unsigned LocSize = VA.getLocVT().getSizeInBits();
+    if (LocSize != MRI.getSize(Reg)) {
+      unsigned WideReg = MRI.createGenericVirtualRegister(LocSize);
+      BuildMI(MBB, MBB.end(), DL, TII.get(getExtendOpcode(VA.getLocInfo())),
+              WideReg).addReg(Reg);
+      Reg = WideReg;
+    }
+    BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::COPY), VA.getLocReg())
+      .addReg(Reg);
+    PhysArgRegs.push_back(VA.getLocReg());
+  }
+
+  // Variadic x86-64 calls pass the number of vector registers used in AL.
+  if (IsVarArg) {
+    static const uint16_t XMMArgRegs[] = {
+      X86::XMM0, X86::XMM1, X86::XMM2, X86::XMM3,
+      X86::XMM4, X86::XMM5, X86::XMM6, X86::XMM7
+    };
+    unsigned NumXMMRegs = CCInfo.getFirstUnallocated(XMMArgRegs, 8);
+    BuildMI(MBB, MBB.end(), DL, TII.get(X86::MOV8ri), X86::AL)
+      .addImm(NumXMMRegs);
+    PhysArgRegs.push_back(X86::AL);
+  }
+
+  MachineInstrBuilder MIB;
+  if (CalleeReg) {
+    unsigned Target = MRI.createVirtualRegister(&X86::GR64RegClass);
+    BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::COPY), Target)
+      .addReg(CalleeReg);
+    MIB = BuildMI(MBB, MBB.end(), DL, TII.get(X86::CALL64r)).addReg(Target);
+  } else {
+    const GlobalValue *GV = cast<GlobalValue>(CI.getCalledValue());
+    // On ELF, direct calls to preemptible symbols go through the PLT in PIC
+    // mode.
+    unsigned char OpFlags = 0;
+    if (Subtarget->isTargetELF() && TM.getRelocationModel() == Reloc::PIC_ &&
+        GV->hasDefaultVisibility() && !GV->hasLocalLinkage())
+      OpFlags = X86II::MO_PLT;
+    MIB = BuildMI(MBB, MBB.end(), DL, TII.get(X86::CALL64pcrel32))
+      .addGlobalAddress(GV, 0, OpFlags);
+  }
+  MIB.addRegMask(TM.getRegisterInfo()->getCallPreservedMask(CC));
+  for (unsigned i = 0, e = PhysArgRegs.size(); i != e; ++i)
+    MIB.addReg(PhysArgRegs[i], RegState::Implicit);
+
+  unsigned RetPhysReg = 0;
+  unsigned RetSize = 0;
+  if (ResReg) {
+    SmallVector<CCValAssign, 16> RetLocs;
+    CCState RetInfo(CC, false, MF, TM, RetLocs, CI.getContext());
+    RetInfo.AnalyzeCallResult(getRegisterVT(TLI, CI.getType()), RetCC_X86);
+    RetPhysReg = RetLocs[0].getLocReg();
+    RetSize = RetLocs[0].getLocVT().getSizeInBits();
+    MIB.addReg(RetPhysReg, RegState::ImplicitDefine);
+  }
+
+  BuildMI(MBB, MBB.end(), DL, TII.get(X86::ADJCALLSTACKUP64))
+    .addImm(0).addImm(0);
+
+  if (!ResReg)
+    return;
+  if (RetSize == MRI.getSize(ResReg)) {
+    BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::COPY), ResReg)
+      .addReg(RetPhysReg);
+    return;
+  }
+  unsigned WideReg = MRI.createGenericVirtualRegister(RetSize);
+  BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::COPY), WideReg)
+    .addReg(RetPhysReg);
+  BuildMI(MBB, MBB.end(), DL, TII.get(TargetOpcode::G_TRUNC), ResReg)
+    .addReg(WideReg);
+}
@@ -0,0 +1,50 @@
+//===-- X86CallLowering.h - X86 call lowering for GlobalISel ----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares how the global instruction selector lowers arguments,
+// returns and calls for x86-64.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef X86CALLLOWERING_H
+#define X86CALLLOWERING_H
+
+#include "llvm/CodeGen/GlobalISel/CallLowering.h"
+#include "llvm/IR/CallingConv.h"
+
+namespace llvm {
+
+class X86Subtarget;
+class X86TargetMachine;
+
+class X86CallLowering : public CallLowering {
+  /// Subtarget - Keep a pointer to the X86Subtarget around so that we can
+  /// make the right decision when generating code for different targets.
+  const X86Subtarget *Subtarget;
+
+public:
+  explicit X86CallLowering(const X86TargetMachine &TM);
+
+  virtual bool canLowerFunction(MachineFunction &MF) const;
+  virtual bool canLowerCall(MachineFunction &MF, const CallInst &CI) const;
+  virtual void lowerArguments(MachineBasicBlock &MBB, const Function &F,
+                              ArrayRef<unsigned> VRegs) const;
+  virtual void lowerReturn(MachineBasicBlock &MBB, const Value *Val,
+                           unsigned VReg, DebugLoc DL) const;
+  virtual void lowerCall(MachineBasicBlock &MBB, const CallInst &CI,
+                         unsigned CalleeReg, ArrayRef<unsigned> ArgRegs,
+                         unsigned ResReg) const;
+
+private:
+  bool isSupportedCallingConv(CallingConv::ID CC) const;
+};
+
+} // End llvm namespace
+
+#endif
@@ -77,7 +77,8 @@ public:
 private:
   bool X86FastEmitCompare(const Value *LHS, const Value *RHS, EVT VT);
 
-  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR);
+  bool X86FastEmitLoad(EVT VT, const X86AddressMode &AM, unsigned &RR,
+                       bool Aligned = false);
 
   bool X86FastEmitStore(EVT VT, const Value *Val, const X86AddressMode &AM,
                         bool Aligned = false);
@@ -89,6 +90,7 @@ private:
 
   bool X86SelectAddress(const Value *V, X86AddressMode &AM);
   bool X86SelectCallAddress(const Value *V, X86AddressMode &AM);
+  unsigned constrainIndexReg(unsigned Reg);
 
   bool X86SelectLoad(const Instruction *I);
 
@@ -107,6 +109,9 @@ private:
   bool X86SelectDivRem(const Instruction *I);
 
   bool X86SelectSelect(const Instruction *I);
+  bool X86FastEmitCondition(const Value *Cond, const Instruction *I,
+                            X86::CondCode &CC);
+  bool X86FastEmitSSESelect(const Instruction *I, MVT RetVT);
 
   bool X86SelectTrunc(const Instruction *I);
 
@@ -146,6 +151,9 @@ private:
 
   bool TryEmitSmallMemcpy(X86AddressMode DestAM,
                           X86AddressMode SrcAM, uint64_t Len);
+
+  bool X86FastEmitRepMovs(X86AddressMode DestAM, unsigned SrcReg,
+                          uint64_t Len);
 };
 
 } // end anonymous namespace.
@@ -179,7 +187,7 @@ bool X86FastISel::isTypeLegal(Type *Ty, MVT &VT, bool AllowI1) {
 /// The address is either pre-computed, i.e. Ptr, or a GlobalAddress, i.e. GV.
 /// Return true and the result register by reference if it is possible.
 bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
-                                  unsigned &ResultReg) {
+                                  unsigned &ResultReg, bool Aligned) {
   // Get opcode and regclass of the output for the given load instruction.
   unsigned Opc = 0;
   const TargetRegisterClass *RC = NULL;
@@ -224,6 +232,30 @@ bool X86FastISel::X86FastEmitLoad(EVT VT, const X86AddressMode &AM,
   case MVT::f80:
     // No f80 support yet.
     return false;
+  case MVT::v4f32:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVAPSrm : X86::MOVAPSrm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVUPSrm : X86::MOVUPSrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v2f64:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVAPDrm : X86::MOVAPDrm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVUPDrm : X86::MOVUPDrm;
+    RC  = &X86::VR128RegClass;
+    break;
+  case MVT::v4i32:
+  case MVT::v2i64:
+  case MVT::v8i16:
+  case MVT::v16i8:
+    if (Aligned)
+      Opc = Subtarget->hasAVX() ? X86::VMOVDQArm : X86::MOVDQArm;
+    else
+      Opc = Subtarget->hasAVX() ? X86::VMOVDQUrm : X86::MOVDQUrm;
+    RC  = &X86::VR128RegClass;
+    break;
   }
 
   ResultReg = createResultReg(RC);
@@ -453,7 +485,7 @@ bool X86FastISel::handleConstantAddresses(const Value *V, X86AddressMode &AM) {
     }
     if (AM.IndexReg == 0) {
       assert(AM.Scale == 1 && "Scale with no index!");
-      AM.IndexReg = getRegForValue(V);
+      AM.IndexReg = constrainIndexReg(getRegForValue(V));
       return AM.IndexReg != 0;
     }
   }
@@ -461,6 +493,22 @@ bool X86FastISel::handleConstantAddresses(const Value *V, X86AddressMode &AM) {
   return false;
 }
 
+/// constrainIndexReg - The stack pointer can't be an index register, so a
+/// virtual register used as one must not be allocated to it.
+unsigned X86FastISel::constrainIndexReg(unsigned Reg) {
+  if (Reg == 0 || !TargetRegisterInfo::isVirtualRegister(Reg))
+    return Reg;
+  const TargetRegisterClass *RC = Subtarget->is64Bit() ?
+    (const TargetRegisterClass *)&X86::GR64_NOSPRegClass :
+    (const TargetRegisterClass *)&X86::GR32_NOSPRegClass;
+  if (MRI.constrainRegClass(Reg, RC))
+    return Reg;
+  unsigned NewReg = createResultReg(RC);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
+          NewReg).addReg(Reg);
+  return NewReg;
+}
+
 /// X86SelectAddress - Attempt to fill in an address from the given value.
 ///
 bool X86FastISel::X86SelectAddress(const Value *V, X86AddressMode &AM) {
@@ -579,7 +627,7 @@ redo_gep:
             (S == 1 || S == 2 || S == 4 || S == 8)) {
           // Scaled-index addressing.
           Scale = S;
-          IndexReg = getRegForGEPIndex(Op).first;
+          IndexReg = constrainIndexReg(getRegForGEPIndex(Op).first);
           if (IndexReg == 0)
             return false;
           break;
@@ -736,7 +784,7 @@ bool X86FastISel::X86SelectCallAddress(const Value *V, X86AddressMode &AM) {
     }
     if (AM.IndexReg == 0) {
       assert(AM.Scale == 1 && "Scale with no index!");
-      AM.IndexReg = getRegForValue(V);
+      AM.IndexReg = constrainIndexReg(getRegForValue(V));
       return AM.IndexReg != 0;
     }
   }
@@ -841,11 +889,14 @@ bool X86FastISel::X86SelectRet(const Instruction *I) {
     EVT SrcVT = TLI.getValueType(RV->getType());
     EVT DstVT = VA.getValVT();
     // Special handling for extended integers.
-    if (SrcVT != DstVT) {
-      if (SrcVT != MVT::i1 && SrcVT != MVT::i8 && SrcVT != MVT::i16)
+    if (SrcVT != DstVT && !Outs[0].Flags.isZExt() &&
+        !Outs[0].Flags.isSExt()) {
+      // Without an extension attribute an i1 is returned in the low bits of
+      // an i8 register, which is where it already lives.
+      if (SrcVT != MVT::i1 || DstVT != MVT::i8)
         return false;
-
-      if (!Outs[0].Flags.isZExt() && !Outs[0].Flags.isSExt())
+    } else if (SrcVT != DstVT) {
+      if (SrcVT != MVT::i1 && SrcVT != MVT::i8 && SrcVT != MVT::i16)
         return false;
 
       assert(DstVT == MVT::i32 && "X86 should always ext to i32");
@@ -909,12 +960,16 @@ bool X86FastISel::X86SelectLoad(const Instruction *I)  {
   if (!isTypeLegal(I->getType(), VT, /*AllowI1=*/true))
     return false;
 
+  const LoadInst *LI = cast<LoadInst>(I);
+  unsigned ABIAlignment = TD.getABITypeAlignment(LI->getType());
+  bool Aligned = LI->getAlignment() == 0 || LI->getAlignment() >= ABIAlignment;
+
   X86AddressMode AM;
   if (!X86SelectAddress(I->getOperand(0), AM))
     return false;
 
   unsigned ResultReg = 0;
-  if (X86FastEmitLoad(VT, AM, ResultReg)) {
+  if (X86FastEmitLoad(VT, AM, ResultReg, Aligned)) {
     UpdateValueMap(I, ResultReg);
     return true;
   }
@@ -1482,41 +1537,218 @@ bool X86FastISel::X86SelectDivRem(const Instruction *I) {
   return true;
 }
 
+/// getX86ConditionCode - Return the condition code that holds after comparing
+/// the operands of a compare with the given predicate, and whether the
+/// operands must be swapped first. Returns COND_INVALID for the predicates
+/// that need two conditions.
+static std::pair<X86::CondCode, bool>
+getX86ConditionCode(CmpInst::Predicate Predicate) {
+  X86::CondCode CC = X86::COND_INVALID;
+  bool SwapArgs = false;
+  switch (Predicate) {
+  default: break;
+  case CmpInst::FCMP_OGT: CC = X86::COND_A;  break;
+  case CmpInst::FCMP_OGE: CC = X86::COND_AE; break;
+  case CmpInst::FCMP_OLT: CC = X86::COND_A;  SwapArgs = true; break;
+  case CmpInst::FCMP_OLE: CC = X86::COND_AE; SwapArgs = true; break;
+  case CmpInst::FCMP_ONE: CC = X86::COND_NE; break;
+  case CmpInst::FCMP_ORD: CC = X86::COND_NP; break;
+  case CmpInst::FCMP_UNO: CC = X86::COND_P;  break;
+  case CmpInst::FCMP_UEQ: CC = X86::COND_E;  break;
+  case CmpInst::FCMP_UGT: CC = X86::COND_B;  SwapArgs = true; break;
+  case CmpInst::FCMP_UGE: CC = X86::COND_BE; SwapArgs = true; break;
+  case CmpInst::FCMP_ULT: CC = X86::COND_B;  break;
+  case CmpInst::FCMP_ULE: CC = X86::COND_BE; break;
+  case CmpInst::ICMP_EQ:  CC = X86::COND_E;  break;
+  case CmpInst::ICMP_NE:  CC = X86::COND_NE; break;
+  case CmpInst::ICMP_UGT: CC = X86::COND_A;  break;
+  case CmpInst::ICMP_UGE: CC = X86::COND_AE; break;
+  case CmpInst::ICMP_ULT: CC = X86::COND_B;  break;
+  case CmpInst::ICMP_ULE: CC = X86::COND_BE; break;
+  case CmpInst::ICMP_SGT: CC = X86::COND_G;  break;
+  case CmpInst::ICMP_SGE: CC = X86::COND_GE; break;
+  case CmpInst::ICMP_SLT: CC = X86::COND_L;  break;
+  case CmpInst::ICMP_SLE: CC = X86::COND_LE; break;
+  }
+  return std::make_pair(CC, SwapArgs);
+}
+
+/// getSSECmpPredicate - Return the CMPSS/CMPSD immediate that computes a
+/// compare with the given predicate, and whether the operands must be swapped
+/// first. Returns 8 for the predicates SSE cannot compute in one instruction.
+static std::pair<unsigned, bool>
+getSSECmpPredicate(CmpInst::Predicate Predicate) {
+  switch (Predicate) {
+  default:                return std::make_pair(8U, false);
+  case CmpInst::FCMP_OEQ: return std::make_pair(0U, false);
+  case CmpInst::FCMP_OLT: return std::make_pair(1U, false);
+  case CmpInst::FCMP_OLE: return std::make_pair(2U, false);
+  case CmpInst::FCMP_UNO: return std::make_pair(3U, false);
+  case CmpInst::FCMP_UNE: return std::make_pair(4U, false);
+  case CmpInst::FCMP_UGE: return std::make_pair(5U, false);
+  case CmpInst::FCMP_UGT: return std::make_pair(6U, false);
+  case CmpInst::FCMP_ORD: return std::make_pair(7U, false);
+  case CmpInst::FCMP_OGT: return std::make_pair(1U, true);
+  case CmpInst::FCMP_OGE: return std::make_pair(2U, true);
+  case CmpInst::FCMP_ULT: return std::make_pair(6U, true);
+  case CmpInst::FCMP_ULE: return std::make_pair(5U, true);
+  }
+}
+
+/// X86FastEmitCondition - Set EFLAGS so that CC holds exactly when the i1
+/// value Cond is true, for use by I. A compare in the same block is folded;
+/// any other value is tested.
+bool X86FastISel::X86FastEmitCondition(const Value *Cond, const Instruction *I,
+                                       X86::CondCode &CC) {
+  const CmpInst *CI = dyn_cast<CmpInst>(Cond);
+  if (CI && CI->hasOneUse() && CI->getParent() == I->getParent()) {
+    std::pair<X86::CondCode, bool> P = getX86ConditionCode(CI->getPredicate());
+    if (P.first != X86::COND_INVALID) {
+      const Value *Op0 = CI->getOperand(0), *Op1 = CI->getOperand(1);
+      if (P.second)
+        std::swap(Op0, Op1);
+      EVT VT = TLI.getValueType(CI->getOperand(0)->getType());
+      if (X86FastEmitCompare(Op0, Op1, VT)) {
+        CC = P.first;
+        return true;
+      }
+    }
+  }
+
+  unsigned CondReg = getRegForValue(Cond);
+  if (CondReg == 0)
+    return false;
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8ri))
+    .addReg(CondReg).addImm(1);
+  CC = X86::COND_NE;
+  return true;
+}
+
 bool X86FastISel::X86SelectSelect(const Instruction *I) {
-  MVT VT;
-  if (!isTypeLegal(I->getType(), VT))
+  MVT RetVT;
+  if (!isTypeLegal(I->getType(), RetVT, /*AllowI1=*/true))
     return false;
 
+  if (isScalarFPTypeInSSEReg(RetVT))
+    return X86FastEmitSSESelect(I, RetVT);
+
   // We only use cmov here, if we don't have a cmov instruction bail.
   if (!Subtarget->hasCMov()) return false;
 
-  unsigned Opc = 0;
-  const TargetRegisterClass *RC = NULL;
-  if (VT == MVT::i16) {
-    Opc = X86::CMOVE16rr;
-    RC = &X86::GR16RegClass;
-  } else if (VT == MVT::i32) {
-    Opc = X86::CMOVE32rr;
-    RC = &X86::GR32RegClass;
-  } else if (VT == MVT::i64) {
-    Opc = X86::CMOVE64rr;
-    RC = &X86::GR64RegClass;
-  } else {
+  // There is no 8-bit cmov, so i1 and i8 values are selected in 32-bit
+  // registers.
+  MVT VT = RetVT;
+  if (VT == MVT::i1 || VT == MVT::i8)
+    VT = MVT::i32;
+  if (VT != MVT::i16 && VT != MVT::i32 && VT != MVT::i64)
+    return false;
+  const TargetRegisterClass *RC = TLI.getRegClassFor(VT);
+
+  // Materialize the operands before setting EFLAGS.
+  unsigned TrueReg = getRegForValue(I->getOperand(1));
+  if (TrueReg == 0) return false;
+  unsigned FalseReg = getRegForValue(I->getOperand(2));
+  if (FalseReg == 0) return false;
+  bool OperandsAreKilled = false;
+  if (VT != RetVT) {
+    TrueReg = FastEmitInst_r(X86::MOVZX32rr8, RC, TrueReg, /*Kill=*/false);
+    FalseReg = FastEmitInst_r(X86::MOVZX32rr8, RC, FalseReg, /*Kill=*/false);
+    OperandsAreKilled = true;
+  }
+
+  X86::CondCode CC;
+  if (!X86FastEmitCondition(I->getOperand(0), I, CC))
     return false;
+
+  unsigned Opc = X86::getCMovFromCond(CC, VT.getSizeInBits() / 8);
+  unsigned ResultReg = FastEmitInst_rr(Opc, RC, FalseReg, OperandsAreKilled,
+                                       TrueReg, OperandsAreKilled);
+  if (VT != RetVT)
+    ResultReg = FastEmitInst_extractsubreg(MVT::i8, ResultReg,
+                                           /*Kill=*/true, X86::sub_8bit);
+  UpdateValueMap(I, ResultReg);
+  return true;
+}
+
+/// X86FastEmitSSESelect - Select a float or double without a branch: build a
+/// mask of all ones or all zeros from the condition and blend the operands
+/// with it.
+bool X86FastISel::X86FastEmitSSESelect(const Instruction *I, MVT RetVT) {
+  bool IsDouble = RetVT == MVT::f64;
+  bool HasAVX = Subtarget->hasAVX();
+  const TargetRegisterClass *RC = TLI.getRegClassFor(RetVT);
+
+  unsigned TrueReg = getRegForValue(I->getOperand(1));
+  if (TrueReg == 0) return false;
+  unsigned FalseReg = getRegForValue(I->getOperand(2));
+  if (FalseReg == 0) return false;
+
+  // A compare of values of the same type computes the mask directly.
+  unsigned MaskReg = 0;
+  const Value *Cond = I->getOperand(0);
+  const FCmpInst *CI = dyn_cast<FCmpInst>(Cond);
+  if (CI && CI->hasOneUse() && CI->getParent() == I->getParent() &&
+      CI->getOperand(0)->getType() == I->getType()) {
+    std::pair<unsigned, bool> P = getSSECmpPredicate(CI->getPredicate());
+    if (P.first < 8) {
+      const Value *Op0 = CI->getOperand(0), *Op1 = CI->getOperand(1);
+      if (P.second)
+        std::swap(Op0, Op1);
+      unsigned LHSReg = getRegForValue(Op0);
+      unsigned RHSReg = getRegForValue(Op1);
+      if (LHSReg == 0 || RHSReg == 0)
+        return false;
+      unsigned CmpOpc = IsDouble ? (HasAVX ? X86::VCMPSDrr : X86::CMPSDrr)
+                                 : (HasAVX ? X86::VCMPSSrr : X86::CMPSSrr);
+      MaskReg = FastEmitInst_rri(CmpOpc, RC, LHSReg, /*Kill=*/false,
+                                 RHSReg, /*Kill=*/false, P.first);
+    }
   }
 
-  unsigned Op0Reg = getRegForValue(I->getOperand(0));
-  if (Op0Reg == 0) return false;
-  unsigned Op1Reg = getRegForValue(I->getOperand(1));
-  if (Op1Reg == 0) return false;
-  unsigned Op2Reg = getRegForValue(I->getOperand(2));
-  if (Op2Reg == 0) return false;
+  // Otherwise negate the zero extended condition in a GPR, and move it over.
+  if (MaskReg == 0) {
+    if (IsDouble && !Subtarget->is64Bit())
+      return false;
+    unsigned CondReg = getRegForValue(Cond);
+    if (CondReg == 0)
+      return false;
+    unsigned Reg = FastEmitInst_r(X86::MOVZX32rr8, &X86::GR32RegClass,
+                                  CondReg, /*Kill=*/false);
+    Reg = FastEmitInst_ri(X86::AND32ri8, &X86::GR32RegClass, Reg,
+                          /*Kill=*/true, 1);
+    if (IsDouble) {
+      unsigned Reg64 = createResultReg(&X86::GR64RegClass);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::SUBREG_TO_REG), Reg64)
+        .addImm(0).addReg(Reg, RegState::Kill).addImm(X86::sub_32bit);
+      Reg = FastEmitInst_r(X86::NEG64r, &X86::GR64RegClass, Reg64,
+                           /*Kill=*/true);
+      MaskReg = FastEmitInst_r(HasAVX ? X86::VMOV64toSDrr : X86::MOV64toSDrr,
+                               RC, Reg, /*Kill=*/true);
+    } else {
+      Reg = FastEmitInst_r(X86::NEG32r, &X86::GR32RegClass, Reg,
+                           /*Kill=*/true);
+      MaskReg = FastEmitInst_r(HasAVX ? X86::VMOVDI2SSrr : X86::MOVDI2SSrr,
+                               RC, Reg, /*Kill=*/true);
+    }
+  }
 
-  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::TEST8rr))
-    .addReg(Op0Reg).addReg(Op0Reg);
-  unsigned ResultReg = createResultReg(RC);
-  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(Opc), ResultReg)
-    .addReg(Op1Reg).addReg(Op2Reg);
+  unsigned AndOpc, AndNOpc, OrOpc;
+  if (IsDouble) {
+    AndOpc = HasAVX ? X86::VFsANDPDrr : X86::FsANDPDrr;
+    AndNOpc = HasAVX ? X86::VFsANDNPDrr : X86::FsANDNPDrr;
+    OrOpc = HasAVX ? X86::VFsORPDrr : X86::FsORPDrr;
+  } else {
+    AndOpc = HasAVX ? X86::VFsANDPSrr : X86::FsANDPSrr;
+    AndNOpc = HasAVX ? X86::VFsANDNPSrr : X86::FsANDNPSrr;
+    OrOpc = HasAVX ? X86::VFsORPSrr : X86::FsORPSrr;
+  }
+  unsigned AndReg = FastEmitInst_rr(AndOpc, RC, MaskReg, /*Kill=*/false,
+                                    TrueReg, /*Kill=*/false);
+  unsigned AndNReg = FastEmitInst_rr(AndNOpc, RC, MaskReg, /*Kill=*/true,
+                                     FalseReg, /*Kill=*/false);
+  unsigned ResultReg = FastEmitInst_rr(OrOpc, RC, AndNReg, /*Kill=*/true,
+                                       AndReg, /*Kill=*/true);
   UpdateValueMap(I, ResultReg);
   return true;
 }
@@ -1645,6 +1877,30 @@ bool X86FastISel::TryEmitSmallMemcpy(X86AddressMode DestAM,
   return true;
 }
 
+/// X86FastEmitRepMovs - Copy Len bytes from the address in SrcReg to DestAM
+/// with a rep;movsq and a short tail of scalar moves. This clobbers RCX, RDI
+/// and RSI.
+bool X86FastISel::X86FastEmitRepMovs(X86AddressMode DestAM, unsigned SrcReg,
+                                     uint64_t Len) {
+  if (!Subtarget->is64Bit())
+    return false;
+
+  uint64_t Quads = Len / 8;
+  addFullAddress(BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+                         TII.get(X86::LEA64r), X86::RDI), DestAM);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
+          X86::RSI).addReg(SrcReg);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::MOV64ri32),
+          X86::RCX).addImm(Quads);
+  BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(X86::REP_MOVSQ_64));
+
+  X86AddressMode SrcAM;
+  SrcAM.Base.Reg = SrcReg;
+  SrcAM.Disp = Quads * 8;
+  DestAM.Disp += Quads * 8;
+  return TryEmitSmallMemcpy(DestAM, SrcAM, Len % 8);
+}
+
 bool X86FastISel::X86VisitIntrinsicCall(const IntrinsicInst &I) {
   // FIXME: Handle more intrinsics.
   switch (I.getIntrinsicID()) {
@@ -1788,59 +2044,108 @@ bool X86FastISel::FastLowerArguments() {
 
   if (!Subtarget->is64Bit())
     return false;
-  
-  // Only handle simple cases. i.e. Up to 6 i32/i64 scalar arguments.
+
+  // Only handle simple cases: scalars and SSE vectors passed in registers or
+  // on the stack, and byval aggregates.
+  const AttributeSet &Attrs = F->getAttributes();
+  SmallVector<const Argument *, 8> Args;
+  SmallVector<MVT, 8> ArgVTs;
+  SmallVector<ISD::ArgFlagsTy, 8> ArgFlags;
   unsigned Idx = 1;
   for (Function::const_arg_iterator I = F->arg_begin(), E = F->arg_end();
        I != E; ++I, ++Idx) {
-    if (Idx > 6)
-      return false;
-
-    if (F->getAttributes().hasAttribute(Idx, Attribute::ByVal) ||
-        F->getAttributes().hasAttribute(Idx, Attribute::InReg) ||
-        F->getAttributes().hasAttribute(Idx, Attribute::StructRet) ||
-        F->getAttributes().hasAttribute(Idx, Attribute::Nest))
+    if (Attrs.hasAttribute(Idx, Attribute::InReg) ||
+        Attrs.hasAttribute(Idx, Attribute::StructRet) ||
+        Attrs.hasAttribute(Idx, Attribute::Nest))
       return false;
 
     Type *ArgTy = I->getType();
-    if (ArgTy->isStructTy() || ArgTy->isArrayTy() || ArgTy->isVectorTy())
+    MVT ArgVT;
+    if (!isTypeLegal(ArgTy, ArgVT, /*AllowI1=*/true) ||
+        ArgVT == MVT::x86mmx || ArgVT.getSizeInBits() > 128)
       return false;
+    // An i1 is passed like an i8.
+    if (ArgVT == MVT::i1)
+      ArgVT = MVT::i8;
 
-    EVT ArgVT = TLI.getValueType(ArgTy);
-    if (!ArgVT.isSimple()) return false;
-    switch (ArgVT.getSimpleVT().SimpleTy) {
-    case MVT::i32:
-    case MVT::i64:
-      break;
-    default:
-      return false;
+    ISD::ArgFlagsTy Flags;
+    if (Attrs.hasAttribute(Idx, Attribute::SExt))
+      Flags.setSExt();
+    if (Attrs.hasAttribute(Idx, Attribute::ZExt))
+      Flags.setZExt();
+    if (Attrs.hasAttribute(Idx, Attribute::ByVal)) {
+      Type *ElementTy = cast<PointerType>(ArgTy)->getElementType();
+      unsigned FrameAlign = Attrs.getParamAlignment(Idx);
+      if (!FrameAlign)
+        FrameAlign = TLI.getByValTypeAlignment(ElementTy);
+      Flags.setByVal();
+      Flags.setByValSize(TD.getTypeAllocSize(ElementTy));
+      Flags.setByValAlign(FrameAlign);
     }
+    Flags.setOrigAlign(TD.getABITypeAlignment(ArgTy));
+
+    Args.push_back(I);
+    ArgVTs.push_back(ArgVT);
+    ArgFlags.push_back(Flags);
   }
 
-  static const uint16_t GPR32ArgRegs[] = {
-    X86::EDI, X86::ESI, X86::EDX, X86::ECX, X86::R8D, X86::R9D
-  };
-  static const uint16_t GPR64ArgRegs[] = {
-    X86::RDI, X86::RSI, X86::RDX, X86::RCX, X86::R8 , X86::R9
-  };
+  SmallVector<CCValAssign, 16> ArgLocs;
+  CCState CCInfo(CC, false, *FuncInfo.MF, TM, ArgLocs, F->getContext());
+  CCInfo.AnalyzeCallOperands(ArgVTs, ArgFlags, CC_X86);
+  for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
+    CCValAssign &VA = ArgLocs[i];
+    if (VA.getLocInfo() != CCValAssign::Full &&
+        VA.getLocInfo() != CCValAssign::SExt &&
+        VA.getLocInfo() != CCValAssign::ZExt &&
+        VA.getLocInfo() != CCValAssign::AExt)
+      return false;
+  }
 
-  Idx = 0;
-  const TargetRegisterClass *RC32 = TLI.getRegClassFor(MVT::i32);
-  const TargetRegisterClass *RC64 = TLI.getRegClassFor(MVT::i64);
-  for (Function::const_arg_iterator I = F->arg_begin(), E = F->arg_end();
-       I != E; ++I, ++Idx) {
-    bool is32Bit = TLI.getValueType(I->getType()) == MVT::i32;
-    const TargetRegisterClass *RC = is32Bit ? RC32 : RC64;
-    unsigned SrcReg = is32Bit ? GPR32ArgRegs[Idx] : GPR64ArgRegs[Idx];
-    unsigned DstReg = FuncInfo.MF->addLiveIn(SrcReg, RC);
-    // FIXME: Unfortunately it's necessary to emit a copy from the livein copy.
-    // Without this, EmitLiveInCopies may eliminate the livein if its only
-    // use is a bitcast (which isn't turned into an instruction).
-    unsigned ResultReg = createResultReg(RC);
-    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
-            ResultReg).addReg(DstReg, getKillRegState(true));
-    UpdateValueMap(I, ResultReg);
+  MachineFrameInfo *MFI = FuncInfo.MF->getFrameInfo();
+  for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
+    CCValAssign &VA = ArgLocs[i];
+    MVT ValVT = VA.getValVT();
+    unsigned ResultReg = 0;
+    if (VA.isRegLoc()) {
+      const TargetRegisterClass *RC = TLI.getRegClassFor(VA.getLocVT());
+      unsigned DstReg = FuncInfo.MF->addLiveIn(VA.getLocReg(), RC);
+      // FIXME: Unfortunately it's necessary to emit a copy from the livein
+      // copy. Without this, EmitLiveInCopies may eliminate the livein if its
+      // only use is a bitcast (which isn't turned into an instruction).
+      ResultReg = createResultReg(RC);
+      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+              TII.get(TargetOpcode::COPY), ResultReg)
+        .addReg(DstReg, getKillRegState(true));
+      // Promoted values live in the low bits of the register.
+      if (ValVT != VA.getLocVT())
+        ResultReg = FastEmitInst_extractsubreg(ValVT, ResultReg, /*Kill=*/true,
+                                               ValVT == MVT::i8 ?
+                                               X86::sub_8bit : X86::sub_16bit);
+    } else {
+      X86AddressMode AM;
+      AM.BaseType = X86AddressMode::FrameIndexBase;
+      if (ArgFlags[VA.getValNo()].isByVal()) {
+        // Byval arguments are addressed in place; don't create zero-sized
+        // stack objects.
+        unsigned Bytes = std::max(ArgFlags[VA.getValNo()].getByValSize(), 1U);
+        AM.Base.FrameIndex =
+          MFI->CreateFixedObject(Bytes, VA.getLocMemOffset(), false);
+        ResultReg = createResultReg(&X86::GR64RegClass);
+        addFullAddress(BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL,
+                               TII.get(X86::LEA64r), ResultReg), AM);
+      } else {
+        AM.Base.FrameIndex =
+          MFI->CreateFixedObject(ValVT.getSizeInBits() / 8,
+                                 VA.getLocMemOffset(), true);
+        bool Loaded = X86FastEmitLoad(ValVT, AM, ResultReg);
+        assert(Loaded && "Failed to load an argument!"); (void)Loaded;
+      }
+    }
+    UpdateValueMap(Args[VA.getValNo()], ResultReg);
   }
+
+  FuncInfo.MF->getInfo<X86MachineFunctionInfo>()
+    ->setArgumentStackSize(CCInfo.getNextStackOffset());
   return true;
 }
 
@@ -1969,7 +2274,8 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
       Flags.setByVal();
       Flags.setByValSize(FrameSize);
       Flags.setByValAlign(FrameAlign);
-      if (!IsMemcpySmall(FrameSize))
+      // Larger aggregates are copied with a string move on x86-64.
+      if (!IsMemcpySmall(FrameSize) && !Subtarget->is64Bit())
         return false;
     }
 
@@ -2048,8 +2354,10 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
     .addImm(NumBytes);
 
   // Process argument: walk the register/memloc assignments, inserting
-  // copies / loads.
+  // copies / loads. Copies into the argument registers are emitted after all
+  // of the stores, because copying a byval argument may clobber them.
   SmallVector<unsigned, 4> RegArgs;
+  SmallVector<unsigned, 4> RegArgVals;
   for (unsigned i = 0, e = ArgLocs.size(); i != e; ++i) {
     CCValAssign &VA = ArgLocs[i];
     unsigned Arg = Args[VA.getValNo()];
@@ -2111,9 +2419,8 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
     }
 
     if (VA.isRegLoc()) {
-      BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
-              VA.getLocReg()).addReg(Arg);
       RegArgs.push_back(VA.getLocReg());
+      RegArgVals.push_back(Arg);
     } else {
       unsigned LocMemOffset = VA.getLocMemOffset();
       X86AddressMode AM;
@@ -2128,6 +2435,8 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
         X86AddressMode SrcAM;
         SrcAM.Base.Reg = Arg;
         bool Res = TryEmitSmallMemcpy(AM, SrcAM, Flags.getByValSize());
+        if (!Res)
+          Res = X86FastEmitRepMovs(AM, Arg, Flags.getByValSize());
         assert(Res && "memcpy length already checked!"); (void)Res;
       } else if (isa<ConstantInt>(ArgVal) || isa<ConstantPointerNull>(ArgVal)) {
         // If this is a really simple value, emit this with the Value* version
@@ -2142,6 +2451,10 @@ bool X86FastISel::DoSelectCall(const Instruction *I, const char *MemIntName) {
     }
   }
 
+  for (unsigned i = 0, e = RegArgs.size(); i != e; ++i)
+    BuildMI(*FuncInfo.MBB, FuncInfo.InsertPt, DL, TII.get(TargetOpcode::COPY),
+            RegArgs[i]).addReg(RegArgVals[i]);
+
   // ELF / PIC requires GOT in the EBX register before function calls via PLT
   // GOT pointer.
   if (Subtarget->isPICStyleGOT()) {
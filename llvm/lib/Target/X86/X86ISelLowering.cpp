@@ -11753,6 +11753,67 @@ static SDValue getMScatterNode(unsigned Opc, SDValue Op, SelectionDAG &DAG,
   return SDValue(Res, 1);
 }
 
+// Lower the generic llvm.masked.load and llvm.masked.store to the AVX
+// vmaskmovps/pd intrinsics. SelectionDAGBuilder has already widened the mask
+// to the element width; only the types that X86TTI reports as legal, 32 and
+// 64 bit elements in 128 and 256 bit vectors, get here. Integer elements are
+// moved through the FP forms.
+static SDValue LowerMaskedMemIntrinsic(SDValue Op, SelectionDAG &DAG) {
+  SDLoc dl(Op);
+  MemIntrinsicSDNode *N = cast<MemIntrinsicSDNode>(Op.getNode());
+  bool IsLoad = cast<ConstantSDNode>(Op.getOperand(1))->getZExtValue() ==
+                Intrinsic::masked_load;
+  SDValue Chain = Op.getOperand(0);
+  SDValue Ptr = Op.getOperand(IsLoad ? 2 : 3);
+  SDValue Mask = Op.getOperand(IsLoad ? 3 : 4);
+  SDValue Data = Op.getOperand(IsLoad ? 4 : 2);
+  EVT VT = Data.getValueType();
+
+  bool Is64 = VT.getScalarType().getSizeInBits() == 64;
+  bool Is256 = VT.getSizeInBits() == 256;
+  assert((Is256 || VT.getSizeInBits() == 128) &&
+         (Is64 || VT.getScalarType().getSizeInBits() == 32) &&
+         "Unexpected masked memory operation type");
+  MVT FPVT = Is64 ? (Is256 ? MVT::v4f64 : MVT::v2f64)
+                  : (Is256 ? MVT::v8f32 : MVT::v4f32);
+  unsigned IntNo;
+  if (IsLoad)
+    IntNo = Is64 ? (Is256 ? Intrinsic::x86_avx_maskload_pd_256
+                          : Intrinsic::x86_avx_maskload_pd)
+                 : (Is256 ? Intrinsic::x86_avx_maskload_ps_256
+                          : Intrinsic::x86_avx_maskload_ps);
+  else
+    IntNo = Is64 ? (Is256 ? Intrinsic::x86_avx_maskstore_pd_256
+                          : Intrinsic::x86_avx_maskstore_pd)
+                 : (Is256 ? Intrinsic::x86_avx_maskstore_ps_256
+                          : Intrinsic::x86_avx_maskstore_ps);
+  SDValue IntID = DAG.getTargetConstant(IntNo, Op.getOperand(1).getValueType());
+  SDValue FPMask = DAG.getNode(ISD::BITCAST, dl, FPVT, Mask);
+
+  if (!IsLoad) {
+    SDValue FPData = DAG.getNode(ISD::BITCAST, dl, FPVT, Data);
+    SDValue Ops[] = { Chain, IntID, Ptr, FPMask, FPData };
+    return DAG.getMemIntrinsicNode(ISD::INTRINSIC_VOID, dl, Op->getVTList(),
+                                   Ops, array_lengthof(Ops), N->getMemoryVT(),
+                                   N->getMemOperand());
+  }
+
+  SDValue Ops[] = { Chain, IntID, Ptr, FPMask };
+  SDValue Load = DAG.getMemIntrinsicNode(ISD::INTRINSIC_W_CHAIN, dl,
+                                         DAG.getVTList(FPVT, MVT::Other),
+                                         Ops, array_lengthof(Ops),
+                                         N->getMemoryVT(), N->getMemOperand());
+  SDValue Res = DAG.getNode(ISD::BITCAST, dl, VT, Load);
+
+  // vmaskmov zeroes the masked-off lanes; blend in the pass-through value
+  // unless that is what it asks for.
+  if (Data.getOpcode() != ISD::UNDEF &&
+      !ISD::isBuildVectorAllZeros(Data.getNode()))
+    Res = DAG.getNode(ISD::VSELECT, dl, VT, Mask, Res, Data);
+  SDValue RetOps[] = { Res, Load.getValue(1) };
+  return DAG.getMergeValues(RetOps, 2, dl);
+}
+
 static SDValue LowerINTRINSIC_W_CHAIN(SDValue Op, const X86Subtarget *Subtarget,
                                       SelectionDAG &DAG) {
   SDLoc dl(Op);
@@ -11760,6 +11821,10 @@ static SDValue LowerINTRINSIC_W_CHAIN(SDValue Op, const X86Subtarget *Subtarget,
   switch (IntNo) {
   default: return SDValue();    // Don't custom lower most intrinsics.
 
+  case Intrinsic::masked_load:
+  case Intrinsic::masked_store:
+    return LowerMaskedMemIntrinsic(Op, DAG);
+
   // RDRAND/RDSEED intrinsics.
   case Intrinsic::x86_rdrand_16:
   case Intrinsic::x86_rdrand_32:
@@ -23,6 +23,7 @@
 #include "llvm/CodeGen/MachineDominators.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineModuleInfo.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/StackMaps.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -2616,8 +2617,7 @@ static X86::CondCode getSwappedCondition(X86::CondCode CC) {
 
 /// getSETFromCond - Return a set opcode for the given condition and
 /// whether it has memory operand.
-static unsigned getSETFromCond(X86::CondCode CC,
-                               bool HasMemoryOperand) {
+unsigned X86::getSETFromCond(X86::CondCode CC, bool HasMemoryOperand) {
   static const uint16_t Opc[16][2] = {
     { X86::SETAr,  X86::SETAm  },
     { X86::SETAEr, X86::SETAEm },
@@ -2643,8 +2643,8 @@ static unsigned getSETFromCond(X86::CondCode CC,
 
 /// getCMovFromCond - Return a cmov opcode for the given condition,
 /// register size in bytes, and operand type.
-static unsigned getCMovFromCond(X86::CondCode CC, unsigned RegBytes,
-                                bool HasMemoryOperand) {
+unsigned X86::getCMovFromCond(X86::CondCode CC, unsigned RegBytes,
+                              bool HasMemoryOperand) {
   static const uint16_t Opc[32][3] = {
     { X86::CMOVA16rr,  X86::CMOVA32rr,  X86::CMOVA64rr  },
     { X86::CMOVAE16rr, X86::CMOVAE32rr, X86::CMOVAE64rr },
@@ -5267,6 +5267,255 @@ hasHighOperandLatency(const InstrItineraryData *ItinData,
   return isHighLatencyDef(DefMI->getOpcode());
 }
 
+bool X86InstrInfo::isFunctionSafeToOutlineFrom(const MachineFunction &MF) const{
+  const X86Subtarget &STI = TM.getSubtarget<X86Subtarget>();
+  if (!STI.is64Bit() || STI.isTargetWin64())
+    return false;
+
+  // The linker may replace a linkonce or weak function with a copy from
+  // another object file, which was outlined differently or not at all.
+  const Function *F = MF.getFunction();
+  if (F->hasLinkOnceLinkage() || F->hasWeakLinkage())
+    return false;
+
+  // Functions that call setjmp-like functions or use eh.return depend on the
+  // exact layout of their stack at each call.
+  return !MF.exposesReturnsTwice() && !MF.getMMI().callsEHReturn();
+}
+
+TargetInstrInfo::MachineOutlinerInstrType
+X86InstrInfo::getOutliningType(const MachineInstr *MI) const {
+  if (MI->isDebugValue())
+    return MOIT_Invisible;
+  if (MI->isLabel() || MI->isKill() ||
+      MI->isImplicitDef() || MI->isInlineAsm() || MI->isBundled() ||
+      MI->getFlag(MachineInstr::FrameSetup))
+    return MOIT_Illegal;
+
+  switch (MI->getOpcode()) {
+  default: break;
+  case X86::RET:
+    return MOIT_Return;
+  case X86::TAILJMPd64:
+    return MI->getOperand(0).isGlobal() || MI->getOperand(0).isSymbol() ?
+      MOIT_Return : MOIT_Illegal;
+  case X86::CALL64pcrel32:
+    return MI->getOperand(0).isGlobal() || MI->getOperand(0).isSymbol() ?
+      MOIT_Call : MOIT_Illegal;
+  }
+
+  // Anything else that transfers control, or that has no encoding of its
+  // own, stays where it is.
+  const MCInstrDesc &Desc = MI->getDesc();
+  if (MI->isTerminator() || MI->isCall() || MI->isReturn() ||
+      (Desc.TSFlags & X86II::FormMask) == X86II::Pseudo)
+    return MOIT_Illegal;
+
+  // Operands that refer to the containing function, such as blocks, frame
+  // indices and constant pool entries, are not valid in another function.
+  for (unsigned i = 0, e = MI->getNumOperands(); i != e; ++i) {
+    const MachineOperand &MO = MI->getOperand(i);
+    switch (MO.getType()) {
+    case MachineOperand::MO_Register:
+    case MachineOperand::MO_Immediate:
+    case MachineOperand::MO_CImmediate:
+    case MachineOperand::MO_FPImmediate:
+    case MachineOperand::MO_GlobalAddress:
+    case MachineOperand::MO_ExternalSymbol:
+      break;
+    default:
+      return MOIT_Illegal;
+    }
+  }
+
+  // Code that uses the stack pointer sees it moved by the return address
+  // when it is called, and so can only be outlined into a tail.
+  if (MI->readsRegister(X86::RSP, &RI) || MI->modifiesRegister(X86::RSP, &RI))
+    return MOIT_LegalInTail;
+
+  // A call would overwrite the red zone below the stack pointer.
+  const X86MachineFunctionInfo *X86FI =
+    MI->getParent()->getParent()->getInfo<X86MachineFunctionInfo>();
+  if (X86FI->getUsesRedZone())
+    return MOIT_LegalInTail;
+
+  return MOIT_Legal;
+}
+
+/// isREXRegOperand - Return true if MO is a register that can only be encoded
+/// with a REX prefix.
+static bool isREXRegOperand(const MachineOperand &MO) {
+  if (!MO.isReg() || MO.isImplicit() || !MO.getReg())
+    return false;
+  return X86II::isX86_64ExtendedReg(MO.getReg()) ||
+         X86II::isX86_64NonExtLowByteReg(MO.getReg());
+}
+
+/// getOutliningInstrSize - Estimate the size of MI the way X86MCCodeEmitter
+/// encodes it, without the short forms chosen during MCInst lowering.
+unsigned X86InstrInfo::getOutliningInstrSize(const MachineInstr *MI) const {
+  const MCInstrDesc &Desc = MI->getDesc();
+  uint64_t TSFlags = Desc.TSFlags;
+  unsigned Form = TSFlags & X86II::FormMask;
+  if (Form == X86II::Pseudo)
+    return 0;
+
+  int MemoryOperand = X86II::getMemoryOperandNo(TSFlags, MI->getOpcode());
+  if (MemoryOperand != -1)
+    MemoryOperand += X86II::getOperandBias(Desc);
+
+  unsigned Size = 1; // The opcode byte.
+  if (TSFlags & X86II::LOCK)
+    ++Size;
+  if ((TSFlags & X86II::SegOvrMask) ||
+      (MemoryOperand != -1 &&
+       MI->getOperand(MemoryOperand + X86::AddrSegmentReg).getReg()))
+    ++Size;
+  if (TSFlags & X86II::AdSize)
+    ++Size;
+  if (TSFlags & X86II::OpSize)
+    ++Size;
+
+  uint64_t VEXFlags = TSFlags >> X86II::VEXShift;
+  unsigned Op0 = TSFlags & X86II::Op0Mask;
+  if (VEXFlags & X86II::EVEX) {
+    Size += 4;
+  } else if (VEXFlags & (X86II::VEX | X86II::XOP)) {
+    // The two byte form only encodes the 0F map, R and L.
+    bool NeedsThreeBytes = (VEXFlags & (X86II::VEX_W | X86II::XOP)) ||
+                           (Op0 != X86II::TB && Op0 != X86II::XS &&
+                            Op0 != X86II::XD && Op0 != 0);
+    if (MemoryOperand != -1) {
+      unsigned Base = MI->getOperand(MemoryOperand + X86::AddrBaseReg).getReg();
+      unsigned Index =
+        MI->getOperand(MemoryOperand + X86::AddrIndexReg).getReg();
+      if ((Base && X86II::isX86_64ExtendedReg(Base)) ||
+          (Index && X86II::isX86_64ExtendedReg(Index)))
+        NeedsThreeBytes = true;
+    }
+    Size += NeedsThreeBytes ? 3 : 2;
+  } else {
+    switch (Op0) {
+    default: break;
+    case X86II::REP:
+    case X86II::TB:
+    case X86II::D8: case X86II::D9: case X86II::DA: case X86II::DB:
+    case X86II::DC: case X86II::DD: case X86II::DE: case X86II::DF:
+      Size += 1;
+      break;
+    case X86II::T8: case X86II::TA: case X86II::A6: case X86II::A7:
+    case X86II::XS: case X86II::XD:
+      Size += 2;
+      break;
+    case X86II::T8XS: case X86II::T8XD: case X86II::TAXD:
+      Size += 3;
+      break;
+    }
+
+    bool NeedsREX = TSFlags & X86II::REX_W;
+    for (unsigned i = 0, e = MI->getNumOperands(); i != e && !NeedsREX; ++i)
+      NeedsREX = isREXRegOperand(MI->getOperand(i));
+    if (NeedsREX)
+      ++Size;
+  }
+
+  switch (Form) {
+  default:
+    // MRMDestReg, MRMSrcReg, MRM0r-MRM7r and the fixed ModRM forms.
+    ++Size;
+    break;
+  case X86II::RawFrm:
+  case X86II::AddRegFrm:
+  case X86II::RawFrmImm8:
+  case X86II::RawFrmImm16:
+    break;
+  case X86II::MRMDestMem:
+  case X86II::MRMSrcMem:
+  case X86II::MRM0m: case X86II::MRM1m: case X86II::MRM2m: case X86II::MRM3m:
+  case X86II::MRM4m: case X86II::MRM5m: case X86II::MRM6m: case X86II::MRM7m: {
+    ++Size; // ModRM.
+    const MachineOperand &Disp = MI->getOperand(MemoryOperand + X86::AddrDisp);
+    unsigned Base = MI->getOperand(MemoryOperand + X86::AddrBaseReg).getReg();
+    unsigned Index = MI->getOperand(MemoryOperand + X86::AddrIndexReg).getReg();
+    if (Base == X86::RIP) {
+      Size += 4;
+      break;
+    }
+    unsigned BaseNo = Base ? RI.getEncodingValue(Base) & 0x7 : -1U;
+    if (Index || !Base || BaseNo == N86::ESP)
+      ++Size; // SIB.
+    if (!Base || !Disp.isImm())
+      Size += 4;
+    else if (Disp.getImm() == 0 && BaseNo != N86::EBP)
+      break;
+    else if (isInt<8>(Disp.getImm()))
+      Size += 1;
+    else
+      Size += 4;
+    break;
+  }
+  }
+
+  if (Form == X86II::RawFrmImm8)
+    Size += 1;
+  else if (Form == X86II::RawFrmImm16)
+    Size += 2;
+  if (X86II::hasImm(TSFlags))
+    Size += X86II::getSizeOfImm(TSFlags);
+  return Size;
+}
+
+unsigned
+X86InstrInfo::getOutliningCallOverhead(MachineOutlinerKind K) const {
+  // A call or jmp with a 32-bit displacement.
+  return 5;
+}
+
+unsigned
+X86InstrInfo::getOutliningFrameOverhead(MachineOutlinerKind K) const {
+  // Only a called sequence needs a ret of its own.
+  return K == MOK_Call ? 1 : 0;
+}
+
+MachineInstr *
+X86InstrInfo::insertOutlinedCall(MachineBasicBlock &MBB,
+                                 MachineBasicBlock::iterator It,
+                                 const GlobalValue *Callee,
+                                 MachineOutlinerKind K) const {
+  // Leave out the implicit operands of the opcode; the caller describes the
+  // registers the outlined sequence actually reads and writes.
+  MachineFunction &MF = *MBB.getParent();
+  unsigned Opc = K == MOK_Tail ? X86::TAILJMPd64 : X86::CALL64pcrel32;
+  MachineInstr *MI = MF.CreateMachineInstr(get(Opc), DebugLoc(), true);
+  MachineInstrBuilder(MF, MI).addGlobalAddress(Callee);
+  MBB.insert(It, MI);
+  return MI;
+}
+
+void X86InstrInfo::finishOutlinedFunction(MachineBasicBlock &MBB,
+                                          MachineOutlinerKind K) const {
+  if (K == MOK_Tail)
+    return;
+
+  if (K == MOK_Call) {
+    BuildMI(&MBB, DebugLoc(), get(X86::RET));
+    return;
+  }
+
+  // The call ending a thunk becomes a tail call, so that the callee returns
+  // straight to the caller of the outlined function.
+  MachineInstr *Call = &MBB.back();
+  assert(Call->getOpcode() == X86::CALL64pcrel32 && "Thunk must end in a call");
+  MachineFunction &MF = *MBB.getParent();
+  MachineInstr *Jmp =
+    MF.CreateMachineInstr(get(X86::TAILJMPd64), Call->getDebugLoc(), true);
+  MachineInstrBuilder MIB(MF, Jmp);
+  for (unsigned i = 0, e = Call->getNumOperands(); i != e; ++i)
+    MIB.addOperand(Call->getOperand(i));
+  MBB.insert(MachineBasicBlock::iterator(Call), Jmp);
+  Call->eraseFromParent();
+}
+
 namespace {
   /// CGBR - Create Global Base Reg pass. This initializes the PIC
   /// global base register for x86-32.
@@ -64,6 +64,13 @@ namespace X86 {
   // Turn CMov opcode into condition code.
   CondCode getCondFromCMovOpc(unsigned Opc);
 
+  // Turn condition code into a SETcc opcode.
+  unsigned getSETFromCond(CondCode CC, bool HasMemoryOperand = false);
+
+  // Turn condition code and register size in bytes into a CMov opcode.
+  unsigned getCMovFromCond(CondCode CC, unsigned RegBytes,
+                           bool HasMemoryOperand = false);
+
   /// GetOppositeBranchCondition - Return the inverse of the specified cond,
   /// e.g. turning COND_E to COND_NE.
   CondCode GetOppositeBranchCondition(X86::CondCode CC);
@@ -387,6 +394,25 @@ public:
                              const MachineInstr *DefMI, unsigned DefIdx,
                              const MachineInstr *UseMI, unsigned UseIdx) const;
 
+  virtual bool
+  isFunctionSafeToOutlineFrom(const MachineFunction &MF) const LLVM_OVERRIDE;
+  virtual MachineOutlinerInstrType
+  getOutliningType(const MachineInstr *MI) const LLVM_OVERRIDE;
+  virtual unsigned
+  getOutliningInstrSize(const MachineInstr *MI) const LLVM_OVERRIDE;
+  virtual unsigned
+  getOutliningCallOverhead(MachineOutlinerKind K) const LLVM_OVERRIDE;
+  virtual unsigned
+  getOutliningFrameOverhead(MachineOutlinerKind K) const LLVM_OVERRIDE;
+  virtual MachineInstr *insertOutlinedCall(MachineBasicBlock &MBB,
+                                           MachineBasicBlock::iterator It,
+                                           const GlobalValue *Callee,
+                                           MachineOutlinerKind K) const
+    LLVM_OVERRIDE;
+  virtual void finishOutlinedFunction(MachineBasicBlock &MBB,
+                                      MachineOutlinerKind K) const
+    LLVM_OVERRIDE;
+
   /// analyzeCompare - For a comparison instruction, return the source registers
   /// in SrcReg and SrcReg2 if having two register operands, and the value it
   /// compares against in CmpValue. Return true if the comparison instruction
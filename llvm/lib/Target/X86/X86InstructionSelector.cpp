@@ -0,0 +1,872 @@
+//===-- X86InstructionSelector.cpp - Select X86 instructions --------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the x86-64 selector for generic instructions. Each
+// generic instruction becomes the same target instructions X86FastISel would
+// emit for it, except that the selector also folds the generic instructions
+// defining its operands where x86 has a form for them: constants become
+// immediates, frame indices, globals and constant offsets become addressing
+// modes, and a comparison used only by a branch or select sets the flags
+// that instruction consumes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86InstructionSelector.h"
+#include "X86InstrBuilder.h"
+#include "X86RegisterInfo.h"
+#include "X86Subtarget.h"
+#include "X86TargetMachine.h"
+#include "llvm/CodeGen/MachineConstantPool.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Target/TargetOpcodes.h"
+using namespace llvm;
+
+X86InstructionSelector::X86InstructionSelector(const X86TargetMachine &TM)
+  : TM(TM), Subtarget(&TM.getSubtarget<X86Subtarget>()),
+    TII(*TM.getInstrInfo()) {}
+
+/// getSizeIndex - Return the index of an integer size in bits into the
+/// opcode tables below.
+static unsigned getSizeIndex(unsigned Size) {
+  switch (Size) {
+  default: llvm_unreachable("Unexpected integer size");
+  case 1:
+  case 8:  return 0;
+  case 16: return 1;
+  case 32: return 2;
+  case 64: return 3;
+  }
+}
+
+/// getConstant - If Reg is defined by a generic constant, set Val to its
+/// sign extended value and return true.
+static bool getConstant(unsigned Reg, const MachineRegisterInfo &MRI,
+                        int64_t &Val) {
+  const MachineInstr *Def = MRI.getVRegDef(Reg);
+  if (!Def || Def->getOpcode() != TargetOpcode::G_CONSTANT)
+    return false;
+  Val = Def->getOperand(1).getCImm()->getSExtValue();
+  return true;
+}
+
+/// getFoldableCompare - Return the generic comparison that defines Reg if
+/// User is its only user and can consume the flags it sets directly.
+static MachineInstr *getFoldableCompare(unsigned Reg, const MachineInstr &User,
+                                        const MachineRegisterInfo &MRI) {
+  MachineInstr *Def = MRI.getVRegDef(Reg);
+  if (!Def || Def->getParent() != User.getParent() ||
+      !MRI.hasOneNonDBGUse(Reg))
+    return 0;
+  if (Def->getOpcode() == TargetOpcode::G_ICMP)
+    return Def;
+  if (Def->getOpcode() != TargetOpcode::G_FCMP)
+    return 0;
+  // Ordered equal and unordered not equal need two flags.
+  CmpInst::Predicate Pred = (CmpInst::Predicate)Def->getOperand(1).getImm();
+  if (Pred == CmpInst::FCMP_OEQ || Pred == CmpInst::FCMP_UNE)
+    return 0;
+  return Def;
+}
+
+static X86::CondCode getICmpCondCode(CmpInst::Predicate Pred) {
+  switch (Pred) {
+  default: llvm_unreachable("Unexpected integer predicate");
+  case CmpInst::ICMP_EQ:  return X86::COND_E;
+  case CmpInst::ICMP_NE:  return X86::COND_NE;
+  case CmpInst::ICMP_UGT: return X86::COND_A;
+  case CmpInst::ICMP_UGE: return X86::COND_AE;
+  case CmpInst::ICMP_ULT: return X86::COND_B;
+  case CmpInst::ICMP_ULE: return X86::COND_BE;
+  case CmpInst::ICMP_SGT: return X86::COND_G;
+  case CmpInst::ICMP_SGE: return X86::COND_GE;
+  case CmpInst::ICMP_SLT: return X86::COND_L;
+  case CmpInst::ICMP_SLE: return X86::COND_LE;
+  }
+}
+
+/// getFCmpCondCode - Return the condition that holds after an unordered
+/// compare of the operands, swapped if Swap is set, when Pred is true. For
+/// FCMP_OEQ and FCMP_UNE this is only the equality part of the answer.
+static X86::CondCode getFCmpCondCode(CmpInst::Predicate Pred, bool &Swap) {
+  Swap = false;
+  switch (Pred) {
+  default: llvm_unreachable("Unexpected floating point predicate");
+  case CmpInst::FCMP_OEQ: return X86::COND_E;
+  case CmpInst::FCMP_UNE: return X86::COND_NE;
+  case CmpInst::FCMP_OGT:              return X86::COND_A;
+  case CmpInst::FCMP_OGE:              return X86::COND_AE;
+  case CmpInst::FCMP_OLT: Swap = true; return X86::COND_A;
+  case CmpInst::FCMP_OLE: Swap = true; return X86::COND_AE;
+  case CmpInst::FCMP_ONE:              return X86::COND_NE;
+  case CmpInst::FCMP_ORD:              return X86::COND_NP;
+  case CmpInst::FCMP_UNO:              return X86::COND_P;
+  case CmpInst::FCMP_UEQ:              return X86::COND_E;
+  case CmpInst::FCMP_UGT: Swap = true; return X86::COND_B;
+  case CmpInst::FCMP_UGE: Swap = true; return X86::COND_BE;
+  case CmpInst::FCMP_ULT:              return X86::COND_B;
+  case CmpInst::FCMP_ULE:              return X86::COND_BE;
+  }
+}
+
+namespace {
+struct BinOpEntry {
+  int Opcode;
+  bool Commutable;
+  unsigned RR[4];   // Register forms for 8, 16, 32 and 64 bits.
+  unsigned RI[4];   // Immediate forms.
+  unsigned RI8[4];  // Sign extended 8-bit immediate forms.
+};
+} // end anonymous namespace
+
+static const BinOpEntry BinOpTable[] = {
+  { TargetOpcode::G_ADD, true,
+    { X86::ADD8rr, X86::ADD16rr, X86::ADD32rr, X86::ADD64rr },
+    { X86::ADD8ri, X86::ADD16ri, X86::ADD32ri, X86::ADD64ri32 },
+    { 0, X86::ADD16ri8, X86::ADD32ri8, X86::ADD64ri8 } },
+  { TargetOpcode::G_SUB, false,
+    { X86::SUB8rr, X86::SUB16rr, X86::SUB32rr, X86::SUB64rr },
+    { X86::SUB8ri, X86::SUB16ri, X86::SUB32ri, X86::SUB64ri32 },
+    { 0, X86::SUB16ri8, X86::SUB32ri8, X86::SUB64ri8 } },
+  { TargetOpcode::G_AND, true,
+    { X86::AND8rr, X86::AND16rr, X86::AND32rr, X86::AND64rr },
+    { X86::AND8ri, X86::AND16ri, X86::AND32ri, X86::AND64ri32 },
+    { 0, X86::AND16ri8, X86::AND32ri8, X86::AND64ri8 } },
+  { TargetOpcode::G_OR, true,
+    { X86::OR8rr, X86::OR16rr, X86::OR32rr, X86::OR64rr },
+    { X86::OR8ri, X86::OR16ri, X86::OR32ri, X86::OR64ri32 },
+    { 0, X86::OR16ri8, X86::OR32ri8, X86::OR64ri8 } },
+  { TargetOpcode::G_XOR, true,
+    { X86::XOR8rr, X86::XOR16rr, X86::XOR32rr, X86::XOR64rr },
+    { X86::XOR8ri, X86::XOR16ri, X86::XOR32ri, X86::XOR64ri32 },
+    { 0, X86::XOR16ri8, X86::XOR32ri8, X86::XOR64ri8 } },
+  { TargetOpcode::G_MUL, true,
+    { 0, X86::IMUL16rr, X86::IMUL32rr, X86::IMUL64rr },
+    { 0, X86::IMUL16rri, X86::IMUL32rri, X86::IMUL64rri32 },
+    { 0, X86::IMUL16rri8, X86::IMUL32rri8, X86::IMUL64rri8 } }
+};
+
+bool X86InstructionSelector::selectBinOp(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  const BinOpEntry *Entry = 0;
+  for (unsigned i = 0; i != array_lengthof(BinOpTable); ++i)
+    if (BinOpTable[i].Opcode == I.getOpcode())
+      Entry = &BinOpTable[i];
+  assert(Entry && "Not a binary operator");
+
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned LHS = I.getOperand(1).getReg();
+  unsigned RHS = I.getOperand(2).getReg();
+  unsigned Idx = getSizeIndex(MRI.getSize(Res));
+  if (!Entry->RR[Idx])
+    return false;
+
+  int64_t Imm;
+  if (Entry->Commutable && !getConstant(RHS, MRI, Imm) &&
+      getConstant(LHS, MRI, Imm))
+    std::swap(LHS, RHS);
+
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+  if (getConstant(RHS, MRI, Imm)) {
+    // Multiplications by a power of two, such as the scaling of array
+    // indices, are shifts.
+    if (I.getOpcode() == TargetOpcode::G_MUL && Imm > 1 &&
+        isPowerOf2_64(Imm)) {
+      static const unsigned ShlRI[4] = {
+        X86::SHL8ri, X86::SHL16ri, X86::SHL32ri, X86::SHL64ri
+      };
+      BuildMI(MBB, &I, DL, TII.get(ShlRI[Idx]), Res)
+        .addReg(LHS).addImm(Log2_64(Imm));
+      return true;
+    }
+    unsigned Opc = 0;
+    if (Entry->RI8[Idx] && isInt<8>(Imm))
+      Opc = Entry->RI8[Idx];
+    else if (Idx != 3 || isInt<32>(Imm))
+      Opc = Entry->RI[Idx];
+    if (Opc) {
+      BuildMI(MBB, &I, DL, TII.get(Opc), Res).addReg(LHS).addImm(Imm);
+      return true;
+    }
+  }
+  BuildMI(MBB, &I, DL, TII.get(Entry->RR[Idx]), Res).addReg(LHS).addReg(RHS);
+  return true;
+}
+
+bool X86InstructionSelector::selectShift(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  static const unsigned ShiftRI[3][4] = {
+    { X86::SHL8ri, X86::SHL16ri, X86::SHL32ri, X86::SHL64ri },
+    { X86::SHR8ri, X86::SHR16ri, X86::SHR32ri, X86::SHR64ri },
+    { X86::SAR8ri, X86::SAR16ri, X86::SAR32ri, X86::SAR64ri }
+  };
+  static const unsigned ShiftRCL[3][4] = {
+    { X86::SHL8rCL, X86::SHL16rCL, X86::SHL32rCL, X86::SHL64rCL },
+    { X86::SHR8rCL, X86::SHR16rCL, X86::SHR32rCL, X86::SHR64rCL },
+    { X86::SAR8rCL, X86::SAR16rCL, X86::SAR32rCL, X86::SAR64rCL }
+  };
+  static const unsigned CountRegs[4] = {
+    X86::CL, X86::CX, X86::ECX, X86::RCX
+  };
+
+  unsigned Kind = I.getOpcode() == TargetOpcode::G_SHL ? 0 :
+                  I.getOpcode() == TargetOpcode::G_LSHR ? 1 : 2;
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Val = I.getOperand(1).getReg();
+  unsigned Amt = I.getOperand(2).getReg();
+  unsigned Size = MRI.getSize(Res);
+  unsigned Idx = getSizeIndex(Size);
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  int64_t Imm;
+  if (getConstant(Amt, MRI, Imm)) {
+    BuildMI(MBB, &I, DL, TII.get(ShiftRI[Kind][Idx]), Res)
+      .addReg(Val).addImm(Imm & (Size == 64 ? 63 : 31));
+    return true;
+  }
+
+  unsigned CReg = CountRegs[Idx];
+  BuildMI(MBB, &I, DL, TII.get(TargetOpcode::COPY), CReg).addReg(Amt);
+  // The shift instruction uses X86::CL. If we defined a super-register
+  // of X86::CL, emit a subreg KILL to precisely describe what we're doing here.
+  if (CReg != X86::CL)
+    BuildMI(MBB, &I, DL, TII.get(TargetOpcode::KILL), X86::CL)
+      .addReg(CReg, RegState::Kill);
+  BuildMI(MBB, &I, DL, TII.get(ShiftRCL[Kind][Idx]), Res).addReg(Val);
+  return true;
+}
+
+bool X86InstructionSelector::selectDivRem(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  unsigned Opcode = I.getOpcode();
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Size = MRI.getSize(Res);
+  if (Size != 32 && Size != 64)
+    return false;
+  bool Is64 = Size == 64;
+  bool IsSigned = Opcode == TargetOpcode::G_SDIV ||
+                  Opcode == TargetOpcode::G_SREM;
+  bool IsRem = Opcode == TargetOpcode::G_SREM ||
+               Opcode == TargetOpcode::G_UREM;
+  unsigned LowReg = Is64 ? X86::RAX : X86::EAX;
+  unsigned HighReg = Is64 ? X86::RDX : X86::EDX;
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  // The dividend goes in HighReg:LowReg, and the quotient and remainder come
+  // back in LowReg and HighReg.
+  BuildMI(MBB, &I, DL, TII.get(TargetOpcode::COPY), LowReg)
+    .addReg(I.getOperand(1).getReg());
+  if (IsSigned) {
+    BuildMI(MBB, &I, DL, TII.get(Is64 ? X86::CQO : X86::CDQ));
+  } else {
+    unsigned Zero32 = MRI.createVirtualRegister(&X86::GR32RegClass);
+    BuildMI(MBB, &I, DL, TII.get(X86::MOV32r0), Zero32);
+    if (Is64)
+      BuildMI(MBB, &I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), HighReg)
+        .addImm(0).addReg(Zero32).addImm(X86::sub_32bit);
+    else
+      BuildMI(MBB, &I, DL, TII.get(TargetOpcode::COPY), HighReg)
+        .addReg(Zero32);
+  }
+  unsigned DivOpc = IsSigned ? (Is64 ? X86::IDIV64r : X86::IDIV32r)
+                             : (Is64 ? X86::DIV64r : X86::DIV32r);
+  BuildMI(MBB, &I, DL, TII.get(DivOpc)).addReg(I.getOperand(2).getReg());
+  BuildMI(MBB, &I, DL, TII.get(TargetOpcode::COPY), Res)
+    .addReg(IsRem ? HighReg : LowReg);
+  return true;
+}
+
+bool X86InstructionSelector::selectFPBinOp(MachineInstr &I,
+                                           MachineRegisterInfo &MRI) const {
+  // Scalar single, scalar double, and their AVX forms.
+  static const unsigned FPOps[4][4] = {
+    { X86::ADDSSrr, X86::ADDSDrr, X86::VADDSSrr, X86::VADDSDrr },
+    { X86::SUBSSrr, X86::SUBSDrr, X86::VSUBSSrr, X86::VSUBSDrr },
+    { X86::MULSSrr, X86::MULSDrr, X86::VMULSSrr, X86::VMULSDrr },
+    { X86::DIVSSrr, X86::DIVSDrr, X86::VDIVSSrr, X86::VDIVSDrr }
+  };
+  unsigned Op;
+  switch (I.getOpcode()) {
+  default: llvm_unreachable("Not a floating point operator");
+  case TargetOpcode::G_FADD: Op = 0; break;
+  case TargetOpcode::G_FSUB: Op = 1; break;
+  case TargetOpcode::G_FMUL: Op = 2; break;
+  case TargetOpcode::G_FDIV: Op = 3; break;
+  }
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Form = (MRI.getSize(Res) == 64 ? 1 : 0) +
+                  (Subtarget->hasAVX() ? 2 : 0);
+  BuildMI(*I.getParent(), &I, I.getDebugLoc(), TII.get(FPOps[Op][Form]), Res)
+    .addReg(I.getOperand(1).getReg()).addReg(I.getOperand(2).getReg());
+  return true;
+}
+
+/// emitCompare - Emit the comparison done by the generic compare Cmp before
+/// InsertPt, and return the condition that holds when Cmp's result is true.
+X86::CondCode
+X86InstructionSelector::emitCompare(MachineInstr &Cmp, MachineInstr &InsertPt,
+                                    MachineRegisterInfo &MRI) const {
+  CmpInst::Predicate Pred = (CmpInst::Predicate)Cmp.getOperand(1).getImm();
+  unsigned LHS = Cmp.getOperand(2).getReg();
+  unsigned RHS = Cmp.getOperand(3).getReg();
+  MachineBasicBlock &MBB = *InsertPt.getParent();
+  DebugLoc DL = Cmp.getDebugLoc();
+
+  if (Cmp.getOpcode() == TargetOpcode::G_FCMP) {
+    bool Swap;
+    X86::CondCode CC = getFCmpCondCode(Pred, Swap);
+    if (Swap)
+      std::swap(LHS, RHS);
+    bool HasAVX = Subtarget->hasAVX();
+    unsigned Opc = MRI.getSize(LHS) == 64
+      ? (HasAVX ? X86::VUCOMISDrr : X86::UCOMISDrr)
+      : (HasAVX ? X86::VUCOMISSrr : X86::UCOMISSrr);
+    BuildMI(MBB, &InsertPt, DL, TII.get(Opc)).addReg(LHS).addReg(RHS);
+    return CC;
+  }
+
+  int64_t Imm;
+  if (!getConstant(RHS, MRI, Imm) && getConstant(LHS, MRI, Imm)) {
+    std::swap(LHS, RHS);
+    Pred = CmpInst::getSwappedPredicate(Pred);
+  }
+  unsigned Idx = getSizeIndex(MRI.getSize(LHS));
+  if (getConstant(RHS, MRI, Imm)) {
+    static const unsigned CmpRI[4] = {
+      X86::CMP8ri, X86::CMP16ri, X86::CMP32ri, X86::CMP64ri32
+    };
+    static const unsigned CmpRI8[4] = {
+      0, X86::CMP16ri8, X86::CMP32ri8, X86::CMP64ri8
+    };
+    unsigned Opc = 0;
+    if (CmpRI8[Idx] && isInt<8>(Imm))
+      Opc = CmpRI8[Idx];
+    else if (Idx != 3 || isInt<32>(Imm))
+      Opc = CmpRI[Idx];
+    if (Opc) {
+      BuildMI(MBB, &InsertPt, DL, TII.get(Opc)).addReg(LHS).addImm(Imm);
+      return getICmpCondCode(Pred);
+    }
+  }
+  static const unsigned CmpRR[4] = {
+    X86::CMP8rr, X86::CMP16rr, X86::CMP32rr, X86::CMP64rr
+  };
+  BuildMI(MBB, &InsertPt, DL, TII.get(CmpRR[Idx])).addReg(LHS).addReg(RHS);
+  return getICmpCondCode(Pred);
+}
+
+/// emitCondition - Set the flags before InsertPt from the boolean CondReg,
+/// and return the condition that holds when CondReg is true.
+X86::CondCode
+X86InstructionSelector::emitCondition(unsigned CondReg, MachineInstr &InsertPt,
+                                      MachineRegisterInfo &MRI) const {
+  if (MachineInstr *Cmp = getFoldableCompare(CondReg, InsertPt, MRI))
+    return emitCompare(*Cmp, InsertPt, MRI);
+  // Only the low bit of a boolean is defined.
+  BuildMI(*InsertPt.getParent(), &InsertPt, InsertPt.getDebugLoc(),
+          TII.get(X86::TEST8ri)).addReg(CondReg).addImm(1);
+  return X86::COND_NE;
+}
+
+bool X86InstructionSelector::selectCmp(MachineInstr &I,
+                                       MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+  X86::CondCode CC = emitCompare(I, I, MRI);
+
+  CmpInst::Predicate Pred = (CmpInst::Predicate)I.getOperand(1).getImm();
+  if (Pred != CmpInst::FCMP_OEQ && Pred != CmpInst::FCMP_UNE) {
+    BuildMI(MBB, &I, DL, TII.get(X86::getSETFromCond(CC)), Res);
+    return true;
+  }
+
+  // oeq is equal and ordered, une is not equal or unordered.
+  bool IsOEQ = Pred == CmpInst::FCMP_OEQ;
+  unsigned EqReg = MRI.createVirtualRegister(&X86::GR8RegClass);
+  unsigned OrdReg = MRI.createVirtualRegister(&X86::GR8RegClass);
+  BuildMI(MBB, &I, DL, TII.get(X86::getSETFromCond(CC)), EqReg);
+  BuildMI(MBB, &I, DL, TII.get(IsOEQ ? X86::SETNPr : X86::SETPr), OrdReg);
+  BuildMI(MBB, &I, DL, TII.get(IsOEQ ? X86::AND8rr : X86::OR8rr), Res)
+    .addReg(OrdReg).addReg(EqReg);
+  return true;
+}
+
+bool X86InstructionSelector::selectBrCond(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineBasicBlock *Target = I.getOperand(1).getMBB();
+  X86::CondCode CC = emitCondition(I.getOperand(0).getReg(), I, MRI);
+
+  // If the branch skips over an unconditional jump to the layout successor,
+  // branch to the jump's target on the opposite condition instead.
+  MachineBasicBlock::iterator Next = &I;
+  ++Next;
+  if (Next != MBB.end() && Next->getOpcode() == X86::JMP_4 &&
+      MBB.isLayoutSuccessor(Target)) {
+    Target = Next->getOperand(0).getMBB();
+    CC = X86::GetOppositeBranchCondition(CC);
+    Next->eraseFromParent();
+  }
+  BuildMI(MBB, &I, I.getDebugLoc(), TII.get(X86::GetCondBranchFromCond(CC)))
+    .addMBB(Target);
+  return true;
+}
+
+bool X86InstructionSelector::selectSelect(MachineInstr &I,
+                                          MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Size = MRI.getSize(Res);
+  if (Size != 16 && Size != 32 && Size != 64)
+    return false;
+  X86::CondCode CC = emitCondition(I.getOperand(1).getReg(), I, MRI);
+  BuildMI(*I.getParent(), &I, I.getDebugLoc(),
+          TII.get(X86::getCMovFromCond(CC, Size / 8)), Res)
+    .addReg(I.getOperand(3).getReg()).addReg(I.getOperand(2).getReg());
+  return true;
+}
+
+bool X86InstructionSelector::selectExt(MachineInstr &I,
+                                       MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Src = I.getOperand(1).getReg();
+  unsigned DstSize = MRI.getSize(Res);
+  unsigned SrcSize = MRI.getSize(Src);
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  // Booleans live in 8-bit registers already.
+  if (MRI.getRegClass(Res) == MRI.getRegClass(Src)) {
+    if (I.getOpcode() != TargetOpcode::G_ANYEXT)
+      return false;
+    BuildMI(MBB, &I, DL, TII.get(TargetOpcode::COPY), Res).addReg(Src);
+    return true;
+  }
+
+  if (I.getOpcode() == TargetOpcode::G_SEXT) {
+    static const unsigned SExtOpc[3][4] = {
+      { 0, X86::MOVSX16rr8, X86::MOVSX32rr8, X86::MOVSX64rr8 },
+      { 0, 0, X86::MOVSX32rr16, X86::MOVSX64rr16 },
+      { 0, 0, 0, X86::MOVSX64rr32 }
+    };
+    unsigned Opc = SExtOpc[getSizeIndex(SrcSize)][getSizeIndex(DstSize)];
+    if (!Opc)
+      return false;
+    BuildMI(MBB, &I, DL, TII.get(Opc), Res).addReg(Src);
+    return true;
+  }
+
+  if (SrcSize == 32) {
+    if (I.getOpcode() == TargetOpcode::G_ANYEXT) {
+      unsigned Undef = MRI.createVirtualRegister(&X86::GR64RegClass);
+      BuildMI(MBB, &I, DL, TII.get(TargetOpcode::IMPLICIT_DEF), Undef);
+      BuildMI(MBB, &I, DL, TII.get(TargetOpcode::INSERT_SUBREG), Res)
+        .addReg(Undef).addReg(Src).addImm(X86::sub_32bit);
+      return true;
+    }
+    // A 32-bit move clears the high half of the 64-bit register.
+    unsigned Tmp = MRI.createVirtualRegister(&X86::GR32RegClass);
+    BuildMI(MBB, &I, DL, TII.get(X86::MOV32rr), Tmp).addReg(Src);
+    BuildMI(MBB, &I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Res)
+      .addImm(0).addReg(Tmp).addImm(X86::sub_32bit);
+    return true;
+  }
+
+  // Zero extend any extensions from 8 and 16 bits too; there is no cheaper
+  // way to move the value into a wider register.
+  unsigned Opc = SrcSize == 16 ? X86::MOVZX32rr16 :
+                 DstSize == 16 ? X86::MOVZX16rr8 : X86::MOVZX32rr8;
+  if (DstSize != 64) {
+    BuildMI(MBB, &I, DL, TII.get(Opc), Res).addReg(Src);
+    return true;
+  }
+  unsigned Tmp = MRI.createVirtualRegister(&X86::GR32RegClass);
+  BuildMI(MBB, &I, DL, TII.get(Opc), Tmp).addReg(Src);
+  BuildMI(MBB, &I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Res)
+    .addImm(0).addReg(Tmp).addImm(X86::sub_32bit);
+  return true;
+}
+
+bool X86InstructionSelector::selectTrunc(MachineInstr &I,
+                                         MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Src = I.getOperand(1).getReg();
+  unsigned DstSize = MRI.getSize(Res);
+  unsigned SubIdx = 0;
+  if (MRI.getRegClass(Res) != MRI.getRegClass(Src)) {
+    SubIdx = DstSize <= 8 ? X86::sub_8bit :
+             DstSize == 16 ? X86::sub_16bit : X86::sub_32bit;
+    // Not every register of the source class has the sub-register (RIP has
+    // no low byte).
+    const TargetRegisterClass *RC =
+      TM.getRegisterInfo()->getSubClassWithSubReg(MRI.getRegClass(Src),
+                                                  SubIdx);
+    if (!RC || !MRI.constrainRegClass(Src, RC))
+      return false;
+  }
+  BuildMI(*I.getParent(), &I, I.getDebugLoc(), TII.get(TargetOpcode::COPY),
+          Res).addReg(Src, 0, SubIdx);
+  return true;
+}
+
+bool X86InstructionSelector::selectFPConversion(MachineInstr &I,
+                                                MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Src = I.getOperand(1).getReg();
+  bool DstIs64 = MRI.getSize(Res) == 64;
+  bool SrcIs64 = MRI.getSize(Src) == 64;
+  bool HasAVX = Subtarget->hasAVX();
+  // The AVX forms of conversions to floating point also take the register
+  // whose upper elements the result keeps.
+  bool NeedsPassThru = HasAVX;
+  unsigned Opc;
+  switch (I.getOpcode()) {
+  default: llvm_unreachable("Not a floating point conversion");
+  case TargetOpcode::G_SITOFP:
+    if (DstIs64)
+      Opc = SrcIs64 ? (HasAVX ? X86::VCVTSI2SD64rr : X86::CVTSI2SD64rr)
+                    : (HasAVX ? X86::VCVTSI2SDrr : X86::CVTSI2SDrr);
+    else
+      Opc = SrcIs64 ? (HasAVX ? X86::VCVTSI2SS64rr : X86::CVTSI2SS64rr)
+                    : (HasAVX ? X86::VCVTSI2SSrr : X86::CVTSI2SSrr);
+    break;
+  case TargetOpcode::G_FPTOSI:
+    if (SrcIs64)
+      Opc = DstIs64 ? (HasAVX ? X86::VCVTTSD2SI64rr : X86::CVTTSD2SI64rr)
+                    : (HasAVX ? X86::VCVTTSD2SIrr : X86::CVTTSD2SIrr);
+    else
+      Opc = DstIs64 ? (HasAVX ? X86::VCVTTSS2SI64rr : X86::CVTTSS2SI64rr)
+                    : (HasAVX ? X86::VCVTTSS2SIrr : X86::CVTTSS2SIrr);
+    NeedsPassThru = false;
+    break;
+  case TargetOpcode::G_FPEXT:
+    Opc = HasAVX ? X86::VCVTSS2SDrr : X86::CVTSS2SDrr;
+    break;
+  case TargetOpcode::G_FPTRUNC:
+    Opc = HasAVX ? X86::VCVTSD2SSrr : X86::CVTSD2SSrr;
+    break;
+  }
+
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+  const MCInstrDesc &Desc = TII.get(Opc);
+  unsigned PassThru = 0;
+  if (NeedsPassThru) {
+    PassThru = MRI.createVirtualRegister(
+      TII.getRegClass(Desc, 1, TM.getRegisterInfo(), *MBB.getParent()));
+    BuildMI(MBB, &I, DL, TII.get(TargetOpcode::IMPLICIT_DEF), PassThru);
+  }
+  MachineInstrBuilder MIB = BuildMI(MBB, &I, DL, Desc, Res);
+  if (PassThru)
+    MIB.addReg(PassThru);
+  MIB.addReg(Src);
+  return true;
+}
+
+bool X86InstructionSelector::selectConstant(MachineInstr &I,
+                                            MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  unsigned Size = MRI.getSize(Res);
+  const ConstantInt *CI = I.getOperand(1).getCImm();
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  if (Size == 64) {
+    uint64_t Val = CI->getZExtValue();
+    if (isUInt<32>(Val)) {
+      // 32-bit moves clear the high half of the register and are shorter.
+      unsigned Tmp = MRI.createVirtualRegister(&X86::GR32RegClass);
+      if (Val == 0)
+        BuildMI(MBB, &I, DL, TII.get(X86::MOV32r0), Tmp);
+      else
+        BuildMI(MBB, &I, DL, TII.get(X86::MOV32ri), Tmp).addImm(Val);
+      BuildMI(MBB, &I, DL, TII.get(TargetOpcode::SUBREG_TO_REG), Res)
+        .addImm(0).addReg(Tmp).addImm(X86::sub_32bit);
+    } else if (isInt<32>((int64_t)Val)) {
+      BuildMI(MBB, &I, DL, TII.get(X86::MOV64ri32), Res).addImm(Val);
+    } else {
+      BuildMI(MBB, &I, DL, TII.get(X86::MOV64ri), Res).addImm(Val);
+    }
+    return true;
+  }
+  if (Size == 32 && CI->isZero()) {
+    BuildMI(MBB, &I, DL, TII.get(X86::MOV32r0), Res);
+    return true;
+  }
+  static const unsigned MovRI[3] = { X86::MOV8ri, X86::MOV16ri, X86::MOV32ri };
+  BuildMI(MBB, &I, DL, TII.get(MovRI[getSizeIndex(Size)]), Res)
+    .addImm(Size == 1 ? CI->getZExtValue() : CI->getSExtValue());
+  return true;
+}
+
+bool X86InstructionSelector::selectFConstant(MachineInstr &I,
+                                             MachineRegisterInfo &MRI) const {
+  unsigned Res = I.getOperand(0).getReg();
+  bool IsDouble = MRI.getSize(Res) == 64;
+  const ConstantFP *CF = I.getOperand(1).getFPImm();
+  MachineBasicBlock &MBB = *I.getParent();
+  MachineFunction &MF = *MBB.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  if (CF->isNullValue()) {
+    BuildMI(MBB, &I, DL, TII.get(IsDouble ? X86::FsFLD0SD : X86::FsFLD0SS),
+            Res);
+    return true;
+  }
+
+  // Load anything else from the constant pool.
+  bool HasAVX = Subtarget->hasAVX();
+  unsigned Opc = IsDouble ? (HasAVX ? X86::VMOVSDrm : X86::MOVSDrm)
+                          : (HasAVX ? X86::VMOVSSrm : X86::MOVSSrm);
+  unsigned Align = TM.getDataLayout()->getPrefTypeAlignment(CF->getType());
+  unsigned CPI = MF.getConstantPool()->getConstantPoolIndex(CF, Align);
+  unsigned PICBase = Subtarget->isPICStyleRIPRel() ? X86::RIP : 0;
+  MachineInstr *Load =
+    addConstantPoolReference(BuildMI(MBB, &I, DL, TII.get(Opc), Res), CPI,
+                             PICBase, 0);
+  Load->addMemOperand(MF, MF.getMachineMemOperand(
+                            MachinePointerInfo::getConstantPool(),
+                            MachineMemOperand::MOLoad, IsDouble ? 8 : 4,
+                            Align));
+  return true;
+}
+
+bool X86InstructionSelector::selectGlobalValue(MachineInstr &I,
+                                               MachineRegisterInfo &MRI) const {
+  const GlobalValue *GV = I.getOperand(1).getGlobal();
+  unsigned char GVFlags = Subtarget->ClassifyGlobalReference(GV, TM);
+  if (isGlobalRelativeToPICBase(GVFlags))
+    return false;
+
+  X86AddressMode AM;
+  AM.GV = GV;
+  AM.GVOpFlags = GVFlags;
+  if (Subtarget->isPICStyleRIPRel())
+    AM.Base.Reg = X86::RIP;
+  // References through a stub load the address from the stub.
+  unsigned Opc = isGlobalStubReference(GVFlags) ? X86::MOV64rm : X86::LEA64r;
+  addFullAddress(BuildMI(*I.getParent(), &I, I.getDebugLoc(), TII.get(Opc),
+                         I.getOperand(0).getReg()), AM);
+  return true;
+}
+
+/// getAddressMode - Fill in AM with the address Addr used by I, folding the
+/// generic instructions that compute it in I's block where possible.
+void X86InstructionSelector::getAddressMode(unsigned Addr, MachineInstr &I,
+                                            MachineRegisterInfo &MRI,
+                                            X86AddressMode &AM) const {
+  const MachineInstr *Def = MRI.getVRegDef(Addr);
+  if (Def && Def->getParent() == I.getParent()) {
+    switch (Def->getOpcode()) {
+    default:
+      break;
+    case TargetOpcode::COPY: {
+      unsigned Src = Def->getOperand(1).getReg();
+      if (!TargetRegisterInfo::isVirtualRegister(Src))
+        break;
+      getAddressMode(Src, I, MRI, AM);
+      return;
+    }
+    case TargetOpcode::G_FRAME_INDEX:
+      AM.BaseType = X86AddressMode::FrameIndexBase;
+      AM.Base.FrameIndex = Def->getOperand(1).getIndex();
+      return;
+    case TargetOpcode::G_GLOBAL_VALUE: {
+      const GlobalValue *GV = Def->getOperand(1).getGlobal();
+      unsigned char GVFlags = Subtarget->ClassifyGlobalReference(GV, TM);
+      if (isGlobalStubReference(GVFlags) || isGlobalRelativeToPICBase(GVFlags))
+        break;
+      AM.GV = GV;
+      AM.GVOpFlags = GVFlags;
+      if (Subtarget->isPICStyleRIPRel())
+        AM.Base.Reg = X86::RIP;
+      return;
+    }
+    case TargetOpcode::G_ADD: {
+      unsigned Base = Def->getOperand(1).getReg();
+      unsigned Offset = Def->getOperand(2).getReg();
+      int64_t Imm;
+      if (getConstant(Offset, MRI, Imm) && isInt<32>(AM.Disp + Imm)) {
+        AM.Disp += Imm;
+        getAddressMode(Base, I, MRI, AM);
+        return;
+      }
+      // Fold a scaled index, unless the base turns out to be RIP-relative,
+      // which cannot have one.
+      const MachineInstr *Mul = MRI.getVRegDef(Offset);
+      if (AM.IndexReg || !Mul || Mul->getOpcode() != TargetOpcode::G_MUL ||
+          Mul->getParent() != I.getParent() ||
+          !getConstant(Mul->getOperand(2).getReg(), MRI, Imm) ||
+          (Imm != 1 && Imm != 2 && Imm != 4 && Imm != 8))
+        break;
+      X86AddressMode Saved = AM;
+      AM.IndexReg = Mul->getOperand(1).getReg();
+      AM.Scale = Imm;
+      getAddressMode(Base, I, MRI, AM);
+      if (AM.BaseType == X86AddressMode::RegBase && AM.Base.Reg == X86::RIP) {
+        AM = Saved;
+        break;
+      }
+      MRI.constrainRegClass(AM.IndexReg, &X86::GR64_NOSPRegClass);
+      return;
+    }
+    }
+  }
+  AM.Base.Reg = Addr;
+}
+
+bool X86InstructionSelector::selectLoadStore(MachineInstr &I,
+                                             MachineRegisterInfo &MRI) const {
+  bool IsStore = I.getOpcode() == TargetOpcode::G_STORE;
+  unsigned ValReg = I.getOperand(0).getReg();
+  const TargetRegisterClass *RC = MRI.getRegClass(ValReg);
+  bool HasAVX = Subtarget->hasAVX();
+  unsigned Idx = getSizeIndex(MRI.getSize(ValReg));
+  MachineBasicBlock &MBB = *I.getParent();
+  DebugLoc DL = I.getDebugLoc();
+
+  X86AddressMode AM;
+  getAddressMode(I.getOperand(1).getReg(), I, MRI, AM);
+
+  MachineInstr *NewMI;
+  if (!IsStore) {
+    static const unsigned MovRM[4] = {
+      X86::MOV8rm, X86::MOV16rm, X86::MOV32rm, X86::MOV64rm
+    };
+    unsigned Opc = MovRM[Idx];
+    if (RC == &X86::FR32RegClass)
+      Opc = HasAVX ? X86::VMOVSSrm : X86::MOVSSrm;
+    else if (RC == &X86::FR64RegClass)
+      Opc = HasAVX ? X86::VMOVSDrm : X86::MOVSDrm;
+    NewMI = addFullAddress(BuildMI(MBB, &I, DL, TII.get(Opc), ValReg), AM);
+  } else {
+    static const unsigned MovMR[4] = {
+      X86::MOV8mr, X86::MOV16mr, X86::MOV32mr, X86::MOV64mr
+    };
+    static const unsigned MovMI[4] = {
+      X86::MOV8mi, X86::MOV16mi, X86::MOV32mi, X86::MOV64mi32
+    };
+    int64_t Imm;
+    if (RC == &X86::FR32RegClass || RC == &X86::FR64RegClass) {
+      unsigned Opc = RC == &X86::FR64RegClass
+        ? (HasAVX ? X86::VMOVSDmr : X86::MOVSDmr)
+        : (HasAVX ? X86::VMOVSSmr : X86::MOVSSmr);
+      NewMI = addFullAddress(BuildMI(MBB, &I, DL, TII.get(Opc)), AM)
+                .addReg(ValReg);
+    } else if (getConstant(ValReg, MRI, Imm) && isInt<32>(Imm)) {
+      NewMI = addFullAddress(BuildMI(MBB, &I, DL, TII.get(MovMI[Idx])), AM)
+                .addImm(Imm);
+    } else {
+      NewMI = addFullAddress(BuildMI(MBB, &I, DL, TII.get(MovMR[Idx])), AM)
+                .addReg(ValReg);
+    }
+  }
+  NewMI->setMemRefs(I.memoperands_begin(), I.memoperands_end());
+  return true;
+}
+
+bool X86InstructionSelector::select(MachineInstr &I) const {
+  MachineRegisterInfo &MRI = I.getParent()->getParent()->getRegInfo();
+  bool Selected;
+  switch (I.getOpcode()) {
+  default:
+    return false;
+  case TargetOpcode::G_ADD:
+  case TargetOpcode::G_SUB:
+  case TargetOpcode::G_MUL:
+  case TargetOpcode::G_AND:
+  case TargetOpcode::G_OR:
+  case TargetOpcode::G_XOR:
+    Selected = selectBinOp(I, MRI);
+    break;
+  case TargetOpcode::G_SHL:
+  case TargetOpcode::G_LSHR:
+  case TargetOpcode::G_ASHR:
+    Selected = selectShift(I, MRI);
+    break;
+  case TargetOpcode::G_SDIV:
+  case TargetOpcode::G_UDIV:
+  case TargetOpcode::G_SREM:
+  case TargetOpcode::G_UREM:
+    Selected = selectDivRem(I, MRI);
+    break;
+  case TargetOpcode::G_FADD:
+  case TargetOpcode::G_FSUB:
+  case TargetOpcode::G_FMUL:
+  case TargetOpcode::G_FDIV:
+    Selected = selectFPBinOp(I, MRI);
+    break;
+  case TargetOpcode::G_ICMP:
+  case TargetOpcode::G_FCMP:
+    Selected = selectCmp(I, MRI);
+    break;
+  case TargetOpcode::G_SELECT:
+    Selected = selectSelect(I, MRI);
+    break;
+  case TargetOpcode::G_ANYEXT:
+  case TargetOpcode::G_ZEXT:
+  case TargetOpcode::G_SEXT:
+    Selected = selectExt(I, MRI);
+    break;
+  case TargetOpcode::G_TRUNC:
+    Selected = selectTrunc(I, MRI);
+    break;
+  case TargetOpcode::G_SITOFP:
+  case TargetOpcode::G_FPTOSI:
+  case TargetOpcode::G_FPEXT:
+  case TargetOpcode::G_FPTRUNC:
+    Selected = selectFPConversion(I, MRI);
+    break;
+  case TargetOpcode::G_CONSTANT:
+    Selected = selectConstant(I, MRI);
+    break;
+  case TargetOpcode::G_FCONSTANT:
+    Selected = selectFConstant(I, MRI);
+    break;
+  case TargetOpcode::G_FRAME_INDEX: {
+    // Not addFrameReference: an LEA does not access memory, so it takes no
+    // memory operand.
+    X86AddressMode AM;
+    AM.BaseType = X86AddressMode::FrameIndexBase;
+    AM.Base.FrameIndex = I.getOperand(1).getIndex();
+    addFullAddress(BuildMI(*I.getParent(), &I, I.getDebugLoc(),
+                           TII.get(X86::LEA64r), I.getOperand(0).getReg()),
+                   AM);
+    Selected = true;
+    break;
+  }
+  case TargetOpcode::G_GLOBAL_VALUE:
+    Selected = selectGlobalValue(I, MRI);
+    break;
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    Selected = selectLoadStore(I, MRI);
+    break;
+  case TargetOpcode::G_BRCOND:
+    Selected = selectBrCond(I, MRI);
+    break;
+  case TargetOpcode::G_BR:
+    BuildMI(*I.getParent(), &I, I.getDebugLoc(), TII.get(X86::JMP_4))
+      .addMBB(I.getOperand(0).getMBB());
+    Selected = true;
+    break;
+  }
+  if (!Selected)
+    return false;
+  I.eraseFromParent();
+  return true;
+}
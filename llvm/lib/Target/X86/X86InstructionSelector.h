@@ -0,0 +1,64 @@
+//===-- X86InstructionSelector.h - Select X86 instructions ------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the x86-64 selector for legal generic instructions
+// whose registers have been assigned register banks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef X86INSTRUCTIONSELECTOR_H
+#define X86INSTRUCTIONSELECTOR_H
+
+#include "X86InstrInfo.h"
+#include "llvm/CodeGen/GlobalISel/InstructionSelector.h"
+
+namespace llvm {
+
+class MachineRegisterInfo;
+class X86Subtarget;
+class X86TargetMachine;
+struct X86AddressMode;
+
+class X86InstructionSelector : public InstructionSelector {
+  const X86TargetMachine &TM;
+  const X86Subtarget *Subtarget;
+  const X86InstrInfo &TII;
+
+public:
+  explicit X86InstructionSelector(const X86TargetMachine &TM);
+
+  virtual bool select(MachineInstr &I) const;
+
+private:
+  bool selectBinOp(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectShift(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectDivRem(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectFPBinOp(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectCmp(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectBrCond(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectSelect(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectExt(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectTrunc(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectFPConversion(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectConstant(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectFConstant(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectGlobalValue(MachineInstr &I, MachineRegisterInfo &MRI) const;
+  bool selectLoadStore(MachineInstr &I, MachineRegisterInfo &MRI) const;
+
+  X86::CondCode emitCompare(MachineInstr &Cmp, MachineInstr &InsertPt,
+                            MachineRegisterInfo &MRI) const;
+  X86::CondCode emitCondition(unsigned CondReg, MachineInstr &InsertPt,
+                              MachineRegisterInfo &MRI) const;
+  void getAddressMode(unsigned Addr, MachineInstr &I, MachineRegisterInfo &MRI,
+                      X86AddressMode &AM) const;
+};
+
+} // End llvm namespace
+
+#endif
@@ -0,0 +1,80 @@
+//===-- X86LegalizerInfo.cpp - X86 generic instruction legality -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the legality table for the x86-64 global instruction
+// selector. Sizes are in bits; sizes that are not listed are widened to the
+// next listed legal size, or are unsupported if there is none.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86LegalizerInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/Target/TargetOpcodes.h"
+using namespace llvm;
+
+X86LegalizerInfo::X86LegalizerInfo() {
+  static const unsigned IntOps[] = {
+    TargetOpcode::G_ADD, TargetOpcode::G_SUB, TargetOpcode::G_AND,
+    TargetOpcode::G_OR, TargetOpcode::G_XOR, TargetOpcode::G_SHL,
+    TargetOpcode::G_LSHR, TargetOpcode::G_ASHR, TargetOpcode::G_ICMP,
+    TargetOpcode::G_LOAD, TargetOpcode::G_STORE, TargetOpcode::G_ANYEXT,
+    TargetOpcode::G_CONSTANT
+  };
+  for (unsigned i = 0; i != array_lengthof(IntOps); ++i)
+    for (unsigned Size = 8; Size <= 64; Size *= 2)
+      setAction(IntOps[i], Size, Legal);
+
+  // There is no 8-bit two-operand multiply, conditional move or register
+  // move from a truncation to a wider register.
+  for (unsigned Size = 16; Size <= 64; Size *= 2) {
+    setAction(TargetOpcode::G_MUL, Size, Legal);
+    setAction(TargetOpcode::G_SELECT, Size, Legal);
+  }
+
+  // Division goes through EDX:EAX or RDX:RAX.
+  static const unsigned DivOps[] = {
+    TargetOpcode::G_SDIV, TargetOpcode::G_UDIV, TargetOpcode::G_SREM,
+    TargetOpcode::G_UREM
+  };
+  for (unsigned i = 0; i != array_lengthof(DivOps); ++i) {
+    setAction(DivOps[i], 32, Legal);
+    setAction(DivOps[i], 64, Legal);
+  }
+
+  // Scalar SSE arithmetic and conversions.
+  static const unsigned FPOps[] = {
+    TargetOpcode::G_FADD, TargetOpcode::G_FSUB, TargetOpcode::G_FMUL,
+    TargetOpcode::G_FDIV, TargetOpcode::G_FCMP, TargetOpcode::G_FCONSTANT,
+    TargetOpcode::G_SITOFP, TargetOpcode::G_FPTOSI
+  };
+  for (unsigned i = 0; i != array_lengthof(FPOps); ++i) {
+    setAction(FPOps[i], 32, Legal);
+    setAction(FPOps[i], 64, Legal);
+  }
+  setAction(TargetOpcode::G_FPEXT, 64, Legal);
+  setAction(TargetOpcode::G_FPTRUNC, 32, Legal);
+
+  // Extensions are classified by their source, truncations by their result.
+  // Extensions from i1 are expanded into an extension and a mask or shifts.
+  for (unsigned Size = 8; Size <= 32; Size *= 2) {
+    setAction(TargetOpcode::G_ZEXT, Size, Legal);
+    setAction(TargetOpcode::G_SEXT, Size, Legal);
+    setAction(TargetOpcode::G_TRUNC, Size, Legal);
+  }
+  setAction(TargetOpcode::G_ZEXT, 1, Lower);
+  setAction(TargetOpcode::G_SEXT, 1, Lower);
+  setAction(TargetOpcode::G_TRUNC, 1, Legal);
+  setAction(TargetOpcode::G_CONSTANT, 1, Legal);
+  setAction(TargetOpcode::G_BRCOND, 1, Legal);
+  setAction(TargetOpcode::G_LOAD, 1, Unsupported);
+  setAction(TargetOpcode::G_STORE, 1, Unsupported);
+
+  setAction(TargetOpcode::G_FRAME_INDEX, 64, Legal);
+  setAction(TargetOpcode::G_GLOBAL_VALUE, 64, Legal);
+}
@@ -0,0 +1,29 @@
+//===-- X86LegalizerInfo.h - X86 generic instruction legality ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares which generic instructions the x86-64 global
+// instruction selector can select directly.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef X86LEGALIZERINFO_H
+#define X86LEGALIZERINFO_H
+
+#include "llvm/CodeGen/GlobalISel/LegalizerInfo.h"
+
+namespace llvm {
+
+class X86LegalizerInfo : public LegalizerInfo {
+public:
+  X86LegalizerInfo();
+};
+
+} // End llvm namespace
+
+#endif
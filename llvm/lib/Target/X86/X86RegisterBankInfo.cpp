@@ -0,0 +1,92 @@
+//===-- X86RegisterBankInfo.cpp - X86 register banks ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the register banks of the x86-64 global instruction
+// selector. Integers and pointers live in the general purpose registers and
+// scalar floating point values in the SSE registers. Loaded and stored values
+// take whichever bank the rest of their uses prefer.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86RegisterBankInfo.h"
+#include "X86RegisterInfo.h"
+#include "llvm/CodeGen/MachineInstr.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Target/TargetOpcodes.h"
+using namespace llvm;
+
+const char *X86RegisterBankInfo::getRegBankName(unsigned Bank) const {
+  switch (Bank) {
+  default: llvm_unreachable("Unknown register bank");
+  case GPR: return "GPR";
+  case FPR: return "FPR";
+  }
+}
+
+unsigned X86RegisterBankInfo::getOperandRegBank(const MachineInstr &MI,
+                                                unsigned OpIdx) const {
+  switch (MI.getOpcode()) {
+  default:
+    return GPR;
+  case TargetOpcode::COPY:
+  case TargetOpcode::PHI:
+    return AnyBank;
+  case TargetOpcode::G_FADD:
+  case TargetOpcode::G_FSUB:
+  case TargetOpcode::G_FMUL:
+  case TargetOpcode::G_FDIV:
+  case TargetOpcode::G_FPEXT:
+  case TargetOpcode::G_FPTRUNC:
+  case TargetOpcode::G_FCONSTANT:
+    return FPR;
+  case TargetOpcode::G_FCMP:
+    // The predicate and the boolean result are not floating point.
+    return OpIdx >= 2 ? FPR : GPR;
+  case TargetOpcode::G_SITOFP:
+    return OpIdx == 0 ? FPR : GPR;
+  case TargetOpcode::G_FPTOSI:
+    return OpIdx == 0 ? GPR : FPR;
+  case TargetOpcode::G_LOAD:
+  case TargetOpcode::G_STORE:
+    // The address is an integer; the value can be loaded into or stored
+    // from either bank.
+    if (OpIdx == 0)
+      return AnyBank;
+    return GPR;
+  }
+}
+
+unsigned
+X86RegisterBankInfo::getRegBankForRegClass(const TargetRegisterClass *RC) const {
+  if (X86::GR8RegClass.hasSubClassEq(RC) ||
+      X86::GR16RegClass.hasSubClassEq(RC) ||
+      X86::GR32RegClass.hasSubClassEq(RC) ||
+      X86::GR64RegClass.hasSubClassEq(RC))
+    return GPR;
+  return FPR;
+}
+
+const TargetRegisterClass *
+X86RegisterBankInfo::getRegClass(unsigned Bank, unsigned Size) const {
+  if (Bank == GPR) {
+    switch (Size) {
+    case 1:
+    case 8:  return &X86::GR8RegClass;
+    case 16: return &X86::GR16RegClass;
+    case 32: return &X86::GR32RegClass;
+    case 64: return &X86::GR64RegClass;
+    }
+    return 0;
+  }
+  switch (Size) {
+  case 32: return &X86::FR32RegClass;
+  case 64: return &X86::FR64RegClass;
+  }
+  return 0;
+}
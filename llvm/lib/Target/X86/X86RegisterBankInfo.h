@@ -0,0 +1,44 @@
+//===-- X86RegisterBankInfo.h - X86 register banks --------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the register banks the x86-64 global instruction
+// selector assigns generic virtual registers to.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef X86REGISTERBANKINFO_H
+#define X86REGISTERBANKINFO_H
+
+#include "llvm/CodeGen/GlobalISel/RegisterBankInfo.h"
+
+namespace llvm {
+
+class X86RegisterBankInfo : public RegisterBankInfo {
+public:
+  enum {
+    /// GPR - The general purpose registers.
+    GPR,
+    /// FPR - The SSE registers, used for scalar floating point.
+    FPR,
+    NumRegBanks
+  };
+
+  virtual unsigned getNumRegBanks() const { return NumRegBanks; }
+  virtual const char *getRegBankName(unsigned Bank) const;
+  virtual unsigned getDefaultRegBank() const { return GPR; }
+  virtual unsigned getOperandRegBank(const MachineInstr &MI,
+                                     unsigned OpIdx) const;
+  virtual unsigned getRegBankForRegClass(const TargetRegisterClass *RC) const;
+  virtual const TargetRegisterClass *getRegClass(unsigned Bank,
+                                                 unsigned Size) const;
+};
+
+} // End llvm namespace
+
+#endif
@@ -13,6 +13,7 @@
 
 #include "X86TargetMachine.h"
 #include "X86.h"
+#include "llvm/CodeGen/GlobalISel/GlobalISel.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/PassManager.h"
@@ -69,7 +70,9 @@ X86_64TargetMachine::X86_64TargetMachine(const Target &T, StringRef TT,
     InstrInfo(*this),
     TLInfo(*this),
     TSInfo(*this),
-    JITInfo(*this) {
+    JITInfo(*this),
+    CallLoweringInfo(*this),
+    InstSelector(*this) {
   initAsmInfo();
 }
 
@@ -169,6 +172,15 @@ TargetPassConfig *X86TargetMachine::createPassConfig(PassManagerBase &PM) {
 }
 
 bool X86PassConfig::addInstSelector() {
+  // The global instruction selector handles the x86-64 functions it
+  // supports; SelectionDAG selects the rest.
+  if (isGlobalISelEnabled() && getX86Subtarget().is64Bit()) {
+    addPass(createIRTranslatorPass());
+    addPass(createLegalizerPass());
+    addPass(createRegBankSelectPass());
+    addPass(createInstructionSelectPass());
+  }
+
   // Install an instruction selector.
   addPass(createX86ISelDag(getX86TargetMachine(), getOptLevel()));
 
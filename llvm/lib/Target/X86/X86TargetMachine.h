@@ -15,10 +15,14 @@
 #define X86TARGETMACHINE_H
 
 #include "X86.h"
+#include "X86CallLowering.h"
 #include "X86FrameLowering.h"
 #include "X86ISelLowering.h"
 #include "X86InstrInfo.h"
+#include "X86InstructionSelector.h"
 #include "X86JITInfo.h"
+#include "X86LegalizerInfo.h"
+#include "X86RegisterBankInfo.h"
 #include "X86SelectionDAGInfo.h"
 #include "X86Subtarget.h"
 #include "llvm/IR/DataLayout.h"
@@ -112,6 +116,10 @@ class X86_64TargetMachine : public X86TargetMachine {
   X86TargetLowering TLInfo;
   X86SelectionDAGInfo TSInfo;
   X86JITInfo        JITInfo;
+  X86CallLowering   CallLoweringInfo;
+  X86LegalizerInfo  LegalizerInfo;
+  X86RegisterBankInfo RegBankInfo;
+  X86InstructionSelector InstSelector;
 public:
   X86_64TargetMachine(const Target &T, StringRef TT,
                       StringRef CPU, StringRef FS, const TargetOptions &Options,
@@ -130,6 +138,18 @@ public:
   virtual       X86JITInfo       *getJITInfo()         {
     return &JITInfo;
   }
+  virtual const X86CallLowering *getCallLowering() const {
+    return &CallLoweringInfo;
+  }
+  virtual const X86LegalizerInfo *getLegalizerInfo() const {
+    return &LegalizerInfo;
+  }
+  virtual const X86RegisterBankInfo *getRegisterBankInfo() const {
+    return &RegBankInfo;
+  }
+  virtual const X86InstructionSelector *getInstructionSelector() const {
+    return &InstSelector;
+  }
 };
 
 } // End llvm namespace
@@ -76,6 +76,8 @@ public:
   /// \name Scalar TTI Implementations
   /// @{
   virtual PopcntSupportKind getPopcntSupport(unsigned TyWidth) const;
+  virtual bool isLegalMaskedLoad(Type *DataType) const;
+  virtual bool isLegalMaskedStore(Type *DataType) const;
 
   /// @}
 
@@ -99,6 +101,14 @@ public:
   virtual unsigned getMemoryOpCost(unsigned Opcode, Type *Src,
                                    unsigned Alignment,
                                    unsigned AddressSpace) const;
+  virtual unsigned getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                              unsigned Factor,
+                                              ArrayRef<unsigned> Indices,
+                                              unsigned Alignment,
+                                              unsigned AddressSpace) const;
+  virtual unsigned getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                         unsigned Alignment,
+                                         unsigned AddressSpace) const;
 
   virtual unsigned getAddressComputationCost(Type *PtrTy, bool IsComplex) const;
   
@@ -134,6 +144,32 @@ X86TTI::PopcntSupportKind X86TTI::getPopcntSupport(unsigned TyWidth) const {
   return ST->hasPOPCNT() ? PSK_FastHardware : PSK_Software;
 }
 
+bool X86TTI::isLegalMaskedLoad(Type *DataType) const {
+  // AVX provides vmaskmovps/pd, which handle 32 and 64 bit elements in 128
+  // and 256 bit vectors. Integer elements are moved through the same
+  // instructions.
+  if (!ST->hasAVX())
+    return false;
+
+  Type *EltTy = DataType->getScalarType();
+  if (!EltTy->isIntegerTy() && !EltTy->isFloatingPointTy())
+    return false;
+  unsigned EltSize = EltTy->getPrimitiveSizeInBits();
+  if (EltSize != 32 && EltSize != 64)
+    return false;
+
+  // A scalar type asks whether the elements can be accessed through a mask
+  // at all, before the vector width is known.
+  if (!DataType->isVectorTy())
+    return true;
+  unsigned Size = DataType->getPrimitiveSizeInBits();
+  return Size == 128 || Size == 256;
+}
+
+bool X86TTI::isLegalMaskedStore(Type *DataType) const {
+  return isLegalMaskedLoad(DataType);
+}
+
 unsigned X86TTI::getNumberOfRegisters(bool Vector) const {
   if (Vector && !ST->hasSSE1())
     return 0;
@@ -599,6 +635,58 @@ unsigned X86TTI::getMemoryOpCost(unsigned Opcode, Type *Src, unsigned Alignment,
   return Cost;
 }
 
+unsigned X86TTI::getMaskedMemoryOpCost(unsigned Opcode, Type *Src,
+                                       unsigned Alignment,
+                                       unsigned AddressSpace) const {
+  if ((Opcode == Instruction::Load && !isLegalMaskedLoad(Src)) ||
+      (Opcode == Instruction::Store && !isLegalMaskedStore(Src)))
+    return TargetTransformInfo::getMaskedMemoryOpCost(Opcode, Src, Alignment,
+                                                      AddressSpace);
+
+  // vmaskmov loads are two uops; the stores are about twice as expensive.
+  // The mask is already in a vector register, as the result of a vector
+  // compare.
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(Src);
+  return LT.first * (Opcode == Instruction::Load ? 2 : 4);
+}
+
+unsigned X86TTI::getInterleavedMemoryOpCost(unsigned Opcode, Type *VecTy,
+                                            unsigned Factor,
+                                            ArrayRef<unsigned> Indices,
+                                            unsigned Alignment,
+                                            unsigned AddressSpace) const {
+  VectorType *VT = cast<VectorType>(VecTy);
+  Type *EltTy = VT->getElementType();
+  unsigned EltSize = EltTy->getPrimitiveSizeInBits();
+  VectorType *SubVT = VectorType::get(EltTy, VT->getNumElements() / Factor);
+  std::pair<unsigned, MVT> LT = TLI->getTypeLegalizationCost(SubVT);
+
+  // Fields of 32 and 64 bit elements are separated and merged with shufps,
+  // unpck and their AVX forms. Narrower elements need pshufb or worse, so
+  // leave them, and larger factors, to the generic estimate.
+  if ((EltSize != 32 && EltSize != 64) || Factor > 4 || !LT.second.isVector())
+    return TargetTransformInfo::getInterleavedMemoryOpCost(
+        Opcode, VecTy, Factor, Indices, Alignment, AddressSpace);
+
+  // The wide access is split into one access per field.
+  unsigned Cost = Factor * getMemoryOpCost(Opcode, SubVT, Alignment,
+                                           AddressSpace);
+
+  // The number of shuffles per register of a field: one for two fields,
+  // a shuffle and two blends for three, and two levels of unpacks for four.
+  static const unsigned ShufflesPerReg[] = { 0, 0, 1, 3, 2 };
+  unsigned Shuffles = ShufflesPerReg[Factor];
+
+  // Shuffles across the 128 bit lanes of a 256 bit register are more
+  // expensive.
+  if (LT.second.getSizeInBits() > 128)
+    Shuffles *= 2;
+
+  // A load only separates the fields that are used; a store merges them all.
+  unsigned NumFields = Opcode == Instruction::Load ? Indices.size() : Factor;
+  return Cost + NumFields * LT.first * Shuffles;
+}
+
 unsigned X86TTI::getAddressComputationCost(Type *Ty, bool IsComplex) const {
   // Address computations in vectorized code with non-consecutive addresses will
   // likely result in more instructions compared to scalar code where the
@@ -50,6 +50,21 @@ static cl::opt<int>
 HintThreshold("inlinehint-threshold", cl::Hidden, cl::init(325),
               cl::desc("Threshold for inlining functions with inline hint"));
 
+static cl::opt<int>
+HotCallSiteThreshold("pgo-hot-callsite-threshold", cl::Hidden, cl::init(325),
+                     cl::desc("Threshold for inlining call sites the profile "
+                              "shows to be hot"));
+
+static cl::opt<int>
+ColdCallSiteThreshold("pgo-cold-callsite-threshold", cl::Hidden, cl::init(45),
+                      cl::desc("Threshold for inlining call sites the profile "
+                               "shows were never executed"));
+
+static cl::opt<unsigned>
+HotCallSitePercent("pgo-hot-callsite-percent", cl::Hidden, cl::init(1),
+                   cl::desc("A call site is hot if it executed at least this "
+                            "percentage of the largest count in the profile"));
+
 // Threshold to use when optsize is specified (and there is no -inline-limit).
 const int OptSizeThreshold = 75;
 
@@ -252,6 +267,39 @@ static bool InlineCallIfPossible(CallSite CS, InlineFunctionInfo &IFI,
   return true;
 }
 
+/// getProfileCount - Return true and set Count to the number of times the
+/// call site executed if -pgo-instr-use recorded it.  MaxCount is set to the
+/// largest count in the profile.
+static bool getProfileCount(CallSite CS, uint64_t &Count, uint64_t &MaxCount) {
+  MDNode *Weights = CS.getInstruction()->getMetadata(LLVMContext::MD_prof);
+  if (!Weights || Weights->getNumOperands() != 2)
+    return false;
+  MDString *Name = dyn_cast<MDString>(Weights->getOperand(0));
+  ConstantInt *C = dyn_cast<ConstantInt>(Weights->getOperand(1));
+  if (!Name || !Name->getString().equals("branch_weights") || !C)
+    return false;
+
+  Module *M = CS.getInstruction()->getParent()->getParent()->getParent();
+  ConstantInt *Max =
+    dyn_cast_or_null<ConstantInt>(M->getModuleFlag("ProfileMaxCount"));
+  if (!Max || Max->isZero())
+    return false;
+  Count = C->getZExtValue();
+  MaxCount = Max->getZExtValue();
+  return true;
+}
+
+/// isHotCount - Return true if Count is at least HotCallSitePercent percent of
+/// MaxCount.  The percentage of MaxCount is taken by parts so that it neither
+/// overflows nor rounds down to zero when MaxCount is below 100.
+static bool isHotCount(uint64_t Count, uint64_t MaxCount) {
+  if (HotCallSitePercent > 100)
+    return false;
+  uint64_t HotCount = MaxCount / 100 * HotCallSitePercent +
+                      (MaxCount % 100 * HotCallSitePercent + 99) / 100;
+  return Count >= HotCount;
+}
+
 unsigned Inliner::getInlineThreshold(CallSite CS) const {
   int thres = InlineThreshold; // -inline-threshold or else selected by
                                // overall opt level
@@ -277,6 +325,20 @@ unsigned Inliner::getInlineThreshold(CallSite CS) const {
                                                Attribute::MinSize))
     thres = HintThreshold;
 
+  // A profile tells better than the attributes: call sites the training run
+  // never reached are only worth inlining if the callee is tiny, and hot ones
+  // are inlined as if hinted.
+  uint64_t Count, MaxCount;
+  if (getProfileCount(CS, Count, MaxCount)) {
+    if (Count == 0)
+      thres = std::min<int>(thres, ColdCallSiteThreshold);
+    else if (isHotCount(Count, MaxCount) &&
+             HotCallSiteThreshold > thres &&
+             !Caller->getAttributes().hasAttribute(AttributeSet::FunctionIndex,
+                                                   Attribute::MinSize))
+      thres = HotCallSiteThreshold;
+  }
+
   return thres;
 }
 
@@ -23,6 +23,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/Instrumentation.h"
 #include "llvm/Transforms/Scalar.h"
 #include "llvm/Transforms/Vectorize.h"
 
@@ -54,6 +55,19 @@ static cl::opt<bool> UseNewSROA("use-new-sroa",
   cl::init(true), cl::Hidden,
   cl::desc("Enable the new, experimental SROA pass"));
 
+static cl::opt<bool>
+RunPGOInstrGen("profile-instr-generate", cl::Hidden,
+               cl::desc("Insert the counters of profile guided optimization"));
+
+static cl::opt<std::string>
+RunPGOInstrUse("profile-instr-use", cl::Hidden, cl::value_desc("filename"),
+               cl::desc("Optimize with the profile of a program built with "
+                        "-profile-instr-generate"));
+
+static cl::opt<std::string>
+RunPGOSampleUse("profile-sample-use", cl::Hidden, cl::value_desc("filename"),
+                cl::desc("Optimize with a sampled profile"));
+
 PassManagerBuilder::PassManagerBuilder() {
     OptLevel = 2;
     SizeLevel = 0;
@@ -65,6 +79,9 @@ PassManagerBuilder::PassManagerBuilder() {
     SLPVectorize = RunSLPVectorization;
     LoopVectorize = RunLoopVectorization;
     LateVectorize = LateVectorization;
+    PGOInstrGen = RunPGOInstrGen;
+    PGOInstrUse = RunPGOInstrUse;
+    PGOSampleUse = RunPGOSampleUse;
 }
 
 PassManagerBuilder::~PassManagerBuilder() {
@@ -124,7 +141,20 @@ void PassManagerBuilder::populateFunctionPassManager(FunctionPassManager &FPM) {
   FPM.add(createLowerExpectIntrinsicPass());
 }
 
+void PassManagerBuilder::addPGOPasses(PassManagerBase &MPM) const {
+  if (PGOInstrGen)
+    MPM.add(createPGOInstrumentationGenPass());
+  if (!PGOInstrUse.empty())
+    MPM.add(createPGOInstrumentationUsePass(PGOInstrUse));
+  if (!PGOSampleUse.empty())
+    MPM.add(createSampleProfileLoaderPass(PGOSampleUse));
+}
+
 void PassManagerBuilder::populateModulePassManager(PassManagerBase &MPM) {
+  // The counters and the profile go in before anything else changes the CFG,
+  // so that both see the same one.
+  addPGOPasses(MPM);
+
   // If all optimizations are disabled, just run the always-inline pass.
   if (OptLevel == 0) {
     if (Inliner) {
@@ -65,12 +65,20 @@ STATISTIC(NumSunkInst , "Number of instructions sunk");
 STATISTIC(NumExpand,    "Number of expansions");
 STATISTIC(NumFactor   , "Number of factorizations");
 STATISTIC(NumReassoc  , "Number of reassociations");
+STATISTIC(NumSweeps,    "Number of sweeps over whole functions");
+STATISTIC(NumMaxSweeps, "Most sweeps over a single function");
+STATISTIC(NumSweepLimit, "Number of functions that hit the sweep limit");
 
 static cl::opt<bool> UnsafeFPShrink("enable-double-float-shrink", cl::Hidden,
                                    cl::init(false),
                                    cl::desc("Enable unsafe double to float "
                                             "shrinking for math lib calls"));
 
+static cl::opt<unsigned>
+MaxIterations("instcombine-max-iterations", cl::Hidden, cl::init(1000),
+              cl::desc("Stop combining a function after this many sweeps "
+                       "(0 = no limit, default = 1000)"));
+
 // Initialization Routines
 void llvm::initializeInstCombine(PassRegistry &Registry) {
   initializeInstCombinerPass(Registry);
@@ -2324,6 +2332,7 @@ bool InstCombiner::DoOneIteration(Function &F, unsigned Iteration) {
     // the reachable instructions.  Ignore blocks that are not reachable.  Keep
     // track of which blocks we visit.
     SmallPtrSet<BasicBlock*, 64> Visited;
+    ++NumSweeps;
     MadeIRChange |= AddReachableCodeToWorklist(F.begin(), Visited, *this, TD,
                                                TLI);
 
@@ -2517,10 +2526,18 @@ bool InstCombiner::runOnFunction(Function &F) {
   // by instcombiner.
   EverMadeChange = LowerDbgDeclare(F);
 
-  // Iterate while there is work to do.
+  // Iterate while there is work to do, up to the limit.
   unsigned Iteration = 0;
-  while (DoOneIteration(F, Iteration++))
+  while (DoOneIteration(F, Iteration++)) {
     EverMadeChange = true;
+    if (MaxIterations && Iteration == MaxIterations) {
+      DEBUG(dbgs() << "IC: Giving up on " << F.getName() << " after "
+                   << Iteration << " sweeps\n");
+      ++NumSweepLimit;
+      break;
+    }
+  }
+  NumMaxSweeps.updateMax(Iteration);
 
   Builder = 0;
   return EverMadeChange;
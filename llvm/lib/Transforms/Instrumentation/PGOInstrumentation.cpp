@@ -0,0 +1,463 @@
+//===- PGOInstrumentation.cpp - Counter based profile guided optimization -===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the two halves of counter based profile guided
+// optimization:
+//
+// -pgo-instr-gen gives every function a counter for its entries and one for
+// each successor edge of its conditional branches and switches, and registers
+// the counters with the runtime in compiler-rt/lib/profile/PGOProfiling.c,
+// which writes them out at exit.
+//
+// -pgo-instr-use reads such a profile back, run at the same point of the
+// pipeline on the same input.  It turns the edge counters into branch_weights
+// on the terminators, the call sites' block counts into branch_weights on the
+// calls, and the entry counter into a "pgo-entry-count" function attribute.
+// Branch probabilities, the inliner, block placement and switch lowering take
+// them from there.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "pgo-instr"
+#include "llvm/Transforms/Instrumentation.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/PGOProfile.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <algorithm>
+using namespace llvm;
+
+STATISTIC(NumInstrumentedFunctions, "Number of functions instrumented");
+STATISTIC(NumCounters, "Number of counters inserted");
+STATISTIC(NumAnnotatedFunctions, "Number of functions given profile data");
+STATISTIC(NumMissingFunctions, "Number of functions not in the profile");
+STATISTIC(NumMismatchedFunctions,
+          "Number of functions whose profile does not match their CFG");
+
+static cl::opt<std::string>
+PGOProfileFile("pgo-profile-file", cl::init("default.pgodata"),
+               cl::value_desc("filename"), cl::Hidden,
+               cl::desc("The profile -pgo-instr-use reads"));
+
+namespace {
+/// CounterLayout - The counters of a function.  Counter 0 counts the entries
+/// of the function, and each conditional branch and switch gets one counter
+/// per successor edge, in the order of the blocks.  Generation and use must
+/// agree on the layout; the hash of the CFG it was computed from tells when
+/// they do not.
+struct CounterLayout {
+  /// Terminators - The instrumented terminators, each with the index of the
+  /// counter of its first successor edge.
+  SmallVector<std::pair<TerminatorInst*, unsigned>, 16> Terminators;
+
+  unsigned NumCounters;
+  uint64_t Hash;
+
+  explicit CounterLayout(Function &F);
+};
+}
+
+/// isInstrumentedTerminator - Return true if the edges of TI get counters.
+/// Invokes and indirect branches do not: their edges cannot all be split.
+static bool isInstrumentedTerminator(const TerminatorInst *TI) {
+  if (const BranchInst *BI = dyn_cast<BranchInst>(TI))
+    return BI->isConditional();
+  return isa<SwitchInst>(TI) && TI->getNumSuccessors() > 1;
+}
+
+/// mixHash - Fold V into the FNV-1a hash H.  The hash is written to profiles,
+/// so unlike hash_combine it must not depend on the host.
+static uint64_t mixHash(uint64_t H, uint64_t V) {
+  for (unsigned i = 0; i != 8; ++i) {
+    H ^= (V >> (i * 8)) & 0xff;
+    H *= 1099511628211ULL;
+  }
+  return H;
+}
+
+CounterLayout::CounterLayout(Function &F) : NumCounters(1) {
+  DenseMap<BasicBlock*, unsigned> BlockNumbers;
+  unsigned NumBlocks = 0;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    BlockNumbers[BB] = NumBlocks++;
+
+  Hash = mixHash(14695981039346656037ULL, BlockNumbers.size());
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    TerminatorInst *TI = BB->getTerminator();
+    if (!isInstrumentedTerminator(TI))
+      continue;
+    Terminators.push_back(std::make_pair(TI, NumCounters));
+    NumCounters += TI->getNumSuccessors();
+
+    Hash = mixHash(Hash, BlockNumbers[BB]);
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i)
+      Hash = mixHash(Hash, BlockNumbers[TI->getSuccessor(i)]);
+  }
+}
+
+/// getProfileName - Return the name F is recorded under.  Local functions
+/// are qualified with the module so that those of different modules do not
+/// share a profile.
+static std::string getProfileName(const Function &F) {
+  if (F.hasLocalLinkage())
+    return F.getParent()->getModuleIdentifier() + ":" + F.getName().str();
+  return F.getName();
+}
+
+/// shouldProfile - Return true if F has a body that is emitted by this
+/// module.
+static bool shouldProfile(const Function &F) {
+  return !F.isDeclaration() && !F.hasAvailableExternallyLinkage();
+}
+
+namespace {
+/// PGOInstrumentationGen - Inserts the counters and registers them with the
+/// runtime.
+class PGOInstrumentationGen : public ModulePass {
+public:
+  static char ID;
+  PGOInstrumentationGen() : ModulePass(ID) {
+    initializePGOInstrumentationGenPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M);
+
+  const char *getPassName() const {
+    return "PGO counter instrumentation";
+  }
+
+private:
+  /// instrumentFunction - Insert the counter increments of F and return the
+  /// counter array.
+  GlobalVariable *instrumentFunction(Function &F, const CounterLayout &Layout);
+};
+
+/// PGOInstrumentationUse - Reads a profile and annotates the IR with it.
+class PGOInstrumentationUse : public ModulePass {
+  std::string Filename;
+
+public:
+  static char ID;
+  PGOInstrumentationUse(StringRef Filename = StringRef())
+    : ModulePass(ID), Filename(Filename.empty() ? std::string(PGOProfileFile)
+                                                : Filename.str()) {
+    initializePGOInstrumentationUsePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M);
+
+  const char *getPassName() const {
+    return "PGO profile annotation";
+  }
+
+private:
+  void annotateFunction(Function &F, const CounterLayout &Layout,
+                        ArrayRef<uint64_t> Counts, uint64_t MaxCount);
+};
+}
+
+char PGOInstrumentationGen::ID = 0;
+INITIALIZE_PASS(PGOInstrumentationGen, "pgo-instr-gen",
+                "Insert counters for profile guided optimization",
+                false, false)
+
+ModulePass *llvm::createPGOInstrumentationGenPass() {
+  return new PGOInstrumentationGen();
+}
+
+char PGOInstrumentationUse::ID = 0;
+INITIALIZE_PASS(PGOInstrumentationUse, "pgo-instr-use",
+                "Annotate the IR with a counter profile", false, false)
+
+ModulePass *llvm::createPGOInstrumentationUsePass(StringRef Filename) {
+  return new PGOInstrumentationUse(Filename);
+}
+
+/// insertIncrement - Add one to counter Idx of Counters at IP.
+static void insertIncrement(Instruction *IP, GlobalVariable *Counters,
+                            unsigned Idx) {
+  IRBuilder<> Builder(IP);
+  Value *Addr = Builder.CreateConstInBoundsGEP2_64(Counters, 0, Idx);
+  Value *Count = Builder.CreateLoad(Addr);
+  Builder.CreateStore(Builder.CreateAdd(Count, Builder.getInt64(1)), Addr);
+}
+
+GlobalVariable *
+PGOInstrumentationGen::instrumentFunction(Function &F,
+                                          const CounterLayout &Layout) {
+  ArrayType *CountersTy = ArrayType::get(Type::getInt64Ty(F.getContext()),
+                                         Layout.NumCounters);
+  GlobalVariable *Counters =
+    new GlobalVariable(*F.getParent(), CountersTy, false,
+                       GlobalValue::PrivateLinkage,
+                       Constant::getNullValue(CountersTy),
+                       "__llvm_pgo_counters_" + F.getName());
+
+  insertIncrement(F.getEntryBlock().getFirstInsertionPt(), Counters, 0);
+  for (unsigned i = 0, e = Layout.Terminators.size(); i != e; ++i) {
+    TerminatorInst *TI = Layout.Terminators[i].first;
+    unsigned Counter = Layout.Terminators[i].second;
+    for (unsigned s = 0, se = TI->getNumSuccessors(); s != se; ++s) {
+      // An edge to a block with other predecessors is counted in a block of
+      // its own.
+      BasicBlock *Dest = TI->getSuccessor(s);
+      if (!Dest->getSinglePredecessor())
+        Dest = SplitCriticalEdge(TI, s);
+      assert(Dest && "Could not split an instrumented edge");
+      insertIncrement(Dest->getFirstInsertionPt(), Counters, Counter + s);
+    }
+  }
+
+  NumCounters += Layout.NumCounters;
+  ++NumInstrumentedFunctions;
+  return Counters;
+}
+
+bool PGOInstrumentationGen::runOnModule(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  Type *Int8PtrTy = Type::getInt8PtrTy(Ctx);
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+
+  // The runtime's struct llvm_pgo_function.
+  StructType *RecordTy = StructType::get(Int8PtrTy, Int64Ty, Int32Ty,
+                                         Int64Ty->getPointerTo(), NULL);
+
+  std::vector<Function*> Functions;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F)
+    if (shouldProfile(*F))
+      Functions.push_back(F);
+  if (Functions.empty())
+    return false;
+
+  std::vector<Constant*> Records;
+  for (unsigned i = 0, e = Functions.size(); i != e; ++i) {
+    Function &F = *Functions[i];
+    CounterLayout Layout(F);
+    GlobalVariable *Counters = instrumentFunction(F, Layout);
+
+    Constant *NameInit = ConstantDataArray::getString(Ctx,
+                                                      getProfileName(F));
+    GlobalVariable *Name =
+      new GlobalVariable(M, NameInit->getType(), true,
+                         GlobalValue::PrivateLinkage, NameInit,
+                         "__llvm_pgo_name_" + F.getName());
+    Name->setUnnamedAddr(true);
+
+    Constant *Fields[] = {
+      ConstantExpr::getPointerCast(Name, Int8PtrTy),
+      ConstantInt::get(Int64Ty, Layout.Hash),
+      ConstantInt::get(Int32Ty, Layout.NumCounters),
+      ConstantExpr::getPointerCast(Counters, Int64Ty->getPointerTo())
+    };
+    Records.push_back(ConstantStruct::get(RecordTy, Fields));
+  }
+
+  ArrayType *TableTy = ArrayType::get(RecordTy, Records.size());
+  GlobalVariable *Table =
+    new GlobalVariable(M, TableTy, true, GlobalValue::PrivateLinkage,
+                       ConstantArray::get(TableTy, Records),
+                       "__llvm_pgo_functions");
+
+  // Register the table with the runtime before main runs.  The runtime
+  // writes the counters out at exit.
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(Ctx), false);
+  Function *Init = Function::Create(FTy, GlobalValue::InternalLinkage,
+                                    "__llvm_pgo_init", &M);
+  Init->setUnnamedAddr(true);
+  Init->addFnAttr(Attribute::NoInline);
+
+  IRBuilder<> Builder(BasicBlock::Create(Ctx, "entry", Init));
+  Constant *Register =
+    M.getOrInsertFunction("llvm_pgo_register_functions",
+                          Type::getVoidTy(Ctx), RecordTy->getPointerTo(),
+                          Int32Ty, NULL);
+  Builder.CreateCall2(Register,
+                      Builder.CreateConstInBoundsGEP2_64(Table, 0, 0),
+                      Builder.getInt32(Records.size()));
+  Builder.CreateRetVoid();
+
+  appendToGlobalCtors(M, Init, 0);
+  return true;
+}
+
+/// computeBlockCounts - Derive the execution counts of the blocks of F from
+/// its counters.  A block ending in an instrumented terminator executed as
+/// often as its edges were taken; any other block as often as its incoming
+/// edges were, once those are known.  Blocks whose count cannot be derived,
+/// such as landing pads, are left out of BlockCounts.
+static void computeBlockCounts(Function &F, const CounterLayout &Layout,
+                               ArrayRef<uint64_t> Counts,
+                               DenseMap<BasicBlock*, uint64_t> &BlockCounts) {
+  DenseMap<TerminatorInst*, unsigned> FirstCounter;
+  for (unsigned i = 0, e = Layout.Terminators.size(); i != e; ++i) {
+    TerminatorInst *TI = Layout.Terminators[i].first;
+    unsigned Counter = Layout.Terminators[i].second;
+    FirstCounter[TI] = Counter;
+
+    uint64_t Sum = 0;
+    for (unsigned s = 0, se = TI->getNumSuccessors(); s != se; ++s)
+      Sum += Counts[Counter + s];
+    BlockCounts[TI->getParent()] = Sum;
+  }
+  BlockCounts[&F.getEntryBlock()] = Counts[0];
+
+  bool Changed;
+  do {
+    Changed = false;
+    for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+      if (BlockCounts.count(BB))
+        continue;
+
+      uint64_t Sum = 0;
+      bool Known = pred_begin(BB) != pred_end(BB);
+      SmallPtrSet<BasicBlock*, 8> Visited;
+      for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB);
+           Known && PI != PE; ++PI) {
+        BasicBlock *Pred = *PI;
+        if (!Visited.insert(Pred))
+          continue;
+        TerminatorInst *TI = Pred->getTerminator();
+
+        // The counters of an instrumented terminator give its edges.
+        DenseMap<TerminatorInst*, unsigned>::iterator FC =
+          FirstCounter.find(TI);
+        if (FC != FirstCounter.end()) {
+          for (unsigned s = 0, se = TI->getNumSuccessors(); s != se; ++s)
+            if (TI->getSuccessor(s) == BB)
+              Sum += Counts[FC->second + s];
+          continue;
+        }
+
+        // Otherwise only an unconditional edge, or the normal edge of an
+        // invoke that did not throw, carries the count of its block.
+        DenseMap<BasicBlock*, uint64_t>::iterator PC = BlockCounts.find(Pred);
+        InvokeInst *II = dyn_cast<InvokeInst>(TI);
+        if (PC == BlockCounts.end() ||
+            !(TI->getNumSuccessors() == 1 || (II && II->getNormalDest() == BB &&
+                                              II->getUnwindDest() != BB)))
+          Known = false;
+        else
+          Sum += PC->second;
+      }
+
+      if (Known) {
+        BlockCounts[BB] = Sum;
+        Changed = true;
+      }
+    }
+  } while (Changed);
+}
+
+void PGOInstrumentationUse::annotateFunction(Function &F,
+                                             const CounterLayout &Layout,
+                                             ArrayRef<uint64_t> Counts,
+                                             uint64_t MaxCount) {
+  MDBuilder MDB(F.getContext());
+
+  // Branch weights are 32 bits and BranchProbabilityInfo wants their sum to
+  // fit as well, so scale the counts of busy terminators down.
+  for (unsigned i = 0, e = Layout.Terminators.size(); i != e; ++i) {
+    TerminatorInst *TI = Layout.Terminators[i].first;
+    ArrayRef<uint64_t> EdgeCounts =
+      Counts.slice(Layout.Terminators[i].second, TI->getNumSuccessors());
+    uint64_t MaxEdge = *std::max_element(EdgeCounts.begin(), EdgeCounts.end());
+    // Leave the heuristics to never executed code.
+    if (MaxEdge == 0)
+      continue;
+
+    uint64_t Scale = MaxEdge / (UINT32_MAX / EdgeCounts.size()) + 1;
+    SmallVector<uint32_t, 4> Weights;
+    for (unsigned s = 0, se = EdgeCounts.size(); s != se; ++s)
+      Weights.push_back(EdgeCounts[s] / Scale);
+    TI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(Weights));
+  }
+
+  // Record how often each call was executed, for the inliner.  Unlike
+  // branch weights these are absolute, so they keep all 64 bits.
+  DenseMap<BasicBlock*, uint64_t> BlockCounts;
+  computeBlockCounts(F, Layout, Counts, BlockCounts);
+  Type *Int64Ty = Type::getInt64Ty(F.getContext());
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    DenseMap<BasicBlock*, uint64_t>::iterator BC = BlockCounts.find(BB);
+    if (BC == BlockCounts.end())
+      continue;
+    Value *Ops[] = { MDB.createString("branch_weights"),
+                     ConstantInt::get(Int64Ty, BC->second) };
+    MDNode *CallCount = MDNode::get(F.getContext(), Ops);
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      CallInst *CI = dyn_cast<CallInst>(I);
+      if (!CI || isa<IntrinsicInst>(CI) || CI->isInlineAsm())
+        continue;
+      CI->setMetadata(LLVMContext::MD_prof, CallCount);
+    }
+  }
+
+  F.addFnAttr("pgo-entry-count", utostr(Counts[0]));
+  // A function the training run never entered is cold.
+  if (Counts[0] == 0 && MaxCount != 0)
+    F.addFnAttr(Attribute::Cold);
+}
+
+bool PGOInstrumentationUse::runOnModule(Module &M) {
+  std::string Error;
+  OwningPtr<PGOProfileReader> Reader(PGOProfileReader::create(Filename,
+                                                              Error));
+  if (!Reader) {
+    M.getContext().emitError("could not read profile '" + Filename + "': " +
+                             Error);
+    return false;
+  }
+
+  bool Changed = false;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (!shouldProfile(*F))
+      continue;
+
+    const PGOFunctionProfile *FP =
+      Reader->getFunction(getProfileName(*F));
+    if (!FP) {
+      ++NumMissingFunctions;
+      continue;
+    }
+
+    CounterLayout Layout(*F);
+    if (FP->Hash != Layout.Hash || FP->Counts.size() != Layout.NumCounters) {
+      DEBUG(dbgs() << "PGO: profile of '" << F->getName()
+                   << "' does not match its CFG\n");
+      ++NumMismatchedFunctions;
+      continue;
+    }
+
+    annotateFunction(*F, Layout, FP->Counts, Reader->getMaximumCount());
+    ++NumAnnotatedFunctions;
+    Changed = true;
+  }
+
+  // The inliner compares call counts against the hottest count to decide
+  // which call sites are hot.
+  if (Changed && !M.getModuleFlag("ProfileMaxCount"))
+    M.addModuleFlag(Module::Max, "ProfileMaxCount",
+                    ConstantInt::get(Type::getInt64Ty(M.getContext()),
+                                     Reader->getMaximumCount()));
+  return Changed;
+}
@@ -22,6 +22,7 @@
 #include "llvm/Analysis/DominatorInternals.h"
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -62,6 +63,8 @@ STATISTIC(NumExtUses,    "Number of uses of [s|z]ext instructions optimized");
 STATISTIC(NumRetsDup,    "Number of return instructions duplicated");
 STATISTIC(NumDbgValueMoved, "Number of debug value instructions moved");
 STATISTIC(NumSelectsExpanded, "Number of selects turned into branches");
+STATISTIC(NumMaskedOpsScalarized, "Number of masked loads and stores "
+                                  "expanded into conditional scalar accesses");
 
 static cl::opt<bool> DisableBranchOpts(
   "disable-cgp-branch-opts", cl::Hidden, cl::init(false),
@@ -78,6 +81,7 @@ namespace {
     const TargetMachine *TM;
     const TargetLowering *TLI;
     const TargetLibraryInfo *TLInfo;
+    const TargetTransformInfo *TTI;
     DominatorTree *DT;
 
     /// CurInstIterator - As we scan instructions optimizing them, this is the
@@ -147,6 +151,7 @@ bool CodeGenPrepare::runOnFunction(Function &F) {
   ModifiedDT = false;
   if (TM) TLI = TM->getTargetLowering();
   TLInfo = &getAnalysis<TargetLibraryInfo>();
+  TTI = getAnalysisIfAvailable<TargetTransformInfo>();
   DT = getAnalysisIfAvailable<DominatorTree>();
   OptSize = F.getAttributes().hasAttribute(AttributeSet::FunctionIndex,
                                            Attribute::OptimizeForSize);
@@ -598,6 +603,99 @@ protected:
 };
 } // end anonymous namespace
 
+/// ScalarizeMaskedMemIntrinsic - Expand a llvm.masked.load or
+/// llvm.masked.store that the target can't handle into a chain of blocks that
+/// each test one bit of the mask and access the corresponding element:
+///
+///   %mask_1 = extractelement <4 x i1> %mask, i32 1
+///   br i1 %mask_1, label %cond.load1, label %else2
+/// cond.load1:
+///   %ptr1 = getelementptr float* %base, i32 1
+///   %elt1 = load float* %ptr1, align 4
+///   %res1 = insertelement <4 x float> %res0, float %elt1, i32 1
+///   br label %else2
+/// else2:
+///   %res.phi.else2 = phi <4 x float> [ %res1, %cond.load1 ], [ %res0, ... ]
+///
+/// Lanes whose mask bit is a constant are accessed, or skipped,
+/// unconditionally.
+static void ScalarizeMaskedMemIntrinsic(IntrinsicInst *II) {
+  bool IsLoad = II->getIntrinsicID() == Intrinsic::masked_load;
+  Value *Ptr = II->getArgOperand(IsLoad ? 0 : 1);
+  unsigned Align =
+    cast<ConstantInt>(II->getArgOperand(IsLoad ? 1 : 2))->getZExtValue();
+  Value *Mask = II->getArgOperand(IsLoad ? 2 : 3);
+  Value *Src = IsLoad ? 0 : II->getArgOperand(0);
+  VectorType *VecTy = cast<VectorType>(IsLoad ? II->getType()
+                                              : Src->getType());
+  Type *EltTy = VecTy->getElementType();
+  unsigned EltAlign = MinAlign(Align, EltTy->getPrimitiveSizeInBits() / 8);
+
+  IRBuilder<> Builder(II);
+  Value *FirstEltPtr = Builder.CreateBitCast(
+      Ptr, EltTy->getPointerTo(Ptr->getType()->getPointerAddressSpace()));
+  Value *Res = IsLoad ? II->getArgOperand(3) : 0;
+
+  BasicBlock *CurBB = II->getParent();
+  for (unsigned Idx = 0, E = VecTy->getNumElements(); Idx != E; ++Idx) {
+    Builder.SetInsertPoint(II);
+    Constant *CBit = 0;
+    if (Constant *C = dyn_cast<Constant>(Mask))
+      CBit = C->getAggregateElement(Idx);
+    if (CBit && (CBit->isNullValue() || isa<UndefValue>(CBit)))
+      continue;
+    if (CBit && isa<ConstantInt>(CBit)) {
+      // The lane is always accessed.
+      Value *EltPtr = Builder.CreateConstInBoundsGEP1_32(FirstEltPtr, Idx);
+      if (IsLoad) {
+        LoadInst *Load = Builder.CreateLoad(EltPtr);
+        Load->setAlignment(EltAlign);
+        Res = Builder.CreateInsertElement(Res, Load, Builder.getInt32(Idx));
+      } else {
+        Value *Elt = Builder.CreateExtractElement(Src, Builder.getInt32(Idx));
+        Builder.CreateStore(Elt, EltPtr)->setAlignment(EltAlign);
+      }
+      continue;
+    }
+    Value *Bit = Builder.CreateExtractElement(Mask, Builder.getInt32(Idx));
+
+    // Split the block before the intrinsic and branch around the access
+    // when the mask bit is clear.
+    BasicBlock *CondBB = CurBB->splitBasicBlock(II, IsLoad ? "cond.load"
+                                                           : "cond.store");
+    Builder.SetInsertPoint(II);
+    Value *EltPtr = Builder.CreateConstInBoundsGEP1_32(FirstEltPtr, Idx);
+    Value *NewRes = 0;
+    if (IsLoad) {
+      LoadInst *Load = Builder.CreateLoad(EltPtr);
+      Load->setAlignment(EltAlign);
+      NewRes = Builder.CreateInsertElement(Res, Load, Builder.getInt32(Idx));
+    } else {
+      Value *Elt = Builder.CreateExtractElement(Src, Builder.getInt32(Idx));
+      Builder.CreateStore(Elt, EltPtr)->setAlignment(EltAlign);
+    }
+
+    BasicBlock *NewBB = CondBB->splitBasicBlock(II, "else");
+    Instruction *OldBr = CurBB->getTerminator();
+    BranchInst::Create(CondBB, NewBB, Bit, OldBr);
+    OldBr->eraseFromParent();
+
+    if (IsLoad) {
+      Builder.SetInsertPoint(NewBB->begin());
+      PHINode *Phi = Builder.CreatePHI(VecTy, 2, "res.phi.else");
+      Phi->addIncoming(NewRes, CondBB);
+      Phi->addIncoming(Res, CurBB);
+      Res = Phi;
+    }
+    CurBB = NewBB;
+  }
+
+  if (IsLoad)
+    II->replaceAllUsesWith(Res);
+  II->eraseFromParent();
+  ++NumMaskedOpsScalarized;
+}
+
 bool CodeGenPrepare::OptimizeCallInst(CallInst *CI) {
   BasicBlock *BB = CI->getParent();
 
@@ -642,6 +740,24 @@ bool CodeGenPrepare::OptimizeCallInst(CallInst *CI) {
     return true;
   }
 
+  // Expand the masked loads and stores that the target can't lower.
+  if (II && (II->getIntrinsicID() == Intrinsic::masked_load ||
+             II->getIntrinsicID() == Intrinsic::masked_store)) {
+    bool IsLoad = II->getIntrinsicID() == Intrinsic::masked_load;
+    Type *DataTy = IsLoad ? II->getType() : II->getArgOperand(0)->getType();
+    if (TTI && (IsLoad ? TTI->isLegalMaskedLoad(DataTy)
+                       : TTI->isLegalMaskedStore(DataTy)))
+      return false;
+
+    ScalarizeMaskedMemIntrinsic(II);
+    ModifiedDT = true;
+    // The rest of the block was moved to a new block, which is visited
+    // later.
+    CurInstIterator = BB->begin();
+    SunkAddrs.clear();
+    return true;
+  }
+
   if (II && TLI) {
     SmallVector<Value*, 2> PtrOps;
     Type *AccessTy;
@@ -25,6 +25,7 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -33,6 +34,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Local.h"
@@ -41,23 +43,35 @@ using namespace llvm;
 STATISTIC(NumFastStores, "Number of stores deleted");
 STATISTIC(NumFastOther , "Number of other instrs removed");
 
+static cl::opt<bool>
+EnableMemorySSA("enable-dse-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Find the earlier writes a store kills using "
+                         "MemorySSA instead of memdep (experimental)"));
+
 namespace {
   struct DSE : public FunctionPass {
     AliasAnalysis *AA;
     MemoryDependenceAnalysis *MD;
     DominatorTree *DT;
     const TargetLibraryInfo *TLI;
+    MemorySSA *MSSA;
 
     static char ID; // Pass identification, replacement for typeid
-    DSE() : FunctionPass(ID), AA(0), MD(0), DT(0) {
+    DSE() : FunctionPass(ID), AA(0), MD(0), DT(0), MSSA(0) {
       initializeDSEPass(*PassRegistry::getPassRegistry());
     }
 
     virtual bool runOnFunction(Function &F) {
       AA = &getAnalysis<AliasAnalysis>();
-      MD = &getAnalysis<MemoryDependenceAnalysis>();
       DT = &getAnalysis<DominatorTree>();
       TLI = AA->getTargetLibraryInfo();
+      // With MemorySSA, memdep is only kept up to date if it is around.
+      if (EnableMemorySSA) {
+        MD = getAnalysisIfAvailable<MemoryDependenceAnalysis>();
+        MSSA = &getAnalysis<MemorySSAAnalysis>().getMSSA();
+      } else {
+        MD = &getAnalysis<MemoryDependenceAnalysis>();
+      }
 
       bool Changed = false;
       for (Function::iterator I = F.begin(), E = F.end(); I != E; ++I)
@@ -66,12 +80,21 @@ namespace {
         if (DT->isReachableFromEntry(I))
           Changed |= runOnBasicBlock(*I);
 
-      AA = 0; MD = 0; DT = 0;
+      AA = 0; MD = 0; DT = 0; MSSA = 0;
       return Changed;
     }
 
     bool runOnBasicBlock(BasicBlock &BB);
+    bool killEarlierWrite(Instruction *Inst,
+                          const AliasAnalysis::Location &Loc,
+                          Instruction *DepWrite,
+                          const AliasAnalysis::Location &DepLoc,
+                          bool &MadeChange);
+    bool eliminateKilledWrites(Instruction *Inst, BasicBlock::iterator &BBI);
+    bool isReadBeforeNextWrite(MemoryAccess *MA,
+                               const AliasAnalysis::Location &Loc);
     bool HandleFree(CallInst *F);
+    bool HandleFreeWithMemorySSA(CallInst *F);
     bool handleEndBlock(BasicBlock &BB);
     void RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
                                SmallSetVector<Value*, 16> &DeadStackObjects);
@@ -80,10 +103,15 @@ namespace {
       AU.setPreservesCFG();
       AU.addRequired<DominatorTree>();
       AU.addRequired<AliasAnalysis>();
-      AU.addRequired<MemoryDependenceAnalysis>();
+      if (EnableMemorySSA)
+        AU.addRequired<MemorySSAAnalysis>();
+      else
+        AU.addRequired<MemoryDependenceAnalysis>();
       AU.addPreserved<AliasAnalysis>();
       AU.addPreserved<DominatorTree>();
       AU.addPreserved<MemoryDependenceAnalysis>();
+      if (EnableMemorySSA)
+        AU.addPreserved<MemorySSAAnalysis>();
     }
   };
 }
@@ -92,6 +120,7 @@ char DSE::ID = 0;
 INITIALIZE_PASS_BEGIN(DSE, "dse", "Dead Store Elimination", false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(MemoryDependenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(MemorySSAAnalysis)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
 INITIALIZE_PASS_END(DSE, "dse", "Dead Store Elimination", false, false)
 
@@ -106,9 +135,11 @@ FunctionPass *llvm::createDeadStoreEliminationPass() { return new DSE(); }
 /// dead, delete them and the computation tree that feeds them.
 ///
 /// If ValueSet is non-null, remove any deleted instructions from it as well.
+/// MD and MSSA, when non-null, are updated.
 ///
 static void DeleteDeadInstruction(Instruction *I,
-                                  MemoryDependenceAnalysis &MD,
+                                  MemoryDependenceAnalysis *MD,
+                                  MemorySSA *MSSA,
                                   const TargetLibraryInfo *TLI,
                                   SmallSetVector<Value*, 16> *ValueSet = 0) {
   SmallVector<Instruction*, 32> NowDeadInsts;
@@ -124,7 +155,11 @@ static void DeleteDeadInstruction(Instruction *I,
     // This instruction is dead, zap it, in stages.  Start by removing it from
     // MemDep, which needs to know the operands and needs it to be in the
     // function.
-    MD.removeInstruction(DeadInst);
+    if (MD)
+      MD->removeInstruction(DeadInst);
+    if (MSSA)
+      if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(DeadInst))
+        MSSA->removeMemoryAccess(MA);
 
     for (unsigned op = 0, e = DeadInst->getNumOperands(); op != e; ++op) {
       Value *Op = DeadInst->getOperand(op);
@@ -505,6 +540,11 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
     if (!hasMemoryWrite(Inst, TLI))
       continue;
 
+    if (MSSA) {
+      MadeChange |= eliminateKilledWrites(Inst, BBI);
+      continue;
+    }
+
     MemDepResult InstDep = MD->getDependency(Inst);
 
     // Ignore any store where we can't find a local dependence.
@@ -525,7 +565,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
           // in case we need it.
           WeakVH NextInst(BBI);
 
-          DeleteDeadInstruction(SI, *MD, TLI);
+          DeleteDeadInstruction(SI, MD, MSSA, TLI);
 
           if (NextInst == 0)  // Next instruction deleted.
             BBI = BB.begin();
@@ -559,55 +599,13 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
       if (DepLoc.Ptr == 0)
         break;
 
-      // If we find a write that is a) removable (i.e., non-volatile), b) is
-      // completely obliterated by the store to 'Loc', and c) which we know that
-      // 'Inst' doesn't load from, then we can remove it.
-      if (isRemovable(DepWrite) &&
-          !isPossibleSelfRead(Inst, Loc, DepWrite, *AA)) {
-        int64_t InstWriteOffset, DepWriteOffset;
-        OverwriteResult OR = isOverwrite(Loc, DepLoc, *AA,
-                                         DepWriteOffset, InstWriteOffset);
-        if (OR == OverwriteComplete) {
-          DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: "
-                << *DepWrite << "\n  KILLER: " << *Inst << '\n');
-
-          // Delete the store and now-dead instructions that feed it.
-          DeleteDeadInstruction(DepWrite, *MD, TLI);
-          ++NumFastStores;
-          MadeChange = true;
-
-          // DeleteDeadInstruction can delete the current instruction in loop
-          // cases, reset BBI.
-          BBI = Inst;
-          if (BBI != BB.begin())
-            --BBI;
-          break;
-        } else if (OR == OverwriteEnd && isShortenable(DepWrite)) {
-          // TODO: base this on the target vector size so that if the earlier
-          // store was too small to get vector writes anyway then its likely
-          // a good idea to shorten it
-          // Power of 2 vector writes are probably always a bad idea to optimize
-          // as any store/memset/memcpy is likely using vector instructions so
-          // shortening it to not vector size is likely to be slower
-          MemIntrinsic* DepIntrinsic = cast<MemIntrinsic>(DepWrite);
-          unsigned DepWriteAlign = DepIntrinsic->getAlignment();
-          if (llvm::isPowerOf2_64(InstWriteOffset) ||
-              ((DepWriteAlign != 0) && InstWriteOffset % DepWriteAlign == 0)) {
-
-            DEBUG(dbgs() << "DSE: Remove Dead Store:\n  OW END: "
-                  << *DepWrite << "\n  KILLER (offset "
-                  << InstWriteOffset << ", "
-                  << DepLoc.Size << ")"
-                  << *Inst << '\n');
-
-            Value* DepWriteLength = DepIntrinsic->getLength();
-            Value* TrimmedLength = ConstantInt::get(DepWriteLength->getType(),
-                                                    InstWriteOffset -
-                                                    DepWriteOffset);
-            DepIntrinsic->setLength(TrimmedLength);
-            MadeChange = true;
-          }
-        }
+      if (killEarlierWrite(Inst, Loc, DepWrite, DepLoc, MadeChange)) {
+        // DeleteDeadInstruction can delete the current instruction in loop
+        // cases, reset BBI.
+        BBI = Inst;
+        if (BBI != BB.begin())
+          --BBI;
+        break;
       }
 
       // If this is a may-aliased store that is clobbering the store value, we
@@ -636,6 +634,168 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
   return MadeChange;
 }
 
+/// killEarlierWrite - Inst writes Loc and DepWrite is an earlier write of
+/// DepLoc.  If Inst makes all of DepWrite dead, delete it and return true; if
+/// it only makes the end of it dead, shorten it.
+bool DSE::killEarlierWrite(Instruction *Inst,
+                           const AliasAnalysis::Location &Loc,
+                           Instruction *DepWrite,
+                           const AliasAnalysis::Location &DepLoc,
+                           bool &MadeChange) {
+  // If we find a write that is a) removable (i.e., non-volatile), b) is
+  // completely obliterated by the store to 'Loc', and c) which we know that
+  // 'Inst' doesn't load from, then we can remove it.
+  if (isRemovable(DepWrite) &&
+      !isPossibleSelfRead(Inst, Loc, DepWrite, *AA)) {
+    int64_t InstWriteOffset, DepWriteOffset;
+    OverwriteResult OR = isOverwrite(Loc, DepLoc, *AA,
+                                     DepWriteOffset, InstWriteOffset);
+    if (OR == OverwriteComplete) {
+      DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: "
+            << *DepWrite << "\n  KILLER: " << *Inst << '\n');
+
+      // Delete the store and now-dead instructions that feed it.
+      DeleteDeadInstruction(DepWrite, MD, MSSA, TLI);
+      ++NumFastStores;
+      MadeChange = true;
+      return true;
+    } else if (OR == OverwriteEnd && isShortenable(DepWrite)) {
+      // TODO: base this on the target vector size so that if the earlier
+      // store was too small to get vector writes anyway then its likely
+      // a good idea to shorten it
+      // Power of 2 vector writes are probably always a bad idea to optimize
+      // as any store/memset/memcpy is likely using vector instructions so
+      // shortening it to not vector size is likely to be slower
+      MemIntrinsic* DepIntrinsic = cast<MemIntrinsic>(DepWrite);
+      unsigned DepWriteAlign = DepIntrinsic->getAlignment();
+      if (llvm::isPowerOf2_64(InstWriteOffset) ||
+          ((DepWriteAlign != 0) && InstWriteOffset % DepWriteAlign == 0)) {
+
+        DEBUG(dbgs() << "DSE: Remove Dead Store:\n  OW END: "
+              << *DepWrite << "\n  KILLER (offset "
+              << InstWriteOffset << ", "
+              << DepLoc.Size << ")"
+              << *Inst << '\n');
+
+        Value* DepWriteLength = DepIntrinsic->getLength();
+        Value* TrimmedLength = ConstantInt::get(DepWriteLength->getType(),
+                                                InstWriteOffset -
+                                                DepWriteOffset);
+        DepIntrinsic->setLength(TrimmedLength);
+        MadeChange = true;
+      }
+    }
+  }
+  return false;
+}
+
+/// isReadBeforeNextWrite - Return true if one of the MemoryUses of MA, which
+/// read memory before the next definition, may read Loc.  As with memdep,
+/// loads of constant memory are taken not to read what is written.
+bool DSE::isReadBeforeNextWrite(MemoryAccess *MA,
+                                const AliasAnalysis::Location &Loc) {
+  for (MemoryAccess::user_iterator I = MA->user_begin(), E = MA->user_end();
+       I != E; ++I) {
+    MemoryUse *MU = dyn_cast<MemoryUse>(*I);
+    if (!MU)
+      continue;
+    Instruction *Read = MU->getMemoryInst();
+    if (LoadInst *LI = dyn_cast<LoadInst>(Read))
+      if (AA->pointsToConstantMemory(AA->getLocation(LI)))
+        continue;
+    if (AA->getModRefInfo(Read, Loc) & AliasAnalysis::Ref)
+      return true;
+  }
+  return false;
+}
+
+/// eliminateKilledWrites - The part of runOnBasicBlock that handles Inst, a
+/// write, with -enable-dse-memoryssa: walk up the definitions of the block
+/// from Inst and remove or shorten the writes it kills.
+bool DSE::eliminateKilledWrites(Instruction *Inst, BasicBlock::iterator &BBI) {
+  BasicBlock &BB = *Inst->getParent();
+  MemoryUseOrDef *MA = MSSA->getMemoryAccess(Inst);
+  if (!MA)
+    return false;
+
+  // If we're storing the same value back to a pointer that we just loaded
+  // from, and nothing writes it in between, then the store can be removed.
+  // The walk up from the store stops at the load if it is a definition, and
+  // otherwise where the walk up from the load does.
+  StoreInst *SI = dyn_cast<StoreInst>(Inst);
+  LoadInst *DepLoad = SI ? dyn_cast<LoadInst>(SI->getValueOperand()) : 0;
+  if (DepLoad && SI->getPointerOperand() == DepLoad->getPointerOperand() &&
+      isRemovable(SI)) {
+    MemoryUseOrDef *LoadAccess = MSSA->getMemoryAccess(DepLoad);
+    MemoryAccess *StoreClobber =
+      MSSA->getClobberingMemoryAccess(MA->getDefiningAccess(),
+                                      AA->getLocation(SI));
+    if (StoreClobber == LoadAccess ||
+        (isa<MemoryUse>(LoadAccess) &&
+         StoreClobber == MSSA->getClobberingMemoryAccess(DepLoad))) {
+      DEBUG(dbgs() << "DSE: Remove Store Of Load from same pointer:\n  "
+                   << "LOAD: " << *DepLoad << "\n  STORE: " << *SI << '\n');
+
+      // DeleteDeadInstruction can delete the current instruction.  Save BBI
+      // in case we need it.
+      WeakVH NextInst(BBI);
+
+      DeleteDeadInstruction(SI, MD, MSSA, TLI);
+
+      if (NextInst == 0)  // Next instruction deleted.
+        BBI = BB.begin();
+      else if (BBI != BB.begin())  // Revisit this instruction if possible.
+        --BBI;
+      ++NumFastStores;
+      return true;
+    }
+  }
+
+  // Figure out what location is being stored to.
+  AliasAnalysis::Location Loc = getLocForWrite(Inst, *AA);
+
+  // If we didn't get a useful location, fail.
+  if (Loc.Ptr == 0)
+    return false;
+
+  // Like the memdep walk, this one stays in the block, and only stops at the
+  // definitions that may write or read Loc.
+  bool MadeChange = false;
+  MemoryAccess *Cur = MA->getDefiningAccess();
+  while (MemoryDef *DepDef = dyn_cast<MemoryDef>(Cur)) {
+    if (MSSA->isLiveOnEntryDef(DepDef) || DepDef->getBlock() != &BB)
+      break;
+
+    // Can't look past a load of 'Loc' between the two writes.
+    if (isReadBeforeNextWrite(DepDef, Loc))
+      break;
+
+    Instruction *DepWrite = DepDef->getMemoryInst();
+    AliasAnalysis::ModRefResult MR = AA->getModRefInfo(DepWrite, Loc);
+    if (MR != AliasAnalysis::NoModRef) {
+      AliasAnalysis::Location DepLoc = getLocForWrite(DepWrite, *AA);
+      // If we didn't get a useful location, or if it isn't a size, bail out.
+      if (DepLoc.Ptr == 0)
+        break;
+
+      if (killEarlierWrite(Inst, Loc, DepWrite, DepLoc, MadeChange)) {
+        // DeleteDeadInstruction can delete the current instruction in loop
+        // cases, reset BBI.
+        BBI = Inst;
+        if (BBI != BB.begin())
+          --BBI;
+        break;
+      }
+
+      // Can't look past this instruction if it might read 'Loc'.
+      if (MR & AliasAnalysis::Ref)
+        break;
+    }
+    Cur = DepDef->getDefiningAccess();
+  }
+  return MadeChange;
+}
+
 /// Find all blocks that will unconditionally lead to the block BB and append
 /// them to F.
 static void FindUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
@@ -655,6 +815,9 @@ static void FindUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
 /// HandleFree - Handle frees of entire structures whose dependency is a store
 /// to a field of that structure.
 bool DSE::HandleFree(CallInst *F) {
+  if (MSSA)
+    return HandleFreeWithMemorySSA(F);
+
   bool MadeChange = false;
 
   AliasAnalysis::Location Loc = AliasAnalysis::Location(F->getOperand(0));
@@ -682,7 +845,7 @@ bool DSE::HandleFree(CallInst *F) {
       Instruction *Next = llvm::next(BasicBlock::iterator(Dependency));
 
       // DCE instructions only used to calculate that store
-      DeleteDeadInstruction(Dependency, *MD, TLI);
+      DeleteDeadInstruction(Dependency, MD, MSSA, TLI);
       ++NumFastStores;
       MadeChange = true;
 
@@ -701,6 +864,71 @@ bool DSE::HandleFree(CallInst *F) {
   return MadeChange;
 }
 
+/// HandleFreeWithMemorySSA - HandleFree with -enable-dse-memoryssa: walk up
+/// the definitions from the free, into the predecessors whose only successor
+/// is the block the walk is in, and remove the stores to the freed object.
+bool DSE::HandleFreeWithMemorySSA(CallInst *F) {
+  MemoryUseOrDef *FreeAccess = MSSA->getMemoryAccess(F);
+  if (!FreeAccess)
+    return false;
+
+  bool MadeChange = false;
+  AliasAnalysis::Location Loc = AliasAnalysis::Location(F->getOperand(0));
+
+  // Each item is an access and the block the walk reached it from.
+  SmallVector<std::pair<MemoryAccess *, BasicBlock *>, 16> Worklist;
+  SmallPtrSet<MemoryAccess *, 16> Visited;
+  Worklist.push_back(std::make_pair(FreeAccess->getDefiningAccess(),
+                                    F->getParent()));
+  while (!Worklist.empty()) {
+    MemoryAccess *MA = Worklist.back().first;
+    BasicBlock *BB = Worklist.back().second;
+    Worklist.pop_back();
+
+    while (!MSSA->isLiveOnEntryDef(MA)) {
+      if (MA->getBlock() != BB) {
+        TerminatorInst *TI = MA->getBlock()->getTerminator();
+        if (TI->getNumSuccessors() != 1 || TI->getSuccessor(0) != BB)
+          break;
+        BB = MA->getBlock();
+      }
+      if (!Visited.insert(MA) || isReadBeforeNextWrite(MA, Loc))
+        break;
+
+      if (MemoryPhi *Phi = dyn_cast<MemoryPhi>(MA)) {
+        for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i) {
+          BasicBlock *Pred = Phi->getIncomingBlock(i);
+          if (Pred->getTerminator()->getNumSuccessors() == 1)
+            Worklist.push_back(std::make_pair(Phi->getIncomingValue(i), Pred));
+        }
+        break;
+      }
+
+      MemoryDef *Def = cast<MemoryDef>(MA);
+      Instruction *Dependency = Def->getMemoryInst();
+      MA = Def->getDefiningAccess();
+      if (AA->getModRefInfo(Dependency, Loc) == AliasAnalysis::NoModRef)
+        continue;
+      if (!hasMemoryWrite(Dependency, TLI) || !isRemovable(Dependency))
+        break;
+
+      Value *DepPointer =
+        GetUnderlyingObject(getStoredPointerOperand(Dependency));
+
+      // Check for aliasing.
+      if (!AA->isMustAlias(F->getArgOperand(0), DepPointer))
+        break;
+
+      // DCE instructions only used to calculate that store
+      DeleteDeadInstruction(Dependency, MD, MSSA, TLI);
+      ++NumFastStores;
+      MadeChange = true;
+    }
+  }
+
+  return MadeChange;
+}
+
 namespace {
   struct CouldRef {
     typedef Value *argument_type;
@@ -782,7 +1010,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
               dbgs() << '\n');
 
         // DCE instructions only used to calculate that store.
-        DeleteDeadInstruction(Dead, *MD, TLI, &DeadStackObjects);
+        DeleteDeadInstruction(Dead, MD, MSSA, TLI, &DeadStackObjects);
         ++NumFastStores;
         MadeChange = true;
         continue;
@@ -792,7 +1020,8 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
     // Remove any dead non-memory-mutating instructions.
     if (isInstructionTriviallyDead(BBI, TLI)) {
       Instruction *Inst = BBI++;
-      DeleteDeadInstruction(Inst, *MD, TLI, &DeadStackObjects);
+      DeleteDeadInstruction(Inst, MD, MSSA, TLI,
+                            &DeadStackObjects);
       ++NumFastOther;
       MadeChange = true;
       continue;
@@ -31,6 +31,7 @@
 #include "llvm/Analysis/Loads.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/PHITransAddr.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Assembly/Writer.h"
@@ -58,10 +59,16 @@ STATISTIC(NumGVNBlocks, "Number of blocks merged");
 STATISTIC(NumGVNSimpl,  "Number of instructions simplified");
 STATISTIC(NumGVNEqProp, "Number of equalities propagated");
 STATISTIC(NumPRELoad,   "Number of loads PRE'd");
+STATISTIC(NumMSSALoad,  "Number of loads deleted using MemorySSA");
+STATISTIC(NumPRESkipped, "Number of functions over budget skipping PRE");
 
 static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
+static cl::opt<bool>
+EnableMemorySSA("enable-gvn-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Find the values of loads and read-only calls using "
+                         "MemorySSA instead of memdep (experimental)"));
 
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
@@ -107,8 +114,14 @@ namespace {
     DenseMap<Expression, uint32_t> expressionNumbering;
     AliasAnalysis *AA;
     MemoryDependenceAnalysis *MD;
+    MemorySSA *MSSA;
     DominatorTree *DT;
 
+    /// callNumbering - The value numbers of read-only calls with MemorySSA, by
+    /// the number of the call expression and the ID of the version of memory
+    /// the call reads.
+    DenseMap<std::pair<uint32_t, unsigned>, uint32_t> callNumbering;
+
     uint32_t nextValueNumber;
 
     Expression create_expression(Instruction* I);
@@ -129,6 +142,7 @@ namespace {
     void setAliasAnalysis(AliasAnalysis* A) { AA = A; }
     AliasAnalysis *getAliasAnalysis() const { return AA; }
     void setMemDep(MemoryDependenceAnalysis* M) { MD = M; }
+    void setMemorySSA(MemorySSA *M) { MSSA = M; }
     void setDomTree(DominatorTree* D) { DT = D; }
     uint32_t getNextUnusedValueNumber() { return nextValueNumber; }
     void verifyRemoved(const Value *) const;
@@ -284,6 +298,22 @@ uint32_t ValueTable::lookup_or_add_call(CallInst *C) {
   } else if (AA->onlyReadsMemory(C)) {
     Expression exp = create_expression(C);
     uint32_t &e = expressionNumbering[exp];
+    if (MSSA) {
+      // Calls of the same expression that read the same version of memory
+      // have the same value.  findLeader picks one that dominates.
+      MemoryAccess *Clobber = MSSA->getClobberingMemoryAccess(C);
+      if (!Clobber) {
+        valueNumbering[C] = nextValueNumber;
+        return nextValueNumber++;
+      }
+      if (!e)
+        e = nextValueNumber++;
+      uint32_t &v = callNumbering[std::make_pair(e, Clobber->getID())];
+      if (!v)
+        v = nextValueNumber++;
+      valueNumbering[C] = v;
+      return v;
+    }
     if (!e) {
       e = nextValueNumber++;
       valueNumbering[C] = e;
@@ -479,6 +509,7 @@ uint32_t ValueTable::lookup_or_add_cmp(unsigned Opcode,
 void ValueTable::clear() {
   valueNumbering.clear();
   expressionNumbering.clear();
+  callNumbering.clear();
   nextValueNumber = 1;
 }
 
@@ -585,6 +616,7 @@ namespace {
 
   class GVN : public FunctionPass {
     bool NoLoads;
+    bool DoPRE;
     MemoryDependenceAnalysis *MD;
     DominatorTree *DT;
     const DataLayout *TD;
@@ -605,6 +637,17 @@ namespace {
 
     SmallVector<Instruction*, 8> InstrsToErase;
 
+    /// MSSA - The MemorySSA form of the function with -enable-gvn-memoryssa.
+    MemorySSA *MSSA;
+
+    /// AvailableLoads - The loads processLoadMemorySSA has kept, by the ID of
+    /// the access that clobbers them and the object they load from: a later
+    /// load with the same clobber that one of them dominates and covers has
+    /// its value.  IDs are not reused, so the loads of a removed access are
+    /// never found again, rather than found by a new access at its address.
+    typedef std::pair<unsigned, Value*> AvailableLoadKey;
+    DenseMap<AvailableLoadKey, SmallVector<LoadInst*, 2> > AvailableLoads;
+
     typedef SmallVector<NonLocalDepResult, 64> LoadDepVect;
     typedef SmallVector<AvailableValueInBlock, 64> AvailValInBlkVect;
     typedef SmallVector<BasicBlock*, 64> UnavailBlkVect;
@@ -612,7 +655,7 @@ namespace {
   public:
     static char ID; // Pass identification, replacement for typeid
     explicit GVN(bool noloads = false)
-        : FunctionPass(ID), NoLoads(noloads), MD(0) {
+        : FunctionPass(ID), NoLoads(noloads), DoPRE(true), MD(0), MSSA(0) {
       initializeGVNPass(*PassRegistry::getPassRegistry());
     }
 
@@ -628,7 +671,8 @@ namespace {
     const DataLayout *getDataLayout() const { return TD; }
     DominatorTree &getDominatorTree() const { return *DT; }
     AliasAnalysis *getAliasAnalysis() const { return VN.getAliasAnalysis(); }
-    MemoryDependenceAnalysis &getMemDep() const { return *MD; }
+    MemoryDependenceAnalysis *getMemDep() const { return MD; }
+    MemorySSA *getMemorySSA() const { return MSSA; }
   private:
     /// addToLeaderTable - Push a new Value to the LeaderTable onto the list for
     /// its value number.
@@ -680,7 +724,10 @@ namespace {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.addRequired<DominatorTree>();
       AU.addRequired<TargetLibraryInfo>();
-      if (!NoLoads)
+      if (!NoLoads && EnableMemorySSA) {
+        AU.addRequired<MemorySSAAnalysis>();
+        AU.addPreserved<MemorySSAAnalysis>();
+      } else if (!NoLoads)
         AU.addRequired<MemoryDependenceAnalysis>();
       AU.addRequired<AliasAnalysis>();
 
@@ -691,7 +738,21 @@ namespace {
 
     // Helper fuctions of redundant load elimination 
     bool processLoad(LoadInst *L);
+    bool processLoadMemorySSA(LoadInst *L);
+    bool processLoadMemDep(LoadInst *L);
+    Value *getLoadValueFromClobber(LoadInst *L, Instruction *DepInst);
+    Value *getLoadValueFromAvailableLoads(LoadInst *L,
+                                          ArrayRef<LoadInst*> Loads);
+    AvailableLoadKey getAvailableLoadKey(MemoryAccess *Clobber, LoadInst *L) {
+      return AvailableLoadKey(Clobber->getID(),
+                              GetUnderlyingObject(L->getPointerOperand(), TD));
+    }
     bool processNonLocalLoad(LoadInst *L);
+    bool findNonLocalDepsMemorySSA(LoadInst *L, MemoryAccess *Clobber,
+                                   LoadDepVect &Deps);
+    MemDepResult getDepForClobber(MemoryAccess *Clobber,
+                                  const AliasAnalysis::Location &Loc,
+                                  BasicBlock *BB);
     void AnalyzeLoadAvailability(LoadInst *LI, LoadDepVect &Deps, 
                                  AvailValInBlkVect &ValuesPerBlock,
                                  UnavailBlkVect &UnavailableBlocks);
@@ -727,6 +788,7 @@ FunctionPass *llvm::createGVNPass(bool NoLoads) {
 
 INITIALIZE_PASS_BEGIN(GVN, "gvn", "Global Value Numbering", false, false)
 INITIALIZE_PASS_DEPENDENCY(MemoryDependenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(MemorySSAAnalysis)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfo)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
@@ -1197,7 +1259,10 @@ static Value *GetLoadValueForLoad(LoadInst *SrcVal, unsigned Offset,
     // tracks.  It is potentially possible to remove the load from the table,
     // but then there all of the operations based on it would need to be
     // rehashed.  Just leave the dead load around.
-    gvn.getMemDep().removeInstruction(SrcVal);
+    if (MemoryDependenceAnalysis *MD = gvn.getMemDep())
+      MD->removeInstruction(SrcVal);
+    if (MemorySSA *MSSA = gvn.getMemorySSA())
+      MSSA->createMemoryUse(NewLoad);
     SrcVal = NewLoad;
   }
 
@@ -1675,7 +1740,10 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
     // Add the newly created load.
     ValuesPerBlock.push_back(AvailableValueInBlock::get(UnavailablePred,
                                                         NewLoad));
-    MD->invalidateCachedPointerInfo(LoadPtr);
+    if (MD)
+      MD->invalidateCachedPointerInfo(LoadPtr);
+    if (MSSA)
+      MSSA->createMemoryUse(NewLoad);
     DEBUG(dbgs() << "GVN INSERTED " << *NewLoad << '\n');
   }
 
@@ -1684,7 +1752,7 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
   LI->replaceAllUsesWith(V);
   if (isa<PHINode>(V))
     V->takeName(LI);
-  if (V->getType()->getScalarType()->isPointerTy())
+  if (MD && V->getType()->getScalarType()->isPointerTy())
     MD->invalidateCachedPointerInfo(V);
   markInstructionForDeletion(LI);
   ++NumPRELoad;
@@ -1696,8 +1764,14 @@ bool GVN::PerformLoadPRE(LoadInst *LI, AvailValInBlkVect &ValuesPerBlock,
 bool GVN::processNonLocalLoad(LoadInst *LI) {
   // Step 1: Find the non-local dependencies of the load.
   LoadDepVect Deps;
-  AliasAnalysis::Location Loc = VN.getAliasAnalysis()->getLocation(LI);
-  MD->getNonLocalPointerDependency(Loc, true, LI->getParent(), Deps);
+  if (MSSA) {
+    MemoryAccess *Clobber = MSSA->getClobberingMemoryAccess(LI);
+    if (!Clobber || !findNonLocalDepsMemorySSA(LI, Clobber, Deps))
+      return false;
+  } else {
+    AliasAnalysis::Location Loc = VN.getAliasAnalysis()->getLocation(LI);
+    MD->getNonLocalPointerDependency(Loc, true, LI->getParent(), Deps);
+  }
 
   // If we had to process more than one hundred blocks to find the
   // dependencies, this load isn't worth worrying about.  Optimizing
@@ -1742,7 +1816,7 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
 
     if (isa<PHINode>(V))
       V->takeName(LI);
-    if (V->getType()->getScalarType()->isPointerTy())
+    if (MD && V->getType()->getScalarType()->isPointerTy())
       MD->invalidateCachedPointerInfo(V);
     markInstructionForDeletion(LI);
     ++NumGVNLoad;
@@ -1750,7 +1824,7 @@ bool GVN::processNonLocalLoad(LoadInst *LI) {
   }
 
   // Step 4: Eliminate partial redundancy.
-  if (!EnablePRE || !EnableLoadPRE)
+  if (!DoPRE || !EnableLoadPRE)
     return false;
 
   return PerformLoadPRE(LI, ValuesPerBlock, UnavailableBlocks);
@@ -1789,7 +1863,14 @@ static void patchReplacementInstruction(Instruction *I, Value *Repl) {
         ReplInst->setMetadata(Kind, MDNode::getMostGenericRange(IMD, ReplMD));
         break;
       case LLVMContext::MD_prof:
-        llvm_unreachable("MD_prof in a non terminator instruction");
+        // Profile use gives calls their execution count as a single branch
+        // weight.  A call that replaces another one it dominates keeps its
+        // own count.
+        if (!isa<CallInst>(ReplInst) || ReplMD->getNumOperands() != 2 ||
+            !isa<MDString>(ReplMD->getOperand(0)) ||
+            !cast<MDString>(ReplMD->getOperand(0))->getString().equals(
+              "branch_weights"))
+          llvm_unreachable("MD_prof in a non terminator instruction");
         break;
       case LLVMContext::MD_fpmath:
         ReplInst->setMetadata(Kind, MDNode::getMostGenericFPMath(IMD, ReplMD));
@@ -1807,17 +1888,30 @@ static void patchAndReplaceAllUsesWith(Instruction *I, Value *Repl) {
 /// processLoad - Attempt to eliminate a load, first by eliminating it
 /// locally, and then attempting non-local elimination if that fails.
 bool GVN::processLoad(LoadInst *L) {
-  if (!MD)
+  if (!MD && !MSSA)
     return false;
 
-  if (!L->isSimple())
+  if (!L->isSimple()) {
+    // An unordered load cannot be removed, but later loads can use its value.
+    if (MSSA && L->isUnordered())
+      if (MemoryAccess *Clobber = MSSA->getClobberingMemoryAccess(L))
+        AvailableLoads[getAvailableLoadKey(Clobber, L)].push_back(L);
     return false;
+  }
 
   if (L->use_empty()) {
     markInstructionForDeletion(L);
     return true;
   }
 
+  if (MSSA)
+    return processLoadMemorySSA(L);
+  return processLoadMemDep(L);
+}
+
+/// processLoadMemDep - Attempt to eliminate a load from the dependency memdep
+/// finds for it.
+bool GVN::processLoadMemDep(LoadInst *L) {
   // ... to a pointer that has been loaded from before...
   MemDepResult Dep = MD->getDependency(L);
 
@@ -1994,6 +2088,380 @@ bool GVN::processLoad(LoadInst *L) {
   return false;
 }
 
+/// getLoadValueFromClobber - Return the value L loads, if it can be worked
+/// out from DepInst, the instruction that clobbers it, or null.
+Value *GVN::getLoadValueFromClobber(LoadInst *L, Instruction *DepInst) {
+  AliasAnalysis *AA = VN.getAliasAnalysis();
+  Value *LoadPtr = L->getPointerOperand();
+
+  if (StoreInst *DepSI = dyn_cast<StoreInst>(DepInst)) {
+    // A store to the same pointer gives its value, if it is at least as large
+    // as the load.
+    // As for loads, the alias query is only needed without target data.
+    Value *StoredVal = DepSI->getValueOperand();
+    if (DepSI->getPointerOperand()->stripPointerCasts() ==
+          LoadPtr->stripPointerCasts() ||
+        (!TD && AA->alias(AA->getLocation(DepSI), AA->getLocation(L)) ==
+                  AliasAnalysis::MustAlias)) {
+      if (StoredVal->getType() == L->getType())
+        return StoredVal;
+      if (TD)
+        if (Value *V = CoerceAvailableValueToLoadType(StoredVal, L->getType(),
+                                                      L, *TD))
+          return V;
+    }
+    if (!TD)
+      return 0;
+    int Offset = AnalyzeLoadFromClobberingStore(L->getType(), LoadPtr,
+                                                DepSI, *TD);
+    if (Offset == -1)
+      return 0;
+    return GetStoreValueForLoad(StoredVal, Offset, L->getType(), L, *TD);
+  }
+
+  if (MemIntrinsic *DepMI = dyn_cast<MemIntrinsic>(DepInst)) {
+    if (!TD)
+      return 0;
+    int Offset = AnalyzeLoadFromClobberingMemInst(L->getType(), LoadPtr,
+                                                  DepMI, *TD);
+    if (Offset == -1)
+      return 0;
+    return GetMemInstValueForLoad(DepMI, Offset, L->getType(), L, *TD);
+  }
+
+  // A load right after the allocation or the start of the lifetime of the
+  // object it reads is undefined.
+  if (IntrinsicInst *II = dyn_cast<IntrinsicInst>(DepInst))
+    if (II->getIntrinsicID() == Intrinsic::lifetime_start &&
+        AA->alias(II->getArgOperand(1), LoadPtr) == AliasAnalysis::MustAlias)
+      return UndefValue::get(L->getType());
+  if (isMallocLikeFn(DepInst, TLI) &&
+      GetUnderlyingObject(LoadPtr, TD) == DepInst)
+    return UndefValue::get(L->getType());
+
+  return 0;
+}
+
+/// getLoadValueFromAvailableLoads - Return the value of L taken from one of
+/// Loads, the kept loads of its object that see the same version of memory,
+/// or null.  Only the most recent few are looked at, to bound the work in
+/// blocks with many loads.
+Value *GVN::getLoadValueFromAvailableLoads(LoadInst *L,
+                                           ArrayRef<LoadInst*> Loads) {
+  AliasAnalysis *AA = VN.getAliasAnalysis();
+  for (unsigned i = Loads.size(), Tries = 0; i != 0 && Tries != 32;
+       --i, ++Tries) {
+    // The blocks are processed in dominator tree order, and the instructions
+    // of a block in order, so a kept load in the same block comes before L.
+    LoadInst *DepLI = Loads[i - 1];
+    if (DepLI->getParent() != L->getParent() &&
+        !DT->dominates(DepLI->getParent(), L->getParent()))
+      continue;
+
+    // With target data, AnalyzeLoadFromClobberingLoad below finds a load of
+    // another pointer to the same address, so the alias query is only made
+    // without it.
+    if (DepLI->getPointerOperand()->stripPointerCasts() ==
+          L->getPointerOperand()->stripPointerCasts() ||
+        (!TD && AA->alias(AA->getLocation(DepLI), AA->getLocation(L)) ==
+                  AliasAnalysis::MustAlias)) {
+      if (DepLI->getType() == L->getType())
+        return DepLI;
+      if (TD)
+        if (Value *V = CoerceAvailableValueToLoadType(DepLI, L->getType(),
+                                                      L, *TD))
+          return V;
+    }
+
+    // A load that covers this one, or can be widened to, gives the bits it
+    // reads.
+    if (!TD)
+      continue;
+    int Offset = AnalyzeLoadFromClobberingLoad(L->getType(),
+                                               L->getPointerOperand(),
+                                               DepLI, *TD);
+    if (Offset != -1)
+      return GetLoadValueForLoad(DepLI, Offset, L->getType(), L, *this);
+  }
+  return 0;
+}
+
+/// processLoadMemorySSA - processLoad with -enable-gvn-memoryssa: find the
+/// value of the load from the access that clobbers it, from a dominating load
+/// that sees the same version of memory, or, when a MemoryPhi clobbers it,
+/// from the values that reach the phi, translating the address through the
+/// phis of the blocks in between.  Memdep is not used.
+bool GVN::processLoadMemorySSA(LoadInst *L) {
+  MemoryAccess *Clobber = MSSA->getClobberingMemoryAccess(L);
+  if (!Clobber)
+    return false;
+
+  // Nothing writes the memory an invariant load reads, so any other load of
+  // it has its value.
+  bool IsInvariant = L->getMetadata(LLVMContext::MD_invariant_load) != 0;
+  if (IsInvariant)
+    Clobber = MSSA->getLiveOnEntryDef();
+
+  Value *AvailVal = 0;
+  MemoryDef *Def = dyn_cast<MemoryDef>(Clobber);
+  if (Def && !IsInvariant) {
+    if (!MSSA->isLiveOnEntryDef(Def))
+      AvailVal = getLoadValueFromClobber(L, Def->getMemoryInst());
+    else if (isa<AllocaInst>(GetUnderlyingObject(L->getPointerOperand(), TD)))
+      AvailVal = UndefValue::get(L->getType());
+  }
+
+  if (!AvailVal) {
+    SmallVectorImpl<LoadInst*> &Loads =
+      AvailableLoads[getAvailableLoadKey(Clobber, L)];
+    if (Value *V = getLoadValueFromAvailableLoads(L, Loads)) {
+      if (LoadInst *LI = dyn_cast<LoadInst>(V))
+        patchReplacementInstruction(L, LI);
+      L->replaceAllUsesWith(V);
+      markInstructionForDeletion(L);
+      ++NumGVNLoad;
+      ++NumMSSALoad;
+      return true;
+    }
+
+    // The values that reach the ends of the predecessors may give the load's
+    // value in every one of them, or in enough to insert it in the rest.
+    if (!IsInvariant && (isa<MemoryPhi>(Clobber) ||
+                         !L->getParent()->getSinglePredecessor()) &&
+        processNonLocalLoad(L))
+      return true;
+    AvailableLoads[getAvailableLoadKey(Clobber, L)].push_back(L);
+    return false;
+  }
+
+  DEBUG(dbgs() << "GVN MEMORYSSA CLOBBER: ";
+        Clobber->print(dbgs());
+        dbgs() << '\n' << *AvailVal << '\n' << *L << "\n\n\n");
+  L->replaceAllUsesWith(AvailVal);
+  markInstructionForDeletion(L);
+  ++NumGVNLoad;
+  ++NumMSSALoad;
+  return true;
+}
+
+/// getDepForClobber - Return what memdep would give as the dependency of a
+/// load of Loc at the end of BB, given Clobber, the access the walk up from
+/// the end of BB stopped at: a must-aliased load that sees the same version
+/// of Loc as BB, a must-aliased write or an allocation, or another write
+/// that clobbers Loc.  Return an unknown result if Clobber is a MemoryPhi and no such load
+/// is found; the caller walks on through the phi.
+MemDepResult GVN::getDepForClobber(MemoryAccess *Clobber,
+                                   const AliasAnalysis::Location &Loc,
+                                   BasicBlock *BB) {
+  AliasAnalysis *AA = VN.getAliasAnalysis();
+
+  // A load of the same location with the same clobber, which dominates BB,
+  // reads the value that reaches the end of BB.  Like memdep, scan back from
+  // the end of BB, here over the accesses of BB and its dominators up to
+  // Clobber, and give up after a hundred of them.
+  unsigned Scanned = 0;
+  for (DomTreeNode *N = DT->getNode(BB); N && Scanned != 100;
+       N = N->getIDom()) {
+    BasicBlock *DomBB = N->getBlock();
+    if (const MemorySSA::AccessListType *Accesses =
+          MSSA->getBlockAccesses(DomBB))
+      for (MemorySSA::AccessListType::const_reverse_iterator
+           I = Accesses->rbegin(), E = Accesses->rend(); I != E; ++I) {
+        if (*I == Clobber || ++Scanned == 100)
+          break;
+        LoadInst *DepLI = dyn_cast<LoadInst>((*I)->getMemoryInst());
+        if (DepLI && DepLI->isSimple() && isa<MemoryUse>(*I) &&
+            AA->alias(AA->getLocation(DepLI), Loc) ==
+              AliasAnalysis::MustAlias &&
+            MSSA->getClobberingMemoryAccess(DepLI) == Clobber)
+          return MemDepResult::getDef(DepLI);
+      }
+    if (DomBB == Clobber->getBlock())
+      break;
+  }
+
+  if (isa<MemoryPhi>(Clobber))
+    return MemDepResult::getUnknown();
+
+  Value *Obj = GetUnderlyingObject(const_cast<Value *>(Loc.Ptr), TD);
+  if (MSSA->isLiveOnEntryDef(Clobber)) {
+    // Loading an alloca before anything writes it gives undef.
+    if (AllocaInst *AI = dyn_cast<AllocaInst>(Obj))
+      if (AI->getParent() == &AI->getParent()->getParent()->getEntryBlock())
+        return MemDepResult::getDef(AI);
+    return MemDepResult::getNonFuncLocal();
+  }
+
+  Instruction *DepInst = cast<MemoryDef>(Clobber)->getMemoryInst();
+  if (StoreInst *SI = dyn_cast<StoreInst>(DepInst))
+    if (SI->isSimple() &&
+        AA->alias(AA->getLocation(SI), Loc) == AliasAnalysis::MustAlias)
+      return MemDepResult::getDef(SI);
+  if (isMallocLikeFn(DepInst, TLI) && Obj == DepInst)
+    return MemDepResult::getDef(DepInst);
+  if (isLifetimeStart(DepInst) &&
+      AA->alias(cast<IntrinsicInst>(DepInst)->getArgOperand(1), Loc.Ptr) ==
+        AliasAnalysis::MustAlias)
+    return MemDepResult::getDef(DepInst);
+  return MemDepResult::getClobber(DepInst);
+}
+
+/// isAddressAvailableAbove - Return true if the address V is the same value
+/// on every path into BB: it is computed above BB, or from such values with
+/// pointer arithmetic alone.
+static bool isAddressAvailableAbove(Value *V, BasicBlock *BB,
+                                    DominatorTree *DT, unsigned Depth = 0) {
+  Instruction *I = dyn_cast<Instruction>(V);
+  if (!I || DT->properlyDominates(I->getParent(), BB))
+    return true;
+  if (Depth == 4 || !(isa<GetElementPtrInst>(I) || isa<CastInst>(I)))
+    return false;
+  for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i)
+    if (!isAddressAvailableAbove(I->getOperand(i), BB, DT, Depth + 1))
+      return false;
+  return true;
+}
+
+namespace {
+/// PredWalk - The end of a predecessor, the address of a load there and the
+/// access the walk up from there for the address stopped at.  The address
+/// and the access are null if the address could not be phi translated into
+/// the predecessor.
+struct PredWalk {
+  BasicBlock *Pred;
+  PHITransAddr Address;
+  MemoryAccess *Clobber;
+};
+}
+
+/// addPredWalks - Add the walks up from the predecessors of BB for Address, a
+/// load address in BB, to Worklist.  The version of memory at the end of
+/// each predecessor is the incoming value of Phi, the phi of BB, or else
+/// EntryVersion.  Like memdep, translate an address computed in BB without
+/// requiring the result to dominate the predecessor, as it is only used for
+/// alias queries.  Return false if the address is computed below BB instead.
+static bool addPredWalks(BasicBlock *BB, MemoryPhi *Phi,
+                         MemoryAccess *EntryVersion,
+                         const PHITransAddr &Address,
+                         const AliasAnalysis::Location &Loc, MemorySSA *MSSA,
+                         DominatorTree *DT, SmallVectorImpl<PredWalk> &Worklist) {
+  bool Translate = Address.NeedsPHITranslationFromBlock(BB);
+  if (!Translate && !isAddressAvailableAbove(Address.getAddr(), BB, DT))
+    return false;
+
+  SmallVector<std::pair<BasicBlock*, MemoryAccess*>, 8> Incoming;
+  if (Phi)
+    for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i)
+      Incoming.push_back(std::make_pair(Phi->getIncomingBlock(i),
+                                        Phi->getIncomingValue(i)));
+  else
+    for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI)
+      Incoming.push_back(std::make_pair(*PI, EntryVersion));
+
+  for (unsigned i = 0, e = Incoming.size(); i != e; ++i) {
+    PredWalk W = { Incoming[i].first, Address, 0 };
+    if (!Translate || !W.Address.PHITranslateValue(BB, W.Pred, 0))
+      W.Clobber = MSSA->getClobberingMemoryAccess(Incoming[i].second,
+                                       Loc.getWithNewPtr(W.Address.getAddr()));
+    Worklist.push_back(W);
+  }
+  return true;
+}
+
+/// findNonLocalDepsMemorySSA - Find the dependencies of L, whose clobber is
+/// Clobber, in the predecessors of its block as memdep's
+/// getNonLocalPointerDependency would: walk up from the end of each
+/// predecessor, and on through the MemoryPhis the walks stop at.  Return
+/// false if the address is not available above a phi, or if Clobber is a
+/// write above L in its block.
+bool GVN::findNonLocalDepsMemorySSA(LoadInst *L, MemoryAccess *Clobber,
+                                    LoadDepVect &Deps) {
+  BasicBlock *LoadBB = L->getParent();
+  if (isa<MemoryDef>(Clobber) && Clobber->getBlock() == LoadBB &&
+      !MSSA->isLiveOnEntryDef(Clobber))
+    return false;
+
+  AliasAnalysis *AA = VN.getAliasAnalysis();
+  AliasAnalysis::Location Loc = AA->getLocation(L);
+  PHITransAddr Address(L->getPointerOperand(), TD);
+
+  SmallVector<PredWalk, 8> Worklist;
+  DenseMap<MemoryPhi*, Value*> VisitedPhis;
+  if (MemoryPhi *Phi = dyn_cast<MemoryPhi>(Clobber)) {
+    // Translate an address computed between the phi and L up to the phi's
+    // block, along the chain of single predecessors memdep would scan.
+    for (BasicBlock *BB = LoadBB; BB != Phi->getBlock();) {
+      BasicBlock *Pred = BB->getSinglePredecessor();
+      if (!Pred)
+        break;
+      if (Address.NeedsPHITranslationFromBlock(BB) &&
+          Address.PHITranslateValue(BB, Pred, 0))
+        return false;
+      BB = Pred;
+    }
+    VisitedPhis[Phi] = Address.getAddr();
+    if (!addPredWalks(Phi->getBlock(), Phi, 0, Address, Loc, MSSA, DT,
+                      Worklist))
+      return false;
+  } else {
+    // L's block has no phi, so the version of memory at its start is the one
+    // its first access is defined from.
+    MemoryAccess *EntryVersion =
+      MSSA->getBlockAccesses(LoadBB)->front()->getDefiningAccess();
+    if (!addPredWalks(LoadBB, 0, EntryVersion, Address, Loc, MSSA, DT,
+                      Worklist))
+      return false;
+  }
+
+  DenseMap<BasicBlock*, unsigned> DepOfBlock;
+  while (!Worklist.empty()) {
+    PredWalk W = Worklist.pop_back_val();
+    Value *Ptr = W.Address.getAddr();
+    MemDepResult Dep = MemDepResult::getUnknown();
+    BasicBlock *DepBB = W.Pred;
+    if (W.Clobber) {
+      Dep = getDepForClobber(W.Clobber, Loc.getWithNewPtr(Ptr), W.Pred);
+      if (Dep.isUnknown()) {
+        // Walk on through the phi.  A walk that comes back to a phi, around
+        // a loop, has nothing to add: the walks from the phi give what
+        // reaches it.  Like memdep, give up if it comes back with another
+        // address.
+        MemoryPhi *NextPhi = cast<MemoryPhi>(W.Clobber);
+        std::pair<DenseMap<MemoryPhi*, Value*>::iterator, bool> Visited =
+          VisitedPhis.insert(std::make_pair(NextPhi, Ptr));
+        if (!Visited.second) {
+          if (Visited.first->second != Ptr)
+            return false;
+          continue;
+        }
+        if (!addPredWalks(NextPhi->getBlock(), NextPhi, 0, W.Address, Loc,
+                          MSSA, DT, Worklist))
+          return false;
+        continue;
+      }
+      DepBB = Dep.getInst() ? Dep.getInst()->getParent()
+                            : W.Clobber->getBlock();
+    }
+
+    // Several walks may end in the same block.  Like memdep, give up if they
+    // disagree about what is there.
+    std::pair<DenseMap<BasicBlock*, unsigned>::iterator, bool> Inserted =
+      DepOfBlock.insert(std::make_pair(DepBB, Deps.size()));
+    if (!Inserted.second) {
+      const NonLocalDepResult &Prev = Deps[Inserted.first->second];
+      if (Prev.getResult() != Dep || Prev.getAddress() != Ptr)
+        return false;
+      continue;
+    }
+    Deps.push_back(NonLocalDepResult(DepBB, Dep, Ptr));
+
+    // Like memdep, stop once there are too many for the load to be worth it.
+    if (Deps.size() > 100)
+      return true;
+  }
+  return true;
+}
+
 // findLeader - In order to find a leader for a given value number at a
 // specific basic block, we first obtain the list of all Values for that number,
 // and then scan the list to find one whose block dominates the block in
@@ -2314,18 +2782,29 @@ bool GVN::processInstruction(Instruction *I) {
 
 /// runOnFunction - This is the main transformation entry point for a function.
 bool GVN::runOnFunction(Function& F) {
-  if (!NoLoads)
+  if (!NoLoads && EnableMemorySSA)
+    MSSA = &getAnalysis<MemorySSAAnalysis>().getMSSA();
+  else if (!NoLoads)
     MD = &getAnalysis<MemoryDependenceAnalysis>();
   DT = &getAnalysis<DominatorTree>();
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
   VN.setAliasAnalysis(&getAnalysis<AliasAnalysis>());
   VN.setMemDep(MD);
+  VN.setMemorySSA(MSSA);
   VN.setDomTree(DT);
 
   bool Changed = false;
   bool ShouldContinue = true;
 
+  // PRE splits edges and inserts code to save a little; it is the first thing
+  // to go on functions that already took too long to compile.
+  DoPRE = EnablePRE;
+  if (DoPRE && isFunctionOverCompileBudget(*this, F)) {
+    DoPRE = false;
+    ++NumPRESkipped;
+  }
+
   // Merge unconditional branches, allowing PRE to catch more
   // optimization opportunities.
   for (Function::iterator FI = F.begin(), FE = F.end(); FI != FE; ) {
@@ -2345,7 +2824,7 @@ bool GVN::runOnFunction(Function& F) {
     ++Iteration;
   }
 
-  if (EnablePRE) {
+  if (DoPRE) {
     // Fabricate val-num for dead-code in order to suppress assertion in
     // performPRE().
     assignValNumForDeadCode();
@@ -2365,6 +2844,8 @@ bool GVN::runOnFunction(Function& F) {
   // Do not cleanup DeadBlocks in cleanupGlobalSets() as it's called for each
   // iteration. 
   DeadBlocks.clear();
+  MD = 0;
+  MSSA = 0;
 
   return Changed;
 }
@@ -2400,6 +2881,9 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      if (MSSA)
+        if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(*I))
+          MSSA->removeMemoryAccess(MA);
       DEBUG(verifyRemoved(*I));
       (*I)->eraseFromParent();
     }
@@ -2583,6 +3067,9 @@ bool GVN::performPRE(Function &F) {
 
       DEBUG(dbgs() << "GVN PRE removed: " << *CurInst << '\n');
       if (MD) MD->removeInstruction(CurInst);
+      if (MSSA)
+        if (MemoryUseOrDef *MA = MSSA->getMemoryAccess(CurInst))
+          MSSA->removeMemoryAccess(MA);
       DEBUG(verifyRemoved(CurInst));
       CurInst->eraseFromParent();
       Changed = true;
@@ -2601,6 +3088,8 @@ BasicBlock *GVN::splitCriticalEdges(BasicBlock *Pred, BasicBlock *Succ) {
   BasicBlock *BB = SplitCriticalEdge(Pred, Succ, this);
   if (MD)
     MD->invalidateCachedPredecessors();
+  if (MSSA && BB)
+    MSSA->replacePhiIncomingBlock(Succ, Pred, BB);
   return BB;
 }
 
@@ -2611,7 +3100,11 @@ bool GVN::splitCriticalEdges() {
     return false;
   do {
     std::pair<TerminatorInst*, unsigned> Edge = toSplit.pop_back_val();
-    SplitCriticalEdge(Edge.first, Edge.second, this);
+    BasicBlock *Pred = Edge.first->getParent();
+    BasicBlock *Succ = Edge.first->getSuccessor(Edge.second);
+    BasicBlock *BB = SplitCriticalEdge(Edge.first, Edge.second, this);
+    if (MSSA)
+      MSSA->replacePhiIncomingBlock(Succ, Pred, BB);
   } while (!toSplit.empty());
   if (MD) MD->invalidateCachedPredecessors();
   return true;
@@ -2651,6 +3144,7 @@ void GVN::cleanupGlobalSets() {
   VN.clear();
   LeaderTable.clear();
   TableAllocator.Reset();
+  AvailableLoads.clear();
 }
 
 /// verifyRemoved - Verify that the specified instruction does not occur in our
@@ -21,6 +21,7 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/CFG.h"
 #include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Analysis/Loads.h"
@@ -79,6 +80,7 @@ namespace {
     DataLayout *TD;
     TargetLibraryInfo *TLI;
     LazyValueInfo *LVI;
+    DominatorTree *DT;
 #ifdef NDEBUG
     SmallPtrSet<BasicBlock*, 16> LoopHeaders;
 #else
@@ -111,6 +113,7 @@ namespace {
       AU.addRequired<LazyValueInfo>();
       AU.addPreserved<LazyValueInfo>();
       AU.addRequired<TargetLibraryInfo>();
+      AU.addPreserved<DominatorTree>();
     }
 
     void FindLoopHeaders(Function &F);
@@ -131,6 +134,9 @@ namespace {
 
     bool SimplifyPartiallyRedundantLoad(LoadInst *LI);
     bool TryToUnfoldSelect(CmpInst *CondCmp, BasicBlock *BB);
+
+    void UpdateDomTreeForLostSuccessors(BasicBlock *BB,
+                                        ArrayRef<BasicBlock*> OldSuccs);
   };
 }
 
@@ -152,6 +158,7 @@ bool JumpThreading::runOnFunction(Function &F) {
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
   LVI = &getAnalysis<LazyValueInfo>();
+  DT = getAnalysisIfAvailable<DominatorTree>();
 
   FindLoopHeaders(F);
 
@@ -199,7 +206,16 @@ bool JumpThreading::runOnFunction(Function &F) {
         // awesome, but it allows us to use AssertingVH to prevent nasty
         // dangling pointer issues within LazyValueInfo.
         LVI->eraseBlock(BB);
+        DomTreeNode *BBNode = DT ? DT->getNode(BB) : 0;
         if (TryToSimplifyUncondBranchFromEmptyBlock(BB)) {
+          // BB's predecessors now branch to Succ, which BB dominated if it
+          // dominated anything.
+          if (BBNode) {
+            DomTreeNode *IDom = BBNode->getIDom();
+            if (IDom && !BBNode->getChildren().empty())
+              DT->changeImmediateDominator(Succ, IDom->getBlock());
+            DT->eraseNode(BB);
+          }
           Changed = true;
           // If we deleted BB and BB was the header of a loop, then the
           // successor is now the header of the loop.
@@ -635,6 +651,21 @@ static bool hasAddressTakenAndUsed(BasicBlock *BB) {
   return !BA->use_empty();
 }
 
+/// UpdateDomTreeForLostSuccessors - BB used to branch to each of OldSuccs.
+/// Tell the dominator tree, if there is one, about the edges that are gone.
+void JumpThreading::UpdateDomTreeForLostSuccessors(
+    BasicBlock *BB, ArrayRef<BasicBlock*> OldSuccs) {
+  if (!DT) return;
+
+  SmallPtrSet<BasicBlock*, 8> Remaining(succ_begin(BB), succ_end(BB));
+  SmallVector<DominatorTree::UpdateType, 4> Updates;
+  for (unsigned i = 0, e = OldSuccs.size(); i != e; ++i)
+    if (Remaining.insert(OldSuccs[i]))
+      Updates.push_back(DominatorTree::UpdateType(
+          DominatorTree::UpdateType::Delete, BB, OldSuccs[i]));
+  DT->applyUpdates(Updates);
+}
+
 /// ProcessBlock - If there are any predecessors whose control can be threaded
 /// through to a successor, transform them now.
 bool JumpThreading::ProcessBlock(BasicBlock *BB) {
@@ -659,7 +690,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
       // will need to move BB back to the entry position.
       bool isEntry = SinglePred == &SinglePred->getParent()->getEntryBlock();
       LVI->eraseBlock(SinglePred);
-      MergeBasicBlockIntoOnlyPred(BB);
+      MergeBasicBlockIntoOnlyPred(BB, this);
 
       if (isEntry && BB != &BB->getParent()->getEntryBlock())
         BB->moveBefore(&BB->getParent()->getEntryBlock());
@@ -707,6 +738,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
 
     // Fold the branch/switch.
     TerminatorInst *BBTerm = BB->getTerminator();
+    SmallVector<BasicBlock*, 4> OldSuccs(succ_begin(BB), succ_end(BB));
     for (unsigned i = 0, e = BBTerm->getNumSuccessors(); i != e; ++i) {
       if (i == BestSucc) continue;
       BBTerm->getSuccessor(i)->removePredecessor(BB, true);
@@ -716,6 +748,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
           << "' folding undef terminator: " << *BBTerm << '\n');
     BranchInst::Create(BBTerm->getSuccessor(BestSucc), BBTerm);
     BBTerm->eraseFromParent();
+    UpdateDomTreeForLostSuccessors(BB, OldSuccs);
     return true;
   }
 
@@ -726,7 +759,9 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
     DEBUG(dbgs() << "  In block '" << BB->getName()
           << "' folding terminator: " << *BB->getTerminator() << '\n');
     ++NumFolds;
+    SmallVector<BasicBlock*, 4> OldSuccs(succ_begin(BB), succ_end(BB));
     ConstantFoldTerminator(BB, true);
+    UpdateDomTreeForLostSuccessors(BB, OldSuccs);
     return true;
   }
 
@@ -771,9 +806,11 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
         if (PI == PE) {
           unsigned ToRemove = Baseline == LazyValueInfo::True ? 1 : 0;
           unsigned ToKeep = Baseline == LazyValueInfo::True ? 0 : 1;
-          CondBr->getSuccessor(ToRemove)->removePredecessor(BB, true);
+          BasicBlock *Removed = CondBr->getSuccessor(ToRemove);
+          Removed->removePredecessor(BB, true);
           BranchInst::Create(CondBr->getSuccessor(ToKeep), CondBr);
           CondBr->eraseFromParent();
+          UpdateDomTreeForLostSuccessors(BB, Removed);
           return true;
         }
       }
@@ -1472,6 +1509,17 @@ bool JumpThreading::ThreadEdge(BasicBlock *BB,
       PredTerm->setSuccessor(i, NewBB);
     }
 
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 3> Updates;
+    Updates.push_back(DominatorTree::UpdateType(
+        DominatorTree::UpdateType::Insert, PredBB, NewBB));
+    Updates.push_back(DominatorTree::UpdateType(
+        DominatorTree::UpdateType::Insert, NewBB, SuccBB));
+    Updates.push_back(DominatorTree::UpdateType(
+        DominatorTree::UpdateType::Delete, PredBB, BB));
+    DT->applyUpdates(Updates);
+  }
+
   // At this point, the IR is fully up to date and consistent.  Do a quick scan
   // over the new instructions and zap any that are constants or dead.  This
   // frequently happens because of phi translation.
@@ -1622,6 +1670,26 @@ bool JumpThreading::DuplicateCondBranchOnPHIIntoPred(BasicBlock *BB,
   // Remove the unconditional branch at the end of the PredBB block.
   OldPredBranch->eraseFromParent();
 
+  // PredBB now branches to BB's successors instead of BB, unless BB is one of
+  // them.
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 4> Updates;
+    SmallPtrSet<BasicBlock*, 4> Seen;
+    bool StillBranchesToBB = false;
+    for (succ_iterator SI = succ_begin(PredBB), SE = succ_end(PredBB);
+         SI != SE; ++SI) {
+      if (*SI == BB)
+        StillBranchesToBB = true;
+      else if (Seen.insert(*SI))
+        Updates.push_back(DominatorTree::UpdateType(
+            DominatorTree::UpdateType::Insert, PredBB, *SI));
+    }
+    if (!StillBranchesToBB)
+      Updates.push_back(DominatorTree::UpdateType(
+          DominatorTree::UpdateType::Delete, PredBB, BB));
+    DT->applyUpdates(Updates);
+  }
+
   ++NumDupes;
   return true;
 }
@@ -1698,6 +1766,10 @@ bool JumpThreading::TryToUnfoldSelect(CmpInst *CondCmp, BasicBlock *BB) {
            PHINode *Phi = dyn_cast<PHINode>(BI); ++BI)
         if (Phi != CondLHS)
           Phi->addIncoming(Phi->getIncomingValueForBlock(Pred), NewBB);
+
+      // Pred still branches to BB, so only NewBB is new to the tree.
+      if (DT && DT->getNode(Pred))
+        DT->addNewBlock(NewBB, Pred);
       return true;
     }
   }
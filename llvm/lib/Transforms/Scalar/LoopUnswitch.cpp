@@ -59,6 +59,7 @@ STATISTIC(NumSelects , "Number of selects unswitched");
 STATISTIC(NumTrivial , "Number of unswitches that are trivial");
 STATISTIC(NumSimplify, "Number of simplifications of unswitched code");
 STATISTIC(TotalInsts,  "Total number of instructions analyzed");
+STATISTIC(NumOverBudget, "Number of loops not unswitched to save compile time");
 
 // The specific value of 100 here was chosen based only on intuition and a
 // few specific examples.
@@ -209,7 +210,7 @@ namespace {
     void EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                         BasicBlock *TrueDest,
                                         BasicBlock *FalseDest,
-                                        Instruction *InsertPt);
+                                        BranchInst *OldBranch);
 
     void SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L);
     void RemoveBlockIfDead(BasicBlock *BB,
@@ -389,6 +390,14 @@ bool LoopUnswitch::runOnLoop(Loop *L, LPPassManager &LPM_Ref) {
   DT = getAnalysisIfAvailable<DominatorTree>();
   currentLoop = L;
   Function *F = currentLoop->getHeader()->getParent();
+
+  // Unswitching duplicates the loop, and with it the work of every later
+  // pass; skip it on functions that already took too long to compile.
+  if (isFunctionOverCompileBudget(*this, *F)) {
+    ++NumOverBudget;
+    return false;
+  }
+
   bool Changed = false;
   do {
     assert(currentLoop->isLCSSAForm(*DT));
@@ -396,11 +405,6 @@ bool LoopUnswitch::runOnLoop(Loop *L, LPPassManager &LPM_Ref) {
     Changed |= processCurrentLoop();
   } while(redoLoop);
 
-  if (Changed) {
-    // FIXME: Reconstruct dom info, because it is not preserved properly.
-    if (DT)
-      DT->runOnFunction(*F);
-  }
   return Changed;
 }
 
@@ -679,24 +683,64 @@ static Loop *CloneLoop(Loop *L, Loop *PL, ValueToValueMapTy &VM,
 }
 
 /// EmitPreheaderBranchOnCondition - Emit a conditional branch on two values
-/// if LIC == Val, branch to TrueDst, otherwise branch to FalseDest.  Insert the
-/// code immediately before InsertPt.
+/// if LIC == Val, branch to TrueDst, otherwise branch to FalseDest.  The new
+/// branch replaces OldBranch, an unconditional branch to one of them.
 void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                                   BasicBlock *TrueDest,
                                                   BasicBlock *FalseDest,
-                                                  Instruction *InsertPt) {
+                                                  BranchInst *OldBranch) {
+  assert(OldBranch->isUnconditional() && "Preheader is not split correctly");
+  BasicBlock *OldBranchParent = OldBranch->getParent();
+  BasicBlock *OldBranchSucc = OldBranch->getSuccessor(0);
+
+  // Keep a block that only branches to the old destination, so that the
+  // enclosing loop structure stays in LoopSimplify form.
+  if ((TrueDest == OldBranchSucc) != (FalseDest == OldBranchSucc)) {
+    BasicBlock *EdgeBB = OldBranchParent->splitBasicBlock(
+        OldBranch, OldBranchParent->getName() + "." +
+                   OldBranchSucc->getName() + "_crit_edge");
+    if (Loop *ParentLoop = LI->getLoopFor(OldBranchParent))
+      ParentLoop->addBasicBlockToLoop(EdgeBB, LI->getBase());
+    if (DT)
+      DT->splitBlock(EdgeBB);
+    if (TrueDest == OldBranchSucc)
+      TrueDest = EdgeBB;
+    else
+      FalseDest = EdgeBB;
+    OldBranch = cast<BranchInst>(OldBranchParent->getTerminator());
+    OldBranchSucc = EdgeBB;
+  }
+
   // Insert a conditional branch on LIC to the two preheaders.  The original
   // code is the true version and the new code is the false version.
   Value *BranchVal = LIC;
   if (!isa<ConstantInt>(Val) ||
       Val->getType() != Type::getInt1Ty(LIC->getContext()))
-    BranchVal = new ICmpInst(InsertPt, ICmpInst::ICMP_EQ, LIC, Val);
+    BranchVal = new ICmpInst(OldBranch, ICmpInst::ICMP_EQ, LIC, Val);
   else if (Val != ConstantInt::getTrue(Val->getContext()))
     // We want to enter the new loop when the condition is true.
     std::swap(TrueDest, FalseDest);
 
-  // Insert the new branch.
-  BranchInst *BI = BranchInst::Create(TrueDest, FalseDest, BranchVal, InsertPt);
+  // Replace the old branch with the new one.
+  BranchInst *BI = BranchInst::Create(TrueDest, FalseDest, BranchVal,
+                                      OldBranch);
+  OldBranch->eraseFromParent();
+
+  // Tell the dominator tree about the new edge before splitting it.  If the
+  // new destination is a copy of the loop, this adds the copy to the tree.
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 3> Updates;
+    if (TrueDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(
+          DominatorTree::UpdateType::Insert, OldBranchParent, TrueDest));
+    if (FalseDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(
+          DominatorTree::UpdateType::Insert, OldBranchParent, FalseDest));
+    if (TrueDest != OldBranchSucc && FalseDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(
+          DominatorTree::UpdateType::Delete, OldBranchParent, OldBranchSucc));
+    DT->applyUpdates(Updates);
+  }
 
   // If either edge is critical, split it. This helps preserve LoopSimplify
   // form for enclosing loops.
@@ -735,10 +779,9 @@ void LoopUnswitch::UnswitchTrivialCondition(Loop *L, Value *Cond,
 
   // Okay, now we have a position to branch from and a position to branch to,
   // insert the new conditional branch.
-  EmitPreheaderBranchOnCondition(Cond, Val, NewExit, NewPH,
-                                 loopPreheader->getTerminator());
-  LPM->deleteSimpleAnalysisValue(loopPreheader->getTerminator(), L);
-  loopPreheader->getTerminator()->eraseFromParent();
+  BranchInst *OldBranch = cast<BranchInst>(loopPreheader->getTerminator());
+  LPM->deleteSimpleAnalysisValue(OldBranch, L);
+  EmitPreheaderBranchOnCondition(Cond, Val, NewExit, NewPH, OldBranch);
 
   // We need to reprocess this loop, it could be unswitched again.
   redoLoop = true;
@@ -889,9 +932,8 @@ void LoopUnswitch::UnswitchNontrivialCondition(Value *LIC, Constant *Val,
          "Preheader splitting did not work correctly!");
 
   // Emit the new branch that selects between the two versions of this loop.
-  EmitPreheaderBranchOnCondition(LIC, Val, NewBlocks[0], LoopBlocks[0], OldBR);
   LPM->deleteSimpleAnalysisValue(OldBR, L);
-  OldBR->eraseFromParent();
+  EmitPreheaderBranchOnCondition(LIC, Val, NewBlocks[0], LoopBlocks[0], OldBR);
 
   LoopProcessWorklist.push_back(NewLoop);
   redoLoop = true;
@@ -1176,10 +1218,8 @@ void LoopUnswitch::RewriteLoopBodyWithConditionConstant(Loop *L, Value *LIC,
          PHINode *PN = dyn_cast<PHINode>(II); ++II)
       PN->setIncomingValue(PN->getBasicBlockIndex(Switch),
                            UndefValue::get(PN->getType()));
-    // Tell the domtree about the new block. We don't fully update the
-    // domtree here -- instead we force it to do a full recomputation
-    // after the pass is complete -- but we do need to inform it of
-    // new blocks.
+    // Abort is only reached from NewSISucc, and the edges of the other
+    // blocks are unchanged.
     if (DT)
       DT->addNewBlock(Abort, NewSISucc);
   }
@@ -1218,8 +1258,8 @@ void LoopUnswitch::SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L) {
 
     // See if instruction simplification can hack this up.  This is common for
     // things like "select false, X, Y" after unswitching made the condition be
-    // 'false'.  TODO: update the domtree properly so we can pass it here.
-    if (Value *V = SimplifyInstruction(I))
+    // 'false'.
+    if (Value *V = SimplifyInstruction(I, 0, 0, DT))
       if (LI->replacementPreservesLCSSAForm(I, V)) {
         ReplaceUsesOfWith(I, V, Worklist, L, LPM);
         continue;
@@ -1254,6 +1294,18 @@ void LoopUnswitch::SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L) {
         BI->eraseFromParent();
         RemoveFromWorklist(BI, Worklist);
 
+        // Succ's dominator tree children now hang off Pred, which was its
+        // immediate dominator.
+        if (DT) {
+          DomTreeNode *SuccNode = DT->getNode(Succ);
+          DomTreeNode *PredNode = DT->getNode(Pred);
+          while (SuccNode && !SuccNode->getChildren().empty())
+            DT->changeImmediateDominator(SuccNode->getChildren().back(),
+                                         PredNode);
+          if (SuccNode)
+            DT->eraseNode(Succ);
+        }
+
         // Remove Succ from the loop tree.
         LI->removeBlock(Succ);
         LPM->deleteSimpleAnalysisValue(Succ, L);
@@ -0,0 +1,586 @@
+//===- SampleProfile.cpp - Incorporate sample profiles into the IR --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SampleProfileLoader transformation.  It reads a
+// profile collected by a sampling profiler such as perf, converted into
+// per-function line samples, and turns it into the branch weights that
+// BranchProbabilityInfo and MachineBlockPlacement consume.
+//
+// Samples are keyed by the line of an instruction relative to the first line
+// of its function, so the profile survives edits elsewhere in the file.  The
+// text form of a profile is:
+//
+//   function:total_samples:head_samples
+//   offset: samples [callee:samples ...]
+//   ...
+//
+// where the body lines of a function follow its header, blank lines and lines
+// starting with '#' are ignored, and the optional call targets are accepted
+// but not used.  The binary form holds the same records as ULEB128 numbers
+// after an 8 byte magic (see parseBinary).
+//
+// A block weighs as much as its most sampled instruction.  Blocks that
+// dominate and post-dominate each other in the same loop execute equally
+// often and share the largest weight among them.  Edge weights are then
+// inferred from the block weights: when all but one edge entering or leaving
+// a block are known, the last one carries the difference.
+//
+// Every sampled call also gets its block weight as a call count, and the
+// heaviest line of the profile is recorded as the ProfileMaxCount module
+// flag, which is what the inliner's profile thresholds read.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "sample-profile"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/PostDominators.h"
+#include "llvm/DebugInfo.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cctype>
+using namespace llvm;
+
+STATISTIC(NumAnnotatedFunctions, "Number of functions given sample weights");
+STATISTIC(NumAnnotatedBranches,  "Number of branches given sample weights");
+STATISTIC(NumNoDebugInfo, "Number of profiled functions without line info");
+
+static cl::opt<std::string>
+SampleProfileFile("sample-profile-file", cl::init(""),
+                  cl::value_desc("filename"), cl::Hidden,
+                  cl::desc("Profile file loaded by -sample-profile"));
+
+static cl::opt<unsigned>
+SampleProfileMaxPropagateIterations("sample-profile-max-propagate-iterations",
+  cl::init(100), cl::Hidden,
+  cl::desc("Maximum number of passes over a function's edges when inferring "
+           "their weights from sampled blocks"));
+
+namespace {
+/// FunctionSamples - The samples collected in one function.
+struct FunctionSamples {
+  /// TotalSamples - The samples collected anywhere in the function.
+  uint64_t TotalSamples;
+
+  /// TotalHeadSamples - The samples collected at its entry.
+  uint64_t TotalHeadSamples;
+
+  /// BodySamples - The samples per line, keyed by the offset of the line
+  /// from the first line of the function.
+  DenseMap<unsigned, uint64_t> BodySamples;
+
+  FunctionSamples() : TotalSamples(0), TotalHeadSamples(0) {}
+};
+
+/// SampleModuleProfile - The samples of every function in a profile.
+class SampleModuleProfile {
+  StringMap<FunctionSamples> Profiles;
+  uint64_t MaxLineSamples;
+
+  bool parseText(StringRef Data, StringRef Filename, std::string &Error);
+  bool parseBinary(StringRef Data, std::string &Error);
+  void addLineSamples(FunctionSamples &FS, unsigned Offset, uint64_t Samples) {
+    uint64_t &S = FS.BodySamples[Offset];
+    S += Samples;
+    MaxLineSamples = std::max(MaxLineSamples, S);
+  }
+
+public:
+  SampleModuleProfile() : MaxLineSamples(0) {}
+
+  /// load - Read the text or binary profile in Filename.  Return false and
+  /// set Error if it cannot be read or is malformed.
+  bool load(StringRef Filename, std::string &Error);
+
+  /// getFunction - Return the samples of the function with the given name,
+  /// or null if the profile has none.
+  const FunctionSamples *getFunction(StringRef Name) const {
+    StringMap<FunctionSamples>::const_iterator I = Profiles.find(Name);
+    return I == Profiles.end() ? 0 : &I->getValue();
+  }
+
+  /// getMaxLineSamples - Return the largest sample count of any line.
+  uint64_t getMaxLineSamples() const { return MaxLineSamples; }
+
+  void dump(raw_ostream &OS) const;
+};
+}
+
+/// BinaryMagic - The first eight bytes of a binary sample profile.
+static const char BinaryMagic[8] = { '\xff', 's', 'p', 'r', 'o', 'f', '0',
+                                     '1' };
+
+bool SampleModuleProfile::load(StringRef Filename, std::string &Error) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(Filename, Buffer)) {
+    Error = Filename.str() + ": " + EC.message();
+    return false;
+  }
+
+  StringRef Data = Buffer->getBuffer();
+  if (Data.startswith(StringRef(BinaryMagic, sizeof(BinaryMagic)))) {
+    if (parseBinary(Data.substr(sizeof(BinaryMagic)), Error))
+      return true;
+    Error = Filename.str() + ": " + Error;
+    return false;
+  }
+  return parseText(Data, Filename, Error);
+}
+
+bool SampleModuleProfile::parseText(StringRef Data, StringRef Filename,
+                                    std::string &Error) {
+  FunctionSamples *Current = 0;
+  unsigned LineNo = 0;
+  while (!Data.empty()) {
+    StringRef Line;
+    tie(Line, Data) = Data.split('\n');
+    ++LineNo;
+    Line = Line.trim();
+    if (Line.empty() || Line[0] == '#')
+      continue;
+
+    // A line that starts with a digit holds the samples of a line of the
+    // current function; anything else starts a new function.
+    if (!isdigit(static_cast<unsigned char>(Line[0]))) {
+      // function:total_samples:head_samples
+      StringRef Rest, Total, Head;
+      tie(Rest, Head) = Line.rsplit(':');
+      tie(Rest, Total) = Rest.rsplit(':');
+      FunctionSamples FS;
+      if (Rest.empty() || Total.getAsInteger(10, FS.TotalSamples) ||
+          Head.getAsInteger(10, FS.TotalHeadSamples)) {
+        Error = (Filename + ":" + Twine(LineNo) +
+                 ": expected 'function:total_samples:head_samples'").str();
+        return false;
+      }
+      // A function may be listed more than once, by profiles of several
+      // binaries concatenated together.
+      Current = &Profiles[Rest];
+      Current->TotalSamples += FS.TotalSamples;
+      Current->TotalHeadSamples += FS.TotalHeadSamples;
+      continue;
+    }
+
+    // offset: samples [callee:samples ...]
+    StringRef OffsetStr, Rest, SamplesStr;
+    tie(OffsetStr, Rest) = Line.split(':');
+    tie(SamplesStr, Rest) = Rest.ltrim().split(' ');
+    unsigned Offset;
+    uint64_t Samples;
+    if (OffsetStr.getAsInteger(10, Offset) ||
+        SamplesStr.getAsInteger(10, Samples)) {
+      Error = (Filename + ":" + Twine(LineNo) +
+               ": expected 'offset: samples'").str();
+      return false;
+    }
+    if (!Current) {
+      Error = (Filename + ":" + Twine(LineNo) +
+               ": line samples before the first function").str();
+      return false;
+    }
+    addLineSamples(*Current, Offset, Samples);
+  }
+  return true;
+}
+
+/// readULEB128 - Read a number at Pos in Data and move Pos past it.  Return
+/// false if Data ends first or the number does not fit in 64 bits.
+static bool readULEB128(StringRef Data, size_t &Pos, uint64_t &Value) {
+  Value = 0;
+  for (unsigned Shift = 0; Pos != Data.size(); Shift += 7) {
+    uint64_t Byte = static_cast<unsigned char>(Data[Pos++]);
+    if (Shift >= 64 || (Shift == 63 && (Byte & 0x7e)))
+      return false;
+    Value |= (Byte & 0x7f) << Shift;
+    if (Byte < 128)
+      return true;
+  }
+  return false;
+}
+
+/// parseBinary - Parse the records following the magic of a binary profile:
+///
+///   num_functions
+///   { name_size name total_samples head_samples num_lines
+///     { offset samples } * num_lines } * num_functions
+///
+/// with every number but the name bytes ULEB128 encoded.
+bool SampleModuleProfile::parseBinary(StringRef Data, std::string &Error) {
+  size_t Pos = 0;
+  uint64_t NumFunctions;
+  if (!readULEB128(Data, Pos, NumFunctions)) {
+    Error = "truncated profile header";
+    return false;
+  }
+
+  for (uint64_t i = 0; i != NumFunctions; ++i) {
+    uint64_t NameSize, Total, Head, NumLines;
+    if (!readULEB128(Data, Pos, NameSize) || NameSize > Data.size() - Pos) {
+      Error = "truncated profile record " + Twine(i).str();
+      return false;
+    }
+    StringRef Name = Data.substr(Pos, NameSize);
+    Pos += NameSize;
+    if (!readULEB128(Data, Pos, Total) || !readULEB128(Data, Pos, Head) ||
+        !readULEB128(Data, Pos, NumLines)) {
+      Error = "truncated profile record " + Twine(i).str();
+      return false;
+    }
+
+    FunctionSamples &FS = Profiles[Name];
+    FS.TotalSamples += Total;
+    FS.TotalHeadSamples += Head;
+    for (uint64_t l = 0; l != NumLines; ++l) {
+      uint64_t Offset, Samples;
+      if (!readULEB128(Data, Pos, Offset) ||
+          !readULEB128(Data, Pos, Samples) || Offset > ~0U) {
+        Error = "truncated line samples for '" + Name.str() + "'";
+        return false;
+      }
+      addLineSamples(FS, Offset, Samples);
+    }
+  }
+
+  if (Pos != Data.size()) {
+    Error = "trailing data after the last profile record";
+    return false;
+  }
+  return true;
+}
+
+void SampleModuleProfile::dump(raw_ostream &OS) const {
+  for (StringMap<FunctionSamples>::const_iterator I = Profiles.begin(),
+       E = Profiles.end(); I != E; ++I) {
+    const FunctionSamples &FS = I->getValue();
+    OS << "Function " << I->getKey() << ": " << FS.TotalSamples
+       << " samples, " << FS.TotalHeadSamples << " at entry, "
+       << FS.BodySamples.size() << " sampled lines\n";
+  }
+}
+
+namespace {
+/// SampleProfileLoader - Annotate the functions of a module with the branch
+/// weights implied by a sample profile.
+class SampleProfileLoader : public FunctionPass {
+  typedef std::pair<BasicBlock*, BasicBlock*> Edge;
+
+  std::string Filename;
+  OwningPtr<SampleModuleProfile> Profile;
+
+  DominatorTree *DT;
+  PostDominatorTree *PDT;
+  LoopInfo *LI;
+
+  /// BlockWeights - The weight of each block, valid for the leader of its
+  /// equivalence class.
+  DenseMap<BasicBlock*, uint64_t> BlockWeights;
+
+  /// EquivalenceClass - The leader of the class of blocks executed as often
+  /// as each block.
+  DenseMap<BasicBlock*, BasicBlock*> EquivalenceClass;
+
+  /// EdgeWeights - The weights of the edges inferred so far.
+  DenseMap<Edge, uint64_t> EdgeWeights;
+
+  unsigned getFunctionLoc(Function &F);
+  void computeBlockWeights(Function &F, const FunctionSamples &FS,
+                           unsigned HeaderLine);
+  void findEquivalenceClasses(Function &F);
+  bool propagateThroughEdges(Function &F);
+  void annotateFunction(Function &F);
+
+public:
+  static char ID; // Pass identification, replacement for typeid
+  SampleProfileLoader(StringRef Name = StringRef())
+    : FunctionPass(ID), Filename(Name.empty() ? StringRef(SampleProfileFile) : Name),
+      DT(0), PDT(0), LI(0) {
+    initializeSampleProfileLoaderPass(*PassRegistry::getPassRegistry());
+  }
+
+  virtual bool doInitialization(Module &M);
+  virtual bool runOnFunction(Function &F);
+
+  virtual const char *getPassName() const {
+    return "Sample profile pass";
+  }
+
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+    AU.setPreservesCFG();
+    AU.addRequired<DominatorTree>();
+    AU.addRequired<PostDominatorTree>();
+    AU.addRequired<LoopInfo>();
+  }
+};
+}
+
+char SampleProfileLoader::ID = 0;
+INITIALIZE_PASS_BEGIN(SampleProfileLoader, "sample-profile",
+                      "Sample Profile loader", false, false)
+INITIALIZE_PASS_DEPENDENCY(DominatorTree)
+INITIALIZE_PASS_DEPENDENCY(PostDominatorTree)
+INITIALIZE_PASS_DEPENDENCY(LoopInfo)
+INITIALIZE_PASS_END(SampleProfileLoader, "sample-profile",
+                    "Sample Profile loader", false, false)
+
+FunctionPass *llvm::createSampleProfileLoaderPass(StringRef Name) {
+  return new SampleProfileLoader(Name);
+}
+
+bool SampleProfileLoader::doInitialization(Module &M) {
+  Profile.reset(new SampleModuleProfile());
+  std::string Error;
+  if (!Profile->load(Filename, Error)) {
+    M.getContext().emitError("could not read sample profile " + Error);
+    Profile.reset();
+    return false;
+  }
+  DEBUG(Profile->dump(dbgs()));
+
+  // The inliner compares call counts against the hottest count to decide
+  // which call sites are hot.
+  if (M.getModuleFlag("ProfileMaxCount"))
+    return false;
+  M.addModuleFlag(Module::Max, "ProfileMaxCount",
+                  ConstantInt::get(Type::getInt64Ty(M.getContext()),
+                                   Profile->getMaxLineSamples()));
+  return true;
+}
+
+/// getFunctionLoc - Return the line the debug info of F starts at, or 0 if F
+/// has no line information.
+unsigned SampleProfileLoader::getFunctionLoc(Function &F) {
+  LLVMContext &Ctx = F.getContext();
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      DebugLoc DL = I->getDebugLoc();
+      if (DL.isUnknown())
+        continue;
+      DISubprogram S = getDISubprogram(DL.getScope(Ctx));
+      if (S.describes(&F))
+        return S.getLineNumber();
+    }
+  return 0;
+}
+
+/// computeBlockWeights - Weigh each block by its most sampled instruction.
+/// An instruction inlined from elsewhere carries the line of its original
+/// function, which does not belong to this one's profile, and is skipped.
+void SampleProfileLoader::computeBlockWeights(Function &F,
+                                              const FunctionSamples &FS,
+                                              unsigned HeaderLine) {
+  LLVMContext &Ctx = F.getContext();
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    uint64_t Weight = 0;
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      DebugLoc DL = I->getDebugLoc();
+      if (DL.isUnknown() || DL.getLine() < HeaderLine ||
+          DL.getInlinedAt(Ctx))
+        continue;
+      DenseMap<unsigned, uint64_t>::const_iterator S =
+        FS.BodySamples.find(DL.getLine() - HeaderLine);
+      if (S != FS.BodySamples.end())
+        Weight = std::max(Weight, S->second);
+    }
+    BlockWeights[BB] = Weight;
+    DEBUG(dbgs() << "  weight of " << BB->getName() << ": " << Weight << "\n");
+  }
+}
+
+/// findEquivalenceClasses - Put each block in the class of the first block
+/// that dominates it, is post-dominated by it and is in the same loop: the
+/// two always execute the same number of times.  Sampling is lossy, so each
+/// class takes the largest weight among its blocks.
+void SampleProfileLoader::findEquivalenceClasses(Function &F) {
+  SmallVector<BasicBlock*, 8> Dominated;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    if (EquivalenceClass.count(BB))
+      continue;
+    EquivalenceClass[BB] = BB;
+
+    Dominated.clear();
+    DT->getDescendants(BB, Dominated);
+    uint64_t &Weight = BlockWeights[BB];
+    Loop *L = LI->getLoopFor(BB);
+    for (unsigned i = 0, e = Dominated.size(); i != e; ++i) {
+      BasicBlock *Other = Dominated[i];
+      if (Other == BB || EquivalenceClass.count(Other) ||
+          LI->getLoopFor(Other) != L || !PDT->dominates(Other, BB))
+        continue;
+      EquivalenceClass[Other] = BB;
+      Weight = std::max(Weight, BlockWeights[Other]);
+    }
+  }
+}
+
+/// propagateThroughEdges - Infer what edge weights the block weights allow.
+/// When all edges but one into or out of a block are known, that one carries
+/// the rest of the block weight.  When all are known and outweigh the block,
+/// the block was undersampled and takes their sum.  Return true if anything
+/// changed.
+bool SampleProfileLoader::propagateThroughEdges(Function &F) {
+  bool Changed = false;
+  SmallVector<Edge, 8> Edges;
+  SmallPtrSet<BasicBlock*, 8> Seen;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    uint64_t &BBWeight = BlockWeights[EquivalenceClass[BB]];
+    for (unsigned Dir = 0; Dir != 2; ++Dir) {
+      Edges.clear();
+      Seen.clear();
+      if (Dir == 0) {
+        for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB);
+             PI != PE; ++PI)
+          if (Seen.insert(*PI))
+            Edges.push_back(Edge(*PI, BB));
+      } else {
+        for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB);
+             SI != SE; ++SI)
+          if (Seen.insert(*SI))
+            Edges.push_back(Edge(BB, *SI));
+      }
+      if (Edges.empty())
+        continue;
+
+      uint64_t Total = 0;
+      unsigned NumUnknown = 0;
+      Edge Unknown;
+      for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+        DenseMap<Edge, uint64_t>::iterator W = EdgeWeights.find(Edges[i]);
+        if (W != EdgeWeights.end()) {
+          Total += W->second;
+          continue;
+        }
+        ++NumUnknown;
+        Unknown = Edges[i];
+      }
+
+      if (NumUnknown == 1) {
+        EdgeWeights[Unknown] = BBWeight > Total ? BBWeight - Total : 0;
+        Changed = true;
+      } else if (NumUnknown == 0 && Total > BBWeight) {
+        BBWeight = Total;
+        Changed = true;
+      }
+    }
+  }
+  return Changed;
+}
+
+/// annotateFunction - Set the branch weights of every conditional terminator
+/// whose edges are known, and the call counts of sampled calls.
+void SampleProfileLoader::annotateFunction(Function &F) {
+  MDBuilder MDB(F.getContext());
+  SmallVector<uint64_t, 4> EdgeCounts;
+  SmallPtrSet<BasicBlock*, 4> Seen;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    TerminatorInst *TI = BB->getTerminator();
+    if (TI->getNumSuccessors() < 2 ||
+        !(isa<BranchInst>(TI) || isa<SwitchInst>(TI)))
+      continue;
+
+    // Several cases of a switch may share a successor.  The edge weight
+    // covers all of them, so it goes to the first and the others get none.
+    EdgeCounts.clear();
+    Seen.clear();
+    bool AllKnown = true;
+    for (unsigned s = 0, se = TI->getNumSuccessors(); s != se; ++s) {
+      BasicBlock *Succ = TI->getSuccessor(s);
+      DenseMap<Edge, uint64_t>::iterator W = EdgeWeights.find(Edge(BB, Succ));
+      AllKnown &= W != EdgeWeights.end();
+      EdgeCounts.push_back(AllKnown && Seen.insert(Succ) ? W->second : 0);
+    }
+    uint64_t MaxEdge = *std::max_element(EdgeCounts.begin(),
+                                         EdgeCounts.end());
+    // Leave the heuristics to code the profile says nothing about.
+    if (!AllKnown || MaxEdge == 0)
+      continue;
+
+    uint64_t Scale = MaxEdge / (UINT32_MAX / EdgeCounts.size()) + 1;
+    SmallVector<uint32_t, 4> Weights;
+    for (unsigned s = 0, se = EdgeCounts.size(); s != se; ++s)
+      Weights.push_back(EdgeCounts[s] / Scale);
+    TI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(Weights));
+    ++NumAnnotatedBranches;
+  }
+
+  // A block without samples may still have run, so its calls are left
+  // unannotated rather than marked as never executed.
+  Type *Int64Ty = Type::getInt64Ty(F.getContext());
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    DenseMap<BasicBlock*, uint64_t>::const_iterator W =
+      BlockWeights.find(EquivalenceClass.lookup(BB));
+    if (W == BlockWeights.end() || W->second == 0)
+      continue;
+    Value *Ops[] = { MDB.createString("branch_weights"),
+                     ConstantInt::get(Int64Ty, W->second) };
+    MDNode *CallCount = MDNode::get(F.getContext(), Ops);
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      CallInst *CI = dyn_cast<CallInst>(I);
+      if (!CI || isa<IntrinsicInst>(CI) || CI->isInlineAsm())
+        continue;
+      CI->setMetadata(LLVMContext::MD_prof, CallCount);
+    }
+  }
+}
+
+bool SampleProfileLoader::runOnFunction(Function &F) {
+  if (!Profile)
+    return false;
+  const FunctionSamples *FS = Profile->getFunction(F.getName());
+  if (!FS)
+    return false;
+
+  unsigned HeaderLine = getFunctionLoc(F);
+  if (HeaderLine == 0) {
+    DEBUG(dbgs() << "Sample profile: no line information in '"
+                 << F.getName() << "'\n");
+    ++NumNoDebugInfo;
+    return false;
+  }
+
+  DEBUG(dbgs() << "Sample profile: annotating '" << F.getName()
+               << "', header at line " << HeaderLine << "\n");
+  DT = &getAnalysis<DominatorTree>();
+  PDT = &getAnalysis<PostDominatorTree>();
+  LI = &getAnalysis<LoopInfo>();
+
+  BlockWeights.clear();
+  EquivalenceClass.clear();
+  EdgeWeights.clear();
+
+  computeBlockWeights(F, *FS, HeaderLine);
+  findEquivalenceClasses(F);
+  for (unsigned i = 0; i != SampleProfileMaxPropagateIterations; ++i)
+    if (!propagateThroughEdges(F))
+      break;
+
+  annotateFunction(F);
+  ++NumAnnotatedFunctions;
+  return true;
+}
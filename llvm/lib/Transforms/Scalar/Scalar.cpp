@@ -53,6 +53,7 @@ void llvm::initializeScalarOpts(PassRegistry &Registry) {
   initializeReassociatePass(Registry);
   initializeRegToMemPass(Registry);
   initializeSCCPPass(Registry);
+  initializeSampleProfileLoaderPass(Registry);
   initializeIPSCCPPass(Registry);
   initializeSROAPass(Registry);
   initializeSROA_DTPass(Registry);
@@ -508,9 +508,18 @@ void llvm::MergeBasicBlockIntoOnlyPred(BasicBlock *DestBB, Pass *P) {
   if (P) {
     DominatorTree *DT = P->getAnalysisIfAvailable<DominatorTree>();
     if (DT) {
-      BasicBlock *PredBBIDom = DT->getNode(PredBB)->getIDom()->getBlock();
-      DT->changeImmediateDominator(DestBB, PredBBIDom);
-      DT->eraseNode(PredBB);
+      DomTreeNode *PredNode = DT->getNode(PredBB);
+      if (!PredNode) {
+        // PredBB is unreachable, and so is DestBB, its only successor.
+        if (DT->getNode(DestBB))
+          DT->eraseNode(DestBB);
+      } else if (DomTreeNode *PredIDom = PredNode->getIDom()) {
+        DT->changeImmediateDominator(DestBB, PredIDom->getBlock());
+        DT->eraseNode(PredBB);
+      } else {
+        // PredBB was the entry block; DestBB, its only child, is the new root.
+        DT->eraseRootNode();
+      }
     }
   }
   // Nuke BB.
@@ -0,0 +1,528 @@
+//===- SplitModule.cpp - Split a module into partitions -------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the function llvm::SplitModule, which splits a module
+// into multiple linkable partitions. Each partition is a full copy of the
+// module in which the definitions that belong to other partitions have been
+// turned into declarations.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "split-module"
+#include "llvm/Transforms/Utils/SplitModule.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalAlias.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Instruction.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <algorithm>
+using namespace llvm;
+
+STATISTIC(NumPromoted, "Number of local symbols promoted to hidden globals");
+
+namespace {
+typedef EquivalenceClasses<const GlobalValue *> ClusterMapType;
+typedef DenseMap<const GlobalValue *, unsigned> PartitionMapType;
+} // end anonymous namespace
+
+/// isUsedList - Return true if \p GV is llvm.used or llvm.compiler.used.
+/// These lists are filtered per partition rather than assigned to one.
+static bool isUsedList(const GlobalValue *GV) {
+  return GV->getName() == "llvm.used" || GV->getName() == "llvm.compiler.used";
+}
+
+/// isPartitioned - Return true if \p GV is a definition that has to be
+/// assigned to exactly one partition.
+static bool isPartitioned(const GlobalValue *GV) {
+  return !GV->isDeclaration() && !GV->hasAppendingLinkage();
+}
+
+/// findReferencingGlobals - Collect the globals whose definitions refer to
+/// \p V, looking through constant expressions and aggregates.
+static void findReferencingGlobals(const Value *V,
+                                   SmallPtrSet<const GlobalValue *, 8> &Refs,
+                                   SmallPtrSet<const Constant *, 8> &Visited) {
+  for (Value::const_use_iterator UI = V->use_begin(), UE = V->use_end();
+       UI != UE; ++UI) {
+    const User *U = *UI;
+    if (const Instruction *I = dyn_cast<Instruction>(U)) {
+      Refs.insert(I->getParent()->getParent());
+    } else if (const GlobalValue *GV = dyn_cast<GlobalValue>(U)) {
+      Refs.insert(GV);
+    } else if (const Constant *C = dyn_cast<Constant>(U)) {
+      if (Visited.insert(C))
+        findReferencingGlobals(C, Refs, Visited);
+    }
+  }
+}
+
+/// addMandatoryClusters - Group the globals that cannot be separated: an
+/// alias must be emitted together with its aliasee, and a blockaddress can only
+/// be materialized in the module that defines the function.
+static void addMandatoryClusters(Module *M, ClusterMapType &Clusters) {
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+       I != E; ++I) {
+    Clusters.insert(I);
+    if (const GlobalValue *Aliasee = I->getAliasedGlobal())
+      Clusters.unionSets(I, Aliasee);
+  }
+
+  for (Module::iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    if (F->isDeclaration())
+      continue;
+    Clusters.insert(F);
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+      if (!BB->hasAddressTaken())
+        continue;
+      for (Value::use_iterator UI = BB->use_begin(), UE = BB->use_end();
+           UI != UE; ++UI) {
+        BlockAddress *BA = dyn_cast<BlockAddress>(*UI);
+        if (!BA)
+          continue;
+        SmallPtrSet<const GlobalValue *, 8> Refs;
+        SmallPtrSet<const Constant *, 8> Visited;
+        findReferencingGlobals(BA, Refs, Visited);
+        for (SmallPtrSet<const GlobalValue *, 8>::iterator RI = Refs.begin(),
+                                                           RE = Refs.end();
+             RI != RE; ++RI)
+          if (isPartitioned(*RI))
+            Clusters.unionSets(F, *RI);
+      }
+    }
+  }
+}
+
+/// getNameHash - Hash the name of \p GV into a partition-independent value.
+static uint32_t getNameHash(const GlobalValue *GV) {
+  MD5 Hasher;
+  Hasher.update(GV->getName());
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  return uint32_t(Result[0]) | (uint32_t(Result[1]) << 8) |
+         (uint32_t(Result[2]) << 16) | (uint32_t(Result[3]) << 24);
+}
+
+/// collectDefinitions - Collect the partitioned globals of \p M in module
+/// order.
+static void collectDefinitions(Module *M,
+                               SmallVectorImpl<const GlobalValue *> &Defs) {
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    if (isPartitioned(I))
+      Defs.push_back(I);
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I)
+    if (isPartitioned(I))
+      Defs.push_back(I);
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+       I != E; ++I)
+    Defs.push_back(I);
+}
+
+/// assignPartitionsByName - Assign every partitioned global to one of \p N
+/// partitions. Globals in the same cluster share a partition, which is picked
+/// by hashing the name of the cluster leader.
+static void assignPartitionsByName(ArrayRef<const GlobalValue *> Defs,
+                                   ClusterMapType &Clusters, unsigned N,
+                                   PartitionMapType &PartitionOf) {
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    const GlobalValue *Leader = Clusters.getOrInsertLeaderValue(Defs[i]);
+    PartitionOf[Defs[i]] = getNameHash(Leader) % N;
+  }
+}
+
+/// getDefinitionSize - Return an estimate of the amount of code or data
+/// emitted for \p GV, used to balance the partitions.
+static unsigned getDefinitionSize(const GlobalValue *GV) {
+  const Function *F = dyn_cast<Function>(GV);
+  if (!F)
+    return 1;
+  unsigned Size = 1;
+  for (Function::const_iterator BB = F->begin(), E = F->end(); BB != E; ++BB)
+    Size += BB->size();
+  return Size;
+}
+
+namespace {
+/// LocalityClusterer - Groups definitions with the globals referring to them,
+/// so that call chains and their private helpers stay in one partition.
+class LocalityClusterer {
+  ArrayRef<const GlobalValue *> Defs;
+  ClusterMapType &Clusters;
+  /// The position of each definition in Defs, used to visit the globals
+  /// referring to a definition in a deterministic order.
+  DenseMap<const GlobalValue *, unsigned> Order;
+  /// The size of each cluster, indexed by its leader.
+  DenseMap<const GlobalValue *, unsigned> ClusterSize;
+  unsigned MaxClusterSize;
+
+  bool tryMerge(const GlobalValue *A, const GlobalValue *B);
+
+public:
+  LocalityClusterer(ArrayRef<const GlobalValue *> Defs,
+                    ClusterMapType &Clusters)
+    : Defs(Defs), Clusters(Clusters), MaxClusterSize(0) {}
+
+  void run(unsigned N);
+  void assign(unsigned N, PartitionMapType &PartitionOf);
+};
+
+/// ClusterInfo - A cluster to be placed by LocalityClusterer::assign.
+struct ClusterInfo {
+  const GlobalValue *Leader;
+  unsigned Size;
+};
+
+/// ClusterSizeCompare - Order clusters by decreasing size.
+struct ClusterSizeCompare {
+  bool operator()(const ClusterInfo &LHS, const ClusterInfo &RHS) const {
+    return LHS.Size > RHS.Size;
+  }
+};
+
+/// OrderCompare - Order globals by their position in the module.
+struct OrderCompare {
+  const DenseMap<const GlobalValue *, unsigned> &Order;
+  explicit OrderCompare(const DenseMap<const GlobalValue *, unsigned> &Order)
+    : Order(Order) {}
+  bool operator()(const GlobalValue *LHS, const GlobalValue *RHS) const {
+    return Order.lookup(LHS) < Order.lookup(RHS);
+  }
+};
+} // end anonymous namespace
+
+/// tryMerge - Merge the clusters of \p A and \p B unless the result would be
+/// larger than MaxClusterSize.
+bool LocalityClusterer::tryMerge(const GlobalValue *A, const GlobalValue *B) {
+  const GlobalValue *LeaderA = Clusters.getLeaderValue(A);
+  const GlobalValue *LeaderB = Clusters.getLeaderValue(B);
+  if (LeaderA == LeaderB)
+    return true;
+  unsigned Size = ClusterSize[LeaderA] + ClusterSize[LeaderB];
+  if (Size > MaxClusterSize)
+    return false;
+  Clusters.unionSets(LeaderA, LeaderB);
+  ClusterSize[Clusters.getLeaderValue(LeaderA)] = Size;
+  return true;
+}
+
+/// run - Grow the clusters along the references to local definitions and to
+/// definitions with a single user. Clusters never grow beyond an even share
+/// of the module, so that the partitions can still be balanced.
+void LocalityClusterer::run(unsigned N) {
+  unsigned TotalSize = 0;
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    Order[Defs[i]] = i;
+    unsigned Size = getDefinitionSize(Defs[i]);
+    ClusterSize[Clusters.getOrInsertLeaderValue(Defs[i])] += Size;
+    TotalSize += Size;
+  }
+  MaxClusterSize = std::max(1U, TotalSize / N);
+
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    const GlobalValue *GV = Defs[i];
+    SmallPtrSet<const GlobalValue *, 8> Refs;
+    SmallPtrSet<const Constant *, 8> Visited;
+    findReferencingGlobals(GV, Refs, Visited);
+
+    SmallVector<const GlobalValue *, 8> Users;
+    for (SmallPtrSet<const GlobalValue *, 8>::iterator RI = Refs.begin(),
+                                                       RE = Refs.end();
+         RI != RE; ++RI)
+      if (*RI != GV && isPartitioned(*RI))
+        Users.push_back(*RI);
+    if (Users.empty() || (!GV->hasLocalLinkage() && Users.size() != 1))
+      continue;
+
+    std::sort(Users.begin(), Users.end(), OrderCompare(Order));
+    for (unsigned u = 0, ue = Users.size(); u != ue; ++u)
+      tryMerge(GV, Users[u]);
+  }
+}
+
+/// assign - Place the clusters, largest first, in the least loaded partition.
+void LocalityClusterer::assign(unsigned N, PartitionMapType &PartitionOf) {
+  SmallVector<ClusterInfo, 32> Infos;
+  SmallPtrSet<const GlobalValue *, 32> Seen;
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    const GlobalValue *Leader = Clusters.getLeaderValue(Defs[i]);
+    if (!Seen.insert(Leader))
+      continue;
+    ClusterInfo Info = { Leader, ClusterSize[Leader] };
+    Infos.push_back(Info);
+  }
+  std::stable_sort(Infos.begin(), Infos.end(), ClusterSizeCompare());
+
+  SmallVector<unsigned, 8> Load(N, 0);
+  DenseMap<const GlobalValue *, unsigned> ClusterPartition;
+  for (unsigned i = 0, e = Infos.size(); i != e; ++i) {
+    unsigned Best = 0;
+    for (unsigned P = 1; P != N; ++P)
+      if (Load[P] < Load[Best])
+        Best = P;
+    ClusterPartition[Infos[i].Leader] = Best;
+    Load[Best] += Infos[i].Size;
+    DEBUG(dbgs() << "split-module: cluster '" << Infos[i].Leader->getName()
+                 << "' of size " << Infos[i].Size << " -> partition " << Best
+                 << '\n');
+  }
+
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i)
+    PartitionOf[Defs[i]] =
+      ClusterPartition.lookup(Clusters.getLeaderValue(Defs[i]));
+}
+
+/// assignPartitions - Assign every partitioned global of \p M to one of \p N
+/// partitions.
+static void assignPartitions(Module *M, unsigned N, bool PreserveLocality,
+                             PartitionMapType &PartitionOf) {
+  ClusterMapType Clusters;
+  addMandatoryClusters(M, Clusters);
+
+  SmallVector<const GlobalValue *, 32> Defs;
+  collectDefinitions(M, Defs);
+
+  if (!PreserveLocality) {
+    assignPartitionsByName(Defs, Clusters, N, PartitionOf);
+    return;
+  }
+
+  LocalityClusterer Clusterer(Defs, Clusters);
+  Clusterer.run(N);
+  Clusterer.assign(N, PartitionOf);
+}
+
+/// getReferencePartition - Return the partition that has to be able to refer
+/// to a global used by \p GV, or -1 if no partition needs to.
+static int getReferencePartition(const GlobalValue *GV,
+                                 const PartitionMapType &PartitionOf) {
+  // Appending globals other than the used lists, such as llvm.global_ctors,
+  // are emitted in the first partition only.
+  if (GV->hasAppendingLinkage())
+    return isUsedList(GV) ? -1 : 0;
+  PartitionMapType::const_iterator I = PartitionOf.find(GV);
+  return I == PartitionOf.end() ? -1 : int(I->second);
+}
+
+/// getModuleSuffix - Return a suffix for the symbols promoted in \p M that is
+/// unlikely to be used by any other module. It hashes the module identifier
+/// and the names of the strong external definitions, which no other module of
+/// the program can define as well. Weak and linkonce definitions are left out
+/// since several modules may define them.
+static std::string getModuleSuffix(Module *M) {
+  MD5 Hasher;
+  Hasher.update(M->getModuleIdentifier());
+  Hasher.update(StringRef("", 1));
+  SmallVector<const GlobalValue *, 32> Defs;
+  collectDefinitions(M, Defs);
+  for (unsigned i = 0, e = Defs.size(); i != e; ++i) {
+    if (Defs[i]->hasLocalLinkage() || Defs[i]->isWeakForLinker() ||
+        !Defs[i]->hasName())
+      continue;
+    Hasher.update(Defs[i]->getName());
+    Hasher.update(StringRef("", 1));
+  }
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  uint64_t Hash = 0;
+  for (unsigned i = 0; i != 8; ++i)
+    Hash |= uint64_t(Result[i]) << (i * 8);
+  return ".llvmsplit." + utohexstr(Hash);
+}
+
+/// externalize - Turn the local global \p GV into a hidden external symbol
+/// that can be referenced from other partitions. It is renamed with \p Suffix
+/// so that it cannot clash with a local of the same name in another module.
+static void externalize(GlobalValue *GV, StringRef Suffix) {
+  GV->setLinkage(GlobalValue::ExternalLinkage);
+  GV->setVisibility(GlobalValue::HiddenVisibility);
+  if (GV->hasName())
+    GV->setName(GV->getName() + Suffix);
+  else
+    GV->setName("__llvmsplit_unnamed" + Suffix);
+  ++NumPromoted;
+}
+
+/// promoteCrossPartitionLocals - Externalize the local symbols that are
+/// referenced from a partition other than the one defining them.
+static void promoteCrossPartitionLocals(Module *M,
+                                        const PartitionMapType &PartitionOf) {
+  SmallVector<GlobalValue *, 32> Locals;
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    if (I->hasLocalLinkage() && isPartitioned(I))
+      Locals.push_back(I);
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage() && isPartitioned(I))
+      Locals.push_back(I);
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+       I != E; ++I)
+    if (I->hasLocalLinkage())
+      Locals.push_back(I);
+
+  std::string Suffix;
+  for (unsigned i = 0, e = Locals.size(); i != e; ++i) {
+    GlobalValue *GV = Locals[i];
+    int Home = PartitionOf.lookup(GV);
+    SmallPtrSet<const GlobalValue *, 8> Refs;
+    SmallPtrSet<const Constant *, 8> Visited;
+    findReferencingGlobals(GV, Refs, Visited);
+    for (SmallPtrSet<const GlobalValue *, 8>::iterator RI = Refs.begin(),
+                                                       RE = Refs.end();
+         RI != RE; ++RI) {
+      int RefPartition = getReferencePartition(*RI, PartitionOf);
+      if (RefPartition != -1 && RefPartition != Home) {
+        DEBUG(dbgs() << "split-module: promoting '" << GV->getName()
+                     << "' referenced from '" << (*RI)->getName() << "'\n");
+        if (Suffix.empty())
+          Suffix = getModuleSuffix(M);
+        externalize(GV, Suffix);
+        break;
+      }
+    }
+  }
+}
+
+/// createDeclarationFor - Create an external declaration in \p P that can
+/// replace the alias \p GA.
+static GlobalValue *createDeclarationFor(Module *P, GlobalAlias *GA) {
+  PointerType *PTy = GA->getType();
+  GlobalValue *Decl;
+  if (FunctionType *FTy = dyn_cast<FunctionType>(PTy->getElementType()))
+    Decl = Function::Create(FTy, GlobalValue::ExternalLinkage, "", P);
+  else
+    Decl = new GlobalVariable(*P, PTy->getElementType(), false,
+                              GlobalValue::ExternalLinkage, 0, "", 0,
+                              GlobalVariable::NotThreadLocal,
+                              PTy->getAddressSpace());
+  Decl->setVisibility(GA->getVisibility());
+  return Decl;
+}
+
+/// filterUsedList - Drop the entries of llvm.used or llvm.compiler.used in
+/// \p P that do not refer to a definition of \p P.
+static void filterUsedList(Module *P, bool CompilerUsed) {
+  SmallPtrSet<GlobalValue *, 8> Used;
+  GlobalVariable *UsedList = collectUsedGlobalVariables(*P, Used, CompilerUsed);
+  if (!UsedList)
+    return;
+
+  ConstantArray *Init = cast<ConstantArray>(UsedList->getInitializer());
+  SmallVector<Constant *, 8> Kept;
+  for (unsigned i = 0, e = Init->getNumOperands(); i != e; ++i) {
+    Constant *C = Init->getOperand(i);
+    if (!cast<GlobalValue>(C->stripPointerCasts())->isDeclaration())
+      Kept.push_back(C);
+  }
+  if (Kept.size() == Init->getNumOperands())
+    return;
+
+  if (!Kept.empty()) {
+    ArrayType *ATy = ArrayType::get(Init->getType()->getElementType(),
+                                    Kept.size());
+    GlobalVariable *NewList =
+      new GlobalVariable(*P, ATy, false, GlobalValue::AppendingLinkage,
+                         ConstantArray::get(ATy, Kept), "");
+    NewList->setSection(UsedList->getSection());
+    NewList->takeName(UsedList);
+  }
+  UsedList->eraseFromParent();
+}
+
+/// createPartition - Clone \p M and strip the definitions that do not belong
+/// to partition \p Index from the copy.
+static Module *createPartition(Module *M, unsigned Index,
+                               const PartitionMapType &PartitionOf) {
+  ValueToValueMapTy VMap;
+  Module *P = CloneModule(M, VMap);
+
+  // Globals of P whose definitions were dropped. They are erased at the end
+  // if nothing in P refers to them anymore.
+  SmallVector<GlobalValue *, 32> Dropped;
+
+  for (Module::alias_iterator I = M->alias_begin(), E = M->alias_end();
+       I != E; ++I) {
+    if (PartitionOf.lookup(I) == Index)
+      continue;
+    GlobalAlias *GA = cast<GlobalAlias>(VMap[I]);
+    GlobalValue *Decl = createDeclarationFor(P, GA);
+    Decl->takeName(GA);
+    GA->replaceAllUsesWith(ConstantExpr::getBitCast(Decl, GA->getType()));
+    GA->eraseFromParent();
+    Dropped.push_back(Decl);
+  }
+
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I) {
+    if (!isPartitioned(I) || PartitionOf.lookup(I) == Index)
+      continue;
+    Function *F = cast<Function>(VMap[I]);
+    F->deleteBody();
+    Dropped.push_back(F);
+  }
+
+  for (Module::global_iterator I = M->global_begin(), E = M->global_end();
+       I != E; ++I) {
+    GlobalVariable *GV = cast<GlobalVariable>(VMap[I]);
+    if (I->hasAppendingLinkage()) {
+      // The used lists are filtered below; all other appending globals are
+      // emitted by the first partition.
+      if (Index != 0 && !isUsedList(GV))
+        GV->eraseFromParent();
+      continue;
+    }
+    if (!isPartitioned(I) || PartitionOf.lookup(I) == Index)
+      continue;
+    GV->setInitializer(0);
+    GV->setLinkage(GlobalValue::ExternalLinkage);
+    Dropped.push_back(GV);
+  }
+
+  filterUsedList(P, /*CompilerUsed=*/false);
+  filterUsedList(P, /*CompilerUsed=*/true);
+
+  for (unsigned i = 0, e = Dropped.size(); i != e; ++i) {
+    GlobalValue *GV = Dropped[i];
+    GV->removeDeadConstantUsers();
+    if (GV->use_empty())
+      GV->eraseFromParent();
+  }
+
+  // Module level inline asm may define symbols, so it is emitted once.
+  if (Index != 0)
+    P->setModuleInlineAsm("");
+
+  return P;
+}
+
+void llvm::SplitModule(Module *M, unsigned N,
+                       void (*ModuleCallback)(Module *Part, unsigned Index,
+                                              void *Context),
+                       void *Context, bool PreserveLocality) {
+  assert(N != 0 && "Cannot split a module into zero partitions!");
+
+  PartitionMapType PartitionOf;
+  assignPartitions(M, N, PreserveLocality, PartitionOf);
+  promoteCrossPartitionLocals(M, PartitionOf);
+
+  for (unsigned I = 0; I != N; ++I)
+    ModuleCallback(createPartition(M, I, PartitionOf), I, Context);
+}
@@ -106,6 +106,18 @@ static cl::opt<bool>
 EnableIfConversion("enable-if-conversion", cl::init(true), cl::Hidden,
                    cl::desc("Enable if-conversion during vectorization."));
 
+static cl::opt<bool>
+EnableMaskedMemOps("enable-masked-mem-ops", cl::init(true), cl::Hidden,
+                   cl::desc("If-convert conditional loads and stores with "
+                            "masked memory intrinsics, where the target "
+                            "supports them."));
+
+static cl::opt<bool>
+EnableEarlyExitVectorization("enable-early-exit-vectorization",
+                             cl::init(true), cl::Hidden,
+                             cl::desc("Vectorize read-only loops that have an "
+                                      "early exit in addition to the latch."));
+
 /// We don't vectorize loops with a known constant trip count below this number.
 static cl::opt<unsigned>
 TinyTripCountVectorThreshold("vectorizer-min-trip-count", cl::init(16),
@@ -114,6 +126,18 @@ TinyTripCountVectorThreshold("vectorizer-min-trip-count", cl::init(16),
                                       "trip count that is smaller than this "
                                       "value."));
 
+static cl::opt<bool>
+EnableInterleavedMemAccesses("enable-interleaved-mem-accesses", cl::init(false),
+                             cl::Hidden,
+                             cl::desc("Vectorize groups of strided loads and "
+                                      "stores as wide accesses and shuffles."));
+
+static cl::opt<unsigned>
+MaxInterleaveGroupFactor("max-interleave-group-factor", cl::init(8),
+                         cl::Hidden,
+                         cl::desc("The largest stride of an interleaved "
+                                  "access group."));
+
 /// We don't unroll loops with a known constant trip count below this number.
 static const unsigned TinyTripCountUnrollThreshold = 128;
 
@@ -136,6 +160,32 @@ namespace {
 class LoopVectorizationLegality;
 class LoopVectorizationCostModel;
 
+/// InterleaveGroup - A group of loads or stores in one block that access the
+/// fields of an array of structs, such as the r, g and b fields of an RGB
+/// image. Every member has the same constant stride, which is the number of
+/// fields (the factor), and its own field index. The vectorizer emits the
+/// group as one wide access plus shuffles, in place of the first load or the
+/// last store.
+struct InterleaveGroup {
+  InterleaveGroup(unsigned Factor, unsigned Align)
+      : Factor(Factor), Align(Align), InsertPos(0), Members(Factor) {}
+
+  /// The number of fields, which is the stride of the members in elements.
+  unsigned Factor;
+  /// The alignment of the field with index zero.
+  unsigned Align;
+  /// The member that the wide access replaces.
+  Instruction *InsertPos;
+  /// The member at each field index, or null for a field that is not
+  /// accessed.
+  SmallVector<Instruction *, 8> Members;
+
+  /// \return The field index of the member \p I.
+  unsigned getIndex(const Instruction *I) const {
+    return std::find(Members.begin(), Members.end(), I) - Members.begin();
+  }
+};
+
 /// InnerLoopVectorizer vectorizes loops which contain only one basic
 /// block to a specified vectorization factor (VF).
 /// This class performs the widening of scalars into vectors, or multiple
@@ -201,6 +251,10 @@ protected:
   /// See PR14725.
   void fixLCSSAPHIs();
 
+  /// Leave the vector loop for the early exit block when any lane of the
+  /// current iteration takes the early exit of the original loop.
+  void addEarlyExitCheck(LoopVectorizationLegality *Legal);
+
   /// A helper function that computes the predicate of the block BB, assuming
   /// that the header block of the loop is set to True. It returns the *entry*
   /// mask for the block BB.
@@ -232,6 +286,11 @@ protected:
   virtual void vectorizeMemoryInstruction(Instruction *Instr,
                                   LoopVectorizationLegality *Legal);
 
+  /// Vectorize the interleave group of the load or store \p Instr. The whole
+  /// group is emitted when \p Instr is its insert position.
+  void vectorizeInterleaveGroup(Instruction *Instr,
+                                const InterleaveGroup *Group);
+
   /// Create a broadcast instruction. This method generates a broadcast
   /// instruction (shuffle) for loop invariant values and for the induction
   /// value. If this is the induction variable then we extend it to N, N+1, ...
@@ -331,6 +390,12 @@ protected:
   BasicBlock *LoopExitBlock;
   ///The vector loop body.
   BasicBlock *LoopVectorBody;
+  /// The block that takes the backedge of the vector loop. This is the vector
+  /// loop body, unless the loop has an early exit.
+  BasicBlock *LoopVectorLatch;
+  /// The block that the vector loop branches to when a lane takes the early
+  /// exit of the original loop, or null.
+  BasicBlock *LoopEarlyExitBlock;
   ///The scalar loop body.
   BasicBlock *LoopScalarBody;
   /// A list of all bypass blocks. The first block is the entry of the loop.
@@ -407,10 +472,11 @@ static void setDebugLocFromInst(IRBuilder<> &B, const Value *Ptr) {
 class LoopVectorizationLegality {
 public:
   LoopVectorizationLegality(Loop *L, ScalarEvolution *SE, DataLayout *DL,
-                            DominatorTree *DT, TargetLibraryInfo *TLI)
-      : TheLoop(L), SE(SE), DL(DL), DT(DT), TLI(TLI),
+                            DominatorTree *DT, TargetLibraryInfo *TLI,
+                            const TargetTransformInfo *TTI)
+      : TheLoop(L), SE(SE), DL(DL), DT(DT), TLI(TLI), TTI(TTI),
         Induction(0), WidestIndTy(0), HasFunNoNaNAttr(false),
-        MaxSafeDepDistBytes(-1U) {}
+        MaxSafeDepDistBytes(-1U), EarlyExitingBlock(0) {}
 
   /// This enum represents the kinds of reductions that we support.
   enum ReductionKind {
@@ -584,6 +650,27 @@ public:
 
   unsigned getMaxSafeDepDistBytes() { return MaxSafeDepDistBytes; }
 
+  /// Returns the interleave group of the load or store I, or null if I is
+  /// not part of one.
+  const InterleaveGroup *getInterleaveGroup(Instruction *I) const {
+    DenseMap<Instruction *, unsigned>::const_iterator It =
+        InterleaveGroupMap.find(I);
+    if (It == InterleaveGroupMap.end())
+      return 0;
+    return &InterleaveGroups[It->second];
+  }
+
+  /// Returns true if the load or store \p I is in a predicated block and has
+  /// to be emitted as a masked memory operation.
+  bool isMaskRequired(Instruction *I) { return MaskedOp.count(I); }
+
+  /// Returns true if the loop has loads or stores that need a mask.
+  bool hasMaskedOps() const { return !MaskedOp.empty(); }
+
+  /// Returns the block, other than the latch, that exits the loop, or null if
+  /// the latch is the only exiting block.
+  BasicBlock *getEarlyExitingBlock() const { return EarlyExitingBlock; }
+
 private:
   /// Check if a single basic block loop is vectorizable.
   /// At this point we know that this is a loop with a constant trip count
@@ -600,9 +687,21 @@ private:
   /// transformation.
   bool canVectorizeWithIfConvert();
 
+  /// Returns the early exiting block of a loop that exits from the latch and
+  /// from one other block, if the vectorizer supports that shape.
+  BasicBlock *findEarlyExitingBlock();
+
+  /// Return true if the loop can be vectorized with its early exit: the
+  /// vector loop executes the lanes past the exiting one speculatively.
+  bool canVectorizeEarlyExit();
+
   /// Collect the variables that need to stay uniform after vectorization.
   void collectLoopUniforms();
 
+  /// Group the strided loads and stores that access the fields of an array
+  /// of structs into interleave groups.
+  void collectInterleaveGroups();
+
   /// Return true if all of the instructions in the block can be speculatively
   /// executed. \p SafePtrs is a list of addresses that are known to be legal
   /// and we know that we can read from them without segfault.
@@ -636,6 +735,8 @@ private:
   DominatorTree *DT;
   /// Target Library Info.
   TargetLibraryInfo *TLI;
+  /// Target Transform Info.
+  const TargetTransformInfo *TTI;
 
   //  ---  vectorization state --- //
 
@@ -664,6 +765,18 @@ private:
   bool HasFunNoNaNAttr;
 
   unsigned MaxSafeDepDistBytes;
+
+  /// The interleave groups found in the loop.
+  SmallVector<InterleaveGroup, 4> InterleaveGroups;
+  /// Maps each member of an interleave group to its index in
+  /// InterleaveGroups.
+  DenseMap<Instruction *, unsigned> InterleaveGroupMap;
+
+  /// The loads and stores of predicated blocks that are emitted as masked
+  /// memory operations.
+  SmallPtrSet<Instruction *, 8> MaskedOp;
+  /// The exiting block other than the latch, if any.
+  BasicBlock *EarlyExitingBlock;
 };
 
 /// LoopVectorizationCostModel - estimates the expected speedups due to
@@ -934,7 +1047,7 @@ struct LoopVectorize : public LoopPass {
     }
 
     // Check if it is legal to vectorize the loop.
-    LoopVectorizationLegality LVL(L, SE, DL, DT, TLI);
+    LoopVectorizationLegality LVL(L, SE, DL, DT, TLI, TTI);
     if (!LVL.canVectorize()) {
       DEBUG(dbgs() << "LV: Not vectorizing.\n");
       return false;
@@ -974,7 +1087,8 @@ struct LoopVectorize : public LoopPass {
     DEBUG(dbgs() << "LV: Unroll Factor is " << UF << '\n');
 
     if (VF.Width == 1) {
-      if (UF == 1)
+      // The unroller can't predicate the masked loads and stores.
+      if (UF == 1 || LVL.hasMaskedOps())
         return false;
       // We decided not to vectorize, but we may want to unroll.
       InnerLoopUnroller Unroller(L, SE, LI, DT, DL, TLI, UF);
@@ -1204,6 +1318,10 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
 
   assert((LI || SI) && "Invalid Load/Store instruction");
 
+  // Loads and stores of an interleave group are emitted together.
+  if (const InterleaveGroup *Group = Legal->getInterleaveGroup(Instr))
+    return vectorizeInterleaveGroup(Instr, Group);
+
   Type *ScalarDataTy = LI ? LI->getType() : SI->getValueOperand()->getType();
   Type *DataTy = VectorType::get(ScalarDataTy, VF);
   Value *Ptr = LI ? LI->getPointerOperand() : SI->getPointerOperand();
@@ -1226,6 +1344,22 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
   Constant *Zero = Builder.getInt32(0);
   VectorParts &Entry = WidenMap.get(Instr);
 
+  // Loads and stores in predicated blocks are emitted as masked intrinsics
+  // that only access the lanes of the block mask.
+  VectorParts Mask;
+  Function *MaskedIntr = 0;
+  unsigned MaskedAlign = Alignment ? Alignment :
+    DL->getABITypeAlignment(ScalarDataTy);
+  if (Legal->isMaskRequired(Instr)) {
+    assert(!Reverse && "Masked accesses must be consecutive");
+    Mask = createBlockInMask(Instr->getParent());
+    Type *Tys[] = { DataTy, DataTy->getPointerTo(AddressSpace),
+                    Mask[0]->getType() };
+    MaskedIntr = Intrinsic::getDeclaration(
+        Instr->getParent()->getParent()->getParent(),
+        LI ? Intrinsic::masked_load : Intrinsic::masked_store, Tys);
+  }
+
   // Handle consecutive loads/stores.
   GetElementPtrInst *Gep = dyn_cast<GetElementPtrInst>(Ptr);
   if (Gep && Legal->isInductionVariable(Gep->getPointerOperand())) {
@@ -1303,6 +1437,12 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
 
       Value *VecPtr = Builder.CreateBitCast(PartPtr,
                                             DataTy->getPointerTo(AddressSpace));
+      if (MaskedIntr) {
+        Value *Ops[] = { StoredVal[Part], VecPtr,
+                         Builder.getInt32(MaskedAlign), Mask[Part] };
+        Builder.CreateCall(MaskedIntr, Ops);
+        continue;
+      }
       Builder.CreateStore(StoredVal[Part], VecPtr)->setAlignment(Alignment);
     }
     return;
@@ -1324,12 +1464,132 @@ void InnerLoopVectorizer::vectorizeMemoryInstruction(Instruction *Instr,
 
     Value *VecPtr = Builder.CreateBitCast(PartPtr,
                                           DataTy->getPointerTo(AddressSpace));
+    if (MaskedIntr) {
+      Value *Ops[] = { VecPtr, Builder.getInt32(MaskedAlign), Mask[Part],
+                       UndefValue::get(DataTy) };
+      Entry[Part] = Builder.CreateCall(MaskedIntr, Ops, "wide.masked.load");
+      continue;
+    }
     Value *LI = Builder.CreateLoad(VecPtr, "wide.load");
     cast<LoadInst>(LI)->setAlignment(Alignment);
     Entry[Part] = Reverse ? reverseVector(LI) :  LI;
   }
 }
 
+/// \brief Returns a mask that selects the field \p Index of \p VF structs of
+/// \p Factor fields each: <Index, Index + Factor, Index + 2 * Factor, ...>.
+static Constant *getStridedMask(IRBuilder<> &Builder, unsigned Index,
+                                unsigned Factor, unsigned VF) {
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < VF; ++i)
+    Mask.push_back(Builder.getInt32(Index + i * Factor));
+  return ConstantVector::get(Mask);
+}
+
+/// \brief Returns a mask that interleaves \p Factor concatenated vectors of
+/// \p VF elements each: <0, VF, 2 * VF, ..., 1, VF + 1, 2 * VF + 1, ...>.
+static Constant *getInterleavedMask(IRBuilder<> &Builder, unsigned VF,
+                                    unsigned Factor) {
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < VF; ++i)
+    for (unsigned j = 0; j < Factor; ++j)
+      Mask.push_back(Builder.getInt32(j * VF + i));
+  return ConstantVector::get(Mask);
+}
+
+/// \brief Concatenates \p V1 and \p V2, which may be shorter than \p V1.
+static Value *concatenateTwoVectors(IRBuilder<> &Builder, Value *V1,
+                                    Value *V2) {
+  unsigned NumElts1 = V1->getType()->getVectorNumElements();
+  unsigned NumElts2 = V2->getType()->getVectorNumElements();
+  assert(NumElts1 >= NumElts2 && "Unexpected vector lengths");
+
+  // A shuffle needs operands of the same type, so pad V2 with undef.
+  if (NumElts1 > NumElts2) {
+    SmallVector<Constant *, 16> Mask;
+    for (unsigned i = 0; i < NumElts1; ++i)
+      Mask.push_back(i < NumElts2 ? (Constant *)Builder.getInt32(i) :
+                                    UndefValue::get(Builder.getInt32Ty()));
+    V2 = Builder.CreateShuffleVector(V2, UndefValue::get(V2->getType()),
+                                     ConstantVector::get(Mask));
+  }
+
+  SmallVector<Constant *, 16> Mask;
+  for (unsigned i = 0; i < NumElts1 + NumElts2; ++i)
+    Mask.push_back(Builder.getInt32(i));
+  return Builder.CreateShuffleVector(V1, V2, ConstantVector::get(Mask));
+}
+
+/// \brief Concatenates the vectors in \p Vecs, which all have the same type.
+static Value *concatenateVectors(IRBuilder<> &Builder,
+                                 ArrayRef<Value *> Vecs) {
+  SmallVector<Value *, 8> Parts(Vecs.begin(), Vecs.end());
+  while (Parts.size() > 1) {
+    SmallVector<Value *, 8> Joined;
+    for (unsigned i = 0; i + 1 < Parts.size(); i += 2)
+      Joined.push_back(concatenateTwoVectors(Builder, Parts[i], Parts[i + 1]));
+    if (Parts.size() % 2)
+      Joined.push_back(Parts.back());
+    Parts.swap(Joined);
+  }
+  return Parts.front();
+}
+
+void InnerLoopVectorizer::vectorizeInterleaveGroup(Instruction *Instr,
+                                                const InterleaveGroup *Group) {
+  // The other members are emitted together with the insert position.
+  if (Instr != Group->InsertPos)
+    return;
+
+  LoadInst *LI = dyn_cast<LoadInst>(Instr);
+  StoreInst *SI = dyn_cast<StoreInst>(Instr);
+  Value *Ptr = LI ? LI->getPointerOperand() : SI->getPointerOperand();
+  Type *ScalarDataTy = LI ? LI->getType() : SI->getValueOperand()->getType();
+  unsigned Factor = Group->Factor;
+  unsigned Index = Group->getIndex(Instr);
+  Type *WideTy = VectorType::get(ScalarDataTy, VF * Factor);
+  Type *WidePtrTy =
+      WideTy->getPointerTo(Ptr->getType()->getPointerAddressSpace());
+  Constant *Zero = Builder.getInt32(0);
+
+  setDebugLocFromInst(Builder, Instr);
+  VectorParts &PtrParts = getVectorValue(Ptr);
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    // The wide access starts at field zero of the first struct of the part.
+    Value *BasePtr = Builder.CreateExtractElement(PtrParts[Part], Zero);
+    if (Index)
+      BasePtr = Builder.CreateGEP(BasePtr, Builder.getInt32(-(int)Index));
+    Value *WidePtr = Builder.CreateBitCast(BasePtr, WidePtrTy);
+
+    if (LI) {
+      LoadInst *WideLoad = Builder.CreateLoad(WidePtr, "wide.vec");
+      WideLoad->setAlignment(Group->Align);
+      // Separate the fields that are used.
+      for (unsigned i = 0; i < Factor; ++i) {
+        Instruction *Member = Group->Members[i];
+        if (!Member)
+          continue;
+        WidenMap.get(Member)[Part] = Builder.CreateShuffleVector(
+            WideLoad, UndefValue::get(WideTy),
+            getStridedMask(Builder, i, Factor, VF), "strided.vec");
+      }
+      continue;
+    }
+
+    // Merge the stored fields into one vector.
+    SmallVector<Value *, 8> StoredVecs;
+    for (unsigned i = 0; i < Factor; ++i) {
+      StoreInst *Member = cast<StoreInst>(Group->Members[i]);
+      StoredVecs.push_back(getVectorValue(Member->getValueOperand())[Part]);
+    }
+    Value *Concat = concatenateVectors(Builder, StoredVecs);
+    Value *Interleaved = Builder.CreateShuffleVector(
+        Concat, UndefValue::get(Concat->getType()),
+        getInterleavedMask(Builder, VF, Factor), "interleaved.vec");
+    Builder.CreateStore(Interleaved, WidePtr)->setAlignment(Group->Align);
+  }
+}
+
 void InnerLoopVectorizer::scalarizeInstruction(Instruction *Instr) {
   assert(!Instr->getType()->isAggregateType() && "Can't handle vectors");
   // Holds vector parameters or scalars, in case of uniform vals.
@@ -1489,6 +1749,32 @@ InnerLoopVectorizer::addRuntimeCheck(LoopVectorizationLegality *Legal,
   return Check;
 }
 
+/// \brief Returns the value of the induction \p II after \p Count iterations
+/// of the loop.
+static Value *
+getInductionValueAfter(IRBuilder<> &Builder,
+                       const LoopVectorizationLegality::InductionInfo &II,
+                       Value *Count) {
+  Type *Ty = II.StartValue->getType();
+  switch (II.IK) {
+  case LoopVectorizationLegality::IK_NoInduction:
+    break;
+  case LoopVectorizationLegality::IK_IntInduction:
+    return Builder.CreateAdd(II.StartValue,
+                             Builder.CreateSExtOrTrunc(Count, Ty), "ind.val");
+  case LoopVectorizationLegality::IK_ReverseIntInduction:
+    return Builder.CreateSub(II.StartValue,
+                             Builder.CreateSExtOrTrunc(Count, Ty),
+                             "rev.ind.val");
+  case LoopVectorizationLegality::IK_PtrInduction:
+    return Builder.CreateGEP(II.StartValue, Count, "ptr.ind.val");
+  case LoopVectorizationLegality::IK_ReversePtrInduction:
+    return Builder.CreateGEP(II.StartValue, Builder.CreateNeg(Count),
+                             "rev.ptr.ind.val");
+  }
+  llvm_unreachable("Unknown induction");
+}
+
 void
 InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   /*
@@ -1523,6 +1809,14 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   BasicBlock *OldBasicBlock = OrigLoop->getHeader();
   BasicBlock *BypassBlock = OrigLoop->getLoopPreheader();
   BasicBlock *ExitBlock = OrigLoop->getExitBlock();
+  // With an early exit, the vector loop leaves through the exit of the latch.
+  // Only the scalar loop branches to the early exit.
+  if (Legal->getEarlyExitingBlock()) {
+    BranchInst *LatchBr =
+      cast<BranchInst>(OrigLoop->getLoopLatch()->getTerminator());
+    ExitBlock = LatchBr->getSuccessor(OrigLoop->contains(
+                                          LatchBr->getSuccessor(0)));
+  }
   assert(ExitBlock && "Must have an exit block");
 
   // Some loops have a single integer induction variable, while other loops
@@ -1533,7 +1827,9 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   Type *IdxTy = Legal->getWidestInductionType();
 
   // Find the loop boundaries.
-  const SCEV *ExitCount = SE->getBackedgeTakenCount(OrigLoop);
+  const SCEV *ExitCount = Legal->getEarlyExitingBlock() ?
+    SE->getExitCount(OrigLoop, OrigLoop->getLoopLatch()) :
+    SE->getBackedgeTakenCount(OrigLoop);
   assert(ExitCount != SE->getCouldNotCompute() && "Invalid loop count");
 
   // Get the total trip count from the count by adding 1.
@@ -1597,6 +1893,24 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   // times the unroll factor (num of SIMD instructions).
   Constant *Step = ConstantInt::get(IdxTy, VF * UF);
 
+  // When a lane takes the early exit, the vector loop branches to a block
+  // that resumes the scalar loop at the start of the vector iteration. The
+  // scalar loop then executes the exiting iteration again.
+  BasicBlock *EarlyExitBlock = 0;
+  Value *EarlyExitCount = 0;
+  IRBuilder<> EarlyExitBuilder(VecBody->getContext());
+  if (Legal->getEarlyExitingBlock()) {
+    EarlyExitBlock = BasicBlock::Create(VecBody->getContext(),
+                                        "vector.early.exit",
+                                        VecBody->getParent(), MiddleBlock);
+    if (ParentLoop)
+      ParentLoop->addBasicBlockToLoop(EarlyExitBlock, LI->getBase());
+    EarlyExitBuilder.SetInsertPoint(BranchInst::Create(MiddleBlock,
+                                                       EarlyExitBlock));
+    EarlyExitCount = EarlyExitBuilder.CreateSub(Induction, StartIdx,
+                                                "early.exit.count");
+  }
+
   // This is the IR builder that we use to add all of the logic for bypassing
   // the new vector loop.
   IRBuilder<> BypassBuilder(BypassBlock->getTerminator());
@@ -1758,6 +2072,19 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
     }
     ResumeVal->addIncoming(EndValue, VecBody);
 
+    if (EarlyExitBlock) {
+      if (OrigPhi == OldInduction) {
+        ResumeVal->addIncoming(Induction, EarlyExitBlock);
+        TruncResumeVal->addIncoming(
+            EarlyExitBuilder.CreateTrunc(Induction, OrigPhi->getType()),
+            EarlyExitBlock);
+      } else {
+        ResumeVal->addIncoming(getInductionValueAfter(EarlyExitBuilder, II,
+                                                      EarlyExitCount),
+                               EarlyExitBlock);
+      }
+    }
+
     // Fix the scalar body counter (PHI node).
     unsigned BlockIdx = OrigPhi->getBasicBlockIndex(ScalarPH);
     // The old inductions phi node in the scalar body needs the truncated value.
@@ -1778,6 +2105,8 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
     for (unsigned I = 0, E = LoopBypassBlocks.size(); I != E; ++I)
       ResumeIndex->addIncoming(StartIdx, LoopBypassBlocks[I]);
     ResumeIndex->addIncoming(IdxEndRoundDown, VecBody);
+    if (EarlyExitBlock)
+      ResumeIndex->addIncoming(Induction, EarlyExitBlock);
   }
 
   // Make sure that we found the index where scalar loop needs to continue.
@@ -1815,6 +2144,8 @@ InnerLoopVectorizer::createEmptyLoop(LoopVectorizationLegality *Legal) {
   LoopMiddleBlock = MiddleBlock;
   LoopExitBlock = ExitBlock;
   LoopVectorBody = VecBody;
+  LoopVectorLatch = VecBody;
+  LoopEarlyExitBlock = EarlyExitBlock;
   LoopScalarBody = OldBasicBlock;
 
   LoopVectorizeHints Hints(Lp, true);
@@ -2326,6 +2657,9 @@ InnerLoopVectorizer::vectorizeLoop(LoopVectorizationLegality *Legal) {
 
   // Remove redundant induction instructions.
   cse(LoopVectorBody);
+
+  if (LoopEarlyExitBlock)
+    addEarlyExitCheck(Legal);
 }
 
 void InnerLoopVectorizer::fixLCSSAPHIs() {
@@ -2339,6 +2673,51 @@ void InnerLoopVectorizer::fixLCSSAPHIs() {
   }
 } 
 
+void InnerLoopVectorizer::addEarlyExitCheck(LoopVectorizationLegality *Legal) {
+  BranchInst *ExitBr =
+    cast<BranchInst>(Legal->getEarlyExitingBlock()->getTerminator());
+  Value *Cond = ExitBr->getCondition();
+  bool ExitOnTrue = !OrigLoop->contains(ExitBr->getSuccessor(0));
+  VectorParts &CondParts = getVectorValue(Cond);
+
+  // Vector conditions are sign extended to the width of the values they
+  // compare. Testing the whole vector for zero is then a single instruction
+  // on most targets.
+  Type *MaskEltTy = Builder.getInt8Ty();
+  if (CmpInst *Cmp = dyn_cast<CmpInst>(Cond)) {
+    Type *OpTy = Cmp->getOperand(0)->getType();
+    MaskEltTy = IntegerType::get(Builder.getContext(),
+                                 DL->getTypeSizeInBits(OpTy));
+  }
+
+  Builder.SetInsertPoint(LoopVectorBody->getTerminator());
+  Value *AnyExit = 0;
+  for (unsigned Part = 0; Part < UF; ++Part) {
+    Value *Exits = CondParts[Part];
+    if (!ExitOnTrue)
+      Exits = Builder.CreateNot(Exits);
+    if (VF > 1)
+      Exits = Builder.CreateSExt(Exits, VectorType::get(MaskEltTy, VF));
+    AnyExit = AnyExit ? Builder.CreateOr(AnyExit, Exits) : Exits;
+  }
+  if (VF > 1) {
+    Type *IntTy = IntegerType::get(Builder.getContext(),
+                                   VF * MaskEltTy->getPrimitiveSizeInBits());
+    AnyExit = Builder.CreateICmpNE(Builder.CreateBitCast(AnyExit, IntTy),
+                                   ConstantInt::get(IntTy, 0), "any.exit");
+  }
+
+  // Move the backedge to a new latch block and branch to the early exit
+  // block before it.
+  BasicBlock *Latch =
+    LoopVectorBody->splitBasicBlock(LoopVectorBody->getTerminator(),
+                                    "vector.body.latch");
+  LI->getLoopFor(LoopVectorBody)->addBasicBlockToLoop(Latch, LI->getBase());
+  ReplaceInstWithInst(LoopVectorBody->getTerminator(),
+                      BranchInst::Create(LoopEarlyExitBlock, Latch, AnyExit));
+  LoopVectorLatch = Latch;
+}
+
 InnerLoopVectorizer::VectorParts
 InnerLoopVectorizer::createEdgeMask(BasicBlock *Src, BasicBlock *Dst) {
   assert(std::find(pred_begin(Dst), pred_end(Dst), Src) != pred_end(Dst) &&
@@ -2766,6 +3145,10 @@ void InnerLoopVectorizer::updateAnalysis() {
   DT->addNewBlock(LoopScalarPreHeader, LoopMiddleBlock);
   DT->changeImmediateDominator(LoopScalarBody, LoopScalarPreHeader);
   DT->changeImmediateDominator(LoopExitBlock, LoopMiddleBlock);
+  if (LoopEarlyExitBlock) {
+    DT->addNewBlock(LoopVectorLatch, LoopVectorBody);
+    DT->addNewBlock(LoopEarlyExitBlock, LoopVectorBody);
+  }
 
   DEBUG(DT->verifyAnalysis());
 }
@@ -2813,6 +3196,138 @@ bool LoopVectorizationLegality::canVectorizeWithIfConvert() {
   return true;
 }
 
+BasicBlock *LoopVectorizationLegality::findEarlyExitingBlock() {
+  if (!EnableEarlyExitVectorization)
+    return 0;
+
+  // The loop must exit from the latch and from one other block.
+  BasicBlock *Latch = TheLoop->getLoopLatch();
+  SmallVector<BasicBlock *, 4> ExitingBlocks;
+  TheLoop->getExitingBlocks(ExitingBlocks);
+  if (ExitingBlocks.size() != 2 ||
+      (ExitingBlocks[0] != Latch && ExitingBlocks[1] != Latch))
+    return 0;
+  BasicBlock *Exiting = ExitingBlocks[0] == Latch ? ExitingBlocks[1]
+                                                  : ExitingBlocks[0];
+
+  // The early exit is tested in every iteration, before the latch.
+  if (!DT->dominates(Exiting, Latch))
+    return 0;
+
+  BranchInst *BI = dyn_cast<BranchInst>(Exiting->getTerminator());
+  BranchInst *LatchBr = dyn_cast<BranchInst>(Latch->getTerminator());
+  if (!BI || !BI->isConditional() || !LatchBr || !LatchBr->isConditional() ||
+      TheLoop->contains(BI->getSuccessor(0)) ==
+      TheLoop->contains(BI->getSuccessor(1)))
+    return 0;
+
+  // The vector loop only branches to the exit of the latch, so the early
+  // exit must lead to a block of its own.
+  BasicBlock *Exit = BI->getSuccessor(TheLoop->contains(BI->getSuccessor(0)));
+  if (Exit->getSinglePredecessor() != Exiting)
+    return 0;
+
+  DEBUG(dbgs() << "LV: Found an early exit from " << Exiting->getName() <<
+        ".\n");
+  return Exiting;
+}
+
+/// \brief Returns true if the load \p LI reads from an object that is known
+/// to be allocated for all of the first \p TripCount iterations of \p L.
+static bool isDereferenceableInLoop(LoadInst *LI, uint64_t TripCount,
+                                    ScalarEvolution *SE, DataLayout *DL,
+                                    Loop *L) {
+  const SCEVAddRecExpr *AR =
+    dyn_cast<SCEVAddRecExpr>(SE->getSCEV(LI->getPointerOperand()));
+  if (!AR || AR->getLoop() != L || !AR->isAffine())
+    return false;
+  const SCEVConstant *Step =
+    dyn_cast<SCEVConstant>(AR->getStepRecurrence(*SE));
+  const SCEVUnknown *Base = dyn_cast<SCEVUnknown>(SE->getPointerBase(AR));
+  if (!Step || !Base)
+    return false;
+
+  // Find the size of the object: a global variable that can't be replaced at
+  // link time, or a fixed size alloca.
+  Value *Obj = GetUnderlyingObject(Base->getValue(), DL);
+  uint64_t ObjSize;
+  if (GlobalVariable *GV = dyn_cast<GlobalVariable>(Obj)) {
+    if (GV->isDeclaration() || GV->mayBeOverridden())
+      return false;
+    ObjSize = DL->getTypeAllocSize(GV->getType()->getElementType());
+  } else if (AllocaInst *AI = dyn_cast<AllocaInst>(Obj)) {
+    ConstantInt *ArraySize = dyn_cast<ConstantInt>(AI->getArraySize());
+    if (!ArraySize)
+      return false;
+    ObjSize = DL->getTypeAllocSize(AI->getAllocatedType()) *
+              ArraySize->getZExtValue();
+  } else
+    return false;
+
+  const SCEVConstant *Offset =
+    dyn_cast<SCEVConstant>(SE->getMinusSCEV(AR->getStart(), SE->getSCEV(Obj)));
+  if (!Offset || TripCount > ObjSize)
+    return false;
+
+  // Check the first and the last element that the loop reads.
+  int64_t First = Offset->getValue()->getSExtValue();
+  int64_t StepVal = Step->getValue()->getSExtValue();
+  int64_t Last = First + StepVal * (int64_t)(TripCount - 1);
+  int64_t Size = DL->getTypeStoreSize(LI->getType());
+  return std::min(First, Last) >= 0 &&
+         std::max(First, Last) + Size <= (int64_t)ObjSize;
+}
+
+bool LoopVectorizationLegality::canVectorizeEarlyExit() {
+  // The vector loop executes whole vector iterations. When a lane of an
+  // iteration exits, the scalar loop re-executes that iteration and takes the
+  // exit. The lanes after the exiting one have been executed speculatively by
+  // then, so they must not write memory or feed a reduction.
+  if (!Reductions.empty()) {
+    DEBUG(dbgs() << "LV: Found a reduction in a loop with an early exit.\n");
+    return false;
+  }
+
+  // Their loads must also stay within objects that are known to be
+  // allocated, which needs a constant trip count for the latch.
+  const SCEVConstant *ExitCount =
+    dyn_cast<SCEVConstant>(SE->getExitCount(TheLoop, TheLoop->getLoopLatch()));
+  if (!ExitCount || ExitCount->getValue()->getValue().getActiveBits() > 32) {
+    DEBUG(dbgs() << "LV: Early exit loop has an unknown trip count.\n");
+    return false;
+  }
+  uint64_t TripCount = ExitCount->getValue()->getZExtValue() + 1;
+
+  for (Loop::block_iterator BI = TheLoop->block_begin(),
+       BE = TheLoop->block_end(); BI != BE; ++BI)
+    for (BasicBlock::iterator I = (*BI)->begin(), E = (*BI)->end(); I != E;
+         ++I) {
+      if (I->mayWriteToMemory() || I->mayThrow()) {
+        DEBUG(dbgs() << "LV: Found a side effect in a loop with an early "
+              "exit:" << *I << "\n");
+        return false;
+      }
+      // The control flow of the lanes is handled by the exit test itself.
+      if (isa<PHINode>(I) || isa<TerminatorInst>(I))
+        continue;
+      if (LoadInst *LI = dyn_cast<LoadInst>(I)) {
+        if (!isDereferenceableInLoop(LI, TripCount, SE, DL, TheLoop)) {
+          DEBUG(dbgs() << "LV: Can't speculate the load:" << *I << "\n");
+          return false;
+        }
+        continue;
+      }
+      // Nor may they trap, as a division by a value that the exit test
+      // guards would.
+      if (!isSafeToSpeculativelyExecute(I, DL)) {
+        DEBUG(dbgs() << "LV: Can't speculate:" << *I << "\n");
+        return false;
+      }
+    }
+
+  return true;
+}
+
 bool LoopVectorizationLegality::canVectorize() {
   // We must have a loop in canonical form. Loops with indirectbr in them cannot
   // be canonicalized.
@@ -2827,9 +3342,13 @@ bool LoopVectorizationLegality::canVectorize() {
   if (TheLoop->getNumBackEdges() != 1)
     return false;
 
-  // We must have a single exiting block.
-  if (!TheLoop->getExitingBlock())
-    return false;
+  // We must have a single exiting block, or an early exit in addition to the
+  // latch.
+  if (!TheLoop->getExitingBlock()) {
+    EarlyExitingBlock = findEarlyExitingBlock();
+    if (!EarlyExitingBlock)
+      return false;
+  }
 
   // We need to have a loop header.
   DEBUG(dbgs() << "LV: Found a loop: " <<
@@ -2842,8 +3361,11 @@ bool LoopVectorizationLegality::canVectorize() {
     return false;
   }
 
-  // ScalarEvolution needs to be able to find the exit count.
-  const SCEV *ExitCount = SE->getBackedgeTakenCount(TheLoop);
+  // ScalarEvolution needs to be able to find the exit count. With an early
+  // exit, the vector loop is bounded by the exit count of the latch.
+  const SCEV *ExitCount = EarlyExitingBlock ?
+    SE->getExitCount(TheLoop, TheLoop->getLoopLatch()) :
+    SE->getBackedgeTakenCount(TheLoop);
   if (ExitCount == SE->getCouldNotCompute()) {
     DEBUG(dbgs() << "LV: SCEV could not compute the loop exit count.\n");
     return false;
@@ -2864,6 +3386,24 @@ bool LoopVectorizationLegality::canVectorize() {
     return false;
   }
 
+  // Masked loads and stores are emitted as wide accesses, which need
+  // consecutive addresses.
+  for (SmallPtrSet<Instruction *, 8>::iterator I = MaskedOp.begin(),
+       E = MaskedOp.end(); I != E; ++I) {
+    Value *Ptr = isa<LoadInst>(*I) ? cast<LoadInst>(*I)->getPointerOperand()
+                                   : cast<StoreInst>(*I)->getPointerOperand();
+    if (isConsecutivePtr(Ptr) != 1) {
+      DEBUG(dbgs() << "LV: Can't mask a non-consecutive access:" << **I <<
+            "\n");
+      return false;
+    }
+  }
+
+  if (EarlyExitingBlock && !canVectorizeEarlyExit()) {
+    DEBUG(dbgs() << "LV: Can't vectorize the early exit\n");
+    return false;
+  }
+
   // Go over each instruction and look at memory deps.
   if (!canVectorizeMemory()) {
     DEBUG(dbgs() << "LV: Can't vectorize due to memory conflicts\n");
@@ -2873,6 +3413,9 @@ bool LoopVectorizationLegality::canVectorize() {
   // Collect all of the variables that remain uniform after vectorization.
   collectLoopUniforms();
 
+  // Find the strided accesses that can be vectorized as wide accesses.
+  collectInterleaveGroups();
+
   DEBUG(dbgs() << "LV: We can vectorize this loop" <<
         (PtrRtCheck.Need ? " (with a runtime bound check)" : "")
         <<"!\n");
@@ -2901,7 +3444,8 @@ static Type* getWiderType(DataLayout &DL, Type *Ty0, Type *Ty1) {
 /// \brief Check that the instruction has outside loop users and is not an
 /// identified reduction variable.
 static bool hasOutsideLoopUser(const Loop *TheLoop, Instruction *Inst,
-                               SmallPtrSet<Value *, 4> &Reductions) {
+                               SmallPtrSet<Value *, 4> &Reductions,
+                               BasicBlock *EarlyExitingBlock) {
   // Reduction instructions are allowed to have exit users. All other
   // instructions must not have external users.
   if (!Reductions.count(Inst))
@@ -2909,6 +3453,11 @@ static bool hasOutsideLoopUser(const Loop *TheLoop, Instruction *Inst,
     for (Value::use_iterator I = Inst->use_begin(), E = Inst->use_end();
          I != E; ++I) {
       Instruction *U = cast<Instruction>(*I);
+      // Only the scalar loop branches to the early exit, so its LCSSA phis
+      // keep their values.
+      if (EarlyExitingBlock && isa<PHINode>(U) &&
+          U->getParent()->getSinglePredecessor() == EarlyExitingBlock)
+        continue;
       // This user may be a reduction exit value.
       if (!TheLoop->contains(U)) {
         DEBUG(dbgs() << "LV: Found an outside user for : " << *U << '\n');
@@ -2953,7 +3502,8 @@ bool LoopVectorizationLegality::canVectorizeInstrs() {
         if (*bb != Header) {
           // Check that this instruction has no outside users or is an
           // identified reduction value with an outside user.
-          if(!hasOutsideLoopUser(TheLoop, it, AllowedExit))
+          if(!hasOutsideLoopUser(TheLoop, it, AllowedExit,
+                                 EarlyExitingBlock))
             continue;
           return false;
         }
@@ -2990,7 +3540,7 @@ bool LoopVectorizationLegality::canVectorizeInstrs() {
 
           // Until we explicitly handle the case of an induction variable with
           // an outside loop user we have to give up vectorizing this loop.
-          if (hasOutsideLoopUser(TheLoop, it, AllowedExit))
+          if (hasOutsideLoopUser(TheLoop, it, AllowedExit, EarlyExitingBlock))
             return false;
 
           continue;
@@ -3063,7 +3613,7 @@ bool LoopVectorizationLegality::canVectorizeInstrs() {
 
       // Reduction instructions are allowed to have exit users.
       // All other instructions must not have external users.
-      if (hasOutsideLoopUser(TheLoop, it, AllowedExit))
+      if (hasOutsideLoopUser(TheLoop, it, AllowedExit, EarlyExitingBlock))
         return false;
 
     } // next instr.
@@ -3515,6 +4065,54 @@ static bool isInBoundsGep(Value *Ptr) {
   return false;
 }
 
+/// \brief Check whether the single variable index of the inbounds
+/// getelementptr \p Ptr is computed without overflow from an induction of
+/// \p Lp that does not wrap. Scalar evolution does not carry the no-wrap flags
+/// of the induction over to such indices, but the pointer cannot wrap either.
+static bool hasNoWrapGEPIndex(ScalarEvolution *SE, DataLayout *DL, Value *Ptr,
+                              const Loop *Lp) {
+  GetElementPtrInst *GEP = dyn_cast<GetElementPtrInst>(Ptr);
+  if (!GEP)
+    return false;
+
+  Value *Index = 0;
+  for (User::op_iterator I = GEP->idx_begin(), E = GEP->idx_end(); I != E; ++I)
+    if (!isa<ConstantInt>(*I)) {
+      if (Index)
+        return false;
+      Index = *I;
+    }
+
+  while (Index) {
+    const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Index));
+    if (AR && AR->getLoop() == Lp && AR->getNoWrapFlags(SCEV::FlagNSW))
+      return true;
+
+    // Look through sign extensions and through arithmetic with a constant
+    // that does not overflow. An or of bits that are known to be zero is
+    // such an add.
+    Instruction *I = dyn_cast<Instruction>(Index);
+    if (!I)
+      return false;
+    if (isa<SExtInst>(I)) {
+      Index = I->getOperand(0);
+      continue;
+    }
+    ConstantInt *C = I->getNumOperands() == 2 ?
+      dyn_cast<ConstantInt>(I->getOperand(1)) : 0;
+    if (!C)
+      return false;
+    OverflowingBinaryOperator *OBO = dyn_cast<OverflowingBinaryOperator>(I);
+    if ((OBO && OBO->hasNoSignedWrap()) ||
+        (I->getOpcode() == Instruction::Or &&
+         MaskedValueIsZero(I->getOperand(0), C->getValue(), DL)))
+      Index = I->getOperand(0);
+    else
+      return false;
+  }
+  return false;
+}
+
 /// \brief Check whether the access through \p Ptr has a constant stride.
 static int isStridedPtr(ScalarEvolution *SE, DataLayout *DL, Value *Ptr,
                         const Loop *Lp) {
@@ -3553,6 +4151,9 @@ static int isStridedPtr(ScalarEvolution *SE, DataLayout *DL, Value *Ptr,
   bool IsInBoundsGEP = isInBoundsGep(Ptr);
   bool IsNoWrapAddRec = AR->getNoWrapFlags(SCEV::NoWrapMask);
   bool IsInAddressSpaceZero = PtrTy->getAddressSpace() == 0;
+
+  if (!IsNoWrapAddRec && IsInBoundsGEP)
+    IsNoWrapAddRec = hasNoWrapGEPIndex(SE, DL, Ptr, Lp);
   if (!IsNoWrapAddRec && !IsInBoundsGEP && !IsInAddressSpaceZero) {
     DEBUG(dbgs() << "LV: Bad stride - Pointer may wrap in the address space "
           << *Ptr << " SCEV: " << *PtrScev << "\n");
@@ -3692,8 +4293,22 @@ bool MemoryDepChecker::isDependent(const MemAccessInfo &A, unsigned AIdx,
   Type *BTy = BPtr->getType()->getPointerElementType();
   unsigned TypeByteSize = DL->getTypeAllocSize(ATy);
 
-  // Negative distances are not plausible dependencies.
   const APInt &Val = C->getValue()->getValue();
+
+  // Accesses with the same stride of more than one element touch different
+  // fields of an array of structs, and so never the same element, unless
+  // their distance is a multiple of the stride.
+  unsigned Stride = std::abs(StrideAPtr);
+  if (Stride > 1 && ATy == BTy && Val.getMinSignedBits() <= 64) {
+    int64_t ElemDist = Val.getSExtValue() / (int64_t)TypeByteSize;
+    if (Val.getSExtValue() % (int64_t)TypeByteSize == 0 &&
+        ElemDist % (int64_t)Stride != 0) {
+      DEBUG(dbgs() << "LV: Accesses to different fields: NoDep\n");
+      return false;
+    }
+  }
+
+  // Negative distances are not plausible dependencies.
   if (Val.isNegative()) {
     bool IsTrueDataDependence = (AIsWrite && !BIsWrite);
     if (IsTrueDataDependence &&
@@ -3723,7 +4338,9 @@ bool MemoryDepChecker::isDependent(const MemAccessInfo &A, unsigned AIdx,
     return false;
   }
 
-  unsigned Distance = (unsigned) Val.getZExtValue();
+  // Strided accesses cover the distance in fewer iterations. Scale it to the
+  // distance of unit stride accesses.
+  unsigned Distance = (unsigned) Val.getZExtValue() / Stride;
 
   // Bail out early if passed-in parameters make vectorization not feasible.
   unsigned ForcedFactor = VectorizationFactor ? VectorizationFactor : 1;
@@ -4005,6 +4622,176 @@ bool LoopVectorizationLegality::canVectorizeMemory() {
   return CanVecMem;
 }
 
+/// \brief Returns the pointer operand of the load or store \p I.
+static Value *getPointerOperand(Instruction *I) {
+  if (LoadInst *LI = dyn_cast<LoadInst>(I))
+    return LI->getPointerOperand();
+  return cast<StoreInst>(I)->getPointerOperand();
+}
+
+void LoopVectorizationLegality::collectInterleaveGroups() {
+  if (!EnableInterleavedMemAccesses)
+    return;
+
+  for (Loop::block_iterator bb = TheLoop->block_begin(),
+       be = TheLoop->block_end(); bb != be; ++bb) {
+    // Accesses in predicated blocks do not happen in every iteration.
+    if (blockNeedsPredication(*bb))
+      continue;
+
+    // Collect the memory instructions of the block in program order, and the
+    // stride of the ones that could be members of a group.
+    SmallVector<Instruction *, 16> MemInsts;
+    SmallVector<int, 16> Strides;
+    for (BasicBlock::iterator it = (*bb)->begin(), e = (*bb)->end(); it != e;
+         ++it) {
+      if (!it->mayReadOrWriteMemory())
+        continue;
+      MemInsts.push_back(it);
+      Strides.push_back(0);
+
+      LoadInst *LI = dyn_cast<LoadInst>(it);
+      StoreInst *SI = dyn_cast<StoreInst>(it);
+      if (!(LI && LI->isSimple()) && !(SI && SI->isSimple()))
+        continue;
+      Value *Ptr = LI ? LI->getPointerOperand() : SI->getPointerOperand();
+      Type *Ty = LI ? LI->getType() : SI->getValueOperand()->getType();
+      if ((!Ty->isIntegerTy() && !Ty->isFloatingPointTy()) ||
+          DL->getTypeAllocSizeInBits(Ty) != Ty->getPrimitiveSizeInBits())
+        continue;
+      // Only the constant step matters here. Whether the pointer may wrap is
+      // up to the dependence checks.
+      const SCEVAddRecExpr *AR = dyn_cast<SCEVAddRecExpr>(SE->getSCEV(Ptr));
+      if (!AR || AR->getLoop() != TheLoop || !AR->isAffine())
+        continue;
+      const SCEVConstant *Step =
+          dyn_cast<SCEVConstant>(AR->getStepRecurrence(*SE));
+      if (!Step || Step->getValue()->getValue().getMinSignedBits() > 64)
+        continue;
+      int64_t StepVal = Step->getValue()->getSExtValue();
+      int64_t Size = DL->getTypeAllocSize(Ty);
+      if (StepVal % Size == 0 && StepVal / Size > 1 &&
+          StepVal / Size <= MaxInterleaveGroupFactor)
+        Strides.back() = StepVal / Size;
+    }
+
+    SmallPtrSet<Instruction *, 16> Grouped;
+    for (unsigned i = 0, e = MemInsts.size(); i != e; ++i) {
+      Instruction *Leader = MemInsts[i];
+      int Stride = Strides[i];
+      if (!Stride || Grouped.count(Leader))
+        continue;
+
+      bool IsLoad = isa<LoadInst>(Leader);
+      Type *Ty = IsLoad ? Leader->getType() :
+                          Leader->getOperand(0)->getType();
+      int64_t Size = DL->getTypeAllocSize(Ty);
+      const SCEV *LeaderPtr = SE->getSCEV(getPointerOperand(Leader));
+
+      // The members, in program order, and their field offsets from the
+      // leader.
+      SmallVector<Instruction *, 8> Members(1, Leader);
+      SmallVector<int64_t, 8> Offsets(1, (int64_t)0);
+      int64_t MinOffset = 0, MaxOffset = 0;
+      for (unsigned j = i + 1; j != e; ++j) {
+        Instruction *Other = MemInsts[j];
+        const SCEVConstant *Dist = 0;
+        if (Strides[j] == Stride && !Grouped.count(Other) &&
+            isa<LoadInst>(Other) == IsLoad &&
+            (IsLoad ? Other->getType() : Other->getOperand(0)->getType()) ==
+                Ty)
+          Dist = dyn_cast<SCEVConstant>(SE->getMinusSCEV(
+              SE->getSCEV(getPointerOperand(Other)), LeaderPtr));
+
+        int64_t Offset = 0;
+        bool Joins = false;
+        if (Dist && Dist->getValue()->getValue().getMinSignedBits() <= 64) {
+          int64_t ByteDist = Dist->getValue()->getSExtValue();
+          Offset = ByteDist / Size;
+          Joins = ByteDist % Size == 0 &&
+                  std::max(MaxOffset, Offset) - std::min(MinOffset, Offset) <
+                      Stride &&
+                  std::find(Offsets.begin(), Offsets.end(), Offset) ==
+                      Offsets.end();
+        }
+
+        if (Joins) {
+          Members.push_back(Other);
+          Offsets.push_back(Offset);
+          MinOffset = std::min(MinOffset, Offset);
+          MaxOffset = std::max(MaxOffset, Offset);
+          continue;
+        }
+
+        // The loads of a group move up to the first one, and the stores down
+        // to the last one. Stop at the first instruction they may not move
+        // across.
+        if (!IsLoad || Other->mayWriteToMemory())
+          break;
+      }
+
+      // A load group must access the first and the last field, so that the
+      // wide load does not read outside of the structs. A store group must
+      // write every field.
+      if ((IsLoad && MaxOffset - MinOffset != Stride - 1) ||
+          (!IsLoad && (int)Members.size() != Stride))
+        continue;
+
+      InterleaveGroup Group(Stride, 0);
+      for (unsigned m = 0, me = Members.size(); m != me; ++m) {
+        Group.Members[Offsets[m] - MinOffset] = Members[m];
+        InterleaveGroupMap[Members[m]] = InterleaveGroups.size();
+        Grouped.insert(Members[m]);
+      }
+      Group.InsertPos = IsLoad ? Members.front() : Members.back();
+
+      Instruction *First = Group.Members[0];
+      Group.Align = IsLoad ? cast<LoadInst>(First)->getAlignment() :
+                             cast<StoreInst>(First)->getAlignment();
+      if (!Group.Align)
+        Group.Align = DL->getABITypeAlignment(Ty);
+
+      DEBUG(dbgs() << "LV: Found an interleave group of factor " << Stride
+            << " with " << Members.size() << " members at "
+            << *Group.InsertPos << '\n');
+      InterleaveGroups.push_back(Group);
+    }
+  }
+
+  // Only the first lane of the pointer of a group is used, so the address
+  // computations that feed nothing but the pointers of the members stay
+  // scalar.
+  std::vector<Value *> Worklist;
+  for (unsigned i = 0, e = InterleaveGroups.size(); i != e; ++i) {
+    InterleaveGroup &Group = InterleaveGroups[i];
+    for (unsigned m = 0, me = Group.Members.size(); m != me; ++m)
+      if (Group.Members[m])
+        Worklist.push_back(getPointerOperand(Group.Members[m]));
+  }
+
+  while (Worklist.size()) {
+    Instruction *I = dyn_cast<Instruction>(Worklist.back());
+    Worklist.pop_back();
+    if (!I || !TheLoop->contains(I) || isa<PHINode>(I) ||
+        I->mayReadOrWriteMemory() || Uniforms.count(I))
+      continue;
+
+    bool OnlyAddresses = true;
+    for (Value::use_iterator UI = I->use_begin(), UE = I->use_end();
+         UI != UE && OnlyAddresses; ++UI) {
+      Instruction *U = cast<Instruction>(*UI);
+      OnlyAddresses = Uniforms.count(U) ||
+        (InterleaveGroupMap.count(U) &&
+         (isa<LoadInst>(U) || cast<StoreInst>(U)->getValueOperand() != I));
+    }
+    if (!OnlyAddresses)
+      continue;
+
+    Uniforms.insert(I);
+    Worklist.insert(Worklist.end(), I->op_begin(), I->op_end());
+  }
+}
+
 static bool hasMultipleUsesOf(Instruction *I,
                               SmallPtrSet<Instruction *, 8> &Insts) {
   unsigned NumUses = 0;
@@ -4344,15 +5131,29 @@ bool LoopVectorizationLegality::blockNeedsPredication(BasicBlock *BB)  {
 bool LoopVectorizationLegality::blockCanBePredicated(BasicBlock *BB,
                                             SmallPtrSet<Value *, 8>& SafePtrs) {
   for (BasicBlock::iterator it = BB->begin(), e = BB->end(); it != e; ++it) {
-    // We might be able to hoist the load.
+    // We might be able to hoist the load. Otherwise it has to be masked.
     if (it->mayReadFromMemory()) {
       LoadInst *LI = dyn_cast<LoadInst>(it);
-      if (!LI || !SafePtrs.count(LI->getPointerOperand()))
+      if (!LI)
         return false;
+      if (!SafePtrs.count(LI->getPointerOperand())) {
+        if (!EnableMaskedMemOps || !LI->isSimple() ||
+            !TTI->isLegalMaskedLoad(LI->getType()))
+          return false;
+        MaskedOp.insert(LI);
+      }
     }
 
-    // We don't predicate stores at the moment.
-    if (it->mayWriteToMemory() || it->mayThrow())
+    // Stores are predicated with a mask.
+    if (it->mayWriteToMemory()) {
+      StoreInst *SI = dyn_cast<StoreInst>(it);
+      if (!SI || !EnableMaskedMemOps || !SI->isSimple() ||
+          !TTI->isLegalMaskedStore(SI->getValueOperand()->getType()))
+        return false;
+      MaskedOp.insert(SI);
+    }
+
+    if (it->mayThrow())
       return false;
 
     // The instructions below can trap.
@@ -4887,6 +5688,29 @@ LoopVectorizationCostModel::getInstructionCost(Instruction *I, unsigned VF) {
       return TTI.getAddressComputationCost(VectorTy) +
         TTI.getMemoryOpCost(I->getOpcode(), VectorTy, Alignment, AS);
 
+    // An interleave group is costed as a whole at its insert position.
+    if (const InterleaveGroup *Group = Legal->getInterleaveGroup(I)) {
+      if (I != Group->InsertPos)
+        return 0;
+
+      SmallVector<unsigned, 8> Indices;
+      for (unsigned i = 0; i < Group->Factor; ++i)
+        if (Group->Members[i])
+          Indices.push_back(i);
+
+      Type *WideTy = VectorType::get(ValTy, VF * Group->Factor);
+      unsigned Cost = TTI.getAddressComputationCost(WideTy);
+      Cost += TTI.getInterleavedMemoryOpCost(I->getOpcode(), WideTy,
+                                             Group->Factor, Indices,
+                                             Group->Align, AS);
+      return Cost;
+    }
+
+    // Masked loads and stores of predicated blocks.
+    if (Legal->isMaskRequired(I))
+      return TTI.getAddressComputationCost(VectorTy) +
+        TTI.getMaskedMemoryOpCost(I->getOpcode(), VectorTy, Alignment, AS);
+
     // Scalarized loads/stores.
     int ConsecutiveStride = Legal->isConsecutivePtr(Ptr);
     bool Reverse = ConsecutiveStride < 0;
@@ -350,6 +350,11 @@ public:
   /// \returns true if the memory operations A and B are consecutive.
   bool isConsecutiveAccess(Value *A, Value *B);
 
+  /// \brief Split the operands of the commutative bundle \p VL into \p Left
+  /// and \p Right, swapping the operands of some lanes so that each side is
+  /// more likely to be vectorizable.
+  void reorderInputs(ArrayRef<Value *> VL, ValueList &Left, ValueList &Right);
+
   /// \brief Perform LICM and CSE on the newly generated gather sequences.
   void optimizeGatherSequence();
 private:
@@ -878,7 +883,7 @@ void BoUpSLP::buildTree_rec(ArrayRef<Value *> VL, unsigned Depth) {
       // have the same opcode.
       if (isa<BinaryOperator>(VL0) && VL0->isCommutative()) {
         ValueList Left, Right;
-        reorderInputsAccordingToOpcode(VL, Left, Right);
+        reorderInputs(VL, Left, Right);
         buildTree_rec(Left, Depth + 1);
         buildTree_rec(Right, Depth + 1);
         return;
@@ -1049,6 +1054,12 @@ bool BoUpSLP::isFullyVectorizableTinyTree() {
   DEBUG(dbgs() << "SLP: Check whether the tree with height " <<
         VectorizableTree.size() << " is fully vectorizable .\n");
 
+  // A single bundle is worth vectorizing when its users are replaced too,
+  // as the operations of a horizontal reduction or the insertelements of a
+  // vector are.
+  if (VectorizableTree.size() == 1)
+    return RdxOps && !VectorizableTree[0].NeedToGather;
+
   // We only handle trees of height 2.
   if (VectorizableTree.size() != 2)
     return false;
@@ -1178,6 +1189,29 @@ bool BoUpSLP::isConsecutiveAccess(Value *A, Value *B) {
   return X == PtrSCEVB;
 }
 
+void BoUpSLP::reorderInputs(ArrayRef<Value *> VL, ValueList &Left,
+                            ValueList &Right) {
+  reorderInputsAccordingToOpcode(VL, Left, Right);
+
+  // Sorting by opcode leaves loads from two arrays alone, but they may be
+  // mixed up between the sides, as in a[0]*b[0] + b[1]*a[1]. Swap the
+  // operands of a lane if that continues a run of consecutive loads from the
+  // lane before it on both sides.
+  for (unsigned i = 1, e = VL.size(); i < e; ++i) {
+    LoadInst *PrevL = dyn_cast<LoadInst>(Left[i - 1]);
+    LoadInst *PrevR = dyn_cast<LoadInst>(Right[i - 1]);
+    if (!PrevL || !PrevR || !isa<LoadInst>(Left[i]) ||
+        !isa<LoadInst>(Right[i]))
+      continue;
+    if (isConsecutiveAccess(PrevL, Left[i]) ||
+        isConsecutiveAccess(PrevR, Right[i]))
+      continue;
+    if (isConsecutiveAccess(PrevL, Right[i]) &&
+        isConsecutiveAccess(PrevR, Left[i]))
+      std::swap(Left[i], Right[i]);
+  }
+}
+
 Value *BoUpSLP::getSinkBarrier(Instruction *Src, Instruction *Dst) {
   assert(Src->getParent() == Dst->getParent() && "Not the same BB");
   BasicBlock::iterator I = Src, E = Dst;
@@ -1456,7 +1490,7 @@ Value *BoUpSLP::vectorizeTree(TreeEntry *E) {
     case Instruction::Xor: {
       ValueList LHSVL, RHSVL;
       if (isa<BinaryOperator>(VL0) && VL0->isCommutative())
-        reorderInputsAccordingToOpcode(E->Scalars, LHSVL, RHSVL);
+        reorderInputs(E->Scalars, LHSVL, RHSVL);
       else
         for (int i = 0, e = E->Scalars.size(); i < e; ++i) {
           LHSVL.push_back(cast<Instruction>(E->Scalars[i])->getOperand(0));
@@ -1810,9 +1844,13 @@ private:
   /// \brief Try to vectorize a chain that starts at two arithmetic instrs.
   bool tryToVectorizePair(Value *A, Value *B, BoUpSLP &R);
 
-  /// \brief Try to vectorize a list of operands.
+  /// \brief Try to vectorize a list of operands. If \p BuildVector is not
+  /// empty, it holds the insertelement instructions that put the operands
+  /// into a vector, and they are rewritten to take the lanes of the
+  /// vectorized operands instead.
   /// \returns true if a value was vectorized.
-  bool tryToVectorizeList(ArrayRef<Value *> VL, BoUpSLP &R);
+  bool tryToVectorizeList(ArrayRef<Value *> VL, BoUpSLP &R,
+                          ArrayRef<Value *> BuildVector = None);
 
   /// \brief Try to vectorize a chain that may start at the operands of \V;
   bool tryToVectorize(BinaryOperator *V, BoUpSLP &R);
@@ -1962,7 +2000,8 @@ bool SLPVectorizer::tryToVectorizePair(Value *A, Value *B, BoUpSLP &R) {
   return tryToVectorizeList(VL, R);
 }
 
-bool SLPVectorizer::tryToVectorizeList(ArrayRef<Value *> VL, BoUpSLP &R) {
+bool SLPVectorizer::tryToVectorizeList(ArrayRef<Value *> VL, BoUpSLP &R,
+                                       ArrayRef<Value *> BuildVector) {
   if (VL.size() < 2)
     return false;
 
@@ -2003,14 +2042,45 @@ bool SLPVectorizer::tryToVectorizeList(ArrayRef<Value *> VL, BoUpSLP &R) {
 
     DEBUG(dbgs() << "SLP: Analyzing " << OpsWidth << " operations " << "\n");
     ArrayRef<Value *> Ops = VL.slice(i, OpsWidth);
-      
-    R.buildTree(Ops);
+
+    // The insertelements that build a vector from the operands are replaced
+    // by the vectorized operands, so they need no extracts.
+    ArrayRef<Value *> BuildVectorSlice;
+    BoUpSLP::ValueSet BuildVectorUsers;
+    if (!BuildVector.empty()) {
+      BuildVectorSlice = BuildVector.slice(i, OpsWidth);
+      BuildVectorUsers.insert(BuildVectorSlice.begin(),
+                              BuildVectorSlice.end());
+    }
+
+    R.buildTree(Ops, BuildVector.empty() ? 0 : &BuildVectorUsers);
     int Cost = R.getTreeCost();
        
     if (Cost < -SLPCostThreshold) {
       DEBUG(dbgs() << "SLP: Vectorizing pair at cost:" << Cost << ".\n");
-      R.vectorizeTree();
-        
+      Value *VectorizedRoot = R.vectorizeTree();
+
+      // Rebuild the vector from the lanes of the vectorized root, after the
+      // last of the insertelements so that the root is available. The
+      // extracts and inserts fold away when the vectors match.
+      if (!BuildVectorSlice.empty()) {
+        Instruction *InsertAfter = cast<Instruction>(BuildVectorSlice.back());
+        for (unsigned Lane = 0; Lane != OpsWidth; ++Lane) {
+          InsertElementInst *IE =
+              cast<InsertElementInst>(BuildVectorSlice[Lane]);
+          IRBuilder<> Builder(InsertAfter->getParent(),
+                              llvm::next(BasicBlock::iterator(InsertAfter)));
+          Value *Extract = Builder.CreateExtractElement(
+              VectorizedRoot, Builder.getInt32(Lane));
+          if (Instruction *ExtractInst = dyn_cast<Instruction>(Extract))
+            InsertAfter = ExtractInst;
+          IE->setOperand(1, Extract);
+          IE->removeFromParent();
+          IE->insertAfter(InsertAfter);
+          InsertAfter = IE;
+        }
+      }
+
       // Move to the next bundle.
       i += VF - 1;
       Changed = true;
@@ -2091,10 +2161,42 @@ static Value *createRdxShuffleMask(unsigned VecLen, unsigned NumEltsToRdx,
 }
 
 
+/// \returns the canonical strict predicate of the compare if \p V is an
+/// integer min or max of two values, as in "a < b ? a : b", or
+/// BAD_ICMP_PREDICATE otherwise.
+static CmpInst::Predicate getMinMaxPredicate(Value *V) {
+  SelectInst *SI = dyn_cast<SelectInst>(V);
+  if (!SI)
+    return CmpInst::BAD_ICMP_PREDICATE;
+  ICmpInst *Cmp = dyn_cast<ICmpInst>(SI->getCondition());
+  if (!Cmp || !Cmp->hasOneUse() || Cmp->getParent() != SI->getParent() ||
+      Cmp->getOperand(0) != SI->getTrueValue() ||
+      Cmp->getOperand(1) != SI->getFalseValue())
+    return CmpInst::BAD_ICMP_PREDICATE;
+
+  switch (Cmp->getPredicate()) {
+  case CmpInst::ICMP_SLT:
+  case CmpInst::ICMP_SLE:
+    return CmpInst::ICMP_SLT;
+  case CmpInst::ICMP_SGT:
+  case CmpInst::ICMP_SGE:
+    return CmpInst::ICMP_SGT;
+  case CmpInst::ICMP_ULT:
+  case CmpInst::ICMP_ULE:
+    return CmpInst::ICMP_ULT;
+  case CmpInst::ICMP_UGT:
+  case CmpInst::ICMP_UGE:
+    return CmpInst::ICMP_UGT;
+  default:
+    return CmpInst::BAD_ICMP_PREDICATE;
+  }
+}
+
 /// Model horizontal reductions.
 ///
-/// A horizontal reduction is a tree of reduction operations (currently add and
-/// fadd) that has operations that can be put into a vector as its leaf.
+/// A horizontal reduction is a tree of reduction operations (currently add,
+/// fadd, and integer min and max) that has operations that can be put into a
+/// vector as its leaf.
 /// For example, this tree:
 ///
 /// mul mul mul mul
@@ -2118,15 +2220,20 @@ static Value *createRdxShuffleMask(unsigned VecLen, unsigned NumEltsToRdx,
 ///     |
 ///   *p =
 ///
+/// The operations of a min or max reduction are selects of the smaller or
+/// larger of the two values that they compare. Such reductions do not start
+/// at a phi.
 class HorizontalReduction {
   SmallPtrSet<Value *, 16> ReductionOps;
   SmallVector<Value *, 32> ReducedVals;
 
-  BinaryOperator *ReductionRoot;
+  Instruction *ReductionRoot;
   PHINode *ReductionPHI;
 
-  /// The opcode of the reduction.
+  /// The opcode of the reduction, Select for a min or max reduction.
   unsigned ReductionOpcode;
+  /// The predicate of the compares of a min or max reduction.
+  CmpInst::Predicate MinMaxPred;
   /// The opcode of the values we perform a reduction on.
   unsigned ReducedValueOpcode;
   /// The width of one full horizontal reduction operation.
@@ -2138,10 +2245,38 @@ class HorizontalReduction {
 public:
   HorizontalReduction()
     : ReductionRoot(0), ReductionPHI(0), ReductionOpcode(0),
-    ReducedValueOpcode(0), ReduxWidth(0), IsPairwiseReduction(false) {}
+    MinMaxPred(CmpInst::BAD_ICMP_PREDICATE), ReducedValueOpcode(0),
+    ReduxWidth(0), IsPairwiseReduction(false) {}
+
+  /// \returns true if \p I is a reduction operation whose value is not
+  /// reduced any further in its block, so that a reduction tree may end in
+  /// it.
+  static bool isReductionRoot(Instruction *I) {
+    unsigned Opcode = I->getOpcode();
+    CmpInst::Predicate Pred = getMinMaxPredicate(I);
+    if (Pred == CmpInst::BAD_ICMP_PREDICATE &&
+        ((Opcode != Instruction::Add && Opcode != Instruction::FAdd) ||
+         !I->isAssociative()))
+      return false;
+
+    // An operation whose only user continues the reduction is an inner
+    // node of a larger tree. For a min or max, the user is the compare and
+    // the select of the next operation.
+    unsigned NumUses = Pred == CmpInst::BAD_ICMP_PREDICATE ? 1 : 2;
+    if (!I->hasNUses(NumUses))
+      return true;
+    Instruction *User = cast<Instruction>(I->use_back());
+    if (isa<CmpInst>(User) && User->hasOneUse())
+      User = cast<Instruction>(User->use_back());
+    if (User->getParent() != I->getParent())
+      return true;
+    if (Pred != CmpInst::BAD_ICMP_PREDICATE)
+      return getMinMaxPredicate(User) != Pred;
+    return User->getOpcode() != Opcode;
+  }
 
   /// \brief Try to find a reduction tree.
-  bool matchAssociativeReduction(PHINode *Phi, BinaryOperator *B,
+  bool matchAssociativeReduction(PHINode *Phi, Instruction *B,
                                  DataLayout *DL) {
     assert((!Phi ||
             std::find(Phi->op_begin(), Phi->op_end(), B) != Phi->op_end()) &&
@@ -2176,27 +2311,35 @@ public:
     if (ReduxWidth < 4)
       return false;
 
-    // We currently only support adds.
-    if (ReductionOpcode != Instruction::Add &&
-        ReductionOpcode != Instruction::FAdd)
+    // We currently only support adds, and min and max without a phi.
+    if (ReductionOpcode == Instruction::Select) {
+      MinMaxPred = getMinMaxPredicate(B);
+      if (MinMaxPred == CmpInst::BAD_ICMP_PREDICATE || Phi)
+        return false;
+    } else if (ReductionOpcode != Instruction::Add &&
+               ReductionOpcode != Instruction::FAdd)
       return false;
 
+    // The operands of a min or max are the values that it selects from.
+    unsigned FirstOperand = isMinMax() ? 1 : 0;
+    unsigned NumUses = isMinMax() ? 2 : 1;
+
     // Post order traverse the reduction tree starting at B. We only handle true
-    // trees containing only binary operators.
-    SmallVector<std::pair<BinaryOperator *, unsigned>, 32> Stack;
+    // trees.
+    SmallVector<std::pair<Instruction *, unsigned>, 32> Stack;
     Stack.push_back(std::make_pair(B, 0));
     while (!Stack.empty()) {
-      BinaryOperator *TreeN = Stack.back().first;
+      Instruction *TreeN = Stack.back().first;
       unsigned EdgeToVist = Stack.back().second++;
-      bool IsReducedValue = TreeN->getOpcode() != ReductionOpcode;
+      bool IsReducedValue = !isReductionOperation(TreeN);
 
       // Only handle trees in the current basic block.
       if (TreeN->getParent() != B->getParent())
         return false;
 
-      // Each tree node needs to have one user except for the ultimate
-      // reduction.
-      if (!TreeN->hasOneUse() && TreeN != B)
+      // Each tree node needs to be used only by its parent except for the
+      // ultimate reduction.
+      if (!TreeN->hasNUses(NumUses) && TreeN != B)
         return false;
 
       // Postorder vist.
@@ -2211,9 +2354,11 @@ public:
           ReducedVals.push_back(TreeN);
         } else {
           // We need to be able to reassociate the adds.
-          if (!TreeN->isAssociative())
+          if (!isMinMax() && !TreeN->isAssociative())
             return false;
           ReductionOps.insert(TreeN);
+          if (isMinMax())
+            ReductionOps.insert(cast<SelectInst>(TreeN)->getCondition());
         }
         // Retract.
         Stack.pop_back();
@@ -2221,8 +2366,8 @@ public:
       }
 
       // Visit left or right.
-      Value *NextV = TreeN->getOperand(EdgeToVist);
-      BinaryOperator *Next = dyn_cast<BinaryOperator>(NextV);
+      Value *NextV = TreeN->getOperand(FirstOperand + EdgeToVist);
+      Instruction *Next = dyn_cast<Instruction>(NextV);
       if (Next)
         Stack.push_back(std::make_pair(Next, 0));
       else if (NextV != Phi)
@@ -2268,8 +2413,8 @@ public:
       Value *ReducedSubTree = emitReduction(VectorizedRoot, Builder);
       if (VectorizedTree) {
         Builder.SetCurrentDebugLocation(Loc);
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedSubTree, "bin.rdx");
+        VectorizedTree = createOp(Builder, VectorizedTree, ReducedSubTree,
+                                  "bin.rdx");
       } else
         VectorizedTree = ReducedSubTree;
     }
@@ -2279,8 +2424,7 @@ public:
       for (; i < NumReducedVals; ++i) {
         Builder.SetCurrentDebugLocation(
           cast<Instruction>(ReducedVals[i])->getDebugLoc());
-        VectorizedTree = createBinOp(Builder, ReductionOpcode, VectorizedTree,
-                                     ReducedVals[i]);
+        VectorizedTree = createOp(Builder, VectorizedTree, ReducedVals[i]);
       }
       // Update users.
       if (ReductionPHI) {
@@ -2295,8 +2439,21 @@ public:
 
 private:
 
+  bool isMinMax() const { return ReductionOpcode == Instruction::Select; }
+
+  /// \returns true if \p I is an operation of this reduction rather than a
+  /// reduced value.
+  bool isReductionOperation(Instruction *I) const {
+    if (isMinMax())
+      return getMinMaxPredicate(I) == MinMaxPred;
+    return I->getOpcode() == ReductionOpcode;
+  }
+
   /// \brief Calcuate the cost of a reduction.
   int getReductionCost(TargetTransformInfo *TTI, Value *FirstReducedVal) {
+    if (isMinMax())
+      return getMinMaxReductionCost(TTI, FirstReducedVal);
+
     Type *ScalarTy = FirstReducedVal->getType();
     Type *VecTy = VectorType::get(ScalarTy, ReduxWidth);
 
@@ -2318,6 +2475,36 @@ private:
     return VecReduxCost - ScalarReduxCost;
   }
 
+  /// \brief Calculate the cost of a min or max reduction, which halves the
+  /// vector with a shuffle, a compare and a select at each level.
+  int getMinMaxReductionCost(TargetTransformInfo *TTI,
+                             Value *FirstReducedVal) {
+    Type *ScalarTy = FirstReducedVal->getType();
+    Type *VecTy = VectorType::get(ScalarTy, ReduxWidth);
+    Type *CondTy = CmpInst::makeCmpResultType(VecTy);
+    Type *ScalarCondTy = CmpInst::makeCmpResultType(ScalarTy);
+    IsPairwiseReduction = false;
+
+    int LevelCost =
+        TTI->getShuffleCost(TargetTransformInfo::SK_ExtractSubvector, VecTy,
+                            ReduxWidth / 2, VecTy) +
+        TTI->getCmpSelInstrCost(Instruction::ICmp, VecTy) +
+        TTI->getCmpSelInstrCost(Instruction::Select, VecTy, CondTy);
+    int VecReduxCost = Log2_32(ReduxWidth) * LevelCost +
+        TTI->getVectorInstrCost(Instruction::ExtractElement, VecTy, 0);
+
+    int ScalarReduxCost = ReduxWidth *
+        (TTI->getCmpSelInstrCost(Instruction::ICmp, ScalarTy) +
+         TTI->getCmpSelInstrCost(Instruction::Select, ScalarTy,
+                                 ScalarCondTy));
+
+    DEBUG(dbgs() << "SLP: Adding cost " << VecReduxCost - ScalarReduxCost
+                 << " for min/max reduction that starts with "
+                 << *FirstReducedVal << "\n");
+
+    return VecReduxCost - ScalarReduxCost;
+  }
+
   static Value *createBinOp(IRBuilder<> &Builder, unsigned Opcode, Value *L,
                             Value *R, const Twine &Name = "") {
     if (Opcode == Instruction::FAdd)
@@ -2325,6 +2512,15 @@ private:
     return Builder.CreateBinOp((Instruction::BinaryOps)Opcode, L, R, Name);
   }
 
+  /// \brief Emit one reduction operation of \p L and \p R.
+  Value *createOp(IRBuilder<> &Builder, Value *L, Value *R,
+                  const Twine &Name = "") {
+    if (!isMinMax())
+      return createBinOp(Builder, ReductionOpcode, L, R, Name);
+    Value *Cmp = Builder.CreateICmp(MinMaxPred, L, R);
+    return Builder.CreateSelect(Cmp, L, R, Name);
+  }
+
   /// \brief Emit a horizontal reduction of the vectorized value.
   Value *emitReduction(Value *VectorizedValue, IRBuilder<> &Builder) {
     assert(VectorizedValue && "Need to have a vectorized tree node");
@@ -2345,14 +2541,13 @@ private:
         Value *RightShuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), (RightMask),
           "rdx.shuf.r");
-        TmpVec = createBinOp(Builder, ReductionOpcode, LeftShuf, RightShuf,
-                             "bin.rdx");
+        TmpVec = createOp(Builder, LeftShuf, RightShuf, "bin.rdx");
       } else {
         Value *UpperHalf =
           createRdxShuffleMask(ReduxWidth, i, false, false, Builder);
         Value *Shuf = Builder.CreateShuffleVector(
           TmpVec, UndefValue::get(TmpVec->getType()), UpperHalf, "rdx.shuf");
-        TmpVec = createBinOp(Builder, ReductionOpcode, TmpVec, Shuf, "bin.rdx");
+        TmpVec = createOp(Builder, TmpVec, Shuf, "bin.rdx");
       }
     }
 
@@ -2370,11 +2565,13 @@ private:
 /// Returns true if it matches
 ///
 static bool findBuildVector(InsertElementInst *IE,
+                            SmallVectorImpl<Value *> &BuildVector,
                             SmallVectorImpl<Value *> &Ops) {
   if (!isa<UndefValue>(IE->getOperand(0)))
     return false;
 
   while (true) {
+    BuildVector.push_back(IE);
     Ops.push_back(IE->getOperand(1));
 
     if (IE->use_empty())
@@ -2503,6 +2700,19 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
       continue;
     }
 
+    // Try to vectorize horizontal reductions that end in this instruction,
+    // such as a sum or a maximum that is returned or inserted into a vector.
+    if (ShouldVectorizeHor && HorizontalReduction::isReductionRoot(it)) {
+      HorizontalReduction HorRdx;
+      if (HorRdx.matchAssociativeReduction(0, it, DL) &&
+          HorRdx.tryToReduce(R, TTI)) {
+        Changed = true;
+        it = BB->begin();
+        e = BB->end();
+        continue;
+      }
+    }
+
     // Try to vectorize horizontal reductions feeding into a store.
     if (ShouldStartVectorizeHorAtStore)
       if (StoreInst *SI = dyn_cast<StoreInst>(it))
@@ -2546,11 +2756,11 @@ bool SLPVectorizer::vectorizeChainsInBlock(BasicBlock *BB, BoUpSLP &R) {
 
     // Try to vectorize trees that start at insertelement instructions.
     if (InsertElementInst *IE = dyn_cast<InsertElementInst>(it)) {
-      SmallVector<Value *, 8> Ops;
-      if (!findBuildVector(IE, Ops))
+      SmallVector<Value *, 8> BuildVector, Ops;
+      if (!findBuildVector(IE, BuildVector, Ops))
         continue;
 
-      if (tryToVectorizeList(Ops, R)) {
+      if (tryToVectorizeList(Ops, R, BuildVector)) {
         Changed = true;
         it = BB->begin();
         e = BB->end();
@@ -0,0 +1,90 @@
+; RUN: opt -basicaa -print-memoryssa -analyze < %s | FileCheck %s
+
+declare void @clobber()
+declare i32 @readonly_fn(i32*) readonly
+
+; Stores define memory, loads and readonly calls use it, and a phi merges the
+; definitions of the two sides of the diamond.
+
+; CHECK-LABEL: define i32 @diamond(
+define i32 @diamond(i32* %p, i32* %q, i1 %c) {
+entry:
+; CHECK: ; 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 1, i32* %p
+  store i32 1, i32* %p
+  br i1 %c, label %left, label %right
+
+left:
+; CHECK: ; 2 = MemoryDef(1)
+; CHECK-NEXT: store i32 2, i32* %q
+  store i32 2, i32* %q
+  br label %join
+
+right:
+; CHECK: ; MemoryUse(1)
+; CHECK-NEXT: %v = load i32* %q
+  %v = load i32* %q
+; CHECK: ; MemoryUse(1)
+; CHECK-NEXT: %r = call i32 @readonly_fn(i32* %p)
+  %r = call i32 @readonly_fn(i32* %p)
+  br label %join
+
+join:
+; CHECK: ; 3 = MemoryPhi({%left,2},{%right,1})
+; CHECK: ; MemoryUse(3)
+; CHECK-NEXT: %w = load i32* %p
+  %w = load i32* %p
+  ret i32 %w
+}
+
+; The loop header merges the definition on entry with the one in the latch.
+
+; CHECK-LABEL: define void @loop(
+define void @loop(i32* %p, i32 %n) {
+entry:
+  br label %header
+
+header:
+; CHECK: ; 1 = MemoryPhi({%entry,liveOnEntry},{%header,2})
+  %i = phi i32 [ 0, %entry ], [ %i.next, %header ]
+; CHECK: ; MemoryUse(1)
+; CHECK-NEXT: %x = load i32* %p
+  %x = load i32* %p
+; CHECK: ; 2 = MemoryDef(1)
+; CHECK-NEXT: call void @clobber()
+  call void @clobber()
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %header
+
+exit:
+; CHECK: ; MemoryUse(2)
+; CHECK-NEXT: %y = load i32* %p
+  %y = load i32* %p
+  ret void
+}
+
+; Volatile loads and fences define memory; blocks without any definition get
+; no phi.
+
+; CHECK-LABEL: define void @ordered(
+define void @ordered(i32* %p, i1 %c) {
+entry:
+; CHECK: ; 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: %a = load volatile i32* %p
+  %a = load volatile i32* %p
+  br i1 %c, label %then, label %end
+
+then:
+; CHECK: ; MemoryUse(1)
+; CHECK-NEXT: %b = load i32* %p
+  %b = load i32* %p
+  br label %end
+
+end:
+; CHECK-NOT: MemoryPhi
+; CHECK: ; 2 = MemoryDef(1)
+; CHECK-NEXT: fence seq_cst
+  fence seq_cst
+  ret void
+}
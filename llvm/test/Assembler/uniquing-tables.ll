@@ -0,0 +1,31 @@
+; RUN: llvm-as < %s | llvm-dis | FileCheck %s
+; RUN: opt -stats -disable-output < %s 2>&1 | FileCheck --check-prefix=STATS %s
+; REQUIRES: asserts
+
+; The forward references are resolved by replacing the placeholders in the
+; aggregates that use them, which moves those aggregates within the uniquing
+; tables.
+
+; CHECK: @a = global [2 x i32*] [i32* @x, i32* @y]
+; CHECK: @b = global { i32*, i8 } { i32* @y, i8 2 }
+; CHECK: @c = global [2 x i32*] [i32* @x, i32* @y]
+; CHECK: @d = global <2 x double> <double 1.500000e+00, double 2.500000e+00>
+; CHECK: @e = global i128 170141183460469231731687303715884105727
+@a = global [2 x i32*] [i32* @x, i32* @y]
+@b = global { i32*, i8 } { i32* @y, i8 2 }
+@c = global [2 x i32*] [i32* @x, i32* @y]
+@d = global <2 x double> <double 1.5, double 2.5>
+@e = global i128 170141183460469231731687303715884105727
+@x = global i32 1
+@y = global i32 2
+
+; CHECK: declare void @f(i32, i8)
+; CHECK: declare { i32, i8 } @g({ i32, i8 })
+declare void @f(i32, i8)
+declare {i32, i8} @g({i32, i8})
+
+; STATS-DAG: ir - Longest probe sequence of a uniquing table lookup
+; STATS-DAG: ir - Number of buckets in the uniquing tables
+; STATS-DAG: ir - Number of buckets probed by uniquing table lookups
+; STATS-DAG: ir - Number of entries in the uniquing tables
+; STATS-DAG: ir - Number of lookups in the uniquing tables
@@ -0,0 +1,79 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux | FileCheck %s
+
+; A block that runs less than once per call according to the profile is moved
+; after the rest of the function, even out of the middle of a loop.
+
+declare void @report(i32)
+
+; CHECK-LABEL: f:
+; CHECK: %loop
+; CHECK: %latch
+; CHECK: %exit
+; CHECK: ret
+; CHECK: %fixup
+; CHECK: callq report
+define i32 @f(i32* %p, i32 %n) #0 {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %addr = getelementptr i32* %p, i32 %i
+  %v = load i32* %addr
+  %bad = icmp slt i32 %v, 0
+  br i1 %bad, label %fixup, label %latch, !prof !0
+
+fixup:
+  call void @report(i32 %v)
+  br label %latch
+
+latch:
+  %w = phi i32 [ 0, %fixup ], [ %v, %loop ]
+  %s.next = add i32 %s, %w
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !1
+
+exit:
+  ret i32 %s.next
+}
+
+; Without an entry count the cold block stays in the loop.
+; CHECK-LABEL: g:
+; CHECK: %fixup
+; CHECK: callq report
+; CHECK: %loop
+; CHECK: %latch
+; CHECK: ret
+define i32 @g(i32* %p, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %addr = getelementptr i32* %p, i32 %i
+  %v = load i32* %addr
+  %bad = icmp slt i32 %v, 0
+  br i1 %bad, label %fixup, label %latch, !prof !0
+
+fixup:
+  call void @report(i32 %v)
+  br label %latch
+
+latch:
+  %w = phi i32 [ 0, %fixup ], [ %v, %loop ]
+  %s.next = add i32 %s, %w
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !1
+
+exit:
+  ret i32 %s.next
+}
+
+attributes #0 = { "pgo-entry-count"="100" }
+
+!0 = metadata !{metadata !"branch_weights", i32 0, i32 100000}
+!1 = metadata !{metadata !"branch_weights", i32 100, i32 100000}
@@ -0,0 +1,22 @@
+; REQUIRES: asserts
+; RUN: llc < %s -mtriple=x86_64-unknown-unknown -stats 2>&1 | FileCheck %s
+
+; Each fold of an identity operation re-adds the users of the folded node.
+; A node that is already queued must be moved to the end of the worklist
+; rather than queued a second time.
+
+; CHECK: 3 dagcombine - Number of dag nodes combined
+; CHECK: 3 dagcombine - Number of queued nodes moved to the worklist end
+
+define i32 @f(i32 %a, i32 %b, i32 %c) nounwind {
+entry:
+  %x = add i32 %a, 0
+  %y = mul i32 %x, 1
+  %z = add i32 %y, %b
+  %s = shl i32 %z, 0
+  %t = or i32 %s, 0
+  %u = add i32 %t, %z
+  %v = xor i32 %u, 0
+  %w = sub i32 %v, %c
+  ret i32 %w
+}
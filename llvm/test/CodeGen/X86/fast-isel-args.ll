@@ -23,3 +23,40 @@ entry:
   %add2 = add nsw i64 %add, %conv1
   ret i64 %add2
 }
+
+define i32 @t4(i1 %a, i8 signext %b, i16 zeroext %c, float %d, double %e) {
+entry:
+  %conv = zext i1 %a to i32
+  %conv1 = sext i8 %b to i32
+  %conv2 = zext i16 %c to i32
+  %conv3 = fptosi float %d to i32
+  %conv4 = fptosi double %e to i32
+  %add = add nsw i32 %conv, %conv1
+  %add1 = add nsw i32 %add, %conv2
+  %add2 = add nsw i32 %add1, %conv3
+  %add3 = add nsw i32 %add2, %conv4
+  ret i32 %add3
+}
+
+define i64 @t5(i64 %a, i64 %b, i64 %c, i64 %d, i64 %e, i64 %f, i64 %g, i8 %h) {
+entry:
+  %conv = sext i8 %h to i64
+  %add = add nsw i64 %g, %conv
+  ret i64 %add
+}
+
+define <4 x float> @t6(<4 x float> %a, <2 x double> %b) {
+entry:
+  %conv = bitcast <2 x double> %b to <4 x float>
+  %add = fadd <4 x float> %a, %conv
+  ret <4 x float> %add
+}
+
+%struct.s = type { i64, i64, i64 }
+
+define i64 @t7(i32 %a, %struct.s* byval align 8 %b) {
+entry:
+  %p = getelementptr inbounds %struct.s* %b, i64 0, i32 2
+  %v = load i64* %p, align 8
+  ret i64 %v
+}
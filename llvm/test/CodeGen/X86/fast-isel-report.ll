@@ -0,0 +1,35 @@
+; RUN: llc < %s -O0 -mtriple=x86_64-apple-darwin10 -mcpu=x86-64 -fast-isel-report -o /dev/null 2>&1 | FileCheck %s
+
+; FastISel selects each block bottom up. The report charges the instructions
+; left to SelectionDAG to the one it missed, and a call it missed to itself.
+
+; CHECK: FastISel fallback report
+; CHECK: 8 instructions selected by FastISel
+; CHECK: 3 instructions left to SelectionDAG (27.3%)
+; CHECK: 2 blocks selected entirely by FastISel
+; CHECK: 2 blocks selected using SelectionDAG
+; CHECK: Misses  DAG insts  Instruction
+; CHECK-NEXT: 1 2 shufflevector
+; CHECK-NEXT: 1 1 call asm
+
+define <4 x i32> @shuffle(<4 x i32> %a, <4 x i32>* %p, i32 %b, i32* %q) {
+  %c = add i32 %b, 1
+  %s = shufflevector <4 x i32> %a, <4 x i32> undef, <4 x i32> <i32 3, i32 2, i32 1, i32 0>
+  store <4 x i32> %s, <4 x i32>* %p
+  store i32 %c, i32* %q
+  ret <4 x i32> %s
+}
+
+define i32 @asm(i32 %a) {
+entry:
+  %b = add i32 %a, 1
+  br label %next
+next:
+  %c = call i32 asm "bswap $0", "=r,0"(i32 %b)
+  ret i32 %c
+}
+
+define i32 @simple(i32 %a, i32 %b) {
+  %c = add i32 %a, %b
+  ret i32 %c
+}
@@ -0,0 +1,59 @@
+; RUN: llc < %s -O0 -fast-isel-abort -verify-machineinstrs -mtriple=x86_64-apple-darwin10 -mcpu=x86-64 | FileCheck %s
+; RUN: llc < %s -O0 -fast-isel-abort -verify-machineinstrs -mtriple=x86_64-apple-darwin10 -mcpu=corei7-avx | FileCheck %s --check-prefix=AVX
+
+; Integer selects are cmovs on the flags of a compare in the same block.
+define i32 @select_cmp_i32(i32 %a, i32 %b, i32 %x, i32 %y) {
+  %c = icmp slt i32 %a, %b
+  %r = select i1 %c, i32 %x, i32 %y
+  ret i32 %r
+; CHECK-LABEL: select_cmp_i32:
+; CHECK: cmpl %esi, %edi
+; CHECK-NEXT: cmovll %edx, %ecx
+}
+
+define i64 @select_fcmp_i64(double %a, double %b, i64 %x, i64 %y) {
+  %c = fcmp ugt double %a, %b
+  %r = select i1 %c, i64 %x, i64 %y
+  ret i64 %r
+; CHECK-LABEL: select_fcmp_i64:
+; CHECK: ucomisd %xmm0, %xmm1
+; CHECK-NEXT: cmovbq %rdi, %rsi
+}
+
+; Other conditions are tested, and i8 values are selected in 32-bit registers.
+define i8 @select_i8(i1 %c, i8 %x, i8 %y) {
+  %r = select i1 %c, i8 %x, i8 %y
+  ret i8 %r
+; CHECK-LABEL: select_i8:
+; CHECK: testb $1,
+; CHECK-NEXT: cmovnel
+}
+
+; Floating point selects blend the operands with a mask.
+define double @select_fcmp_f64(double %a, double %b, double %x, double %y) {
+  %c = fcmp ogt double %a, %b
+  %r = select i1 %c, double %x, double %y
+  ret double %r
+; CHECK-LABEL: select_fcmp_f64:
+; CHECK: cmpltsd %xmm0, %xmm1
+; CHECK: andpd %xmm2,
+; CHECK: andnpd %xmm3, %xmm1
+; CHECK: orpd
+; AVX-LABEL: select_fcmp_f64:
+; AVX: vcmpltsd %xmm0, %xmm1, [[MASK:%xmm[0-9]+]]
+; AVX: vandpd %xmm2, [[MASK]],
+; AVX: vandnpd %xmm3, [[MASK]],
+; AVX: vorpd
+}
+
+define float @select_f32(i1 %c, float %x, float %y) {
+  %r = select i1 %c, float %x, float %y
+  ret float %r
+; CHECK-LABEL: select_f32:
+; CHECK: andl $1, [[REG:%e[a-z0-9]+]]
+; CHECK-NEXT: negl [[REG]]
+; CHECK-NEXT: movd [[REG]], [[MASK:%xmm[0-9]+]]
+; CHECK: andps %xmm0,
+; CHECK: andnps %xmm1, [[MASK]]
+; CHECK: orps
+}
@@ -304,3 +304,30 @@ define void @test23(i8* noalias sret %result) {
 }
 
 declare i8* @foo23()
+
+; Large byval arguments are copied with a string move, after which the
+; register arguments are set up.
+%struct.big = type { [10 x i64], i32 }
+
+define void @test24(%struct.big* %p, i32 %x) nounwind {
+  call void @foo24(i32 %x, %struct.big* byval align 8 %p)
+  ret void
+; CHECK-LABEL: test24:
+; CHECK: leaq	(%rsp), %rdi
+; CHECK: movq	$11, %rcx
+; CHECK: rep;movsq
+; CHECK: movl	{{.*}}, %edi
+; CHECK: callq	_foo24
+}
+
+declare void @foo24(i32, %struct.big* byval align 8)
+
+; Bitcasts between vector types in the same registers are copies.
+define <4 x float> @test25(<4 x i32>* %p) nounwind {
+  %v = load <4 x i32>* %p, align 16
+  %f = bitcast <4 x i32> %v to <4 x float>
+  ret <4 x float> %f
+; CHECK-LABEL: test25:
+; CHECK: movdqa	(%rdi), %xmm0
+; CHECK-NEXT: ret
+}
@@ -0,0 +1,23 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -global-isel -verify-machineinstrs -asm-verbose=0 | FileCheck %s
+; RUN: not llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -global-isel -global-isel-abort -o /dev/null 2>&1 | FileCheck %s --check-prefix=ABORT
+
+; Vectors are not handled by the global instruction selector, so the whole
+; function is left to SelectionDAG.
+; CHECK-LABEL: vec:
+; CHECK: paddd %xmm1, %xmm0
+; ABORT: global instruction selection failed in 'vec'
+define <4 x i32> @vec(<4 x i32> %a, <4 x i32> %b) {
+entry:
+  %s = add <4 x i32> %a, %b
+  ret <4 x i32> %s
+}
+
+; Functions after the one that fell back are still selected globally; the DAG
+; would have used an LEA here.
+; CHECK-LABEL: scalar:
+; CHECK: addl %edi, %esi
+define i32 @scalar(i32 %a, i32 %b) {
+entry:
+  %s = add i32 %a, %b
+  ret i32 %s
+}
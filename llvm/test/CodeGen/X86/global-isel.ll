@@ -0,0 +1,150 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -global-isel -global-isel-abort -verify-machineinstrs -asm-verbose=0 | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7-avx -global-isel -global-isel-abort -verify-machineinstrs -asm-verbose=0 | FileCheck %s --check-prefix=AVX
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -O0 -global-isel -global-isel-abort -verify-machineinstrs -asm-verbose=0 | FileCheck %s --check-prefix=O0
+
+
+@g = global i32 0
+
+; CHECK-LABEL: add_imm:
+; CHECK: addq %rdi, %rsi
+; CHECK-NEXT: leaq 42(%rsi), %rax
+; CHECK-NEXT: ret
+; O0-LABEL: add_imm:
+; O0: addq $42,
+define i64 @add_imm(i64 %a, i64 %b) {
+entry:
+  %s = add i64 %a, %b
+  %t = add i64 %s, 42
+  ret i64 %t
+}
+
+; CHECK-LABEL: mul_pow2:
+; CHECK: leal (,%rdi,8), %eax
+; O0-LABEL: mul_pow2:
+; O0: shll $3, %edi
+define i32 @mul_pow2(i32 %a) {
+entry:
+  %m = mul i32 %a, 8
+  ret i32 %m
+}
+
+; CHECK-LABEL: sel:
+; CHECK: cmpl %esi, %edi
+; CHECK-NEXT: cmovll %edi, %esi
+define i32 @sel(i32 %a, i32 %b) {
+entry:
+  %c = icmp slt i32 %a, %b
+  %s = select i1 %c, i32 %a, i32 %b
+  ret i32 %s
+}
+
+; The compare is folded into the branch, and the branch to the layout
+; successor is inverted away.
+; CHECK-LABEL: branch:
+; CHECK: cmpl $0, %edi
+; CHECK-NEXT: jne .LBB3_2
+; CHECK-NEXT: movl $1, %eax
+; CHECK: .LBB3_2:
+; CHECK-NEXT: movl $2, %eax
+define i32 @branch(i32 %a) {
+entry:
+  %c = icmp eq i32 %a, 0
+  br i1 %c, label %zero, label %nonzero
+zero:
+  ret i32 1
+nonzero:
+  ret i32 2
+}
+
+; CHECK-LABEL: div:
+; CHECK: cltd
+; CHECK-NEXT: idivl %esi
+; CHECK-NEXT: xorl %edx, %edx
+; CHECK-NEXT: divl %esi
+; CHECK-NEXT: movl %edx, %eax
+define i32 @div(i32 %a, i32 %b) {
+entry:
+  %q = sdiv i32 %a, %b
+  %r = urem i32 %q, %b
+  ret i32 %r
+}
+
+; CHECK-LABEL: fp:
+; CHECK: cvtss2sd %xmm1, %xmm1
+; CHECK-NEXT: mulsd %xmm0, %xmm1
+; CHECK-NEXT: addsd .LCPI5_0, %xmm1
+; AVX-LABEL: fp:
+; AVX: vcvtss2sd %xmm1, %xmm0, %xmm1
+; AVX-NEXT: vmulsd %xmm1, %xmm0, %xmm0
+; AVX-NEXT: vaddsd .LCPI5_0, %xmm0, %xmm0
+define double @fp(double %a, float %b) {
+entry:
+  %e = fpext float %b to double
+  %m = fmul double %a, %e
+  %s = fadd double %m, 1.500000e+00
+  ret double %s
+}
+
+; CHECK-LABEL: fcmp_oeq:
+; CHECK: ucomisd %xmm1, %xmm0
+; CHECK-NEXT: sete %al
+; CHECK-NEXT: setnp %cl
+; CHECK-NEXT: andb %al, %cl
+define i32 @fcmp_oeq(double %a, double %b) {
+entry:
+  %c = fcmp oeq double %a, %b
+  %z = zext i1 %c to i32
+  ret i32 %z
+}
+
+; CHECK-LABEL: load_index:
+; CHECK: movl 12(%rdi,%rsi,4), %eax
+; CHECK-NEXT: ret
+define i32 @load_index(i32* %p, i64 %i) {
+entry:
+  %q = getelementptr i32* %p, i64 %i
+  %r = getelementptr i32* %q, i64 3
+  %v = load i32* %r
+  ret i32 %v
+}
+
+; Once both users fold the address, nothing is left to compute it, even
+; at -O0.
+; O0-LABEL: load_store_index:
+; O0: movslq %esi, %rax
+; O0-NEXT: movl (%rdi,%rax,4), [[R:%[a-z]+]]
+; O0-NEXT: addl $1, [[R]]
+; O0-NEXT: movl [[R]], (%rdi,%rax,4)
+; O0-NEXT: ret
+define void @load_store_index(i32* %p, i32 %i) {
+entry:
+  %idx = sext i32 %i to i64
+  %q = getelementptr i32* %p, i64 %idx
+  %v = load i32* %q
+  %w = add i32 %v, 1
+  store i32 %w, i32* %q
+  ret void
+}
+
+; CHECK-LABEL: store_global:
+; CHECK: movl %edi, g
+; CHECK-NEXT: movl $7, g
+define void @store_global(i32 %v) {
+entry:
+  store i32 %v, i32* @g
+  store i32 7, i32* @g
+  ret void
+}
+
+declare i64 @callee(i64, double)
+
+; CHECK-LABEL: call:
+; CHECK: xorps %xmm0, %xmm0
+; CHECK-NEXT: callq callee
+; CHECK-NEXT: addq $1, %rax
+define i64 @call(i64 %a) {
+entry:
+  %r = call i64 @callee(i64 %a, double 0.000000e+00)
+  %s = add i64 %r, 1
+  ret i64 %s
+}
@@ -0,0 +1,70 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -enable-machine-outliner -verify-machineinstrs | FileCheck %s
+
+; Debug values neither split the repeated stores nor end up in the outlined
+; function; those in the callers stay behind the call.
+
+; CHECK-LABEL: store1:
+; CHECK: callq OUTLINED_FUNCTION_0
+; CHECK-NEXT: DEBUG_VALUE: store1:x <- 7
+; CHECK: movl %edi, g(%rip)
+; CHECK-LABEL: store2:
+; CHECK: callq OUTLINED_FUNCTION_0
+; CHECK-NEXT: DEBUG_VALUE: store2:x <- 8
+; CHECK-LABEL: store3:
+; CHECK: callq OUTLINED_FUNCTION_0
+
+; CHECK-LABEL: OUTLINED_FUNCTION_0:
+; CHECK-NOT: DEBUG_VALUE
+; CHECK: movl $1, g+4(%rip)
+; CHECK-NEXT: movl $2, g+8(%rip)
+; CHECK-NEXT: movl $3, g+12(%rip)
+; CHECK-NEXT: ret
+
+@g = global [8 x i32] zeroinitializer
+
+define void @store1(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1), !dbg !20
+  call void @llvm.dbg.value(metadata !{i32 7}, i64 0, metadata !10), !dbg !20
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2), !dbg !20
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3), !dbg !20
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 0), !dbg !20
+  ret void, !dbg !20
+}
+
+define void @store2(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1), !dbg !21
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2), !dbg !21
+  call void @llvm.dbg.value(metadata !{i32 8}, i64 0, metadata !11), !dbg !21
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3), !dbg !21
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 4), !dbg !21
+  ret void, !dbg !21
+}
+
+define void @store3(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1), !dbg !22
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2), !dbg !22
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3), !dbg !22
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 5), !dbg !22
+  ret void, !dbg !22
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata) nounwind readnone
+
+!llvm.dbg.cu = !{!0}
+
+!0 = metadata !{i32 786449, metadata !1, i32 12, metadata !"clang version 3.4", i1 true, metadata !"", i32 0, metadata !2, metadata !2, metadata !3, metadata !2, metadata !2, metadata !""} ; [ DW_TAG_compile_unit ]
+!1 = metadata !{metadata !"store.c", metadata !"/tmp"}
+!2 = metadata !{i32 0}
+!3 = metadata !{metadata !4, metadata !5, metadata !6}
+!4 = metadata !{i32 786478, metadata !1, metadata !7, metadata !"store1", metadata !"store1", metadata !"", i32 1, metadata !8, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, void (i32)* @store1, null, null, metadata !2, i32 1} ; [ DW_TAG_subprogram ]
+!5 = metadata !{i32 786478, metadata !1, metadata !7, metadata !"store2", metadata !"store2", metadata !"", i32 2, metadata !8, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, void (i32)* @store2, null, null, metadata !2, i32 2} ; [ DW_TAG_subprogram ]
+!6 = metadata !{i32 786478, metadata !1, metadata !7, metadata !"store3", metadata !"store3", metadata !"", i32 3, metadata !8, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, void (i32)* @store3, null, null, metadata !2, i32 3} ; [ DW_TAG_subprogram ]
+!7 = metadata !{i32 786473, metadata !1} ; [ DW_TAG_file_type ]
+!8 = metadata !{i32 786453, i32 0, null, metadata !"", i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !9, i32 0, null, null, null} ; [ DW_TAG_subroutine_type ]
+!9 = metadata !{null, metadata !12}
+!10 = metadata !{i32 786689, metadata !4, metadata !"x", metadata !7, i32 16777217, metadata !12, i32 0, i32 0} ; [ DW_TAG_arg_variable ]
+!11 = metadata !{i32 786689, metadata !5, metadata !"x", metadata !7, i32 16777218, metadata !12, i32 0, i32 0} ; [ DW_TAG_arg_variable ]
+!12 = metadata !{i32 786468, null, null, metadata !"int", i32 0, i64 32, i64 32, i64 0, i32 0, i32 5} ; [ DW_TAG_base_type ]
+!20 = metadata !{i32 1, i32 0, metadata !4, null}
+!21 = metadata !{i32 2, i32 0, metadata !5, null}
+!22 = metadata !{i32 3, i32 0, metadata !6, null}
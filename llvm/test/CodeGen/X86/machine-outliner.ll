@@ -0,0 +1,209 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -enable-machine-outliner -verify-machineinstrs | FileCheck %s
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -enable-machine-outliner -outliner-report -o /dev/null 2>&1 | FileCheck %s -check-prefix=REPORT
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 | FileCheck %s -check-prefix=OFF
+
+; CHECK-LABEL: store1:
+; CHECK: callq OUTLINED_FUNCTION_1
+; CHECK-NEXT: movl %edi, g(%rip)
+; CHECK-NEXT: ret
+; CHECK-LABEL: store3:
+; CHECK: callq OUTLINED_FUNCTION_1
+; CHECK-NEXT: movl %edi, g+20(%rip)
+
+; CHECK-LABEL: redzone1:
+; CHECK-NOT: OUTLINED_FUNCTION
+; CHECK: movl $3, g+12(%rip)
+; CHECK-NOT: OUTLINED_FUNCTION
+; CHECK: ret
+
+; CHECK-LABEL: args1:
+; CHECK: addl $7, %ebx
+; CHECK-NEXT: callq OUTLINED_FUNCTION_2
+; CHECK-NEXT: movl %ebx, %edi
+; CHECK-NEXT: callq ext2
+
+; CHECK-LABEL: epilogue1:
+; CHECK: Reload
+; CHECK-NEXT: callq use
+; CHECK-NEXT: jmp OUTLINED_FUNCTION_0 # TAILCALL
+; CHECK-LABEL: epilogue3:
+; CHECK: Reload
+; CHECK-NEXT: callq use
+; CHECK-NEXT: jmp OUTLINED_FUNCTION_0 # TAILCALL
+
+; CHECK-LABEL: OUTLINED_FUNCTION_0:
+; CHECK: addq %r14, %rax
+; CHECK-NEXT: addq $8, %rsp
+; CHECK-NEXT: popq %rbx
+; CHECK: popq %rbp
+; CHECK-NEXT: ret
+
+; CHECK-LABEL: OUTLINED_FUNCTION_1:
+; CHECK: movl $1, g+4(%rip)
+; CHECK-NEXT: movl $2, g+8(%rip)
+; CHECK-NEXT: movl $3, g+12(%rip)
+; CHECK-NEXT: ret
+
+; CHECK-LABEL: OUTLINED_FUNCTION_2:
+; CHECK: movl $100, %edi
+; CHECK-NEXT: movl $200, %esi
+; CHECK-NEXT: movl %ebx, %edx
+; CHECK-NEXT: jmp ext # TAILCALL
+
+; REPORT: 3 functions outlined
+; REPORT-NEXT: 9 sequences replaced
+; REPORT-NEXT: 114 bytes saved (estimated)
+; REPORT: Insts Bytes Uses Saved Kind Function
+; REPORT-NEXT: 14 33 3 51 tail OUTLINED_FUNCTION_0
+; REPORT-NEXT: 3 30 3 44 call OUTLINED_FUNCTION_1
+; REPORT-NEXT: 4 17 3 19 thunk OUTLINED_FUNCTION_2
+
+; OFF-NOT: OUTLINED_FUNCTION
+
+@g = global [8 x i32] zeroinitializer
+
+declare void @ext(i32, i32, i32)
+declare i32 @ext2(i32)
+declare i64 @use(i64)
+
+; Three stores repeated at the start of each function are called.
+
+define void @store1(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 0)
+  ret void
+}
+
+define void @store2(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 4)
+  ret void
+}
+
+define void @store3(i32 %x) nounwind {
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  store i32 %x, i32* getelementptr ([8 x i32]* @g, i64 0, i64 5)
+  ret void
+}
+
+; The same stores in functions that keep a local in the red zone. A call would
+; overwrite it, so the stores can only be jumped to along with the return.
+
+define i32 @redzone1(i32 %x) nounwind {
+  %a = alloca i32
+  store volatile i32 %x, i32* %a
+  call void asm sideeffect "", ""()
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  call void asm sideeffect "", ""()
+  %v = load volatile i32* %a
+  ret i32 %v
+}
+
+define i32 @redzone2(i32 %x) nounwind {
+  %a = alloca i32
+  store volatile i32 %x, i32* %a
+  call void asm sideeffect "", ""()
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  call void asm sideeffect "", ""()
+  %v = load volatile i32* %a
+  ret i32 %v
+}
+
+define i32 @redzone3(i32 %x) nounwind {
+  %a = alloca i32
+  store volatile i32 %x, i32* %a
+  call void asm sideeffect "", ""()
+  store i32 1, i32* getelementptr ([8 x i32]* @g, i64 0, i64 1)
+  store i32 2, i32* getelementptr ([8 x i32]* @g, i64 0, i64 2)
+  store i32 3, i32* getelementptr ([8 x i32]* @g, i64 0, i64 3)
+  call void asm sideeffect "", ""()
+  %v = load volatile i32* %a
+  ret i32 %v
+}
+
+; Argument setup before a call is outlined with the call, which becomes a
+; tail call.
+
+define i32 @args1(i32 %x) nounwind {
+  %a = add i32 %x, 7
+  call void @ext(i32 100, i32 200, i32 %a)
+  %r = call i32 @ext2(i32 %a)
+  ret i32 %r
+}
+
+define i32 @args2(i32 %x) nounwind {
+  %a = add i32 %x, 9
+  call void @ext(i32 100, i32 200, i32 %a)
+  %r = call i32 @ext2(i32 %a)
+  ret i32 %r
+}
+
+define i32 @args3(i32 %x) nounwind {
+  %a = add i32 %x, 11
+  call void @ext(i32 100, i32 200, i32 %a)
+  %r = call i32 @ext2(i32 %a)
+  ret i32 %r
+}
+
+; The epilogues restoring six callee-saved registers are jumped to.
+
+define i64 @epilogue1(i64 %a) nounwind {
+  %v0 = call i64 @use(i64 0)
+  %v1 = call i64 @use(i64 1)
+  %v2 = call i64 @use(i64 2)
+  %v3 = call i64 @use(i64 3)
+  %v4 = call i64 @use(i64 4)
+  %v5 = call i64 @use(i64 5)
+  %w = call i64 @use(i64 %a)
+  %s0 = add i64 %w, %v0
+  %s1 = add i64 %s0, %v1
+  %s2 = add i64 %s1, %v2
+  %s3 = add i64 %s2, %v3
+  %s4 = add i64 %s3, %v4
+  %s5 = add i64 %s4, %v5
+  ret i64 %s5
+}
+
+define i64 @epilogue2(i64 %a) nounwind {
+  %v0 = call i64 @use(i64 10)
+  %v1 = call i64 @use(i64 11)
+  %v2 = call i64 @use(i64 12)
+  %v3 = call i64 @use(i64 13)
+  %v4 = call i64 @use(i64 14)
+  %v5 = call i64 @use(i64 15)
+  %w = call i64 @use(i64 %a)
+  %s0 = add i64 %w, %v0
+  %s1 = add i64 %s0, %v1
+  %s2 = add i64 %s1, %v2
+  %s3 = add i64 %s2, %v3
+  %s4 = add i64 %s3, %v4
+  %s5 = add i64 %s4, %v5
+  ret i64 %s5
+}
+
+define i64 @epilogue3(i64 %a) nounwind {
+  %v0 = call i64 @use(i64 20)
+  %v1 = call i64 @use(i64 21)
+  %v2 = call i64 @use(i64 22)
+  %v3 = call i64 @use(i64 23)
+  %v4 = call i64 @use(i64 24)
+  %v5 = call i64 @use(i64 25)
+  %w = call i64 @use(i64 %a)
+  %s0 = add i64 %w, %v0
+  %s1 = add i64 %s0, %v1
+  %s2 = add i64 %s1, %v2
+  %s3 = add i64 %s2, %v3
+  %s4 = add i64 %s3, %v4
+  %s5 = add i64 %s4, %v5
+  ret i64 %s5
+}
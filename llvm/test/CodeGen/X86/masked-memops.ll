@@ -0,0 +1,77 @@
+; RUN: llc < %s -mtriple=x86_64-apple-darwin -mcpu=corei7-avx | FileCheck %s -check-prefix=AVX
+; RUN: llc < %s -mtriple=x86_64-apple-darwin -mcpu=corei7 | FileCheck %s -check-prefix=SSE
+
+; AVX selects vmaskmov for 32 and 64-bit elements. Without AVX the intrinsics
+; are expanded into a branch per lane by CodeGenPrepare.
+
+; AVX-LABEL: test_load_v8f32:
+; AVX: vmaskmovps (%rdi), %ymm
+; AVX-NOT: vblendv
+; AVX: ret
+; SSE-LABEL: test_load_v8f32:
+; SSE-NOT: maskmov
+; SSE: ret
+define <8 x float> @test_load_v8f32(<8 x float>* %addr, <8 x i1> %mask) {
+  %res = call <8 x float> @llvm.masked.load.v8f32.p0v8f32.v8i1(<8 x float>* %addr, i32 4, <8 x i1> %mask, <8 x float> undef)
+  ret <8 x float> %res
+}
+
+; AVX-LABEL: test_load_v4i32_passthru:
+; AVX: vmaskmovps (%rdi), %xmm
+; AVX: vblendvps
+; AVX: ret
+define <4 x i32> @test_load_v4i32_passthru(<4 x i32>* %addr, <4 x i32> %trigger, <4 x i32> %dst) {
+  %mask = icmp eq <4 x i32> %trigger, zeroinitializer
+  %res = call <4 x i32> @llvm.masked.load.v4i32.p0v4i32.v4i1(<4 x i32>* %addr, i32 4, <4 x i1> %mask, <4 x i32> %dst)
+  ret <4 x i32> %res
+}
+
+; AVX-LABEL: test_load_v2f64:
+; AVX: vmaskmovpd (%rdi), %xmm
+; AVX: ret
+define <2 x double> @test_load_v2f64(<2 x double>* %addr, <2 x i64> %trigger) {
+  %mask = icmp ne <2 x i64> %trigger, zeroinitializer
+  %res = call <2 x double> @llvm.masked.load.v2f64.p0v2f64.v2i1(<2 x double>* %addr, i32 8, <2 x i1> %mask, <2 x double> zeroinitializer)
+  ret <2 x double> %res
+}
+
+; AVX-LABEL: test_store_v8i32:
+; AVX: vmaskmovps %ymm{{[0-9]+}}, %ymm{{[0-9]+}}, (%rdi)
+; AVX: ret
+define void @test_store_v8i32(<8 x i32>* %addr, <8 x i32> %val, <8 x i32> %trigger) {
+  %mask = icmp sgt <8 x i32> %trigger, zeroinitializer
+  call void @llvm.masked.store.v8i32.p0v8i32.v8i1(<8 x i32> %val, <8 x i32>* %addr, i32 4, <8 x i1> %mask)
+  ret void
+}
+
+; AVX-LABEL: test_store_v4f64:
+; AVX: vmaskmovpd %ymm{{[0-9]+}}, %ymm{{[0-9]+}}, (%rdi)
+; AVX: ret
+; SSE-LABEL: test_store_v4f64:
+; SSE-NOT: maskmov
+; SSE: je
+; SSE: movlpd %xmm0, (%rdi)
+; SSE: je
+; SSE: movhpd %xmm0, 8(%rdi)
+; SSE: ret
+define void @test_store_v4f64(<4 x double>* %addr, <4 x double> %val, <4 x i64> %trigger) {
+  %mask = icmp ne <4 x i64> %trigger, zeroinitializer
+  call void @llvm.masked.store.v4f64.p0v4f64.v4i1(<4 x double> %val, <4 x double>* %addr, i32 8, <4 x i1> %mask)
+  ret void
+}
+
+; A constant mask needs no branches.
+; SSE-LABEL: test_store_const_mask:
+; SSE-NOT: j
+; SSE: ret
+define void @test_store_const_mask(<4 x i32>* %addr, <4 x i32> %val) {
+  call void @llvm.masked.store.v4i32.p0v4i32.v4i1(<4 x i32> %val, <4 x i32>* %addr, i32 4, <4 x i1> <i1 true, i1 false, i1 false, i1 true>)
+  ret void
+}
+
+declare <8 x float> @llvm.masked.load.v8f32.p0v8f32.v8i1(<8 x float>*, i32, <8 x i1>, <8 x float>)
+declare <4 x i32> @llvm.masked.load.v4i32.p0v4i32.v4i1(<4 x i32>*, i32, <4 x i1>, <4 x i32>)
+declare <2 x double> @llvm.masked.load.v2f64.p0v2f64.v2i1(<2 x double>*, i32, <2 x i1>, <2 x double>)
+declare void @llvm.masked.store.v8i32.p0v8i32.v8i1(<8 x i32>, <8 x i32>*, i32, <8 x i1>)
+declare void @llvm.masked.store.v4f64.p0v4f64.v4i1(<4 x double>, <4 x double>*, i32, <4 x i1>)
+declare void @llvm.masked.store.v4i32.p0v4i32.v4i1(<4 x i32>, <4 x i32>*, i32, <4 x i1>)
@@ -0,0 +1,119 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -regalloc=linearscan -verify-machineinstrs | FileCheck %s
+
+declare void @g()
+
+; The accumulators are live across the call, and no xmm register survives it.
+; They are split around the call instead of being spilled everywhere, so the
+; loop only touches the stack on the path with the call.
+; CHECK-LABEL: f:
+; CHECK: %loop
+; CHECK-NOT: Spill
+; CHECK-NOT: Reload
+; CHECK: %call
+; CHECK: Spill
+; CHECK: callq g
+; CHECK: Reload
+; CHECK: %latch
+; CHECK-NOT: Spill
+; CHECK-NOT: Reload
+; CHECK: jne
+define double @f(double* %p, i64 %n) nounwind {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %latch ]
+  %a = phi double [ 0.0, %entry ], [ %a.n, %latch ]
+  %b = phi double [ 1.0, %entry ], [ %b.n, %latch ]
+  %c = phi double [ 2.0, %entry ], [ %c.n, %latch ]
+  %d = phi double [ 3.0, %entry ], [ %d.n, %latch ]
+  %q = getelementptr double* %p, i64 %i
+  %v = load double* %q
+  %a.n = fadd double %a, %v
+  %b.n = fmul double %b, %v
+  %c.n = fsub double %c, %v
+  %d.n = fdiv double %d, %v
+  %cmp = fcmp olt double %v, 0.0
+  br i1 %cmp, label %call, label %latch
+
+call:
+  call void @g()
+  br label %latch
+
+latch:
+  %i.next = add i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %s1 = fadd double %a.n, %b.n
+  %s2 = fadd double %c.n, %d.n
+  %s = fadd double %s1, %s2
+  ret double %s
+}
+
+; More integer values are live around the loop than there are registers.
+; Some of them have to be spilled, but the result must still verify.
+; CHECK-LABEL: h:
+; CHECK: Spill
+; CHECK: Reload
+; CHECK: ret
+define i64 @h(i64* %p, i64 %n) nounwind {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %x0 = phi i64 [ 0, %entry ], [ %x0.n, %loop ]
+  %x1 = phi i64 [ 1, %entry ], [ %x1.n, %loop ]
+  %x2 = phi i64 [ 2, %entry ], [ %x2.n, %loop ]
+  %x3 = phi i64 [ 3, %entry ], [ %x3.n, %loop ]
+  %x4 = phi i64 [ 4, %entry ], [ %x4.n, %loop ]
+  %x5 = phi i64 [ 5, %entry ], [ %x5.n, %loop ]
+  %x6 = phi i64 [ 6, %entry ], [ %x6.n, %loop ]
+  %x7 = phi i64 [ 7, %entry ], [ %x7.n, %loop ]
+  %x8 = phi i64 [ 8, %entry ], [ %x8.n, %loop ]
+  %x9 = phi i64 [ 9, %entry ], [ %x9.n, %loop ]
+  %x10 = phi i64 [ 10, %entry ], [ %x10.n, %loop ]
+  %x11 = phi i64 [ 11, %entry ], [ %x11.n, %loop ]
+  %x12 = phi i64 [ 12, %entry ], [ %x12.n, %loop ]
+  %x13 = phi i64 [ 13, %entry ], [ %x13.n, %loop ]
+  %x14 = phi i64 [ 14, %entry ], [ %x14.n, %loop ]
+  %q = getelementptr i64* %p, i64 %i
+  %v = load i64* %q
+  %x0.n = mul i64 %x0, %v
+  %x1.n = xor i64 %x1, %x0.n
+  %x2.n = mul i64 %x2, %x1.n
+  %x3.n = xor i64 %x3, %x2.n
+  %x4.n = mul i64 %x4, %x3.n
+  %x5.n = xor i64 %x5, %x4.n
+  %x6.n = mul i64 %x6, %x5.n
+  %x7.n = xor i64 %x7, %x6.n
+  %x8.n = mul i64 %x8, %x7.n
+  %x9.n = xor i64 %x9, %x8.n
+  %x10.n = mul i64 %x10, %x9.n
+  %x11.n = xor i64 %x11, %x10.n
+  %x12.n = mul i64 %x12, %x11.n
+  %x13.n = xor i64 %x13, %x12.n
+  %x14.n = mul i64 %x14, %x13.n
+  %i.next = add i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %s1 = add i64 %x0.n, %x1.n
+  %s2 = add i64 %s1, %x2.n
+  %s3 = add i64 %s2, %x3.n
+  %s4 = add i64 %s3, %x4.n
+  %s5 = add i64 %s4, %x5.n
+  %s6 = add i64 %s5, %x6.n
+  %s7 = add i64 %s6, %x7.n
+  %s8 = add i64 %s7, %x8.n
+  %s9 = add i64 %s8, %x9.n
+  %s10 = add i64 %s9, %x10.n
+  %s11 = add i64 %s10, %x11.n
+  %s12 = add i64 %s11, %x12.n
+  %s13 = add i64 %s12, %x13.n
+  %s14 = add i64 %s13, %x14.n
+  ret i64 %s14
+}
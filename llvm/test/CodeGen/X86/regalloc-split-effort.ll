@@ -0,0 +1,134 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -verify-machineinstrs -regalloc-split-effort=50 -regalloc-stats-json=%t.json -stats 2>&1 | FileCheck %s
+; RUN: FileCheck %s -check-prefix=CAPPED < %t.json
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -regalloc-max-split-candidates=1 -regalloc-stats-json=%t.json -o /dev/null
+; RUN: FileCheck %s -check-prefix=CAPPED < %t.json
+; RUN: llc < %s -mtriple=x86_64-unknown-linux-gnu -mcpu=x86-64 -regalloc-split-effort=0 -regalloc-stats-json=%t.json -o /dev/null
+; RUN: FileCheck %s -check-prefix=FULL < %t.json
+; REQUIRES: asserts
+
+; Eight values are live through a chain of blocks with a call in the middle,
+; and only used at the ends. Growing a split region through the chain one
+; block at a time is quadratic in the length of the chain. When the effort
+; limit is reached, region splitting gives up and the values are spilled
+; like they would be anyway.
+
+; CHECK: big:
+; CHECK: Spill
+; CHECK: callq ext
+; CHECK: Reload
+; CHECK: shuf:
+
+; -stats reports a histogram of the functions.
+; CHECK: 1 regalloc - Functions with 0 evictions
+; CHECK: 2 regalloc - Functions with 0 live range splits
+; CHECK: 1 regalloc - Functions with 1-9 evictions
+; CHECK: 1 regalloc - Functions with eviction cascade depth 0
+; CHECK: 1 regalloc - Functions with eviction cascade depth 1-9
+; CHECK: 4 regalloc - Number of region splits cut short by the effort limit
+
+; CAPPED: [
+; CAPPED-NEXT: {"function":"big","virtregs":29,"evictions":0,"region_splits":0,"block_splits":0,"local_splits":0,"instruction_splits":0,"spills":4,"capped_region_splits":4,"max_split_effort":{{[0-9]+}},"max_cascade_depth":0,"evictions_by_depth":[]},
+; CAPPED-NEXT: {"function":"shuf",{{.*}}"evictions":2,{{.*}}"capped_region_splits":0,{{.*}}"max_cascade_depth":2,"evictions_by_depth":[1,1]}
+; CAPPED-NEXT: ]
+
+; FULL: {"function":"big",{{.*}}"spills":4,"capped_region_splits":0,"max_split_effort":234,
+
+declare void @ext(i64*)
+
+define void @big(i64* %a, i64* %o) {
+entry:
+  %p0 = getelementptr i64* %a, i64 0
+  %v0 = load i64* %p0
+  %p1 = getelementptr i64* %a, i64 1
+  %v1 = load i64* %p1
+  %p2 = getelementptr i64* %a, i64 2
+  %v2 = load i64* %p2
+  %p3 = getelementptr i64* %a, i64 3
+  %v3 = load i64* %p3
+  %p4 = getelementptr i64* %a, i64 4
+  %v4 = load i64* %p4
+  %p5 = getelementptr i64* %a, i64 5
+  %v5 = load i64* %p5
+  %p6 = getelementptr i64* %a, i64 6
+  %v6 = load i64* %p6
+  %p7 = getelementptr i64* %a, i64 7
+  %v7 = load i64* %p7
+  br label %b0
+b0:
+  %q0 = getelementptr i64* %o, i64 0
+  %x0 = load i64* %q0
+  %c0 = icmp eq i64 %x0, 0
+  br i1 %c0, label %l0, label %j0
+l0:
+  store i64 0, i64* %q0
+  br label %j0
+j0:
+  br label %b1
+b1:
+  %q1 = getelementptr i64* %o, i64 1
+  %x1 = load i64* %q1
+  %c1 = icmp eq i64 %x1, 1
+  br i1 %c1, label %l1, label %j1
+l1:
+  store i64 0, i64* %q1
+  br label %j1
+j1:
+  br label %b2
+b2:
+  %q2 = getelementptr i64* %o, i64 2
+  %x2 = load i64* %q2
+  %c2 = icmp eq i64 %x2, 2
+  br i1 %c2, label %l2, label %j2
+l2:
+  store i64 0, i64* %q2
+  br label %j2
+j2:
+  br label %b3
+b3:
+  %q3 = getelementptr i64* %o, i64 3
+  %x3 = load i64* %q3
+  %c3 = icmp eq i64 %x3, 3
+  br i1 %c3, label %l3, label %j3
+l3:
+  call void @ext(i64* %q3)
+  br label %j3
+j3:
+  br label %b4
+b4:
+  %q4 = getelementptr i64* %o, i64 4
+  %x4 = load i64* %q4
+  %c4 = icmp eq i64 %x4, 4
+  br i1 %c4, label %l4, label %j4
+l4:
+  store i64 0, i64* %q4
+  br label %j4
+j4:
+  br label %b5
+b5:
+  %q5 = getelementptr i64* %o, i64 5
+  %x5 = load i64* %q5
+  %c5 = icmp eq i64 %x5, 5
+  br i1 %c5, label %l5, label %j5
+l5:
+  store i64 0, i64* %q5
+  br label %j5
+j5:
+  br label %b6
+b6:
+  store i64 %v0, i64* %p0
+  store i64 %v1, i64* %p1
+  store i64 %v2, i64* %p2
+  store i64 %v3, i64* %p3
+  store i64 %v4, i64* %p4
+  store i64 %v5, i64* %p5
+  store i64 %v6, i64* %p6
+  store i64 %v7, i64* %p7
+  ret void
+}
+
+; Eviction chains are reported by depth.
+define <16 x i8> @shuf(<16 x i8> %inval1) {
+entry:
+  %0 = shufflevector <16 x i8> %inval1, <16 x i8> zeroinitializer, <16 x i32> <i32 0, i32 4, i32 3, i32 2, i32 16, i32 16, i32 3, i32 4, i32 0, i32 4, i32 3, i32 2, i32 16, i32 16, i32 3, i32 4>
+  ret <16 x i8> %0
+}
@@ -0,0 +1,27 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -o %t.s %s
+; RUN: cat %t.s0 %t.s1 | FileCheck %s
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -disable-cfi \
+; RUN:   -disable-simplify-libcalls -o %t.opt.s %s
+; RUN: cat %t.opt.s0 %t.opt.s1 | FileCheck --check-prefix=OPTS %s
+
+; Every partition is compiled with the code generation options of llc, as a
+; whole module would be.
+
+; CHECK: .cfi_startproc
+; CHECK: sqrtsd
+
+; OPTS-NOT: .cfi_startproc
+; OPTS: callq sqrt
+; OPTS-NOT: .cfi_startproc
+
+define double @root(double %x) {
+  %r = call double @sqrt(double %x) readnone
+  ret double %r
+}
+
+define i32 @other(i32 %x) {
+  %a = mul i32 %x, 3
+  ret i32 %a
+}
+
+declare double @sqrt(double)
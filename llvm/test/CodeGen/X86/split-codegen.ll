@@ -0,0 +1,31 @@
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -filetype=obj -o %t %s
+; RUN: llvm-nm %t0 | FileCheck --check-prefix=PART %s
+; RUN: llvm-nm %t1 | FileCheck --check-prefix=PART %s
+; RUN: llvm-nm %t0 %t1 | FileCheck %s
+; RUN: llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -o %t.s %s
+; RUN: cat %t.s0 %t.s1 | FileCheck --check-prefix=ASM %s
+; RUN: not llc -mtriple=x86_64-unknown-linux-gnu -split-codegen=2 -o - %s 2>&1 | FileCheck --check-prefix=STDOUT %s
+
+; The module is split into two partitions, and code is generated for each of
+; them into its own output file.
+
+; PART: {{[0-9a-f]+}} T {{f.llvmsplit.[0-9A-F]+|main}}
+
+; CHECK-DAG: T f.llvmsplit.
+; CHECK-DAG: T main
+
+; ASM-DAG: {{^}}main:
+; ASM-DAG: {{^}}f.llvmsplit.{{[0-9A-F]+}}:
+
+; STDOUT: -split-codegen requires an output filename
+
+define i32 @main() {
+  %a = call i32 @f(i32 1)
+  ret i32 %a
+}
+
+define internal i32 @f(i32 %x) {
+  %a = mul i32 %x, 3
+  %b = add i32 %a, 7
+  ret i32 %b
+}
@@ -0,0 +1,79 @@
+; RUN: llc < %s -mtriple=x86_64-unknown-linux | FileCheck %s
+
+; With a profile that sends most executions to one case, that case is tested
+; before the jump table is indexed.
+
+declare void @a()
+declare void @b()
+declare void @c()
+declare void @d()
+declare void @e()
+
+; CHECK-LABEL: hot:
+; CHECK: cmpl $3, %edi
+; CHECK-NEXT: jne
+; CHECK: jmpq *.LJTI0_0
+define void @hot(i32 %x) {
+entry:
+  switch i32 %x, label %ret [
+    i32 0, label %ca
+    i32 1, label %cb
+    i32 2, label %cc
+    i32 3, label %cd
+    i32 4, label %ce
+  ], !prof !0
+
+ca:
+  tail call void @a()
+  br label %ret
+cb:
+  tail call void @b()
+  br label %ret
+cc:
+  tail call void @c()
+  br label %ret
+cd:
+  tail call void @d()
+  br label %ret
+ce:
+  tail call void @e()
+  br label %ret
+ret:
+  ret void
+}
+
+; Without a dominant case the jump table comes first.
+; CHECK-LABEL: flat:
+; CHECK-NOT: cmpl $3
+; CHECK: jmpq *.LJTI1_0
+define void @flat(i32 %x) {
+entry:
+  switch i32 %x, label %ret [
+    i32 0, label %ca
+    i32 1, label %cb
+    i32 2, label %cc
+    i32 3, label %cd
+    i32 4, label %ce
+  ], !prof !1
+
+ca:
+  tail call void @a()
+  br label %ret
+cb:
+  tail call void @b()
+  br label %ret
+cc:
+  tail call void @c()
+  br label %ret
+cd:
+  tail call void @d()
+  br label %ret
+ce:
+  tail call void @e()
+  br label %ret
+ret:
+  ret void
+}
+
+!0 = metadata !{metadata !"branch_weights", i32 10, i32 10, i32 10, i32 10, i32 1000, i32 10}
+!1 = metadata !{metadata !"branch_weights", i32 10, i32 10, i32 10, i32 10, i32 10, i32 10}
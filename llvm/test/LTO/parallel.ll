@@ -0,0 +1,37 @@
+; RUN: llvm-as < %s > %t.bc
+; RUN: llvm-lto -j2 -disable-opt -exported-symbol=main -o %t.o %t.bc
+; RUN: llvm-nm %t.o0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-nm %t.o1 | FileCheck --check-prefix=CHECK1 %s
+
+; The merged module is split into two partitions, and an object file is
+; generated for each of them. @f is internalized, and then promoted to a
+; hidden symbol because it is referenced from the other partition.
+
+target triple = "x86_64-unknown-linux-gnu"
+
+; CHECK0: U f
+; CHECK0: t g
+; CHECK0: T main
+define i32 @main() {
+  %a = call i32 @f(i32 1)
+  %b = call i32 @g(i32 2)
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+; CHECK1: T f
+; CHECK1-NOT: g
+; CHECK1-NOT: main
+define i32 @f(i32 %x) {
+  %a = mul i32 %x, 3
+  %b = add i32 %a, 7
+  %c = xor i32 %b, %x
+  ret i32 %c
+}
+
+define i32 @g(i32 %x) {
+  %a = mul i32 %x, 5
+  %b = add i32 %a, 11
+  %c = xor i32 %b, %x
+  ret i32 %c
+}
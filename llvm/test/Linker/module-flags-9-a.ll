@@ -0,0 +1,13 @@
+; RUN: llvm-link %s %p/module-flags-9-b.ll -S -o - | sort | FileCheck %s
+; RUN: llvm-link %p/module-flags-9-b.ll %s -S -o - | sort | FileCheck %s
+
+; Test max-type module flags.
+
+; CHECK: !0 = metadata !{i32 7, metadata !"flag-0", i64 1000}
+; CHECK: !1 = metadata !{i32 7, metadata !"flag-1", i64 42}
+; CHECK: !llvm.module.flags = !{!0, !1}
+
+!0 = metadata !{ i32 7, metadata !"flag-0", i64 1000 }
+!1 = metadata !{ i32 7, metadata !"flag-1", i64 7 }
+
+!llvm.module.flags = !{ !0, !1 }
@@ -0,0 +1,7 @@
+; This file is used with module-flags-9-a.ll
+; RUN: true
+
+!0 = metadata !{ i32 7, metadata !"flag-0", i64 20 }
+!1 = metadata !{ i32 7, metadata !"flag-1", i64 42 }
+
+!llvm.module.flags = !{ !0, !1 }
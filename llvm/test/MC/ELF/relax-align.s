@@ -0,0 +1,29 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t
+// RUN: llvm-objdump -d %t | FileCheck %s
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t2 \
+// RUN:   -mc-relax-worklist=false
+// RUN: diff %t %t2
+
+// Relaxing the jump at Y moves L out of range of the jump at X. Relaxing that
+// one moves the alignment, whose padding grows and pushes T out of range of
+// J, even though nothing between J and T was resized. J must be re-examined
+// and relaxed as well.
+
+// CHECK: 0: e9 {{.*}} jmp
+// CHECK: 5: e9 b4 00 00 00 jmp
+// CHECK: be: e9 {{.*}} jmp
+
+X:
+        jmp     L
+J:
+        jmp     T
+        .fill   58, 1, 0x90
+        .p2align 6, 0x90
+        .fill   62, 1, 0x90
+T:
+Y:
+        jmp     far
+L:
+        .fill   200, 1, 0x90
+far:
+        ret
@@ -0,0 +1,42 @@
+// REQUIRES: asserts
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t -stats 2>&1 \
+// RUN:   | FileCheck --check-prefix=STATS %s
+// RUN: llvm-objdump -d %t | FileCheck %s
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t2 \
+// RUN:   -mc-relax-worklist=false
+// RUN: diff %t %t2
+
+// Relaxing the last jump pushes the target of the one before it out of
+// range, and so on back to the first. Each relaxation only re-examines the
+// fragments that depend on what moved, rather than the whole section.
+
+// STATS: 17 assembler - Number of fragments examined for relaxation
+// STATS: 6 assembler - Number of relaxed instructions
+
+// CHECK:  0: e9 {{.*}} jmp
+// CHECK: 43: e9 {{.*}} jmp
+// CHECK: 86: e9 {{.*}} jmp
+// CHECK: c9: e9 {{.*}} jmp
+// CHECK: 10c: e9 {{.*}} jmp
+// CHECK: 14f: e9 {{.*}} jmp
+
+        jmp     .L1
+        .fill   62, 1, 0x90
+        jmp     .L2
+        .fill   62, 1, 0x90
+.L1:
+        jmp     .L3
+        .fill   62, 1, 0x90
+.L2:
+        jmp     .L4
+        .fill   62, 1, 0x90
+.L3:
+        jmp     .L5
+        .fill   62, 1, 0x90
+.L4:
+        jmp     .L6
+        .fill   62, 1, 0x90
+.L5:
+        .fill   130, 1, 0x90
+.L6:
+        ret
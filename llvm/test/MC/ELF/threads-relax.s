@@ -0,0 +1,56 @@
+// Relaxing the sections concurrently must give the same object as the serial
+// assembler on the relaxation tests.
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax.s -o %t1 \
+// RUN:   -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax.s -o %t2 \
+// RUN:   -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-align.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-align.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-arith.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-arith.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-cascade.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-cascade.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-crash.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/relax-crash.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/align-nops.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/align-nops.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/threads.s \
+// RUN:   -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %S/threads.s \
+// RUN:   -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple i386-apple-darwin9 \
+// RUN:   %S/../MachO/relax-jumps.s -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple i386-apple-darwin9 \
+// RUN:   %S/../MachO/relax-jumps.s -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
+
+// RUN: llvm-mc -filetype=obj -triple i386-apple-darwin9 \
+// RUN:   %S/../MachO/relax-recompute-align.s -o %t1 -mc-assembler-threads=1
+// RUN: llvm-mc -filetype=obj -triple i386-apple-darwin9 \
+// RUN:   %S/../MachO/relax-recompute-align.s -o %t2 -mc-assembler-threads=4
+// RUN: cmp %t1 %t2
@@ -0,0 +1,63 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t1
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t2 \
+// RUN:   -mc-assembler-threads=4
+// RUN: diff %t1 %t2
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o %t3 \
+// RUN:   -mc-assembler-threads=4 -time-mc-assembler 2>&1 | FileCheck %s
+// RUN: diff %t1 %t3
+
+// Relaxing and writing the sections concurrently must give the same object
+// as the serial assembler.
+
+// CHECK: Assembler Backend
+// CHECK-DAG: Layout and relaxation
+// CHECK-DAG: Fixup evaluation
+// CHECK-DAG: Object writing
+
+        .file 1 "threads.c"
+
+        .text
+        .globl  foo
+foo:
+        .loc 1 1 0
+        jmp     .Lfar
+        jne     .Lnear
+        .fill   100, 1, 0x90
+.Lnear:
+        jmp     foo
+        .fill   200, 1, 0x90
+        .loc 1 2 0
+        call    bar
+.Lfar:
+        .p2align 4, 0x90
+        jmp     .Lfar2
+        .fill   150, 1, 0x90
+.Lfar2:
+        ret
+
+        .section .text.bar,"ax",@progbits
+        .globl  bar
+bar:
+        .loc 1 3 0
+        je      .Lbar_end
+        .fill   120, 1, 0x90
+        jmp     foo
+        jmp     bar
+.Lbar_end:
+        .p2align 3
+        ret
+
+        .data
+        .quad   foo
+        .long   .Lfar2 - foo
+        .uleb128 .Lfar2 - foo
+        .sleb128 foo - .Lfar2
+        .byte   1
+
+        .bss
+        .zero   64
+
+        .section .rodata,"a",@progbits
+        .uleb128 .Lbar_end - bar
+        .p2align 4
+        .asciz  "threads"
@@ -0,0 +1,18 @@
+; RUN: opt < %s -die -disable-output -pass-trace=%t.json
+; RUN: FileCheck %s < %t.json
+
+; A basic block pass is recorded once per block, with the instruction counts
+; of that block and whether the pass changed it.
+
+; CHECK: {"pass":"Dead Instruction Elimination","kind":"basicblock","unit":"f",{{.*}}"instructions_before":3,"instructions_after":2,"changed":true,
+; CHECK: {"pass":"Dead Instruction Elimination","kind":"basicblock","unit":"f",{{.*}}"instructions_before":1,"instructions_after":1,"changed":false,
+
+define i32 @f(i32 %a) {
+entry:
+  %dead = add i32 %a, 1
+  %x = mul i32 %a, %a
+  br label %exit
+
+exit:
+  ret i32 %x
+}
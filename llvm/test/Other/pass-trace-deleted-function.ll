@@ -0,0 +1,20 @@
+; RUN: opt < %s -argpromotion -disable-output -pass-trace=%t.json
+; RUN: FileCheck %s < %t.json
+; RUN: opt < %s -argpromotion -disable-output -function-compile-budget-us=1000000000
+
+; Argument promotion deletes @callee and replaces it with a new function while
+; it runs on the SCC.  The deleted function is left out of the record of the
+; run rather than read after it is freed.
+
+; CHECK: {"pass":"Promote 'by reference' arguments to scalars","kind":"cgscc","unit":"","start_us":{{[0-9]+}},"end_us":{{[0-9]+}},"instructions_before":2,"instructions_after":0,"changed":true,"invalidated":[]}
+; CHECK: {"pass":"Promote 'by reference' arguments to scalars","kind":"cgscc","unit":"caller",
+
+define internal i32 @callee(i32* %p) {
+  %v = load i32* %p
+  ret i32 %v
+}
+
+define i32 @caller(i32* %p) {
+  %r = call i32 @callee(i32* %p)
+  ret i32 %r
+}
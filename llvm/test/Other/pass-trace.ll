@@ -0,0 +1,30 @@
+; RUN: opt < %s -instcombine -gvn -disable-output -pass-trace=%t.json
+; RUN: FileCheck %s < %t.json
+; RUN: opt < %s -instcombine -gvn -disable-output -pass-trace=%t.trace -pass-trace-format=chrome
+; RUN: FileCheck %s -check-prefix=CHROME < %t.trace
+
+; Every pass execution on every function is recorded with its time, the
+; instruction counts before and after, and the analyses it invalidated.
+
+; CHECK: [
+; CHECK: {"pass":"Combine redundant instructions","kind":"function","unit":"f","start_us":{{[0-9]+}},"end_us":{{[0-9]+}},"instructions_before":5,"instructions_after":4,"changed":true,"invalidated":[]}
+; CHECK: {"pass":"Global Value Numbering","kind":"function","unit":"f",{{.*}}"instructions_before":4,"instructions_after":3,"changed":true,"invalidated":[{{.*}}"Memory Dependence Analysis"{{.*}}]}
+; CHECK: {"pass":"Combine redundant instructions","kind":"function","unit":"g",{{.*}}"changed":false,"invalidated":[]}
+; CHECK: {"pass":"Module Verifier","kind":"function"
+; CHECK: ]
+
+; CHROME: {"traceEvents":[
+; CHROME: {"name":"Global Value Numbering","cat":"function","ph":"X","ts":{{[0-9]+}},"dur":{{[0-9]+}},"pid":1,"tid":1,"args":{"unit":"f","instructions_before":4,"instructions_after":3,"changed":true,"invalidated":[{{.*}}]}}
+; CHROME: ]}
+
+define i32 @f(i32 %a, i32 %b) {
+  %s = add i32 %a, 0
+  %x = add i32 %s, %b
+  %y = add i32 %a, %b
+  %z = mul i32 %x, %y
+  ret i32 %z
+}
+
+define void @g() {
+  ret void
+}
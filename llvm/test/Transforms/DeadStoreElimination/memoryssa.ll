@@ -0,0 +1,86 @@
+; RUN: opt < %s -basicaa -dse -S | FileCheck %s
+; RUN: opt < %s -basicaa -dse -enable-dse-memoryssa -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64"
+
+declare void @free(i8* nocapture)
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i32, i1) nounwind
+
+; The first store to %p is dead even though %q may alias it.
+; CHECK-LABEL: @killed_through_may_alias(
+; CHECK-NEXT: store i32 1, i32* %q
+; CHECK-NEXT: store i32 2, i32* %p
+; CHECK-NEXT: ret void
+define void @killed_through_may_alias(i32* %p, i32* %q) {
+  store i32 0, i32* %p
+  store i32 1, i32* %q
+  store i32 2, i32* %p
+  ret void
+}
+
+; A load of %p in between keeps the first store.
+; CHECK-LABEL: @read_in_between(
+; CHECK-NEXT: store i32 0, i32* %p
+; CHECK-NEXT: %x = load i32* %p
+; CHECK-NEXT: store i32 2, i32* %p
+define i32 @read_in_between(i32* %p) {
+  store i32 0, i32* %p
+  %x = load i32* %p
+  store i32 2, i32* %p
+  ret i32 %x
+}
+
+; A load of another object does not.
+; CHECK-LABEL: @read_other(
+; CHECK-NEXT: %x = load i32* %q
+; CHECK-NEXT: store i32 2, i32* %p
+define i32 @read_other(i32* noalias %p, i32* noalias %q) {
+  store i32 0, i32* %p
+  %x = load i32* %q
+  store i32 2, i32* %p
+  ret i32 %x
+}
+
+; Storing back the value just loaded is a no-op, and then so is the load.
+; CHECK-LABEL: @store_of_load(
+; CHECK-NEXT: store i32 1, i32* %q
+; CHECK-NEXT: ret void
+define void @store_of_load(i32* noalias %p, i32* noalias %q) {
+  %x = load i32* %p
+  store i32 1, i32* %q
+  store i32 %x, i32* %p
+  ret void
+}
+
+; The end of the memset is overwritten, so it is shortened.
+; CHECK-LABEL: @shorten(
+; CHECK: call void @llvm.memset.p0i8.i64(i8* %p, i8 0, i64 4, i32 8, i1 false)
+define void @shorten(i8* %p) {
+  call void @llvm.memset.p0i8.i64(i8* %p, i8 0, i64 8, i32 8, i1 false)
+  %g = getelementptr i8* %p, i64 4
+  %w = bitcast i8* %g to i32*
+  store i32 1, i32* %w
+  ret void
+}
+
+; Stores to an object that is freed are dead, including the ones in a
+; predecessor that always branches to the block of the free.
+; CHECK-LABEL: @freed(
+; CHECK: pred:
+; CHECK-NEXT: br label %bb
+; CHECK: bb:
+; CHECK-NEXT: call void @free(i8* %p)
+define void @freed(i8* %p) {
+entry:
+  br label %pred
+
+pred:
+  store i8 1, i8* %p
+  br label %bb
+
+bb:
+  %g = getelementptr i8* %p, i64 1
+  store i8 2, i8* %g
+  call void @free(i8* %p)
+  ret void
+}
@@ -0,0 +1,21 @@
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+
+; Profile use gives calls their execution count as !prof.  GVN keeps the
+; count of the call that replaces another one.
+
+declare i32 @f(i32) readnone
+
+define i32 @merge(i32 %x) {
+; CHECK-LABEL: @merge(
+; CHECK-NEXT: %a = call i32 @f(i32 %x), !prof !0
+; CHECK-NEXT: %c = add i32 %a, %a
+  %a = call i32 @f(i32 %x), !prof !0
+  %b = call i32 @f(i32 %x), !prof !1
+  %c = add i32 %a, %b
+  ret i32 %c
+}
+
+; CHECK: !0 = metadata !{metadata !"branch_weights", i64 100}
+
+!0 = metadata !{metadata !"branch_weights", i64 100}
+!1 = metadata !{metadata !"branch_weights", i64 60}
@@ -0,0 +1,30 @@
+; RUN: opt < %s -gvn -S | FileCheck %s -check-prefix=PRE
+; RUN: opt < %s -gvn -function-compile-budget-us=1 -stats -S 2>&1 | FileCheck %s -check-prefix=BUDGET
+; REQUIRES: asserts
+
+; Once a function has used up its budget, GVN no longer does PRE on it.  The
+; dominator tree and memory dependence passes GVN needs already use up one
+; microsecond.
+
+define i32 @f(i32 %p, i32 %q) {
+block1:
+  %cmp = icmp eq i32 %p, %q
+  br i1 %cmp, label %block2, label %block3
+
+block2:
+  %a = add i32 %p, 1
+  br label %block4
+
+block3:
+  br label %block4
+
+; PRE: block4:
+; PRE-NEXT: %b.pre-phi = phi i32
+; BUDGET: block4:
+; BUDGET-NEXT: %b = add i32 %p, 1
+block4:
+  %b = add i32 %p, 1
+  ret i32 %b
+}
+
+; BUDGET: 1 gvn - Number of functions over budget skipping PRE
@@ -1,4 +1,5 @@
 ; RUN: opt -gvn -disable-output < %s
+; RUN: opt -gvn -enable-gvn-memoryssa -disable-output < %s
 
 ; PR5631
 
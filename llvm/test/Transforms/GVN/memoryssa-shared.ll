@@ -0,0 +1,26 @@
+; RUN: opt < %s -basicaa -gvn -dse -enable-gvn-memoryssa -enable-dse-memoryssa -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -dse -enable-gvn-memoryssa -enable-dse-memoryssa -debug-pass=Structure -o /dev/null 2>&1 | FileCheck %s -check-prefix=STRUCT
+
+; GVN preserves MemorySSA, so DSE uses the form GVN kept up to date
+; instead of building its own.  Neither pass needs memdep.
+; STRUCT-NOT: Memory Dependence Analysis
+; STRUCT: Memory SSA
+; STRUCT-NEXT: Global Value Numbering
+; STRUCT-NOT: Memory SSA
+; STRUCT-NOT: Memory Dependence Analysis
+; STRUCT: Dead Store Elimination
+
+declare void @clobber()
+
+; GVN deletes the load; DSE then sees the first store killed by the second.
+; CHECK-LABEL: @f(
+; CHECK-NEXT: call void @clobber()
+; CHECK-NEXT: store i32 %w, i32* %p
+; CHECK-NEXT: ret i32 %v
+define i32 @f(i32* noalias %p, i32 %v, i32 %w) {
+  call void @clobber()
+  store i32 %v, i32* %p
+  %x = load i32* %p
+  store i32 %w, i32* %p
+  ret i32 %x
+}
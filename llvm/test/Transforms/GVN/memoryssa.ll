@@ -0,0 +1,148 @@
+; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -enable-gvn-memoryssa -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64"
+
+declare void @clobber()
+declare void @llvm.memset.p0i8.i64(i8* nocapture, i8, i64, i32, i1) nounwind
+
+; The load sees the store through the store to a distinct object.
+; CHECK-LABEL: @forward_store(
+; CHECK-NOT: load
+; CHECK: ret i32 %v
+define i32 @forward_store(i32* noalias %p, i32* noalias %q, i32 %v) {
+  store i32 %v, i32* %p
+  store i32 0, i32* %q
+  %x = load i32* %p
+  ret i32 %x
+}
+
+; A call that may write memory in between keeps the load.
+; CHECK-LABEL: @clobbered(
+; CHECK: call void @clobber()
+; CHECK-NEXT: %x = load i32* %p
+define i32 @clobbered(i32* %p, i32 %v) {
+  store i32 %v, i32* %p
+  call void @clobber()
+  %x = load i32* %p
+  ret i32 %x
+}
+
+; Loads that see the same version of memory have the same value.
+; CHECK-LABEL: @load_load(
+; CHECK: %x = load i32* %p
+; CHECK-NOT: load
+; CHECK: add i32 %x, %x
+define i32 @load_load(i32* noalias %p, i32* noalias %q) {
+  %x = load i32* %p
+  store i32 0, i32* %q
+  %y = load i32* %p
+  %z = add i32 %x, %y
+  ret i32 %z
+}
+
+; A byte of a memset is forwarded.
+; CHECK-LABEL: @memset_byte(
+; CHECK-NOT: load
+; CHECK: ret i8 7
+define i8 @memset_byte(i8* %p) {
+  call void @llvm.memset.p0i8.i64(i8* %p, i8 7, i64 16, i32 1, i1 false)
+  %g = getelementptr i8* %p, i64 3
+  %x = load i8* %g
+  ret i8 %x
+}
+
+; Nothing has been stored to a fresh alloca.
+; CHECK-LABEL: @fresh_alloca(
+; CHECK-NOT: load
+; CHECK: ret i32 undef
+define i32 @fresh_alloca() {
+  %a = alloca i32
+  %x = load i32* %a
+  ret i32 %x
+}
+
+; A load after a join is fully redundant with the values stored on both
+; sides.
+; CHECK-LABEL: @diamond(
+; CHECK: join:
+; CHECK-NEXT: %x = phi i32 [ 2, %right ], [ 1, %left ]
+; CHECK-NEXT: ret i32 %x
+define i32 @diamond(i32* %p, i1 %c) {
+entry:
+  br i1 %c, label %left, label %right
+
+left:
+  store i32 1, i32* %p
+  br label %join
+
+right:
+  store i32 2, i32* %p
+  br label %join
+
+join:
+  %x = load i32* %p
+  ret i32 %x
+}
+
+; The load in the loop is PRE'd into the preheader; the later load in the
+; loop body uses it.
+; CHECK-LABEL: @loop(
+; CHECK: entry:
+; CHECK-NEXT: %x.pre = load i32* %p
+; CHECK: loop:
+; CHECK-NOT: load
+; CHECK: exit:
+define i32 @loop(i32* noalias %p, i32* noalias %q, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %x = load i32* %p
+  store i32 %x, i32* %q
+  %y = load i32* %p
+  %i.next = add i32 %i, %y
+  %done = icmp sge i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 %i.next
+}
+
+declare i32 @read(i32*) readonly
+
+; Read-only calls that see the same version of memory have the same value,
+; in the same block or across blocks.
+; CHECK-LABEL: @readonly_calls(
+; CHECK: %x = call i32 @read(i32* %p)
+; CHECK-NOT: call i32 @read
+; CHECK: ret i32
+define i32 @readonly_calls(i32* noalias %p, i32* noalias %q, i1 %c) {
+entry:
+  %x = call i32 @read(i32* %p)
+  %y = call i32 @read(i32* %p)
+  br i1 %c, label %then, label %exit
+
+then:
+  %z = call i32 @read(i32* %p)
+  br label %exit
+
+exit:
+  %r = phi i32 [ %y, %entry ], [ %z, %then ]
+  %s = add i32 %x, %r
+  ret i32 %s
+}
+
+; A write in between gives the second call a value of its own.
+; CHECK-LABEL: @readonly_call_clobbered(
+; CHECK: %x = call i32 @read(i32* %p)
+; CHECK: store i32 0, i32* %p
+; CHECK: %y = call i32 @read(i32* %p)
+define i32 @readonly_call_clobbered(i32* %p) {
+  %x = call i32 @read(i32* %p)
+  store i32 0, i32* %p
+  %y = call i32 @read(i32* %p)
+  %s = add i32 %x, %y
+  ret i32 %s
+}
@@ -1,4 +1,5 @@
 ; RUN: opt < %s -basicaa -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -gvn -enable-gvn-memoryssa -S | FileCheck %s
 
 define i32 @main(i32** %p, i32 %x, i32 %y) {
 block1:
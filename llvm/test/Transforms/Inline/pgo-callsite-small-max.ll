@@ -0,0 +1,60 @@
+; RUN: opt < %s -inline -inline-threshold=50 -pgo-hot-callsite-percent=50 -S \
+; RUN:   | FileCheck %s
+
+; With a largest count below 100, a call site is only hot if it reaches the
+; given percentage of that count.
+
+@g = global i32 0
+
+define void @medium(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = xor i32 %b, %a
+  %d = mul i32 %c, %b
+  %e = sub i32 %d, %c
+  %f = mul i32 %e, %d
+  %h = xor i32 %f, %e
+  %i = mul i32 %h, %f
+  %j = add i32 %i, %h
+  %k = mul i32 %j, %i
+  %l = xor i32 %k, %j
+  %m = mul i32 %l, %k
+  %n = sub i32 %m, %l
+  %o = mul i32 %n, %m
+  %p = mul i32 %o, %n
+  %q = xor i32 %p, %o
+  %r = add i32 %q, %p
+  %s = sub i32 %r, %q
+  %t = mul i32 %s, %r
+  %u = xor i32 %t, %s
+  %v = add i32 %u, %t
+  %w = sub i32 %v, %u
+  %y = mul i32 %w, %v
+  %z = xor i32 %y, %w
+  %aa = add i32 %z, %y
+  %ab = sub i32 %aa, %z
+  %ac = mul i32 %ab, %aa
+  %ad = xor i32 %ac, %ab
+  store volatile i32 %ad, i32* @g
+  ret void
+}
+
+; CHECK-LABEL: define void @hot_site(
+; CHECK-NOT: call void @medium
+define void @hot_site(i32 %x) {
+  call void @medium(i32 %x), !prof !0
+  ret void
+}
+
+; CHECK-LABEL: define void @warm_site(
+; CHECK: call void @medium
+define void @warm_site(i32 %x) {
+  call void @medium(i32 %x), !prof !1
+  ret void
+}
+
+!llvm.module.flags = !{!2}
+
+!0 = metadata !{metadata !"branch_weights", i64 25}
+!1 = metadata !{metadata !"branch_weights", i64 24}
+!2 = metadata !{i32 7, metadata !"ProfileMaxCount", i64 50}
@@ -0,0 +1,73 @@
+; RUN: opt < %s -inline -inline-threshold=50 -S | FileCheck %s -check-prefix=LOW
+; RUN: opt < %s -inline -S | FileCheck %s -check-prefix=DEFAULT
+
+; Call sites with a profile count get the hot or cold threshold instead of the
+; default one.
+
+@g = global i32 0
+
+define void @medium(i32 %x) {
+  %a = add i32 %x, 1
+  %b = mul i32 %a, %x
+  %c = xor i32 %b, %a
+  %d = mul i32 %c, %b
+  %e = sub i32 %d, %c
+  %f = mul i32 %e, %d
+  %h = xor i32 %f, %e
+  %i = mul i32 %h, %f
+  %j = add i32 %i, %h
+  %k = mul i32 %j, %i
+  %l = xor i32 %k, %j
+  %m = mul i32 %l, %k
+  %n = sub i32 %m, %l
+  %o = mul i32 %n, %m
+  %p = mul i32 %o, %n
+  %q = xor i32 %p, %o
+  %r = add i32 %q, %p
+  %s = sub i32 %r, %q
+  %t = mul i32 %s, %r
+  %u = xor i32 %t, %s
+  %v = add i32 %u, %t
+  %w = sub i32 %v, %u
+  %y = mul i32 %w, %v
+  %z = xor i32 %y, %w
+  %aa = add i32 %z, %y
+  %ab = sub i32 %aa, %z
+  %ac = mul i32 %ab, %aa
+  %ad = xor i32 %ac, %ab
+  store volatile i32 %ad, i32* @g
+  ret void
+}
+
+; LOW-LABEL: define void @hot_site(
+; LOW-NOT: call void @medium
+; DEFAULT-LABEL: define void @hot_site(
+; DEFAULT-NOT: call void @medium
+define void @hot_site(i32 %x) {
+  call void @medium(i32 %x), !prof !0
+  ret void
+}
+
+; LOW-LABEL: define void @cold_site(
+; LOW: call void @medium
+; DEFAULT-LABEL: define void @cold_site(
+; DEFAULT: call void @medium
+define void @cold_site(i32 %x) {
+  call void @medium(i32 %x), !prof !1
+  ret void
+}
+
+; LOW-LABEL: define void @unprofiled_site(
+; LOW: call void @medium
+; DEFAULT-LABEL: define void @unprofiled_site(
+; DEFAULT-NOT: call void @medium
+define void @unprofiled_site(i32 %x) {
+  call void @medium(i32 %x)
+  ret void
+}
+
+!llvm.module.flags = !{!2}
+
+!0 = metadata !{metadata !"branch_weights", i64 1000}
+!1 = metadata !{metadata !"branch_weights", i64 0}
+!2 = metadata !{i32 7, metadata !"ProfileMaxCount", i64 1000}
@@ -0,0 +1,48 @@
+; RUN: opt < %s -instcombine -stats -S 2>&1 | FileCheck %s
+; RUN: opt < %s -instcombine -instcombine-max-iterations=0 -stats -S 2>&1 | FileCheck %s
+; RUN: opt < %s -instcombine -instcombine-max-iterations=1 -stats -S 2>&1 | FileCheck %s -check-prefix=LIMIT
+; REQUIRES: asserts
+
+; Both functions need a second sweep to see that nothing is left to do.
+; -instcombine-max-iterations=1 stops after the first one, and 0 sets no limit.
+
+define i32 @chain(i32 %x) {
+; CHECK-LABEL: @chain(
+; CHECK-NEXT: %c = shl i32 %x, 2
+; CHECK-NEXT: ret i32 %c
+  %a = add i32 %x, 1
+  %b = sub i32 %a, 1
+  %c = mul i32 %b, 4
+  %d = shl i32 %c, 0
+  ret i32 %d
+}
+
+define i32 @forward(i1 %c) {
+; CHECK-LABEL: @forward(
+; CHECK-NOT: alloca
+; CHECK: Cont:
+; CHECK-NEXT: %storemerge = phi i32 [ 2, %F ], [ 1, %T ]
+; CHECK-NEXT: ret i32 %storemerge
+entry:
+  %A = alloca i32
+  br i1 %c, label %T, label %F
+
+T:
+  store i32 1, i32* %A
+  br label %Cont
+
+F:
+  store i32 2, i32* %A
+  br label %Cont
+
+Cont:
+  %V = load i32* %A
+  ret i32 %V
+}
+
+; CHECK: 2 instcombine - Most sweeps over a single function
+; CHECK: 4 instcombine - Number of sweeps over whole functions
+
+; LIMIT: 1 instcombine - Most sweeps over a single function
+; LIMIT: 2 instcombine - Number of functions that hit the sweep limit
+; LIMIT: 2 instcombine - Number of sweeps over whole functions
@@ -0,0 +1,107 @@
+; RUN: opt < %s -domtree -jump-threading -verify-dom-info -S | FileCheck %s
+
+; Jump threading keeps the dominator tree up to date instead of throwing it
+; away.  -verify-dom-info checks it against a fresh one after the pass.
+
+declare i32 @f1()
+declare i32 @f2()
+declare void @f3()
+
+; The branch on %A is threaded from both predecessors, which leaves Merge dead;
+; the blocks left with a single predecessor are then merged into it.
+define i32 @thread(i1 %cond) {
+; CHECK-LABEL: @thread(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: br i1 %cond, label %T2, label %F2
+; CHECK-NOT: Merge:
+entry:
+  br i1 %cond, label %T1, label %F1
+
+T1:
+  %v1 = call i32 @f1()
+  br label %Merge
+
+F1:
+  %v2 = call i32 @f2()
+  br label %Merge
+
+Merge:
+  %A = phi i1 [ true, %T1 ], [ false, %F1 ]
+  %B = phi i32 [ %v1, %T1 ], [ %v2, %F1 ]
+  br i1 %A, label %T2, label %F2
+
+T2:
+  call void @f3()
+  ret i32 %B
+
+F2:
+  ret i32 %B
+}
+
+; The edge from Other is threaded straight to F, and what is left of BB is
+; merged into Pred.
+define i32 @duplicate(i1 %c, i32 %x) {
+; CHECK-LABEL: @duplicate(
+; CHECK-NEXT: entry:
+; CHECK-NEXT: br i1 %c, label %BB, label %F
+; CHECK: BB:
+; CHECK: br i1 %cmp, label %T, label %F
+entry:
+  br i1 %c, label %Pred, label %Other
+
+Pred:
+  %y = add i32 %x, 1
+  br label %BB
+
+Other:
+  br label %BB
+
+BB:
+  %p = phi i32 [ %y, %Pred ], [ 7, %Other ]
+  %cmp = icmp eq i32 %p, 8
+  br i1 %cmp, label %T, label %F
+
+T:
+  ret i32 1
+
+F:
+  ret i32 0
+}
+
+; A conditional branch on a constant is folded, which leaves B dead, and the
+; remaining chain of blocks collapses into the entry block.
+define i32 @fold(i32 %x) {
+; CHECK-LABEL: @fold(
+; CHECK-NEXT: C:
+; CHECK-NEXT: ret i32 1
+entry:
+  br i1 true, label %A, label %B
+
+A:
+  br label %C
+
+B:
+  br label %C
+
+C:
+  %r = phi i32 [ 1, %A ], [ 2, %B ]
+  ret i32 %r
+}
+
+; Jump threading folds the entry block into its only successor.
+define i32 @entry_merge(i32 %x) {
+; CHECK-LABEL: @entry_merge(
+; CHECK-NEXT: next:
+entry:
+  br label %next
+
+next:
+  %c = icmp eq i32 %x, 0
+  br i1 %c, label %a, label %b
+
+a:
+  ret i32 1
+
+b:
+  ret i32 2
+}
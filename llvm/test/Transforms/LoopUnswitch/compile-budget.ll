@@ -0,0 +1,28 @@
+; RUN: opt < %s -loop-unswitch -S | FileCheck %s -check-prefix=UNSWITCH
+; RUN: opt < %s -loop-unswitch -function-compile-budget-us=1 -S | FileCheck %s -check-prefix=BUDGET
+
+; A function that has used up its compile-time budget is not unswitched.
+
+; UNSWITCH: br i1 %c, label %{{.*}}, label %{{.*}}
+; UNSWITCH: loop.us:
+; BUDGET-NOT: .us:
+define void @f(i32* %p, i1 %c, i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  br i1 %c, label %then, label %latch
+
+then:
+  store volatile i32 %i, i32* %p
+  br label %latch
+
+latch:
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
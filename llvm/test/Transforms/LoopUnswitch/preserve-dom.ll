@@ -0,0 +1,74 @@
+; RUN: opt < %s -loop-unswitch -verify-loop-info -verify-dom-info -S | FileCheck %s
+
+; Loop unswitching updates the dominator tree as it goes instead of
+; recomputing it after every loop.  -verify-dom-info checks it against a
+; fresh one after the pass.
+
+declare void @a()
+declare void @b()
+
+; The inner loop is unswitched on %c inside the outer loop, and then the
+; outer loop is unswitched on it as well, so both loops are copied.
+define void @nested(i1 %c, i32 %n) {
+; CHECK-LABEL: @nested(
+; CHECK: entry:
+; CHECK-NEXT: br i1 %c, label %entry.split.us, label %entry.entry.split_crit_edge
+; CHECK: outer.us:
+; CHECK: outer:
+; CHECK: br i1 false, label %outer.split.us, label %outer.outer.split_crit_edge
+entry:
+  br label %outer
+
+outer:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %j = phi i32 [ 0, %outer ], [ %j.next, %inner.latch ]
+  br i1 %c, label %then, label %else
+
+then:
+  call void @a()
+  br label %inner.latch
+
+else:
+  call void @b()
+  br label %inner.latch
+
+inner.latch:
+  %j.next = add i32 %j, 1
+  %inner.done = icmp eq i32 %j.next, %n
+  br i1 %inner.done, label %outer.latch, label %inner
+
+outer.latch:
+  %i.next = add i32 %i, 1
+  %outer.done = icmp eq i32 %i.next, %n
+  br i1 %outer.done, label %exit, label %outer
+
+exit:
+  ret void
+}
+
+; A trivial unswitch moves the exit test on %c out of the loop.
+define void @trivial(i1 %c, i32 %n) {
+; CHECK-LABEL: @trivial(
+; CHECK: entry:
+; CHECK-NEXT: br i1 %c, label %entry.exit.split_crit_edge, label %entry.entry.split_crit_edge
+; CHECK: loop:
+; CHECK: br i1 false, label %exit, label %latch
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  br i1 %c, label %exit, label %latch
+
+latch:
+  call void @a()
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
@@ -0,0 +1,215 @@
+; RUN: opt < %s -loop-vectorize -mtriple=x86_64-apple-macosx10.8.0 -mcpu=corei7-avx -S | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.8.0"
+
+@buf = global [1024 x i32] zeroinitializer, align 16
+
+; A search loop with a second exit. The vector loop leaves as soon as any lane
+; matches and the scalar loop finds the exact index.
+;
+; int search(int key) {
+;   for (int i = 0; i < 1024; ++i)
+;     if (buf[i] == key)
+;       return i;
+;   return -1;
+; }
+
+; CHECK-LABEL: @search(
+; CHECK: vector.body:
+; CHECK: icmp eq <4 x i32>
+; CHECK: %any.exit = icmp ne i128 %{{.*}}, 0
+; CHECK: br i1 %any.exit, label %vector.early.exit, label %vector.body.latch
+; CHECK: vector.body.latch:
+; CHECK: br i1 %{{.*}}, label %middle.block, label %vector.body
+; CHECK: vector.early.exit:
+; CHECK: br label %middle.block
+; CHECK: middle.block:
+; CHECK: %resume.val = phi i64 [ 0, %entry ], [ 1024, %vector.body.latch ], [ %index, %vector.early.exit ]
+; CHECK: ret i32
+define i32 @search(i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %arrayidx = getelementptr inbounds [1024 x i32]* @buf, i64 0, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %cmp1 = icmp eq i32 %0, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1024
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %iv to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
+
+; Other inductions resume at their value for the first lane of the chunk.
+
+; CHECK-LABEL: @rsearch(
+; CHECK: vector.early.exit:
+; CHECK: %early.exit.count = sub i64 %index, 0
+; CHECK: %rev.ind.val = sub i64 1023, %early.exit.count
+; CHECK: middle.block:
+; CHECK: phi i64 [ 1023, %entry ], [ -1, %vector.body.latch ], [ %rev.ind.val, %vector.early.exit ]
+; CHECK: ret i32
+define i32 @rsearch(i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %j = phi i64 [ 1023, %entry ], [ %j.next, %for.inc ]
+  %arrayidx = getelementptr inbounds [1024 x i32]* @buf, i64 0, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %cmp1 = icmp eq i32 %0, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %j.next = add i64 %j, -1
+  %exitcond = icmp eq i64 %iv.next, 1024
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %j to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
+
+; The loads may run past the matching element, so the accessed object must be
+; known to be large enough for the whole trip count.
+
+; CHECK-LABEL: @search_ptr(
+; CHECK-NOT: any.exit
+; CHECK: ret i32
+define i32 @search_ptr(i32* %p, i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %arrayidx = getelementptr inbounds i32* %p, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %cmp1 = icmp eq i32 %0, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1024
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %iv to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
+
+; CHECK-LABEL: @search_past_end(
+; CHECK-NOT: any.exit
+; CHECK: ret i32
+define i32 @search_past_end(i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %arrayidx = getelementptr inbounds [1024 x i32]* @buf, i64 0, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %cmp1 = icmp eq i32 %0, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 2048
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %iv to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
+
+; Stores before the exit would have to be undone.
+
+; CHECK-LABEL: @search_and_clear(
+; CHECK-NOT: any.exit
+; CHECK: ret i32
+define i32 @search_and_clear(i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %arrayidx = getelementptr inbounds [1024 x i32]* @buf, i64 0, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  store i32 0, i32* %arrayidx, align 4
+  %cmp1 = icmp eq i32 %0, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 1024
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %iv to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
+
+; Nor may the lanes after the exit trap. Here the scalar loop returns at i = 0
+; and never divides by the zero at i = 1.
+;
+; int divisors[16] = { 1, 0, 1, 0, ... };
+; int find_quotient(unsigned key) {
+;   for (int i = 0; i < 16; ++i)
+;     if (100u / divisors[i] == key)
+;       return i;
+;   return -1;
+; }
+
+@divisors = global [16 x i32] [i32 1, i32 0, i32 1, i32 0, i32 1, i32 0, i32 1, i32 0, i32 1, i32 0, i32 1, i32 0, i32 1, i32 0, i32 1, i32 0], align 16
+
+; CHECK-LABEL: @find_quotient(
+; CHECK-NOT: any.exit
+; CHECK: ret i32
+define i32 @find_quotient(i32 %key) {
+entry:
+  br label %for.body
+
+for.body:
+  %iv = phi i64 [ 0, %entry ], [ %iv.next, %for.inc ]
+  %arrayidx = getelementptr inbounds [16 x i32]* @divisors, i64 0, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %div = udiv i32 100, %0
+  %cmp1 = icmp eq i32 %div, %key
+  br i1 %cmp1, label %found, label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %exitcond = icmp eq i64 %iv.next, 16
+  br i1 %exitcond, label %notfound, label %for.body
+
+found:
+  %idx = trunc i64 %iv to i32
+  ret i32 %idx
+
+notfound:
+  ret i32 -1
+}
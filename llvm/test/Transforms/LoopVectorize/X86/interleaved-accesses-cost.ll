@@ -0,0 +1,91 @@
+; RUN: opt < %s -loop-vectorize -enable-interleaved-mem-accesses -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7 -debug-only=loop-vectorize -S -o /dev/null 2>&1 | FileCheck %s
+; REQUIRES: asserts
+; Check the cost of interleaved groups of loads and stores. A group is costed
+; once, at the member where it is emitted, and the other members are free.
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+
+; Three <4 x float> loads and three shuffles per field.
+; CHECK: LV: Checking a loop in "gray"
+; CHECK: LV: Found an interleave group of factor 3 with 3 members at   %r = load
+; CHECK: LV: Found an estimated cost of 12 for VF 4 For instruction:   %r = load
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   %g = load
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   %b = load
+; CHECK: LV: Selecting VF = : 4.
+
+define void @gray(float* noalias %rgb, float* noalias %gray, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i3 = mul nsw i64 %i, 3
+  %pr = getelementptr inbounds float* %rgb, i64 %i3
+  %r = load float* %pr, align 4
+  %i31 = add nsw i64 %i3, 1
+  %pg = getelementptr inbounds float* %rgb, i64 %i31
+  %g = load float* %pg, align 4
+  %i32 = add nsw i64 %i3, 2
+  %pb = getelementptr inbounds float* %rgb, i64 %i32
+  %b = load float* %pb, align 4
+  %r1 = fmul float %r, 5.0e-01
+  %g1 = fmul float %g, 2.5e-01
+  %b1 = fmul float %b, 1.25e-01
+  %s = fadd float %r1, %g1
+  %s2 = fadd float %s, %b1
+  %pd = getelementptr inbounds float* %gray, i64 %i
+  store float %s2, float* %pd, align 4
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; Two <4 x float> loads or stores and one shuffle per field.
+; CHECK: LV: Checking a loop in "cmul"
+; CHECK: LV: Found an interleave group of factor 2 with 2 members at   %are = load
+; CHECK: LV: Found an interleave group of factor 2 with 2 members at   %bre = load
+; CHECK: LV: Found an interleave group of factor 2 with 2 members at   store float %im
+; CHECK: LV: Found an estimated cost of 4 for VF 4 For instruction:   %are = load
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   %aim = load
+; CHECK: LV: Found an estimated cost of 4 for VF 4 For instruction:   %bre = load
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   %bim = load
+; CHECK: LV: Found an estimated cost of 0 for VF 4 For instruction:   store float %re
+; CHECK: LV: Found an estimated cost of 4 for VF 4 For instruction:   store float %im
+; CHECK: LV: Selecting VF = : 4.
+
+define void @cmul(float* %a, float* noalias %b, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i2 = shl nsw i64 %i, 1
+  %i21 = or i64 %i2, 1
+  %pare = getelementptr inbounds float* %a, i64 %i2
+  %paim = getelementptr inbounds float* %a, i64 %i21
+  %pbre = getelementptr inbounds float* %b, i64 %i2
+  %pbim = getelementptr inbounds float* %b, i64 %i21
+  %are = load float* %pare, align 4
+  %aim = load float* %paim, align 4
+  %bre = load float* %pbre, align 4
+  %bim = load float* %pbim, align 4
+  %t1 = fmul float %are, %bre
+  %t2 = fmul float %aim, %bim
+  %re = fsub float %t1, %t2
+  %t3 = fmul float %are, %bim
+  %t4 = fmul float %aim, %bre
+  %im = fadd float %t3, %t4
+  store float %re, float* %pare, align 4
+  store float %im, float* %paim, align 4
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
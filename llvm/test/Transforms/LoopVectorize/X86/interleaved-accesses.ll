@@ -0,0 +1,200 @@
+; RUN: opt -S -loop-vectorize -force-vector-unroll=1 -enable-interleaved-mem-accesses -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7 < %s | FileCheck %s
+; RUN: opt -S -loop-vectorize -force-vector-unroll=1 -enable-interleaved-mem-accesses=false -mtriple=x86_64-unknown-linux-gnu -mcpu=corei7 < %s | FileCheck %s -check-prefix=DISABLED
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+
+; The three loads of a pixel form a group of factor 3 and are loaded with one
+; wide load and split with shuffles.
+;
+; void gray(float *restrict rgb, float *restrict gray, long n) {
+;   for (long i = 0; i < n; ++i)
+;     gray[i] = rgb[3*i] * 0.5f + rgb[3*i+1] * 0.25f + rgb[3*i+2] * 0.125f;
+; }
+
+; CHECK-LABEL: @gray(
+; CHECK: vector.body:
+; CHECK: %wide.vec = load <12 x float>* %{{.*}}, align 4
+; CHECK: %strided.vec = shufflevector <12 x float> %wide.vec, <12 x float> undef, <4 x i32> <i32 0, i32 3, i32 6, i32 9>
+; CHECK: %strided.vec1 = shufflevector <12 x float> %wide.vec, <12 x float> undef, <4 x i32> <i32 1, i32 4, i32 7, i32 10>
+; CHECK: %strided.vec2 = shufflevector <12 x float> %wide.vec, <12 x float> undef, <4 x i32> <i32 2, i32 5, i32 8, i32 11>
+; CHECK: fmul <4 x float> %strided.vec,
+; CHECK: fmul <4 x float> %strided.vec1,
+; CHECK: fmul <4 x float> %strided.vec2,
+; CHECK: store <4 x float>
+; CHECK: middle.block:
+
+; DISABLED-LABEL: @gray(
+; DISABLED-NOT: wide.vec
+; DISABLED: ret void
+
+define void @gray(float* noalias %rgb, float* noalias %gray, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i3 = mul nsw i64 %i, 3
+  %pr = getelementptr inbounds float* %rgb, i64 %i3
+  %r = load float* %pr, align 4
+  %i31 = add nsw i64 %i3, 1
+  %pg = getelementptr inbounds float* %rgb, i64 %i31
+  %g = load float* %pg, align 4
+  %i32 = add nsw i64 %i3, 2
+  %pb = getelementptr inbounds float* %rgb, i64 %i32
+  %b = load float* %pb, align 4
+  %r1 = fmul float %r, 5.0e-01
+  %g1 = fmul float %g, 2.5e-01
+  %b1 = fmul float %b, 1.25e-01
+  %s = fadd float %r1, %g1
+  %s2 = fadd float %s, %b1
+  %pd = getelementptr inbounds float* %gray, i64 %i
+  store float %s2, float* %pd, align 4
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; An in-place complex multiply: the real and imaginary parts of a are read and
+; written as groups of factor 2. The loads and stores of a access different
+; fields of the same elements, so they do not depend on each other across
+; iterations.
+;
+; void cmul(float *a, float *restrict b, long n) {
+;   for (long i = 0; i < n; ++i) {
+;     float re = a[2*i] * b[2*i] - a[2*i+1] * b[2*i+1];
+;     float im = a[2*i] * b[2*i+1] + a[2*i+1] * b[2*i];
+;     a[2*i] = re;
+;     a[2*i+1] = im;
+;   }
+; }
+
+; CHECK-LABEL: @cmul(
+; CHECK: vector.body:
+; CHECK: %wide.vec = load <8 x float>* %{{.*}}, align 4
+; CHECK: shufflevector <8 x float> %wide.vec, <8 x float> undef, <4 x i32> <i32 0, i32 2, i32 4, i32 6>
+; CHECK: shufflevector <8 x float> %wide.vec, <8 x float> undef, <4 x i32> <i32 1, i32 3, i32 5, i32 7>
+; CHECK: load <8 x float>
+; CHECK: [[RE:%.*]] = fsub <4 x float>
+; CHECK: [[IM:%.*]] = fadd <4 x float>
+; CHECK: [[CAT:%.*]] = shufflevector <4 x float> [[RE]], <4 x float> [[IM]], <8 x i32> <i32 0, i32 1, i32 2, i32 3, i32 4, i32 5, i32 6, i32 7>
+; CHECK: %interleaved.vec = shufflevector <8 x float> [[CAT]], <8 x float> undef, <8 x i32> <i32 0, i32 4, i32 1, i32 5, i32 2, i32 6, i32 3, i32 7>
+; CHECK: store <8 x float> %interleaved.vec, <8 x float>* %{{.*}}, align 4
+; CHECK: middle.block:
+
+; DISABLED-LABEL: @cmul(
+; DISABLED-NOT: <4 x float>
+; DISABLED: ret void
+
+define void @cmul(float* %a, float* noalias %b, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i2 = shl nsw i64 %i, 1
+  %i21 = or i64 %i2, 1
+  %pare = getelementptr inbounds float* %a, i64 %i2
+  %paim = getelementptr inbounds float* %a, i64 %i21
+  %pbre = getelementptr inbounds float* %b, i64 %i2
+  %pbim = getelementptr inbounds float* %b, i64 %i21
+  %are = load float* %pare, align 4
+  %aim = load float* %paim, align 4
+  %bre = load float* %pbre, align 4
+  %bim = load float* %pbim, align 4
+  %t1 = fmul float %are, %bre
+  %t2 = fmul float %aim, %bim
+  %re = fsub float %t1, %t2
+  %t3 = fmul float %are, %bim
+  %t4 = fmul float %aim, %bre
+  %im = fadd float %t3, %t4
+  store float %re, float* %pare, align 4
+  store float %im, float* %paim, align 4
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; Only two of the three fields are stored. A wide store would overwrite the
+; third field, so the stores are not grouped.
+;
+; void fill(int *restrict p, int x, int y, long n) {
+;   for (long i = 0; i < n; ++i) {
+;     p[3*i] = x;
+;     p[3*i+1] = y;
+;   }
+; }
+
+; CHECK-LABEL: @fill(
+; CHECK-NOT: interleaved.vec
+; CHECK: ret void
+
+define void @fill(i32* noalias %p, i32 %x, i32 %y, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %i3 = mul nsw i64 %i, 3
+  %p0 = getelementptr inbounds i32* %p, i64 %i3
+  store i32 %x, i32* %p0, align 4
+  %i31 = add nsw i64 %i3, 1
+  %p1 = getelementptr inbounds i32* %p, i64 %i31
+  store i32 %y, i32* %p1, align 4
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret void
+}
+
+; A load group may skip fields in the middle: fields 0 and 2 of a stride 3
+; are read with one wide load.
+;
+; int sum02(int *restrict p, long n) {
+;   int s = 0;
+;   for (long i = 0; i < n; ++i)
+;     s += p[3*i] + p[3*i+2];
+;   return s;
+; }
+
+; CHECK-LABEL: @sum02(
+; CHECK: vector.body:
+; CHECK: %wide.vec = load <12 x i32>* %{{.*}}, align 4
+; CHECK: shufflevector <12 x i32> %wide.vec, <12 x i32> undef, <4 x i32> <i32 0, i32 3, i32 6, i32 9>
+; CHECK: shufflevector <12 x i32> %wide.vec, <12 x i32> undef, <4 x i32> <i32 2, i32 5, i32 8, i32 11>
+; CHECK: middle.block:
+
+define i32 @sum02(i32* noalias %p, i64 %n) {
+entry:
+  %cmp = icmp sgt i64 %n, 0
+  br i1 %cmp, label %loop, label %exit
+
+loop:
+  %i = phi i64 [ 0, %entry ], [ %i.next, %loop ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  %i3 = mul nsw i64 %i, 3
+  %p0 = getelementptr inbounds i32* %p, i64 %i3
+  %v0 = load i32* %p0, align 4
+  %i32 = add nsw i64 %i3, 2
+  %p2 = getelementptr inbounds i32* %p, i64 %i32
+  %v2 = load i32* %p2, align 4
+  %a = add nsw i32 %v0, %v2
+  %s.next = add nsw i32 %s, %a
+  %i.next = add nsw i64 %i, 1
+  %done = icmp eq i64 %i.next, %n
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ %s.next, %loop ]
+  ret i32 %r
+}
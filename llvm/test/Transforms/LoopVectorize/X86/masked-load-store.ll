@@ -0,0 +1,129 @@
+; RUN: opt < %s -loop-vectorize -mtriple=x86_64-apple-macosx10.8.0 -mcpu=corei7-avx -S | FileCheck %s -check-prefix=AVX
+; RUN: opt < %s -loop-vectorize -mtriple=x86_64-apple-macosx10.8.0 -mcpu=corei7 -S | FileCheck %s -check-prefix=SSE
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.8.0"
+
+; Stores and loads that only happen under a condition are vectorized with
+; masked memory intrinsics when the target supports them.
+;
+; void filter(int *a, int *b, int *c, int n) {
+;   for (int i = 0; i < n; ++i)
+;     if (a[i] > 100)
+;       b[i] = c[i] + a[i];
+; }
+
+; AVX-LABEL: @filter(
+; AVX: vector.body:
+; AVX: %wide.load = load <8 x i32>
+; AVX: %wide.masked.load = call <8 x i32> @llvm.masked.load.v8i32.p0v8i32.v8i1(<8 x i32>* %{{.*}}, i32 4, <8 x i1> %{{.*}}, <8 x i32> undef)
+; AVX: call void @llvm.masked.store.v8i32.p0v8i32.v8i1(<8 x i32> %{{.*}}, <8 x i32>* %{{.*}}, i32 4, <8 x i1> %{{.*}})
+; AVX: ret void
+; SSE-LABEL: @filter(
+; SSE-NOT: vector.body:
+; SSE-NOT: @llvm.masked
+; SSE: ret void
+define void @filter(i32* noalias %a, i32* noalias %b, i32* noalias %c, i32 %n) {
+entry:
+  %cmp10 = icmp sgt i32 %n, 0
+  br i1 %cmp10, label %for.body, label %for.end
+
+for.body:
+  %iv = phi i64 [ %iv.next, %for.inc ], [ 0, %entry ]
+  %arrayidx = getelementptr inbounds i32* %a, i64 %iv
+  %0 = load i32* %arrayidx, align 4
+  %cmp1 = icmp sgt i32 %0, 100
+  br i1 %cmp1, label %if.then, label %for.inc
+
+if.then:
+  %arrayidx3 = getelementptr inbounds i32* %c, i64 %iv
+  %1 = load i32* %arrayidx3, align 4
+  %add = add nsw i32 %1, %0
+  %arrayidx5 = getelementptr inbounds i32* %b, i64 %iv
+  store i32 %add, i32* %arrayidx5, align 4
+  br label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %lftr.wideiv = trunc i64 %iv.next to i32
+  %exitcond = icmp eq i32 %lftr.wideiv, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; Conditional doubles use the 64-bit element form.
+;
+; void clamp(double *a, double lim, int n) {
+;   for (int i = 0; i < n; ++i)
+;     if (a[i] > lim)
+;       a[i] = lim;
+; }
+
+; AVX-LABEL: @clamp(
+; AVX: call void @llvm.masked.store.v4f64.p0v4f64.v4i1(<4 x double>
+; AVX: ret void
+define void @clamp(double* nocapture %a, double %lim, i32 %n) {
+entry:
+  %cmp6 = icmp sgt i32 %n, 0
+  br i1 %cmp6, label %for.body, label %for.end
+
+for.body:
+  %iv = phi i64 [ %iv.next, %for.inc ], [ 0, %entry ]
+  %arrayidx = getelementptr inbounds double* %a, i64 %iv
+  %0 = load double* %arrayidx, align 8
+  %cmp1 = fcmp ogt double %0, %lim
+  br i1 %cmp1, label %if.then, label %for.inc
+
+if.then:
+  store double %lim, double* %arrayidx, align 8
+  br label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %lftr.wideiv = trunc i64 %iv.next to i32
+  %exitcond = icmp eq i32 %lftr.wideiv, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
+
+; There is no masked move for bytes, so this loop stays scalar.
+;
+; void filter8(char *a, char *b, int n) {
+;   for (int i = 0; i < n; ++i)
+;     if (a[i])
+;       b[i] = a[i];
+; }
+
+; AVX-LABEL: @filter8(
+; AVX-NOT: @llvm.masked
+; AVX: ret void
+define void @filter8(i8* noalias %a, i8* noalias %b, i32 %n) {
+entry:
+  %cmp8 = icmp sgt i32 %n, 0
+  br i1 %cmp8, label %for.body, label %for.end
+
+for.body:
+  %iv = phi i64 [ %iv.next, %for.inc ], [ 0, %entry ]
+  %arrayidx = getelementptr inbounds i8* %a, i64 %iv
+  %0 = load i8* %arrayidx, align 1
+  %tobool = icmp eq i8 %0, 0
+  br i1 %tobool, label %for.inc, label %if.then
+
+if.then:
+  %arrayidx4 = getelementptr inbounds i8* %b, i64 %iv
+  store i8 %0, i8* %arrayidx4, align 1
+  br label %for.inc
+
+for.inc:
+  %iv.next = add i64 %iv, 1
+  %lftr.wideiv = trunc i64 %iv.next to i32
+  %exitcond = icmp eq i32 %lftr.wideiv, %n
+  br i1 %exitcond, label %for.end, label %for.body
+
+for.end:
+  ret void
+}
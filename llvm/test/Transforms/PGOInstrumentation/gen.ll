@@ -0,0 +1,78 @@
+; RUN: opt < %s -pgo-instr-gen -S | FileCheck %s
+
+; Counter 0 counts the entries, and each successor of a conditional branch or
+; switch has its own counter.  Edges to blocks with other predecessors are
+; split to hold theirs.
+
+; CHECK: @__llvm_pgo_counters_diamond = private global [3 x i64] zeroinitializer
+; CHECK: @__llvm_pgo_name_diamond = private unnamed_addr constant [8 x i8] c"diamond\00"
+; CHECK: @__llvm_pgo_counters_cases = private global [4 x i64] zeroinitializer
+; CHECK: @__llvm_pgo_counters_straight = private global [1 x i64] zeroinitializer
+; CHECK: @__llvm_pgo_functions = private constant [3 x { i8*, i64, i32, i64* }]
+; CHECK-NOT: @__llvm_pgo_counters_external
+; CHECK: @llvm.global_ctors = appending global {{.*}} @__llvm_pgo_init
+
+define i32 @diamond(i1 %c) {
+; CHECK-LABEL: @diamond(
+; CHECK: entry:
+; CHECK-NEXT: load i64* getelementptr inbounds ([3 x i64]* @__llvm_pgo_counters_diamond, i64 0, i64 0)
+; CHECK: br i1 %c, label %then, label %else
+entry:
+  br i1 %c, label %then, label %else
+
+; CHECK: then:
+; CHECK-NEXT: load i64* getelementptr inbounds ([3 x i64]* @__llvm_pgo_counters_diamond, i64 0, i64 1)
+then:
+  br label %exit
+
+; CHECK: else:
+; CHECK-NEXT: load i64* getelementptr inbounds ([3 x i64]* @__llvm_pgo_counters_diamond, i64 0, i64 2)
+else:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 1, %then ], [ 2, %else ]
+  ret i32 %r
+}
+
+define void @cases(i32 %x) {
+; CHECK-LABEL: @cases(
+; CHECK: switch i32 %x, label %[[DEFAULT:.*]] [
+; CHECK-NEXT: i32 0, label %one
+; CHECK-NEXT: i32 1, label %[[CASE1:.*]]
+; CHECK-NEXT: ]
+entry:
+  switch i32 %x, label %exit [
+    i32 0, label %one
+    i32 1, label %exit
+  ]
+
+; CHECK: [[CASE1]]:
+; CHECK-NEXT: load i64* getelementptr inbounds ([4 x i64]* @__llvm_pgo_counters_cases, i64 0, i64 3)
+; CHECK: br label %exit
+
+; CHECK: [[DEFAULT]]:
+; CHECK-NEXT: load i64* getelementptr inbounds ([4 x i64]* @__llvm_pgo_counters_cases, i64 0, i64 1)
+; CHECK: br label %exit
+
+; CHECK: one:
+; CHECK-NEXT: load i64* getelementptr inbounds ([4 x i64]* @__llvm_pgo_counters_cases, i64 0, i64 2)
+one:
+  br label %exit
+
+; CHECK: exit:
+; CHECK-NEXT: ret void
+exit:
+  ret void
+}
+
+define void @straight() {
+; CHECK-LABEL: @straight(
+; CHECK-NEXT: load i64* getelementptr inbounds ([1 x i64]* @__llvm_pgo_counters_straight, i64 0, i64 0)
+  ret void
+}
+
+declare void @external()
+
+; CHECK-LABEL: define internal void @__llvm_pgo_init()
+; CHECK: call void @llvm_pgo_register_functions({ i8*, i64, i32, i64* }* getelementptr inbounds ([3 x { i8*, i64, i32, i64* }]* @__llvm_pgo_functions, i64 0, i64 0), i32 3)
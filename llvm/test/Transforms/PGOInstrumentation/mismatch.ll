@@ -0,0 +1,32 @@
+; RUN: opt < %s -pgo-instr-use -pgo-profile-file=%S/Inputs/use.pgodata -S | FileCheck %s
+
+; The profile of @classify was taken before its CFG changed, so its counters
+; no longer belong to its branches and are ignored.  @hot is unchanged.
+
+define void @hot() {
+  ret void
+}
+
+; CHECK-LABEL: define i32 @classify(i32 %x) {
+; CHECK: br i1 %small, label %common, label %exit{{$}}
+define i32 @classify(i32 %x) {
+entry:
+  %small = icmp slt i32 %x, 1000
+  br i1 %small, label %common, label %exit
+
+common:
+  call void @hot()
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %entry ], [ 1, %common ]
+  ret i32 %r
+}
+
+; A function missing from the profile is left alone.
+; CHECK-LABEL: define void @unknown() {
+define void @unknown() {
+  ret void
+}
+
+; CHECK: attributes #0 = { "pgo-entry-count"="1251" }
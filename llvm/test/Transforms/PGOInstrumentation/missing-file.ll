@@ -0,0 +1,7 @@
+; RUN: not opt < %s -pgo-instr-use -pgo-profile-file=%S/Inputs/no-such-file.pgodata -S 2>&1 | FileCheck %s
+
+; CHECK: error: could not read profile '{{.*}}no-such-file.pgodata'
+
+define void @f() {
+  ret void
+}
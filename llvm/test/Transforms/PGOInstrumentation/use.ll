@@ -0,0 +1,107 @@
+; RUN: opt < %s -pgo-instr-use -pgo-profile-file=%S/Inputs/use.pgodata -S | FileCheck %s
+
+; Inputs/use.pgodata was written by running this file built with counters:
+;   opt < use.ll -pgo-instr-gen | llc -o use.s
+;   cc use.s compiler-rt/lib/profile/PGOProfiling.c && LLVM_PGO_FILE=use.pgodata ./a.out
+; @main calls @classify with 0 to 1000, and never calls @never.
+
+@sink = global i32 0
+
+define void @hot() noinline {
+  store volatile i32 1, i32* @sink
+  ret void
+}
+
+define void @rare() noinline {
+  store volatile i32 2, i32* @sink
+  ret void
+}
+
+; CHECK-LABEL: define i32 @classify(i32 %x) #2
+define i32 @classify(i32 %x) {
+entry:
+  %small = icmp slt i32 %x, 1000
+; CHECK: br i1 %small, label %common, label %uncommon, !prof ![[SMALL:[0-9]+]]
+  br i1 %small, label %common, label %uncommon
+
+common:
+; CHECK: call void @hot(), !prof ![[COMMON_CALL:[0-9]+]]
+  call void @hot()
+  br label %select
+
+uncommon:
+; CHECK: call void @rare(), !prof ![[RARE_CALL:[0-9]+]]
+  call void @rare()
+  br label %select
+
+select:
+  %m = and i32 %x, 3
+; CHECK: switch i32 %m, label %exit [
+; CHECK: ], !prof ![[SWITCH:[0-9]+]]
+  switch i32 %m, label %exit [
+    i32 0, label %zero
+    i32 1, label %one
+  ]
+
+zero:
+; The count of a block without counters of its own comes from its incoming
+; edges.
+; CHECK: call void @hot(), !prof ![[ZERO_CALL:[0-9]+]]
+  call void @hot()
+  br label %exit
+
+one:
+  br label %exit
+
+exit:
+  %r = phi i32 [ 0, %select ], [ 1, %zero ], [ 2, %one ]
+  ret i32 %r
+}
+
+; CHECK-LABEL: define i32 @never(i32 %x) #3
+define i32 @never(i32 %x) {
+entry:
+  %c = icmp eq i32 %x, 0
+; Never executed branches keep their heuristic weights.
+; CHECK: br i1 %c, label %a, label %b{{$}}
+  br i1 %c, label %a, label %b
+
+a:
+  ret i32 1
+
+b:
+  ret i32 2
+}
+
+; CHECK-LABEL: define i32 @main() #4
+define i32 @main() {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %r = call i32 @classify(i32 %i)
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, 1001
+; CHECK: call i32 @classify(i32 %i), !prof ![[CLASSIFY_CALL:[0-9]+]]
+; CHECK: br i1 %done, label %exit, label %loop, !prof ![[LOOP:[0-9]+]]
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 0
+}
+
+; CHECK: attributes #0 = { noinline "pgo-entry-count"="1251" }
+; CHECK: attributes #1 = { noinline "pgo-entry-count"="1" }
+; CHECK: attributes #2 = { "pgo-entry-count"="1001" }
+; CHECK: attributes #3 = { cold "pgo-entry-count"="0" }
+; CHECK: attributes #4 = { "pgo-entry-count"="1" }
+
+; CHECK: !{i32 7, metadata !"ProfileMaxCount", i64 1251}
+; CHECK-DAG: ![[SMALL]] = metadata !{metadata !"branch_weights", i32 1000, i32 1}
+; CHECK-DAG: ![[COMMON_CALL]] = metadata !{metadata !"branch_weights", i64 1000}
+; CHECK-DAG: ![[RARE_CALL]] = metadata !{metadata !"branch_weights", i64 1}
+; CHECK-DAG: ![[SWITCH]] = metadata !{metadata !"branch_weights", i32 500, i32 251, i32 250}
+; CHECK-DAG: ![[ZERO_CALL]] = metadata !{metadata !"branch_weights", i64 251}
+; CHECK-DAG: ![[CLASSIFY_CALL]] = metadata !{metadata !"branch_weights", i64 1001}
+; CHECK-DAG: ![[LOOP]] = metadata !{metadata !"branch_weights", i32 1, i32 1000}
@@ -0,0 +1,113 @@
+; RUN: opt -S -slp-vectorizer -slp-vectorize-hor -mcpu=corei7 < %s | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; A dot product that is returned is a horizontal reduction that does not start
+; at a phi or feed a store. The operands of two of the products are swapped,
+; and are put back in order so that the loads from a and b are consecutive.
+
+; int dot4(int *restrict a, int *restrict b) {
+;   return a[0] * b[0] + b[1] * a[1] + a[2] * b[2] + b[3] * a[3];
+; }
+
+; CHECK-LABEL: @dot4(
+; CHECK: [[A:%.*]] = load <4 x i32>
+; CHECK: [[B:%.*]] = load <4 x i32>
+; CHECK: [[M:%.*]] = mul <4 x i32> [[A]], [[B]]
+; CHECK: shufflevector <4 x i32> [[M]], <4 x i32> undef, <4 x i32> <i32 2, i32 3, i32 undef, i32 undef>
+; CHECK: add <4 x i32>
+; CHECK: shufflevector <4 x i32> %{{.*}}, <4 x i32> undef, <4 x i32> <i32 1, i32 undef, i32 undef, i32 undef>
+; CHECK: [[S:%.*]] = add <4 x i32>
+; CHECK: [[R:%.*]] = extractelement <4 x i32> [[S]], i32 0
+; CHECK: ret i32 [[R]]
+
+define i32 @dot4(i32* noalias %a, i32* noalias %b) {
+entry:
+  %a0 = load i32* %a, align 4
+  %b0 = load i32* %b, align 4
+  %m0 = mul nsw i32 %a0, %b0
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %pb1 = getelementptr inbounds i32* %b, i64 1
+  %a1 = load i32* %pa1, align 4
+  %b1 = load i32* %pb1, align 4
+  %m1 = mul nsw i32 %b1, %a1
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %pb2 = getelementptr inbounds i32* %b, i64 2
+  %a2 = load i32* %pa2, align 4
+  %b2 = load i32* %pb2, align 4
+  %m2 = mul nsw i32 %a2, %b2
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %pb3 = getelementptr inbounds i32* %b, i64 3
+  %a3 = load i32* %pa3, align 4
+  %b3 = load i32* %pb3, align 4
+  %m3 = mul nsw i32 %b3, %a3
+  %s1 = add nsw i32 %m0, %m1
+  %s2 = add nsw i32 %s1, %m2
+  %s3 = add nsw i32 %s2, %m3
+  ret i32 %s3
+}
+
+; Floating point additions are only reassociated with fast-math flags.
+
+; CHECK-LABEL: @fdot4_fast(
+; CHECK: fmul <4 x float>
+; CHECK: fadd fast <4 x float>
+; CHECK: fadd fast <4 x float>
+; CHECK: ret float
+
+define float @fdot4_fast(float* noalias %a, float* noalias %b) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %m0 = fmul fast float %a0, %b0
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %m1 = fmul fast float %b1, %a1
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %m2 = fmul fast float %a2, %b2
+  %pa3 = getelementptr inbounds float* %a, i64 3
+  %pb3 = getelementptr inbounds float* %b, i64 3
+  %a3 = load float* %pa3, align 4
+  %b3 = load float* %pb3, align 4
+  %m3 = fmul fast float %a3, %b3
+  %s1 = fadd fast float %m0, %m1
+  %s2 = fadd fast float %m2, %m3
+  %s3 = fadd fast float %s1, %s2
+  ret float %s3
+}
+
+; CHECK-LABEL: @fdot4_strict(
+; CHECK-NOT: fadd <4 x float>
+; CHECK: ret float
+
+define float @fdot4_strict(float* noalias %a, float* noalias %b) {
+entry:
+  %a0 = load float* %a, align 4
+  %b0 = load float* %b, align 4
+  %m0 = fmul float %a0, %b0
+  %pa1 = getelementptr inbounds float* %a, i64 1
+  %pb1 = getelementptr inbounds float* %b, i64 1
+  %a1 = load float* %pa1, align 4
+  %b1 = load float* %pb1, align 4
+  %m1 = fmul float %a1, %b1
+  %pa2 = getelementptr inbounds float* %a, i64 2
+  %pb2 = getelementptr inbounds float* %b, i64 2
+  %a2 = load float* %pa2, align 4
+  %b2 = load float* %pb2, align 4
+  %m2 = fmul float %a2, %b2
+  %pa3 = getelementptr inbounds float* %a, i64 3
+  %pb3 = getelementptr inbounds float* %b, i64 3
+  %a3 = load float* %pa3, align 4
+  %b3 = load float* %pb3, align 4
+  %m3 = fmul float %a3, %b3
+  %s1 = fadd float %m0, %m1
+  %s2 = fadd float %s1, %m2
+  %s3 = fadd float %s2, %m3
+  ret float %s3
+}
@@ -0,0 +1,92 @@
+; RUN: opt -S -slp-vectorizer -slp-vectorize-hor -mcpu=corei7 < %s | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; Integer min and max reductions are vectorized like sums: the selects of the
+; smaller or larger of two values are reassociated into a tree of vector
+; compares and selects.
+
+; int smax4(int *a) {
+;   int m = a[0] > a[1] ? a[0] : a[1];
+;   m = m > a[2] ? m : a[2];
+;   return m > a[3] ? m : a[3];
+; }
+
+; CHECK-LABEL: @smax4(
+; CHECK: [[V:%.*]] = load <4 x i32>
+; CHECK: [[S1:%.*]] = shufflevector <4 x i32> [[V]], <4 x i32> undef, <4 x i32> <i32 2, i32 3, i32 undef, i32 undef>
+; CHECK: [[C1:%.*]] = icmp sgt <4 x i32> [[V]], [[S1]]
+; CHECK: [[M1:%.*]] = select <4 x i1> [[C1]], <4 x i32> [[V]], <4 x i32> [[S1]]
+; CHECK: [[S2:%.*]] = shufflevector <4 x i32> [[M1]], <4 x i32> undef, <4 x i32> <i32 1, i32 undef, i32 undef, i32 undef>
+; CHECK: [[C2:%.*]] = icmp sgt <4 x i32> [[M1]], [[S2]]
+; CHECK: [[M2:%.*]] = select <4 x i1> [[C2]], <4 x i32> [[M1]], <4 x i32> [[S2]]
+; CHECK: [[R:%.*]] = extractelement <4 x i32> [[M2]], i32 0
+; CHECK: ret i32 [[R]]
+
+define i32 @smax4(i32* %a) {
+entry:
+  %a0 = load i32* %a, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %a1 = load i32* %pa1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %a2 = load i32* %pa2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %a3 = load i32* %pa3, align 4
+  %c1 = icmp sgt i32 %a0, %a1
+  %m1 = select i1 %c1, i32 %a0, i32 %a1
+  %c2 = icmp sgt i32 %m1, %a2
+  %m2 = select i1 %c2, i32 %m1, i32 %a2
+  %c3 = icmp sgt i32 %m2, %a3
+  %m3 = select i1 %c3, i32 %m2, i32 %a3
+  ret i32 %m3
+}
+
+; A non-strict compare selects the same value, so ule and ult mix.
+
+; CHECK-LABEL: @umin4(
+; CHECK: icmp ult <4 x i32>
+; CHECK: icmp ult <4 x i32>
+; CHECK: ret i32
+
+define i32 @umin4(i32* %a) {
+entry:
+  %a0 = load i32* %a, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %a1 = load i32* %pa1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %a2 = load i32* %pa2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %a3 = load i32* %pa3, align 4
+  %c1 = icmp ult i32 %a0, %a1
+  %m1 = select i1 %c1, i32 %a0, i32 %a1
+  %c2 = icmp ule i32 %a2, %a3
+  %m2 = select i1 %c2, i32 %a2, i32 %a3
+  %c3 = icmp ult i32 %m1, %m2
+  %m3 = select i1 %c3, i32 %m1, i32 %m2
+  ret i32 %m3
+}
+
+; A mix of min and max is not a reduction.
+
+; CHECK-LABEL: @minmax4(
+; CHECK-NOT: <4 x i32>
+; CHECK: ret i32
+
+define i32 @minmax4(i32* %a) {
+entry:
+  %a0 = load i32* %a, align 4
+  %pa1 = getelementptr inbounds i32* %a, i64 1
+  %a1 = load i32* %pa1, align 4
+  %pa2 = getelementptr inbounds i32* %a, i64 2
+  %a2 = load i32* %pa2, align 4
+  %pa3 = getelementptr inbounds i32* %a, i64 3
+  %a3 = load i32* %pa3, align 4
+  %c1 = icmp sgt i32 %a0, %a1
+  %m1 = select i1 %c1, i32 %a0, i32 %a1
+  %c2 = icmp slt i32 %m1, %a2
+  %m2 = select i1 %c2, i32 %m1, i32 %a2
+  %c3 = icmp sgt i32 %m2, %a3
+  %m3 = select i1 %c3, i32 %m2, i32 %a3
+  ret i32 %m3
+}
@@ -0,0 +1,104 @@
+; RUN: opt -S -slp-vectorizer -slp-vectorize-hor -mcpu=corei7 < %s | FileCheck %s
+
+target datalayout = "e-p:64:64:64-i1:8:8-i8:8:8-i16:16:16-i32:32:32-i64:64:64-f32:32:32-f64:64:64-v64:64:64-v128:128:128-a0:0:64-s0:64:64-f80:128:128-n8:16:32:64-S128"
+target triple = "x86_64-unknown-linux-gnu"
+
+; The rows of a matrix-vector product are built into a vector with
+; insertelement. The vectorized rows replace the inserted scalars, so there
+; is no cost for extracting them and the product is vectorized at the default
+; threshold. Two of the products have their operands swapped.
+
+; CHECK-LABEL: @mat4vec(
+; CHECK: load <4 x float>
+; CHECK: load <4 x float>
+; CHECK: load <4 x float>
+; CHECK: load <4 x float>
+; CHECK: fmul <4 x float>
+; CHECK: fmul <4 x float>
+; CHECK: fmul <4 x float>
+; CHECK: fmul <4 x float>
+; CHECK: fadd <4 x float>
+; CHECK: fadd <4 x float>
+; CHECK: [[Y:%.*]] = fadd <4 x float>
+; CHECK: [[Y0:%.*]] = extractelement <4 x float> [[Y]], i32 0
+; CHECK-NEXT: %r0 = insertelement <4 x float> undef, float [[Y0]], i32 0
+; CHECK-NEXT: [[Y1:%.*]] = extractelement <4 x float> [[Y]], i32 1
+; CHECK-NEXT: %r1 = insertelement <4 x float> %r0, float [[Y1]], i32 1
+; CHECK-NEXT: [[Y2:%.*]] = extractelement <4 x float> [[Y]], i32 2
+; CHECK-NEXT: %r2 = insertelement <4 x float> %r1, float [[Y2]], i32 2
+; CHECK-NEXT: [[Y3:%.*]] = extractelement <4 x float> [[Y]], i32 3
+; CHECK-NEXT: %r3 = insertelement <4 x float> %r2, float [[Y3]], i32 3
+; CHECK-NEXT: ret <4 x float> %r3
+
+define <4 x float> @mat4vec(float* noalias %m, <4 x float> %x) {
+entry:
+  %x0 = extractelement <4 x float> %x, i32 0
+  %x1 = extractelement <4 x float> %x, i32 1
+  %x2 = extractelement <4 x float> %x, i32 2
+  %x3 = extractelement <4 x float> %x, i32 3
+  %p00 = getelementptr inbounds float* %m, i64 0
+  %p01 = getelementptr inbounds float* %m, i64 4
+  %p02 = getelementptr inbounds float* %m, i64 8
+  %p03 = getelementptr inbounds float* %m, i64 12
+  %p10 = getelementptr inbounds float* %m, i64 1
+  %p11 = getelementptr inbounds float* %m, i64 5
+  %p12 = getelementptr inbounds float* %m, i64 9
+  %p13 = getelementptr inbounds float* %m, i64 13
+  %p20 = getelementptr inbounds float* %m, i64 2
+  %p21 = getelementptr inbounds float* %m, i64 6
+  %p22 = getelementptr inbounds float* %m, i64 10
+  %p23 = getelementptr inbounds float* %m, i64 14
+  %p30 = getelementptr inbounds float* %m, i64 3
+  %p31 = getelementptr inbounds float* %m, i64 7
+  %p32 = getelementptr inbounds float* %m, i64 11
+  %p33 = getelementptr inbounds float* %m, i64 15
+  %m00 = load float* %p00, align 4
+  %m01 = load float* %p01, align 4
+  %m02 = load float* %p02, align 4
+  %m03 = load float* %p03, align 4
+  %m10 = load float* %p10, align 4
+  %m11 = load float* %p11, align 4
+  %m12 = load float* %p12, align 4
+  %m13 = load float* %p13, align 4
+  %m20 = load float* %p20, align 4
+  %m21 = load float* %p21, align 4
+  %m22 = load float* %p22, align 4
+  %m23 = load float* %p23, align 4
+  %m30 = load float* %p30, align 4
+  %m31 = load float* %p31, align 4
+  %m32 = load float* %p32, align 4
+  %m33 = load float* %p33, align 4
+  %t00 = fmul float %m00, %x0
+  %t10 = fmul float %x0, %m10
+  %t20 = fmul float %m20, %x0
+  %t30 = fmul float %x0, %m30
+  %t01 = fmul float %m01, %x1
+  %t11 = fmul float %m11, %x1
+  %t21 = fmul float %m21, %x1
+  %t31 = fmul float %m31, %x1
+  %t02 = fmul float %m02, %x2
+  %t12 = fmul float %m12, %x2
+  %t22 = fmul float %m22, %x2
+  %t32 = fmul float %m32, %x2
+  %t03 = fmul float %m03, %x3
+  %t13 = fmul float %m13, %x3
+  %t23 = fmul float %m23, %x3
+  %t33 = fmul float %m33, %x3
+  %s00 = fadd float %t00, %t01
+  %s01 = fadd float %s00, %t02
+  %y0 = fadd float %s01, %t03
+  %s10 = fadd float %t10, %t11
+  %s11 = fadd float %s10, %t12
+  %y1 = fadd float %s11, %t13
+  %s20 = fadd float %t20, %t21
+  %s21 = fadd float %s20, %t22
+  %y2 = fadd float %s21, %t23
+  %s30 = fadd float %t30, %t31
+  %s31 = fadd float %s30, %t32
+  %y3 = fadd float %s31, %t33
+  %r0 = insertelement <4 x float> undef, float %y0, i32 0
+  %r1 = insertelement <4 x float> %r0, float %y1, i32 1
+  %r2 = insertelement <4 x float> %r1, float %y2, i32 2
+  %r3 = insertelement <4 x float> %r2, float %y3, i32 3
+  ret <4 x float> %r3
+}
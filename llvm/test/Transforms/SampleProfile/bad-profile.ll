@@ -0,0 +1,9 @@
+; RUN: not opt < %s -sample-profile -sample-profile-file=%S/Inputs/bad.prof -disable-output 2>&1 | FileCheck %s
+; RUN: not opt < %s -sample-profile -sample-profile-file=%S/Inputs/missing.prof -disable-output 2>&1 | FileCheck %s -check-prefix=MISSING
+
+; CHECK: error: could not read sample profile {{.*}}bad.prof:3: expected 'offset: samples'
+; MISSING: error: could not read sample profile {{.*}}missing.prof: No such file or directory
+
+define void @f() {
+  ret void
+}
@@ -0,0 +1,94 @@
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/branch.prof -S | FileCheck %s
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/branch.binprof -S | FileCheck %s
+
+; Compiled from:
+;
+; 10  int clamp(int *p, int n) {
+; 11    int s = 0;
+; 12    for (int i = 0; i != n; ++i) {
+; 13      if (p[i] < 0)
+; 14        report(p[i]);
+; 15      s += p[i];
+; 16    }
+; 17    return s;
+; 18  }
+;
+; The loop body runs 5000 times as often as the function is entered, and the
+; call to report is sampled twice.  The weights of the edges follow from the
+; weights of the blocks.
+
+declare void @report(i32)
+
+define i32 @clamp(i32* %p, i32 %n) {
+entry:
+  br label %loop, !dbg !11
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %latch ]
+  %s = phi i32 [ 0, %entry ], [ %s.next, %latch ]
+  %addr = getelementptr i32* %p, i32 %i, !dbg !13
+  %v = load i32* %addr, !dbg !13
+  %bad = icmp slt i32 %v, 0, !dbg !13
+; CHECK: br i1 %bad, label %fixup, label %latch, !dbg !{{[0-9]+}}, !prof ![[BODY:[0-9]+]]
+  br i1 %bad, label %fixup, label %latch, !dbg !13
+
+fixup:
+; CHECK: call void @report(i32 %v), !dbg !{{[0-9]+}}, !prof ![[REPORT:[0-9]+]]
+  call void @report(i32 %v), !dbg !14
+  br label %latch, !dbg !14
+
+latch:
+  %s.next = add i32 %s, %v, !dbg !15
+  %i.next = add i32 %i, 1, !dbg !12
+  %done = icmp eq i32 %i.next, %n, !dbg !12
+; CHECK: br i1 %done, label %exit, label %loop, !dbg !{{[0-9]+}}, !prof ![[LATCH:[0-9]+]]
+  br i1 %done, label %exit, label %loop, !dbg !12
+
+exit:
+  %neg = icmp slt i32 %s.next, 0, !dbg !16
+  br i1 %neg, label %underflow, label %out, !dbg !16
+
+; A call on a line without samples is not known to be cold, so it gets no
+; count.
+underflow:
+; CHECK: call void @report(i32 %s.next), !dbg !{{[0-9]+}}{{$}}
+  call void @report(i32 %s.next), !dbg !16
+  br label %out, !dbg !16
+
+out:
+  ret i32 %s.next, !dbg !17
+}
+
+; Without line information the profile cannot be mapped to the code.
+; CHECK-LABEL: define i32 @nodebug(
+; CHECK: br i1 %c, label %a, label %b{{$}}
+define i32 @nodebug(i1 %c) {
+  br i1 %c, label %a, label %b
+a:
+  ret i32 0
+b:
+  ret i32 1
+}
+
+; CHECK: !{i32 7, metadata !"ProfileMaxCount", i64 5000}
+; CHECK-DAG: ![[BODY]] = metadata !{metadata !"branch_weights", i32 2, i32 4998}
+; CHECK-DAG: ![[REPORT]] = metadata !{metadata !"branch_weights", i64 2}
+; CHECK-DAG: ![[LATCH]] = metadata !{metadata !"branch_weights", i32 10, i32 4990}
+
+!llvm.dbg.cu = !{!0}
+
+!0 = metadata !{i32 786449, metadata !2, i32 12, metadata !"clang version 3.4", i1 true, metadata !"", i32 0, metadata !3, metadata !3, metadata !4, metadata !3, metadata !3, metadata !""} ; [ DW_TAG_compile_unit ] [/tmp/clamp.c] [DW_LANG_C99]
+!1 = metadata !{i32 786473, metadata !2}          ; [ DW_TAG_file_type ] [/tmp/clamp.c]
+!2 = metadata !{metadata !"clamp.c", metadata !"/tmp"}
+!3 = metadata !{i32 0}
+!4 = metadata !{metadata !5}
+!5 = metadata !{i32 786478, metadata !1, metadata !1, metadata !"clamp", metadata !"clamp", metadata !"", i32 10, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32*, i32)* @clamp, null, null, metadata !3, i32 10} ; [ DW_TAG_subprogram ] [line 10] [def] [clamp]
+!6 = metadata !{i32 786453, i32 0, null, i32 0, i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !7, i32 0, i32 0} ; [ DW_TAG_subroutine_type ] [line 0, size 0, align 0, offset 0] [from ]
+!7 = metadata !{null}
+!11 = metadata !{i32 11, i32 0, metadata !5, null}
+!12 = metadata !{i32 12, i32 0, metadata !5, null}
+!13 = metadata !{i32 13, i32 0, metadata !5, null}
+!14 = metadata !{i32 14, i32 0, metadata !5, null}
+!15 = metadata !{i32 15, i32 0, metadata !5, null}
+!16 = metadata !{i32 16, i32 0, metadata !5, null}
+!17 = metadata !{i32 17, i32 0, metadata !5, null}
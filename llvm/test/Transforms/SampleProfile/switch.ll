@@ -0,0 +1,41 @@
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/switch.prof -S | FileCheck %s
+
+; Two cases of the switch go to the same block.  The weight of that edge is
+; given to the first of them only, so it is not counted twice.
+
+define i32 @pick(i32 %x) {
+entry:
+; CHECK: switch i32 %x, label %other [
+; CHECK: ], !dbg !{{[0-9]+}}, !prof ![[SWITCH:[0-9]+]]
+  switch i32 %x, label %other [
+    i32 1, label %same
+    i32 2, label %same
+    i32 3, label %third
+  ], !dbg !11
+
+same:
+  ret i32 1, !dbg !12
+
+third:
+  ret i32 3, !dbg !13
+
+other:
+  ret i32 0, !dbg !14
+}
+
+; CHECK: ![[SWITCH]] = metadata !{metadata !"branch_weights", i32 10, i32 60, i32 0, i32 30}
+
+!llvm.dbg.cu = !{!0}
+
+!0 = metadata !{i32 786449, metadata !2, i32 12, metadata !"clang version 3.4", i1 true, metadata !"", i32 0, metadata !3, metadata !3, metadata !4, metadata !3, metadata !3, metadata !""} ; [ DW_TAG_compile_unit ] [/tmp/pick.c] [DW_LANG_C99]
+!1 = metadata !{i32 786473, metadata !2}          ; [ DW_TAG_file_type ] [/tmp/pick.c]
+!2 = metadata !{metadata !"pick.c", metadata !"/tmp"}
+!3 = metadata !{i32 0}
+!4 = metadata !{metadata !5}
+!5 = metadata !{i32 786478, metadata !1, metadata !1, metadata !"pick", metadata !"pick", metadata !"", i32 20, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @pick, null, null, metadata !3, i32 20} ; [ DW_TAG_subprogram ] [line 20] [def] [pick]
+!6 = metadata !{i32 786453, i32 0, null, i32 0, i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !7, i32 0, i32 0} ; [ DW_TAG_subroutine_type ] [line 0, size 0, align 0, offset 0] [from ]
+!7 = metadata !{null}
+!11 = metadata !{i32 21, i32 0, metadata !5, null}
+!12 = metadata !{i32 22, i32 0, metadata !5, null}
+!13 = metadata !{i32 23, i32 0, metadata !5, null}
+!14 = metadata !{i32 24, i32 0, metadata !5, null}
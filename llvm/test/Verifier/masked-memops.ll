@@ -0,0 +1,21 @@
+; RUN: not llvm-as < %s -o /dev/null 2>&1 | FileCheck %s
+
+declare <4 x i32> @llvm.masked.load.v4i32.p0v4i32.v4i1(<4 x i32>*, i32, <4 x i1>, <4 x i32>)
+declare void @llvm.masked.store.v4i32.p0v4i32.v4i8(<4 x i32>, <4 x i32>*, i32, <4 x i8>)
+declare <4 x i32> @llvm.masked.load.v4i32.p0v2i64.v4i1(<2 x i64>*, i32, <4 x i1>, <4 x i32>)
+
+define void @f(<4 x i32>* %p, <2 x i64>* %q, i32 %align, <4 x i1> %mask, <4 x i8> %bytes, <4 x i32> %v) {
+entry:
+; CHECK: alignment argument of masked memory intrinsics must be a constant int
+; CHECK-NEXT: @llvm.masked.load.v4i32.p0v4i32.v4i1
+  call <4 x i32> @llvm.masked.load.v4i32.p0v4i32.v4i1(<4 x i32>* %p, i32 %align, <4 x i1> %mask, <4 x i32> %v)
+
+; CHECK: mask of masked memory intrinsics must be a vector of i1 with one element per data element
+; CHECK-NEXT: @llvm.masked.store.v4i32.p0v4i32.v4i8
+  call void @llvm.masked.store.v4i32.p0v4i32.v4i8(<4 x i32> %v, <4 x i32>* %p, i32 4, <4 x i8> %bytes)
+
+; CHECK: pointer operand of masked memory intrinsics must point to the data type
+; CHECK-NEXT: @llvm.masked.load.v4i32.p0v2i64.v4i1
+  call <4 x i32> @llvm.masked.load.v4i32.p0v2i64.v4i1(<2 x i64>* %q, i32 4, <4 x i1> %mask, <4 x i32> %v)
+  ret void
+}
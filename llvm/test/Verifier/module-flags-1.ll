@@ -41,6 +41,12 @@
 ; CHECK-NOT: invalid value for 'append'-type module flag (expected a metadata node)
 !18 = metadata !{ i32 5, metadata !"flag-4", metadata !{ i32 57 } }
 
+; Check that any 'max' module flags are valid.
+; CHECK: invalid value for 'max' module flag (expected constant integer)
+!19 = metadata !{ i32 7, metadata !"flag-5", metadata !{ i32 58 } }
+; CHECK-NOT: invalid value for 'max' module flag (expected constant integer)
+!20 = metadata !{ i32 7, metadata !"flag-6", i32 59 }
+
 ; Check that any 'require' module flags are valid.
 ; CHECK: invalid requirement on flag, flag is not present in module
 !11 = metadata !{ i32 3, metadata !"bar",
@@ -57,4 +63,4 @@
 
 !llvm.module.flags = !{
   !0, !1, !2, !3, !4, !5, !6, !7, !8, !9, !10, !11, !12, !13, !14, !15,
-  !16, !17, !18 }
+  !16, !17, !18, !19, !20 }
@@ -0,0 +1,13 @@
+define internal i32 @local() {
+  ret i32 2
+}
+
+define i32 @baz() {
+  %v = call i32 @local()
+  ret i32 %v
+}
+
+define i32 @qux() {
+  %v = call i32 @local()
+  ret i32 %v
+}
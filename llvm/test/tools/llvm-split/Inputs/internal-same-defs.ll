@@ -0,0 +1,13 @@
+define internal i32 @local() {
+  ret i32 2
+}
+
+define linkonce_odr i32 @foo() {
+  %v = call i32 @local()
+  ret i32 %v
+}
+
+define linkonce_odr i32 @bar() {
+  %v = call i32 @local()
+  ret i32 %v
+}
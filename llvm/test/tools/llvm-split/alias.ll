@@ -0,0 +1,27 @@
+; RUN: llvm-split -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; An alias is always placed in the partition of its aliasee. Other partitions
+; refer to it through a declaration.
+
+; CHECK0: @a = alias void ()* @f1
+; CHECK1-NOT: = alias
+@a = alias void ()* @f1
+
+; CHECK0: define void @f1()
+; CHECK1: declare void @f1()
+define void @f1() {
+  ret void
+}
+
+; CHECK0-NOT: @f3
+; CHECK1: define void @f3()
+; CHECK1-NEXT: call void @a()
+; CHECK1-NEXT: call void @f1()
+; CHECK1: declare void @a()
+define void @f3() {
+  call void @a()
+  call void @f1()
+  ret void
+}
@@ -0,0 +1,37 @@
+; RUN: llvm-split -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; Module inline asm and global constructors are emitted by the first
+; partition only, while llvm.used is filtered to the local definitions of each
+; partition.
+
+; CHECK0: module asm ".globl x"
+; CHECK1-NOT: module asm
+module asm ".globl x"
+
+; CHECK0: @llvm.global_ctors = appending global
+; CHECK1-NOT: @llvm.global_ctors
+@llvm.global_ctors = appending global [1 x { i32, void ()* }] [{ i32, void ()* } { i32 65535, void ()* @f1 }]
+
+; CHECK0: @llvm.used = appending global [1 x i8*] [i8* bitcast (void ()* @used1 to i8*)], section "llvm.metadata"
+; CHECK1: @llvm.used = appending global [1 x i8*] [i8* bitcast (void ()* @used2 to i8*)], section "llvm.metadata"
+@llvm.used = appending global [2 x i8*] [i8* bitcast (void ()* @used1 to i8*), i8* bitcast (void ()* @used2 to i8*)], section "llvm.metadata"
+
+; CHECK0: declare hidden void @f1.llvmsplit.[[HASH:[0-9A-F]+]]()
+; CHECK1: define hidden void @f1.llvmsplit.[[HASH:[0-9A-F]+]]()
+define internal void @f1() {
+  ret void
+}
+
+; CHECK0: define internal void @used1()
+; CHECK1-NOT: @used1
+define internal void @used1() {
+  ret void
+}
+
+; CHECK0-NOT: @used2
+; CHECK1: define internal void @used2()
+define internal void @used2() {
+  ret void
+}
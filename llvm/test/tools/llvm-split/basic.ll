@@ -0,0 +1,30 @@
+; RUN: llvm-split -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; Every definition ends up in exactly one partition. The other partitions
+; only keep a declaration if they refer to it.
+
+; CHECK0: @foo = global i32 1
+; CHECK1: @foo = external global i32
+@foo = global i32 1
+
+; CHECK0: declare i32 @bar()
+; CHECK1: define i32 @bar()
+define i32 @bar() {
+  %v = load i32* @foo
+  ret i32 %v
+}
+
+; CHECK0: define i32 @qux()
+; CHECK1-NOT: @qux
+define i32 @qux() {
+  %v = call i32 @bar()
+  ret i32 %v
+}
+
+; CHECK0-NOT: @baz
+; CHECK1: define void @baz()
+define void @baz() {
+  ret void
+}
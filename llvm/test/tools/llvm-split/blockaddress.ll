@@ -0,0 +1,25 @@
+; RUN: llvm-split -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; Globals taking the address of a basic block are placed in the partition of
+; the function containing the block.
+
+; CHECK0-NOT: @table
+; CHECK1: @table = global i8* blockaddress(@dispatch, %bb)
+@table = global i8* blockaddress(@dispatch, %bb)
+
+; CHECK0-NOT: @dispatch
+; CHECK1: define void @dispatch()
+define void @dispatch() {
+entry:
+  br label %bb
+
+bb:
+  ret void
+}
+
+; CHECK0: define void @foo()
+define void @foo() {
+  ret void
+}
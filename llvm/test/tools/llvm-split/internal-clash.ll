@@ -0,0 +1,27 @@
+; RUN: llvm-split -o %t.a %s
+; RUN: llvm-split -o %t.b %S/Inputs/internal-clash.ll
+; RUN: llvm-link -S -o - %t.a0 %t.a1 %t.b0 %t.b1 | FileCheck %s
+
+; Both modules promote their own internal @local. The promoted symbols get
+; different names, so the partitions of both modules can be linked together.
+
+; CHECK-DAG: define hidden i32 @local.llvmsplit.[[A:[0-9A-F]+]]()
+; CHECK-DAG: define hidden i32 @local.llvmsplit.[[B:[0-9A-F]+]]()
+; CHECK-DAG: define i32 @foo()
+; CHECK-DAG: define i32 @bar()
+; CHECK-DAG: define i32 @baz()
+; CHECK-DAG: define i32 @qux()
+
+define internal i32 @local() {
+  ret i32 1
+}
+
+define i32 @foo() {
+  %v = call i32 @local()
+  ret i32 %v
+}
+
+define i32 @bar() {
+  %v = call i32 @local()
+  ret i32 %v
+}
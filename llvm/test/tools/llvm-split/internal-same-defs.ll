@@ -0,0 +1,24 @@
+; RUN: llvm-split -o %t.a %s
+; RUN: llvm-split -o %t.b %S/Inputs/internal-same-defs.ll
+; RUN: llvm-link -S -o - %t.a0 %t.a1 %t.b0 %t.b1 | FileCheck %s
+
+; Both modules define the same linkonce functions and nothing else, so the
+; module identifier is what keeps their promoted @local symbols apart.
+
+; CHECK-DAG: define hidden i32 @local.llvmsplit.[[A:[0-9A-F]+]]()
+; CHECK-DAG: define hidden i32 @local.llvmsplit.[[B:[0-9A-F]+]]()
+; CHECK-DAG: define linkonce_odr i32 @foo()
+
+define internal i32 @local() {
+  ret i32 1
+}
+
+define linkonce_odr i32 @foo() {
+  %v = call i32 @local()
+  ret i32 %v
+}
+
+define linkonce_odr i32 @bar() {
+  %v = call i32 @local()
+  ret i32 %v
+}
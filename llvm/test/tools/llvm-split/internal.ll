@@ -0,0 +1,37 @@
+; RUN: llvm-split -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; Local symbols referenced from another partition are promoted to hidden
+; symbols, with a suffix that depends on the module. Local symbols only
+; referenced from their own partition stay local.
+
+; CHECK0: @table.llvmsplit.[[HASH:[0-9A-F]+]] = hidden constant [2 x i8] c"a\00"
+; CHECK1: @table.llvmsplit.[[HASH:[0-9A-F]+]] = external hidden constant [2 x i8]
+@table = private constant [2 x i8] c"a\00"
+
+; CHECK0: declare hidden i32 @local.llvmsplit.[[HASH]]()
+; CHECK1: define hidden i32 @local.llvmsplit.[[HASH]]()
+define internal i32 @local() {
+  ret i32 1
+}
+
+; CHECK0: define i32 @foo()
+; CHECK1-NOT: @foo
+define i32 @foo() {
+  %v = call i32 @local()
+  ret i32 %v
+}
+
+; CHECK0-NOT: @helper
+; CHECK1: define internal i32 @helper()
+define internal i32 @helper() {
+  ret i32 2
+}
+
+; CHECK0-NOT: @bar
+; CHECK1: define i8* @bar()
+define i8* @bar() {
+  %v = call i32 @helper()
+  ret i8* getelementptr inbounds ([2 x i8]* @table, i32 0, i32 0)
+}
@@ -0,0 +1,48 @@
+; RUN: llvm-split -preserve-locality -o %t %s
+; RUN: llvm-dis -o - %t0 | FileCheck --check-prefix=CHECK0 %s
+; RUN: llvm-dis -o - %t1 | FileCheck --check-prefix=CHECK1 %s
+
+; With -preserve-locality, local functions are grouped with their users and
+; functions with their only user, as long as the groups stay smaller than half
+; of the module. The groups are then placed, largest first, in the partition
+; that is the least loaded so far.
+
+; @helper and @a form a group of size 5. @b does not fit into that group, but
+; ends up in the same partition, so @helper does not need to be promoted.
+; CHECK0: define internal i32 @helper()
+; CHECK1-NOT: @helper
+define internal i32 @helper() {
+  ret i32 1
+}
+
+; CHECK0: define i32 @a()
+define i32 @a() {
+  %v = call i32 @helper()
+  ret i32 %v
+}
+
+; CHECK0: define i32 @b()
+define i32 @b() {
+  %v = call i32 @helper()
+  ret i32 %v
+}
+
+; CHECK0-NOT: @c
+; CHECK1: define void @c()
+define void @c() {
+  ret void
+}
+
+; @e is only used by @d, so they form a group of size 5.
+; CHECK0-NOT: @d
+; CHECK1: define void @d()
+define void @d() {
+  call void @e()
+  ret void
+}
+
+; CHECK0-NOT: @e
+; CHECK1: define void @e()
+define void @e() {
+  ret void
+}
@@ -80,6 +80,9 @@ namespace options {
   static std::string extra_library_path;
   static std::string triple;
   static std::string mcpu;
+  // The number of object files, each compiled on its own thread, that the
+  // merged module is split into.
+  static unsigned parallelism = 1;
   // Additional options to pass into the code generator.
   // Note: This array will contain all plugin options which are not claimed
   // as plugin exclusive to pass to the code generator.
@@ -101,6 +104,12 @@ namespace options {
       extra_library_path = opt.substr(strlen("extra_library_path="));
     } else if (opt.startswith("mtriple=")) {
       triple = opt.substr(strlen("mtriple="));
+    } else if (opt.startswith("jobs=")) {
+      if (opt.substr(strlen("jobs=")).getAsInteger(10, parallelism) ||
+          parallelism == 0) {
+        (*message)(LDPL_WARNING, "Invalid number of jobs: %s", opt_);
+        parallelism = 1;
+      }
     } else if (opt.startswith("obj-path=")) {
       obj_path = opt.substr(strlen("obj-path="));
     } else if (opt == "emit-llvm") {
@@ -442,13 +451,21 @@ static ld_plugin_status all_symbols_read_hook(void) {
     }
   }
 
-  std::string ObjPath;
-  {
+  std::vector<std::string> ObjPaths;
+  if (options::parallelism > 1) {
+    const char **Temps = NULL;
+    unsigned NumTemps = 0;
+    lto_codegen_set_parallelism(code_gen, options::parallelism);
+    if (lto_codegen_compile_to_files(code_gen, &Temps, &NumTemps)) {
+      (*message)(LDPL_ERROR, "Could not produce the combined object files\n");
+    }
+    ObjPaths.assign(Temps, Temps + NumTemps);
+  } else {
     const char *Temp;
     if (lto_codegen_compile_to_file(code_gen, &Temp)) {
       (*message)(LDPL_ERROR, "Could not produce a combined object file\n");
     }
-    ObjPath = Temp;
+    ObjPaths.push_back(Temp);
   }
 
   lto_codegen_dispose(code_gen);
@@ -460,10 +477,12 @@ static ld_plugin_status all_symbols_read_hook(void) {
     }
   }
 
-  if ((*add_input_file)(ObjPath.c_str()) != LDPS_OK) {
-    (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
-    (*message)(LDPL_ERROR, "File left behind in: %s", ObjPath.c_str());
-    return LDPS_ERR;
+  for (unsigned i = 0, e = ObjPaths.size(); i != e; ++i) {
+    if ((*add_input_file)(ObjPaths[i].c_str()) != LDPS_OK) {
+      (*message)(LDPL_ERROR, "Unable to add .o file to the link.");
+      (*message)(LDPL_ERROR, "File left behind in: %s", ObjPaths[i].c_str());
+      return LDPS_ERR;
+    }
   }
 
   if (!options::extra_library_path.empty() &&
@@ -473,7 +492,7 @@ static ld_plugin_status all_symbols_read_hook(void) {
   }
 
   if (options::obj_path.empty())
-    Cleanup.push_back(ObjPath);
+    Cleanup.insert(Cleanup.end(), ObjPaths.begin(), ObjPaths.end());
 
   return LDPS_OK;
 }
@@ -16,10 +16,12 @@
 
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/ADT/Triple.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/LinkAllAsmWriterComponents.h"
 #include "llvm/CodeGen/LinkAllCodegenComponents.h"
+#include "llvm/CodeGen/ParallelCG.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IRReader/IRReader.h"
@@ -53,6 +55,12 @@ InputFilename(cl::Positional, cl::desc("<input bitcode>"), cl::init("-"));
 static cl::opt<std::string>
 OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"));
 
+static cl::opt<unsigned>
+SplitCodeGen("split-codegen", cl::init(1), cl::value_desc("N"),
+             cl::desc("Split the module into N partitions and generate code "
+                      "for them in parallel; the output for partition I is "
+                      "written to <filename>I"));
+
 static cl::opt<unsigned>
 TimeCompilations("time-compilations", cl::Hidden, cl::init(1u),
                  cl::value_desc("N"),
@@ -79,6 +87,8 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::init(false));
 
 static int compileModule(char**, LLVMContext&);
+static int compileSplitModule(char**, Module*, TargetMachine&,
+                              const TargetLibraryInfo&);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
 static inline std::string
@@ -97,10 +107,8 @@ GetFileNameRoot(const std::string &InputFilename) {
   return outputFilename;
 }
 
-static tool_output_file *GetOutputStream(const char *TargetName,
-                                         Triple::OSType OS,
-                                         const char *ProgName) {
-  // If we don't yet have an output filename, make one.
+// ComputeOutputFilename - If we don't yet have an output filename, make one.
+static void ComputeOutputFilename(const char *TargetName, Triple::OSType OS) {
   if (OutputFilename.empty()) {
     if (InputFilename == "-")
       OutputFilename = "-";
@@ -131,7 +139,9 @@ static tool_output_file *GetOutputStream(const char *TargetName,
       }
     }
   }
+}
 
+static tool_output_file *GetOutputStream(const std::string &Filename) {
   // Decide if we need "binary" output.
   bool Binary = false;
   switch (FileType) {
@@ -148,7 +158,7 @@ static tool_output_file *GetOutputStream(const char *TargetName,
   sys::fs::OpenFlags OpenFlags = sys::fs::F_None;
   if (Binary)
     OpenFlags |= sys::fs::F_Binary;
-  tool_output_file *FDOut = new tool_output_file(OutputFilename.c_str(), error,
+  tool_output_file *FDOut = new tool_output_file(Filename.c_str(), error,
                                                  OpenFlags);
   if (!error.empty()) {
     errs() << error << '\n';
@@ -182,6 +192,7 @@ int main(int argc, char **argv) {
   PassRegistry *Registry = PassRegistry::getPassRegistry();
   initializeCore(*Registry);
   initializeCodeGen(*Registry);
+  initializeGlobalISel(*Registry);
   initializeLoopStrengthReducePass(*Registry);
   initializeLowerIntrinsicsPass(*Registry);
   initializeUnreachableBlockElimPass(*Registry);
@@ -306,27 +317,12 @@ static int compileModule(char **argv, LLVMContext &Context) {
     Target.setMCUseLoc(false);
 
   // Figure out where we are going to send the output.
-  OwningPtr<tool_output_file> Out
-    (GetOutputStream(TheTarget->getName(), TheTriple.getOS(), argv[0]));
-  if (!Out) return 1;
+  ComputeOutputFilename(TheTarget->getName(), TheTriple.getOS());
 
-  // Build up all of the passes that we want to do to the module.
-  PassManager PM;
-
-  // Add an appropriate TargetLibraryInfo pass for the module's triple.
-  TargetLibraryInfo *TLI = new TargetLibraryInfo(TheTriple);
+  // An appropriate TargetLibraryInfo for the module's triple.
+  TargetLibraryInfo TLI(TheTriple);
   if (DisableSimplifyLibCalls)
-    TLI->disableAllFunctions();
-  PM.add(TLI);
-
-  // Add intenal analysis passes from the target machine.
-  Target.addAnalysisPasses(PM);
-
-  // Add the target data from the target machine, if it exists, or the module.
-  if (const DataLayout *TD = Target.getDataLayout())
-    PM.add(new DataLayout(*TD));
-  else
-    PM.add(new DataLayout(mod));
+    TLI.disableAllFunctions();
 
   // Override default to generate verbose assembly.
   Target.setAsmVerbosityDefault(true);
@@ -339,6 +335,15 @@ static int compileModule(char **argv, LLVMContext &Context) {
       Target.setMCRelaxAll(true);
   }
 
+  if (SplitCodeGen > 1)
+    return compileSplitModule(argv, mod, Target, TLI);
+
+  OwningPtr<tool_output_file> Out(GetOutputStream(OutputFilename));
+  if (!Out) return 1;
+
+  // Build up all of the passes that we want to do to the module.
+  PassManager PM;
+
   {
     formatted_raw_ostream FOS(Out->os());
 
@@ -362,9 +367,11 @@ static int compileModule(char **argv, LLVMContext &Context) {
       StopAfterID = PI->getTypeInfo();
     }
 
-    // Ask the target to add backend passes as necessary.
-    if (Target.addPassesToEmitFile(PM, FOS, FileType, NoVerify,
-                                   StartAfterID, StopAfterID)) {
+    // Add the library info, the target analyses and data layout, and ask the
+    // target to add backend passes as necessary.  -split-codegen sets up
+    // every partition with the same helper.
+    if (addCodeGenPasses(PM, *mod, Target, &TLI, FOS, FileType, NoVerify,
+                         StartAfterID, StopAfterID)) {
       errs() << argv[0] << ": target does not support generation of this"
              << " file type!\n";
       return 1;
@@ -381,3 +388,51 @@ static int compileModule(char **argv, LLVMContext &Context) {
 
   return 0;
 }
+
+// compileSplitModule - Split the module into SplitCodeGen partitions and
+// generate code for them in parallel with splitCodeGen, writing partition I to
+// <OutputFilename>I.  Every partition is compiled with the default code
+// generation pipeline of its own copy of the target machine and of TLI.
+static int compileSplitModule(char **argv, Module *mod, TargetMachine &Target,
+                              const TargetLibraryInfo &TLI) {
+  if (OutputFilename == "-") {
+    errs() << argv[0] << ": -split-codegen requires an output filename\n";
+    return 1;
+  }
+  if (!StartAfter.empty() || !StopAfter.empty()) {
+    errs() << argv[0] << ": -split-codegen cannot be used with -start-after "
+           << "or -stop-after\n";
+    return 1;
+  }
+
+  std::vector<tool_output_file *> Outs;
+  std::vector<raw_ostream *> OSs;
+  int RetVal = 0;
+  for (unsigned I = 0; I != SplitCodeGen; ++I) {
+    tool_output_file *Out = GetOutputStream(OutputFilename + utostr(I));
+    if (!Out) {
+      RetVal = 1;
+      break;
+    }
+    Outs.push_back(Out);
+    OSs.push_back(&Out->os());
+  }
+
+  if (!RetVal) {
+    // Before executing passes, print the final values of the LLVM options.
+    cl::PrintOptionValues();
+
+    std::string ErrMsg;
+    if (splitCodeGen(mod, OSs, Target, &TLI, FileType, ErrMsg)) {
+      for (unsigned I = 0, E = Outs.size(); I != E; ++I)
+        Outs[I]->keep();
+    } else {
+      errs() << argv[0] << ": " << ErrMsg << '\n';
+      RetVal = 1;
+    }
+  }
+
+  for (unsigned I = 0, E = Outs.size(); I != E; ++I)
+    delete Outs[I];
+  return RetVal;
+}
@@ -52,6 +52,11 @@ static cl::opt<bool>
 PrintInlining("inlining", cl::init(false),
               cl::desc("Print all inlined frames for a given address"));
 
+static cl::opt<unsigned>
+NumThreads("threads", cl::init(0),
+           cl::desc("Number of threads that index the compile units by "
+                    "address"));
+
 static cl::opt<DIDumpType>
 DumpType("debug-dump", cl::init(DIDT_All),
   cl::desc("Dump of debug sections:"),
@@ -98,6 +103,7 @@ static void DumpInput(const StringRef &Filename) {
   }
 
   OwningPtr<DIContext> DICtx(DIContext::getDWARFContext(Obj.get()));
+  DICtx->setNumThreads(NumThreads);
 
   if (Address == -1ULL) {
     outs() << Filename
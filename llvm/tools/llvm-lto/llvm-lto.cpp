@@ -12,16 +12,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSet.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/LTO/LTOCodeGenerator.h"
 #include "llvm/LTO/LTOModule.h"
 #include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/PrettyStackTrace.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/system_error.h"
 
 using namespace llvm;
 
@@ -37,6 +42,11 @@ static cl::opt<bool>
 DisableGVNLoadPRE("disable-gvn-loadpre", cl::init(false),
   cl::desc("Do not run the GVN load PRE pass"));
 
+static cl::opt<unsigned>
+Parallelism("j", cl::Prefix, cl::init(1),
+  cl::desc("Number of object files to generate in parallel; with -o, the "
+           "object files are named <filename>0, <filename>1, ..."));
+
 static cl::list<std::string>
 InputFilenames(cl::Positional, cl::OneOrMore,
   cl::desc("<input bitcode files>"));
@@ -149,7 +159,45 @@ int main(int argc, char **argv) {
   for (unsigned i = 0; i < KeptDSOSyms.size(); ++i)
     CodeGen.addMustPreserveSymbol(KeptDSOSyms[i].c_str());
 
-  if (!OutputFilename.empty()) {
+  if (Parallelism > 1) {
+    std::string ErrorInfo;
+    const char **ObjectNames = NULL;
+    unsigned NumObjects = 0;
+    CodeGen.setCodeGenParallelism(Parallelism);
+    if (!CodeGen.compile_to_files(&ObjectNames, &NumObjects, DisableOpt,
+                                  DisableInline, DisableGVNLoadPRE,
+                                  ErrorInfo)) {
+      errs() << argv[0]
+             << ": error compiling the code: " << ErrorInfo << "\n";
+      return 1;
+    }
+
+    for (unsigned i = 0; i != NumObjects; ++i) {
+      if (OutputFilename.empty()) {
+        outs() << "Wrote native object file '" << ObjectNames[i] << "'\n";
+        continue;
+      }
+
+      OwningPtr<MemoryBuffer> Buffer;
+      if (error_code EC = MemoryBuffer::getFile(ObjectNames[i], Buffer, -1,
+                                                false)) {
+        errs() << argv[0] << ": error reading the file '" << ObjectNames[i]
+               << "': " << EC.message() << "\n";
+        return 1;
+      }
+      sys::fs::remove(ObjectNames[i]);
+
+      std::string Filename = OutputFilename + utostr(i);
+      raw_fd_ostream FileStream(Filename.c_str(), ErrorInfo,
+                                sys::fs::F_Binary);
+      if (!ErrorInfo.empty()) {
+        errs() << argv[0] << ": error opening the file '" << Filename
+               << "': " << ErrorInfo << "\n";
+        return 1;
+      }
+      FileStream << Buffer->getBuffer();
+    }
+  } else if (!OutputFilename.empty()) {
     size_t len = 0;
     std::string ErrorInfo;
     const void *Code = CodeGen.compile(&len, DisableOpt, DisableInline,
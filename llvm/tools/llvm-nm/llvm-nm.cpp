@@ -564,7 +564,8 @@ static void DumpSymbolNamesFromFile(std::string &Filename) {
   }
 
   OwningPtr<MemoryBuffer> Buffer;
-  if (error(MemoryBuffer::getFileOrSTDIN(Filename, Buffer), Filename))
+  if (error(MemoryBuffer::getFileOrSTDIN(Filename, Buffer, -1, false),
+            Filename))
     return;
 
   sys::fs::file_magic magic = sys::fs::identify_magic(Buffer->getBuffer());
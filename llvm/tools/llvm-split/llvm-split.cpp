@@ -0,0 +1,104 @@
+//===-- llvm-split.cpp - Split a module into linkable partitions ----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This utility splits a module into the same linkable partitions that are used
+// for parallel code generation, and writes each partition to its own bitcode
+// file. It is primarily used to test llvm::SplitModule.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Transforms/Utils/SplitModule.h"
+using namespace llvm;
+
+static cl::opt<std::string>
+InputFilename(cl::Positional, cl::desc("<input bitcode file>"),
+              cl::init("-"), cl::value_desc("filename"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Override output filename prefix"),
+               cl::value_desc("filename"));
+
+static cl::opt<unsigned>
+NumOutputs("j", cl::Prefix, cl::init(2),
+           cl::desc("Number of partitions to split the module into"));
+
+static cl::opt<bool>
+PreserveLocality("preserve-locality", cl::init(false),
+                 cl::desc("Keep globals together with the globals using them "
+                          "and balance the partitions"));
+
+namespace {
+/// SplitState - The state shared by the SplitModule callbacks.
+struct SplitState {
+  const char *ProgName;
+  bool Failed;
+};
+} // end anonymous namespace
+
+/// writePartition - Write partition \p Index to "<prefix><Index>".
+static void writePartition(Module *Part, unsigned Index, void *Context) {
+  SplitState &State = *static_cast<SplitState *>(Context);
+  OwningPtr<Module> M(Part);
+
+  std::string ErrorInfo;
+  std::string Filename = OutputFilename + utostr(Index);
+  tool_output_file Out(Filename.c_str(), ErrorInfo, sys::fs::F_Binary);
+  if (!ErrorInfo.empty()) {
+    errs() << State.ProgName << ": " << ErrorInfo << '\n';
+    State.Failed = true;
+    return;
+  }
+
+  WriteBitcodeToFile(M.get(), Out.os());
+  Out.keep();
+}
+
+int main(int argc, char **argv) {
+  // Print a stack trace if we signal out.
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+
+  LLVMContext &Context = getGlobalContext();
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+  cl::ParseCommandLineOptions(argc, argv, "LLVM module splitter\n");
+
+  if (NumOutputs == 0) {
+    errs() << argv[0] << ": the number of partitions must be positive\n";
+    return 1;
+  }
+
+  if (OutputFilename.empty()) {
+    errs() << argv[0] << ": an output filename prefix must be given with -o\n";
+    return 1;
+  }
+
+  SMDiagnostic Err;
+  OwningPtr<Module> M(ParseIRFile(InputFilename, Err, Context));
+  if (!M) {
+    Err.print(argv[0], errs());
+    return 1;
+  }
+
+  SplitState State = { argv[0], false };
+  SplitModule(M.get(), NumOutputs, writePartition, &State, PreserveLocality);
+  return State.Failed ? 1 : 0;
+}
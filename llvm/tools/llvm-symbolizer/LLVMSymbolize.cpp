@@ -19,9 +19,12 @@
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
 #include <sstream>
 #include <stdlib.h>
 
@@ -165,11 +168,134 @@ bool ModuleInfo::symbolizeData(uint64_t ModuleOffset, std::string &Name,
                                 Size);
 }
 
+const std::string *ResultCache::lookup(const std::string &ModuleName,
+                                      uint64_t ModuleOffset, bool IsData) {
+  if (Entries.empty())
+    return 0;
+  Key K = { ModuleName, ModuleOffset, IsData };
+  EntryMapTy::iterator I = Entries.find(K);
+  if (I == Entries.end())
+    return 0;
+  LRU.splice(LRU.begin(), LRU, I->second.Pos);
+  return &I->second.Result;
+}
+
+void ResultCache::insert(const std::string &ModuleName, uint64_t ModuleOffset,
+                         bool IsData, const std::string &Result) {
+  Key K = { ModuleName, ModuleOffset, IsData };
+  size_t EntrySize = getEntrySize(K, Result);
+  if (EntrySize > MaxSize)
+    return;
+  std::pair<EntryMapTy::iterator, bool> Inserted =
+      Entries.insert(std::make_pair(K, Entry()));
+  if (!Inserted.second)
+    return;
+  Inserted.first->second.Result = Result;
+  LRU.push_front(&Inserted.first->first);
+  Inserted.first->second.Pos = LRU.begin();
+  Size += EntrySize;
+
+  while (Size > MaxSize) {
+    EntryMapTy::iterator Last = Entries.find(*LRU.back());
+    Size -= getEntrySize(Last->first, Last->second.Result);
+    LRU.pop_back();
+    Entries.erase(Last);
+  }
+}
+
+void ResultCache::clear() {
+  Entries.clear();
+  LRU.clear();
+  Size = 0;
+}
+
 const char LLVMSymbolizer::kBadString[] = "??";
 
 std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
                                           uint64_t ModuleOffset) {
-  ModuleInfo *Info = getOrCreateModuleInfo(ModuleName);
+  if (const std::string *Cached =
+          CachedResults.lookup(ModuleName, ModuleOffset, false))
+    return *Cached;
+  std::string Result =
+      symbolizeCode(getOrCreateModuleInfo(ModuleName), ModuleOffset);
+  CachedResults.insert(ModuleName, ModuleOffset, false, Result);
+  return Result;
+}
+
+std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
+                                          uint64_t ModuleOffset) {
+  if (const std::string *Cached =
+          CachedResults.lookup(ModuleName, ModuleOffset, true))
+    return *Cached;
+  ModuleInfo *Info = Opts.UseSymbolTable ? getOrCreateModuleInfo(ModuleName)
+                                         : 0;
+  std::string Result = symbolizeData(Info, ModuleOffset);
+  CachedResults.insert(ModuleName, ModuleOffset, true, Result);
+  return Result;
+}
+
+namespace {
+/// RequestOrder - Orders the indices of requests by module, kind and offset.
+struct RequestOrder {
+  ArrayRef<LLVMSymbolizer::Request> Requests;
+  explicit RequestOrder(ArrayRef<LLVMSymbolizer::Request> Requests)
+      : Requests(Requests) {}
+
+  static bool same(const LLVMSymbolizer::Request &L,
+                   const LLVMSymbolizer::Request &R) {
+    return L.ModuleOffset == R.ModuleOffset && L.IsData == R.IsData &&
+           L.ModuleName == R.ModuleName;
+  }
+  bool operator()(unsigned LHS, unsigned RHS) const {
+    const LLVMSymbolizer::Request &L = Requests[LHS], &R = Requests[RHS];
+    int Cmp = L.ModuleName.compare(R.ModuleName);
+    if (Cmp != 0)
+      return Cmp < 0;
+    if (L.IsData != R.IsData)
+      return L.IsData < R.IsData;
+    return L.ModuleOffset < R.ModuleOffset;
+  }
+};
+}
+
+void LLVMSymbolizer::symbolizeBatch(ArrayRef<Request> Requests,
+                                    std::vector<std::string> &Results) {
+  // Symbolizing the offsets of a module in increasing order looks its
+  // modules, compile units and line tables up once per run of offsets that
+  // share them, and visits each of them in address order.
+  std::vector<unsigned> Order(Requests.size());
+  for (unsigned i = 0, e = Requests.size(); i != e; ++i)
+    Order[i] = i;
+  std::sort(Order.begin(), Order.end(), RequestOrder(Requests));
+
+  Results.assign(Requests.size(), std::string());
+  ModuleInfo *Info = 0;
+  const std::string *InfoName = 0;
+  for (unsigned i = 0, e = Order.size(); i != e; ++i) {
+    const Request &R = Requests[Order[i]];
+    std::string &Result = Results[Order[i]];
+    if (i != 0 && RequestOrder::same(Requests[Order[i - 1]], R)) {
+      Result = Results[Order[i - 1]];
+      continue;
+    }
+    if (const std::string *Cached =
+            CachedResults.lookup(R.ModuleName, R.ModuleOffset, R.IsData)) {
+      Result = *Cached;
+      continue;
+    }
+    bool NeedsModule = !R.IsData || Opts.UseSymbolTable;
+    if (NeedsModule && (InfoName == 0 || *InfoName != R.ModuleName)) {
+      Info = getOrCreateModuleInfo(R.ModuleName);
+      InfoName = &R.ModuleName;
+    }
+    Result = R.IsData ? symbolizeData(NeedsModule ? Info : 0, R.ModuleOffset)
+                      : symbolizeCode(Info, R.ModuleOffset);
+    CachedResults.insert(R.ModuleName, R.ModuleOffset, R.IsData, Result);
+  }
+}
+
+std::string LLVMSymbolizer::symbolizeCode(ModuleInfo *Info,
+                                          uint64_t ModuleOffset) {
   if (Info == 0)
     return printDILineInfo(DILineInfo());
   if (Opts.PrintInlining) {
@@ -188,16 +314,14 @@ std::string LLVMSymbolizer::symbolizeCode(const std::string &ModuleName,
   return printDILineInfo(LineInfo);
 }
 
-std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
+std::string LLVMSymbolizer::symbolizeData(ModuleInfo *Info,
                                           uint64_t ModuleOffset) {
   std::string Name = kBadString;
   uint64_t Start = 0;
   uint64_t Size = 0;
-  if (Opts.UseSymbolTable) {
-    if (ModuleInfo *Info = getOrCreateModuleInfo(ModuleName)) {
-      if (Info->symbolizeData(ModuleOffset, Name, Start, Size) && Opts.Demangle)
-        Name = DemangleGlobalName(Name);
-    }
+  if (Info) {
+    if (Info->symbolizeData(ModuleOffset, Name, Start, Size) && Opts.Demangle)
+      Name = DemangleGlobalName(Name);
   }
   std::stringstream ss;
   ss << Name << "\n" << Start << " " << Size << "\n";
@@ -205,7 +329,12 @@ std::string LLVMSymbolizer::symbolizeData(const std::string &ModuleName,
 }
 
 void LLVMSymbolizer::flush() {
-  DeleteContainerSeconds(Modules);
+  for (ModuleMapTy::iterator I = Modules.begin(), E = Modules.end(); I != E;
+       ++I)
+    delete I->second.first;
+  Modules.clear();
+  ModuleLRU.clear();
+  CachedResults.clear();
   DeleteContainerPointers(ParsedBinariesAndObjects);
   BinaryForPath.clear();
   ObjectFileForArch.clear();
@@ -363,13 +492,13 @@ LLVMSymbolizer::getObjectFileFromBinary(Binary *Bin, const std::string &ArchName
   return Res;
 }
 
-ModuleInfo *
-LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
-  ModuleMapTy::iterator I = Modules.find(ModuleName);
-  if (I != Modules.end())
-    return I->second;
-  std::string BinaryName = ModuleName;
-  std::string ArchName = Opts.DefaultArch;
+/// splitModuleName - Split ModuleName into the path of the binary and the
+/// architecture, which follows a colon if it is given.
+static void splitModuleName(const std::string &ModuleName,
+                            const std::string &DefaultArch,
+                            std::string &BinaryName, std::string &ArchName) {
+  BinaryName = ModuleName;
+  ArchName = DefaultArch;
   size_t ColonPos = ModuleName.find_last_of(':');
   // Verify that substring after colon form a valid arch name.
   if (ColonPos != std::string::npos) {
@@ -379,22 +508,135 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       ArchName = ArchStr;
     }
   }
+}
+
+ModuleInfo *
+LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
+  ModuleMapTy::iterator I = Modules.find(ModuleName);
+  if (I != Modules.end()) {
+    ModuleLRU.splice(ModuleLRU.begin(), ModuleLRU, I->second.second);
+    return I->second.first;
+  }
+  std::string BinaryName, ArchName;
+  splitModuleName(ModuleName, Opts.DefaultArch, BinaryName, ArchName);
   BinaryPair Binaries = getOrCreateBinary(BinaryName);
   ObjectFile *Obj = getObjectFileFromBinary(Binaries.first, ArchName);
   ObjectFile *DbgObj = getObjectFileFromBinary(Binaries.second, ArchName);
 
   if (Obj == 0) {
     // Failed to find valid object file.
-    Modules.insert(make_pair(ModuleName, (ModuleInfo *)0));
-    return 0;
+    return addModuleInfo(ModuleName, 0);
   }
   DIContext *Context = DIContext::getDWARFContext(DbgObj);
   assert(Context);
-  ModuleInfo *Info = new ModuleInfo(Obj, Context);
-  Modules.insert(make_pair(ModuleName, Info));
+  Context->setNumThreads(Opts.NumThreads);
+  if (!Opts.IndexDir.empty())
+    loadOrWriteAddressIndex(Context, DbgObj, ArchName);
+  return addModuleInfo(ModuleName, new ModuleInfo(Obj, Context));
+}
+
+ModuleInfo *LLVMSymbolizer::addModuleInfo(const std::string &ModuleName,
+                                          ModuleInfo *Info) {
+  ModuleLRU.push_front(ModuleName);
+  Modules.insert(make_pair(ModuleName, ModuleEntry(Info, ModuleLRU.begin())));
+  if (Opts.MaxModules != 0 && Modules.size() > Opts.MaxModules) {
+    std::string Evicted = ModuleLRU.back();
+    ModuleMapTy::iterator Last = Modules.find(Evicted);
+    delete Last->second.first;
+    Modules.erase(Last);
+    ModuleLRU.pop_back();
+
+    // Unmap the binary too, unless another architecture of it is still in
+    // use.
+    std::string BinaryName, ArchName, OtherBinaryName;
+    splitModuleName(Evicted, Opts.DefaultArch, BinaryName, ArchName);
+    for (ModuleMapTy::iterator I = Modules.begin(), E = Modules.end(); I != E;
+         ++I) {
+      splitModuleName(I->first, Opts.DefaultArch, OtherBinaryName, ArchName);
+      if (OtherBinaryName == BinaryName)
+        return Info;
+    }
+    releaseBinary(BinaryName);
+  }
   return Info;
 }
 
+void LLVMSymbolizer::deleteBinary(Binary *Bin) {
+  if (MachOUniversalBinary *UB = dyn_cast<MachOUniversalBinary>(Bin)) {
+    ObjectFileForArchMapTy::iterator I =
+        ObjectFileForArch.lower_bound(std::make_pair(UB, std::string()));
+    while (I != ObjectFileForArch.end() && I->first.first == UB) {
+      if (ObjectFile *Obj = I->second)
+        deleteBinary(Obj);
+      ObjectFileForArch.erase(I++);
+    }
+  }
+  ParsedBinariesAndObjects.erase(std::find(ParsedBinariesAndObjects.begin(),
+                                           ParsedBinariesAndObjects.end(),
+                                           Bin));
+  delete Bin;
+}
+
+void LLVMSymbolizer::releaseBinary(const std::string &Path) {
+  BinaryMapTy::iterator I = BinaryForPath.find(Path);
+  if (I == BinaryForPath.end())
+    return;
+  BinaryPair Binaries = I->second;
+  BinaryForPath.erase(I);
+  if (Binaries.second && Binaries.second != Binaries.first)
+    deleteBinary(Binaries.second);
+  if (Binaries.first)
+    deleteBinary(Binaries.first);
+}
+
+void LLVMSymbolizer::loadOrWriteAddressIndex(DIContext *Context,
+                                             ObjectFile *DbgObj,
+                                             const std::string &ArchName) {
+  // The index is named after an MD5 of the path and architecture of the
+  // object, and is tagged with an MD5 of its contents, so that it is found
+  // again by any build of the symbolizer and never used for another version
+  // of the object.
+  StringRef Path = DbgObj->getFileName();
+  MD5 NameHash;
+  NameHash.update(Path);
+  NameHash.update(StringRef("\0", 1));
+  NameHash.update(ArchName);
+  MD5::MD5Result NameResult;
+  NameHash.final(NameResult);
+  SmallString<32> Name;
+  MD5::stringifyResult(NameResult, Name);
+
+  MD5 ContentHash;
+  ContentHash.update(DbgObj->getData());
+  MD5::MD5Result ContentResult;
+  ContentHash.final(ContentResult);
+  uint64_t Key = 0;
+  for (unsigned I = 0; I != 8; ++I)
+    Key |= uint64_t(ContentResult[I]) << (I * 8);
+
+  SmallString<128> IndexPath(Opts.IndexDir);
+  sys::path::append(IndexPath, sys::path::filename(Path) + "-" + Name.str() +
+                                   ".aranges");
+
+  OwningPtr<MemoryBuffer> Index;
+  if (!MemoryBuffer::getFile(IndexPath.str(), Index, -1, false) &&
+      Context->readAddressIndex(Index->getBuffer(), Key))
+    return;
+
+  // Write the index to a temporary file first, so that concurrent symbolizers
+  // never read a partial index.
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(IndexPath + "-%%%%%%", FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, true);
+    Context->writeAddressIndex(OS, Key);
+  }
+  if (sys::fs::rename(TempPath.str(), IndexPath.str()))
+    sys::fs::remove(TempPath.str());
+}
+
 std::string LLVMSymbolizer::printDILineInfo(DILineInfo LineInfo) const {
   // By default, DILineInfo contains "<invalid>" for function/filename it
   // cannot fetch. We replace it to "??" to make our output closer to addr2line.
@@ -13,14 +13,17 @@
 #ifndef LLVM_SYMBOLIZE_H
 #define LLVM_SYMBOLIZE_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/DebugInfo/DIContext.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <list>
 #include <map>
 #include <string>
+#include <vector>
 
 namespace llvm {
 
@@ -30,6 +33,51 @@ namespace symbolize {
 
 class ModuleInfo;
 
+/// \brief Symbolization results keyed by module, offset and kind.  Once the
+/// results take more than MaxSize bytes, the least recently used ones are
+/// dropped.  A MaxSize of zero disables the cache.
+class ResultCache {
+public:
+  explicit ResultCache(size_t MaxSize = 0) : MaxSize(MaxSize), Size(0) {}
+
+  /// \brief Returns the cached result, or null if there is none.
+  const std::string *lookup(const std::string &ModuleName,
+                            uint64_t ModuleOffset, bool IsData);
+  void insert(const std::string &ModuleName, uint64_t ModuleOffset,
+              bool IsData, const std::string &Result);
+  void clear();
+
+private:
+  struct Key {
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+    bool IsData;
+    bool operator<(const Key &RHS) const {
+      if (ModuleOffset != RHS.ModuleOffset)
+        return ModuleOffset < RHS.ModuleOffset;
+      if (IsData != RHS.IsData)
+        return IsData < RHS.IsData;
+      return ModuleName < RHS.ModuleName;
+    }
+  };
+  // The keys of the entries, most recently used first.
+  typedef std::list<const Key *> KeyListTy;
+  struct Entry {
+    std::string Result;
+    KeyListTy::iterator Pos;
+  };
+  typedef std::map<Key, Entry> EntryMapTy;
+
+  static size_t getEntrySize(const Key &K, const std::string &Result) {
+    return sizeof(Key) + sizeof(Entry) + K.ModuleName.size() + Result.size();
+  }
+
+  EntryMapTy Entries;
+  KeyListTy LRU;
+  size_t MaxSize;
+  size_t Size;
+};
+
 class LLVMSymbolizer {
 public:
   struct Options {
@@ -38,16 +86,38 @@ public:
     bool PrintInlining : 1;
     bool Demangle : 1;
     std::string DefaultArch;
+    /// Number of threads that index the debug info of a module by address.
+    unsigned NumThreads;
+    /// Directory that holds the address indexes of modules across runs, or
+    /// empty to index every module anew.
+    std::string IndexDir;
+    /// Number of modules whose symbols and debug info are kept parsed, or
+    /// zero for no limit.  The least recently used module is dropped first.
+    unsigned MaxModules;
+    /// Number of bytes of symbolization results to keep, or zero for none.
+    size_t ResultCacheSize;
     Options(bool UseSymbolTable = true, bool PrintFunctions = true,
             bool PrintInlining = true, bool Demangle = true,
-            std::string DefaultArch = "")
+            std::string DefaultArch = "", unsigned NumThreads = 0,
+            std::string IndexDir = "", unsigned MaxModules = 0,
+            size_t ResultCacheSize = 0)
         : UseSymbolTable(UseSymbolTable), PrintFunctions(PrintFunctions),
           PrintInlining(PrintInlining), Demangle(Demangle),
-          DefaultArch(DefaultArch) {
+          DefaultArch(DefaultArch), NumThreads(NumThreads),
+          IndexDir(IndexDir), MaxModules(MaxModules),
+          ResultCacheSize(ResultCacheSize) {
     }
   };
 
-  LLVMSymbolizer(const Options &Opts = Options()) : Opts(Opts) {}
+  /// \brief A request to symbolize an offset in a module.
+  struct Request {
+    std::string ModuleName;
+    uint64_t ModuleOffset;
+    bool IsData;
+  };
+
+  LLVMSymbolizer(const Options &Opts = Options())
+      : CachedResults(Opts.ResultCacheSize), Opts(Opts) {}
   ~LLVMSymbolizer() {
     flush();
   }
@@ -58,26 +128,49 @@ public:
   symbolizeCode(const std::string &ModuleName, uint64_t ModuleOffset);
   std::string
   symbolizeData(const std::string &ModuleName, uint64_t ModuleOffset);
+  /// \brief Symbolizes the requests grouped by module and in order of
+  /// increasing offset, and stores the result of Requests[i] in Results[i].
+  void symbolizeBatch(ArrayRef<Request> Requests,
+                      std::vector<std::string> &Results);
   void flush();
   static std::string DemangleName(const std::string &Name);
 private:
   typedef std::pair<Binary*, Binary*> BinaryPair;
 
+  std::string symbolizeCode(ModuleInfo *Info, uint64_t ModuleOffset);
+  std::string symbolizeData(ModuleInfo *Info, uint64_t ModuleOffset);
   ModuleInfo *getOrCreateModuleInfo(const std::string &ModuleName);
+  /// \brief Records Info for ModuleName as the most recently used module,
+  /// dropping the least recently used one, and unmapping its binary, if there
+  /// are too many.
+  ModuleInfo *addModuleInfo(const std::string &ModuleName, ModuleInfo *Info);
+  /// \brief Deletes the binary and debug binary parsed for Path.
+  void releaseBinary(const std::string &Path);
+  /// \brief Deletes Bin and the objects parsed from it.
+  void deleteBinary(Binary *Bin);
   /// \brief Returns pair of pointers to binary and debug binary.
   BinaryPair getOrCreateBinary(const std::string &Path);
   /// \brief Returns a parsed object file for a given architecture in a
   /// universal binary (or the binary itself if it is an object file).
   ObjectFile *getObjectFileFromBinary(Binary *Bin, const std::string &ArchName);
+  /// \brief Reads the address index of a debug object from Opts.IndexDir, or
+  /// writes one there if it holds none for the current version of the object.
+  void loadOrWriteAddressIndex(DIContext *Context, ObjectFile *DbgObj,
+                               const std::string &ArchName);
 
   std::string printDILineInfo(DILineInfo LineInfo) const;
   static std::string DemangleGlobalName(const std::string &Name);
 
   // Owns all the parsed binaries and object files.
   SmallVector<Binary*, 4> ParsedBinariesAndObjects;
-  // Owns module info objects.
-  typedef std::map<std::string, ModuleInfo *> ModuleMapTy;
+  // Owns module info objects.  ModuleLRU holds the module names, most
+  // recently used first.  Dropping a module unmaps its binaries as well.
+  typedef std::list<std::string> ModuleListTy;
+  typedef std::pair<ModuleInfo *, ModuleListTy::iterator> ModuleEntry;
+  typedef std::map<std::string, ModuleEntry> ModuleMapTy;
   ModuleMapTy Modules;
+  ModuleListTy ModuleLRU;
+  ResultCache CachedResults;
   typedef std::map<std::string, BinaryPair> BinaryMapTy;
   BinaryMapTy BinaryForPath;
   typedef std::map<std::pair<MachOUniversalBinary *, std::string>, ObjectFile *>
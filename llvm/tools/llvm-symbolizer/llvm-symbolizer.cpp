@@ -26,6 +26,7 @@
 #include <cstdio>
 #include <cstring>
 #include <string>
+#include <vector>
 
 using namespace llvm;
 using namespace symbolize;
@@ -51,19 +52,43 @@ static cl::opt<std::string> ClDefaultArch("default-arch", cl::init(""),
                                           cl::desc("Default architecture "
                                                    "(for multi-arch objects)"));
 
-static bool parseCommand(bool &IsData, std::string &ModuleName,
-                         uint64_t &ModuleOffset) {
+static cl::opt<unsigned>
+ClThreads("threads", cl::init(0),
+          cl::desc("Number of threads that index the debug info of a module "
+                   "by address"));
+
+static cl::opt<std::string>
+ClIndexDir("index-dir", cl::init(""),
+           cl::desc("Directory to keep the address indexes of modules in, "
+                    "so that later runs need not build them again"));
+
+static cl::opt<bool>
+ClBatch("batch", cl::init(false),
+        cl::desc("Read requests up to an empty line or the end of the input, "
+                 "symbolize them grouped by module and offset, and print the "
+                 "results in input order"));
+
+static cl::opt<unsigned>
+ClMaxModules("max-modules", cl::init(0),
+             cl::desc("Number of modules to keep parsed, dropping the least "
+                      "recently used ones (default: no limit)"));
+
+static cl::opt<unsigned long long>
+ClResultCacheSize("result-cache-size", cl::init(0),
+                  cl::desc("Number of bytes of results to keep, dropping "
+                           "the least recently used ones"));
+
+static const int kMaxInputStringLength = 1024;
+
+static bool parseCommand(const char *InputString, bool &IsData,
+                         std::string &ModuleName, uint64_t &ModuleOffset) {
   const char *kDataCmd = "DATA ";
   const char *kCodeCmd = "CODE ";
-  const int kMaxInputStringLength = 1024;
   const char kDelimiters[] = " \n";
-  char InputString[kMaxInputStringLength];
-  if (!fgets(InputString, sizeof(InputString), stdin))
-    return false;
   IsData = false;
   ModuleName = "";
   std::string ModuleOffsetStr = "";
-  char *pos = InputString;
+  const char *pos = InputString;
   if (strncmp(pos, kDataCmd, strlen(kDataCmd)) == 0) {
     IsData = true;
     pos += strlen(kDataCmd);
@@ -79,7 +104,7 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   if (*pos == '"' || *pos == '\'') {
     char quote = *pos;
     pos++;
-    char *end = strchr(pos, quote);
+    const char *end = strchr(pos, quote);
     if (end == 0)
       return false;
     ModuleName = std::string(pos, end - pos);
@@ -98,6 +123,43 @@ static bool parseCommand(bool &IsData, std::string &ModuleName,
   return true;
 }
 
+static bool readCommand(bool &IsData, std::string &ModuleName,
+                        uint64_t &ModuleOffset) {
+  char InputString[kMaxInputStringLength];
+  if (!fgets(InputString, sizeof(InputString), stdin))
+    return false;
+  return parseCommand(InputString, IsData, ModuleName, ModuleOffset);
+}
+
+/// runBatches - Symbolize the requests up to each empty line, and those up to
+/// the end of the input, as one batch.
+static void runBatches(LLVMSymbolizer &Symbolizer) {
+  std::vector<LLVMSymbolizer::Request> Requests;
+  std::vector<std::string> Results;
+  bool Done = false;
+  while (!Done) {
+    Requests.clear();
+    char InputString[kMaxInputStringLength];
+    while (fgets(InputString, sizeof(InputString), stdin)) {
+      if (StringRef(InputString).trim().empty())
+        break;
+      LLVMSymbolizer::Request R;
+      if (!parseCommand(InputString, R.IsData, R.ModuleName, R.ModuleOffset)) {
+        Done = true;
+        break;
+      }
+      Requests.push_back(R);
+    }
+    if (feof(stdin))
+      Done = true;
+
+    Symbolizer.symbolizeBatch(Requests, Results);
+    for (unsigned i = 0, e = Results.size(); i != e; ++i)
+      outs() << Results[i] << "\n";
+    outs().flush();
+  }
+}
+
 int main(int argc, char **argv) {
   // Print stack trace if we signal out.
   sys::PrintStackTraceOnErrorSignal();
@@ -106,13 +168,20 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm symbolizer for compiler-rt\n");
   LLVMSymbolizer::Options Opts(ClUseSymbolTable, ClPrintFunctions,
-                               ClPrintInlining, ClDemangle, ClDefaultArch);
+                               ClPrintInlining, ClDemangle, ClDefaultArch,
+                               ClThreads, ClIndexDir, ClMaxModules,
+                               ClResultCacheSize);
   LLVMSymbolizer Symbolizer(Opts);
 
+  if (ClBatch) {
+    runBatches(Symbolizer);
+    return 0;
+  }
+
   bool IsData = false;
   std::string ModuleName;
   uint64_t ModuleOffset;
-  while (parseCommand(IsData, ModuleName, ModuleOffset)) {
+  while (readCommand(IsData, ModuleName, ModuleOffset)) {
     std::string Result =
         IsData ? Symbolizer.symbolizeData(ModuleName, ModuleOffset)
                : Symbolizer.symbolizeCode(ModuleName, ModuleOffset);
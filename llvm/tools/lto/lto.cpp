@@ -240,6 +240,12 @@ void lto_codegen_set_cpu(lto_code_gen_t cg, const char *cpu) {
   return cg->setCpu(cpu);
 }
 
+/// lto_codegen_set_parallelism - Sets the number of native object files
+/// generated by lto_codegen_compile_to_files().
+void lto_codegen_set_parallelism(lto_code_gen_t cg, unsigned parallelism) {
+  cg->setCodeGenParallelism(parallelism);
+}
+
 /// lto_codegen_set_assembler_path - Sets the path to the assembler tool.
 void lto_codegen_set_assembler_path(lto_code_gen_t cg, const char *path) {
   // In here only for backwards compatibility. We use MC now.
@@ -298,6 +304,20 @@ bool lto_codegen_compile_to_file(lto_code_gen_t cg, const char **name) {
                               sLastErrorString);
 }
 
+/// lto_codegen_compile_to_files - Generates code for all added modules into as
+/// many native object files as set by lto_codegen_set_parallelism(). The names
+/// of the files are written to names and their number to count. Returns true
+/// on error.
+bool lto_codegen_compile_to_files(lto_code_gen_t cg, const char ***names,
+                                  unsigned *count) {
+  if (!parsedOptions) {
+    cg->parseCodeGenDebugOptions();
+    parsedOptions = true;
+  }
+  return !cg->compile_to_files(names, count, DisableOpt, DisableInline,
+                               DisableGVNLoadPRE, sLastErrorString);
+}
+
 /// lto_codegen_debug_options - Used to pass extra options to the code
 /// generator.
 void lto_codegen_debug_options(lto_code_gen_t cg, const char *opt) {
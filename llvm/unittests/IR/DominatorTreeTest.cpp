@@ -9,6 +9,7 @@
 
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Assembly/Parser.h"
+#include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
@@ -196,6 +197,216 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    // Make Succs the successors of BB, branching on the argument of its
+    // function.
+    void setSuccessors(BasicBlock *BB, ArrayRef<BasicBlock *> Succs) {
+      LLVMContext &C = BB->getContext();
+      if (TerminatorInst *TI = BB->getTerminator())
+        TI->eraseFromParent();
+      if (Succs.empty()) {
+        ReturnInst::Create(C, BB);
+        return;
+      }
+      Value *X = BB->getParent()->arg_begin();
+      SwitchInst *SI = SwitchInst::Create(X, Succs[0], Succs.size() - 1, BB);
+      for (unsigned i = 1, e = Succs.size(); i != e; ++i)
+        SI->addCase(ConstantInt::get(Type::getInt32Ty(C), i), Succs[i]);
+    }
+
+    // Check that DT matches a tree computed from scratch, and that the
+    // levels are consistent.
+    void expectValid(DominatorTreeBase<BasicBlock> &DT, Function &F) {
+      DominatorTreeBase<BasicBlock> Fresh(false);
+      Fresh.recalculate(F);
+      EXPECT_FALSE(DT.compare(Fresh));
+      for (Function::iterator I = F.begin(), E = F.end(); I != E; ++I) {
+        DomTreeNode *N = DT.getNode(I);
+        EXPECT_EQ(Fresh.getNode(I) != 0, N != 0);
+        if (N && N->getIDom())
+          EXPECT_EQ(N->getIDom()->getLevel() + 1, N->getLevel());
+      }
+    }
+
+    Function *makeFunction(Module &M, unsigned NumBlocks,
+                           SmallVectorImpl<BasicBlock *> &Blocks) {
+      LLVMContext &C = M.getContext();
+      Type *ArgTy = Type::getInt32Ty(C);
+      FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), ArgTy, false);
+      Function *F = Function::Create(FTy, GlobalValue::ExternalLinkage, "f",
+                                     &M);
+      for (unsigned i = 0; i != NumBlocks; ++i)
+        Blocks.push_back(BasicBlock::Create(C, "", F));
+      return F;
+    }
+
+    TEST(DominatorTree, InsertDeleteEdges) {
+      LLVMContext C;
+      Module M("m", C);
+      SmallVector<BasicBlock *, 8> B;
+      Function *F = makeFunction(M, 6, B);
+
+      // 0 -> 1 -> 2 -> 3, and 4 -> 5 is unreachable.
+      setSuccessors(B[0], B[1]);
+      setSuccessors(B[1], B[2]);
+      setSuccessors(B[2], B[3]);
+      setSuccessors(B[3], ArrayRef<BasicBlock *>());
+      setSuccessors(B[4], B[5]);
+      setSuccessors(B[5], ArrayRef<BasicBlock *>());
+
+      DominatorTreeBase<BasicBlock> DT(false);
+      DT.recalculate(*F);
+      EXPECT_EQ(3u, DT.getNode(B[3])->getLevel());
+
+      // A shortcut moves 3 up to 0.
+      BasicBlock *Succs0[] = { B[1], B[3] };
+      setSuccessors(B[0], Succs0);
+      DT.insertEdge(B[0], B[3]);
+      expectValid(DT, *F);
+      EXPECT_EQ(B[0], DT.getNode(B[3])->getIDom()->getBlock());
+
+      // An edge into the unreachable part makes 4 and 5 reachable.
+      BasicBlock *Succs2[] = { B[3], B[4] };
+      setSuccessors(B[2], Succs2);
+      DT.insertEdge(B[2], B[4]);
+      expectValid(DT, *F);
+      EXPECT_EQ(4u, DT.getNode(B[5])->getLevel());
+
+      // Removing the shortcut makes 2 dominate 3 again.
+      setSuccessors(B[0], B[1]);
+      DT.deleteEdge(B[0], B[3]);
+      expectValid(DT, *F);
+      EXPECT_EQ(B[2], DT.getNode(B[3])->getIDom()->getBlock());
+
+      // Cutting 1 -> 2 leaves only 0 and 1 reachable.
+      setSuccessors(B[1], ArrayRef<BasicBlock *>());
+      DT.deleteEdge(B[1], B[2]);
+      expectValid(DT, *F);
+      EXPECT_EQ(0, DT.getNode(B[2]));
+      EXPECT_EQ(0, DT.getNode(B[5]));
+    }
+
+    TEST(DominatorTree, BatchUpdates) {
+      LLVMContext C;
+      Module M("m", C);
+      SmallVector<BasicBlock *, 8> B;
+      Function *F = makeFunction(M, 5, B);
+
+      // A diamond 0 -> {1, 2} -> 3, with 4 unreachable.
+      BasicBlock *Diamond[] = { B[1], B[2] };
+      setSuccessors(B[0], Diamond);
+      setSuccessors(B[1], B[3]);
+      setSuccessors(B[2], B[3]);
+      setSuccessors(B[3], ArrayRef<BasicBlock *>());
+      setSuccessors(B[4], B[3]);
+
+      DominatorTreeBase<BasicBlock> DT(false);
+      DT.recalculate(*F);
+
+      // Route 0 through 4 instead of 2, and make 1 the only way to 3.
+      typedef DomTreeUpdate<BasicBlock> Update;
+      BasicBlock *Succs0[] = { B[1], B[4] };
+      setSuccessors(B[0], Succs0);
+      setSuccessors(B[4], B[2]);
+      setSuccessors(B[2], B[1]);
+      Update Updates[] = {
+        Update(Update::Insert, B[0], B[4]),
+        Update(Update::Delete, B[0], B[2]),
+        Update(Update::Delete, B[4], B[3]),
+        Update(Update::Insert, B[4], B[2]),
+        Update(Update::Delete, B[2], B[3]),
+        Update(Update::Insert, B[2], B[1]),
+        // Cancels out.
+        Update(Update::Insert, B[3], B[0]),
+        Update(Update::Delete, B[3], B[0])
+      };
+      DT.applyUpdates(Updates);
+      expectValid(DT, *F);
+      EXPECT_EQ(B[1], DT.getNode(B[3])->getIDom()->getBlock());
+      EXPECT_EQ(B[0], DT.getNode(B[1])->getIDom()->getBlock());
+    }
+
+    TEST(DominatorTree, EraseRootNode) {
+      LLVMContext C;
+      Module M("m", C);
+      SmallVector<BasicBlock *, 8> B;
+      Function *F = makeFunction(M, 4, B);
+
+      // 0 -> 1 -> {2, 3}, 2 -> 3.
+      setSuccessors(B[0], B[1]);
+      BasicBlock *Succs1[] = { B[2], B[3] };
+      setSuccessors(B[1], Succs1);
+      setSuccessors(B[2], B[3]);
+      setSuccessors(B[3], ArrayRef<BasicBlock *>());
+
+      DominatorTreeBase<BasicBlock> DT(false);
+      DT.recalculate(*F);
+
+      // Drop the entry block; its only successor becomes the root.
+      DT.eraseRootNode();
+      B[0]->eraseFromParent();
+      expectValid(DT, *F);
+      EXPECT_EQ(B[1], DT.getRoot());
+      EXPECT_EQ(0u, DT.getNode(B[1])->getLevel());
+      EXPECT_EQ(1u, DT.getNode(B[3])->getLevel());
+    }
+
+    unsigned nextRandom(uint32_t &Seed, unsigned Max) {
+      Seed = Seed * 1103515245 + 12345;
+      return (Seed >> 16) % Max;
+    }
+
+    TEST(DominatorTree, RandomUpdates) {
+      LLVMContext C;
+      Module M("m", C);
+      SmallVector<BasicBlock *, 32> B;
+      const unsigned NumBlocks = 24;
+      Function *F = makeFunction(M, NumBlocks, B);
+
+      uint32_t Seed = 12345;
+
+      std::vector<std::vector<BasicBlock *> > Succs(NumBlocks);
+      for (unsigned i = 0; i != NumBlocks; ++i) {
+        if (i + 1 != NumBlocks)
+          Succs[i].push_back(B[i + 1]);
+        setSuccessors(B[i], Succs[i]);
+      }
+
+      DominatorTreeBase<BasicBlock> DT(false);
+      DT.recalculate(*F);
+
+      typedef DomTreeUpdate<BasicBlock> Update;
+      for (unsigned Round = 0; Round != 200; ++Round) {
+        SmallVector<Update, 8> Updates;
+        // Odd rounds apply several edits as a batch; the others apply a
+        // single one directly.
+        unsigned NumEdits = Round % 2 ? 1 + nextRandom(Seed, 4) : 1;
+        for (unsigned Edit = 0; Edit != NumEdits; ++Edit) {
+          unsigned From = nextRandom(Seed, NumBlocks);
+          std::vector<BasicBlock *> &S = Succs[From];
+          if (!S.empty() && nextRandom(Seed, 2)) {
+            unsigned Idx = nextRandom(Seed, S.size());
+            Updates.push_back(Update(Update::Delete, B[From], S[Idx]));
+            S.erase(S.begin() + Idx);
+          } else {
+            BasicBlock *To = B[1 + nextRandom(Seed, NumBlocks - 1)];
+            if (std::find(S.begin(), S.end(), To) != S.end())
+              continue;
+            Updates.push_back(Update(Update::Insert, B[From], To));
+            S.push_back(To);
+          }
+          setSuccessors(B[From], S);
+        }
+
+        if (Round % 2)
+          DT.applyUpdates(Updates);
+        else if (!Updates.empty() && Updates[0].Kind == Update::Insert)
+          DT.insertEdge(Updates[0].From, Updates[0].To);
+        else if (!Updates.empty())
+          DT.deleteEdge(Updates[0].From, Updates[0].To);
+        expectValid(DT, *F);
+      }
+    }
   }
 }
 
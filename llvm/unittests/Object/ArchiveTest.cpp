@@ -0,0 +1,143 @@
+//===- llvm/unittest/Object/ArchiveTest.cpp - Tests for Archive -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/Archive.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "gtest/gtest.h"
+#include <string>
+
+using namespace llvm;
+using namespace object;
+
+namespace {
+
+/// appendMember - Append a member header and its contents, padded to an even
+/// size.
+void appendMember(std::string &Archive, StringRef Name, StringRef Contents) {
+  std::string Header = Name;
+  Header.resize(48, ' ');
+  std::string Size = Twine(Contents.size()).str();
+  Size.resize(10, ' ');
+  Archive += Header + Size + "`\n";
+  Archive += Contents;
+  if (Archive.size() & 1)
+    Archive += '\n';
+}
+
+void appendBig32(std::string &Out, uint32_t V) {
+  Out += char(V >> 24);
+  Out += char(V >> 16);
+  Out += char(V >> 8);
+  Out += char(V);
+}
+
+/// makeArchive - Make a GNU archive of the three members "a.o", "b.o" and
+/// "c.o" with a symbol table listing Symbols[I] in member MemberOf[I].
+std::string makeArchive(ArrayRef<const char *> Symbols,
+                        ArrayRef<unsigned> MemberOf) {
+  const char *Members[] = { "a.o/", "b.o/", "c.o/" };
+  const char *Contents[] = { "contents of a", "b", "contents of c" };
+
+  std::string Names;
+  for (unsigned I = 0, E = Symbols.size(); I != E; ++I)
+    (Names += Symbols[I]) += '\0';
+  unsigned TableSize = 4 + 4 * Symbols.size() + Names.size();
+
+  // Lay the members out after the symbol table to find their offsets.
+  uint32_t Offsets[3];
+  std::string Rest;
+  unsigned Start = 8 + 60 + TableSize + (TableSize & 1);
+  for (unsigned I = 0; I != 3; ++I) {
+    Offsets[I] = Start + Rest.size();
+    appendMember(Rest, Members[I], Contents[I]);
+  }
+
+  std::string Table;
+  appendBig32(Table, Symbols.size());
+  for (unsigned I = 0, E = MemberOf.size(); I != E; ++I)
+    appendBig32(Table, Offsets[MemberOf[I]]);
+  Table += Names;
+
+  std::string Archive = "!<arch>\n";
+  appendMember(Archive, "/", Table);
+  return Archive + Rest;
+}
+
+TEST(ArchiveTest, FindSym) {
+  const char *Symbols[] = { "foo", "bar", "baz", "foo", "qux" };
+  const unsigned MemberOf[] = { 1, 0, 2, 0, 1 };
+  std::string Data = makeArchive(Symbols, MemberOf);
+
+  error_code EC;
+  Archive A(MemoryBuffer::getMemBuffer(Data, "test.a", false), EC);
+  ASSERT_FALSE(EC);
+  ASSERT_TRUE(A.hasSymbolTable());
+
+  StringRef Name;
+  Archive::child_iterator C = A.findSym("foo");
+  ASSERT_TRUE(C != A.end_children());
+  ASSERT_FALSE(C->getName(Name));
+  // The first definition of a symbol wins.
+  EXPECT_EQ("b.o", Name);
+
+  C = A.findSym("bar");
+  ASSERT_TRUE(C != A.end_children());
+  ASSERT_FALSE(C->getName(Name));
+  EXPECT_EQ("a.o", Name);
+
+  C = A.findSym("baz");
+  ASSERT_TRUE(C != A.end_children());
+  ASSERT_FALSE(C->getName(Name));
+  EXPECT_EQ("c.o", Name);
+
+  C = A.findSym("qux");
+  ASSERT_TRUE(C != A.end_children());
+  ASSERT_FALSE(C->getName(Name));
+  EXPECT_EQ("b.o", Name);
+
+  EXPECT_TRUE(A.findSym("fo") == A.end_children());
+  EXPECT_TRUE(A.findSym("foo2") == A.end_children());
+  EXPECT_TRUE(A.findSym("") == A.end_children());
+}
+
+TEST(ArchiveTest, FindSymEmptyTable) {
+  std::string Data = makeArchive(ArrayRef<const char *>(),
+                                 ArrayRef<unsigned>());
+
+  error_code EC;
+  Archive A(MemoryBuffer::getMemBuffer(Data, "test.a", false), EC);
+  ASSERT_FALSE(EC);
+  EXPECT_TRUE(A.findSym("foo") == A.end_children());
+  EXPECT_TRUE(A.findSym("foo") == A.end_children());
+}
+
+TEST(ArchiveTest, MemberBuffersAreViews) {
+  const char *Symbols[] = { "foo" };
+  const unsigned MemberOf[] = { 2 };
+  std::string Data = makeArchive(Symbols, MemberOf);
+
+  error_code EC;
+  Archive A(MemoryBuffer::getMemBuffer(Data, "test.a", false), EC);
+  ASSERT_FALSE(EC);
+
+  Archive::child_iterator C = A.findSym("foo");
+  ASSERT_TRUE(C != A.end_children());
+  OwningPtr<MemoryBuffer> Buffer;
+  ASSERT_FALSE(C->getMemoryBuffer(Buffer, true));
+  EXPECT_EQ("contents of c", Buffer->getBuffer());
+  EXPECT_EQ(C->getBuffer().data(), Buffer->getBufferStart());
+  EXPECT_TRUE(Buffer->getBufferStart() > Data.data() &&
+              Buffer->getBufferEnd() <= Data.data() + Data.size());
+  EXPECT_STREQ("test.a(c.o)", Buffer->getBufferIdentifier());
+}
+
+}
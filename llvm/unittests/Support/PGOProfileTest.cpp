@@ -0,0 +1,133 @@
+//===- llvm/unittest/Support/PGOProfileTest.cpp - PGO profile tests -------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/PGOProfile.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+PGOProfileReader *readProfile(StringRef Data, std::string &Error) {
+  OwningPtr<MemoryBuffer> Buffer(MemoryBuffer::getMemBuffer(Data, "", false));
+  return PGOProfileReader::create(Buffer.get(), Error);
+}
+
+std::string writeProfile(const PGOProfileWriter &Writer) {
+  std::string Data;
+  raw_string_ostream OS(Data);
+  Writer.write(OS);
+  return OS.str();
+}
+
+TEST(PGOProfileTest, RoundTrip) {
+  PGOProfileWriter Writer;
+  uint64_t FooCounts[] = { 1, 200, 1ULL << 40 };
+  uint64_t BarCounts[] = { 7 };
+  EXPECT_TRUE(Writer.addFunction("foo", 0x1234, FooCounts));
+  EXPECT_TRUE(Writer.addFunction("bar", ~0ULL, BarCounts));
+
+  std::string Error;
+  OwningPtr<PGOProfileReader> Reader(readProfile(writeProfile(Writer), Error));
+  ASSERT_TRUE(Reader.get() != 0) << Error;
+  EXPECT_EQ(2U, Reader->getNumFunctions());
+  EXPECT_EQ(1ULL << 40, Reader->getMaximumCount());
+
+  const PGOFunctionProfile *Foo = Reader->getFunction("foo");
+  ASSERT_TRUE(Foo != 0);
+  EXPECT_EQ(0x1234U, Foo->Hash);
+  ASSERT_EQ(3U, Foo->Counts.size());
+  EXPECT_EQ(1U, Foo->Counts[0]);
+  EXPECT_EQ(200U, Foo->Counts[1]);
+  EXPECT_EQ(1ULL << 40, Foo->Counts[2]);
+
+  const PGOFunctionProfile *Bar = Reader->getFunction("bar");
+  ASSERT_TRUE(Bar != 0);
+  EXPECT_EQ(~0ULL, Bar->Hash);
+  ASSERT_EQ(1U, Bar->Counts.size());
+  EXPECT_EQ(7U, Bar->Counts[0]);
+
+  EXPECT_TRUE(Reader->getFunction("baz") == 0);
+}
+
+TEST(PGOProfileTest, Merge) {
+  PGOProfileWriter Writer;
+  uint64_t First[] = { 1, 2 };
+  uint64_t Second[] = { 10, 20 };
+  uint64_t Longer[] = { 1, 2, 3 };
+  EXPECT_TRUE(Writer.addFunction("foo", 1, First));
+  EXPECT_TRUE(Writer.addFunction("foo", 1, Second));
+  EXPECT_FALSE(Writer.addFunction("foo", 2, Second));
+  EXPECT_FALSE(Writer.addFunction("foo", 1, Longer));
+
+  std::string Error;
+  OwningPtr<PGOProfileReader> Reader(readProfile(writeProfile(Writer), Error));
+  ASSERT_TRUE(Reader.get() != 0) << Error;
+  const PGOFunctionProfile *Foo = Reader->getFunction("foo");
+  ASSERT_TRUE(Foo != 0);
+  ASSERT_EQ(2U, Foo->Counts.size());
+  EXPECT_EQ(11U, Foo->Counts[0]);
+  EXPECT_EQ(22U, Foo->Counts[1]);
+}
+
+TEST(PGOProfileTest, DuplicateRecords) {
+  // Two programs' profiles concatenated by hand: the header claims three
+  // records, two of which are for "f" with the same layout.
+  std::string Data(PGOProfile::Magic, sizeof(PGOProfile::Magic));
+  Data += "\x01\x03";
+  Data += "\x01" "f" "\x05" "\x01" "\x03";
+  Data += "\x01" "f" "\x05" "\x01" "\x04";
+  Data += "\x01" "f" "\x06" "\x01" "\x09";
+
+  std::string Error;
+  OwningPtr<PGOProfileReader> Reader(readProfile(Data, Error));
+  ASSERT_TRUE(Reader.get() != 0) << Error;
+  const PGOFunctionProfile *F = Reader->getFunction("f");
+  ASSERT_TRUE(F != 0);
+  EXPECT_EQ(5U, F->Hash);
+  ASSERT_EQ(1U, F->Counts.size());
+  EXPECT_EQ(7U, F->Counts[0]);
+  EXPECT_EQ(9U, Reader->getMaximumCount());
+}
+
+TEST(PGOProfileTest, Errors) {
+  std::string Error;
+  OwningPtr<PGOProfileReader> Reader(readProfile("not a profile", Error));
+  EXPECT_TRUE(Reader.get() == 0);
+  EXPECT_EQ("not a profile: bad magic", Error);
+
+  PGOProfileWriter Writer;
+  uint64_t Counts[] = { 300, 400 };
+  Writer.addFunction("foo", 1, Counts);
+  std::string Data = writeProfile(Writer);
+
+  // Every proper prefix of a profile is rejected.
+  for (size_t Size = sizeof(PGOProfile::Magic); Size != Data.size(); ++Size) {
+    Error.clear();
+    Reader.reset(readProfile(Data.substr(0, Size), Error));
+    EXPECT_TRUE(Reader.get() == 0) << "prefix of size " << Size;
+    EXPECT_FALSE(Error.empty());
+  }
+
+  Reader.reset(readProfile(Data + '\0', Error));
+  EXPECT_TRUE(Reader.get() == 0);
+  EXPECT_EQ("trailing data after the last profile record", Error);
+
+  std::string Future(PGOProfile::Magic, sizeof(PGOProfile::Magic));
+  Future += "\x02";
+  Future += '\0';
+  Reader.reset(readProfile(Future, Error));
+  EXPECT_TRUE(Reader.get() == 0);
+  EXPECT_EQ("unsupported profile version 2", Error);
+}
+
+} // end anonymous namespace
@@ -0,0 +1,190 @@
+//===- llvm/unittest/Support/ThreadPoolTest.cpp - ThreadPool tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/Parallel.h"
+#include "llvm/Support/Threading.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+class ThreadPoolTest : public testing::Test {
+  bool WasMultithreaded;
+
+protected:
+  virtual void SetUp() {
+    WasMultithreaded = llvm_is_multithreaded();
+  }
+
+  // Creating a pool starts multithreaded mode, which other tests expect to be
+  // off.
+  virtual void TearDown() {
+    if (!WasMultithreaded && llvm_is_multithreaded())
+      llvm_stop_multithreaded();
+  }
+};
+
+struct Counter {
+  sys::cas_flag Count;
+};
+
+static void increment(void *Arg) {
+  sys::AtomicIncrement(&static_cast<Counter *>(Arg)->Count);
+}
+
+TEST_F(ThreadPoolTest, SpawnAndWait) {
+  ThreadPool Pool(4);
+  Counter C = { 0 };
+  {
+    TaskGroup Group(Pool);
+    for (unsigned I = 0; I != 1000; ++I)
+      Group.spawn(increment, &C);
+    Group.wait();
+    EXPECT_EQ(1000u, C.Count);
+
+    // A group can be reused after waiting for it.
+    Group.spawn(increment, &C);
+  }
+  EXPECT_EQ(1001u, C.Count);
+}
+
+struct NestedArgs {
+  TaskGroup *Outer;
+  Counter *C;
+  unsigned Depth;
+};
+
+/// spawnNested - Spawn two nested tasks and wait for them, down to Depth.
+static void spawnNested(void *Arg) {
+  NestedArgs &A = *static_cast<NestedArgs *>(Arg);
+  increment(A.C);
+  if (A.Depth == 0)
+    return;
+
+  TaskGroup Inner(A.Outer->getPool());
+  NestedArgs Children[2];
+  for (unsigned I = 0; I != 2; ++I) {
+    Children[I].Outer = &Inner;
+    Children[I].C = A.C;
+    Children[I].Depth = A.Depth - 1;
+    Inner.spawn(spawnNested, &Children[I]);
+  }
+  Inner.wait();
+}
+
+TEST_F(ThreadPoolTest, NestedGroups) {
+  // Every worker ends up waiting for a nested group, which must not deadlock.
+  ThreadPool Pool(2);
+  Counter C = { 0 };
+  TaskGroup Group(Pool);
+  NestedArgs Root = { &Group, &C, 8 };
+  Group.spawn(spawnNested, &Root);
+  Group.wait();
+  EXPECT_EQ(511u, C.Count);
+}
+
+TEST_F(ThreadPoolTest, NestedGroupsOneThread) {
+  // The waiting threads run the nested tasks themselves.
+  ThreadPool Pool(1);
+  EXPECT_LE(Pool.getThreadCount(), 1u);
+  Counter C = { 0 };
+  TaskGroup Group(Pool);
+  NestedArgs Root = { &Group, &C, 4 };
+  Group.spawn(spawnNested, &Root);
+  Group.wait();
+  EXPECT_EQ(31u, C.Count);
+}
+
+TEST_F(ThreadPoolTest, DeepNestedGroups) {
+  // A thread waiting for a group steals only a few levels of other groups'
+  // tasks, so a large tree does not overflow its stack.
+  ThreadPool Pool(1);
+  Counter C = { 0 };
+  TaskGroup Group(Pool);
+  NestedArgs Root = { &Group, &C, 17 };
+  Group.spawn(spawnNested, &Root);
+  Group.wait();
+  EXPECT_EQ(262143u, C.Count);
+}
+
+struct Square {
+  void operator()(unsigned &V) const { V *= V; }
+};
+
+TEST_F(ThreadPoolTest, ParallelForEach) {
+  ThreadPool Pool(4);
+  std::vector<unsigned> V;
+  for (unsigned I = 0; I != 10000; ++I)
+    V.push_back(I);
+  parallel_for_each(Pool, V.begin(), V.end(), Square());
+  for (unsigned I = 0; I != 10000; ++I)
+    ASSERT_EQ(I * I, V[I]);
+
+  // Empty ranges are fine.
+  parallel_for_each(Pool, V.end(), V.end(), Square());
+}
+
+struct Greater {
+  bool operator()(unsigned L, unsigned R) const { return L > R; }
+};
+
+TEST_F(ThreadPoolTest, ParallelSort) {
+  ThreadPool Pool(4);
+  std::vector<unsigned> V;
+  // A linear congruential generator, with many duplicates.
+  unsigned Seed = 1;
+  for (unsigned I = 0; I != 100000; ++I) {
+    Seed = Seed * 1103515245 + 12345;
+    V.push_back((Seed >> 16) % 5000);
+  }
+  std::vector<unsigned> Expected(V);
+  std::sort(Expected.begin(), Expected.end());
+
+  std::vector<unsigned> Sorted(V);
+  parallel_sort(Pool, Sorted.begin(), Sorted.end());
+  EXPECT_TRUE(Sorted == Expected);
+
+  std::reverse(Expected.begin(), Expected.end());
+  parallel_sort(Pool, V.begin(), V.end(), Greater());
+  EXPECT_TRUE(V == Expected);
+
+  // Already sorted and all-equal inputs are the usual quicksort pitfalls.
+  parallel_sort(Pool, V.begin(), V.end(), Greater());
+  EXPECT_TRUE(V == Expected);
+  std::vector<unsigned> Equal(50000, 7);
+  parallel_sort(Pool, Equal.begin(), Equal.end());
+  EXPECT_TRUE(std::vector<unsigned>(50000, 7) == Equal);
+}
+
+struct Add {
+  uint64_t operator()(uint64_t L, uint64_t R) const { return L + R; }
+};
+
+struct Double {
+  uint64_t operator()(unsigned V) const { return 2 * V; }
+};
+
+TEST_F(ThreadPoolTest, ParallelTransformReduce) {
+  ThreadPool Pool(4);
+  std::vector<unsigned> V;
+  for (unsigned I = 1; I <= 10000; ++I)
+    V.push_back(I);
+  EXPECT_EQ(10000ULL * 10001ULL,
+            parallel_transform_reduce(Pool, V.begin(), V.end(), uint64_t(0),
+                                      Add(), Double()));
+  EXPECT_EQ(0ULL, parallel_transform_reduce(Pool, V.end(), V.end(),
+                                            uint64_t(0), Add(), Double()));
+}
+
+} // anonymous namespace
@@ -323,6 +323,42 @@ void CodeGenTarget::ComputeInstrsByEnum() const {
     "LIFETIME_END",
     "STACKMAP",
     "PATCHPOINT",
+    "G_ADD",
+    "G_SUB",
+    "G_MUL",
+    "G_SDIV",
+    "G_UDIV",
+    "G_SREM",
+    "G_UREM",
+    "G_AND",
+    "G_OR",
+    "G_XOR",
+    "G_SHL",
+    "G_LSHR",
+    "G_ASHR",
+    "G_ICMP",
+    "G_FCMP",
+    "G_FADD",
+    "G_FSUB",
+    "G_FMUL",
+    "G_FDIV",
+    "G_SELECT",
+    "G_ANYEXT",
+    "G_ZEXT",
+    "G_SEXT",
+    "G_TRUNC",
+    "G_SITOFP",
+    "G_FPTOSI",
+    "G_FPEXT",
+    "G_FPTRUNC",
+    "G_CONSTANT",
+    "G_FCONSTANT",
+    "G_FRAME_INDEX",
+    "G_GLOBAL_VALUE",
+    "G_LOAD",
+    "G_STORE",
+    "G_BR",
+    "G_BRCOND",
     0
   };
   const DenseMap<const Record*, CodeGenInstruction*> &Insts = getInstructions();